@@ -0,0 +1,144 @@
+/*****************************************************************************
+ * libvlc_thumbnailer.h:  libvlc external API
+ *****************************************************************************
+ * Copyright © 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_LIBVLC_THUMBNAILER_H
+#define VLC_LIBVLC_THUMBNAILER_H 1
+
+# ifdef __cplusplus
+extern "C" {
+# endif
+
+/**
+ * @defgroup libvlc_thumbnailer LibVLC thumbnailer
+ * @ingroup libvlc
+ * LibVLC thumbnailer extracts pictures from medias without playing them
+ *
+ * Medias are opened without audio nor video output. The thumbnailer seeks to
+ * the keyframe nearest to the requested time, decodes a single picture, then
+ * scales and encodes it. Requests are processed by a bounded pool of worker
+ * threads, which suits batches of medias.
+ * @{
+ * @file
+ * LibVLC thumbnailer external API
+ */
+
+typedef struct libvlc_thumbnailer_t libvlc_thumbnailer_t;
+
+/**
+ * Thumbnail image formats
+ */
+typedef enum libvlc_thumbnailer_format_t
+{
+    libvlc_thumbnailer_png,
+    libvlc_thumbnailer_jpg,
+} libvlc_thumbnailer_format_t;
+
+/**
+ * Callback prototype for thumbnail completion
+ *
+ * It is called once per request, from a thumbnailer thread.
+ *
+ * \param opaque private pointer given with the request
+ * \param p_md the media of the request
+ * \param p_data the encoded image, or NULL on error, timeout or cancellation
+ * (it is only valid until the callback returns)
+ * \param i_size the size of the encoded image in bytes
+ */
+typedef void (*libvlc_thumbnailer_cb)( void *opaque, libvlc_media_t *p_md,
+                                       const void *p_data, size_t i_size );
+
+/**
+ * Create a thumbnailer
+ *
+ * \version LibVLC 3.0.0 or later
+ *
+ * \param p_instance libvlc instance
+ * \param i_workers maximum number of thumbnails extracted in parallel
+ * \return thumbnailer object or NULL in case of error
+ */
+LIBVLC_API libvlc_thumbnailer_t *
+libvlc_thumbnailer_new( libvlc_instance_t *p_instance, unsigned i_workers );
+
+/**
+ * Release a thumbnailer
+ *
+ * Pending requests are canceled: their callbacks are called with NULL data
+ * before this function returns.
+ *
+ * \version LibVLC 3.0.0 or later
+ *
+ * \param p_thumbnailer thumbnailer object
+ */
+LIBVLC_API void
+libvlc_thumbnailer_release( libvlc_thumbnailer_t *p_thumbnailer );
+
+/**
+ * Request a thumbnail at a given time
+ *
+ * If i_width AND i_height is 0, original size is used.
+ * If i_width XOR i_height is 0, original aspect-ratio is preserved.
+ *
+ * \version LibVLC 3.0.0 or later
+ *
+ * \param p_thumbnailer thumbnailer object
+ * \param p_md media to extract a thumbnail from (it is retained until the
+ * callback is called)
+ * \param i_time time in ms; the picture is taken from the nearest keyframe
+ * \param i_width the thumbnail's width
+ * \param i_height the thumbnail's height
+ * \param i_format the thumbnail's image format
+ * \param i_timeout maximum processing time in ms, 0 for none
+ * \param pf_cb completion callback
+ * \param opaque private pointer for the callback
+ * \return 0 on success, -1 on error (the callback is then not called)
+ */
+LIBVLC_API int
+libvlc_thumbnailer_request_by_time( libvlc_thumbnailer_t *p_thumbnailer,
+                                    libvlc_media_t *p_md, libvlc_time_t i_time,
+                                    unsigned i_width, unsigned i_height,
+                                    libvlc_thumbnailer_format_t i_format,
+                                    libvlc_time_t i_timeout,
+                                    libvlc_thumbnailer_cb pf_cb, void *opaque );
+
+/**
+ * Request a thumbnail at a given position
+ *
+ * \see libvlc_thumbnailer_request_by_time()
+ *
+ * \version LibVLC 3.0.0 or later
+ *
+ * \param f_pos position between 0.0 and 1.0; the picture is taken from the
+ * nearest keyframe
+ */
+LIBVLC_API int
+libvlc_thumbnailer_request_by_pos( libvlc_thumbnailer_t *p_thumbnailer,
+                                   libvlc_media_t *p_md, float f_pos,
+                                   unsigned i_width, unsigned i_height,
+                                   libvlc_thumbnailer_format_t i_format,
+                                   libvlc_time_t i_timeout,
+                                   libvlc_thumbnailer_cb pf_cb, void *opaque );
+
+/** @} */
+
+# ifdef __cplusplus
+}
+# endif
+
+#endif
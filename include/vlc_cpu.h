@@ -44,6 +44,7 @@ VLC_API unsigned vlc_CPU(void);
 #  define VLC_CPU_AVX2   0x00004000
 #  define VLC_CPU_XOP    0x00008000
 #  define VLC_CPU_FMA4   0x00010000
+#  define VLC_CPU_AVX512 0x00020000 /* AVX-512 F and BW */
 
 # if defined (__MMX__)
 #  define vlc_CPU_MMX() (1)
@@ -111,6 +112,12 @@ VLC_API unsigned vlc_CPU(void);
 #  define vlc_CPU_AVX2() ((vlc_CPU() & VLC_CPU_AVX2) != 0)
 # endif
 
+# if defined (__AVX512F__) && defined (__AVX512BW__)
+#  define vlc_CPU_AVX512() (1)
+# else
+#  define vlc_CPU_AVX512() ((vlc_CPU() & VLC_CPU_AVX512) != 0)
+# endif
+
 # ifdef __3dNOW__
 #  define vlc_CPU_3dNOW() (1)
 # else
@@ -0,0 +1,75 @@
+/*****************************************************************************
+ * vlc_fft.h: real fast Fourier transform
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FFT_H
+#define VLC_FFT_H 1
+
+/**
+ * \defgroup fft Fast Fourier transform
+ * @{
+ * \file
+ * Fourier transform of real signals of power of two lengths, vectorized for
+ * the CPU. The tables of each length are shared by all the transforms of that
+ * length.
+ *
+ * A spectrum of N samples is stored as N / 2 real parts, followed by N / 2
+ * imaginary parts. Since the imaginary parts of the DC and Nyquist bins are
+ * zero, the imaginary part of the DC bin holds the real part of the Nyquist
+ * bin instead.
+ *
+ * A transform keeps scratch buffers, so it cannot be used by more than one
+ * thread at a time.
+ */
+
+typedef struct vlc_fft vlc_fft_t;
+
+/**
+ * Creates a transform.
+ * @param size number of samples, a power of two from 8
+ * @return the transform, or NULL on error
+ */
+VLC_API vlc_fft_t *vlc_fft_New(unsigned size) VLC_USED;
+
+VLC_API void vlc_fft_Delete(vlc_fft_t *);
+
+/**
+ * Computes the spectrum of size samples.
+ */
+VLC_API void vlc_fft_Forward(vlc_fft_t *, float *spectrum,
+                             const float *samples);
+
+/**
+ * Computes size samples from their spectrum, multiplied by size.
+ */
+VLC_API void vlc_fft_Inverse(vlc_fft_t *, float *samples,
+                             const float *spectrum);
+
+/**
+ * Computes the power spectrum of size samples, that is the squared magnitude
+ * of the size / 2 + 1 bins from DC to Nyquist. The DC and Nyquist bins are
+ * divided by 4, to be in scale with the other bins which only hold half of
+ * the power of their frequency.
+ */
+VLC_API void vlc_fft_Power(vlc_fft_t *, float *power,
+                           const float *samples);
+
+/** @} */
+
+#endif
@@ -26,6 +26,7 @@
 #define VLC_FILTER_H 1
 
 #include <vlc_es.h>
+#include <vlc_block.h>
 
 /**
  * \defgroup filter Filters
@@ -52,6 +53,10 @@ typedef struct filter_owner_t
         {
             subpicture_t * (*buffer_new)( filter_t * );
         } sub;
+        struct
+        {
+            block_t * (*buffer_new)( filter_t *, size_t );
+        } audio;
     };
 } filter_owner_t;
 
@@ -85,7 +90,11 @@ struct filter_t
         /** Filter a picture (video filter) */
         picture_t * (*pf_video_filter)( filter_t *, picture_t * );
 
-        /** Filter an audio block (audio filter) */
+        /** Filter an audio block (audio filter)
+         *
+         * The filter should process the input block in place and return it
+         * whenever the output fits in it. Otherwise, it shall get its output
+         * block from filter_NewAudioBuffer() and release the input block. */
         block_t * (*pf_audio_filter)( filter_t *, block_t * );
 
         /** Blend a subpicture onto a picture (blend) */
@@ -158,6 +167,32 @@ static inline picture_t *filter_NewPicture( filter_t *p_filter )
     return pic;
 }
 
+/**
+ * This function will return a new block usable by p_filter as an audio output
+ * buffer. You have to release it using block_Release or by returning it to
+ * the caller as a pf_audio_filter return value.
+ *
+ * The block may be recycled from a pool owned by the filter owner, so that
+ * filtering does not allocate memory in steady state.
+ *
+ * \param p_filter filter_t object
+ * \param i_size size of the buffer in bytes
+ * \return new block on success or NULL on failure
+ */
+static inline block_t *filter_NewAudioBuffer( filter_t *p_filter,
+                                              size_t i_size )
+{
+    block_t *block;
+
+    if( p_filter->owner.audio.buffer_new != NULL )
+        block = p_filter->owner.audio.buffer_new( p_filter, i_size );
+    else
+        block = block_Alloc( i_size );
+    if( block == NULL )
+        msg_Warn( p_filter, "can't get output block" );
+    return block;
+}
+
 /**
  * Flush a filter
  *
@@ -238,6 +273,41 @@ VLC_API int filter_Blend( filter_t *, picture_t *p_dst, int i_dst_x, int i_dst_y
  */
 VLC_API void filter_DeleteBlend( filter_t * );
 
+/**
+ * It returns the number of slices a video filter should split a picture
+ * of i_lines lines into, so that all slice worker threads are kept busy.
+ */
+VLC_API unsigned filter_GetSliceCount( filter_t *, int i_lines ) VLC_USED;
+
+/**
+ * It runs pf_slice once for each of the i_slices slices, in parallel on
+ * the shared slice worker pool, and returns once all of them are done.
+ *
+ * The slices must not depend on each other.
+ */
+VLC_API void filter_RunSlices( filter_t *, unsigned i_slices,
+                               void (*pf_slice)( filter_t *, void *opaque,
+                                                 unsigned i_slice,
+                                                 unsigned i_slices ),
+                               void *opaque );
+
+/**
+ * It computes the [*pi_start, *pi_end[ band of rows of a slice.
+ *
+ * Rows are split evenly and bands are aligned to i_align rows (which
+ * must be a power of 2), so that chroma planes can be derived from them.
+ */
+static inline void filter_SliceRows( int i_lines, int i_align,
+                                     unsigned i_slice, unsigned i_slices,
+                                     int *pi_start, int *pi_end )
+{
+    const int i_units = ( i_lines + i_align - 1 ) / i_align;
+
+    *pi_start = __MIN( i_lines, i_units * (int)i_slice / (int)i_slices * i_align );
+    *pi_end = __MIN( i_lines,
+                     i_units * (int)( i_slice + 1 ) / (int)i_slices * i_align );
+}
+
 /**
  * Create a picture_t *(*)( filter_t *, picture_t * ) compatible wrapper
  * using a void (*)( filter_t *, picture_t *, picture_t * ) function
@@ -139,6 +139,21 @@ typedef struct
  */
 VLC_API picture_t * picture_NewFromResource( const video_format_t *, const picture_resource_t * ) VLC_USED;
 
+/**
+ * This function will create a view of a rectangle of a picture.
+ *
+ * The view shares the pixels of the source picture, starting at the
+ * (i_x, i_y) pixel position, and keeps a reference to it until the view is
+ * released. The format must have the source chroma; its size is the size of
+ * the view.
+ *
+ * The view pixels must be considered read-only.
+ *
+ * It returns NULL if the rectangle does not fit in the source picture or is
+ * not aligned on the chroma subsampling.
+ */
+VLC_API picture_t * picture_NewView( picture_t *p_src, const video_format_t *p_fmt, unsigned i_x, unsigned i_y ) VLC_USED;
+
 /**
  * This function will increase the picture reference count.
  * It will not have any effect on picture obtained from vout
@@ -96,8 +96,26 @@ VLC_API picture_pool_t * picture_pool_NewFromFormat(const video_format_t *fmt,
                                                     unsigned count) VLC_USED;
 
 /**
- * Releases a pool created by picture_pool_NewExtended(), picture_pool_New()
- * or picture_pool_NewFromFormat().
+ * Allocates pictures from the heap and creates a growable picture pool with
+ * them.
+ *
+ * When no picture is available, picture_pool_Get() and picture_pool_Wait()
+ * allocate a new one rather than failing or blocking, until the pool holds
+ * max pictures. The pool never shrinks.
+ *
+ * @param fmt video format of pictures to allocate from the heap
+ * @param count number of pictures to allocate initially
+ * @param max maximum number of pictures in the pool
+ *
+ * @return a pointer to the new pool on success, NULL on error
+ */
+VLC_API picture_pool_t * picture_pool_NewGrowable(const video_format_t *fmt,
+                                                  unsigned count,
+                                                  unsigned max) VLC_USED;
+
+/**
+ * Releases a pool created by picture_pool_NewExtended(), picture_pool_New(),
+ * picture_pool_NewFromFormat() or picture_pool_NewGrowable().
  *
  * @note If there are no pending references to the pooled pictures, and the
  * picture_resource_t.pf_destroy callback was not NULL, it will be invoked.
@@ -177,6 +195,25 @@ VLC_USED;
  */
 VLC_API unsigned picture_pool_GetSize(const picture_pool_t *);
 
+/**
+ * Picture pool occupancy statistics
+ */
+typedef struct {
+    unsigned size; /**< current number of pictures */
+    unsigned max_size; /**< number of pictures a growable pool can reach */
+    unsigned in_use; /**< pictures currently obtained from the pool */
+    unsigned peak_in_use; /**< highest number of pictures in use at once */
+    unsigned long acquired; /**< pictures obtained from the pool so far */
+    unsigned long failed; /**< picture_pool_Get() calls which returned NULL */
+} picture_pool_stats_t;
+
+/**
+ * Reads the occupancy statistics of a pool.
+ * @note This function is thread-safe; the values are read independently.
+ */
+VLC_API void picture_pool_GetStats(const picture_pool_t *,
+                                   picture_pool_stats_t *);
+
 
 #endif /* VLC_PICTURE_POOL_H */
 
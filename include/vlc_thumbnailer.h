@@ -0,0 +1,101 @@
+/*****************************************************************************
+ * vlc_thumbnailer.h: Thumbnail extraction
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_THUMBNAILER_H
+#define VLC_THUMBNAILER_H 1
+
+#include <vlc_common.h>
+#include <vlc_input_item.h>
+#include <vlc_block.h>
+
+/**
+ * \defgroup thumbnailer Thumbnailer
+ * \ingroup input
+ * Thumbnail extraction
+ *
+ * The thumbnailer opens an input item without audio nor video output, seeks
+ * to the keyframe nearest to the requested time, decodes a single picture,
+ * and scales and encodes it. Requests are processed by a bounded pool of
+ * worker threads.
+ * @{
+ * \file
+ * Thumbnailer interface
+ */
+
+typedef struct vlc_thumbnailer_t vlc_thumbnailer_t;
+
+/**
+ * Thumbnail request completion callback
+ *
+ * It is called from a worker thread, once per request.
+ *
+ * \param data opaque pointer given with the request
+ * \param p_image the encoded picture, or NULL on error, timeout or
+ * cancellation (the callee must release it)
+ */
+typedef void (*vlc_thumbnailer_cb)( void *data, block_t *p_image );
+
+/**
+ * Thumbnail request parameters
+ */
+typedef struct
+{
+    mtime_t      i_time;    /**< time to seek to, or -1 to use f_pos */
+    float        f_pos;     /**< position to seek to, if i_time is -1 */
+    unsigned     i_width;   /**< width, 0 to keep the aspect ratio */
+    unsigned     i_height;  /**< height, 0 to keep the aspect ratio */
+    vlc_fourcc_t i_codec;   /**< image codec (VLC_CODEC_PNG, VLC_CODEC_JPEG) */
+    mtime_t      i_timeout; /**< maximum processing time, 0 for none */
+} vlc_thumbnailer_params_t;
+
+/**
+ * Creates a thumbnailer
+ *
+ * \param i_workers maximum number of requests processed in parallel
+ * \return a thumbnailer or NULL on error
+ */
+VLC_API vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t *p_parent,
+                                                   unsigned i_workers ) VLC_USED;
+#define vlc_thumbnailer_Create(a, b) vlc_thumbnailer_Create(VLC_OBJECT(a), b)
+
+/**
+ * Queues a thumbnail request
+ *
+ * \param p_item item to extract a thumbnail from (it is held until the
+ * request completes); its options apply as for playback
+ * \return VLC_SUCCESS, or an error if the request cannot be queued (the
+ * callback is then not called)
+ */
+VLC_API int vlc_thumbnailer_Request( vlc_thumbnailer_t *,
+                                     input_item_t *p_item,
+                                     const vlc_thumbnailer_params_t *,
+                                     vlc_thumbnailer_cb pf_cb, void *data );
+
+/**
+ * Destroys a thumbnailer
+ *
+ * Pending requests are canceled and running ones are interrupted: their
+ * callbacks are all called with NULL before this function returns.
+ */
+VLC_API void vlc_thumbnailer_Delete( vlc_thumbnailer_t * );
+
+/** @} */
+
+#endif
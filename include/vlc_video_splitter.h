@@ -99,9 +99,12 @@ struct video_splitter_t
 
     video_splitter_sys_t *p_sys;
 
-    /* Buffer allocation */
+    /* Buffer allocation, for the outputs whose pp_picture[] entry is NULL.
+     * On error, all the non NULL entries are released. */
     int  (*pf_picture_new) ( video_splitter_t *, picture_t *pp_picture[] );
     void (*pf_picture_del) ( video_splitter_t *, picture_t *pp_picture[] );
+    /* Tells if an output accepts views of the input picture (optional) */
+    bool (*pf_picture_view)( video_splitter_t *, int i_index );
     video_splitter_owner_t *p_owner;
 };
 
@@ -116,6 +119,8 @@ struct video_splitter_t
 static inline int video_splitter_NewPicture( video_splitter_t *p_splitter,
                                              picture_t *pp_picture[] )
 {
+    for( int i = 0; i < p_splitter->i_output; i++ )
+        pp_picture[i] = NULL;
     int i_ret = p_splitter->pf_picture_new( p_splitter, pp_picture );
     if( i_ret )
         msg_Warn( p_splitter, "can't get output pictures" );
@@ -132,6 +137,49 @@ static inline void video_splitter_DeletePicture( video_splitter_t *p_splitter,
     p_splitter->pf_picture_del( p_splitter, pp_picture );
 }
 
+/**
+ * It will create an array of pictures suitable as output, using views of
+ * p_src (see picture_NewView) for the outputs that accept them.
+ *
+ * The output i shows the area of p_src starting at (pi_x[i], pi_y[i]).
+ * On input, pb_view[i] tells if the splitter can use a view for the output
+ * i. On output, it tells if the picture is a view: its pixels are already
+ * those of p_src and must not be written to. The other pictures must be
+ * filled by the splitter.
+ *
+ * If VLC_SUCCESS is not returned, pp_picture values are undefined.
+ */
+static inline int video_splitter_NewPictureView( video_splitter_t *p_splitter,
+                                                 picture_t *pp_picture[],
+                                                 picture_t *p_src,
+                                                 const unsigned pi_x[],
+                                                 const unsigned pi_y[],
+                                                 bool pb_view[] )
+{
+    bool b_alloc = false;
+
+    for( int i = 0; i < p_splitter->i_output; i++ )
+    {
+        pp_picture[i] = NULL;
+        if( pb_view[i] && p_splitter->pf_picture_view != NULL &&
+            p_splitter->pf_picture_view( p_splitter, i ) )
+            pp_picture[i] = picture_NewView( p_src, &p_splitter->p_output[i].fmt,
+                                             pi_x[i], pi_y[i] );
+        /* Outputs that are not views are filled by the splitter */
+        pb_view[i] = pp_picture[i] != NULL;
+        if( !pb_view[i] )
+            b_alloc = true;
+    }
+
+    /* Only those need a picture of their own */
+    if( b_alloc && p_splitter->pf_picture_new( p_splitter, pp_picture ) )
+    {
+        msg_Warn( p_splitter, "can't get output pictures" );
+        return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
 /* */
 VLC_API video_splitter_t * video_splitter_New( vlc_object_t *, const char *psz_name, const video_format_t * );
 VLC_API void video_splitter_Delete( video_splitter_t * );
@@ -131,6 +131,7 @@ typedef struct {
     bool has_hide_mouse;                    /* Is mouse automatically hidden */
     bool has_pictures_invalid;              /* Will VOUT_DISPLAY_EVENT_PICTURES_INVALID be used */
     bool needs_event_thread VLC_DEPRECATED; /* Will events (key at least) be emitted using an independent thread */
+    bool accepts_views;                     /* Can display pictures not from its pool (see picture_NewView) */
     const vlc_fourcc_t *subpicture_chromas; /* List of supported chromas for subpicture rendering. */
 } vout_display_info_t;
 
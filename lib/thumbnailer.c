@@ -0,0 +1,167 @@
+/*****************************************************************************
+ * thumbnailer.c: libvlc thumbnailer API
+ *****************************************************************************
+ * Copyright © 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc/libvlc.h>
+#include <vlc/libvlc_media.h>
+#include <vlc/libvlc_thumbnailer.h>
+
+#include <vlc_common.h>
+#include <vlc_thumbnailer.h>
+
+#include "libvlc_internal.h"
+#include "media_internal.h"
+
+struct libvlc_thumbnailer_t
+{
+    vlc_thumbnailer_t *p_thumbnailer;
+};
+
+typedef struct
+{
+    libvlc_media_t        *p_md;
+    libvlc_thumbnailer_cb  pf_cb;
+    void                  *opaque;
+} thumbnailer_request_t;
+
+static void thumbnailer_done( void *data, block_t *p_image )
+{
+    thumbnailer_request_t *p_req = data;
+
+    if( p_image != NULL )
+    {
+        p_req->pf_cb( p_req->opaque, p_req->p_md,
+                      p_image->p_buffer, p_image->i_buffer );
+        block_Release( p_image );
+    }
+    else
+        p_req->pf_cb( p_req->opaque, p_req->p_md, NULL, 0 );
+
+    libvlc_media_release( p_req->p_md );
+    free( p_req );
+}
+
+static int thumbnailer_request( libvlc_thumbnailer_t *p_lt,
+                                libvlc_media_t *p_md,
+                                const vlc_thumbnailer_params_t *p_params,
+                                libvlc_thumbnailer_cb pf_cb, void *opaque )
+{
+    thumbnailer_request_t *p_req = malloc( sizeof( *p_req ) );
+    if( unlikely(p_req == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return -1;
+    }
+
+    libvlc_media_retain( p_md );
+    p_req->p_md = p_md;
+    p_req->pf_cb = pf_cb;
+    p_req->opaque = opaque;
+
+    if( vlc_thumbnailer_Request( p_lt->p_thumbnailer, p_md->p_input_item,
+                                 p_params, thumbnailer_done, p_req ) )
+    {
+        libvlc_printerr( "Cannot queue the thumbnail request" );
+        libvlc_media_release( p_md );
+        free( p_req );
+        return -1;
+    }
+    return 0;
+}
+
+static vlc_fourcc_t thumbnailer_codec( libvlc_thumbnailer_format_t i_format )
+{
+    switch( i_format )
+    {
+        case libvlc_thumbnailer_jpg:
+            return VLC_CODEC_JPEG;
+        case libvlc_thumbnailer_png:
+        default:
+            return VLC_CODEC_PNG;
+    }
+}
+
+libvlc_thumbnailer_t *
+libvlc_thumbnailer_new( libvlc_instance_t *p_inst, unsigned i_workers )
+{
+    libvlc_thumbnailer_t *p_lt = malloc( sizeof( *p_lt ) );
+    if( unlikely(p_lt == NULL) )
+    {
+        libvlc_printerr( "Not enough memory" );
+        return NULL;
+    }
+
+    p_lt->p_thumbnailer = vlc_thumbnailer_Create( p_inst->p_libvlc_int,
+                                                  i_workers );
+    if( p_lt->p_thumbnailer == NULL )
+    {
+        libvlc_printerr( "Cannot create the thumbnailer" );
+        free( p_lt );
+        return NULL;
+    }
+    return p_lt;
+}
+
+void
+libvlc_thumbnailer_release( libvlc_thumbnailer_t *p_lt )
+{
+    vlc_thumbnailer_Delete( p_lt->p_thumbnailer );
+    free( p_lt );
+}
+
+int
+libvlc_thumbnailer_request_by_time( libvlc_thumbnailer_t *p_lt,
+                                    libvlc_media_t *p_md, libvlc_time_t i_time,
+                                    unsigned i_width, unsigned i_height,
+                                    libvlc_thumbnailer_format_t i_format,
+                                    libvlc_time_t i_timeout,
+                                    libvlc_thumbnailer_cb pf_cb, void *opaque )
+{
+    const vlc_thumbnailer_params_t params = {
+        .i_time = i_time > 0 ? to_mtime( i_time ) : 0,
+        .i_width = i_width,
+        .i_height = i_height,
+        .i_codec = thumbnailer_codec( i_format ),
+        .i_timeout = to_mtime( i_timeout ),
+    };
+    return thumbnailer_request( p_lt, p_md, &params, pf_cb, opaque );
+}
+
+int
+libvlc_thumbnailer_request_by_pos( libvlc_thumbnailer_t *p_lt,
+                                   libvlc_media_t *p_md, float f_pos,
+                                   unsigned i_width, unsigned i_height,
+                                   libvlc_thumbnailer_format_t i_format,
+                                   libvlc_time_t i_timeout,
+                                   libvlc_thumbnailer_cb pf_cb, void *opaque )
+{
+    const vlc_thumbnailer_params_t params = {
+        .i_time = -1,
+        .f_pos = f_pos,
+        .i_width = i_width,
+        .i_height = i_height,
+        .i_codec = thumbnailer_codec( i_format ),
+        .i_timeout = to_mtime( i_timeout ),
+    };
+    return thumbnailer_request( p_lt, p_md, &params, pf_cb, opaque );
+}
@@ -0,0 +1,1161 @@
+/*****************************************************************************
+ * cmaf.c: CMAF segmenter with HLS and DASH manifests
+ *****************************************************************************
+ * Copyright © 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <sys/types.h>
+#include <time.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_sout.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_strings.h>
+#include <vlc_charset.h>
+#include <vlc_arrays.h>
+#include <vlc_memstream.h>
+
+#ifndef O_LARGEFILE
+#   define O_LARGEFILE 0
+#endif
+
+#define SEG_NUMBER_PLACEHOLDER "#"
+
+/* Parts listed in the HLS playlist, counted from the live edge */
+#define HLS_PART_SEGMENTS 3
+
+/*****************************************************************************
+ * Module descriptor
+ *****************************************************************************/
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+#define SOUT_CFG_PREFIX "sout-cmaf-"
+#define SEGLEN_TEXT N_("Segment length")
+#define SEGLEN_LONGTEXT N_("Minimal length of segments, in seconds. "\
+                           "Segments are only cut on keyframes.")
+
+#define NUMSEGS_TEXT N_("Number of segments")
+#define NUMSEGS_LONGTEXT N_("Number of segments to include in manifests. "\
+                            "0 keeps all of them.")
+
+#define DELSEGS_TEXT N_("Delete segments")
+#define DELSEGS_LONGTEXT N_("Delete segments when they are no longer needed")
+
+#define CHUNKED_TEXT N_("Low latency chunked output")
+#define CHUNKED_LONGTEXT N_("Announce every fragment as soon as it is "\
+                            "written, as HLS parts and DASH chunks.")
+
+#define HLS_TEXT N_("HLS playlist")
+#define HLS_LONGTEXT N_("Path to the HLS media playlist to create")
+
+#define DASH_TEXT N_("DASH manifest")
+#define DASH_LONGTEXT N_("Path to the DASH MPD to create")
+
+#define INIT_TEXT N_("Initialization segment")
+#define INIT_LONGTEXT N_("Path to the initialization segment. Defaults to "\
+                         "the segment path with #'s replaced by \"init\".")
+
+#define INDEXURL_TEXT N_("Segment URL to put in manifests")
+#define INDEXURL_LONGTEXT N_("Segment URL to put in manifests. "\
+                             "Use #'s to represent segment number")
+
+vlc_module_begin ()
+    set_description( N_("CMAF segmented output") )
+    set_shortname( N_("CMAF" ))
+    add_shortcut( "cmaf" )
+    set_capability( "sout access", 0 )
+    set_category( CAT_SOUT )
+    set_subcategory( SUBCAT_SOUT_ACO )
+    add_integer( SOUT_CFG_PREFIX "seglen", 4, SEGLEN_TEXT, SEGLEN_LONGTEXT, false )
+    add_integer( SOUT_CFG_PREFIX "numsegs", 0, NUMSEGS_TEXT, NUMSEGS_LONGTEXT, false )
+    add_bool( SOUT_CFG_PREFIX "delsegs", true,
+              DELSEGS_TEXT, DELSEGS_LONGTEXT, true )
+    add_bool( SOUT_CFG_PREFIX "chunked", false,
+              CHUNKED_TEXT, CHUNKED_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "hls-index", NULL,
+                HLS_TEXT, HLS_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "dash-index", NULL,
+                DASH_TEXT, DASH_LONGTEXT, false )
+    add_string( SOUT_CFG_PREFIX "init", NULL,
+                INIT_TEXT, INIT_LONGTEXT, true )
+    add_string( SOUT_CFG_PREFIX "index-url", NULL,
+                INDEXURL_TEXT, INDEXURL_LONGTEXT, false )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+
+/*****************************************************************************
+ * Exported prototypes
+ *****************************************************************************/
+static const char *const ppsz_sout_options[] = {
+    "seglen",
+    "numsegs",
+    "delsegs",
+    "chunked",
+    "hls-index",
+    "dash-index",
+    "init",
+    "index-url",
+    NULL
+};
+
+static ssize_t Write( sout_access_out_t *, block_t * );
+static int Seek ( sout_access_out_t *, off_t  );
+static int Control( sout_access_out_t *, int, va_list );
+
+/* A fragment (moof + mdat) inside a segment file */
+typedef struct
+{
+    uint64_t i_offset;
+    uint64_t i_size;
+    mtime_t  i_duration;
+    bool     b_independent;
+} cmaf_part_t;
+
+typedef struct
+{
+    char    *psz_filename;
+    char    *psz_uri;
+    uint32_t i_number;
+    mtime_t  i_start;
+    mtime_t  i_duration;
+    uint64_t i_size;
+    bool     b_complete;
+    int          i_parts;
+    cmaf_part_t *p_parts;
+} cmaf_segment_t;
+
+struct sout_access_out_sys_t
+{
+    char    *psz_hlsPath;
+    char    *psz_dashPath;
+    char    *psz_initPath;
+    char    *psz_initUri;
+    char    *psz_indexUrl;
+    char    *psz_codecs;
+    bool     b_video;
+
+    mtime_t  i_seglenm;
+    unsigned i_numsegs;
+    bool     b_delsegs;
+    bool     b_chunked;
+
+    int      i_handle;
+    uint32_t i_segment;
+    mtime_t  i_first_dts;
+    mtime_t  i_max_part;
+    mtime_t  i_max_segment;
+    time_t   i_availability_start;
+
+    /* top level box tracking */
+    uint64_t i_box_left;
+    vlc_fourcc_t i_box_type;
+    bool     b_drop_box;
+
+    /* header of the next box, which may be split across blocks */
+    uint8_t  p_header[16];
+    size_t   i_header;
+    bool     b_header_sync;
+    mtime_t  i_header_dts;
+    mtime_t  i_header_length;
+
+    /* fragment being written */
+    bool     b_part_open;
+    cmaf_part_t part;
+
+    uint64_t i_total_size;
+    mtime_t  i_total_duration;
+
+    vlc_array_t segments;
+};
+
+/*****************************************************************************
+ * Open: open the segmenter
+ *****************************************************************************/
+static char *formatSegmentPath( const char *psz_path, uint32_t i_seg );
+static char *formatSegmentName( const char *psz_path, const char *psz_name );
+
+static int Open( vlc_object_t *p_this )
+{
+    sout_access_out_t   *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys;
+
+    config_ChainParse( p_access, SOUT_CFG_PREFIX, ppsz_sout_options, p_access->p_cfg );
+
+    if( !p_access->psz_path )
+    {
+        msg_Err( p_access, "no file name specified" );
+        return VLC_EGENERIC;
+    }
+
+    if( unlikely( !( p_sys = calloc ( 1, sizeof( *p_sys ) ) ) ) )
+        return VLC_ENOMEM;
+
+    p_sys->i_seglenm = CLOCK_FREQ *
+                       var_GetInteger( p_access, SOUT_CFG_PREFIX "seglen" );
+    p_sys->i_numsegs = var_GetInteger( p_access, SOUT_CFG_PREFIX "numsegs" );
+    p_sys->b_delsegs = var_GetBool( p_access, SOUT_CFG_PREFIX "delsegs" );
+    p_sys->b_chunked = var_GetBool( p_access, SOUT_CFG_PREFIX "chunked" );
+
+    char *psz_tmp = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "hls-index" );
+    if( psz_tmp )
+    {
+        p_sys->psz_hlsPath = vlc_strftime( psz_tmp );
+        free( psz_tmp );
+    }
+    psz_tmp = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "dash-index" );
+    if( psz_tmp )
+    {
+        p_sys->psz_dashPath = vlc_strftime( psz_tmp );
+        free( psz_tmp );
+    }
+    if( !p_sys->psz_hlsPath && !p_sys->psz_dashPath )
+        msg_Warn( p_access, "no HLS nor DASH manifest requested" );
+
+    p_sys->psz_indexUrl = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "index-url" );
+    const char *psz_uriFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl
+                                                    : p_access->psz_path;
+
+    psz_tmp = var_GetNonEmptyString( p_access, SOUT_CFG_PREFIX "init" );
+    if( psz_tmp )
+    {
+        p_sys->psz_initPath = psz_tmp;
+        p_sys->psz_initUri = strdup( psz_tmp );
+    }
+    else
+    {
+        p_sys->psz_initPath = formatSegmentName( p_access->psz_path, "init" );
+        p_sys->psz_initUri = formatSegmentName( psz_uriFormat, "init" );
+    }
+
+    if( !p_sys->psz_initPath || !p_sys->psz_initUri )
+    {
+        free( p_sys->psz_initPath );
+        free( p_sys->psz_initUri );
+        free( p_sys->psz_indexUrl );
+        free( p_sys->psz_dashPath );
+        free( p_sys->psz_hlsPath );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    vlc_array_init( &p_sys->segments );
+    p_sys->i_handle = -1;
+    p_sys->i_first_dts = VLC_TS_INVALID;
+
+    p_access->p_sys = p_sys;
+    p_access->pf_write = Write;
+    p_access->pf_seek  = Seek;
+    p_access->pf_control = Control;
+
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * formatSegmentPath: create segment path name based on seg #
+ *****************************************************************************/
+static char *formatSegmentPath( const char *psz_path, uint32_t i_seg )
+{
+    char *psz_result;
+    char *psz_firstNumSign;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    if ( *psz_firstNumSign )
+    {
+        char *psz_newResult;
+        int i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+        int ret;
+
+        *psz_firstNumSign = '\0';
+        ret = asprintf( &psz_newResult, "%s%0*"PRIu32"%s", psz_result, i_cnt,
+                        i_seg, psz_firstNumSign + i_cnt );
+        free ( psz_result );
+        if ( ret < 0 )
+            return NULL;
+        psz_result = psz_newResult;
+    }
+
+    return psz_result;
+}
+
+/*****************************************************************************
+ * formatSegmentName: replace the segment number placeholder with a string,
+ * used for the init segment and the DASH $Number$ template
+ *****************************************************************************/
+static char *formatSegmentName( const char *psz_path, const char *psz_name )
+{
+    char *psz_result;
+    char *psz_firstNumSign;
+
+    if ( ! ( psz_result  = vlc_strftime( psz_path ) ) )
+        return NULL;
+
+    psz_firstNumSign = psz_result + strcspn( psz_result, SEG_NUMBER_PLACEHOLDER );
+    if ( *psz_firstNumSign )
+    {
+        char *psz_newResult;
+        int i_cnt = strspn( psz_firstNumSign, SEG_NUMBER_PLACEHOLDER );
+        int ret;
+
+        *psz_firstNumSign = '\0';
+        if( psz_name )
+            ret = asprintf( &psz_newResult, "%s%s%s", psz_result, psz_name,
+                            psz_firstNumSign + i_cnt );
+        else
+            ret = asprintf( &psz_newResult, "%s$Number%%0%dd$%s", psz_result,
+                            i_cnt, psz_firstNumSign + i_cnt );
+        free ( psz_result );
+        if ( ret < 0 )
+            return NULL;
+        psz_result = psz_newResult;
+    }
+
+    return psz_result;
+}
+
+static void destroySegment( cmaf_segment_t *segment )
+{
+    free( segment->psz_filename );
+    free( segment->psz_uri );
+    free( segment->p_parts );
+    free( segment );
+}
+
+/*****************************************************************************
+ * Codecs string from the initialization segment (RFC 6381)
+ *****************************************************************************/
+static const uint8_t *findBox( const uint8_t *p, size_t i_size, const char *psz_type,
+                               size_t *pi_box )
+{
+    while( i_size >= 8 )
+    {
+        size_t i_box = GetDWBE( p );
+        if( i_box < 8 || i_box > i_size )
+            return NULL;
+        if( !memcmp( &p[4], psz_type, 4 ) )
+        {
+            *pi_box = i_box - 8;
+            return &p[8];
+        }
+        p += i_box;
+        i_size -= i_box;
+    }
+    return NULL;
+}
+
+static size_t readDescriptorLength( const uint8_t **pp, size_t *pi_size )
+{
+    size_t i_len = 0;
+    for( int i = 0; i < 4 && *pi_size; i++ )
+    {
+        uint8_t i_byte = *(*pp)++;
+        (*pi_size)--;
+        i_len = ( i_len << 7 ) | ( i_byte & 0x7f );
+        if( !( i_byte & 0x80 ) )
+            break;
+    }
+    return i_len;
+}
+
+static char *codecFromSampleEntry( const uint8_t *p, size_t i_size, bool *pb_video )
+{
+    char *psz_codec = NULL;
+    size_t i_box;
+    const uint8_t *p_box;
+
+    if( i_size < 8 )
+        return NULL;
+
+    const uint8_t *p_type = &p[4];
+    i_size = __MIN( i_size, GetDWBE( p ) );
+
+    if( !memcmp( p_type, "avc1", 4 ) || !memcmp( p_type, "avc3", 4 ) )
+    {
+        *pb_video = true;
+        /* box header + visual sample entry */
+        if( i_size > 8 + 78 &&
+            ( p_box = findBox( &p[8 + 78], i_size - 8 - 78, "avcC", &i_box ) ) &&
+            i_box >= 4 )
+        {
+            if( asprintf( &psz_codec, "%4.4s.%02x%02x%02x", p_type,
+                          p_box[1], p_box[2], p_box[3] ) < 0 )
+                psz_codec = NULL;
+        }
+    }
+    else if( !memcmp( p_type, "mp4a", 4 ) )
+    {
+        unsigned i_object = 0x40, i_aot = 2;
+
+        /* box header + audio sample entry, then esds full box */
+        if( i_size > 8 + 28 &&
+            ( p_box = findBox( &p[8 + 28], i_size - 8 - 28, "esds", &i_box ) ) &&
+            i_box > 4 )
+        {
+            p_box += 4;
+            i_box -= 4;
+            /* ES_Descriptor */
+            if( i_box > 4 && *p_box == 0x03 )
+            {
+                p_box++; i_box--;
+                readDescriptorLength( &p_box, &i_box );
+                if( i_box >= 3 )
+                {
+                    uint8_t i_flags = p_box[2];
+                    size_t i_skip = 3 + ( ( i_flags & 0x80 ) ? 2 : 0 ) +
+                                        ( ( i_flags & 0x20 ) ? 1 + ( i_box > 3 ? p_box[3] : 0 ) : 0 ) +
+                                        ( ( i_flags & 0x40 ) ? 2 : 0 );
+                    if( i_skip < i_box )
+                    {
+                        p_box += i_skip; i_box -= i_skip;
+                    }
+                    else
+                        i_box = 0;
+                }
+            }
+            /* DecoderConfigDescriptor */
+            if( i_box > 2 && *p_box == 0x04 )
+            {
+                p_box++; i_box--;
+                readDescriptorLength( &p_box, &i_box );
+                if( i_box >= 13 )
+                {
+                    i_object = p_box[0];
+                    p_box += 13; i_box -= 13;
+                    /* DecoderSpecificInfo */
+                    if( i_box > 2 && *p_box == 0x05 )
+                    {
+                        p_box++; i_box--;
+                        if( readDescriptorLength( &p_box, &i_box ) && i_box )
+                            i_aot = p_box[0] >> 3;
+                    }
+                }
+            }
+        }
+        if( i_object == 0x40 )
+        {
+            if( asprintf( &psz_codec, "mp4a.40.%u", i_aot ) < 0 )
+                psz_codec = NULL;
+        }
+        else if( asprintf( &psz_codec, "mp4a.%02x", i_object ) < 0 )
+            psz_codec = NULL;
+    }
+    else
+    {
+        if( !memcmp( p_type, "hvc1", 4 ) || !memcmp( p_type, "hev1", 4 ) ||
+            !memcmp( p_type, "vp09", 4 ) || !memcmp( p_type, "av01", 4 ) )
+            *pb_video = true;
+        psz_codec = strndup( (const char *) p_type, 4 );
+    }
+
+    return psz_codec;
+}
+
+static void parseInitSegment( sout_access_out_t *p_access, const block_t *p_init )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const uint8_t *p_moov, *p_trak;
+    size_t i_moov, i_trak;
+    char *psz_codecs = NULL;
+
+    p_moov = findBox( p_init->p_buffer, p_init->i_buffer, "moov", &i_moov );
+    if( !p_moov )
+        return;
+
+    p_sys->b_video = false;
+    while( ( p_trak = findBox( p_moov, i_moov, "trak", &i_trak ) ) )
+    {
+        const uint8_t *p = p_trak;
+        size_t i = i_trak;
+        if( ( p = findBox( p, i, "mdia", &i ) ) &&
+            ( p = findBox( p, i, "minf", &i ) ) &&
+            ( p = findBox( p, i, "stbl", &i ) ) &&
+            ( p = findBox( p, i, "stsd", &i ) ) && i > 8 )
+        {
+            char *psz_codec = codecFromSampleEntry( &p[8], i - 8, &p_sys->b_video );
+            if( psz_codec )
+            {
+                char *psz_list;
+                if( asprintf( &psz_list, "%s%s%s", psz_codecs ? psz_codecs : "",
+                              psz_codecs ? "," : "", psz_codec ) < 0 )
+                    psz_list = NULL;
+                free( psz_codec );
+                if( psz_list )
+                {
+                    free( psz_codecs );
+                    psz_codecs = psz_list;
+                }
+            }
+        }
+        /* next trak */
+        i_moov -= p_trak + i_trak - p_moov;
+        p_moov = p_trak + i_trak;
+    }
+
+    free( p_sys->psz_codecs );
+    p_sys->psz_codecs = psz_codecs;
+    msg_Dbg( p_access, "init segment codecs: %s", psz_codecs ? psz_codecs : "?" );
+}
+
+/*****************************************************************************
+ * Manifests
+ *****************************************************************************/
+static size_t firstListedSegment( sout_access_out_sys_t *p_sys )
+{
+    size_t i_count = vlc_array_count( &p_sys->segments );
+    size_t i_complete = i_count;
+
+    if( i_count && !((cmaf_segment_t *)
+            vlc_array_item_at_index( &p_sys->segments, i_count - 1 ))->b_complete )
+        i_complete--;
+
+    if( p_sys->i_numsegs == 0 || i_complete <= p_sys->i_numsegs )
+        return 0;
+    return i_complete - p_sys->i_numsegs;
+}
+
+static int writeManifestFile( sout_access_out_t *p_access, const char *psz_path,
+                              const char *psz_data )
+{
+    char *psz_tmp;
+    if ( asprintf( &psz_tmp, "%s.tmp", psz_path ) < 0 )
+        return -1;
+
+    FILE *fp = vlc_fopen( psz_tmp, "wt" );
+    if ( !fp )
+    {
+        msg_Err( p_access, "cannot open index file `%s'", psz_tmp );
+        free( psz_tmp );
+        return -1;
+    }
+
+    int val = fputs( psz_data, fp );
+    if( fclose( fp ) || val < 0 )
+    {
+        vlc_unlink( psz_tmp );
+        free( psz_tmp );
+        return -1;
+    }
+
+    val = vlc_rename( psz_tmp, psz_path );
+    if ( val < 0 )
+    {
+        vlc_unlink( psz_tmp );
+        msg_Err( p_access, "Error moving index file `%s'", psz_path );
+    }
+    free( psz_tmp );
+    return val;
+}
+
+/* Formats a duration in seconds with millisecond precision. Integers are used
+ * so that the decimal separator is a dot whatever the locale. */
+#define SECONDS_SIZE 24
+static const char *formatSeconds( char *psz, mtime_t i_time )
+{
+    uint64_t i_ms = ( ( i_time < 0 ? -(uint64_t)i_time : (uint64_t)i_time )
+                      + 500 ) / 1000;
+
+    snprintf( psz, SECONDS_SIZE, "%s%"PRIu64".%03u",
+              i_time < 0 && i_ms ? "-" : "", i_ms / 1000,
+              (unsigned)( i_ms % 1000 ) );
+    return psz;
+}
+
+static char *buildHlsPlaylist( sout_access_out_sys_t *p_sys, bool b_isend )
+{
+    struct vlc_memstream ms;
+    size_t i_count = vlc_array_count( &p_sys->segments );
+    size_t i_first = firstListedSegment( p_sys );
+    uint32_t i_sequence = 0;
+
+    if( vlc_memstream_open( &ms ) )
+        return NULL;
+
+    if( i_first < i_count )
+        i_sequence = ((cmaf_segment_t *)
+                vlc_array_item_at_index( &p_sys->segments, i_first ))->i_number;
+
+    mtime_t i_target = __MAX( p_sys->i_seglenm, p_sys->i_max_segment );
+    const bool b_parts = p_sys->b_chunked && !b_isend;
+    char psz_sec[SECONDS_SIZE], psz_sec2[SECONDS_SIZE];
+
+    vlc_memstream_printf( &ms, "#EXTM3U\n#EXT-X-VERSION:%d\n"
+                          "#EXT-X-TARGETDURATION:%"PRId64"\n"
+                          "#EXT-X-MEDIA-SEQUENCE:%"PRIu32"\n"
+                          "#EXT-X-INDEPENDENT-SEGMENTS\n",
+                          b_parts ? 9 : 7,
+                          ( i_target + CLOCK_FREQ - 1 ) / CLOCK_FREQ, i_sequence );
+    if( p_sys->i_numsegs == 0 )
+        vlc_memstream_printf( &ms, "#EXT-X-PLAYLIST-TYPE:%s\n",
+                              b_isend ? "VOD" : "EVENT" );
+    if( b_parts )
+    {
+        vlc_memstream_printf( &ms, "#EXT-X-PART-INF:PART-TARGET=%s\n"
+                              "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=%s\n",
+                              formatSeconds( psz_sec, p_sys->i_max_part ),
+                              formatSeconds( psz_sec2, 3 * p_sys->i_max_part ) );
+    }
+    vlc_memstream_printf( &ms, "#EXT-X-MAP:URI=\"%s\"\n", p_sys->psz_initUri );
+
+    for( size_t i = i_first; i < i_count; i++ )
+    {
+        const cmaf_segment_t *segment = vlc_array_item_at_index( &p_sys->segments, i );
+
+        if( b_parts && i + HLS_PART_SEGMENTS >= i_count )
+        {
+            for( int j = 0; j < segment->i_parts; j++ )
+            {
+                const cmaf_part_t *part = &segment->p_parts[j];
+                vlc_memstream_printf( &ms, "#EXT-X-PART:DURATION=%s,URI=\"%s\","
+                                      "BYTERANGE=\"%"PRIu64"@%"PRIu64"\"%s\n",
+                                      formatSeconds( psz_sec, part->i_duration ),
+                                      segment->psz_uri, part->i_size, part->i_offset,
+                                      part->b_independent ? ",INDEPENDENT=YES" : "" );
+            }
+        }
+
+        if( segment->b_complete )
+            vlc_memstream_printf( &ms, "#EXTINF:%s,\n%s\n",
+                                  formatSeconds( psz_sec, segment->i_duration ),
+                                  segment->psz_uri );
+    }
+
+    if( b_isend )
+        vlc_memstream_puts( &ms, "#EXT-X-ENDLIST\n" );
+
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    return ms.ptr;
+}
+
+static void formatIsoDate( char *psz, size_t i_size, time_t i_time )
+{
+    struct tm tm;
+    if( gmtime_r( &i_time, &tm ) == NULL ||
+        strftime( psz, i_size, "%Y-%m-%dT%H:%M:%SZ", &tm ) == 0 )
+        strcpy( psz, "1970-01-01T00:00:00Z" );
+}
+
+static char *buildDashManifest( sout_access_out_t *p_access, bool b_isend )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    struct vlc_memstream ms;
+    size_t i_count = vlc_array_count( &p_sys->segments );
+    size_t i_first = firstListedSegment( p_sys );
+    mtime_t i_target = __MAX( p_sys->i_seglenm, p_sys->i_max_segment );
+    char psz_date[32];
+    char psz_sec[SECONDS_SIZE];
+
+    const char *psz_uriFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl
+                                                    : p_access->psz_path;
+    char *psz_media = formatSegmentName( psz_uriFormat, NULL );
+    if( !psz_media )
+        return NULL;
+
+    if( vlc_memstream_open( &ms ) )
+    {
+        free( psz_media );
+        return NULL;
+    }
+
+    vlc_memstream_puts( &ms, "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+                        "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" "
+                        "profiles=\"urn:mpeg:dash:profile:isoff-live:2011,"
+                        "urn:mpeg:dash:profile:cmaf:2019\"" );
+    if( b_isend )
+    {
+        vlc_memstream_printf( &ms, " type=\"static\" mediaPresentationDuration=\"PT%sS\"",
+                              formatSeconds( psz_sec, p_sys->i_total_duration ) );
+    }
+    else
+    {
+        formatIsoDate( psz_date, sizeof(psz_date), p_sys->i_availability_start );
+        vlc_memstream_printf( &ms, " type=\"dynamic\" availabilityStartTime=\"%s\"",
+                              psz_date );
+        formatIsoDate( psz_date, sizeof(psz_date), time( NULL ) );
+        vlc_memstream_printf( &ms, " publishTime=\"%s\" minimumUpdatePeriod=\"PT%sS\"",
+                              psz_date, formatSeconds( psz_sec, p_sys->b_chunked
+                                                       ? p_sys->i_max_part : i_target ) );
+        if( p_sys->i_numsegs )
+            vlc_memstream_printf( &ms, " timeShiftBufferDepth=\"PT%sS\"",
+                                  formatSeconds( psz_sec, p_sys->i_numsegs * i_target ) );
+    }
+    vlc_memstream_printf( &ms, " minBufferTime=\"PT%sS\">\n"
+                          " <Period id=\"0\" start=\"PT0S\">\n"
+                          "  <AdaptationSet mimeType=\"%s\" segmentAlignment=\"true\""
+                          " startWithSAP=\"1\">\n",
+                          formatSeconds( psz_sec, i_target ),
+                          p_sys->b_video ? "video/mp4" : "audio/mp4" );
+
+    uint32_t i_start_number = 1;
+    if( i_first < i_count )
+        i_start_number = ((cmaf_segment_t *)
+                vlc_array_item_at_index( &p_sys->segments, i_first ))->i_number;
+
+    vlc_memstream_printf( &ms, "   <SegmentTemplate timescale=\"1000\""
+                          " initialization=\"%s\" media=\"%s\" startNumber=\"%"PRIu32"\"",
+                          p_sys->psz_initUri, psz_media, i_start_number );
+    if( p_sys->b_chunked && !b_isend )
+        vlc_memstream_printf( &ms, " availabilityTimeOffset=\"%s\""
+                              " availabilityTimeComplete=\"false\"",
+                              formatSeconds( psz_sec, i_target - p_sys->i_max_part ) );
+    vlc_memstream_puts( &ms, ">\n    <SegmentTimeline>\n" );
+
+    for( size_t i = i_first; i < i_count; i++ )
+    {
+        const cmaf_segment_t *segment = vlc_array_item_at_index( &p_sys->segments, i );
+        if( !segment->b_complete )
+            break;
+        vlc_memstream_printf( &ms, "     <S t=\"%"PRId64"\" d=\"%"PRId64"\"/>\n",
+                              segment->i_start / 1000, segment->i_duration / 1000 );
+    }
+
+    uint64_t i_bandwidth = 0;
+    if( p_sys->i_total_duration > 0 )
+        i_bandwidth = p_sys->i_total_size * 8 * CLOCK_FREQ / p_sys->i_total_duration;
+
+    vlc_memstream_printf( &ms, "    </SegmentTimeline>\n   </SegmentTemplate>\n"
+                          "   <Representation id=\"0\" bandwidth=\"%"PRIu64"\"",
+                          i_bandwidth );
+    if( p_sys->psz_codecs )
+        vlc_memstream_printf( &ms, " codecs=\"%s\"", p_sys->psz_codecs );
+    vlc_memstream_puts( &ms, "/>\n  </AdaptationSet>\n </Period>\n</MPD>\n" );
+
+    free( psz_media );
+    if( vlc_memstream_close( &ms ) )
+        return NULL;
+    return ms.ptr;
+}
+
+/*****************************************************************************
+ * updateIndexAndDel: update manifests & delete old segments
+ *****************************************************************************/
+static void updateIndexAndDel( sout_access_out_t *p_access, bool b_isend )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->psz_hlsPath )
+    {
+        char *psz = buildHlsPlaylist( p_sys, b_isend );
+        if( psz )
+            writeManifestFile( p_access, p_sys->psz_hlsPath, psz );
+        free( psz );
+    }
+
+    if( p_sys->psz_dashPath )
+    {
+        char *psz = buildDashManifest( p_access, b_isend );
+        if( psz )
+            writeManifestFile( p_access, p_sys->psz_dashPath, psz );
+        free( psz );
+    }
+
+    /* Keep one extra segment around for clients still fetching it */
+    size_t i_first = firstListedSegment( p_sys );
+    while( p_sys->b_delsegs && p_sys->i_numsegs && i_first > 1 )
+    {
+        cmaf_segment_t *segment = vlc_array_item_at_index( &p_sys->segments, 0 );
+        msg_Dbg( p_access, "Removing segment number %"PRIu32, segment->i_number );
+        vlc_array_remove( &p_sys->segments, 0 );
+        if( segment->psz_filename )
+            vlc_unlink( segment->psz_filename );
+        destroySegment( segment );
+        i_first--;
+    }
+}
+
+/*****************************************************************************
+ * Segment and fragment handling
+ *****************************************************************************/
+static cmaf_segment_t *currentSegment( sout_access_out_sys_t *p_sys )
+{
+    size_t i_count = vlc_array_count( &p_sys->segments );
+    if( i_count == 0 )
+        return NULL;
+    cmaf_segment_t *segment = vlc_array_item_at_index( &p_sys->segments, i_count - 1 );
+    return segment->b_complete ? NULL : segment;
+}
+
+static void closeCurrentSegment( sout_access_out_t *p_access, bool b_isend )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    cmaf_segment_t *segment = currentSegment( p_sys );
+
+    if( p_sys->i_handle >= 0 )
+    {
+        vlc_close( p_sys->i_handle );
+        p_sys->i_handle = -1;
+    }
+
+    if( !segment )
+        return;
+
+    segment->b_complete = true;
+    p_sys->i_max_segment = __MAX( p_sys->i_max_segment, segment->i_duration );
+    msg_Dbg( p_access, "CmafSegmentComplete: %s (%"PRIu32")",
+             segment->psz_filename, segment->i_number );
+    updateIndexAndDel( p_access, b_isend );
+}
+
+static int openNextSegment( sout_access_out_t *p_access, mtime_t i_start )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    const char *psz_uriFormat = p_sys->psz_indexUrl ? p_sys->psz_indexUrl
+                                                    : p_access->psz_path;
+
+    cmaf_segment_t *segment = calloc( 1, sizeof(*segment) );
+    if( unlikely( !segment ) )
+        return -1;
+
+    segment->i_number = ++p_sys->i_segment;
+    segment->i_start = i_start;
+    segment->psz_filename = formatSegmentPath( p_access->psz_path, segment->i_number );
+    segment->psz_uri = formatSegmentPath( psz_uriFormat, segment->i_number );
+    if( unlikely( !segment->psz_filename || !segment->psz_uri ) )
+    {
+        msg_Err( p_access, "Format segmentpath failed" );
+        destroySegment( segment );
+        return -1;
+    }
+
+    int fd = vlc_open( segment->psz_filename, O_WRONLY | O_CREAT | O_LARGEFILE |
+                       O_TRUNC, 0666 );
+    if( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", segment->psz_filename,
+                 vlc_strerror_c(errno) );
+        destroySegment( segment );
+        return -1;
+    }
+
+    if( p_sys->i_segment == 1 )
+        p_sys->i_availability_start = time( NULL );
+
+    vlc_array_append( &p_sys->segments, segment );
+    p_sys->i_handle = fd;
+    msg_Dbg( p_access, "Successfully opened cmaf segment: %s (%"PRIu32")",
+             segment->psz_filename, segment->i_number );
+    return 0;
+}
+
+/* A moof starts a new fragment, and a new segment when it is a random access
+ * point and the current segment is long enough. The timing comes from the
+ * block where the moof header started. */
+static int startFragment( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    cmaf_segment_t *segment = currentSegment( p_sys );
+    const bool b_sync = p_sys->b_header_sync;
+
+    if( p_sys->i_first_dts == VLC_TS_INVALID )
+        p_sys->i_first_dts = p_sys->i_header_dts;
+
+    if( segment && b_sync && segment->i_duration >= p_sys->i_seglenm )
+    {
+        closeCurrentSegment( p_access, false );
+        segment = NULL;
+    }
+
+    if( !segment )
+    {
+        mtime_t i_start = p_sys->i_header_dts - p_sys->i_first_dts;
+        if( !b_sync )
+            msg_Warn( p_access, "segment %"PRIu32" does not start on a keyframe",
+                      p_sys->i_segment + 1 );
+        if( openNextSegment( p_access, i_start ) )
+            return -1;
+        segment = currentSegment( p_sys );
+    }
+
+    p_sys->b_part_open = true;
+    p_sys->part.i_offset = segment->i_size;
+    p_sys->part.i_size = 0;
+    p_sys->part.i_duration = p_sys->i_header_length;
+    p_sys->part.b_independent = b_sync;
+    return 0;
+}
+
+/* The mdat of the fragment has been fully written */
+static void endFragment( sout_access_out_t *p_access )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    cmaf_segment_t *segment = currentSegment( p_sys );
+
+    p_sys->b_part_open = false;
+    if( !segment )
+        return;
+
+    segment->i_duration += p_sys->part.i_duration;
+    p_sys->i_total_duration += p_sys->part.i_duration;
+    p_sys->i_max_part = __MAX( p_sys->i_max_part, p_sys->part.i_duration );
+
+    if( p_sys->b_chunked )
+    {
+        cmaf_part_t *p_parts = realloc( segment->p_parts,
+                                        (segment->i_parts + 1) * sizeof(*p_parts) );
+        if( p_parts )
+        {
+            p_parts[segment->i_parts++] = p_sys->part;
+            segment->p_parts = p_parts;
+        }
+        updateIndexAndDel( p_access, false );
+    }
+}
+
+static int writeInitSegment( sout_access_out_t *p_access, block_t *p_init )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    parseInitSegment( p_access, p_init );
+
+    int fd = vlc_open( p_sys->psz_initPath, O_WRONLY | O_CREAT | O_LARGEFILE |
+                       O_TRUNC, 0666 );
+    if( fd == -1 )
+    {
+        msg_Err( p_access, "cannot open `%s' (%s)", p_sys->psz_initPath,
+                 vlc_strerror_c(errno) );
+        return -1;
+    }
+
+    ssize_t val = vlc_write( fd, p_init->p_buffer, p_init->i_buffer );
+    vlc_close( fd );
+    if( val != (ssize_t) p_init->i_buffer )
+    {
+        msg_Err( p_access, "cannot write init segment" );
+        return -1;
+    }
+    return 0;
+}
+
+static int writeSegmentData( sout_access_out_t *p_access, const uint8_t *p, size_t i_size )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    cmaf_segment_t *segment = currentSegment( p_sys );
+
+    if( !segment || p_sys->i_handle < 0 )
+        return 0;
+
+    while( i_size )
+    {
+        ssize_t val = vlc_write( p_sys->i_handle, p, i_size );
+        if( val == -1 )
+        {
+            if( errno == EINTR )
+                continue;
+            msg_Err( p_access, "cannot write: %s", vlc_strerror_c(errno) );
+            return -1;
+        }
+        p += val;
+        i_size -= val;
+        segment->i_size += val;
+        p_sys->i_total_size += val;
+        if( p_sys->b_part_open )
+            p_sys->part.i_size += val;
+    }
+    return 0;
+}
+
+/*****************************************************************************
+ * Write: split the fMP4 stream in top level boxes and dispatch them
+ *****************************************************************************/
+static ssize_t Write( sout_access_out_t *p_access, block_t *p_buffer )
+{
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+    size_t i_write = 0;
+
+    while( p_buffer )
+    {
+        block_t *p_next = p_buffer->p_next;
+
+        if( p_buffer->i_flags & BLOCK_FLAG_HEADER )
+        {
+            if( writeInitSegment( p_access, p_buffer ) )
+                goto error;
+            i_write += p_buffer->i_buffer;
+            block_Release( p_buffer );
+            p_buffer = p_next;
+            continue;
+        }
+
+        const uint8_t *p = p_buffer->p_buffer;
+        size_t i_size = p_buffer->i_buffer;
+
+        while( i_size )
+        {
+            if( p_sys->i_box_left == 0 )
+            {
+                if( p_sys->i_header == 0 )
+                {
+                    p_sys->b_header_sync = p_buffer->i_flags & BLOCK_FLAG_TYPE_I;
+                    p_sys->i_header_dts = p_buffer->i_dts;
+                    p_sys->i_header_length = p_buffer->i_length;
+                }
+
+                /* 8 bytes, or 16 with a 64 bits size */
+                size_t i_need = 8;
+                if( p_sys->i_header >= 8 && GetDWBE( p_sys->p_header ) == 1 )
+                    i_need = 16;
+
+                size_t i_copy = __MIN( i_need - p_sys->i_header, i_size );
+                memcpy( &p_sys->p_header[p_sys->i_header], p, i_copy );
+                p_sys->i_header += i_copy;
+                p += i_copy;
+                i_size -= i_copy;
+
+                if( p_sys->i_header < i_need )
+                    break; /* the rest of the header is in the next block */
+
+                uint64_t i_box = GetDWBE( p_sys->p_header );
+                if( i_box == 1 && p_sys->i_header < 16 )
+                    continue;
+
+                const uint8_t *h = p_sys->p_header;
+                p_sys->i_box_type = VLC_FOURCC( h[4], h[5], h[6], h[7] );
+                if( i_box == 1 )
+                    i_box = GetQWBE( &h[8] );
+                else if( i_box == 0 )
+                    i_box = UINT64_MAX; /* up to the end of the stream */
+                if( i_box < p_sys->i_header )
+                {
+                    msg_Err( p_access, "invalid box size" );
+                    goto error;
+                }
+                p_sys->i_box_left = i_box - p_sys->i_header;
+
+                /* fragment random access index refers to absolute offsets */
+                p_sys->b_drop_box = p_sys->i_box_type == VLC_FOURCC('m','f','r','a');
+
+                if( p_sys->i_box_type == VLC_FOURCC('m','o','o','f') &&
+                    startFragment( p_access ) )
+                    goto error;
+
+                if( !p_sys->b_drop_box &&
+                    writeSegmentData( p_access, h, p_sys->i_header ) )
+                    goto error;
+                p_sys->i_header = 0;
+            }
+
+            size_t i_chunk = __MIN( (uint64_t) i_size, p_sys->i_box_left );
+            if( !p_sys->b_drop_box &&
+                writeSegmentData( p_access, p, i_chunk ) )
+                goto error;
+
+            p += i_chunk;
+            i_size -= i_chunk;
+            p_sys->i_box_left -= i_chunk;
+
+            if( p_sys->i_box_left == 0 && p_sys->b_part_open &&
+                p_sys->i_box_type == VLC_FOURCC('m','d','a','t') )
+                endFragment( p_access );
+        }
+
+        i_write += p_buffer->i_buffer;
+        block_Release( p_buffer );
+        p_buffer = p_next;
+    }
+
+    return i_write;
+
+error:
+    block_ChainRelease( p_buffer );
+    return -1;
+}
+
+/*****************************************************************************
+ * Close: close the target
+ *****************************************************************************/
+static void Close( vlc_object_t * p_this )
+{
+    sout_access_out_t *p_access = (sout_access_out_t*)p_this;
+    sout_access_out_sys_t *p_sys = p_access->p_sys;
+
+    if( p_sys->b_part_open )
+        endFragment( p_access );
+
+    if( currentSegment( p_sys ) )
+        closeCurrentSegment( p_access, true );
+    else if( vlc_array_count( &p_sys->segments ) )
+        updateIndexAndDel( p_access, true );
+
+    while( vlc_array_count( &p_sys->segments ) > 0 )
+    {
+        cmaf_segment_t *segment = vlc_array_item_at_index( &p_sys->segments, 0 );
+        vlc_array_remove( &p_sys->segments, 0 );
+        if( p_sys->b_delsegs && p_sys->i_numsegs && segment->psz_filename )
+        {
+            msg_Dbg( p_access, "Removing segment number %"PRIu32" name %s",
+                     segment->i_number, segment->psz_filename );
+            vlc_unlink( segment->psz_filename );
+        }
+        destroySegment( segment );
+    }
+
+    free( p_sys->psz_codecs );
+    free( p_sys->psz_initPath );
+    free( p_sys->psz_initUri );
+    free( p_sys->psz_indexUrl );
+    free( p_sys->psz_dashPath );
+    free( p_sys->psz_hlsPath );
+    free( p_sys );
+
+    msg_Dbg( p_access, "cmaf access output closed" );
+}
+
+static int Control( sout_access_out_t *p_access, int i_query, va_list args )
+{
+    (void) p_access;
+
+    switch( i_query )
+    {
+        case ACCESS_OUT_CONTROLS_PACE:
+        {
+            bool *pb = va_arg( args, bool * );
+            *pb = true;
+            break;
+        }
+
+        default:
+            return VLC_EGENERIC;
+    }
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * Seek: seek to a specific location in a file
+ *****************************************************************************/
+static int Seek( sout_access_out_t *p_access, off_t i_pos )
+{
+    (void) i_pos;
+    msg_Err( p_access, "cmaf sout access cannot seek" );
+    return -1;
+}
@@ -39,6 +39,8 @@
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "../convolver.h"
+
 /*****************************************************************************
  * Local prototypes
  *****************************************************************************/
@@ -72,6 +74,16 @@ static block_t *Convert( filter_t *, block_t * );
      "Dolby Surround encoded streams won't be decoded before being " \
      "processed by this filter. Enabling this setting is not recommended.")
 
+#define HEADPHONE_HRIR_TEXT N_("Head-related impulse responses")
+#define HEADPHONE_HRIR_LONGTEXT N_( \
+     "WAVE file holding the responses of the left and right ears to each " \
+     "virtual speaker, used instead of the built-in room model: one pair " \
+     "of channels per speaker, in the WAVE channel order (e.g. 16 " \
+     "channels for 7.1).")
+
+/* Partition length of the impulse responses, about 3 ms of latency */
+#define HRIR_BLOCK 128
+
 vlc_module_begin ()
     set_description( N_("Headphone virtual spatialization effect") )
     set_shortname( N_("Headphone effect") )
@@ -85,6 +97,8 @@ vlc_module_begin ()
               HEADPHONE_COMPENSATE_LONGTEXT, true )
     add_bool( "headphone-dolby", false, HEADPHONE_DOLBY_TEXT,
               HEADPHONE_DOLBY_LONGTEXT, true )
+    add_loadfile( "headphone-hrir", NULL, HEADPHONE_HRIR_TEXT,
+                  HEADPHONE_HRIR_LONGTEXT, false )
 
     set_capability( "audio filter", 0 )
     set_callbacks( OpenFilter, CloseFilter )
@@ -109,6 +123,7 @@ struct filter_sys_t
     float * p_overflow_buffer;
     unsigned int i_nb_atomic_operations;
     struct atomic_operation_t * p_atomic_operations;
+    convolver_t * p_convolver;/* HRIR rendering, if any */
 };
 
 /*****************************************************************************
@@ -431,6 +446,59 @@ static void DoWork( filter_t * p_filter,
     }
 }
 
+/*****************************************************************************
+ * OpenHrir: set up the rendering through measured impulse responses
+ *****************************************************************************/
+static convolver_t *OpenHrir( filter_t * p_filter, const char * psz_path )
+{
+    unsigned int i_rate, i_nb_channels;
+    size_t i_length;
+    float * p_hrir = convolver_Load( p_filter, psz_path, &i_rate,
+                                     &i_nb_channels, &i_length );
+    if( p_hrir == NULL )
+        return NULL;
+
+    /* A left and a right ear response per speaker */
+    uint8_t pi_table[AOUT_CHAN_MAX];
+    uint16_t i_speakers = 0;
+    if( i_nb_channels % 2 == 0 )
+        i_speakers = convolver_Layout( i_nb_channels / 2, pi_table );
+    if( i_speakers == 0 )
+    {
+        msg_Err( p_filter, "unsupported %u channels HRIR", i_nb_channels );
+        free( p_hrir );
+        return NULL;
+    }
+
+    convolver_t * p_convolver = convolver_New( HRIR_BLOCK, i_nb_channels / 2,
+                                               2, i_length );
+    for( unsigned int i = 0; p_convolver != NULL && i < i_nb_channels; i++ )
+    {
+        if( convolver_SetResponse( p_convolver, pi_table[i / 2], i % 2,
+                                   p_hrir + i, i_length, i_nb_channels,
+                                   1.f ) )
+        {
+            convolver_Delete( p_convolver );
+            p_convolver = NULL;
+        }
+    }
+    free( p_hrir );
+    if( p_convolver == NULL )
+        return NULL;
+
+    /* Let the audio output remix and resample to the HRIR speakers */
+    msg_Dbg( p_filter, "%zu samples HRIR, %u speakers", i_length,
+             i_nb_channels / 2 );
+    p_filter->fmt_in.audio.i_physical_channels = i_speakers;
+    p_filter->fmt_in.audio.i_rate = i_rate;
+    return p_convolver;
+}
+
+static void Flush( filter_t * p_filter )
+{
+    convolver_Reset( p_filter->p_sys->p_convolver );
+}
+
 /*
  * Audio filter 2
  */
@@ -458,8 +526,19 @@ static int OpenFilter( vlc_object_t *p_this )
     p_sys->p_overflow_buffer = NULL;
     p_sys->i_nb_atomic_operations = 0;
     p_sys->p_atomic_operations = NULL;
+    p_sys->p_convolver = NULL;
+
+    char *psz_hrir = var_InheritString( p_filter, "headphone-hrir" );
+    if( psz_hrir != NULL )
+    {
+        p_sys->p_convolver = OpenHrir( p_filter, psz_hrir );
+        free( psz_hrir );
+        if( p_sys->p_convolver == NULL )
+            msg_Warn( p_filter, "using the built-in room model" );
+    }
 
-    if( Init( VLC_OBJECT(p_filter), p_sys
+    if( p_sys->p_convolver == NULL
+     && Init( VLC_OBJECT(p_filter), p_sys
                 , aout_FormatNbChannels ( &(p_filter->fmt_in.audio) )
                 , p_filter->fmt_in.audio.i_physical_channels
                 , p_filter->fmt_in.audio.i_rate ) < 0 )
@@ -474,13 +553,16 @@ static int OpenFilter( vlc_object_t *p_this )
     p_filter->fmt_out.audio.i_rate = p_filter->fmt_in.audio.i_rate;
     p_filter->fmt_in.audio.i_original_channels =
                                    p_filter->fmt_out.audio.i_original_channels;
-    if( p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
+    if( p_sys->p_convolver == NULL
+     && p_filter->fmt_in.audio.i_physical_channels == AOUT_CHANS_STEREO
      && (p_filter->fmt_in.audio.i_original_channels & AOUT_CHAN_DOLBYSTEREO)
      && !var_InheritBool( p_filter, "headphone-dolby" ) )
     {
         p_filter->fmt_in.audio.i_physical_channels = AOUT_CHANS_5_0;
     }
     p_filter->pf_audio_filter = Convert;
+    if( p_sys->p_convolver != NULL )
+        p_filter->pf_flush = Flush;
 
     return VLC_SUCCESS;
 }
@@ -492,6 +574,8 @@ static void CloseFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
 
+    if( p_filter->p_sys->p_convolver != NULL )
+        convolver_Delete( p_filter->p_sys->p_convolver );
     free( p_filter->p_sys->p_overflow_buffer );
     free( p_filter->p_sys->p_atomic_operations );
     free( p_filter->p_sys );
@@ -510,7 +594,7 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
         aout_FormatNbChannels( &(p_filter->fmt_out.audio) ) /
         aout_FormatNbChannels( &(p_filter->fmt_in.audio) );
 
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
@@ -523,7 +607,13 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
 
-    DoWork( p_filter, p_block, p_out );
+    if( p_filter->p_sys->p_convolver != NULL )
+        convolver_Process( p_filter->p_sys->p_convolver,
+                           (float *)p_out->p_buffer,
+                           (const float *)p_block->p_buffer,
+                           p_block->i_nb_samples );
+    else
+        DoWork( p_filter, p_block, p_out );
 
     block_Release( p_block );
     return p_out;
@@ -433,16 +433,14 @@ static block_t *Convert( filter_t *p_filter, block_t *p_block )
     i_out_size = p_block->i_nb_samples * p_filter->p_sys->i_bitspersample/8 *
                  aout_FormatNbChannels( &(p_filter->fmt_out.audio) );
 
-    p_out = block_Alloc( i_out_size );
+    p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
         block_Release( p_block );
         return NULL;
     }
-    p_out->i_nb_samples =
-                  (p_block->i_nb_samples / p_filter->p_sys->i_nb_channels) *
-                       aout_FormatNbChannels( &(p_filter->fmt_out.audio) );
+    p_out->i_nb_samples = p_block->i_nb_samples;
 
 #if 0
     unsigned int i_in_size = in_buf.i_nb_samples  * (p_filter->p_sys->i_bitspersample/8) *
@@ -537,8 +535,10 @@ static void stereo2mono_downmix( filter_t * p_filter,
         /* shorter variable names */
         i_source_channel_offset
             = p_sys->p_atomic_operations[i].i_source_channel_offset;
+        /* both ears are mixed into the mono output */
         i_dest_channel_offset
-            = p_sys->p_atomic_operations[i].i_dest_channel_offset;
+            = p_sys->p_atomic_operations[i].i_dest_channel_offset
+            % i_output_nb;
         i_delay = p_sys->p_atomic_operations[i].i_delay;
         d_amplitude_factor
             = p_sys->p_atomic_operations[i].d_amplitude_factor;
@@ -576,49 +576,48 @@ static void stereo2mono_downmix( filter_t * p_filter,
     }
 }
 
-/* Simple stereo to mono mixing. */
+/* Simple stereo to mono mixing: the first two input channels are averaged
+ * into the single output channel, whatever the input layout. */
 static unsigned int mono( filter_t *p_filter,
                           block_t *p_output, block_t *p_input )
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
-    int16_t *p_in, *p_out;
-    unsigned int n = 0, r = 0;
+    const int16_t *p_in = (const int16_t *) p_input->p_buffer;
+    int16_t *p_out = (int16_t *) p_output->p_buffer;
+    const unsigned int i_nb_channels = p_sys->i_nb_channels;
 
-    p_in = (int16_t *) p_input->p_buffer;
-    p_out = (int16_t *) p_output->p_buffer;
-
-    while( n < (p_input->i_nb_samples * p_sys->i_nb_channels) )
+    for( unsigned int i = 0; i < p_input->i_nb_samples; i++ )
     {
-        p_out[r] = (p_in[n] + p_in[n+1]) >> 1;
-        r++;
-        n += 2;
+        p_out[i] = (p_in[0] + p_in[1]) >> 1;
+        p_in += i_nb_channels;
     }
-    return r;
+    return p_input->i_nb_samples;
 }
 
-/* Simple stereo to mono mixing. */
+/* Simple stereo to mono mixing: the average of the first two input channels,
+ * or the selected channel, is copied to both output channels. */
 static unsigned int stereo_to_mono( filter_t *p_filter,
                                     block_t *p_output, block_t *p_input )
 {
     filter_sys_t *p_sys = (filter_sys_t *)p_filter->p_sys;
-    int16_t *p_in, *p_out;
-    unsigned int n;
+    const int16_t *p_in = (const int16_t *) p_input->p_buffer;
+    int16_t *p_out = (int16_t *) p_output->p_buffer;
+    const unsigned int i_nb_channels = p_sys->i_nb_channels;
+    const int i_selected = p_sys->i_channel_selected;
 
-    p_in = (int16_t *) p_input->p_buffer;
-    p_out = (int16_t *) p_output->p_buffer;
+    /* The output is silent if the selected channel is not in the input */
+    if( i_selected >= (int) i_nb_channels )
+        return p_input->i_nb_samples;
 
-    for( n = 0; n < (p_input->i_nb_samples * p_sys->i_nb_channels); n++ )
+    for( unsigned int i = 0; i < p_input->i_nb_samples; i++ )
     {
         /* Fake real mono. */
-        if( p_sys->i_channel_selected == -1)
-        {
-            p_out[n] = p_out[n+1] = (p_in[n] + p_in[n+1]) >> 1;
-            n++;
-        }
-        else if( (n % p_sys->i_nb_channels) == (unsigned int) p_sys->i_channel_selected )
-        {
-            p_out[n] = p_out[n+1] = p_in[n];
-        }
+        if( i_selected < 0 )
+            p_out[0] = p_out[1] = (p_in[0] + p_in[1]) >> 1;
+        else
+            p_out[0] = p_out[1] = p_in[i_selected];
+        p_in += i_nb_channels;
+        p_out += 2;
     }
-    return n;
+    return p_input->i_nb_samples;
 }
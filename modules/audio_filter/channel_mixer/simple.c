@@ -34,25 +34,39 @@
 #include <vlc_filter.h>
 #include <vlc_block.h>
 
+#include "../converter/format.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
 static int  OpenFilter( vlc_object_t * );
+static void CloseFilter( vlc_object_t * );
 
 vlc_module_begin ()
     set_description( N_("Audio filter for simple channel mixing") )
     set_category( CAT_AUDIO )
     set_subcategory( SUBCAT_AUDIO_MISC )
     set_capability( "audio converter", 10 )
-    set_callbacks( OpenFilter, NULL );
+    set_callbacks( OpenFilter, CloseFilter );
 vlc_module_end ()
 
 static block_t *Filter( filter_t *, block_t * );
 
-static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+typedef void (*work_t)( filter_t *, float *, const float *, unsigned );
+
+struct filter_sys_t
+{
+    work_t    work;
+    pcm_cvt_t convert; /**< conversion of the mix to the output format */
+};
+
+/* Frames mixed at a time when converting to an integer output format */
+#define MIX_FRAMES 128
+
+static void DoWork_7_x_to_2_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         float ctr = p_src[6] * 0.7071f;
         *p_dest++ = ctr + p_src[0] + p_src[2] / 4 + p_src[4] / 4;
@@ -64,13 +78,11 @@ static void DoWork_7_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
-                               block_t *p_out_buf )
+static void DoWork_6_1_to_2_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
 {
     VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+    for( unsigned i = i_nb_samples; i--; )
     {
         float ctr = (p_src[2] + p_src[5]) * 0.7071f;
         *p_dest++ = p_src[0] + p_src[3] + ctr;
@@ -83,10 +95,10 @@ static void DoWork_6_1_to_2_0( filter_t *p_filter, block_t *p_in_buf,
     }
 }
 
-static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_5_x_to_2_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[0] + 0.7071f * (p_src[4] + p_src[2]);
         *p_dest++ = p_src[1] + 0.7071f * (p_src[4] + p_src[3]);
@@ -97,11 +109,11 @@ static void DoWork_5_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
+static void DoWork_4_0_to_2_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
     VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[0];
         *p_dest++ = p_src[2] + p_src[3] + 0.5f * p_src[1];
@@ -109,10 +121,10 @@ static void DoWork_4_0_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_3_x_to_2_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[2] + 0.5f * p_src[0];
         *p_dest++ = p_src[2] + 0.5f * p_src[1];
@@ -123,10 +135,10 @@ static void DoWork_3_x_to_2_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_7_x_to_1_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[6] + p_src[0] / 4 + p_src[1] / 4 + p_src[2] / 8 + p_src[3] / 8 + p_src[4] / 8 + p_src[5] / 8;
 
@@ -136,10 +148,10 @@ static void DoWork_7_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_5_x_to_1_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = 0.7071f * (p_src[0] + p_src[1]) + p_src[4]
                      + 0.5f * (p_src[2] + p_src[3]);
@@ -150,21 +162,21 @@ static void DoWork_5_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_4_0_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
+static void DoWork_4_0_to_1_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
     VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[2] + p_src[3] + p_src[0] / 4 + p_src[1] / 4;
         p_src += 4;
     }
 }
 
-static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_3_x_to_1_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[2] + p_src[0] / 4 + p_src[1] / 4;
 
@@ -174,11 +186,11 @@ static void DoWork_3_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
+static void DoWork_2_x_to_1_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
     VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[0] / 2 + p_src[1] / 2;
 
@@ -186,10 +198,10 @@ static void DoWork_2_x_to_1_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_7_x_to_4_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[6] + 0.5f * p_src[0] + p_src[2] / 6;
         *p_dest++ = p_src[6] + 0.5f * p_src[1] + p_src[3] / 6;
@@ -202,10 +214,10 @@ static void DoWork_7_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_5_x_to_4_0( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         float ctr = p_src[4] * 0.7071f;
         *p_dest++ = p_src[0] + ctr;
@@ -219,10 +231,10 @@ static void DoWork_5_x_to_4_0( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_7_x_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+static void DoWork_7_x_to_5_x( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[0];
         *p_dest++ = p_src[1];
@@ -239,11 +251,11 @@ static void DoWork_7_x_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
-static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t * p_out_buf ) {
+static void DoWork_6_1_to_5_x( filter_t *p_filter, float *p_dest,
+                               const float *p_src, unsigned i_nb_samples )
+{
     VLC_UNUSED(p_filter);
-    float *p_dest = (float *)p_out_buf->p_buffer;
-    const float *p_src = (const float *)p_in_buf->p_buffer;
-    for( int i = p_in_buf->i_nb_samples; i--; )
+    for( unsigned i = i_nb_samples; i--; )
     {
         *p_dest++ = p_src[0];
         *p_dest++ = p_src[1];
@@ -258,9 +270,174 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
     }
 }
 
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+
+#define HAVE_SIMPLE_SSE2
+
+/* The SSE2 kernels mix 4 frames at a time with the same expressions as the
+ * C ones. The frames left over are mixed by the C kernels. */
+
+/* Loads 4 frames of i_stride channels as one vector per channel: c[0] to c[3]
+ * hold the channels 0 to 3, c[4] to c[7] the channels i_stride - 4 to
+ * i_stride - 1. */
+__attribute__ ((__target__ ("sse2")))
+static inline void Load4Frames_sse2( const float *p_src, unsigned i_stride,
+                                     __m128 c[8] )
+{
+    __m128 a0 = _mm_loadu_ps( p_src );
+    __m128 a1 = _mm_loadu_ps( p_src + i_stride );
+    __m128 a2 = _mm_loadu_ps( p_src + 2 * i_stride );
+    __m128 a3 = _mm_loadu_ps( p_src + 3 * i_stride );
+    _MM_TRANSPOSE4_PS( a0, a1, a2, a3 );
+
+    p_src += i_stride - 4;
+    __m128 b0 = _mm_loadu_ps( p_src );
+    __m128 b1 = _mm_loadu_ps( p_src + i_stride );
+    __m128 b2 = _mm_loadu_ps( p_src + 2 * i_stride );
+    __m128 b3 = _mm_loadu_ps( p_src + 3 * i_stride );
+    _MM_TRANSPOSE4_PS( b0, b1, b2, b3 );
+
+    c[0] = a0; c[1] = a1; c[2] = a2; c[3] = a3;
+    c[4] = b0; c[5] = b1; c[6] = b2; c[7] = b3;
+}
+
+/* Channel i of the frames loaded by Load4Frames_sse2() */
+#define CH(i) ((i) < 4 ? c[i] : c[8 + (i) - i_stride])
+
+__attribute__ ((__target__ ("sse2")))
+static inline unsigned Mix_5_x_to_2_0_sse2( float *p_dest, const float *p_src,
+                                            unsigned i_nb_samples,
+                                            unsigned i_stride )
+{
+    const __m128 k = _mm_set1_ps( 0.7071f );
+    unsigned i = 0;
+
+    for( ; i + 4 <= i_nb_samples; i += 4 )
+    {
+        __m128 c[8];
+        Load4Frames_sse2( p_src, i_stride, c );
+
+        __m128 l = _mm_add_ps( CH(0), _mm_mul_ps( k, _mm_add_ps( CH(4),
+                                                                 CH(2) ) ) );
+        __m128 r = _mm_add_ps( CH(1), _mm_mul_ps( k, _mm_add_ps( CH(4),
+                                                                 CH(3) ) ) );
+        _mm_storeu_ps( p_dest, _mm_unpacklo_ps( l, r ) );
+        _mm_storeu_ps( p_dest + 4, _mm_unpackhi_ps( l, r ) );
+
+        p_src += 4 * i_stride;
+        p_dest += 8;
+    }
+    return i;
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline unsigned Mix_7_x_to_5_x_sse2( float *p_dest, const float *p_src,
+                                            unsigned i_nb_samples,
+                                            unsigned i_stride,
+                                            unsigned i_out_stride )
+{
+    const __m128 h = _mm_set1_ps( 0.5f );
+    unsigned i = 0;
+
+    for( ; i + 4 <= i_nb_samples; i += 4 )
+    {
+        __m128 c[8];
+        Load4Frames_sse2( p_src, i_stride, c );
+
+        __m128 f0 = CH(0), f1 = CH(1);
+        __m128 f2 = _mm_mul_ps( _mm_add_ps( CH(2), CH(4) ), h );
+        __m128 f3 = _mm_mul_ps( _mm_add_ps( CH(3), CH(5) ), h );
+        _MM_TRANSPOSE4_PS( f0, f1, f2, f3 );
+
+        const __m128 f[4] = { f0, f1, f2, f3 };
+        for( unsigned j = 0; j < 4; j++ )
+        {
+            _mm_storeu_ps( p_dest, f[j] );
+            p_dest[4] = p_src[6];
+            if( i_out_stride > 5 )
+                p_dest[5] = p_src[7];
+            p_src += i_stride;
+            p_dest += i_out_stride;
+        }
+    }
+    return i;
+}
+
+#undef CH
+
+static void DoWork_5_x_to_2_0_sse2( filter_t *p_filter, float *p_dest,
+                                    const float *p_src, unsigned i_nb_samples )
+{
+    const bool b_lfe =
+        p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE;
+    const unsigned i_stride = b_lfe ? 6 : 5;
+    unsigned i = b_lfe ? Mix_5_x_to_2_0_sse2( p_dest, p_src, i_nb_samples, 6 )
+                       : Mix_5_x_to_2_0_sse2( p_dest, p_src, i_nb_samples, 5 );
+
+    DoWork_5_x_to_2_0( p_filter, p_dest + 2 * i, p_src + i_stride * i,
+                       i_nb_samples - i );
+}
+
+static void DoWork_7_x_to_5_x_sse2( filter_t *p_filter, float *p_dest,
+                                    const float *p_src, unsigned i_nb_samples )
+{
+    const bool b_lfe =
+        p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE;
+    const unsigned i_stride = b_lfe ? 8 : 7;
+    const unsigned i_out_stride = b_lfe &&
+        (p_filter->fmt_out.audio.i_physical_channels & AOUT_CHAN_LFE) ? 6 : 5;
+    unsigned i;
+
+    if( i_out_stride == 6 )
+        i = Mix_7_x_to_5_x_sse2( p_dest, p_src, i_nb_samples, 8, 6 );
+    else if( b_lfe )
+        i = Mix_7_x_to_5_x_sse2( p_dest, p_src, i_nb_samples, 8, 5 );
+    else
+        i = Mix_7_x_to_5_x_sse2( p_dest, p_src, i_nb_samples, 7, 5 );
+
+    DoWork_7_x_to_5_x( p_filter, p_dest + i_out_stride * i,
+                       p_src + i_stride * i, i_nb_samples - i );
+}
+
+#define SSE2_WRAPPER(in, out) \
+    static inline work_t GET_WORK_##in##_to_##out##_sse2( void ) \
+    { \
+        return vlc_CPU_SSE2() ? DoWork_##in##_to_##out##_sse2 \
+                              : DoWork_##in##_to_##out; \
+    }
+
+SSE2_WRAPPER(5_x,2_0)
+SSE2_WRAPPER(7_x,5_x)
+
+/* TODO: the following conversions are not handled in SSE2. The compiler
+ * vectorizes the 7.x to stereo downmix well enough on its own. */
+
+#define C_WRAPPER(in, out) \
+    static inline work_t GET_WORK_##in##_to_##out##_sse2( void ) \
+    { \
+        return DoWork_##in##_to_##out; \
+    }
+
+C_WRAPPER(7_x,2_0)
+C_WRAPPER(4_0,2_0)
+C_WRAPPER(3_x,2_0)
+C_WRAPPER(6_1,2_0)
+C_WRAPPER(7_x,1_0)
+C_WRAPPER(5_x,1_0)
+C_WRAPPER(4_0,1_0)
+C_WRAPPER(3_x,1_0)
+C_WRAPPER(2_x,1_0)
+C_WRAPPER(7_x,4_0)
+C_WRAPPER(5_x,4_0)
+C_WRAPPER(6_1,5_x)
+#endif
+
 #if defined (CAN_COMPILE_ARM)
 #include "simple_neon.h"
 #define GET_WORK(in, out) GET_WORK_##in##_to_##out##_neon()
+#elif defined (HAVE_SIMPLE_SSE2)
+#define GET_WORK(in, out) GET_WORK_##in##_to_##out##_sse2()
 #else
 #define GET_WORK(in, out) DoWork_##in##_to_##out
 #endif
@@ -271,14 +448,22 @@ static void DoWork_6_1_to_5_x( filter_t * p_filter,  block_t * p_in_buf, block_t
 static int OpenFilter( vlc_object_t *p_this )
 {
     filter_t *p_filter = (filter_t *)p_this;
-    void (*do_work)(filter_t *, block_t *, block_t *) = NULL;
+    work_t do_work = NULL;
+    pcm_cvt_t convert = NULL;
 
     if( p_filter->fmt_in.audio.i_format != VLC_CODEC_FL32 ||
-        p_filter->fmt_in.audio.i_format != p_filter->fmt_out.audio.i_format ||
         p_filter->fmt_in.audio.i_rate != p_filter->fmt_out.audio.i_rate ||
         aout_FormatNbChannels( &p_filter->fmt_in.audio) < 2 )
         return VLC_EGENERIC;
 
+    /* The mix can be converted on the fly to an integer output format */
+    if( p_filter->fmt_out.audio.i_format != VLC_CODEC_FL32 )
+    {
+        convert = Fl32toIntegerFind( p_filter->fmt_out.audio.i_format );
+        if( convert == NULL )
+            return VLC_EGENERIC;
+    }
+
     uint32_t input = p_filter->fmt_in.audio.i_physical_channels;
     uint32_t output = p_filter->fmt_out.audio.i_physical_channels;
 
@@ -348,17 +533,33 @@ static int OpenFilter( vlc_object_t *p_this )
     if( do_work == NULL )
         return VLC_EGENERIC;
 
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+    p_sys->work = do_work;
+    p_sys->convert = convert;
+
     p_filter->pf_audio_filter = Filter;
-    p_filter->p_sys = (void *)do_work;
+    p_filter->p_sys = p_sys;
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * CloseFilter:
+ *****************************************************************************/
+static void CloseFilter( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
+
 /*****************************************************************************
  * Filter:
  *****************************************************************************/
 static block_t *Filter( filter_t *p_filter, block_t *p_block )
 {
-    void (*work)(filter_t *, block_t *, block_t *) = (void *)p_filter->p_sys;
+    filter_sys_t *p_sys = p_filter->p_sys;
 
     if( !p_block || !p_block->i_nb_samples )
     {
@@ -371,7 +572,7 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
       p_filter->fmt_out.audio.i_bitspersample *
         p_filter->fmt_out.audio.i_channels / 8;
 
-    block_t *p_out = block_Alloc( i_out_size );
+    block_t *p_out = filter_NewAudioBuffer( p_filter, i_out_size );
     if( !p_out )
     {
         msg_Warn( p_filter, "can't get output buffer" );
@@ -383,16 +584,33 @@ static block_t *Filter( filter_t *p_filter, block_t *p_block )
     p_out->i_dts = p_block->i_dts;
     p_out->i_pts = p_block->i_pts;
     p_out->i_length = p_block->i_length;
-
-    int i_input_nb = aout_FormatNbChannels( &p_filter->fmt_in.audio );
-    int i_output_nb = aout_FormatNbChannels( &p_filter->fmt_out.audio );
-    p_out->i_nb_samples = p_block->i_nb_samples;
-    p_out->i_buffer = p_block->i_buffer * i_output_nb / i_input_nb;
-
-    work( p_filter, p_block, p_out );
+    p_out->i_buffer = i_out_size;
+
+    const float *p_src = (const float *)p_block->p_buffer;
+
+    if( p_sys->convert == NULL )
+        p_sys->work( p_filter, (float *)p_out->p_buffer, p_src,
+                     p_block->i_nb_samples );
+    else
+    {   /* Mix by chunks small enough to stay in cache, and convert each */
+        const unsigned i_input_nb =
+            aout_FormatNbChannels( &p_filter->fmt_in.audio );
+        const unsigned i_output_nb =
+            aout_FormatNbChannels( &p_filter->fmt_out.audio );
+        const size_t i_out_frame = i_out_size / p_block->i_nb_samples;
+        float p_mix[MIX_FRAMES * AOUT_CHAN_MAX];
+
+        for( unsigned i = 0; i < p_block->i_nb_samples; i += MIX_FRAMES )
+        {
+            unsigned i_frames = __MIN( p_block->i_nb_samples - i, MIX_FRAMES );
+
+            p_sys->work( p_filter, p_mix, p_src + i * i_input_nb, i_frames );
+            p_sys->convert( p_out->p_buffer + i * i_out_frame, p_mix,
+                            i_frames * i_output_nb );
+        }
+    }
 
     block_Release( p_block );
 
     return p_out;
 }
-
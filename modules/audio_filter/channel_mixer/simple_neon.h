@@ -35,14 +35,13 @@
 
 #define NEON_WRAPPER(in, out)                                                    \
     void convert_##in##_to_##out##_neon_asm(float *dst, const float *src, int num, bool lfeChannel); \
-    static inline void DoWork_##in##_to_##out##_neon( filter_t *p_filter, block_t *p_in_buf, block_t *p_out_buf )  \
+    static inline void DoWork_##in##_to_##out##_neon( filter_t *p_filter, float *p_dest, \
+                                                      const float *p_src, unsigned i_nb_samples ) \
     {                                                                            \
-        const float *p_src = (const float *)p_in_buf->p_buffer;                  \
-        float *p_dest = (float *)p_out_buf->p_buffer;                            \
-        convert_##in##_to_##out##_neon_asm( p_dest, p_src, p_in_buf->i_nb_samples, \
+        convert_##in##_to_##out##_neon_asm( p_dest, p_src, i_nb_samples,       \
                   p_filter->fmt_in.audio.i_physical_channels & AOUT_CHAN_LFE );  \
     } \
-    static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
+    static inline work_t GET_WORK_##in##_to_##out##_neon() \
     { \
         return vlc_CPU_ARM_NEON() ? DoWork_##in##_to_##out##_neon : DoWork_##in##_to_##out; \
     }
@@ -59,7 +58,7 @@ NEON_WRAPPER(5_x,4_0)
 /* TODO: the following conversions are not handled in NEON */
 
 #define C_WRAPPER(in, out) \
-    static inline void (*GET_WORK_##in##_to_##out##_neon())(filter_t*, block_t*, block_t*) \
+    static inline work_t GET_WORK_##in##_to_##out##_neon() \
     { \
         return DoWork_##in##_to_##out; \
     }
@@ -40,6 +40,8 @@
 #include <vlc_block.h>
 #include <vlc_filter.h>
 
+#include "format.h"
+
 /*****************************************************************************
  * Module descriptor
  *****************************************************************************/
@@ -57,8 +59,8 @@ vlc_module_end()
  * Local prototypes
  *****************************************************************************/
 
-typedef block_t *(*cvt_t)(filter_t *, block_t *);
-static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst);
+static pcm_cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst);
+static block_t *Convert(filter_t *, block_t *);
 
 static int Open(vlc_object_t *object)
 {
@@ -72,110 +74,93 @@ static int Open(vlc_object_t *object)
     if (src->i_codec == dst->i_codec)
         return VLC_EGENERIC;
 
-    filter->pf_audio_filter = FindConversion(src->i_codec, dst->i_codec);
-    if (filter->pf_audio_filter == NULL)
+    pcm_cvt_t convert = FindConversion(src->i_codec, dst->i_codec);
+    if (convert == NULL)
         return VLC_EGENERIC;
 
+    filter->pf_audio_filter = Convert;
+    filter->p_sys = (void *)convert;
+
     msg_Dbg(filter, "%4.4s->%4.4s, bits per sample: %i->%i",
             (char *)&src->i_codec, (char *)&dst->i_codec,
             src->audio.i_bitspersample, dst->audio.i_bitspersample);
     return VLC_SUCCESS;
 }
 
-
-/*** from U8 ***/
-static block_t *U8toS16(filter_t *filter, block_t *bsrc)
+static block_t *Convert(filter_t *filter, block_t *bsrc)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
+    pcm_cvt_t convert = (pcm_cvt_t)filter->p_sys;
+    const unsigned src_size = aout_BitsPerSample(filter->fmt_in.i_codec) / 8;
+    const unsigned dst_size = aout_BitsPerSample(filter->fmt_out.i_codec) / 8;
+    const size_t n = bsrc->i_buffer / src_size;
 
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    int16_t *dst = (int16_t *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
-        *dst++ = ((*src++) << 8) - 0x8000;
-out:
+    /* Samples that do not grow are converted in place */
+    if (dst_size <= src_size)
+    {
+        convert(bsrc->p_buffer, bsrc->p_buffer, n);
+        bsrc->i_buffer = n * dst_size;
+        return bsrc;
+    }
+
+    block_t *bdst = filter_NewAudioBuffer(filter, n * dst_size);
+    if (likely(bdst != NULL))
+    {
+        block_CopyProperties(bdst, bsrc);
+        convert(bdst->p_buffer, bsrc->p_buffer, n);
+    }
     block_Release(bsrc);
-    VLC_UNUSED(filter);
     return bdst;
 }
 
-static block_t *U8toFl32(filter_t *filter, block_t *bsrc)
+
+/*** from U8 ***/
+static void U8toS16_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
+    const uint8_t *src = s;
+    int16_t *dst = d;
+    while (n--)
+        *dst++ = ((*src++) << 8) - 0x8000;
+}
 
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
+static void U8toFl32_C(void *d, const void *s, size_t n)
+{
+    const uint8_t *src = s;
+    float *dst = d;
+    while (n--)
         *dst++ = ((float)((*src++) - 128)) / 128.f;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
-static block_t *U8toS32(filter_t *filter, block_t *bsrc)
+static void U8toS32_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
+    const uint8_t *src = s;
+    int32_t *dst = d;
+    while (n--)
         *dst++ = ((*src++) << 24) - 0x80000000;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
-static block_t *U8toFl64(filter_t *filter, block_t *bsrc)
+static void U8toFl64_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 8);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    uint8_t *src = (uint8_t *)bsrc->p_buffer;
-    double  *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer; i--;)
+    const uint8_t *src = s;
+    double *dst = d;
+    while (n--)
         *dst++ = ((double)((*src++) - 128)) / 128.;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
 
 /*** from S16N ***/
-static block_t *S16toU8(filter_t *filter, block_t *b)
+static void S16toU8_C(void *d, const void *s, size_t n)
 {
-    VLC_UNUSED(filter);
-    int16_t *src = (int16_t *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 2; i--;)
+    const int16_t *src = s;
+    uint8_t *dst = d;
+    while (n--)
         *dst++ = ((*src++) + 32768) >> 8;
-
-    b->i_buffer /= 2;
-    return b;
 }
 
-static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
+static void S16toFl32_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    const int16_t *src = s;
+    float *dst = d;
+    while (n--)
 #if 0
         /* Slow version */
         *dst++ = (float)*src++ / 32768.f;
@@ -188,213 +173,111 @@ static block_t *S16toFl32(filter_t *filter, block_t *bsrc)
         *dst++ = u.f - 384.f;
     }
 #endif
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
-static block_t *S16toS32(filter_t *filter, block_t *bsrc)
+static void S16toS32_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    int32_t *dst = (int32_t *)bdst->p_buffer;
-    for (int i = bsrc->i_buffer / 2; i--;)
+    const int16_t *src = s;
+    int32_t *dst = d;
+    while (n--)
         *dst++ = *src++ << 16;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
-static block_t *S16toFl64(filter_t *filter, block_t *bsrc)
+static void S16toFl64_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 4);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int16_t *src = (int16_t *)bsrc->p_buffer;
-    float   *dst = (float *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 2; i--;)
+    const int16_t *src = s;
+    double *dst = d;
+    while (n--)
         *dst++ = (double)*src++ / 32768.;
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
 
 /*** from FL32 ***/
-static block_t *Fl32toU8(filter_t *filter, block_t *b)
+static void Fl32toU8_C(void *d, const void *s, size_t n)
 {
-    float   *src = (float *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    const float *src = s;
+    uint8_t *dst = d;
+    while (n--)
     {
-        float s = *(src++) * 128.f;
-        if (s >= 127.f)
+        float v = *(src++) * 128.f;
+        if (v >= 127.f)
             *(dst++) = 255;
         else
-        if (s <= -128.f)
+        if (v <= -128.f)
             *(dst++) = 0;
         else
-            *(dst++) = lroundf(s) + 128;
+            *(dst++) = lroundf(v) + 128;
     }
-    b->i_buffer /= 4;
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl32toS16(filter_t *filter, block_t *b)
-{
-    VLC_UNUSED(filter);
-    float   *src = (float *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (int i = b->i_buffer / 4; i--;) {
-#if 0
-        /* Slow version. */
-        if (*src >= 1.0) *dst = 32767;
-        else if (*src < -1.0) *dst = -32768;
-        else *dst = lroundf(*src * 32768.f);
-        src++; dst++;
-#else
-        /* This is Walken's trick based on IEEE float format. */
-        union { float f; int32_t i; } u;
-        u.f = *src++ + 384.f;
-        if (u.i > 0x43c07fff)
-            *dst++ = 32767;
-        else if (u.i < 0x43bf8000)
-            *dst++ = -32768;
-        else
-            *dst++ = u.i - 0x43c00000;
-#endif
-    }
-    b->i_buffer /= 2;
-    return b;
-}
-
-static block_t *Fl32toS32(filter_t *filter, block_t *b)
-{
-    float   *src = (float *)b->p_buffer;
-    int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
-    {
-        float s = *(src++) * 2147483648.f;
-        if (s >= 2147483647.f)
-            *(dst++) = 2147483647;
-        else
-        if (s <= -2147483648.f)
-            *(dst++) = -2147483648;
-        else
-            *(dst++) = lroundf(s);
-    }
-    VLC_UNUSED(filter);
-    return b;
-}
+/* Fl32toS16_C and Fl32toS32_C are shared with the channel mixers */
 
-static block_t *Fl32toFl64(filter_t *filter, block_t *bsrc)
+static void Fl32toFl64_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    float  *src = (float *)bsrc->p_buffer;
-    double *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 4; i--;)
+    const float *src = s;
+    double *dst = d;
+    while (n--)
         *(dst++) = *(src++);
-out:
-    block_Release(bsrc);
-    VLC_UNUSED(filter);
-    return bdst;
 }
 
 
 /*** from S32N ***/
-static block_t *S32toU8(filter_t *filter, block_t *b)
+static void S32toU8_C(void *d, const void *s, size_t n)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    const int32_t *src = s;
+    uint8_t *dst = d;
+    while (n--)
         *dst++ = ((*src++) >> 24) + 128;
-
-    b->i_buffer /= 4;
-    return b;
 }
 
-static block_t *S32toS16(filter_t *filter, block_t *b)
+static void S32toS16_C(void *d, const void *s, size_t n)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (size_t i = b->i_buffer / 4; i--;)
+    const int32_t *src = s;
+    int16_t *dst = d;
+    while (n--)
         *dst++ = (*src++) >> 16;
-
-    b->i_buffer /= 2;
-    return b;
 }
 
-static block_t *S32toFl32(filter_t *filter, block_t *b)
+static void S32toFl32_C(void *d, const void *s, size_t n)
 {
-    VLC_UNUSED(filter);
-    int32_t *src = (int32_t*)b->p_buffer;
-    float   *dst = (float *)src;
-    for (int i = b->i_buffer / 4; i--;)
+    const int32_t *src = s;
+    float *dst = d;
+    while (n--)
         *dst++ = (float)(*src++) / 2147483648.f;
-    return b;
 }
 
-static block_t *S32toFl64(filter_t *filter, block_t *bsrc)
+static void S32toFl64_C(void *d, const void *s, size_t n)
 {
-    block_t *bdst = block_Alloc(bsrc->i_buffer * 2);
-    if (unlikely(bdst == NULL))
-        goto out;
-
-    block_CopyProperties(bdst, bsrc);
-    int32_t *src = (int32_t*)bsrc->p_buffer;
-    double  *dst = (double *)bdst->p_buffer;
-    for (size_t i = bsrc->i_buffer / 4; i--;)
+    const int32_t *src = s;
+    double *dst = d;
+    while (n--)
         *dst++ = (double)(*src++) / 2147483648.;
-out:
-    VLC_UNUSED(filter);
-    block_Release(bsrc);
-    return bdst;
 }
 
 
 /*** from FL64 ***/
-static block_t *Fl64toU8(filter_t *filter, block_t *b)
+static void Fl64toU8_C(void *d, const void *s, size_t n)
 {
-    double  *src = (double *)b->p_buffer;
-    uint8_t *dst = (uint8_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    const double *src = s;
+    uint8_t *dst = d;
+    while (n--)
     {
-        float s = *(src++) * 128.;
-        if (s >= 127.f)
+        float v = *(src++) * 128.;
+        if (v >= 127.f)
             *(dst++) = 255;
         else
-        if (s <= -128.f)
+        if (v <= -128.f)
             *(dst++) = 0;
         else
-            *(dst++) = lround(s) + 128;
+            *(dst++) = lround(v) + 128;
     }
-    b->i_buffer /= 8;
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl64toS16(filter_t *filter, block_t *b)
+static void Fl64toS16_C(void *d, const void *s, size_t n)
 {
-    VLC_UNUSED(filter);
-    double  *src = (double *)b->p_buffer;
-    int16_t *dst = (int16_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;) {
+    const double *src = s;
+    int16_t *dst = d;
+    while (n--) {
         const double v = *src++ * 32768.;
         /* Slow version. */
         if (v >= 32767.)
@@ -404,82 +287,516 @@ static block_t *Fl64toS16(filter_t *filter, block_t *b)
         else
             *dst++ = lround(v);
     }
-    b->i_buffer /= 4;
-    return b;
 }
 
-static block_t *Fl64toFl32(filter_t *filter, block_t *b)
+static void Fl64toFl32_C(void *d, const void *s, size_t n)
 {
-    double *src = (double *)b->p_buffer;
-    float  *dst = (float *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    const double *src = s;
+    float *dst = d;
+    while (n--)
         *(dst++) = *(src++);
-
-    VLC_UNUSED(filter);
-    return b;
 }
 
-static block_t *Fl64toS32(filter_t *filter, block_t *b)
+static void Fl64toS32_C(void *d, const void *s, size_t n)
 {
-    double  *src = (double *)b->p_buffer;
-    int32_t *dst = (int32_t *)src;
-    for (size_t i = b->i_buffer / 8; i--;)
+    const double *src = s;
+    int32_t *dst = d;
+    while (n--)
     {
-        float s = *(src++) * 2147483648.;
-        if (s >= 2147483647.f)
+        float v = *(src++) * 2147483648.;
+        if (v >= 2147483647.f)
             *(dst++) = 2147483647;
         else
-        if (s <= -2147483648.f)
+        if (v <= -2147483648.f)
             *(dst++) = -2147483648;
         else
-            *(dst++) = lround(s);
+            *(dst++) = lround(v);
+    }
+}
+
+
+#ifdef HAVE_FORMAT_SSE2
+/* The vectorized kernels handle whole vectors, and leave the remaining
+ * samples to the C version. In place, they never store ahead of what they
+ * have loaded. */
+
+/* Zero-extends 16 unsigned bytes to 4 vectors of 32-bit integers */
+__attribute__ ((__target__ ("sse2")))
+static inline void U8toS32_16_SSE2(__m128i x, __m128i out[4])
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i lo = _mm_unpacklo_epi8(x, zero), hi = _mm_unpackhi_epi8(x, zero);
+
+    out[0] = _mm_unpacklo_epi16(lo, zero);
+    out[1] = _mm_unpackhi_epi16(lo, zero);
+    out[2] = _mm_unpacklo_epi16(hi, zero);
+    out[3] = _mm_unpackhi_epi16(hi, zero);
+}
+
+/* Converts 4 samples scaled by 128 to unsigned 8 bits, rounding half away
+ * from zero as lroundf() does */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i RoundU8_4_SSE2(__m128 v)
+{
+    v = _mm_min_ps(v, _mm_set1_ps(127.f));
+    v = _mm_max_ps(v, _mm_set1_ps(-128.f));
+
+    __m128i i = _mm_cvttps_epi32(v);
+    __m128 frac = _mm_sub_ps(v, _mm_cvtepi32_ps(i));
+    i = _mm_sub_epi32(i, _mm_castps_si128(
+                            _mm_cmpge_ps(frac, _mm_set1_ps(.5f))));
+    i = _mm_add_epi32(i, _mm_castps_si128(
+                            _mm_cmple_ps(frac, _mm_set1_ps(-.5f))));
+    return _mm_add_epi32(i, _mm_set1_epi32(128));
+}
+
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i PackU8_16_SSE2(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    return _mm_packus_epi16(_mm_packs_epi32(a, b), _mm_packs_epi32(c, d));
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void U8toS16_SSE2(void *d, const void *s, size_t n)
+{
+    const uint8_t *src = s;
+    int16_t *dst = d;
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i x = _mm_xor_si128(_mm_loadu_si128((const __m128i *)src),
+                                  _mm_set1_epi8(0x80));
+        _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi8(zero, x));
+        _mm_storeu_si128((__m128i *)(dst + 8), _mm_unpackhi_epi8(zero, x));
+    }
+    U8toS16_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void U8toFl32_SSE2(void *d, const void *s, size_t n)
+{
+    const uint8_t *src = s;
+    float *dst = d;
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        U8toS32_16_SSE2(_mm_loadu_si128((const __m128i *)src), v);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            __m128i x = _mm_sub_epi32(v[i], _mm_set1_epi32(128));
+            _mm_storeu_ps(dst + 4 * i, _mm_mul_ps(_mm_cvtepi32_ps(x),
+                                                  _mm_set1_ps(1.f / 128.f)));
+        }
+    }
+    U8toFl32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void U8toS32_SSE2(void *d, const void *s, size_t n)
+{
+    const uint8_t *src = s;
+    int32_t *dst = d;
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        U8toS32_16_SSE2(_mm_xor_si128(_mm_loadu_si128((const __m128i *)src),
+                                      _mm_set1_epi8(0x80)), v);
+        for (unsigned i = 0; i < 4; i++)
+            _mm_storeu_si128((__m128i *)(dst + 4 * i),
+                             _mm_slli_epi32(v[i], 24));
+    }
+    U8toS32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void U8toFl64_SSE2(void *d, const void *s, size_t n)
+{
+    const uint8_t *src = s;
+    double *dst = d;
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        U8toS32_16_SSE2(_mm_loadu_si128((const __m128i *)src), v);
+        for (unsigned i = 0; i < 4; i++)
+        {
+            __m128i x = _mm_sub_epi32(v[i], _mm_set1_epi32(128));
+            __m128d lo = _mm_cvtepi32_pd(x);
+            __m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(x, 0xEE));
+            _mm_storeu_pd(dst + 4 * i, _mm_mul_pd(lo, _mm_set1_pd(1. / 128.)));
+            _mm_storeu_pd(dst + 4 * i + 2,
+                          _mm_mul_pd(hi, _mm_set1_pd(1. / 128.)));
+        }
+    }
+    U8toFl64_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toU8_SSE2(void *d, const void *s, size_t n)
+{
+    const int16_t *src = s;
+    uint8_t *dst = d;
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)src);
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 8));
+        __m128i x = _mm_packs_epi16(_mm_srai_epi16(a, 8), _mm_srai_epi16(b, 8));
+        _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(x, _mm_set1_epi8(0x80)));
+    }
+    S16toU8_C(dst, src, n);
+}
+
+/* Sign-extends 8 16-bit integers to 2 vectors of 32-bit integers */
+__attribute__ ((__target__ ("sse2")))
+static inline void S16toS32_8_SSE2(__m128i x, __m128i *lo, __m128i *hi)
+{
+    *lo = _mm_srai_epi32(_mm_unpacklo_epi16(x, x), 16);
+    *hi = _mm_srai_epi32(_mm_unpackhi_epi16(x, x), 16);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toFl32_SSE2(void *d, const void *s, size_t n)
+{
+    const int16_t *src = s;
+    float *dst = d;
+    const __m128 scale = _mm_set1_ps(1.f / 32768.f);
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i lo, hi;
+        S16toS32_8_SSE2(_mm_loadu_si128((const __m128i *)src), &lo, &hi);
+        _mm_storeu_ps(dst, _mm_mul_ps(_mm_cvtepi32_ps(lo), scale));
+        _mm_storeu_ps(dst + 4, _mm_mul_ps(_mm_cvtepi32_ps(hi), scale));
+    }
+    S16toFl32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toS32_SSE2(void *d, const void *s, size_t n)
+{
+    const int16_t *src = s;
+    int32_t *dst = d;
+    const __m128i zero = _mm_setzero_si128();
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)src);
+        _mm_storeu_si128((__m128i *)dst, _mm_unpacklo_epi16(zero, x));
+        _mm_storeu_si128((__m128i *)(dst + 4), _mm_unpackhi_epi16(zero, x));
+    }
+    S16toS32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S16toFl64_SSE2(void *d, const void *s, size_t n)
+{
+    const int16_t *src = s;
+    double *dst = d;
+    const __m128d scale = _mm_set1_pd(1. / 32768.);
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i v[2];
+        S16toS32_8_SSE2(_mm_loadu_si128((const __m128i *)src), &v[0], &v[1]);
+        for (unsigned i = 0; i < 2; i++)
+        {
+            __m128d lo = _mm_cvtepi32_pd(v[i]);
+            __m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(v[i], 0xEE));
+            _mm_storeu_pd(dst + 4 * i, _mm_mul_pd(lo, scale));
+            _mm_storeu_pd(dst + 4 * i + 2, _mm_mul_pd(hi, scale));
+        }
+    }
+    S16toFl64_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toU8_SSE2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    uint8_t *dst = d;
+    const __m128 scale = _mm_set1_ps(128.f);
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        for (unsigned i = 0; i < 4; i++)
+            v[i] = RoundU8_4_SSE2(_mm_mul_ps(_mm_loadu_ps(src + 4 * i), scale));
+        _mm_storeu_si128((__m128i *)dst, PackU8_16_SSE2(v[0], v[1], v[2], v[3]));
+    }
+    Fl32toU8_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toFl64_SSE2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    double *dst = d;
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+    {
+        __m128 x = _mm_loadu_ps(src);
+        _mm_storeu_pd(dst, _mm_cvtps_pd(x));
+        _mm_storeu_pd(dst + 2, _mm_cvtps_pd(_mm_movehl_ps(x, x)));
+    }
+    Fl32toFl64_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toU8_SSE2(void *d, const void *s, size_t n)
+{
+    const int32_t *src = s;
+    uint8_t *dst = d;
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        for (unsigned i = 0; i < 4; i++)
+            v[i] = _mm_srai_epi32(_mm_loadu_si128((const __m128i *)(src + 4 * i)),
+                                  24);
+        __m128i x = _mm_packs_epi16(_mm_packs_epi32(v[0], v[1]),
+                                    _mm_packs_epi32(v[2], v[3]));
+        _mm_storeu_si128((__m128i *)dst, _mm_xor_si128(x, _mm_set1_epi8(0x80)));
+    }
+    S32toU8_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toS16_SSE2(void *d, const void *s, size_t n)
+{
+    const int32_t *src = s;
+    int16_t *dst = d;
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i a = _mm_loadu_si128((const __m128i *)src);
+        __m128i b = _mm_loadu_si128((const __m128i *)(src + 4));
+        _mm_storeu_si128((__m128i *)dst,
+                         _mm_packs_epi32(_mm_srai_epi32(a, 16),
+                                         _mm_srai_epi32(b, 16)));
+    }
+    S32toS16_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toFl32_SSE2(void *d, const void *s, size_t n)
+{
+    const int32_t *src = s;
+    float *dst = d;
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+    {
+        __m128 x = _mm_cvtepi32_ps(_mm_loadu_si128((const __m128i *)src));
+        _mm_storeu_ps(dst, _mm_mul_ps(x, _mm_set1_ps(1.f / 2147483648.f)));
+    }
+    S32toFl32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void S32toFl64_SSE2(void *d, const void *s, size_t n)
+{
+    const int32_t *src = s;
+    double *dst = d;
+    const __m128d scale = _mm_set1_pd(1. / 2147483648.);
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+    {
+        __m128i x = _mm_loadu_si128((const __m128i *)src);
+        __m128d lo = _mm_cvtepi32_pd(x);
+        __m128d hi = _mm_cvtepi32_pd(_mm_shuffle_epi32(x, 0xEE));
+        _mm_storeu_pd(dst, _mm_mul_pd(lo, scale));
+        _mm_storeu_pd(dst + 2, _mm_mul_pd(hi, scale));
+    }
+    S32toFl64_C(dst, src, n);
+}
+
+/* Narrows 4 doubles scaled in double precision to floats, as the C version
+ * does before rounding */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128 Fl64toFl32_4_SSE2(const double *src, __m128d scale)
+{
+    __m128 lo = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src), scale));
+    __m128 hi = _mm_cvtpd_ps(_mm_mul_pd(_mm_loadu_pd(src + 2), scale));
+    return _mm_movelh_ps(lo, hi);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl64toU8_SSE2(void *d, const void *s, size_t n)
+{
+    const double *src = s;
+    uint8_t *dst = d;
+    const __m128d scale = _mm_set1_pd(128.);
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m128i v[4];
+        for (unsigned i = 0; i < 4; i++)
+            v[i] = RoundU8_4_SSE2(Fl64toFl32_4_SSE2(src + 4 * i, scale));
+        _mm_storeu_si128((__m128i *)dst, PackU8_16_SSE2(v[0], v[1], v[2], v[3]));
     }
-    VLC_UNUSED(filter);
-    return b;
+    Fl64toU8_C(dst, src, n);
 }
 
+/* Converts 2 doubles to 32-bit integers in the low half, rounding half away
+ * from zero as lround() does */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i RoundS16_2_SSE2(__m128d v)
+{
+    const __m128d one = _mm_set1_pd(1.);
+
+    v = _mm_min_pd(v, _mm_set1_pd(32767.));
+    v = _mm_max_pd(v, _mm_set1_pd(-32768.));
+
+    __m128d t = _mm_cvtepi32_pd(_mm_cvttpd_epi32(v));
+    __m128d frac = _mm_sub_pd(v, t);
+    t = _mm_add_pd(t, _mm_and_pd(_mm_cmpge_pd(frac, _mm_set1_pd(.5)), one));
+    t = _mm_sub_pd(t, _mm_and_pd(_mm_cmple_pd(frac, _mm_set1_pd(-.5)), one));
+    return _mm_cvttpd_epi32(t);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl64toS16_SSE2(void *d, const void *s, size_t n)
+{
+    const double *src = s;
+    int16_t *dst = d;
+    const __m128d scale = _mm_set1_pd(32768.);
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i v[4];
+        for (unsigned i = 0; i < 4; i++)
+            v[i] = RoundS16_2_SSE2(_mm_mul_pd(_mm_loadu_pd(src + 2 * i), scale));
+        _mm_storeu_si128((__m128i *)dst,
+                         _mm_packs_epi32(_mm_unpacklo_epi64(v[0], v[1]),
+                                         _mm_unpacklo_epi64(v[2], v[3])));
+    }
+    Fl64toS16_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl64toFl32_SSE2(void *d, const void *s, size_t n)
+{
+    const double *src = s;
+    float *dst = d;
+    const __m128d one = _mm_set1_pd(1.);
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+        _mm_storeu_ps(dst, Fl64toFl32_4_SSE2(src, one));
+    Fl64toFl32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl64toS32_SSE2(void *d, const void *s, size_t n)
+{
+    const double *src = s;
+    int32_t *dst = d;
+    const __m128d scale = _mm_set1_pd(2147483648.);
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+        _mm_storeu_si128((__m128i *)dst,
+                         RoundS32_4_SSE2(Fl64toFl32_4_SSE2(src, scale)));
+    Fl64toS32_C(dst, src, n);
+}
+# define SSE2(f) f##_SSE2
+#else
+# define SSE2(f) NULL
+#endif
+
+#ifdef HAVE_FORMAT_AVX2
+/* Integer to float conversions of the decoders output, the common case */
+__attribute__ ((__target__ ("avx2")))
+static void S16toFl32_AVX2(void *d, const void *s, size_t n)
+{
+    const int16_t *src = s;
+    float *dst = d;
+    const __m256 scale = _mm256_set1_ps(1.f / 32768.f);
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m256i x = _mm256_cvtepi16_epi32(
+                            _mm_loadu_si128((const __m128i *)src));
+        _mm256_storeu_ps(dst, _mm256_mul_ps(_mm256_cvtepi32_ps(x), scale));
+    }
+    S16toFl32_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void S32toFl32_AVX2(void *d, const void *s, size_t n)
+{
+    const int32_t *src = s;
+    float *dst = d;
+    const __m256 scale = _mm256_set1_ps(1.f / 2147483648.f);
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m256 x = _mm256_cvtepi32_ps(
+                            _mm256_loadu_si256((const __m256i *)src));
+        _mm256_storeu_ps(dst, _mm256_mul_ps(x, scale));
+    }
+    S32toFl32_C(dst, src, n);
+}
+# define AVX2(f) f##_AVX2
+#else
+# define AVX2(f) NULL
+#endif
+
 
 /* */
 /* */
 static const struct {
     vlc_fourcc_t src;
     vlc_fourcc_t dst;
-    cvt_t convert;
+    pcm_cvt_t convert;
+    pcm_cvt_t convert_sse2;
+    pcm_cvt_t convert_avx2;
 } cvt_directs[] = {
-    { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16    },
-    { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32   },
-    { VLC_CODEC_U8,   VLC_CODEC_S32N, U8toS32    },
-    { VLC_CODEC_U8,   VLC_CODEC_FL64, U8toFl64   },
-
-    { VLC_CODEC_S16N, VLC_CODEC_U8,   S16toU8    },
-    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32  },
-    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32   },
-    { VLC_CODEC_S16N, VLC_CODEC_FL64, S16toFl64  },
-
-    { VLC_CODEC_FL32, VLC_CODEC_U8,   Fl32toU8   },
-    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16  },
-    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32  },
-    { VLC_CODEC_FL32, VLC_CODEC_FL64, Fl32toFl64 },
-
-    { VLC_CODEC_S32N, VLC_CODEC_U8,   S32toU8    },
-    { VLC_CODEC_S32N, VLC_CODEC_S16N, S32toS16   },
-    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32  },
-    { VLC_CODEC_S32N, VLC_CODEC_FL64, S32toFl64  },
-
-    { VLC_CODEC_FL64, VLC_CODEC_U8,   Fl64toU8   },
-    { VLC_CODEC_FL64, VLC_CODEC_S16N, Fl64toS16  },
-    { VLC_CODEC_FL64, VLC_CODEC_FL32, Fl64toFl32 },
-    { VLC_CODEC_FL64, VLC_CODEC_S32N, Fl64toS32  },
-
-    { 0, 0, NULL }
+    { VLC_CODEC_U8,   VLC_CODEC_S16N, U8toS16_C,    SSE2(U8toS16),    NULL },
+    { VLC_CODEC_U8,   VLC_CODEC_FL32, U8toFl32_C,   SSE2(U8toFl32),   NULL },
+    { VLC_CODEC_U8,   VLC_CODEC_S32N, U8toS32_C,    SSE2(U8toS32),    NULL },
+    { VLC_CODEC_U8,   VLC_CODEC_FL64, U8toFl64_C,   SSE2(U8toFl64),   NULL },
+
+    { VLC_CODEC_S16N, VLC_CODEC_U8,   S16toU8_C,    SSE2(S16toU8),    NULL },
+    { VLC_CODEC_S16N, VLC_CODEC_FL32, S16toFl32_C,  SSE2(S16toFl32),
+                                                    AVX2(S16toFl32) },
+    { VLC_CODEC_S16N, VLC_CODEC_S32N, S16toS32_C,   SSE2(S16toS32),   NULL },
+    { VLC_CODEC_S16N, VLC_CODEC_FL64, S16toFl64_C,  SSE2(S16toFl64),  NULL },
+
+    { VLC_CODEC_FL32, VLC_CODEC_U8,   Fl32toU8_C,   SSE2(Fl32toU8),   NULL },
+    { VLC_CODEC_FL32, VLC_CODEC_S16N, Fl32toS16_C,  SSE2(Fl32toS16),
+                                                    AVX2(Fl32toS16) },
+    { VLC_CODEC_FL32, VLC_CODEC_S32N, Fl32toS32_C,  SSE2(Fl32toS32),
+                                                    AVX2(Fl32toS32) },
+    { VLC_CODEC_FL32, VLC_CODEC_FL64, Fl32toFl64_C, SSE2(Fl32toFl64), NULL },
+
+    { VLC_CODEC_S32N, VLC_CODEC_U8,   S32toU8_C,    SSE2(S32toU8),    NULL },
+    { VLC_CODEC_S32N, VLC_CODEC_S16N, S32toS16_C,   SSE2(S32toS16),   NULL },
+    { VLC_CODEC_S32N, VLC_CODEC_FL32, S32toFl32_C,  SSE2(S32toFl32),
+                                                    AVX2(S32toFl32) },
+    { VLC_CODEC_S32N, VLC_CODEC_FL64, S32toFl64_C,  SSE2(S32toFl64),  NULL },
+
+    { VLC_CODEC_FL64, VLC_CODEC_U8,   Fl64toU8_C,   SSE2(Fl64toU8),   NULL },
+    { VLC_CODEC_FL64, VLC_CODEC_S16N, Fl64toS16_C,  SSE2(Fl64toS16),  NULL },
+    { VLC_CODEC_FL64, VLC_CODEC_FL32, Fl64toFl32_C, SSE2(Fl64toFl32), NULL },
+    { VLC_CODEC_FL64, VLC_CODEC_S32N, Fl64toS32_C,  SSE2(Fl64toS32),  NULL },
+
+    { 0, 0, NULL, NULL, NULL }
 };
 
-static cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst)
+static pcm_cvt_t FindConversion(vlc_fourcc_t src, vlc_fourcc_t dst)
 {
     for (int i = 0; cvt_directs[i].convert; i++) {
         if (cvt_directs[i].src == src &&
             cvt_directs[i].dst == dst)
+        {
+            if (cvt_directs[i].convert_avx2 != NULL && vlc_CPU_AVX2())
+                return cvt_directs[i].convert_avx2;
+            if (cvt_directs[i].convert_sse2 != NULL && vlc_CPU_SSE2())
+                return cvt_directs[i].convert_sse2;
             return cvt_directs[i].convert;
+        }
     }
     return NULL;
 }
@@ -0,0 +1,234 @@
+/*****************************************************************************
+ * format.h : PCM sample conversion from float
+ *****************************************************************************
+ * Copyright (C) 2002-2005 VLC authors and VideoLAN
+ * Copyright (C) 2010 Laurent Aimar
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_FORMAT_H
+#define VLC_AUDIO_FORMAT_H 1
+
+/* Sample kernels shared by the format converter and the channel mixers that
+ * can write their output straight to an integer format. They all convert n
+ * samples from src to dst, which may alias src when the output samples are
+ * no larger than the input ones. Every vectorized kernel gives the same
+ * output as its plain C counterpart, bit for bit. */
+
+#include <math.h>
+#include <vlc_cpu.h>
+
+typedef void (*pcm_cvt_t)(void *dst, const void *src, size_t n);
+
+static inline void Fl32toS16_C(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int16_t *dst = d;
+
+    while (n--) {
+        /* This is Walken's trick based on IEEE float format. */
+        union { float f; int32_t i; } u;
+        u.f = *src++ + 384.f;
+        if (u.i > 0x43c07fff)
+            *dst++ = 32767;
+        else if (u.i < 0x43bf8000)
+            *dst++ = -32768;
+        else
+            *dst++ = u.i - 0x43c00000;
+    }
+}
+
+static inline void Fl32toS32_C(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int32_t *dst = d;
+
+    while (n--)
+    {
+        float v = *(src++) * 2147483648.f;
+        if (v >= 2147483647.f)
+            *(dst++) = 2147483647;
+        else
+        if (v <= -2147483648.f)
+            *(dst++) = -2147483648;
+        else
+            *(dst++) = lroundf(v);
+    }
+}
+
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+
+#define HAVE_FORMAT_SSE2
+
+/* Adding 384 rounds to the nearest multiple of 2^-15 in the current rounding
+ * mode, as does the conversion of the scaled sample: clamping first keeps
+ * the saturation of the C version. */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i Fl32toS16_4_SSE2(__m128 v)
+{
+    v = _mm_mul_ps(v, _mm_set1_ps(32768.f));
+    v = _mm_min_ps(v, _mm_set1_ps(32767.f));
+    v = _mm_max_ps(v, _mm_set1_ps(-32768.f));
+    return _mm_cvtps_epi32(v);
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toS16_SSE2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int16_t *dst = d;
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m128i lo = Fl32toS16_4_SSE2(_mm_loadu_ps(src));
+        __m128i hi = Fl32toS16_4_SSE2(_mm_loadu_ps(src + 4));
+        _mm_storeu_si128((__m128i *)dst, _mm_packs_epi32(lo, hi));
+    }
+    Fl32toS16_C(dst, src, n);
+}
+
+/* Rounds samples already scaled by 2^31 half away from zero, as lroundf()
+ * does: the conversion truncates, then the exact remainder corrects the
+ * result by one either way. */
+__attribute__ ((__target__ ("sse2")))
+static inline __m128i RoundS32_4_SSE2(__m128 v)
+{
+    v = _mm_max_ps(v, _mm_set1_ps(-2147483648.f));
+
+    __m128i i = _mm_cvttps_epi32(v);
+    __m128 frac = _mm_sub_ps(v, _mm_cvtepi32_ps(i));
+    i = _mm_sub_epi32(i, _mm_castps_si128(
+                            _mm_cmpge_ps(frac, _mm_set1_ps(.5f))));
+    i = _mm_add_epi32(i, _mm_castps_si128(
+                            _mm_cmple_ps(frac, _mm_set1_ps(-.5f))));
+
+    __m128i over = _mm_castps_si128(
+                        _mm_cmpge_ps(v, _mm_set1_ps(2147483648.f)));
+    return _mm_or_si128(_mm_andnot_si128(over, i),
+                        _mm_and_si128(over, _mm_set1_epi32(INT32_MAX)));
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void Fl32toS32_SSE2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int32_t *dst = d;
+
+    for (; n >= 4; n -= 4, src += 4, dst += 4)
+    {
+        __m128 v = _mm_mul_ps(_mm_loadu_ps(src), _mm_set1_ps(2147483648.f));
+        _mm_storeu_si128((__m128i *)dst, RoundS32_4_SSE2(v));
+    }
+    Fl32toS32_C(dst, src, n);
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define HAVE_FORMAT_AVX2
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl32toS16_AVX2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int16_t *dst = d;
+    const __m256 scale = _mm256_set1_ps(32768.f);
+    const __m256 max = _mm256_set1_ps(32767.f);
+    const __m256 min = _mm256_set1_ps(-32768.f);
+
+    for (; n >= 16; n -= 16, src += 16, dst += 16)
+    {
+        __m256 a = _mm256_mul_ps(_mm256_loadu_ps(src), scale);
+        __m256 b = _mm256_mul_ps(_mm256_loadu_ps(src + 8), scale);
+        a = _mm256_max_ps(_mm256_min_ps(a, max), min);
+        b = _mm256_max_ps(_mm256_min_ps(b, max), min);
+
+        /* The pack works within each 128-bit lane */
+        __m256i p = _mm256_packs_epi32(_mm256_cvtps_epi32(a),
+                                       _mm256_cvtps_epi32(b));
+        p = _mm256_permute4x64_epi64(p, _MM_SHUFFLE(3, 1, 2, 0));
+        _mm256_storeu_si256((__m256i *)dst, p);
+    }
+    Fl32toS16_C(dst, src, n);
+}
+
+__attribute__ ((__target__ ("avx2")))
+static void Fl32toS32_AVX2(void *d, const void *s, size_t n)
+{
+    const float *src = s;
+    int32_t *dst = d;
+
+    for (; n >= 8; n -= 8, src += 8, dst += 8)
+    {
+        __m256 v = _mm256_mul_ps(_mm256_loadu_ps(src),
+                                 _mm256_set1_ps(2147483648.f));
+        v = _mm256_max_ps(v, _mm256_set1_ps(-2147483648.f));
+
+        __m256i i = _mm256_cvttps_epi32(v);
+        __m256 frac = _mm256_sub_ps(v, _mm256_cvtepi32_ps(i));
+        i = _mm256_sub_epi32(i, _mm256_castps_si256(
+                    _mm256_cmp_ps(frac, _mm256_set1_ps(.5f), _CMP_GE_OQ)));
+        i = _mm256_add_epi32(i, _mm256_castps_si256(
+                    _mm256_cmp_ps(frac, _mm256_set1_ps(-.5f), _CMP_LE_OQ)));
+
+        __m256i over = _mm256_castps_si256(
+            _mm256_cmp_ps(v, _mm256_set1_ps(2147483648.f), _CMP_GE_OQ));
+        i = _mm256_blendv_epi8(i, _mm256_set1_epi32(INT32_MAX), over);
+        _mm256_storeu_si256((__m256i *)dst, i);
+    }
+    Fl32toS32_C(dst, src, n);
+}
+#endif
+
+/**
+ * Returns the fastest kernel converting FL32 samples to S16N or S32N,
+ * or NULL for any other output format.
+ */
+static inline pcm_cvt_t Fl32toIntegerFind(vlc_fourcc_t dst)
+{
+    pcm_cvt_t cvt;
+
+    switch (dst)
+    {
+        case VLC_CODEC_S16N:
+            cvt = Fl32toS16_C;
+#ifdef HAVE_FORMAT_SSE2
+            if (vlc_CPU_SSE2())
+                cvt = Fl32toS16_SSE2;
+#endif
+#ifdef HAVE_FORMAT_AVX2
+            if (vlc_CPU_AVX2())
+                cvt = Fl32toS16_AVX2;
+#endif
+            return cvt;
+        case VLC_CODEC_S32N:
+            cvt = Fl32toS32_C;
+#ifdef HAVE_FORMAT_SSE2
+            if (vlc_CPU_SSE2())
+                cvt = Fl32toS32_SSE2;
+#endif
+#ifdef HAVE_FORMAT_AVX2
+            if (vlc_CPU_AVX2())
+                cvt = Fl32toS32_AVX2;
+#endif
+            return cvt;
+    }
+    return NULL;
+}
+
+#endif
@@ -0,0 +1,169 @@
+/*****************************************************************************
+ * convolution.c : convolution reverb audio filter
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_plugin.h>
+
+#include "convolver.h"
+
+#define FILE_TEXT N_("Impulse response")
+#define FILE_LONGTEXT N_( \
+    "WAVE file holding the impulse response of the room or device to " \
+    "simulate, either a single response applied to every channel, or " \
+    "one response per channel in the WAVE channel order.")
+
+#define GAIN_TEXT N_("Gain")
+#define GAIN_LONGTEXT N_("Gain applied to the impulse response.")
+
+#define BLOCK_TEXT N_("Block length")
+#define BLOCK_LONGTEXT N_( \
+    "Length of the partitions of the impulse response, in samples. " \
+    "This is the latency of the filter: shorter blocks use more CPU.")
+
+static const int block_values[] = { 64, 128, 256, 512, 1024, 2048 };
+static const char *const block_texts[] = {
+    "64", "128", "256", "512", "1024", "2048",
+};
+
+static int Open( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Convolution") )
+    set_description( N_("Convolution reverb") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_loadfile( "convolution-file", NULL, FILE_TEXT, FILE_LONGTEXT, false )
+    add_float( "convolution-gain", 1., GAIN_TEXT, GAIN_LONGTEXT, false )
+    add_integer( "convolution-block", 256, BLOCK_TEXT, BLOCK_LONGTEXT, true )
+        change_integer_list( block_values, block_texts )
+    set_capability( "audio filter", 0 )
+    set_callbacks( Open, Close )
+    add_shortcut( "convolution" )
+vlc_module_end ()
+
+static block_t *Process( filter_t *p_filter, block_t *p_block )
+{
+    convolver_t *p_conv = (convolver_t *)p_filter->p_sys;
+
+    /* The output is as long as the input, one block late */
+    convolver_Process( p_conv, (float *)p_block->p_buffer,
+                       (const float *)p_block->p_buffer,
+                       p_block->i_nb_samples );
+    return p_block;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    convolver_Reset( (convolver_t *)p_filter->p_sys );
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    audio_format_t *p_fmt = &p_filter->fmt_in.audio;
+
+    char *psz_path = var_InheritString( p_filter, "convolution-file" );
+    if( psz_path == NULL )
+    {
+        msg_Err( p_filter, "no impulse response file" );
+        return VLC_EGENERIC;
+    }
+
+    unsigned i_rate, i_ir_chans;
+    size_t i_frames;
+    float *p_ir = convolver_Load( p_filter, psz_path, &i_rate, &i_ir_chans,
+                                  &i_frames );
+    free( psz_path );
+    if( p_ir == NULL )
+        return VLC_EGENERIC;
+
+    /* One response per channel sets the channels up, the audio output
+     * remixes the input to them if needed */
+    uint8_t table[AOUT_CHAN_MAX];
+    if( i_ir_chans > 1 )
+    {
+        uint16_t i_layout = convolver_Layout( i_ir_chans, table );
+        if( i_layout == 0 )
+        {
+            msg_Err( p_filter, "unsupported %u channels impulse response",
+                     i_ir_chans );
+            free( p_ir );
+            return VLC_EGENERIC;
+        }
+        p_fmt->i_physical_channels = p_fmt->i_original_channels = i_layout;
+    }
+
+    /* Run at the rate of the response rather than resample it */
+    if( i_rate != p_fmt->i_rate )
+        msg_Dbg( p_filter, "converting %u Hz input to the %u Hz response",
+                 p_fmt->i_rate, i_rate );
+    p_fmt->i_rate = i_rate;
+    p_fmt->i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( p_fmt );
+    p_filter->fmt_out.audio = *p_fmt;
+
+    const unsigned i_chans = p_fmt->i_channels;
+    const float f_gain = var_InheritFloat( p_filter, "convolution-gain" );
+    convolver_t *p_conv = convolver_New( var_InheritInteger( p_filter,
+                                                 "convolution-block" ),
+                                         i_chans, i_chans, i_frames );
+    if( p_conv == NULL )
+    {
+        free( p_ir );
+        return VLC_EGENERIC;
+    }
+
+    for( unsigned i = 0; i < i_chans; i++ )
+    {
+        /* The response, and the channel it applies to */
+        const float *p = i_ir_chans > 1 ? &p_ir[i] : p_ir;
+        const unsigned c = i_ir_chans > 1 ? table[i] : i;
+
+        if( convolver_SetResponse( p_conv, c, c, p, i_frames, i_ir_chans,
+                                   f_gain ) )
+        {
+            convolver_Delete( p_conv );
+            free( p_ir );
+            return VLC_ENOMEM;
+        }
+    }
+    free( p_ir );
+
+    msg_Dbg( p_filter, "%zu samples response, %u channels", i_frames,
+             i_chans );
+    p_filter->p_sys = (void *)p_conv;
+    p_filter->pf_audio_filter = Process;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    convolver_Delete( (convolver_t *)p_filter->p_sys );
+}
@@ -0,0 +1,427 @@
+/*****************************************************************************
+ * convolver.c : uniformly partitioned FFT convolution engine
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Overlap-save convolution with a frequency-domain delay line: each impulse
+ * response is cut into partitions of one block, kept as the spectra of the
+ * partitions zero-padded to two blocks. Every block, each input channel gets
+ * one FFT of its last two blocks, stored in its delay line. Each output is
+ * then the sum of the products of the delayed input spectra with the
+ * matching partitions, and takes a single inverse FFT whatever the number of
+ * inputs and the length of the responses.
+ *
+ * The cost per frame thus grows with the number of partitions only through
+ * the complex multiply-accumulate of the spectra, which is kept in split
+ * real/imaginary arrays so that the compiler vectorizes it.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <errno.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_fft.h>
+#include <vlc_fs.h>
+
+#include "convolver.h"
+
+struct convolver
+{
+    unsigned block; /**< Block length (frames), half the FFT length */
+    unsigned inputs;
+    unsigned outputs;
+    unsigned parts; /**< Length of the delay lines (blocks) */
+    unsigned pos; /**< Delay line slot of the current block */
+    unsigned fill; /**< Frames of the current block */
+
+    vlc_fft_t *fft; /**< Transform of 2 x block samples */
+
+    float *time; /**< Last two blocks of each input (inputs x 2 x block) */
+    float *fdl; /**< Input spectra (inputs x parts x 2 x block) */
+    float *acc; /**< Output spectrum (2 x block) */
+    float *tmp; /**< Output samples (2 x block) */
+    float *out; /**< Output samples of the last block (outputs x block) */
+    float **resp; /**< Response spectra by path, or NULL (inputs x outputs) */
+    unsigned *resp_parts; /**< Partitions of each response */
+};
+
+/* acc += x * h */
+static void MultiplyAdd(float *restrict acc, const float *restrict x,
+                        const float *restrict h, unsigned n)
+{
+    float *restrict ar = acc, *restrict ai = acc + n;
+    const float *restrict xr = x, *restrict xi = x + n;
+    const float *restrict hr = h, *restrict hi = h + n;
+    /* The DC and Nyquist bins are real */
+    const float dc = ar[0] + xr[0] * hr[0], nyquist = ai[0] + xi[0] * hi[0];
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        ar[k] += xr[k] * hr[k] - xi[k] * hi[k];
+        ai[k] += xr[k] * hi[k] + xi[k] * hr[k];
+    }
+    ar[0] = dc;
+    ai[0] = nyquist;
+}
+
+/*****************************************************************************
+ * Engine
+ *****************************************************************************/
+convolver_t *convolver_New(unsigned block, unsigned inputs, unsigned outputs,
+                           size_t length)
+{
+    if (block < 4 || (block & (block - 1)) || inputs == 0 || outputs == 0)
+        return NULL;
+
+    convolver_t *c = calloc(1, sizeof (*c));
+    if (unlikely(c == NULL))
+        return NULL;
+
+    c->block = block;
+    c->inputs = inputs;
+    c->outputs = outputs;
+    c->parts = length > 0 ? (length + block - 1) / block : 1;
+
+    const size_t spec = 2 * block;
+    c->fft = vlc_fft_New(spec);
+    c->time = vlc_memalign(32, inputs * spec * sizeof (float));
+    c->fdl = vlc_memalign(32, (size_t)inputs * c->parts * spec
+                              * sizeof (float));
+    c->acc = vlc_memalign(32, spec * sizeof (float));
+    c->tmp = vlc_memalign(32, spec * sizeof (float));
+    c->out = vlc_memalign(32, outputs * block * sizeof (float));
+    c->resp = calloc(inputs * outputs, sizeof (*c->resp));
+    c->resp_parts = calloc(inputs * outputs, sizeof (*c->resp_parts));
+    if (unlikely(c->fft == NULL
+              || c->time == NULL || c->fdl == NULL || c->acc == NULL
+              || c->tmp == NULL || c->out == NULL || c->resp == NULL || c->resp_parts == NULL))
+    {
+        convolver_Delete(c);
+        return NULL;
+    }
+
+    convolver_Reset(c);
+    return c;
+}
+
+void convolver_Delete(convolver_t *c)
+{
+    if (c->resp != NULL)
+        for (unsigned i = 0; i < c->inputs * c->outputs; i++)
+            vlc_free(c->resp[i]);
+    free(c->resp_parts);
+    free(c->resp);
+    vlc_free(c->out);
+    vlc_free(c->tmp);
+    vlc_free(c->acc);
+    vlc_free(c->fdl);
+    vlc_free(c->time);
+    if (c->fft != NULL)
+        vlc_fft_Delete(c->fft);
+    free(c);
+}
+
+int convolver_SetResponse(convolver_t *c, unsigned input, unsigned output,
+                          const float *ir, size_t length, size_t stride,
+                          float gain)
+{
+    assert(input < c->inputs && output < c->outputs);
+
+    const unsigned n = c->block;
+    const unsigned parts = (length + n - 1) / n;
+    float **pp = &c->resp[input * c->outputs + output];
+
+    if (parts > c->parts)
+        return VLC_EGENERIC;
+
+    vlc_free(*pp);
+    *pp = NULL;
+    c->resp_parts[input * c->outputs + output] = 0;
+    if (parts == 0)
+        return VLC_SUCCESS;
+
+    float *h = vlc_memalign(32, parts * 2 * n * sizeof (float));
+    if (unlikely(h == NULL))
+        return VLC_ENOMEM;
+
+    /* Fold the scale of the inverse FFT into the response */
+    gain /= 2 * n;
+
+    for (unsigned p = 0; p < parts; p++)
+    {
+        float *x = c->acc;
+        size_t count = length - p * n;
+
+        if (count > n)
+            count = n;
+        for (size_t i = 0; i < count; i++)
+            x[i] = gain * ir[(p * n + i) * stride];
+        memset(x + count, 0, (2 * n - count) * sizeof (float));
+        vlc_fft_Forward(c->fft, h + p * 2 * n, x);
+    }
+
+    *pp = h;
+    c->resp_parts[input * c->outputs + output] = parts;
+    return VLC_SUCCESS;
+}
+
+void convolver_Reset(convolver_t *c)
+{
+    const size_t spec = 2 * c->block;
+
+    memset(c->time, 0, c->inputs * spec * sizeof (float));
+    memset(c->fdl, 0, (size_t)c->inputs * c->parts * spec * sizeof (float));
+    memset(c->out, 0, c->outputs * c->block * sizeof (float));
+    c->pos = 0;
+    c->fill = 0;
+}
+
+static void ProcessBlock(convolver_t *c)
+{
+    const unsigned n = c->block;
+    const size_t spec = 2 * n;
+
+    for (unsigned i = 0; i < c->inputs; i++)
+    {
+        float *time = c->time + i * spec;
+
+        vlc_fft_Forward(c->fft, c->fdl + (i * c->parts + c->pos) * spec,
+                        time);
+        memcpy(time, time + n, n * sizeof (float));
+    }
+
+    for (unsigned o = 0; o < c->outputs; o++)
+    {
+        memset(c->acc, 0, spec * sizeof (float));
+
+        for (unsigned i = 0; i < c->inputs; i++)
+        {
+            const float *h = c->resp[i * c->outputs + o];
+            const unsigned parts = c->resp_parts[i * c->outputs + o];
+            const float *fdl = c->fdl + i * c->parts * spec;
+
+            for (unsigned p = 0, slot = c->pos; p < parts; p++)
+            {
+                MultiplyAdd(c->acc, fdl + slot * spec, h + p * spec, n);
+                slot = (slot > 0 ? slot : c->parts) - 1;
+            }
+        }
+
+        /* Overlap-save: only the second half is free of circular aliasing */
+        vlc_fft_Inverse(c->fft, c->tmp, c->acc);
+        memcpy(c->out + o * n, c->tmp + n, n * sizeof (float));
+    }
+
+    c->pos = (c->pos + 1 < c->parts) ? c->pos + 1 : 0;
+}
+
+void convolver_Process(convolver_t *c, float *out, const float *in,
+                       size_t frames)
+{
+    const unsigned n = c->block;
+
+    while (frames > 0)
+    {
+        size_t count = n - c->fill;
+
+        if (count > frames)
+            count = frames;
+
+        for (size_t f = 0; f < count; f++)
+        {
+            const unsigned t = c->fill + f;
+
+            for (unsigned i = 0; i < c->inputs; i++)
+                c->time[i * 2 * n + n + t] = in[i];
+            for (unsigned o = 0; o < c->outputs; o++)
+                out[o] = c->out[o * n + t];
+            in += c->inputs;
+            out += c->outputs;
+        }
+
+        c->fill += count;
+        frames -= count;
+        if (c->fill == n)
+        {
+            ProcessBlock(c);
+            c->fill = 0;
+        }
+    }
+}
+
+/*****************************************************************************
+ * Impulse response files
+ *****************************************************************************/
+static uint32_t GetLE32(const uint8_t *p)
+{
+    return p[0] | (p[1] << 8) | (p[2] << 16) | ((uint32_t)p[3] << 24);
+}
+
+#undef convolver_Load
+float *convolver_Load(vlc_object_t *obj, const char *path, unsigned *rate,
+                      unsigned *channels, size_t *frames)
+{
+    FILE *stream = vlc_fopen(path, "rb");
+    if (stream == NULL)
+    {
+        msg_Err(obj, "cannot open impulse response %s: %s", path,
+                vlc_strerror_c(errno));
+        return NULL;
+    }
+
+    float *samples = NULL;
+    uint8_t hdr[12];
+    unsigned tag = 0, chans = 0, bits = 0;
+    uint32_t srate = 0;
+
+    if (fread(hdr, 1, 12, stream) != 12 || memcmp(hdr, "RIFF", 4)
+     || memcmp(hdr + 8, "WAVE", 4))
+        goto invalid;
+
+    while (fread(hdr, 1, 8, stream) == 8)
+    {
+        uint32_t size = GetLE32(hdr + 4);
+
+        if (!memcmp(hdr, "fmt ", 4))
+        {
+            uint8_t fmt[40];
+
+            if (size < 16 || size > sizeof (fmt)
+             || fread(fmt, 1, size, stream) != size)
+                goto invalid;
+            tag = fmt[0] | (fmt[1] << 8);
+            chans = fmt[2] | (fmt[3] << 8);
+            srate = GetLE32(fmt + 4);
+            bits = fmt[14] | (fmt[15] << 8);
+            if (tag == 0xFFFE && size >= 26) /* WAVE_FORMAT_EXTENSIBLE */
+                tag = fmt[24] | (fmt[25] << 8);
+            if (size & 1)
+                fseek(stream, 1, SEEK_CUR);
+            continue;
+        }
+
+        if (memcmp(hdr, "data", 4))
+        {
+            if (fseek(stream, size + (size & 1), SEEK_CUR))
+                goto invalid;
+            continue;
+        }
+
+        /* Data */
+        unsigned bytes = bits / 8;
+        if (chans == 0 || srate == 0
+         || !((tag == 1 && (bits == 16 || bits == 24 || bits == 32))
+           || (tag == 3 && bits == 32)))
+        {
+            msg_Err(obj, "unsupported impulse response format %u, "
+                    "%u bits", tag, bits);
+            goto error;
+        }
+
+        size_t count = size / (bytes * chans);
+        uint8_t *raw = malloc(count * bytes * chans);
+        samples = malloc(count * chans * sizeof (float));
+        if (unlikely(raw == NULL || samples == NULL)
+         || fread(raw, bytes * chans, count, stream) != count)
+        {
+            free(raw);
+            goto invalid;
+        }
+
+        for (size_t i = 0; i < count * chans; i++)
+        {
+            const uint8_t *p = raw + i * bytes;
+
+            if (tag == 3)
+            {
+                union { uint32_t u; float f; } v = { .u = GetLE32(p) };
+                samples[i] = v.f;
+            }
+            else if (bits == 16)
+                samples[i] = (int16_t)(p[0] | (p[1] << 8)) / 32768.f;
+            else if (bits == 24)
+                samples[i] = (int32_t)((p[0] << 8) | (p[1] << 16)
+                                       | ((uint32_t)p[2] << 24))
+                             / 2147483648.f;
+            else
+                samples[i] = (int32_t)GetLE32(p) / 2147483648.f;
+        }
+        free(raw);
+
+        fclose(stream);
+        *rate = srate;
+        *channels = chans;
+        *frames = count;
+        return samples;
+    }
+
+invalid:
+    msg_Err(obj, "invalid impulse response %s", path);
+error:
+    free(samples);
+    fclose(stream);
+    return NULL;
+}
+
+uint16_t convolver_Layout(unsigned channels, uint8_t *table)
+{
+    static const uint32_t wave_order[] = {
+        AOUT_CHAN_LEFT, AOUT_CHAN_RIGHT, AOUT_CHAN_CENTER, AOUT_CHAN_LFE,
+        AOUT_CHAN_REARLEFT, AOUT_CHAN_REARRIGHT, AOUT_CHAN_REARCENTER,
+        AOUT_CHAN_MIDDLELEFT, AOUT_CHAN_MIDDLERIGHT,
+    };
+    uint16_t layout;
+
+    switch (channels)
+    {
+        case 1: layout = AOUT_CHAN_CENTER; break;
+        case 2: layout = AOUT_CHANS_STEREO; break;
+        case 3: layout = AOUT_CHANS_3_0; break;
+        case 4: layout = AOUT_CHANS_4_0; break;
+        case 5: layout = AOUT_CHANS_5_0; break;
+        case 6: layout = AOUT_CHANS_5_1; break;
+        case 8: layout = AOUT_CHANS_7_1; break;
+        default: return 0;
+    }
+
+    unsigned i = 0;
+    for (size_t w = 0; w < ARRAY_SIZE(wave_order); w++)
+    {
+        if (!(layout & wave_order[w]))
+            continue;
+
+        /* Count the speakers coming first in the VLC order */
+        unsigned index = 0;
+        for (const uint32_t *v = pi_vlc_chan_order_wg4;
+             *v != wave_order[w]; v++)
+            if (layout & *v)
+                index++;
+        table[i++] = index;
+    }
+    assert(i == channels);
+    return layout;
+}
@@ -0,0 +1,77 @@
+/*****************************************************************************
+ * convolver.h : uniformly partitioned FFT convolution engine
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AUDIO_CONVOLVER_H
+#define VLC_AUDIO_CONVOLVER_H 1
+
+/**
+ * Mixes interleaved input channels into interleaved output channels, each
+ * output being the sum of the inputs convolved with one impulse response per
+ * (input, output) path. The output is delayed by one block.
+ */
+typedef struct convolver convolver_t;
+
+/**
+ * Creates a convolution engine.
+ * @param block partition length in frames, a power of two:
+ *              the latency of the engine
+ * @param length longest impulse response, in frames
+ */
+convolver_t *convolver_New(unsigned block, unsigned inputs, unsigned outputs,
+                           size_t length);
+void convolver_Delete(convolver_t *);
+
+/**
+ * Sets the impulse response from an input to an output.
+ * @param ir impulse response, length frames of stride samples
+ * @param gain factor applied to the impulse response
+ */
+int convolver_SetResponse(convolver_t *, unsigned input, unsigned output,
+                          const float *ir, size_t length, size_t stride,
+                          float gain);
+
+/**
+ * Convolves a buffer of frames. The output may alias the input if there are
+ * no more output channels than input channels.
+ */
+void convolver_Process(convolver_t *, float *out, const float *in,
+                       size_t frames);
+
+/**
+ * Discards the queued input and the tails of the responses.
+ */
+void convolver_Reset(convolver_t *);
+
+/**
+ * Loads an impulse response file (RIFF WAVE, integer or float samples).
+ * @return interleaved samples, to be freed with free(), or NULL on error
+ */
+float *convolver_Load(vlc_object_t *, const char *path, unsigned *rate,
+                      unsigned *channels, size_t *frames);
+#define convolver_Load(o, p, r, c, f) convolver_Load(VLC_OBJECT(o), p, r, c, f)
+
+/**
+ * Gets the default speaker layout of a WAVE file with the given number of
+ * channels, and the index of each of its channels in the VLC channel order.
+ * @return the speakers, or 0 if there is no default layout
+ */
+uint16_t convolver_Layout(unsigned channels, uint8_t *table);
+
+#endif
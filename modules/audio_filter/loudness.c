@@ -0,0 +1,675 @@
+/*****************************************************************************
+ * loudness.c : EBU R128 loudness meter and normalizer
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The loudness is measured as specified by ITU-R BS.1770-4 and EBU R128:
+ * the channels are K-weighted, and their weighted power is summed in steps
+ * of 100 ms. The momentary loudness is measured over 400 ms, the short-term
+ * loudness over 3 s. The integrated loudness and the loudness range are
+ * computed from histograms of the gated 400 ms blocks and 3 s windows, so
+ * that the memory and time needed do not grow with the length of the stream.
+ * The true peak is measured on a 4 times oversampled signal.
+ *
+ * The measurements are published as variables of the parent object, that is
+ * the audio output or the transcoding stream output, every 100 ms.
+ *
+ * The normalizer steers its gain towards the target loudness, and a
+ * look-ahead limiter keeps the true peak of the output under the ceiling.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_plugin.h>
+
+#define TARGET_TEXT N_("Target loudness")
+#define TARGET_LONGTEXT N_( \
+    "Integrated loudness of the output, in LUFS. EBU R128 recommends " \
+    "-23 LUFS for broadcasting.")
+
+#define CEILING_TEXT N_("True peak ceiling")
+#define CEILING_LONGTEXT N_( \
+    "Maximum true peak level of the output, in dBTP.")
+
+#define MAX_GAIN_TEXT N_("Maximum gain")
+#define MAX_GAIN_LONGTEXT N_( \
+    "Maximum amplification of quiet audio, in dB.")
+
+#define DYNAMIC_TEXT N_("Follow the short-term loudness")
+#define DYNAMIC_LONGTEXT N_( \
+    "Normalize the loudness of the last 3 seconds, rather than the " \
+    "integrated loudness. This evens out quiet and loud passages, at the " \
+    "expense of the dynamics.")
+
+#define NORMALIZE_TEXT N_("Normalize")
+#define NORMALIZE_LONGTEXT N_( \
+    "Normalize the loudness, rather than only measure it.")
+
+static int  Open( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Loudness") )
+    set_description( N_("EBU R128 loudness normalizer") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_AFILTER )
+    add_float_with_range( "loudness-target", -23., -70., 0.,
+                          TARGET_TEXT, TARGET_LONGTEXT, false )
+    add_float_with_range( "loudness-ceiling", -1., -20., 0.,
+                          CEILING_TEXT, CEILING_LONGTEXT, false )
+    add_float_with_range( "loudness-max-gain", 12., 0., 40.,
+                          MAX_GAIN_TEXT, MAX_GAIN_LONGTEXT, true )
+    add_bool( "loudness-dynamic", false, DYNAMIC_TEXT, DYNAMIC_LONGTEXT,
+              false )
+    add_bool( "loudness-normalize", true, NORMALIZE_TEXT, NORMALIZE_LONGTEXT,
+              true )
+    set_capability( "audio filter", 0 )
+    set_callbacks( Open, Close )
+    add_shortcut( "loudness", "r128" )
+vlc_module_end ()
+
+/* Measurement steps of 100 ms */
+#define MOMENTARY_STEPS 4
+#define SHORT_STEPS     30
+
+/* Histograms of the loudness from -70 to +10 LUFS, by 0.1 LU */
+#define HIST_MIN   (-70.)
+#define HIST_STEP  (.1)
+#define HIST_BINS  800
+
+/* True peak interpolation taps per phase */
+#define TP_TAPS    12
+
+/* Look-ahead of the limiter, release of the limiter and response time of the
+ * normalizer */
+#define LOOKAHEAD  .005
+#define RELEASE    .1
+#define RESPONSE   1.
+
+typedef struct
+{
+    double b0, b1, b2, a1, a2;
+} biquad_t;
+
+typedef struct
+{
+    uint64_t i_count;
+    double   f_energy;
+} loudness_bin_t;
+
+struct filter_sys_t
+{
+    unsigned i_channels;
+    float    weights[AOUT_CHAN_MAX];
+
+    /* K-weighting: a high shelf, and a high pass */
+    biquad_t shelf, highpass;
+    double  *p_state;           /**< 4 per channel */
+
+    /* Weighted energy of the last steps */
+    unsigned i_step_frames;
+    unsigned i_step_pos;
+    double   f_step;
+    double   steps[SHORT_STEPS];
+    uint64_t i_steps;
+
+    loudness_bin_t blocks[HIST_BINS];   /**< 400 ms gating blocks */
+    loudness_bin_t windows[HIST_BINS];  /**< 3 s windows */
+
+    /* True peak */
+    unsigned i_over;
+    float    taps[4][TP_TAPS];
+    float   *p_history;         /**< 2 * TP_TAPS per channel */
+    unsigned i_history;
+    float    f_peak;
+
+    float    f_momentary, f_short, f_integrated, f_range;
+
+    /* Normalizer */
+    bool     b_normalize;
+    bool     b_dynamic;
+    float    f_target;
+    float    f_max_gain;
+    float    f_gain;
+    float    f_gain_target;
+    float    f_gain_coef;
+
+    /* Look-ahead limiter: the minimum of the gains needed in the look-ahead
+     * window, released slowly, then averaged over the window */
+    float    f_ceiling;
+    unsigned i_look;
+    float   *p_delay;           /**< i_look - 1 frames */
+    unsigned i_delay;
+    float   *p_min_gain;        /**< i_look values of the minimum queue */
+    uint64_t *p_min_index;
+    unsigned i_min_head, i_min_count;
+    float   *p_box;             /**< i_look values of the average */
+    double   f_box_sum;
+    unsigned i_box;
+    float    f_hold;
+    float    f_release_coef;
+    uint64_t i_frame;
+
+    mtime_t  i_next_pts;
+};
+
+static const char *const ppsz_vars[] = {
+    "loudness-momentary", "loudness-short-term", "loudness-integrated",
+    "loudness-range", "loudness-true-peak", "loudness-gain",
+};
+
+/*****************************************************************************
+ * Meter
+ *****************************************************************************/
+static double Loudness( double f_energy )
+{
+    return -0.691 + 10. * log10( f_energy );
+}
+
+static unsigned Bin( double f_loudness )
+{
+    double f_bin = (f_loudness - HIST_MIN) / HIST_STEP;
+
+    if( f_bin < 0. )
+        return 0;
+    return __MIN( (unsigned)f_bin, HIST_BINS - 1 );
+}
+
+static void HistAdd( loudness_bin_t *p_hist, double f_energy )
+{
+    double f_loudness = Loudness( f_energy );
+
+    /* Absolute gate */
+    if( f_loudness < HIST_MIN )
+        return;
+    p_hist[Bin( f_loudness )].i_count++;
+    p_hist[Bin( f_loudness )].f_energy += f_energy;
+}
+
+/* Gets the first bin above the relative gate, and the count above it */
+static unsigned HistGate( const loudness_bin_t *p_hist, double f_gate,
+                          uint64_t *pi_count )
+{
+    uint64_t i_count = 0;
+    double f_energy = 0.;
+
+    for( unsigned i = 0; i < HIST_BINS; i++ )
+    {
+        i_count += p_hist[i].i_count;
+        f_energy += p_hist[i].f_energy;
+    }
+    *pi_count = 0;
+    if( i_count == 0 )
+        return HIST_BINS;
+
+    unsigned i_first = Bin( Loudness( f_energy / i_count ) + f_gate );
+    for( unsigned i = i_first; i < HIST_BINS; i++ )
+        *pi_count += p_hist[i].i_count;
+    return i_first;
+}
+
+static float Integrated( const loudness_bin_t *p_hist )
+{
+    uint64_t i_count;
+    unsigned i_first = HistGate( p_hist, -10., &i_count );
+    double f_energy = 0.;
+
+    if( i_count == 0 )
+        return -HUGE_VALF;
+    for( unsigned i = i_first; i < HIST_BINS; i++ )
+        f_energy += p_hist[i].f_energy;
+    return Loudness( f_energy / i_count );
+}
+
+static float Range( const loudness_bin_t *p_hist )
+{
+    uint64_t i_count;
+    unsigned i_first = HistGate( p_hist, -20., &i_count );
+
+    if( i_count == 0 )
+        return 0.f;
+
+    /* Distance between the 10th and the 95th percentiles */
+    uint64_t i_sum = 0;
+    unsigned i_low = HIST_BINS, i_high = HIST_BINS;
+    for( unsigned i = i_first; i < HIST_BINS && i_high == HIST_BINS; i++ )
+    {
+        i_sum += p_hist[i].i_count;
+        if( i_low == HIST_BINS && i_sum > i_count / 10 )
+            i_low = i;
+        if( i_sum > i_count * 95 / 100 )
+            i_high = i;
+    }
+    if( i_high == HIST_BINS )
+        i_high = HIST_BINS - 1;
+    return (i_high - i_low) * HIST_STEP;
+}
+
+static double StepsEnergy( const filter_sys_t *p_sys, unsigned i_count )
+{
+    double f_sum = 0.;
+
+    for( unsigned i = 0; i < i_count; i++ )
+        f_sum += p_sys->steps[(p_sys->i_steps - 1 - i) % SHORT_STEPS];
+    return f_sum / ((double)i_count * p_sys->i_step_frames);
+}
+
+static void Publish( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const float values[ARRAY_SIZE(ppsz_vars)] = {
+        p_sys->f_momentary, p_sys->f_short, p_sys->f_integrated,
+        p_sys->f_range, 20.f * log10f( p_sys->f_peak ),
+        20.f * log10f( p_sys->f_gain ),
+    };
+
+    for( size_t i = 0; i < ARRAY_SIZE(ppsz_vars); i++ )
+        var_SetFloat( p_filter->obj.parent, ppsz_vars[i], values[i] );
+}
+
+/* Ends a 100 ms step, updates the measures and the normalizer */
+static void Step( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->steps[p_sys->i_steps++ % SHORT_STEPS] = p_sys->f_step;
+    p_sys->f_step = 0.;
+
+    unsigned i_count = __MIN( p_sys->i_steps, MOMENTARY_STEPS );
+    double f_energy = StepsEnergy( p_sys, i_count );
+    p_sys->f_momentary = Loudness( f_energy );
+    if( i_count == MOMENTARY_STEPS )
+    {
+        HistAdd( p_sys->blocks, f_energy );
+        p_sys->f_integrated = Integrated( p_sys->blocks );
+    }
+
+    i_count = __MIN( p_sys->i_steps, SHORT_STEPS );
+    f_energy = StepsEnergy( p_sys, i_count );
+    p_sys->f_short = Loudness( f_energy );
+    if( i_count == SHORT_STEPS )
+    {
+        HistAdd( p_sys->windows, f_energy );
+        p_sys->f_range = Range( p_sys->windows );
+    }
+
+    if( p_sys->b_normalize )
+    {
+        float f_loudness = p_sys->b_dynamic ? p_sys->f_short
+                                            : p_sys->f_integrated;
+
+        /* Keep the gain through silences */
+        if( f_loudness >= HIST_MIN )
+        {
+            float f_db = __MIN( p_sys->f_target - f_loudness,
+                                p_sys->f_max_gain );
+            p_sys->f_gain_target = powf( 10.f, f_db / 20.f );
+        }
+    }
+    Publish( p_filter );
+}
+
+static double Biquad( const biquad_t *p_bq, double *z, double x )
+{
+    double y = p_bq->b0 * x + z[0];
+
+    z[0] = p_bq->b1 * x - p_bq->a1 * y + z[1];
+    z[1] = p_bq->b2 * x - p_bq->a2 * y;
+    return y;
+}
+
+/* Measures a frame, and returns its true peak */
+static float Measure( filter_t *p_filter, const float *p_frame )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_pos = p_sys->i_history;
+    double f_sum = 0.;
+    float f_peak = 0.f;
+
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+    {
+        double *z = &p_sys->p_state[4 * c];
+        double y = Biquad( &p_sys->highpass, z + 2,
+                           Biquad( &p_sys->shelf, z, p_frame[c] ) );
+
+        f_sum += p_sys->weights[c] * y * y;
+
+        /* The history is stored twice, so that the last taps are
+         * contiguous */
+        float *h = &p_sys->p_history[2 * TP_TAPS * c];
+        h[i_pos] = h[i_pos + TP_TAPS] = p_frame[c];
+        h += i_pos + 1;
+
+        f_peak = fmaxf( f_peak, fabsf( p_frame[c] ) );
+        for( unsigned p = 1; p < p_sys->i_over; p++ )
+        {
+            float f_value = 0.f;
+
+            for( unsigned j = 0; j < TP_TAPS; j++ )
+                f_value += p_sys->taps[p][j] * h[TP_TAPS - 1 - j];
+            f_peak = fmaxf( f_peak, fabsf( f_value ) );
+        }
+    }
+    p_sys->i_history = (i_pos + 1) % TP_TAPS;
+    p_sys->f_peak = fmaxf( p_sys->f_peak, f_peak );
+
+    p_sys->f_step += f_sum;
+    if( ++p_sys->i_step_pos == p_sys->i_step_frames )
+    {
+        p_sys->i_step_pos = 0;
+        Step( p_filter );
+    }
+    return f_peak;
+}
+
+/*****************************************************************************
+ * Normalizer and limiter
+ *****************************************************************************/
+static void Limit( filter_sys_t *p_sys, float *p_frame, float f_peak )
+{
+    const unsigned i_look = p_sys->i_look;
+    const uint64_t i_frame = p_sys->i_frame++;
+
+    p_sys->f_gain += (p_sys->f_gain_target - p_sys->f_gain)
+                   * p_sys->f_gain_coef;
+
+    /* Gain needed by this frame, which affects the interpolated peaks of the
+     * TP_TAPS frames before it: the look-ahead covers them */
+    float f_needed = 1.f;
+    if( f_peak * p_sys->f_gain > p_sys->f_ceiling )
+        f_needed = p_sys->f_ceiling / (f_peak * p_sys->f_gain);
+
+    /* Minimum over the look-ahead window, in a monotonic queue */
+    if( p_sys->i_min_count > 0
+     && p_sys->p_min_index[p_sys->i_min_head] + i_look <= i_frame )
+    {
+        p_sys->i_min_head = (p_sys->i_min_head + 1) % i_look;
+        p_sys->i_min_count--;
+    }
+    while( p_sys->i_min_count > 0 )
+    {
+        unsigned i_back = (p_sys->i_min_head + p_sys->i_min_count - 1)
+                        % i_look;
+        if( p_sys->p_min_gain[i_back] < f_needed )
+            break;
+        p_sys->i_min_count--;
+    }
+    unsigned i_back = (p_sys->i_min_head + p_sys->i_min_count++) % i_look;
+    p_sys->p_min_gain[i_back] = f_needed;
+    p_sys->p_min_index[i_back] = i_frame;
+    float f_min = p_sys->p_min_gain[p_sys->i_min_head];
+
+    /* Instant attack, smooth release */
+    if( f_min < p_sys->f_hold )
+        p_sys->f_hold = f_min;
+    else
+        p_sys->f_hold += (f_min - p_sys->f_hold) * p_sys->f_release_coef;
+
+    /* The average over the window cannot be more than the gain needed by
+     * the oldest frame, which is the one going out */
+    p_sys->f_box_sum += p_sys->f_hold - p_sys->p_box[p_sys->i_box];
+    p_sys->p_box[p_sys->i_box] = p_sys->f_hold;
+    p_sys->i_box = (p_sys->i_box + 1) % i_look;
+    const float f_gain = p_sys->f_box_sum / i_look;
+
+    float *p_delayed = &p_sys->p_delay[p_sys->i_delay * p_sys->i_channels];
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+    {
+        float f_in = p_frame[c] * p_sys->f_gain;
+
+        p_frame[c] = p_delayed[c] * f_gain;
+        p_delayed[c] = f_in;
+    }
+    p_sys->i_delay = (p_sys->i_delay + 1) % (i_look - 1);
+}
+
+static block_t *Process( filter_t *p_filter, block_t *p_block )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    float *p_frame = (float *)p_block->p_buffer;
+
+    for( unsigned i = 0; i < p_block->i_nb_samples; i++ )
+    {
+        float f_peak = Measure( p_filter, p_frame );
+
+        if( p_sys->b_normalize )
+            Limit( p_sys, p_frame, f_peak );
+        p_frame += p_sys->i_channels;
+    }
+    p_sys->i_next_pts = p_block->i_pts + p_block->i_length;
+    return p_block;
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( !p_sys->b_normalize || p_sys->i_frame == 0 )
+        return NULL;
+
+    /* Push the delayed frames out */
+    const unsigned i_frames = p_sys->i_look - 1;
+    block_t *p_block = block_Alloc( i_frames * p_sys->i_channels
+                                    * sizeof (float) );
+    if( unlikely(p_block == NULL) )
+        return NULL;
+
+    float *p_frame = (float *)p_block->p_buffer;
+    memset( p_frame, 0, p_block->i_buffer );
+    for( unsigned i = 0; i < i_frames; i++ )
+    {
+        Limit( p_sys, p_frame, 0.f );
+        p_frame += p_sys->i_channels;
+    }
+    p_block->i_nb_samples = i_frames;
+    p_block->i_pts = p_block->i_dts = p_sys->i_next_pts;
+    p_block->i_length = CLOCK_FREQ * i_frames
+                      / p_filter->fmt_in.audio.i_rate;
+    return p_block;
+}
+
+static void Reset( filter_sys_t *p_sys )
+{
+    memset( p_sys->p_delay, 0,
+            (p_sys->i_look - 1) * p_sys->i_channels * sizeof (float) );
+    p_sys->i_delay = 0;
+    for( unsigned i = 0; i < p_sys->i_look; i++ )
+        p_sys->p_box[i] = 1.f;
+    p_sys->f_box_sum = p_sys->i_look;
+    p_sys->i_box = 0;
+    p_sys->i_min_head = p_sys->i_min_count = 0;
+    p_sys->f_hold = 1.f;
+    p_sys->i_frame = 0;
+}
+
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_normalize )
+        Reset( p_sys );
+}
+
+/*****************************************************************************
+ * Open
+ *****************************************************************************/
+static void KWeighting( filter_sys_t *p_sys, unsigned i_rate )
+{
+    /* Coefficients of BS.1770 for 48 kHz, generalized to any rate */
+    double K = tan( M_PI * 1681.974450955533 / i_rate );
+    double Q = 0.7071752369554196;
+    double Vh = pow( 10., 3.999843853973347 / 20. );
+    double Vb = pow( Vh, 0.4996667741545416 );
+    double a0 = 1. + K / Q + K * K;
+
+    p_sys->shelf.b0 = (Vh + Vb * K / Q + K * K) / a0;
+    p_sys->shelf.b1 = 2. * (K * K - Vh) / a0;
+    p_sys->shelf.b2 = (Vh - Vb * K / Q + K * K) / a0;
+    p_sys->shelf.a1 = 2. * (K * K - 1.) / a0;
+    p_sys->shelf.a2 = (1. - K / Q + K * K) / a0;
+
+    K = tan( M_PI * 38.13547087602444 / i_rate );
+    Q = 0.5003270373238773;
+    a0 = 1. + K / Q + K * K;
+
+    p_sys->highpass.b0 = 1.;
+    p_sys->highpass.b1 = -2.;
+    p_sys->highpass.b2 = 1.;
+    p_sys->highpass.a1 = 2. * (K * K - 1.) / a0;
+    p_sys->highpass.a2 = (1. - K / Q + K * K) / a0;
+}
+
+static void Oversampler( filter_sys_t *p_sys, unsigned i_rate )
+{
+    /* 4 times oversampling up to 96 kHz, as BS.1770 requires, less above */
+    p_sys->i_over = i_rate < 96000 ? 4 : i_rate < 192000 ? 2 : 1;
+
+    /* Hann windowed sinc, each phase normalized to unit gain. The phase 0 is
+     * the input itself, delayed by TP_TAPS / 2 frames. */
+    const unsigned n = p_sys->i_over;
+    const double f_center = TP_TAPS * n / 2;
+    for( unsigned p = 1; p < n; p++ )
+    {
+        double f_sum = 0.;
+
+        for( unsigned j = 0; j < TP_TAPS; j++ )
+        {
+            double t = (p + n * j - f_center) / n;
+            double w = .5 + .5 * cos( M_PI * (p + n * j - f_center)
+                                      / f_center );
+
+            p_sys->taps[p][j] = w * sin( M_PI * t ) / (M_PI * t);
+            f_sum += p_sys->taps[p][j];
+        }
+        for( unsigned j = 0; j < TP_TAPS; j++ )
+            p_sys->taps[p][j] /= f_sum;
+    }
+}
+
+static void Weights( filter_sys_t *p_sys, uint16_t i_physical_channels )
+{
+    unsigned i = 0;
+
+    for( const uint32_t *p = pi_vlc_chan_order_wg4; *p != 0; p++ )
+    {
+        if( !(i_physical_channels & *p) )
+            continue;
+        if( *p == AOUT_CHAN_LFE )
+            p_sys->weights[i++] = 0.f;
+        else if( *p & (AOUT_CHANS_STEREO | AOUT_CHAN_CENTER) )
+            p_sys->weights[i++] = 1.f;
+        else
+            p_sys->weights[i++] = 1.41f;
+    }
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    audio_format_t *p_fmt = &p_filter->fmt_in.audio;
+
+    p_fmt->i_format = VLC_CODEC_FL32;
+    aout_FormatPrepare( p_fmt );
+    p_filter->fmt_out.audio = *p_fmt;
+
+    const unsigned i_channels = p_fmt->i_channels;
+    const unsigned i_rate = p_fmt->i_rate;
+    if( i_channels == 0 || i_channels > AOUT_CHAN_MAX || i_rate < 8000 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = calloc( 1, sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->i_channels = i_channels;
+    p_sys->i_step_frames = (i_rate + 5) / 10;
+    p_sys->i_look = lround( LOOKAHEAD * i_rate );
+    p_sys->p_state = calloc( 4 * i_channels, sizeof (double) );
+    p_sys->p_history = calloc( 2 * TP_TAPS * i_channels, sizeof (float) );
+    p_sys->p_delay = malloc( (p_sys->i_look - 1) * i_channels
+                             * sizeof (float) );
+    p_sys->p_min_gain = malloc( p_sys->i_look * sizeof (float) );
+    p_sys->p_min_index = malloc( p_sys->i_look * sizeof (uint64_t) );
+    p_sys->p_box = malloc( p_sys->i_look * sizeof (float) );
+    if( unlikely(p_sys->p_state == NULL || p_sys->p_history == NULL
+              || p_sys->p_delay == NULL || p_sys->p_min_gain == NULL
+              || p_sys->p_min_index == NULL || p_sys->p_box == NULL) )
+    {
+        free( p_sys->p_box );
+        free( p_sys->p_min_index );
+        free( p_sys->p_min_gain );
+        free( p_sys->p_delay );
+        free( p_sys->p_history );
+        free( p_sys->p_state );
+        free( p_sys );
+        return VLC_ENOMEM;
+    }
+
+    Weights( p_sys, p_fmt->i_physical_channels );
+    KWeighting( p_sys, i_rate );
+    Oversampler( p_sys, i_rate );
+    p_sys->f_momentary = p_sys->f_short = p_sys->f_integrated = -HUGE_VALF;
+
+    p_sys->b_normalize = var_InheritBool( p_filter, "loudness-normalize" );
+    p_sys->b_dynamic = var_InheritBool( p_filter, "loudness-dynamic" );
+    p_sys->f_target = var_InheritFloat( p_filter, "loudness-target" );
+    p_sys->f_max_gain = var_InheritFloat( p_filter, "loudness-max-gain" );
+    p_sys->f_ceiling = powf( 10.f, var_InheritFloat( p_filter,
+                                               "loudness-ceiling" ) / 20.f );
+    p_sys->f_gain = p_sys->f_gain_target = 1.f;
+    p_sys->f_gain_coef = 1. - exp( -1. / (RESPONSE * i_rate) );
+    p_sys->f_release_coef = 1. - exp( -1. / (RELEASE * i_rate) );
+    Reset( p_sys );
+
+    /* The variables are left on the parent after the filter is gone, so that
+     * the measures of a whole stream can be read once it has ended */
+    for( size_t i = 0; i < ARRAY_SIZE(ppsz_vars); i++ )
+        var_Create( p_filter->obj.parent, ppsz_vars[i], VLC_VAR_FLOAT );
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_audio_filter = Process;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    msg_Dbg( p_filter, "integrated loudness %.1f LUFS, loudness range "
+             "%.1f LU, true peak %.1f dBTP", p_sys->f_integrated,
+             p_sys->f_range, 20.f * log10f( p_sys->f_peak ) );
+
+    free( p_sys->p_box );
+    free( p_sys->p_min_index );
+    free( p_sys->p_min_gain );
+    free( p_sys->p_delay );
+    free( p_sys->p_history );
+    free( p_sys->p_state );
+    free( p_sys );
+}
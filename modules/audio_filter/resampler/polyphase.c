@@ -0,0 +1,784 @@
+/*****************************************************************************
+ * polyphase.c : polyphase windowed-sinc audio resampler
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Each output sample is the dot product of the input history with one phase
+ * of a Kaiser-windowed sinc filter bank. When the input/output ratio is a
+ * fraction L/M with a small enough L, the bank holds exactly the L phases
+ * needed and no interpolation is done. Otherwise, including while the audio
+ * output corrects the clock drift with small input rate adjustments, output
+ * samples are linearly interpolated between the two nearest phases of a
+ * finer bank. The exact bank is used again once the rate is back to nominal
+ * and the position falls close enough to one of its phases.
+ *
+ * Input samples are kept deinterleaved, so that the dot products run over
+ * contiguous samples with SSE2, AVX2 or NEON.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_plugin.h>
+
+#define QUALITY_TEXT N_("Resampling quality")
+#define QUALITY_LONGTEXT N_( \
+    "Resampling quality (0 = worst and fastest, 3 = best and slowest).")
+
+static int Open( vlc_object_t * );
+static int OpenResampler( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_shortname( N_("Polyphase resampler") )
+    set_description( N_("Polyphase windowed-sinc resampler") )
+    set_category( CAT_AUDIO )
+    set_subcategory( SUBCAT_AUDIO_RESAMPLER )
+    add_integer( "polyphase-resampler-quality", 2,
+                 QUALITY_TEXT, QUALITY_LONGTEXT, true )
+        change_integer_range( 0, 3 )
+    set_capability( "audio converter", 60 )
+    set_callbacks( Open, Close )
+
+    add_submodule ()
+    set_capability( "audio resampler", 60 )
+    set_callbacks( OpenResampler, Close )
+    add_shortcut( "polyphase" )
+vlc_module_end ()
+
+/** Filter designs, by quality */
+static const struct
+{
+    unsigned i_taps;   /**< filter length when upsampling */
+    float    f_beta;   /**< Kaiser window parameter */
+    unsigned i_phases; /**< phases of the interpolated bank */
+} qualities[] = {
+    {  16,  5.f, 128 },
+    {  32,  7.f, 256 },
+    {  64,  9.f, 256 },
+    { 128, 11.f, 512 },
+};
+
+/** Largest number of phases of an exact bank */
+#define MAX_EXACT_PHASES 512
+/** Largest filter length */
+#define MAX_TAPS 1024
+/** Relative ratio change triggering a new interpolated bank design */
+#define BANK_TOLERANCE .01f
+/** Largest position change when switching back to the exact bank, in
+ * 1/2^32 of an input sample (1/512 sample) */
+#define EXACT_TOLERANCE (UINT32_C(1) << 23)
+
+typedef float (*dot_t)( const float *, const float *, unsigned );
+typedef float (*dot_interp_t)( const float *, const float *, const float *,
+                               float, unsigned );
+
+/** Filter bank */
+typedef struct
+{
+    float   *p_coefs; /**< (i_phases + 1) phases of i_taps coefficients */
+    unsigned i_phases;
+    float    f_scale; /**< cut-off frequency scale of the design */
+} bank_t;
+
+struct filter_sys_t
+{
+    unsigned i_channels;
+    unsigned i_taps;     /**< filter length, a multiple of 8 */
+    float    f_beta;
+    float    f_cutoff;   /**< cut-off frequency relative to Nyquist */
+    unsigned i_interp_phases;
+
+    unsigned i_rate;     /**< nominal input rate */
+    unsigned i_L, i_M;   /**< nominal ratio, i_L = 0 if not exact */
+    bank_t   exact;      /**< bank for the nominal ratio, if exact */
+    bank_t   interp;     /**< bank for other ratios, built on demand */
+
+    /* Deinterleaved input history */
+    float   *p_hist;     /**< i_channels buffers of i_hist_size samples */
+    size_t   i_hist_size;
+    size_t   i_hist_len; /**< valid samples per channel */
+
+    /* Position of the next output sample in the history, minus the filter
+     * delay. The fraction is either a phase of the exact bank, or a 0.32
+     * fixed point value for the interpolated bank. */
+    size_t   i_pos;
+    uint32_t i_frac;
+    bool     b_exact;
+
+    mtime_t  i_next_pts;
+
+    dot_t        pf_dot;
+    dot_interp_t pf_dot_interp;
+};
+
+/*****************************************************************************
+ * Dot product kernels
+ *
+ * n is a multiple of 8 and h is 32-bytes aligned.
+ *****************************************************************************/
+static float DotC( const float *x, const float *h, unsigned n )
+{
+    float a0 = 0.f, a1 = 0.f, a2 = 0.f, a3 = 0.f;
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        a0 += x[i] * h[i];
+        a1 += x[i + 1] * h[i + 1];
+        a2 += x[i + 2] * h[i + 2];
+        a3 += x[i + 3] * h[i + 3];
+    }
+    return (a0 + a1) + (a2 + a3);
+}
+
+static float DotInterpC( const float *x, const float *h0, const float *h1,
+                         float mu, unsigned n )
+{
+    float a0 = 0.f, a1 = 0.f, b0 = 0.f, b1 = 0.f;
+
+    for( unsigned i = 0; i < n; i += 2 )
+    {
+        a0 += x[i] * h0[i];
+        a1 += x[i + 1] * h0[i + 1];
+        b0 += x[i] * h1[i];
+        b1 += x[i + 1] * h1[i + 1];
+    }
+
+    const float a = a0 + a1, b = b0 + b1;
+    return a + mu * (b - a);
+}
+
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+
+#define HAVE_POLYPHASE_SSE2
+
+__attribute__ ((__target__ ("sse2")))
+static inline float HorizontalSumSSE2( __m128 v )
+{
+    v = _mm_add_ps( v, _mm_movehl_ps( v, v ) );
+    v = _mm_add_ss( v, _mm_shuffle_ps( v, v, 1 ) );
+    return _mm_cvtss_f32( v );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static float DotSSE2( const float *x, const float *h, unsigned n )
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        a0 = _mm_add_ps( a0, _mm_mul_ps( _mm_loadu_ps( &x[i] ),
+                                         _mm_load_ps( &h[i] ) ) );
+        a1 = _mm_add_ps( a1, _mm_mul_ps( _mm_loadu_ps( &x[i + 4] ),
+                                         _mm_load_ps( &h[i + 4] ) ) );
+    }
+    return HorizontalSumSSE2( _mm_add_ps( a0, a1 ) );
+}
+
+__attribute__ ((__target__ ("sse2")))
+static float DotInterpSSE2( const float *x, const float *h0, const float *h1,
+                            float mu, unsigned n )
+{
+    __m128 a = _mm_setzero_ps(), b = _mm_setzero_ps();
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        const __m128 v = _mm_loadu_ps( &x[i] );
+
+        a = _mm_add_ps( a, _mm_mul_ps( v, _mm_load_ps( &h0[i] ) ) );
+        b = _mm_add_ps( b, _mm_mul_ps( v, _mm_load_ps( &h1[i] ) ) );
+    }
+    /* a + mu * (b - a) */
+    a = _mm_add_ps( a, _mm_mul_ps( _mm_set1_ps( mu ), _mm_sub_ps( b, a ) ) );
+    return HorizontalSumSSE2( a );
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define HAVE_POLYPHASE_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static inline float HorizontalSumAVX2( __m256 v )
+{
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( v ),
+                           _mm256_extractf128_ps( v, 1 ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+    return _mm_cvtss_f32( s );
+}
+
+VLC_TARGET
+static float DotAVX2( const float *x, const float *h, unsigned n )
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        a0 = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_loadu_ps( &x[i] ),
+                                               _mm256_load_ps( &h[i] ) ) );
+        a1 = _mm256_add_ps( a1, _mm256_mul_ps( _mm256_loadu_ps( &x[i + 8] ),
+                                               _mm256_load_ps( &h[i + 8] ) ) );
+    }
+    if( i < n )
+        a0 = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_loadu_ps( &x[i] ),
+                                               _mm256_load_ps( &h[i] ) ) );
+    return HorizontalSumAVX2( _mm256_add_ps( a0, a1 ) );
+}
+
+VLC_TARGET
+static float DotInterpAVX2( const float *x, const float *h0, const float *h1,
+                            float mu, unsigned n )
+{
+    __m256 a = _mm256_setzero_ps(), b = _mm256_setzero_ps();
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        const __m256 v = _mm256_loadu_ps( &x[i] );
+
+        a = _mm256_add_ps( a, _mm256_mul_ps( v, _mm256_load_ps( &h0[i] ) ) );
+        b = _mm256_add_ps( b, _mm256_mul_ps( v, _mm256_load_ps( &h1[i] ) ) );
+    }
+    a = _mm256_add_ps( a, _mm256_mul_ps( _mm256_set1_ps( mu ),
+                                         _mm256_sub_ps( b, a ) ) );
+    return HorizontalSumAVX2( a );
+}
+#undef VLC_TARGET
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#define HAVE_POLYPHASE_NEON
+
+static inline float HorizontalSumNEON( float32x4_t v )
+{
+    float32x2_t s = vadd_f32( vget_low_f32( v ), vget_high_f32( v ) );
+    return vget_lane_f32( vpadd_f32( s, s ), 0 );
+}
+
+static float DotNEON( const float *x, const float *h, unsigned n )
+{
+    float32x4_t a0 = vdupq_n_f32( 0.f ), a1 = vdupq_n_f32( 0.f );
+
+    for( unsigned i = 0; i < n; i += 8 )
+    {
+        a0 = vmlaq_f32( a0, vld1q_f32( &x[i] ), vld1q_f32( &h[i] ) );
+        a1 = vmlaq_f32( a1, vld1q_f32( &x[i + 4] ), vld1q_f32( &h[i + 4] ) );
+    }
+    return HorizontalSumNEON( vaddq_f32( a0, a1 ) );
+}
+
+static float DotInterpNEON( const float *x, const float *h0, const float *h1,
+                            float mu, unsigned n )
+{
+    float32x4_t a = vdupq_n_f32( 0.f ), b = vdupq_n_f32( 0.f );
+
+    for( unsigned i = 0; i < n; i += 4 )
+    {
+        const float32x4_t v = vld1q_f32( &x[i] );
+
+        a = vmlaq_f32( a, v, vld1q_f32( &h0[i] ) );
+        b = vmlaq_f32( b, v, vld1q_f32( &h1[i] ) );
+    }
+    a = vmlaq_n_f32( a, vsubq_f32( b, a ), mu );
+    return HorizontalSumNEON( a );
+}
+#endif
+
+/*****************************************************************************
+ * Filter bank design
+ *****************************************************************************/
+
+/** Zeroth order modified Bessel function of the first kind */
+static double BesselI0( double x )
+{
+    double sum = 1., term = 1.;
+
+    for( unsigned k = 1; k < 64 && term > sum * 1e-12; k++ )
+    {
+        term *= (x / (2. * k)) * (x / (2. * k));
+        sum += term;
+    }
+    return sum;
+}
+
+/**
+ * Computes a filter bank of i_phases + 1 phases. Phase p holds the
+ * coefficients for an output sample p / i_phases input samples after the
+ * center of the filter; the extra phase is the first one shifted by one
+ * sample, for interpolation.
+ */
+static int BankInit( filter_sys_t *p_sys, bank_t *p_bank, unsigned i_phases,
+                     float f_scale )
+{
+    const unsigned i_taps = p_sys->i_taps;
+    const double half = i_taps / 2.;
+    const double cutoff = p_sys->f_cutoff * f_scale;
+    const double i0_beta = BesselI0( p_sys->f_beta );
+    float *p_coefs = vlc_memalign( 32, sizeof (float) * (i_phases + 1)
+                                       * i_taps );
+    if( unlikely(p_coefs == NULL) )
+        return VLC_ENOMEM;
+
+    for( unsigned p = 0; p <= i_phases; p++ )
+    {
+        float *h = &p_coefs[p * i_taps];
+        double sum = 0.;
+
+        for( unsigned k = 0; k < i_taps; k++ )
+        {
+            /* Distance from the output sample, in input samples */
+            const double d = (double)k - (half - 1.) - (double)p / i_phases;
+            const double r = d / half;
+            double v = 0.;
+
+            if( r > -1. && r < 1. )
+            {
+                const double t = M_PI * cutoff * d;
+                v = (t != 0. ? sin( t ) / t : 1.)
+                  * BesselI0( p_sys->f_beta * sqrt( 1. - r * r ) ) / i0_beta;
+            }
+            h[k] = v;
+            sum += v;
+        }
+        /* Normalize the DC gain of every phase */
+        for( unsigned k = 0; k < i_taps; k++ )
+            h[k] /= sum;
+    }
+
+    vlc_free( p_bank->p_coefs );
+    p_bank->p_coefs = p_coefs;
+    p_bank->i_phases = i_phases;
+    p_bank->f_scale = f_scale;
+    return VLC_SUCCESS;
+}
+
+static void BankClean( bank_t *p_bank )
+{
+    vlc_free( p_bank->p_coefs );
+    p_bank->p_coefs = NULL;
+}
+
+/*****************************************************************************
+ * Resampling
+ *****************************************************************************/
+
+/** Resets the history, aligning the first output sample with the next input
+ * sample. */
+static void Flush( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    p_sys->i_hist_len = p_sys->i_taps / 2 - 1;
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+        memset( &p_sys->p_hist[c * p_sys->i_hist_size], 0,
+                sizeof (float) * p_sys->i_hist_len );
+    p_sys->i_pos = 0;
+    p_sys->i_frac = 0;
+    p_sys->i_next_pts = VLC_TS_INVALID;
+}
+
+/** Makes room for i_count more samples per channel in the history */
+static int HistoryReserve( filter_sys_t *p_sys, size_t i_count )
+{
+    const size_t i_len = p_sys->i_hist_len;
+
+    if( i_len + i_count <= p_sys->i_hist_size )
+        return VLC_SUCCESS;
+
+    size_t i_size = (i_len + i_count) * 2;
+    if( unlikely(i_size > SIZE_MAX / sizeof (float) / p_sys->i_channels) )
+        return VLC_ENOMEM;
+
+    float *p_hist = malloc( sizeof (float) * i_size * p_sys->i_channels );
+    if( unlikely(p_hist == NULL) )
+        return VLC_ENOMEM;
+
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+        memcpy( &p_hist[c * i_size], &p_sys->p_hist[c * p_sys->i_hist_size],
+                sizeof (float) * i_len );
+    free( p_sys->p_hist );
+    p_sys->p_hist = p_hist;
+    p_sys->i_hist_size = i_size;
+    return VLC_SUCCESS;
+}
+
+/** Tells whether the interpolated position is close enough to a phase of the
+ * exact bank to switch to it without an audible jump. */
+static bool NearExactPhase( const filter_sys_t *p_sys )
+{
+    const uint32_t i_rem = (uint64_t)p_sys->i_frac * p_sys->i_L;
+
+    return __MIN(i_rem, UINT32_MAX - i_rem)
+        <= (uint64_t)EXACT_TOLERANCE * p_sys->i_L;
+}
+
+/** Switches the position to the exact or interpolated representation */
+static void SetExact( filter_sys_t *p_sys, bool b_exact )
+{
+    if( b_exact == p_sys->b_exact )
+        return;
+
+    const uint64_t i_L = p_sys->i_L;
+
+    if( b_exact )
+    {
+        uint64_t i_phase = ((uint64_t)p_sys->i_frac * i_L + (1u << 31)) >> 32;
+        if( i_phase == i_L )
+        {
+            i_phase = 0;
+            p_sys->i_pos++;
+        }
+        p_sys->i_frac = i_phase;
+    }
+    else
+        p_sys->i_frac = ((uint64_t)p_sys->i_frac << 32) / i_L;
+    p_sys->b_exact = b_exact;
+}
+
+/**
+ * Computes the output samples available from the history, then discards
+ * the history that is no longer needed.
+ */
+static block_t *Render( filter_t *p_filter, mtime_t i_pts, size_t i_start )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_in_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_out_rate = p_filter->fmt_out.audio.i_rate;
+    const unsigned i_channels = p_sys->i_channels;
+    const unsigned i_taps = p_sys->i_taps;
+
+    if( unlikely(i_in_rate == 0) )
+        return NULL;
+
+    const bool b_exact = p_sys->i_L != 0 && i_in_rate == p_sys->i_rate
+                      && (p_sys->b_exact || NearExactPhase( p_sys ));
+    SetExact( p_sys, b_exact );
+
+    if( !b_exact )
+    {   /* Redesign the interpolated bank if the cut-off moved too much */
+        const float f_scale = i_in_rate > i_out_rate
+                            ? (float)i_out_rate / i_in_rate : 1.f;
+        if( p_sys->interp.p_coefs == NULL
+         || fabsf( f_scale - p_sys->interp.f_scale )
+                                > BANK_TOLERANCE * p_sys->interp.f_scale )
+        {
+            if( BankInit( p_sys, &p_sys->interp, p_sys->i_interp_phases,
+                          f_scale ) )
+                return NULL;
+        }
+    }
+
+    /* Time of the first output sample relative to i_pts */
+    double f_delay;
+    if( b_exact )
+        f_delay = (double)p_sys->i_frac / p_sys->i_L;
+    else
+        f_delay = p_sys->i_frac / 4294967296.;
+    f_delay += (double)p_sys->i_pos + (i_taps / 2 - 1) - (double)i_start;
+
+    if( p_sys->i_pos + i_taps > p_sys->i_hist_len )
+        return NULL;
+
+    const size_t i_avail = p_sys->i_hist_len - (i_taps - 1) - p_sys->i_pos;
+    const size_t i_max = (uint64_t)i_avail * i_out_rate / i_in_rate + 2;
+
+    block_t *p_out = filter_NewAudioBuffer( p_filter,
+                                            i_max * sizeof (float) * i_channels );
+    if( unlikely(p_out == NULL) )
+        return NULL;
+
+    float *p_dst = (float *)p_out->p_buffer;
+    size_t i_pos = p_sys->i_pos, i_count = 0;
+    uint32_t i_frac = p_sys->i_frac;
+
+    if( b_exact && i_in_rate == i_out_rate )
+    {   /* No conversion: only delay */
+        assert( i_frac == 0 );
+        i_count = i_avail;
+        for( unsigned c = 0; c < i_channels; c++ )
+        {
+            const float *p_src = &p_sys->p_hist[c * p_sys->i_hist_size
+                                                + i_pos + i_taps / 2 - 1];
+            for( size_t i = 0; i < i_count; i++ )
+                p_dst[i * i_channels + c] = p_src[i];
+        }
+        i_pos += i_count;
+    }
+    else if( b_exact )
+    {
+        const unsigned i_L = p_sys->i_L;
+        const unsigned i_step = p_sys->i_M / i_L, i_rem = p_sys->i_M % i_L;
+
+        for( ; i_pos + i_taps <= p_sys->i_hist_len && i_count < i_max;
+             i_count++ )
+        {
+            const float *h = &p_sys->exact.p_coefs[i_frac * i_taps];
+
+            for( unsigned c = 0; c < i_channels; c++ )
+                *(p_dst++) = p_sys->pf_dot( &p_sys->p_hist[c * p_sys->i_hist_size
+                                                           + i_pos],
+                                            h, i_taps );
+            i_pos += i_step;
+            i_frac += i_rem;
+            if( i_frac >= i_L )
+            {
+                i_frac -= i_L;
+                i_pos++;
+            }
+        }
+    }
+    else
+    {
+        const uint64_t i_step = ((uint64_t)i_in_rate << 32) / i_out_rate;
+        const unsigned i_phases = p_sys->interp.i_phases;
+
+        for( ; i_pos + i_taps <= p_sys->i_hist_len && i_count < i_max;
+             i_count++ )
+        {
+            const uint64_t i_sub = (uint64_t)i_frac * i_phases;
+            const float *h0 = &p_sys->interp.p_coefs[(i_sub >> 32) * i_taps];
+            const float mu = (uint32_t)i_sub / 4294967296.f;
+
+            for( unsigned c = 0; c < i_channels; c++ )
+                *(p_dst++) = p_sys->pf_dot_interp(
+                    &p_sys->p_hist[c * p_sys->i_hist_size + i_pos],
+                    h0, h0 + i_taps, mu, i_taps );
+
+            const uint64_t i_next = (uint64_t)i_frac + (uint32_t)i_step;
+            i_pos += (i_step >> 32) + (i_next >> 32);
+            i_frac = i_next;
+        }
+    }
+
+    /* Discard the consumed history */
+    const size_t i_drop = __MIN(i_pos, p_sys->i_hist_len);
+    p_sys->i_hist_len -= i_drop;
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        float *p_hist = &p_sys->p_hist[c * p_sys->i_hist_size];
+        memmove( p_hist, &p_hist[i_drop], sizeof (float) * p_sys->i_hist_len );
+    }
+    p_sys->i_pos = i_pos - i_drop;
+    p_sys->i_frac = i_frac;
+
+    p_out->i_buffer = i_count * sizeof (float) * i_channels;
+    p_out->i_nb_samples = i_count;
+    if( i_pts != VLC_TS_INVALID )
+        p_out->i_pts = i_pts + (mtime_t)(f_delay * CLOCK_FREQ / i_in_rate);
+    else
+        p_out->i_pts = p_sys->i_next_pts;
+    p_out->i_length = i_count * CLOCK_FREQ / i_out_rate;
+    if( p_out->i_pts != VLC_TS_INVALID )
+        p_sys->i_next_pts = p_out->i_pts + p_out->i_length;
+    return p_out;
+}
+
+static block_t *Resample( filter_t *p_filter, block_t *p_in )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    block_t *p_out = NULL;
+
+    if( p_in->i_flags & BLOCK_FLAG_DISCONTINUITY )
+        Flush( p_filter );
+
+    const size_t i_count = p_in->i_nb_samples;
+    if( HistoryReserve( p_sys, i_count ) )
+        goto out;
+
+    /* Deinterleave the input */
+    const unsigned i_channels = p_sys->i_channels;
+    const float *p_src = (const float *)p_in->p_buffer;
+    const size_t i_start = p_sys->i_hist_len;
+
+    for( unsigned c = 0; c < i_channels; c++ )
+    {
+        float *p_hist = &p_sys->p_hist[c * p_sys->i_hist_size + i_start];
+        for( size_t i = 0; i < i_count; i++ )
+            p_hist[i] = p_src[i * i_channels + c];
+    }
+    p_sys->i_hist_len += i_count;
+
+    p_out = Render( p_filter, p_in->i_pts, i_start );
+    if( p_out != NULL )
+        p_out->i_flags = p_in->i_flags;
+out:
+    block_Release( p_in );
+    return p_out;
+}
+
+static block_t *Drain( filter_t *p_filter )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const size_t i_count = p_sys->i_taps / 2;
+
+    /* Feed silence to flush the last input samples out of the filter */
+    if( HistoryReserve( p_sys, i_count ) )
+        return NULL;
+    for( unsigned c = 0; c < p_sys->i_channels; c++ )
+        memset( &p_sys->p_hist[c * p_sys->i_hist_size + p_sys->i_hist_len],
+                0, sizeof (float) * i_count );
+    p_sys->i_hist_len += i_count;
+
+    block_t *p_out = Render( p_filter, VLC_TS_INVALID, 0 );
+    Flush( p_filter );
+    return p_out;
+}
+
+/*****************************************************************************
+ * Open / Close
+ *****************************************************************************/
+static int OpenResampler( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const audio_format_t *p_in = &p_filter->fmt_in.audio;
+    const audio_format_t *p_out = &p_filter->fmt_out.audio;
+
+    /* Cannot convert format */
+    if( p_in->i_format != VLC_CODEC_FL32 || p_out->i_format != VLC_CODEC_FL32
+    /* Cannot remix */
+     || p_in->i_physical_channels != p_out->i_physical_channels
+     || p_in->i_original_channels != p_out->i_original_channels
+     || p_in->i_rate == 0 || p_out->i_rate == 0 )
+        return VLC_EGENERIC;
+
+    filter_sys_t *p_sys = malloc( sizeof (*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    unsigned i_quality = var_InheritInteger( p_this,
+                                             "polyphase-resampler-quality" );
+    if( i_quality >= ARRAY_SIZE(qualities) )
+        i_quality = 2;
+
+    /* Lengthen the filter when downsampling, to keep the same transition
+     * band relative to the output rate. */
+    unsigned i_taps = qualities[i_quality].i_taps;
+    if( p_in->i_rate > p_out->i_rate )
+        i_taps = (uint64_t)i_taps * p_in->i_rate / p_out->i_rate;
+    i_taps = __MIN((i_taps + 7) & ~7u, MAX_TAPS);
+
+    /* Kaiser design formulas: stop-band attenuation and transition width */
+    const float f_beta = qualities[i_quality].f_beta;
+    const float f_atten = f_beta / .1102f + 8.7f;
+    const float f_transition = (f_atten - 7.95f)
+                             / (14.36f * qualities[i_quality].i_taps);
+
+    p_sys->i_channels = aout_FormatNbChannels( p_in );
+    p_sys->i_taps = i_taps;
+    p_sys->f_beta = f_beta;
+    p_sys->f_cutoff = 1.f - f_transition;
+    p_sys->i_interp_phases = qualities[i_quality].i_phases;
+    p_sys->i_rate = p_in->i_rate;
+    p_sys->exact.p_coefs = NULL;
+    p_sys->interp.p_coefs = NULL;
+    p_sys->p_hist = NULL;
+    p_sys->i_hist_size = 0;
+    p_sys->i_hist_len = 0;
+    p_sys->b_exact = false;
+
+    unsigned i_L, i_M;
+    vlc_ureduce( &i_L, &i_M, p_out->i_rate, p_in->i_rate, 0 );
+    if( i_L > MAX_EXACT_PHASES )
+        i_L = 0;
+    p_sys->i_L = i_L;
+    p_sys->i_M = i_M;
+
+    const float f_scale = p_in->i_rate > p_out->i_rate
+                        ? (float)p_out->i_rate / p_in->i_rate : 1.f;
+    if( i_L != 0 && p_in->i_rate != p_out->i_rate
+     && BankInit( p_sys, &p_sys->exact, i_L, f_scale ) )
+        goto error;
+    if( HistoryReserve( p_sys, i_taps ) )
+        goto error;
+
+    p_sys->pf_dot = DotC;
+    p_sys->pf_dot_interp = DotInterpC;
+#ifdef HAVE_POLYPHASE_SSE2
+    if( vlc_CPU_SSE2() )
+    {
+        p_sys->pf_dot = DotSSE2;
+        p_sys->pf_dot_interp = DotInterpSSE2;
+    }
+#endif
+#ifdef HAVE_POLYPHASE_AVX2
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_dot = DotAVX2;
+        p_sys->pf_dot_interp = DotInterpAVX2;
+    }
+#endif
+#ifdef HAVE_POLYPHASE_NEON
+    p_sys->pf_dot = DotNEON;
+    p_sys->pf_dot_interp = DotInterpNEON;
+#endif
+
+    p_filter->p_sys = p_sys;
+    Flush( p_filter );
+    SetExact( p_sys, i_L != 0 );
+
+    p_filter->pf_audio_filter = Resample;
+    p_filter->pf_audio_drain = Drain;
+    p_filter->pf_flush = Flush;
+
+    msg_Dbg( p_filter, "%u Hz -> %u Hz, %u taps, %u exact phases",
+             p_in->i_rate, p_out->i_rate, i_taps, i_L );
+    return VLC_SUCCESS;
+
+error:
+    BankClean( &p_sys->exact );
+    free( p_sys->p_hist );
+    free( p_sys );
+    return VLC_ENOMEM;
+}
+
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    /* Will change rate */
+    if( p_filter->fmt_in.audio.i_rate == p_filter->fmt_out.audio.i_rate )
+        return VLC_EGENERIC;
+    return OpenResampler( p_this );
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    BankClean( &p_sys->exact );
+    BankClean( &p_sys->interp );
+    free( p_sys->p_hist );
+    free( p_sys );
+}
@@ -31,6 +31,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_aout.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 
 #include <string.h> /* for memset */
@@ -69,7 +70,9 @@ vlc_module_end ()
  *
  * Scaletempo smooths the overlap further by searching within the input buffer
  * for the best overlap position.  Scaletempo uses a statistical cross correlation
- * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here.
+ * (roughly a dot-product).  Scaletempo consumes most of its CPU cycles here,
+ * so the dot-product runs on SSE2, AVX2 or NEON when available.  Frames are
+ * interleaved, hence one dot-product over the overlap covers all channels.
  *
  * NOTE:
  * sample: a single audio sample for one channel
@@ -111,8 +114,109 @@ struct filter_sys_t
     void     *buf_pre_corr;
     void     *table_window;
     unsigned(*best_overlap_offset)( filter_t *p_filter );
+    float   (*corr_dot)( const float *, const float *, unsigned );
 };
 
+/*****************************************************************************
+ * corr_dot: correlation of the pre-windowed overlap with the search window
+ *****************************************************************************/
+static float corr_dot_c( const float *ppc, const float *ps, unsigned n )
+{
+    float corr = 0;
+    for( unsigned i = 0; i < n; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+
+#define HAVE_SCALETEMPO_SSE2
+
+__attribute__ ((__target__ ("sse2")))
+static float corr_dot_sse2( const float *ppc, const float *ps, unsigned n )
+{
+    __m128 a0 = _mm_setzero_ps(), a1 = _mm_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+        a0 = _mm_add_ps( a0, _mm_mul_ps( _mm_loadu_ps( &ppc[i] ),
+                                         _mm_loadu_ps( &ps[i] ) ) );
+        a1 = _mm_add_ps( a1, _mm_mul_ps( _mm_loadu_ps( &ppc[i + 4] ),
+                                         _mm_loadu_ps( &ps[i + 4] ) ) );
+    }
+    a0 = _mm_add_ps( a0, a1 );
+    a0 = _mm_add_ps( a0, _mm_movehl_ps( a0, a0 ) );
+    a0 = _mm_add_ss( a0, _mm_shuffle_ps( a0, a0, 1 ) );
+
+    float corr = _mm_cvtss_f32( a0 );
+    for( ; i < n; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define HAVE_SCALETEMPO_AVX2
+
+__attribute__ ((__target__ ("avx2")))
+static float corr_dot_avx2( const float *ppc, const float *ps, unsigned n )
+{
+    __m256 a0 = _mm256_setzero_ps(), a1 = _mm256_setzero_ps();
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        a0 = _mm256_add_ps( a0, _mm256_mul_ps( _mm256_loadu_ps( &ppc[i] ),
+                                               _mm256_loadu_ps( &ps[i] ) ) );
+        a1 = _mm256_add_ps( a1, _mm256_mul_ps( _mm256_loadu_ps( &ppc[i + 8] ),
+                                               _mm256_loadu_ps( &ps[i + 8] ) ) );
+    }
+    a0 = _mm256_add_ps( a0, a1 );
+
+    __m128 s = _mm_add_ps( _mm256_castps256_ps128( a0 ),
+                           _mm256_extractf128_ps( a0, 1 ) );
+    for( ; i + 4 <= n; i += 4 )
+        s = _mm_add_ps( s, _mm_mul_ps( _mm_loadu_ps( &ppc[i] ),
+                                       _mm_loadu_ps( &ps[i] ) ) );
+    s = _mm_add_ps( s, _mm_movehl_ps( s, s ) );
+    s = _mm_add_ss( s, _mm_shuffle_ps( s, s, 1 ) );
+
+    float corr = _mm_cvtss_f32( s );
+    for( ; i < n; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#define HAVE_SCALETEMPO_NEON
+
+static float corr_dot_neon( const float *ppc, const float *ps, unsigned n )
+{
+    float32x4_t a0 = vdupq_n_f32( 0.f ), a1 = vdupq_n_f32( 0.f );
+    unsigned i = 0;
+
+    for( ; i + 8 <= n; i += 8 )
+    {
+        a0 = vmlaq_f32( a0, vld1q_f32( &ppc[i] ), vld1q_f32( &ps[i] ) );
+        a1 = vmlaq_f32( a1, vld1q_f32( &ppc[i + 4] ), vld1q_f32( &ps[i + 4] ) );
+    }
+    a0 = vaddq_f32( a0, a1 );
+
+    float32x2_t s = vadd_f32( vget_low_f32( a0 ), vget_high_f32( a0 ) );
+    float corr = vget_lane_f32( vpadd_f32( s, s ), 0 );
+    for( ; i < n; i++ )
+        corr += ppc[i] * ps[i];
+    return corr;
+}
+#endif
+
 /*****************************************************************************
  * best_overlap_offset: calculate best offset for overlap
  *****************************************************************************/
@@ -123,6 +227,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
     float best_corr = INT_MIN;
     unsigned best_off = 0;
     unsigned i, off;
+    unsigned samples_corr = p->samples_overlap - p->samples_per_frame;
 
     pw  = p->table_window;
     po  = p->buf_overlap;
@@ -134,12 +239,7 @@ static unsigned best_overlap_offset_float( filter_t *p_filter )
 
     search_start = (float *)p->buf_queue + p->samples_per_frame;
     for( off = 0; off < p->frames_search; off++ ) {
-      float corr = 0;
-      float *ps = search_start;
-      ppc = p->buf_pre_corr;
-      for( i = p->samples_per_frame; i < p->samples_overlap; i++ ) {
-        corr += *ppc++ * *ps++;
-      }
+      float corr = p->corr_dot( p->buf_pre_corr, search_start, samples_corr );
       if( corr > best_corr ) {
         best_corr = corr;
         best_off  = off;
@@ -338,6 +438,18 @@ static int reinit_buffers( filter_t *p_filter )
                 *pw++ = v;
         }
         p->best_overlap_offset = best_overlap_offset_float;
+        p->corr_dot = corr_dot_c;
+#ifdef HAVE_SCALETEMPO_SSE2
+        if( vlc_CPU_SSE2() )
+            p->corr_dot = corr_dot_sse2;
+#endif
+#ifdef HAVE_SCALETEMPO_AVX2
+        if( vlc_CPU_AVX2() )
+            p->corr_dot = corr_dot_avx2;
+#endif
+#ifdef HAVE_SCALETEMPO_NEON
+        p->corr_dot = corr_dot_neon;
+#endif
     }
 
     unsigned new_size = ( p->frames_search + frames_stride + frames_overlap ) * p->bytes_per_frame;
@@ -468,7 +580,7 @@ static block_t *DoWork( filter_t * p_filter, block_t * p_in_buf )
     }
 
     size_t i_outsize = calculate_output_buffer_size ( p_filter, p_in_buf->i_buffer );
-    block_t *p_out_buf = block_Alloc( i_outsize );
+    block_t *p_out_buf = filter_NewAudioBuffer( p_filter, i_outsize );
     if( p_out_buf == NULL )
         return NULL;
 
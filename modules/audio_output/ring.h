@@ -0,0 +1,354 @@
+/*****************************************************************************
+ * ring.h : lock-free sample ring and output thread for blocking devices
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_AOUT_RING_H
+#define VLC_AOUT_RING_H 1
+
+/* Outputs writing to a blocking device queue their samples in a single
+ * producer, single consumer ring, and a dedicated high priority thread feeds
+ * the device from the ring. The decoder thread then never waits on the
+ * device, so the device buffer only needs to absorb the scheduling latency
+ * of the output thread.
+ *
+ * The ring positions count the bytes queued and played since the start.
+ * Each is written by one side only, so the fast path takes no lock. A side
+ * only takes the lock to sleep while the ring is full or empty, and the other
+ * side only takes it to wake a sleeper up. */
+
+#include <vlc_atomic.h>
+#include <vlc_block.h>
+
+/** Duration of the samples the ring can hold */
+#define AOUT_RING_TIME AOUT_MAX_ADVANCE_TIME
+/** Duration of the samples the device should buffer behind the ring */
+#define AOUT_RING_DEVICE_TIME (4 * AOUT_MIN_PREPARE_TIME)
+
+enum
+{
+    AOUT_RING_NONE,
+    AOUT_RING_SYNC, /**< Get the thread out of the device write callback */
+    AOUT_RING_FLUSH, /**< Discard the queued samples */
+    AOUT_RING_QUIT,
+};
+
+typedef struct aout_ring
+{
+    uint8_t *buffer;
+    size_t size; /**< Capacity (bytes) */
+    size_t chunk; /**< Largest device write (bytes) */
+    atomic_size_t head; /**< Bytes queued, written by the producer */
+    atomic_size_t tail; /**< Bytes played, written by the output thread */
+    atomic_uint request; /**< Pending AOUT_RING_* request */
+    atomic_bool paused;
+    atomic_bool thread_asleep; /**< The output thread waits on wait */
+    atomic_bool space_asleep; /**< The producer waits on space */
+    vlc_mutex_t lock; /**< Only taken to sleep or to wake a sleeper up */
+    vlc_cond_t wait; /**< Wakes the output thread up */
+    vlc_cond_t space; /**< Signals that samples were played */
+    vlc_sem_t ack; /**< Signals that a request was served */
+    vlc_thread_t thread;
+
+    /** Writes to the device, blocking. Returns the number of bytes written,
+     * or a negative value to drop the samples on unrecoverable errors. */
+    ssize_t (*write)(void *opaque, const void *buf, size_t length);
+    void *opaque;
+} aout_ring_t;
+
+/**
+ * Returns the number of bytes queued and not played yet.
+ */
+static inline size_t aout_RingUsed(aout_ring_t *ring)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    return head - tail;
+}
+
+/**
+ * Queues as many bytes as fit in the ring without blocking.
+ * Producer side only. Returns the number of bytes queued.
+ */
+static inline size_t aout_RingPush(aout_ring_t *ring, const uint8_t *buf,
+                                   size_t length)
+{
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t avail = ring->size - (head - tail);
+
+    if (length > avail)
+        length = avail;
+
+    size_t offset = head % ring->size;
+    size_t first = ring->size - offset;
+
+    if (first > length)
+        first = length;
+    memcpy(ring->buffer + offset, buf, first);
+    memcpy(ring->buffer, buf + first, length - first);
+
+    atomic_store_explicit(&ring->head, head + length, memory_order_release);
+    return length;
+}
+
+/**
+ * Gets the longest contiguous run of queued bytes.
+ * Output thread side only.
+ */
+static inline size_t aout_RingPeek(aout_ring_t *ring, const uint8_t **buf)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+    size_t offset = tail % ring->size;
+    size_t length = head - tail;
+
+    if (length > ring->size - offset)
+        length = ring->size - offset;
+    *buf = ring->buffer + offset;
+    return length;
+}
+
+static inline void aout_RingConsume(aout_ring_t *ring, size_t length)
+{
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+
+    atomic_store_explicit(&ring->tail, tail + length, memory_order_release);
+}
+
+/* A sleeper raises its flag, then checks its wake-up condition again. A waker
+ * changes that condition, then checks the flag. The fences order both pairs,
+ * so either the sleeper sees the change or the waker sees the flag. The waker
+ * signals under the lock, which the sleeper holds until it waits. */
+static inline void aout_RingWake(aout_ring_t *ring, atomic_bool *asleep,
+                                 vlc_cond_t *cond)
+{
+    atomic_thread_fence(memory_order_seq_cst);
+    if (atomic_load_explicit(asleep, memory_order_relaxed))
+    {
+        vlc_mutex_lock(&ring->lock);
+        vlc_cond_signal(cond);
+        vlc_mutex_unlock(&ring->lock);
+    }
+}
+
+static inline bool aout_RingIdle(aout_ring_t *ring)
+{
+    return atomic_load(&ring->request) == AOUT_RING_NONE
+        && (aout_RingUsed(ring) == 0 || atomic_load(&ring->paused));
+}
+
+/**
+ * Waits until at most the given number of bytes remain queued.
+ * Producer side only.
+ */
+static inline void aout_RingWaitUsed(aout_ring_t *ring, size_t used)
+{
+    if (aout_RingUsed(ring) <= used)
+        return;
+
+    vlc_mutex_lock(&ring->lock);
+    atomic_store_explicit(&ring->space_asleep, true, memory_order_relaxed);
+    atomic_thread_fence(memory_order_seq_cst);
+    while (aout_RingUsed(ring) > used)
+        vlc_cond_wait(&ring->space, &ring->lock);
+    atomic_store_explicit(&ring->space_asleep, false, memory_order_relaxed);
+    vlc_mutex_unlock(&ring->lock);
+}
+
+static void *aout_RingThread(void *data)
+{
+    aout_ring_t *ring = data;
+
+    for (;;)
+    {
+        unsigned req = atomic_exchange(&ring->request, AOUT_RING_NONE);
+
+        if (req == AOUT_RING_QUIT)
+            break;
+        if (req != AOUT_RING_NONE)
+        {
+            if (req == AOUT_RING_FLUSH)
+                aout_RingConsume(ring, aout_RingUsed(ring));
+            vlc_sem_post(&ring->ack);
+            continue;
+        }
+
+        const uint8_t *buf;
+        size_t length = aout_RingPeek(ring, &buf);
+
+        if (length == 0 || atomic_load(&ring->paused))
+        {
+            vlc_mutex_lock(&ring->lock);
+            atomic_store_explicit(&ring->thread_asleep, true,
+                                  memory_order_relaxed);
+            atomic_thread_fence(memory_order_seq_cst);
+            while (aout_RingIdle(ring))
+                vlc_cond_wait(&ring->wait, &ring->lock);
+            atomic_store_explicit(&ring->thread_asleep, false,
+                                  memory_order_relaxed);
+            vlc_mutex_unlock(&ring->lock);
+            continue;
+        }
+
+        if (length > ring->chunk)
+            length = ring->chunk;
+
+        ssize_t val = ring->write(ring->opaque, buf, length);
+        if (val < 0)
+            val = length;
+        aout_RingConsume(ring, val);
+        aout_RingWake(ring, &ring->space_asleep, &ring->space);
+    }
+    return NULL;
+}
+
+/**
+ * Allocates a ring of (at least) the given size, rounded down to a whole
+ * number of frames, and starts the output thread.
+ * @param chunk largest number of bytes to write to the device at once,
+ *              e.g. one device period
+ */
+static inline int aout_RingInit(aout_ring_t *ring, size_t size, size_t frame,
+                                size_t chunk,
+                                ssize_t (*write)(void *, const void *, size_t),
+                                void *opaque)
+{
+    size -= size % frame;
+    chunk -= chunk % frame;
+    if (unlikely(size == 0 || chunk == 0))
+        return VLC_EGENERIC;
+
+    ring->buffer = malloc(size);
+    if (unlikely(ring->buffer == NULL))
+        return VLC_ENOMEM;
+
+    ring->size = size;
+    ring->chunk = chunk;
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+    atomic_init(&ring->request, AOUT_RING_NONE);
+    atomic_init(&ring->paused, false);
+    atomic_init(&ring->thread_asleep, false);
+    atomic_init(&ring->space_asleep, false);
+    vlc_mutex_init(&ring->lock);
+    vlc_cond_init(&ring->wait);
+    vlc_cond_init(&ring->space);
+    vlc_sem_init(&ring->ack, 0);
+    ring->write = write;
+    ring->opaque = opaque;
+
+    if (vlc_clone(&ring->thread, aout_RingThread, ring,
+                  VLC_THREAD_PRIORITY_AUDIO))
+    {
+        vlc_sem_destroy(&ring->ack);
+        vlc_cond_destroy(&ring->space);
+        vlc_cond_destroy(&ring->wait);
+        vlc_mutex_destroy(&ring->lock);
+        free(ring->buffer);
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
+/**
+ * Stops the output thread and releases the ring. The queued samples are lost.
+ */
+static inline void aout_RingClean(aout_ring_t *ring)
+{
+    atomic_store(&ring->request, AOUT_RING_QUIT);
+    aout_RingWake(ring, &ring->thread_asleep, &ring->wait);
+    vlc_join(ring->thread, NULL);
+
+    vlc_sem_destroy(&ring->ack);
+    vlc_cond_destroy(&ring->space);
+    vlc_cond_destroy(&ring->wait);
+    vlc_mutex_destroy(&ring->lock);
+    free(ring->buffer);
+}
+
+/**
+ * Waits for the output thread to serve a request.
+ */
+static inline void aout_RingRequest(aout_ring_t *ring, unsigned req)
+{
+    atomic_store(&ring->request, req);
+    aout_RingWake(ring, &ring->thread_asleep, &ring->wait);
+    vlc_sem_wait(&ring->ack);
+}
+
+/**
+ * Queues one audio buffer, waiting for room in the ring if needed.
+ */
+static inline void aout_RingPlay(aout_ring_t *ring, block_t *block)
+{
+    const uint8_t *buf = block->p_buffer;
+    size_t length = block->i_buffer;
+
+    for (;;)
+    {
+        size_t val = aout_RingPush(ring, buf, length);
+        if (val > 0)
+            aout_RingWake(ring, &ring->thread_asleep, &ring->wait);
+
+        buf += val;
+        length -= val;
+        /* Nothing gets played while paused: drop what does not fit */
+        if (length == 0 || atomic_load(&ring->paused))
+            break;
+        aout_RingWaitUsed(ring, ring->size - 1);
+    }
+    block_Release(block);
+}
+
+/**
+ * Stops or resumes feeding the device. When pausing, this returns once the
+ * output thread has left the device, so that it can be paused safely. When
+ * resuming, the device must be resumed first.
+ */
+static inline void aout_RingPause(aout_ring_t *ring, bool paused)
+{
+    atomic_store(&ring->paused, paused);
+    if (paused)
+        aout_RingRequest(ring, AOUT_RING_SYNC);
+    else
+        aout_RingWake(ring, &ring->thread_asleep, &ring->wait);
+}
+
+/**
+ * Discards the queued samples. On return, the output thread has left the
+ * device, so that the device can be flushed safely in turn.
+ */
+static inline void aout_RingFlush(aout_ring_t *ring)
+{
+    aout_RingRequest(ring, AOUT_RING_FLUSH);
+}
+
+/**
+ * Waits until all queued samples were written to the device, so that the
+ * device can be drained in turn.
+ */
+static inline void aout_RingDrain(aout_ring_t *ring)
+{
+    if (atomic_load(&ring->paused))
+        return;
+    aout_RingWaitUsed(ring, 0);
+}
+
+#endif
@@ -334,8 +334,11 @@ static int OpenEncoder(vlc_object_t *p_this)
 
     p_enc->p_sys->p_obj = p_this;
 
-    p_enc->p_sys->i_blocksize = 3 * p_enc->fmt_in.video.i_visible_width *
+    /* Worst case: the rows stored uncompressed with their filter byte, plus
+     * the signature, the chunk headers and the deflate framing */
+    size_t i_raw = (3 * p_enc->fmt_in.video.i_visible_width + 1) *
         p_enc->fmt_in.video.i_visible_height;
+    p_enc->p_sys->i_blocksize = i_raw + i_raw / 256 + 1024;
 
     p_enc->fmt_in.i_codec = VLC_CODEC_RGB24;
     p_enc->pf_encode_video = EncodeBlock;
@@ -180,6 +180,7 @@ static bool GatherSectionsData( demux_t *p_demux, ts_pid_t *, block_t *, size_t
 static void ProgramSetPCR( demux_t *p_demux, ts_pmt_t *p_prg, mtime_t i_pcr );
 
 static block_t* ReadTSPacket( demux_t *p_demux );
+static block_t* ReadTSPacketDescrambled( demux_t *p_demux );
 static int SeekToTime( demux_t *p_demux, const ts_pmt_t *, int64_t time );
 static void ReadyQueuesPostSeek( demux_t *p_demux );
 static void PCRHandle( demux_t *p_demux, ts_pid_t *, mtime_t );
@@ -386,6 +387,7 @@ static int Open( vlc_object_t *p_this )
     p_sys->i_packet_header_size = i_packet_header_size;
     p_sys->i_ts_read = 50;
     p_sys->csa = NULL;
+    p_sys->p_csa_batch = NULL;
     p_sys->b_start_record = false;
 
     p_sys->patfix.i_first_dts = -1;
@@ -540,6 +542,7 @@ static void Close( vlc_object_t *p_this )
         csa_Delete( p_sys->csa );
     }
     vlc_mutex_unlock( &p_sys->csa_lock );
+    block_ChainRelease( p_sys->p_csa_batch );
 
     ARRAY_RESET( p_sys->programs );
 
@@ -605,7 +608,11 @@ static int Demux( demux_t *p_demux )
         bool         b_frame = false;
         int          i_header = 0;
         block_t     *p_pkt;
-        if( !(p_pkt = ReadTSPacket( p_demux )) )
+        if( p_sys->csa )
+            p_pkt = ReadTSPacketDescrambled( p_demux );
+        else
+            p_pkt = ReadTSPacket( p_demux );
+        if( !p_pkt )
         {
             return VLC_DEMUXER_EOF;
         }
@@ -1731,6 +1738,53 @@ static block_t* ReadTSPacket( demux_t *p_demux )
     return p_pkt;
 }
 
+/* Reads up to i_ts_read packets ahead and descrambles them in one batch */
+static block_t* ReadTSPacketDescrambled( demux_t *p_demux )
+{
+    demux_sys_t *p_sys = p_demux->p_sys;
+
+    /* Recording starts with the next packet read from the stream */
+    if( p_sys->p_csa_batch == NULL && p_sys->b_start_record )
+        return ReadTSPacket( p_demux );
+
+    if( p_sys->p_csa_batch == NULL )
+    {
+        block_t **pp_last = &p_sys->p_csa_batch;
+        uint8_t *pp_scrambled[CSA_BATCH_SIZE];
+        int i_scrambled = 0;
+
+        for( unsigned i = 0; i < __MIN(p_sys->i_ts_read, (unsigned)CSA_BATCH_SIZE); i++ )
+        {
+            block_t *p_pkt = ReadTSPacket( p_demux );
+            if( !p_pkt )
+                break;
+            block_ChainLastAppend( &pp_last, p_pkt );
+
+            /* Truncated and uncorrected packets will be rejected by Demux */
+            if( p_pkt->i_buffer >= TS_PACKET_SIZE_188 &&
+                (p_pkt->p_buffer[1]&0x80) == 0 &&
+                (p_pkt->p_buffer[3]&0x80) )
+                pp_scrambled[i_scrambled++] = p_pkt->p_buffer;
+        }
+
+        if( i_scrambled > 0 )
+        {
+            vlc_mutex_lock( &p_sys->csa_lock );
+            csa_DecryptBatch( p_sys->csa, pp_scrambled, i_scrambled,
+                              p_sys->i_csa_pkt_size );
+            vlc_mutex_unlock( &p_sys->csa_lock );
+        }
+    }
+
+    block_t *p_pkt = p_sys->p_csa_batch;
+    if( p_pkt )
+    {
+        p_sys->p_csa_batch = p_pkt->p_next;
+        p_pkt->p_next = NULL;
+    }
+    return p_pkt;
+}
+
 static mtime_t GetPCR( const block_t *p_pkt )
 {
     const uint8_t *p = p_pkt->p_buffer;
@@ -1803,6 +1857,10 @@ static void ReadyQueuesPostSeek( demux_t *p_demux )
 {
     demux_sys_t *p_sys = p_demux->p_sys;
 
+    /* Read ahead packets are from before the seek point */
+    block_ChainRelease( p_sys->p_csa_batch );
+    p_sys->p_csa_batch = NULL;
+
     ts_pat_t *p_pat = GetPID(p_sys, 0)->u.p_pat;
     for( int i=0; i< p_pat->programs.i_size; i++ )
     {
@@ -231,6 +231,7 @@ static int Open( vlc_object_t * p_this )
         return VLC_ENOMEM;
 
     p_sys->i_length = -1;
+    p_sys->i_page_pos = -1;
     p_sys->b_preparsing_done = false;
 
     vlc_stream_Control( p_demux->s, STREAM_GET_PTS_DELAY,
@@ -271,6 +272,8 @@ static void Close( vlc_object_t *p_this )
     if( p_sys->p_old_stream )
         Ogg_LogicalStreamDelete( p_demux, p_sys->p_old_stream );
 
+    oggseek_page_cache_free( p_sys->p_page_cache );
+
     free( p_sys );
 }
 
@@ -610,6 +613,12 @@ static int Demux( demux_t * p_demux )
         {
             p_stream->i_pcr = VLC_TS_0 + i_pagestamp;
             p_stream->i_pcr += p_sys->i_nzpcr_offset;
+
+            /* Only sized streams can be seeked back into */
+            if ( p_sys->i_page_pos != -1 && p_sys->i_total_length > 0 )
+                OggSeek_IndexAdd( p_stream, i_pagestamp,
+                                  ogg_page_granulepos( &p_sys->current_page ),
+                                  p_sys->i_page_pos );
         }
 
         if( !p_sys->b_page_waiting )
@@ -959,6 +968,14 @@ static int Ogg_ReadPage( demux_t *p_demux, ogg_page *p_oggpage )
         ogg_sync_wrote( &p_ogg->oy, i_read );
     }
 
+    /* The sync layer holds what follows the page, so we can tell where the
+     * page started in the physical bitstream */
+    p_ogg->i_page_pos = vlc_stream_Tell( p_demux->s )
+                      - ( p_ogg->oy.fill - p_ogg->oy.returned )
+                      - p_oggpage->header_len - p_oggpage->body_len;
+    if( p_ogg->i_page_pos < 0 )
+        p_ogg->i_page_pos = -1;
+
     return VLC_SUCCESS;
 }
 
@@ -2160,8 +2177,9 @@ static int Ogg_BeginningOfStream( demux_t *p_demux )
 
         p_stream->p_es = NULL;
 
-        /* initialise kframe index */
-        p_stream->idx=NULL;
+        /* initialise page index */
+        p_stream->idx.p_entries = NULL;
+        p_stream->idx.i_count = p_stream->idx.i_size = 0;
 
         if ( p_stream->fmt.i_bitrate == 0  &&
              ( p_stream->fmt.i_cat == VIDEO_ES ||
@@ -2255,10 +2273,7 @@ static void Ogg_LogicalStreamDelete( demux_t *p_demux, logical_stream_t *p_strea
     es_format_Clean( &p_stream->fmt_old );
     es_format_Clean( &p_stream->fmt );
 
-    if ( p_stream->idx != NULL)
-    {
-        oggseek_index_entries_free( p_stream->idx );
-    }
+    oggseek_index_entries_free( p_stream->idx.p_entries );
 
     Ogg_FreeSkeleton( p_stream->p_skel );
     p_stream->p_skel = NULL;
@@ -3205,6 +3220,19 @@ static void Ogg_ReadSkeletonIndex( demux_t *p_demux, ogg_packet *p_oggpacket )
     uint64_t i_time = 0;
     uint64_t i_keypoints_found = 0;
 
+    /* Each keypoint takes at least 2 bytes */
+    if ( i_keypoints > (uint64_t)( p_boundary - p_fwdbyte ) / 2 )
+    {
+        msg_Warn( p_demux, "Invalid Index: missing entries" );
+        return;
+    }
+    if ( i_keypoints > SIZE_MAX / sizeof( ogg_skeleton_keypoint_t ) ) return;
+
+    /* Decode it once, so that lookups can bisect it */
+    ogg_skeleton_keypoint_t *p_index =
+        malloc( i_keypoints * sizeof( ogg_skeleton_keypoint_t ) );
+    if ( !p_index ) return;
+
     while( p_fwdbyte < p_boundary && i_keypoints_found < i_keypoints )
     {
         uint64_t i_val;
@@ -3212,21 +3240,22 @@ static void Ogg_ReadSkeletonIndex( demux_t *p_demux, ogg_packet *p_oggpacket )
         i_offset += i_val;
         p_fwdbyte = Read7BitsVariableLE( p_fwdbyte, p_boundary, &i_val );
         i_time += i_val * p_stream->p_skel->i_indexstampden;
+        if ( (int64_t) i_offset < 0 || (int64_t) i_time < 0 ) break;
+        p_index[i_keypoints_found].i_pos = i_offset;
+        p_index[i_keypoints_found].i_time = i_time;
         i_keypoints_found++;
     }
 
     if ( i_keypoints_found != i_keypoints )
     {
         msg_Warn( p_demux, "Invalid Index: missing entries" );
+        free( p_index );
         return;
     }
 
-    p_stream->p_skel->p_index = malloc( p_oggpacket->bytes - 42 );
-    if ( !p_stream->p_skel->p_index ) return;
-    memcpy( p_stream->p_skel->p_index, &p_oggpacket->packet[42],
-            p_oggpacket->bytes - 42 );
+    free( p_stream->p_skel->p_index );
+    p_stream->p_skel->p_index = p_index;
     p_stream->p_skel->i_index = i_keypoints_found;
-    p_stream->p_skel->i_index_size = p_oggpacket->bytes - 42;
 }
 
 static void Ogg_FreeSkeleton( ogg_skeleton_t *p_skel )
@@ -3271,39 +3300,25 @@ bool Ogg_GetBoundsUsingSkeletonIndex( logical_stream_t *p_stream, int64_t i_time
          i_time > p_stream->p_skel->i_indexlastnum
                 * p_stream->p_skel->i_indexstampden ) return false;
 
-    /* Then Lookup its index */
-    unsigned const char *p_fwdbyte = p_stream->p_skel->p_index;
-    struct
-    {
-        int64_t i_pos;
-        int64_t i_time;
-    } current = { 0, 0 }, prev = { -1, -1 };
-
-    uint64_t i_keypoints_found = 0;
+    /* Then bisect its index for the first keypoint at or after i_time */
+    const ogg_skeleton_keypoint_t *p_index = p_stream->p_skel->p_index;
+    uint64_t i_low = 0, i_high = p_stream->p_skel->i_index;
 
-    while( p_fwdbyte < p_fwdbyte + p_stream->p_skel->i_index_size
-           && i_keypoints_found < p_stream->p_skel->i_index )
+    while ( i_low < i_high )
     {
-        uint64_t i_val;
-        p_fwdbyte = Read7BitsVariableLE( p_fwdbyte,
-                        p_fwdbyte + p_stream->p_skel->i_index_size, &i_val );
-        current.i_pos += i_val;
-        p_fwdbyte = Read7BitsVariableLE( p_fwdbyte,
-                        p_fwdbyte + p_stream->p_skel->i_index_size, &i_val );
-        current.i_time += i_val * p_stream->p_skel->i_indexstampden;
-        if ( current.i_pos < 0 || current.i_time < 0 ) break;
+        uint64_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_index[i_mid].i_time < i_time )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
 
-        i_keypoints_found++;
+    if ( i_low == p_stream->p_skel->i_index )
+        return false;
 
-        if ( i_time <= current.i_time )
-        {
-            *pi_lower = prev.i_pos;
-            *pi_upper = current.i_pos;
-            return ( i_time == current.i_time );
-        }
-        prev = current;
-    }
-    return false;
+    *pi_lower = ( i_low > 0 ) ? p_index[i_low - 1].i_pos : -1;
+    *pi_upper = p_index[i_low].i_pos;
+    return ( i_time == p_index[i_low].i_time );
 }
 
 static uint32_t dirac_uint( bs_t *p_bs )
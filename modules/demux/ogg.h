@@ -49,6 +49,7 @@
 #define PACKET_IS_SYNCPOINT  0x08
 
 typedef struct oggseek_index_entry demux_index_entry_t;
+typedef struct oggseek_page_cache oggseek_page_cache_t;
 typedef struct ogg_skeleton_t ogg_skeleton_t;
 
 typedef struct backup_queue
@@ -99,8 +100,14 @@ typedef struct logical_stream_s
     /* offset of first keyframe for theora; can be 0 or 1 depending on version number */
     int8_t i_keyframe_offset;
 
-    /* keyframe index for seeking, created as we discover keyframes */
-    demux_index_entry_t *idx;
+    /* page index for seeking, sorted by position, created from every
+     * page we come across while demuxing or seeking */
+    struct
+    {
+        demux_index_entry_t *p_entries;
+        size_t i_count;
+        size_t i_size;
+    } idx;
 
     /* Skeleton data */
     ogg_skeleton_t *p_skel;
@@ -157,13 +164,18 @@ typedef struct logical_stream_s
 
 } logical_stream_t;
 
+typedef struct
+{
+    int64_t i_pos;
+    int64_t i_time;
+} ogg_skeleton_keypoint_t;
+
 struct ogg_skeleton_t
 {
     int            i_messages;
     char         **ppsz_messages;
-    unsigned char *p_index;
+    ogg_skeleton_keypoint_t *p_index; /* decoded keypoints, sorted by time */
     uint64_t       i_index;
-    uint64_t       i_index_size;
     int64_t        i_indexstampden;/* time denominator */
     int64_t        i_indexfirstnum;/* first sample time numerator */
     int64_t        i_indexlastnum;
@@ -207,8 +219,12 @@ struct demux_sys_t
     /* offset position in file (for reading) */
     int64_t i_input_position;
 
-    /* current page being parsed */
+    /* current page being parsed, and its offset in file (-1 if unknown) */
     ogg_page current_page;
+    int64_t i_page_pos;
+
+    /* pages recently read by the seek code */
+    oggseek_page_cache_t *p_page_cache;
 
     /* */
     vlc_meta_t          *p_meta;
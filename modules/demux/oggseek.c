@@ -67,115 +67,198 @@ typedef struct packetStartCoordinates
 * index entries
 *************************************************************/
 
-/* free all entries in index list */
+/* free all entries in index */
 
 void oggseek_index_entries_free ( demux_index_entry_t *idx )
 {
-    demux_index_entry_t *idx_next;
+    free( idx );
+}
+
+/* returns the number of entries whose page starts before i_pagepos */
+
+static size_t OggSeekIndexBisectPos( const logical_stream_t *p_stream,
+                                     int64_t i_pagepos )
+{
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
 
-    while ( idx != NULL )
+    while ( i_low < i_high )
     {
-        idx_next = idx->p_next;
-        free( idx );
-        idx = idx_next;
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_pagepos < i_pagepos )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
     }
+    return i_low;
 }
 
+/* returns the number of entries whose page ends at or before i_timestamp */
 
-/* internal function to create a new list member */
-
-static demux_index_entry_t *index_entry_new( void )
+static size_t OggSeekIndexBisectTime( const logical_stream_t *p_stream,
+                                      int64_t i_timestamp )
 {
-    demux_index_entry_t *idx = xmalloc( sizeof( demux_index_entry_t ) );
-    if ( !idx ) return NULL;
-    idx->p_next = idx->p_prev = NULL;
-    idx->i_pagepos_end = -1;
-    return idx;
+    size_t i_low = 0, i_high = p_stream->idx.i_count;
+
+    while ( i_low < i_high )
+    {
+        size_t i_mid = i_low + ( i_high - i_low ) / 2;
+        if ( p_stream->idx.p_entries[i_mid].i_value <= i_timestamp )
+            i_low = i_mid + 1;
+        else
+            i_high = i_mid;
+    }
+    return i_low;
 }
 
-/* We insert into index, sorting by pagepos (as a page can match multiple
-   time stamps) */
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *p_stream,
-                                             int64_t i_timestamp,
-                                             int64_t i_pagepos )
+/* We insert into index, sorting by pagepos. Entries closer than
+   OGGSEEK_INDEX_SPACING to an existing one are not worth the memory,
+   and entries breaking the time order (broken streams) are refused. */
+bool OggSeek_IndexAdd ( logical_stream_t *p_stream, int64_t i_timestamp,
+                        int64_t i_granule, int64_t i_pagepos )
 {
-    demux_index_entry_t *idx;
-    demux_index_entry_t *last_idx = NULL;
+    if ( p_stream == NULL ) return false;
 
-    if ( p_stream == NULL ) return NULL;
+    if ( i_timestamp < 1 || i_pagepos < 1 ) return false;
 
-    idx = p_stream->idx;
+    demux_index_entry_t *p_entries = p_stream->idx.p_entries;
+    size_t i_count = p_stream->idx.i_count;
+    size_t i_pos = OggSeekIndexBisectPos( p_stream, i_pagepos );
 
-    if ( i_timestamp < 1 || i_pagepos < 1 ) return NULL;
+    if ( i_pos > 0 &&
+         ( i_pagepos - p_entries[i_pos - 1].i_pagepos < OGGSEEK_INDEX_SPACING ||
+           p_entries[i_pos - 1].i_value > i_timestamp ) )
+        return false;
 
-    if ( idx == NULL )
+    if ( i_pos < i_count &&
+         ( p_entries[i_pos].i_pagepos - i_pagepos < OGGSEEK_INDEX_SPACING ||
+           p_entries[i_pos].i_value < i_timestamp ) )
+        return false;
+
+    if ( i_count == p_stream->idx.i_size )
     {
-        demux_index_entry_t *ie = index_entry_new();
-        if ( !ie ) return NULL;
-        ie->i_value = i_timestamp;
-        ie->i_pagepos = i_pagepos;
-        p_stream->idx = ie;
-        return ie;
+        size_t i_size = p_stream->idx.i_size ? p_stream->idx.i_size * 2 : 256;
+        p_entries = realloc( p_entries, i_size * sizeof( *p_entries ) );
+        if ( !p_entries ) return false;
+        p_stream->idx.p_entries = p_entries;
+        p_stream->idx.i_size = i_size;
     }
 
-    while ( idx != NULL )
+    memmove( &p_entries[i_pos + 1], &p_entries[i_pos],
+             ( i_count - i_pos ) * sizeof( *p_entries ) );
+    p_entries[i_pos].i_value = i_timestamp;
+    p_entries[i_pos].i_granule = i_granule;
+    p_entries[i_pos].i_pagepos = i_pagepos;
+    p_stream->idx.i_count++;
+
+    return true;
+}
+
+/* Looks up the last indexed page ending at or before i_timestamp.
+   The upper bound is set from the following entry, if any. */
+static const demux_index_entry_t *OggSeekIndexFind ( logical_stream_t *p_stream,
+                                                     int64_t i_timestamp,
+                                                     int64_t *pi_pos_lower,
+                                                     int64_t *pi_pos_upper )
+{
+    size_t i_pos = OggSeekIndexBisectTime( p_stream, i_timestamp );
+
+    if ( i_pos == 0 )
+        return NULL;
+
+    const demux_index_entry_t *p_lower = &p_stream->idx.p_entries[i_pos - 1];
+    *pi_pos_lower = p_lower->i_pagepos;
+    if ( i_pos < p_stream->idx.i_count )
+        *pi_pos_upper = p_stream->idx.p_entries[i_pos].i_pagepos;
+
+    return p_lower;
+}
+
+/************************************************************
+* page cache
+*************************************************************/
+
+/* this is typedefed to oggseek_page_cache_t in ogg.h */
+struct oggseek_page_cache
+{
+    struct
     {
-        if ( idx->i_pagepos > i_pagepos ) break;
-        last_idx = idx;
-        idx = idx->p_next;
-    }
+        int64_t i_pos;      /* page offset, -1 if unused */
+        int64_t i_sync_pos; /* searching a page from there lands on this one */
+        unsigned i_size;    /* 0 until the page data is known */
+        unsigned i_age;
+        uint8_t *p_data;
+    } pages[OGGSEEK_PAGE_CACHE_SIZE];
+    unsigned i_clock;
+};
+
+void oggseek_page_cache_free ( oggseek_page_cache_t *p_cache )
+{
+    if ( !p_cache ) return;
+    for ( int i = 0; i < OGGSEEK_PAGE_CACHE_SIZE; i++ )
+        free( p_cache->pages[i].p_data );
+    free( p_cache );
+}
+
+/* returns the slot for the page at i_pos, recycling the least recently used
+   one if the page is not cached yet and b_create is set */
+static int OggSeekCacheGet( demux_sys_t *p_sys, int64_t i_pos, bool b_create )
+{
+    oggseek_page_cache_t *p_cache = p_sys->p_page_cache;
+    int i_slot = -1;
 
-    /* new entry; insert after last_idx */
-    idx = index_entry_new();
-    if ( !idx ) return NULL;
-    if ( last_idx != NULL )
+    if ( !p_cache )
     {
-        idx->p_next = last_idx->p_next;
-        last_idx->p_next = idx;
-        idx->p_prev = last_idx;
+        if ( !b_create ) return -1;
+        p_cache = p_sys->p_page_cache = calloc( 1, sizeof( *p_cache ) );
+        if ( !p_cache ) return -1;
+        for ( int i = 0; i < OGGSEEK_PAGE_CACHE_SIZE; i++ )
+            p_cache->pages[i].i_pos = -1;
     }
-    else
+
+    for ( int i = 0; i < OGGSEEK_PAGE_CACHE_SIZE; i++ )
     {
-        idx->p_next = p_stream->idx;
-        p_stream->idx = idx;
+        if ( p_cache->pages[i].i_pos == i_pos )
+        {
+            i_slot = i;
+            break;
+        }
     }
 
-    if ( idx->p_next != NULL )
+    if ( i_slot == -1 )
     {
-        idx->p_next->p_prev = idx;
+        if ( !b_create ) return -1;
+        i_slot = 0;
+        for ( int i = 1; i < OGGSEEK_PAGE_CACHE_SIZE; i++ )
+        {
+            if ( p_cache->pages[i].i_age < p_cache->pages[i_slot].i_age )
+                i_slot = i;
+        }
+        p_cache->pages[i_slot].i_pos = i_pos;
+        p_cache->pages[i_slot].i_sync_pos = i_pos;
+        p_cache->pages[i_slot].i_size = 0;
     }
 
-    idx->i_value = i_timestamp;
-    idx->i_pagepos = i_pagepos;
-
-    return idx;
+    p_cache->pages[i_slot].i_age = ++p_cache->i_clock;
+    return i_slot;
 }
 
-static bool OggSeekIndexFind ( logical_stream_t *p_stream, int64_t i_timestamp,
-                               int64_t *pi_pos_lower, int64_t *pi_pos_upper )
+/* returns the offset of the first page at or after i_pos, if known */
+static int64_t OggSeekCacheFindSync( demux_sys_t *p_sys, int64_t i_pos )
 {
-    demux_index_entry_t *idx = p_stream->idx;
+    oggseek_page_cache_t *p_cache = p_sys->p_page_cache;
+    if ( !p_cache ) return -1;
 
-    while ( idx != NULL )
+    for ( int i = 0; i < OGGSEEK_PAGE_CACHE_SIZE; i++ )
     {
-        if ( idx->i_value <= i_timestamp )
+        if ( p_cache->pages[i].i_pos != -1 &&
+             p_cache->pages[i].i_sync_pos <= i_pos &&
+             p_cache->pages[i].i_pos >= i_pos )
         {
-            if ( !idx->p_next ) /* found on last index */
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                return true;
-            }
-            if ( idx->p_next->i_value > i_timestamp )
-            {
-                *pi_pos_lower = idx->i_pagepos;
-                *pi_pos_upper = idx->p_next->i_pagepos;
-                return true;
-            }
+            p_cache->pages[i].i_age = ++p_cache->i_clock;
+            return p_cache->pages[i].i_pos;
         }
-        idx = idx->p_next;
     }
-
-    return false;
+    return -1;
 }
 
 /*********************************************************************
@@ -193,6 +276,7 @@ static void seek_byte( demux_t *p_demux, int64_t i_pos )
         ogg_sync_reset( &p_sys->oy );
 
         p_sys->i_input_position = i_pos;
+        p_sys->i_page_pos = -1;
         p_sys->b_page_waiting = false;
     }
 }
@@ -231,6 +315,81 @@ static int64_t get_data( demux_t *p_demux, int64_t i_bytes_to_read )
     return i_result;
 }
 
+/* find the first page starting in [i_pos1, i_pos2), returns its offset or
+ * -1 if there is none */
+
+static int64_t OggSyncToPage( demux_t *p_demux, int64_t i_pos1, int64_t i_pos2 )
+{
+    demux_sys_t *p_sys  = p_demux->p_sys;
+    int64_t i_bytes_to_read = i_pos2 - i_pos1 + 1;
+    int64_t i_bytes_read;
+    int64_t i_result;
+    const int64_t i_sync_pos = i_pos1;
+
+    /* A previous search already went through this range */
+    int64_t i_cached = OggSeekCacheFindSync( p_sys, i_pos1 );
+    if ( i_cached != -1 )
+    {
+        if ( i_cached >= i_pos2 )
+            return -1;
+        p_sys->i_input_position = i_cached;
+        return i_cached;
+    }
+
+    seek_byte( p_demux, i_pos1 );
+
+    if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+
+    while ( 1 )
+    {
+
+        if ( p_sys->i_input_position >= i_pos2 )
+        {
+            /* we reached the end and found no pages */
+            return -1;
+        }
+
+        /* read next chunk */
+        if ( ! ( i_bytes_read = get_data( p_demux, i_bytes_to_read ) ) )
+        {
+            /* EOF */
+            return -1;
+        }
+
+        i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
+
+        i_result = ogg_sync_pageseek( &p_sys->oy, &p_sys->current_page );
+
+        if ( i_result < 0 )
+        {
+            /* found a page, sync to page start */
+            p_sys->i_input_position -= i_result;
+            continue;
+        }
+
+        if ( i_result > 0 || ( i_result == 0 && p_sys->oy.fill > 3 &&
+                               ! strncmp( (char *)p_sys->oy.data, "OggS" , 4 ) ) )
+        {
+            break;
+        }
+
+        p_sys->i_input_position += i_bytes_read;
+
+    };
+
+    /* Remember it, so that searching again from anywhere in between does not
+     * need to read anything */
+    int i_slot = OggSeekCacheGet( p_sys, p_sys->i_input_position, true );
+    if ( i_slot != -1 )
+    {
+        oggseek_page_cache_t *p_cache = p_sys->p_page_cache;
+        p_cache->pages[i_slot].i_sync_pos =
+            __MIN( p_cache->pages[i_slot].i_sync_pos, i_sync_pos );
+    }
+
+    return p_sys->i_input_position;
+}
+
 
 void Oggseek_ProbeEnd( demux_t *p_demux )
 {
@@ -331,59 +490,21 @@ static int64_t find_first_page_granule( demux_t *p_demux,
 {
     int64_t i_result;
     *i_granulepos = -1;
-    int64_t i_bytes_to_read = i_pos2 - i_pos1 + 1;
-    int64_t i_bytes_read;
     int64_t i_packets_checked;
 
     demux_sys_t *p_sys  = p_demux->p_sys;
 
     ogg_packet op;
 
-    seek_byte( p_demux, i_pos1 );
-
     if ( i_pos1 == p_stream->i_data_start )
-        return p_sys->i_input_position;
-
-    if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
-
-    while ( 1 )
     {
+        seek_byte( p_demux, i_pos1 );
+        return p_sys->i_input_position;
+    }
 
-        if ( p_sys->i_input_position >= i_pos2 )
-        {
-            /* we reached the end and found no pages */
-            return -1;
-        }
-
-        /* read next chunk */
-        if ( ! ( i_bytes_read = get_data( p_demux, i_bytes_to_read ) ) )
-        {
-            /* EOF */
-            return -1;
-        }
-
-        i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
-
-        i_result = ogg_sync_pageseek( &p_sys->oy, &p_sys->current_page );
-
-        if ( i_result < 0 )
-        {
-            /* found a page, sync to page start */
-            p_sys->i_input_position -= i_result;
-            i_pos1 = p_sys->i_input_position;
-            continue;
-        }
-
-        if ( i_result > 0 || ( i_result == 0 && p_sys->oy.fill > 3 &&
-                               ! strncmp( (char *)p_sys->oy.data, "OggS" , 4 ) ) )
-        {
-            i_pos1 = p_sys->i_input_position;
-            break;
-        }
-
-        p_sys->i_input_position += i_bytes_read;
-
-    };
+    i_pos1 = OggSyncToPage( p_demux, i_pos1, i_pos2 );
+    if ( i_pos1 == -1 )
+        return -1;
 
     seek_byte( p_demux, p_sys->i_input_position );
     ogg_stream_reset( &p_stream->os );
@@ -431,6 +552,10 @@ static int64_t find_first_page_granule( demux_t *p_demux,
         if ( i_packets_checked )
         {
             *i_granulepos = ogg_page_granulepos( &p_sys->current_page );
+            /* Learn from our probes, next seeks will start closer */
+            OggSeek_IndexAdd( p_stream,
+                              Oggseek_GranuleToAbsTimestamp( p_stream, *i_granulepos, false ),
+                              *i_granulepos, p_sys->i_input_position );
             return i_pos1;
         }
 
@@ -555,51 +680,16 @@ static int64_t OggForwardSeekToFrame( demux_t *p_demux, int64_t i_pos1, int64_t
                 logical_stream_t *p_stream, int64_t i_granulepos, bool b_fastseek )
 {
     int64_t i_result;
-    int64_t i_bytes_to_read;
-    int64_t i_bytes_read;
 
     demux_sys_t *p_sys  = p_demux->p_sys;
 
-    i_bytes_to_read = i_pos2 - i_pos1 + 1;
-    seek_byte( p_demux, i_pos1 );
-    if ( i_bytes_to_read > OGGSEEK_BYTES_TO_READ ) i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
-
     OggDebug(
         msg_Dbg( p_demux, "Probing Fwd %"PRId64" %"PRId64" for granule %"PRId64,
         i_pos1, i_pos2, i_granulepos );
     );
 
-    while ( 1 )
-    {
-
-        if ( p_sys->i_input_position >= i_pos2 )
-            return SEGMENT_NOT_FOUND;
-
-        /* read next chunk */
-        if ( ! ( i_bytes_read = get_data( p_demux, i_bytes_to_read ) ) )
-            return SEGMENT_NOT_FOUND;
-
-        i_bytes_to_read = OGGSEEK_BYTES_TO_READ;
-
-        i_result = ogg_sync_pageseek( &p_sys->oy, &p_sys->current_page );
-
-        if ( i_result < 0 )
-        {
-            /* found a page, sync to page start */
-            p_sys->i_input_position -= i_result;
-            i_pos1 = p_sys->i_input_position;
-            continue;
-        }
-
-        if ( i_result > 0 || ( i_result == 0 && p_sys->oy.fill > 3 &&
-                               ! strncmp( (char *)p_sys->oy.data, "OggS" , 4 ) ) )
-        {
-            i_pos1 = p_sys->i_input_position;
-            break;
-        }
-
-        p_sys->i_input_position += i_bytes_read;
-    };
+    if ( OggSyncToPage( p_demux, i_pos1, i_pos2 ) == -1 )
+        return SEGMENT_NOT_FOUND;
 
     seek_byte( p_demux, p_sys->i_input_position );
     ogg_stream_reset( &p_stream->os );
@@ -750,6 +840,46 @@ int64_t Oggseek_GranuleToAbsTimestamp( logical_stream_t *p_stream,
     return i_timestamp;
 }
 
+/* returns the pos to start decoding from to get the page found at i_pos
+ * (with i_granule) fully decoded */
+static int64_t OggSeekBackToKeyframe( demux_t *p_demux, logical_stream_t *p_stream,
+                                      int64_t i_pos, int64_t i_granule )
+{
+    int64_t i_pos_lower = __MAX ( i_pos - OGGSEEK_BYTES_TO_READ, p_stream->i_data_start );
+
+    if ( p_stream->b_oggds )
+    {
+        return OggBackwardSeekToFrame( p_demux, i_pos_lower, i_pos,
+                                       p_stream, i_granule /* unused */ );
+    }
+
+    /* If not each packet is usable as keyframe, query the codec for keyframe */
+    int64_t i_keyframegranule = Ogg_GetKeyframeGranule( p_stream, i_granule );
+    if ( i_keyframegranule == i_granule )
+        return i_pos;
+
+    int64_t i_keyframetime = Oggseek_GranuleToAbsTimestamp( p_stream, i_keyframegranule, false );
+
+    OggDebug( msg_Dbg( p_demux, "Need to reseek to keyframe (%"PRId64") granule (%"PRId64") to t=%"PRId64,
+                       i_keyframegranule >> p_stream->i_granule_shift,
+                       i_granule, i_keyframetime ) );
+
+    /* Any indexed page ending before the keyframe is a safe place to scan
+     * forward from. Use it when the index brackets the keyframe tightly, or
+     * when it is closer than our guess anyway */
+    int64_t i_idx_lower = -1, i_idx_upper = -1;
+    if ( i_keyframetime > 0 &&
+         OggSeekIndexFind( p_stream, i_keyframetime - 1, &i_idx_lower, &i_idx_upper ) &&
+         ( i_idx_lower >= i_pos_lower ||
+           ( i_idx_upper != -1 && i_idx_upper - i_idx_lower <= 2 * OGGSEEK_INDEX_SPACING ) ) )
+        i_pos_lower = __MAX( i_idx_lower, p_stream->i_data_start );
+
+    OggDebug( msg_Dbg( p_demux, "Seeking back to %"PRId64, i_pos_lower ) );
+
+    return OggBackwardSeekToFrame( p_demux, i_pos_lower, stream_Size( p_demux->s ),
+                                   p_stream, i_keyframegranule );
+}
+
 /* returns pos */
 static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stream,
             int64_t i_targettime, int64_t i_pos_lower, int64_t i_pos_upper)
@@ -860,34 +990,8 @@ static int64_t OggBisectSearchByTime( demux_t *p_demux, logical_stream_t *p_stre
             bestlower = lowestupper;
     }
 
-    if ( p_stream->b_oggds )
-    {
-        int64_t a = OggBackwardSeekToFrame( p_demux,
-                __MAX ( bestlower.i_pos - OGGSEEK_BYTES_TO_READ, p_stream->i_data_start ),
-                bestlower.i_pos,
-                p_stream, bestlower.i_granule /* unused */ );
-        return a;
-    }
-    /* If not each packet is usable as keyframe, query the codec for keyframe */
-    else if ( Ogg_GetKeyframeGranule( p_stream, bestlower.i_granule ) != bestlower.i_granule )
-    {
-        int64_t i_keyframegranule = Ogg_GetKeyframeGranule( p_stream, bestlower.i_granule );
-
-        OggDebug( msg_Dbg( p_demux, "Need to reseek to keyframe (%"PRId64") granule (%"PRId64"!=%"PRId64") to t=%"PRId64,
-                           i_keyframegranule >> p_stream->i_granule_shift,
-                           bestlower.i_granule,
-                           i_pos_upper,
-                           Oggseek_GranuleToAbsTimestamp( p_stream, i_keyframegranule, false ) ) );
-
-        OggDebug( msg_Dbg( p_demux, "Seeking back to %"PRId64, __MAX ( bestlower.i_pos - OGGSEEK_BYTES_TO_READ, p_stream->i_data_start ) ) );
-
-        int64_t a = OggBackwardSeekToFrame( p_demux,
-            __MAX ( bestlower.i_pos - OGGSEEK_BYTES_TO_READ, p_stream->i_data_start ),
-            stream_Size( p_demux->s ), p_stream, i_keyframegranule );
-        return a;
-    }
-
-    return bestlower.i_pos;
+    return OggSeekBackToKeyframe( p_demux, p_stream, bestlower.i_pos,
+                                  bestlower.i_granule );
 }
 
 
@@ -908,9 +1012,23 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( i_lowerpos != -1 ) b_found = true;
 
     /* And also search in our own index */
-    if ( !b_found && OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos ) )
+    int64_t i_search_lower = p_stream->i_data_start;
+    int64_t i_search_upper = p_sys->i_total_length;
+    if ( !b_found )
     {
-        b_found = true;
+        const demux_index_entry_t *p_entry =
+                OggSeekIndexFind( p_stream, i_time, &i_lowerpos, &i_upperpos );
+        if ( p_entry && b_fastseek )
+        {
+            /* Entries can be seconds apart: only narrow the search, which
+             * then takes one or two reads */
+            i_search_lower = i_lowerpos;
+            if ( i_upperpos != -1 )
+                i_search_upper = i_upperpos;
+            i_lowerpos = i_upperpos = -1;
+        }
+        else
+            b_found = ( p_entry != NULL );
     }
 
     /* Or try to be smart with audio fixed bitrate streams */
@@ -927,7 +1045,7 @@ int Oggseek_BlindSeektoAbsoluteTime( demux_t *p_demux, logical_stream_t *p_strea
     if ( !b_found && b_fastseek )
     {
         i_lowerpos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                            p_stream->i_data_start, p_sys->i_total_length );
+                                            i_search_lower, i_search_upper );
         b_found = ( i_lowerpos != -1 );
     }
 
@@ -1004,15 +1122,24 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
     }
     OggDebug( msg_Dbg( p_demux, "Search bounds set to %"PRId64" %"PRId64" using skeleton index", i_offset_lower, i_offset_upper ) );
 
+    /* Narrow the bounds using our own index */
+    const demux_index_entry_t *p_entry = NULL;
+    int64_t i_idx_lower = -1;
+    int64_t i_idx_upper = -1;
     OggNoDebug(
-        OggSeekIndexFind( p_stream, i_time, &i_offset_lower, &i_offset_upper )
+        p_entry = OggSeekIndexFind( p_stream, i_time, &i_idx_lower, &i_idx_upper )
     );
 
+    if ( p_entry )
+        i_offset_lower = __MAX( i_offset_lower, i_idx_lower );
+    if ( i_idx_upper != -1 && ( i_offset_upper == -1 || i_idx_upper < i_offset_upper ) )
+        i_offset_upper = i_idx_upper;
+
     i_offset_lower = __MAX( i_offset_lower, p_stream->i_data_start );
     i_offset_upper = __MIN( i_offset_upper, p_sys->i_total_length );
 
     int64_t i_pagepos = OggBisectSearchByTime( p_demux, p_stream, i_time,
-                                       i_offset_lower, i_offset_upper);
+                                               i_offset_lower, i_offset_upper );
     if ( i_pagepos >= 0 )
     {
         /* be sure to clear any state or read+pagein() will fail on same # */
@@ -1020,12 +1147,6 @@ int Oggseek_SeektoAbsolutetime( demux_t *p_demux, logical_stream_t *p_stream,
         p_sys->i_input_position = i_pagepos;
         seek_byte( p_demux, p_sys->i_input_position );
     }
-    /* Insert keyframe position into index */
-    OggNoDebug(
-    if ( i_pagepos >= p_stream->i_data_start )
-        OggSeek_IndexAdd( p_stream, i_time, i_pagepos )
-    );
-
     OggDebug( msg_Dbg( p_demux, "=================== Seeked To %"PRId64" time %"PRId64, i_pagepos, i_time ) );
     return i_pagepos;
 }
@@ -1059,6 +1180,29 @@ int64_t oggseek_read_page( demux_t *p_demux )
         return 0;
     }
 
+    /* Bisection probes the same pages again and again */
+    int i_slot = OggSeekCacheGet( p_sys, i_in_pos, true );
+    if ( i_slot != -1 && p_sys->p_page_cache->pages[i_slot].i_size )
+    {
+        const uint8_t *p_data = p_sys->p_page_cache->pages[i_slot].p_data;
+        i_page_size = p_sys->p_page_cache->pages[i_slot].i_size;
+
+        if ( vlc_stream_Seek( p_demux->s, i_in_pos + i_page_size ) == VLC_SUCCESS )
+        {
+            ogg_sync_reset( &p_ogg->oy );
+            buf = ogg_sync_buffer( &p_ogg->oy, i_page_size );
+            memcpy( buf, p_data, i_page_size );
+            ogg_sync_wrote( &p_ogg->oy, i_page_size );
+
+            if ( ogg_sync_pageout( &p_ogg->oy, &p_ogg->current_page ) == 1 )
+            {
+                p_sys->i_page_pos = i_in_pos;
+                return i_page_size;
+            }
+        }
+        vlc_stream_Seek( p_demux->s, i_in_pos );
+    }
+
     if ( vlc_stream_Read ( p_demux->s, header, PAGE_HEADER_BYTES ) < PAGE_HEADER_BYTES )
     {
         vlc_stream_Seek( p_demux->s, i_in_pos );
@@ -1103,6 +1247,23 @@ int64_t oggseek_read_page( demux_t *p_demux )
         return 0;
     }
 
+    p_sys->i_page_pos = i_in_pos;
+
+    /* Keep a copy for the next probes */
+    if ( i_slot != -1 && i_result + PAGE_HEADER_BYTES + i_nsegs == i_page_size )
+    {
+        oggseek_page_cache_t *p_cache = p_sys->p_page_cache;
+        uint8_t *p_data = realloc( p_cache->pages[i_slot].p_data, i_page_size );
+        if ( p_data )
+        {
+            memcpy( p_data, p_ogg->current_page.header, p_ogg->current_page.header_len );
+            memcpy( p_data + p_ogg->current_page.header_len,
+                    p_ogg->current_page.body, p_ogg->current_page.body_len );
+            p_cache->pages[i_slot].p_data = p_data;
+            p_cache->pages[i_slot].i_size = i_page_size;
+        }
+    }
+
     return i_result + PAGE_HEADER_BYTES + i_nsegs;
 }
 
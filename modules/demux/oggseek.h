@@ -30,23 +30,25 @@
 
 #define OGGSEEK_BYTES_TO_READ 8500
 
-/* index entries are structured as follows:
- *   - for theora, highest granulepos -> pagepos (bytes) where keyframe begins
- *  - for dirac, kframe (sync point) -> pagepos of sequence start (?)
+/* minimum distance between two index entries; the span left between two
+ * entries is covered by one or two reads */
+#define OGGSEEK_INDEX_SPACING OGGSEEK_BYTES_TO_READ
+
+/* number of pages kept in the page cache */
+#define OGGSEEK_PAGE_CACHE_SIZE 8
+
+/* index entries map the end time of a page to its position in the
+ * physical bitstream. Both increase together within a logical stream, so
+ * the index can be bisected on either of them.
  */
 
 /* this is typedefed to demux_index_entry_t in ogg.h */
 struct oggseek_index_entry
 {
-    demux_index_entry_t *p_next;
-    demux_index_entry_t *p_prev;
-
-    /* value is highest granulepos for theora, sync frame for dirac */
+    /* absolute timestamp of the last packet ending in the page */
     int64_t i_value;
+    int64_t i_granule;
     int64_t i_pagepos;
-
-    /* not used for theora because the granulepos tells us this */
-    int64_t i_pagepos_end;
 };
 
 int64_t Ogg_GetKeyframeGranule ( logical_stream_t *p_stream, int64_t i_granule );
@@ -57,9 +59,11 @@ int64_t Oggseek_GranuleToAbsTimestamp ( logical_stream_t *p_stream, int64_t i_gr
 int     Oggseek_BlindSeektoAbsoluteTime ( demux_t *, logical_stream_t *, int64_t, bool );
 int     Oggseek_BlindSeektoPosition ( demux_t *, logical_stream_t *, double f, bool );
 int     Oggseek_SeektoAbsolutetime ( demux_t *, logical_stream_t *, int64_t i_granulepos );
-const demux_index_entry_t *OggSeek_IndexAdd ( logical_stream_t *, int64_t, int64_t );
+bool    OggSeek_IndexAdd ( logical_stream_t *, int64_t i_timestamp,
+                           int64_t i_granule, int64_t i_pagepos );
 void    Oggseek_ProbeEnd( demux_t * );
 
 void oggseek_index_entries_free ( demux_index_entry_t * );
+void oggseek_page_cache_free ( oggseek_page_cache_t * );
 
 int64_t oggseek_read_page ( demux_t * );
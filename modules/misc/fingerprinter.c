@@ -26,6 +26,7 @@
 #include <vlc_common.h>
 #include <vlc_plugin.h>
 #include <vlc_stream.h>
+#include <vlc_threads.h>
 #include <vlc_modules.h>
 #include <vlc_meta.h>
 #include <vlc_url.h>
@@ -42,21 +43,30 @@
 
 struct fingerprinter_sys_t
 {
-    vlc_thread_t thread;
+    vlc_thread_t *p_threads;
+    unsigned i_threads;
+    unsigned i_duration; /* seconds decoded from the start of each track */
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-    } incoming, results;
+        vlc_cond_t          cond;
+    } incoming;
 
     struct
     {
         vlc_array_t         queue;
         vlc_mutex_t         lock;
-        vlc_cond_t          cond;
-        bool                b_working;
-    } processing;
+    } results;
+};
+
+/* Decoding of one track */
+struct fingerprinter_session_t
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  cond;
+    bool        b_working;
 };
 
 static int  Open            (vlc_object_t *);
@@ -67,12 +77,25 @@ static void *Run(void *);
 /*****************************************************************************
  * Module descriptor
  ****************************************************************************/
+#define THREADS_TEXT N_("Parallel fingerprints")
+#define THREADS_LONGTEXT N_("Number of tracks decoded at the same time " \
+    "(0 for one per CPU).")
+#define DURATION_TEXT N_("Fingerprinted duration")
+#define DURATION_LONGTEXT N_("Seconds of audio decoded from the start of " \
+    "each track. The rest of the track is skipped.")
+
 vlc_module_begin ()
     set_category(CAT_ADVANCED)
     set_subcategory(SUBCAT_ADVANCED_MISC)
     set_shortname(N_("acoustid"))
     set_description(N_("Track fingerprinter (based on Acoustid)"))
     set_capability("fingerprinter", 10)
+    add_integer("fingerprinter-threads", 0, THREADS_TEXT, THREADS_LONGTEXT,
+                true)
+        change_integer_range(0, 64)
+    add_integer("fingerprinter-duration", 90, DURATION_TEXT,
+                DURATION_LONGTEXT, true)
+        change_integer_range(10, 600)
     set_callbacks(Open, Close)
 vlc_module_end ()
 
@@ -85,19 +108,23 @@ static void EnqueueRequest( fingerprinter_thread_t *f, fingerprint_request_t *r
     fingerprinter_sys_t *p_sys = f->p_sys;
     vlc_mutex_lock( &p_sys->incoming.lock );
     vlc_array_append( &p_sys->incoming.queue, r );
+    vlc_cond_signal( &p_sys->incoming.cond );
     vlc_mutex_unlock( &p_sys->incoming.lock );
 }
 
-static void QueueIncomingRequests( fingerprinter_sys_t *p_sys )
+static fingerprint_request_t *DequeueRequest( fingerprinter_sys_t *p_sys )
 {
-    vlc_mutex_lock( &p_sys->incoming.lock );
-    size_t i = vlc_array_count( &p_sys->incoming.queue );
+    fingerprint_request_t *r;
 
-    while( i )
-        vlc_array_append( &p_sys->processing.queue,
-                          vlc_array_item_at_index( &p_sys->incoming.queue, --i ) );
-    vlc_array_clear( &p_sys->incoming.queue );
-    vlc_mutex_unlock(&p_sys->incoming.lock);
+    vlc_mutex_lock( &p_sys->incoming.lock );
+    mutex_cleanup_push( &p_sys->incoming.lock );
+    while( vlc_array_count( &p_sys->incoming.queue ) == 0 )
+        vlc_cond_wait( &p_sys->incoming.cond, &p_sys->incoming.lock );
+    r = vlc_array_item_at_index( &p_sys->incoming.queue, 0 );
+    vlc_array_remove( &p_sys->incoming.queue, 0 );
+    vlc_cleanup_pop();
+    vlc_mutex_unlock( &p_sys->incoming.lock );
+    return r;
 }
 
 static fingerprint_request_t * GetResult( fingerprinter_thread_t *f )
@@ -133,15 +160,15 @@ static int InputEventHandler( vlc_object_t *p_this, char const *psz_cmd,
     VLC_UNUSED( psz_cmd );
     VLC_UNUSED( oldval );
     input_thread_t *p_input = (input_thread_t *) p_this;
-    fingerprinter_sys_t *p_sys = (fingerprinter_sys_t *) p_data;
+    struct fingerprinter_session_t *p_session = p_data;
     if( newval.i_int == INPUT_EVENT_STATE )
     {
         if( var_GetInteger( p_input, "state" ) >= PAUSE_S )
         {
-            vlc_mutex_lock( &p_sys->processing.lock );
-            p_sys->processing.b_working = false;
-            vlc_cond_signal( &p_sys->processing.cond );
-            vlc_mutex_unlock( &p_sys->processing.lock );
+            vlc_mutex_lock( &p_session->lock );
+            p_session->b_working = false;
+            vlc_cond_signal( &p_session->cond );
+            vlc_mutex_unlock( &p_session->lock );
         }
     }
     return VLC_SUCCESS;
@@ -155,12 +182,15 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     if ( unlikely(p_item == NULL) )
          return;
 
+    const unsigned i_duration = p_fingerprinter->p_sys->i_duration;
     char *psz_sout_option;
-    /* Note: need at -max- 2 channels, but we can't guess it before playing */
-    /* the stereo upmix could make the mono tracks fingerprint to differ :/ */
+    /* Chromaprint mixes down to mono at its own rate: do it right after the
+     * decoder, so that the transcoder and chromaprint handle the least data */
     if ( asprintf( &psz_sout_option,
-                   "sout=#transcode{acodec=%s,channels=2}:chromaprint",
-                   ( VLC_CODEC_S16L == VLC_CODEC_S16N ) ? "s16l" : "s16b" )
+                   "sout=#transcode{acodec=%s,channels=1,samplerate=%u}"
+                   ":chromaprint",
+                   ( VLC_CODEC_S16L == VLC_CODEC_S16N ) ? "s16l" : "s16b",
+                   CHROMAPRINT_SAMPLE_RATE )
          == -1 )
     {
         input_item_Release( p_item );
@@ -171,16 +201,25 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     free( psz_sout_option );
     input_item_AddOption( p_item, "vout=dummy", VLC_INPUT_OPTION_TRUSTED );
     input_item_AddOption( p_item, "aout=dummy", VLC_INPUT_OPTION_TRUSTED );
-    if ( fp->i_duration )
+    input_item_AddOption( p_item, "no-sout-video", VLC_INPUT_OPTION_TRUSTED );
+    input_item_AddOption( p_item, "no-sout-spu", VLC_INPUT_OPTION_TRUSTED );
+
+    /* Stop demuxing once chromaprint has enough, allowing for the latency
+     * of the decoder and resampler */
+    if ( asprintf( &psz_sout_option, "duration=%u", i_duration ) == -1 )
     {
-        if ( asprintf( &psz_sout_option, "stop-time=%u", fp->i_duration ) == -1 )
-        {
-            input_item_Release( p_item );
-            return;
-        }
-        input_item_AddOption( p_item, psz_sout_option, VLC_INPUT_OPTION_TRUSTED );
-        free( psz_sout_option );
+        input_item_Release( p_item );
+        return;
     }
+    input_item_AddOption( p_item, psz_sout_option, VLC_INPUT_OPTION_TRUSTED );
+    free( psz_sout_option );
+    if ( asprintf( &psz_sout_option, "stop-time=%u", i_duration + 1 ) == -1 )
+    {
+        input_item_Release( p_item );
+        return;
+    }
+    input_item_AddOption( p_item, psz_sout_option, VLC_INPUT_OPTION_TRUSTED );
+    free( psz_sout_option );
     input_item_SetURI( p_item, psz_uri ) ;
 
     input_thread_t *p_input = input_Create( p_fingerprinter, p_item, "fingerprinter", NULL );
@@ -197,29 +236,41 @@ static void DoFingerprint( fingerprinter_thread_t *p_fingerprinter,
     var_Create( p_input, "fingerprint-data", VLC_VAR_ADDRESS );
     var_SetAddress( p_input, "fingerprint-data", &chroma_fingerprint );
 
-    var_AddCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+    struct fingerprinter_session_t session;
+
+    vlc_mutex_init( &session.lock );
+    vlc_cond_init( &session.cond );
+    session.b_working = true;
+
+    var_AddCallback( p_input, "intf-event", InputEventHandler, &session );
 
     if( input_Start( p_input ) != VLC_SUCCESS )
     {
-        var_DelCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+        var_DelCallback( p_input, "intf-event", InputEventHandler, &session );
         input_Close( p_input );
     }
     else
     {
-        p_fingerprinter->p_sys->processing.b_working = true;
-        while( p_fingerprinter->p_sys->processing.b_working )
-        {
-            vlc_cond_wait( &p_fingerprinter->p_sys->processing.cond,
-                           &p_fingerprinter->p_sys->processing.lock );
-        }
-        var_DelCallback( p_input, "intf-event", InputEventHandler, p_fingerprinter->p_sys );
+        vlc_mutex_lock( &session.lock );
+        while( session.b_working )
+            vlc_cond_wait( &session.cond, &session.lock );
+        vlc_mutex_unlock( &session.lock );
+
+        var_DelCallback( p_input, "intf-event", InputEventHandler, &session );
         input_Stop( p_input );
+
+        /* Only the start of the track was decoded: take its length from
+         * the demuxer unless the caller gave a hint */
+        mtime_t i_length = input_item_GetDuration( input_GetItem( p_input ) );
         input_Close( p_input );
 
         fp->psz_fingerprint = chroma_fingerprint.psz_fingerprint;
         if( !fp->i_duration ) /* had not given hint */
-            fp->i_duration = chroma_fingerprint.i_duration;
+            fp->i_duration = i_length > 0 ? i_length / CLOCK_FREQ
+                                          : chroma_fingerprint.i_duration;
     }
+    vlc_cond_destroy( &session.cond );
+    vlc_mutex_destroy( &session.lock );
 }
 
 /*****************************************************************************
@@ -237,10 +288,7 @@ static int Open(vlc_object_t *p_this)
 
     vlc_array_init( &p_sys->incoming.queue );
     vlc_mutex_init( &p_sys->incoming.lock );
-
-    vlc_array_init( &p_sys->processing.queue );
-    vlc_mutex_init( &p_sys->processing.lock );
-    vlc_cond_init( &p_sys->processing.cond );
+    vlc_cond_init( &p_sys->incoming.cond );
 
     vlc_array_init( &p_sys->results.queue );
     vlc_mutex_init( &p_sys->results.lock );
@@ -249,17 +297,34 @@ static int Open(vlc_object_t *p_this)
     p_fingerprinter->pf_getresults = GetResult;
     p_fingerprinter->pf_apply = ApplyResult;
 
-    var_Create( p_fingerprinter, "results-available", VLC_VAR_BOOL );
-    if( vlc_clone( &p_sys->thread, Run, p_fingerprinter,
-                   VLC_THREAD_PRIORITY_LOW ) )
-    {
-        msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
+    p_sys->i_duration = var_InheritInteger( p_fingerprinter,
+                                            "fingerprinter-duration" );
+    unsigned i_threads = var_InheritInteger( p_fingerprinter,
+                                             "fingerprinter-threads" );
+    if( i_threads == 0 )
+        i_threads = vlc_GetCPUCount();
+
+    p_sys->p_threads = malloc( i_threads * sizeof (*p_sys->p_threads) );
+    if( unlikely(p_sys->p_threads == NULL) )
         goto error;
-    }
+
+    var_Create( p_fingerprinter, "results-available", VLC_VAR_BOOL );
+    for( ; p_sys->i_threads < i_threads; p_sys->i_threads++ )
+        if( vlc_clone( &p_sys->p_threads[p_sys->i_threads], Run,
+                       p_fingerprinter, VLC_THREAD_PRIORITY_LOW ) )
+        {
+            msg_Err( p_fingerprinter, "cannot spawn fingerprinter thread" );
+            if( p_sys->i_threads == 0 )
+                goto error;
+            break;
+        }
+    msg_Dbg( p_fingerprinter, "fingerprinting %u tracks at a time, "
+             "%u seconds each", p_sys->i_threads, p_sys->i_duration );
 
     return VLC_SUCCESS;
 
 error:
+    free( p_sys->p_threads );
     CleanSys( p_sys );
     free( p_sys );
     return VLC_EGENERIC;
@@ -273,8 +338,11 @@ static void Close(vlc_object_t *p_this)
     fingerprinter_thread_t   *p_fingerprinter = (fingerprinter_thread_t*) p_this;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_cancel( p_sys->thread );
-    vlc_join( p_sys->thread, NULL );
+    for( unsigned i = 0; i < p_sys->i_threads; i++ )
+        vlc_cancel( p_sys->p_threads[i] );
+    for( unsigned i = 0; i < p_sys->i_threads; i++ )
+        vlc_join( p_sys->p_threads[i], NULL );
+    free( p_sys->p_threads );
 
     CleanSys( p_sys );
     free( p_sys );
@@ -286,12 +354,7 @@ static void CleanSys( fingerprinter_sys_t *p_sys )
         fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->incoming.queue, i ) );
     vlc_array_clear( &p_sys->incoming.queue );
     vlc_mutex_destroy( &p_sys->incoming.lock );
-
-    for ( size_t i = 0; i < vlc_array_count( &p_sys->processing.queue ); i++ )
-        fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->processing.queue, i ) );
-    vlc_array_clear( &p_sys->processing.queue );
-    vlc_mutex_destroy( &p_sys->processing.lock );
-    vlc_cond_destroy( &p_sys->processing.cond );
+    vlc_cond_destroy( &p_sys->incoming.cond );
 
     for ( size_t i = 0; i < vlc_array_count( &p_sys->results.queue ); i++ )
         fingerprint_request_Delete( vlc_array_item_at_index( &p_sys->results.queue, i ) );
@@ -320,69 +383,51 @@ static void fill_metas_with_results( fingerprint_request_t *p_r, acoustid_finger
 }
 
 /*****************************************************************************
- * Run :
+ * Run : one worker of the pool, fingerprinting one track at a time
  *****************************************************************************/
 static void *Run( void *opaque )
 {
     fingerprinter_thread_t *p_fingerprinter = opaque;
     fingerprinter_sys_t *p_sys = p_fingerprinter->p_sys;
 
-    vlc_mutex_lock( &p_sys->processing.lock );
-    mutex_cleanup_push( &p_sys->processing.lock );
-
     /* main loop */
     for (;;)
     {
-        msleep( CLOCK_FREQ );
-
-        QueueIncomingRequests( p_sys );
+        fingerprint_request_t *p_data = DequeueRequest( p_sys );
 
-        vlc_testcancel();
+        int canc = vlc_savecancel();
 
-        for ( size_t i = 0 ; i < vlc_array_count( &p_sys->processing.queue ); i++ )
+        char *psz_uri = input_item_GetURI( p_data->p_item );
+        if ( psz_uri != NULL )
         {
-            int canc = vlc_savecancel();
-            fingerprint_request_t *p_data = vlc_array_item_at_index( &p_sys->processing.queue, i );
+            acoustid_fingerprint_t acoustid_print;
 
-            char *psz_uri = input_item_GetURI( p_data->p_item );
-            if ( psz_uri != NULL )
-            {
-                 acoustid_fingerprint_t acoustid_print;
-
-                 memset( &acoustid_print , 0, sizeof (acoustid_print) );
-                /* overwrite with hint, as in this case, fingerprint's session will be truncated */
-                if ( p_data->i_duration )
-                     acoustid_print.i_duration = p_data->i_duration;
+            memset( &acoustid_print , 0, sizeof (acoustid_print) );
+            /* overwrite with hint, as in this case, fingerprint's session will be truncated */
+            if ( p_data->i_duration )
+                acoustid_print.i_duration = p_data->i_duration;
 
-                DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
-                free( psz_uri );
+            DoFingerprint( p_fingerprinter, &acoustid_print, psz_uri );
+            free( psz_uri );
 
-                DoAcoustIdWebRequest( VLC_OBJECT(p_fingerprinter), &acoustid_print );
-                fill_metas_with_results( p_data, &acoustid_print );
+            DoAcoustIdWebRequest( VLC_OBJECT(p_fingerprinter), &acoustid_print );
+            fill_metas_with_results( p_data, &acoustid_print );
 
-                for( unsigned j = 0; j < acoustid_print.results.count; j++ )
-                     free_acoustid_result_t( &acoustid_print.results.p_results[j] );
-                if( acoustid_print.results.count )
-                    free( acoustid_print.results.p_results );
-                free( acoustid_print.psz_fingerprint );
-            }
-            vlc_restorecancel(canc);
-
-            /* copy results */
-            vlc_mutex_lock( &p_sys->results.lock );
-            vlc_array_append( &p_sys->results.queue, p_data );
-            vlc_mutex_unlock( &p_sys->results.lock );
-
-            vlc_testcancel();
+            for( unsigned j = 0; j < acoustid_print.results.count; j++ )
+                free_acoustid_result_t( &acoustid_print.results.p_results[j] );
+            if( acoustid_print.results.count )
+                free( acoustid_print.results.p_results );
+            free( acoustid_print.psz_fingerprint );
         }
 
-        if ( vlc_array_count( &p_sys->processing.queue ) )
-        {
-            var_TriggerCallback( p_fingerprinter, "results-available" );
-            vlc_array_clear( &p_sys->processing.queue );
-        }
+        /* copy results */
+        vlc_mutex_lock( &p_sys->results.lock );
+        vlc_array_append( &p_sys->results.queue, p_data );
+        vlc_mutex_unlock( &p_sys->results.lock );
+
+        var_TriggerCallback( p_fingerprinter, "results-available" );
+        vlc_restorecancel(canc);
     }
 
-    vlc_cleanup_pop();
     vlc_assert_unreachable();
 }
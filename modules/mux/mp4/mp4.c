@@ -33,8 +33,10 @@
 #include <vlc_plugin.h>
 #include <vlc_sout.h>
 #include <vlc_block.h>
+#include <vlc_fs.h>
 
 #include <assert.h>
+#include <errno.h>
 #include <time.h>
 
 #include <vlc_iso_lang.h>
@@ -53,12 +55,32 @@
     "\"Fast Start\" files are optimized for downloads and allow the user " \
     "to start previewing the file while it is downloading.")
 
+#define RESERVE_TEXT N_("Expected duration for moov reservation")
+#define RESERVE_LONGTEXT N_(\
+    "Expected duration of the recording, in seconds. When set, space for " \
+    "the \"Fast Start\" index is reserved at the start of the file, from " \
+    "the tracks frame rates and bitrates, so the file does not need to be " \
+    "rewritten when closing. 0 disables the reservation.")
+
+#define SIDECAR_TEXT N_("Write a sidecar index when the reservation is too small")
+#define SIDECAR_LONGTEXT N_(\
+    "When the reserved space is too small, the index is written at the end " \
+    "of the file and a \".moov\" sidecar file is created. Concatenating it " \
+    "with the mdat range of the file gives a \"Fast Start\" file.")
+
+#define FRAGLEN_TEXT N_("Fragment duration")
+#define FRAGLEN_LONGTEXT N_(\
+    "Target duration of fragments, in milliseconds. Fragments are cut " \
+    "earlier to start on keyframes. Use short fragments for chunked " \
+    "low latency delivery.")
+
 static int  Open   (vlc_object_t *);
 static void Close  (vlc_object_t *);
 static int  OpenFrag   (vlc_object_t *);
 static void CloseFrag  (vlc_object_t *);
 
 #define SOUT_CFG_PREFIX "sout-mp4-"
+#define SOUT_CFG_PREFIX_FRAG "sout-mp4frag-"
 
 vlc_module_begin ()
     set_description(N_("MP4/MOV muxer"))
@@ -69,6 +91,11 @@ vlc_module_begin ()
     add_bool(SOUT_CFG_PREFIX "faststart", true,
               FASTSTART_TEXT, FASTSTART_LONGTEXT,
               true)
+    add_integer(SOUT_CFG_PREFIX "moov-reserve", 0,
+                RESERVE_TEXT, RESERVE_LONGTEXT, true)
+        change_integer_range(0, 7 * 24 * 3600)
+    add_bool(SOUT_CFG_PREFIX "moov-sidecar", true,
+             SIDECAR_TEXT, SIDECAR_LONGTEXT, true)
     set_capability("sout mux", 5)
     add_shortcut("mp4", "mov", "3gp")
     set_callbacks(Open, Close)
@@ -79,6 +106,9 @@ add_submodule ()
     set_subcategory(SUBCAT_SOUT_MUX)
     set_shortname("MP4 Frag")
     add_shortcut("mp4frag", "mp4stream")
+    add_integer(SOUT_CFG_PREFIX_FRAG "fragment-duration", 1500,
+                FRAGLEN_TEXT, FRAGLEN_LONGTEXT, true)
+        change_integer_range(40, 60000)
     set_capability("sout mux", 0)
     set_callbacks(OpenFrag, CloseFrag)
 
@@ -88,7 +118,11 @@ vlc_module_end ()
  * Exported prototypes
  *****************************************************************************/
 static const char *const ppsz_sout_options[] = {
-    "faststart", NULL
+    "faststart", "moov-reserve", "moov-sidecar", NULL
+};
+
+static const char *const ppsz_sout_frag_options[] = {
+    "fragment-duration", NULL
 };
 
 static int Control(sout_mux_t *, int, va_list);
@@ -158,6 +192,12 @@ struct sout_mux_sys_t
     bool b_64_ext;
     bool b_fast_start;
 
+    /* reserved moov space, faststart without rewriting */
+    mtime_t  i_reserve_duration;
+    uint64_t i_reserve_pos;
+    uint64_t i_reserve_size;
+    bool     b_mdat_sent;
+
     uint64_t i_mdat_pos;
     uint64_t i_pos;
     mtime_t  i_read_duration;
@@ -170,11 +210,14 @@ struct sout_mux_sys_t
     bool           b_fragmented;
     bool           b_header_sent;
     mtime_t        i_written_duration;
+    mtime_t        i_fragment_length;
     uint32_t       i_mfhd_sequence;
 };
 
 static void box_send(sout_mux_t *p_mux,  bo_t *box);
+static bo_t *BuildFtyp(const sout_mux_sys_t *p_sys);
 static bo_t *BuildMoov(sout_mux_t *p_mux);
+static int WriteMdatHeader(sout_mux_t *p_mux);
 
 static block_t *ConvertSUBT(block_t *);
 static bool CreateCurrentEdit(mp4_stream_t *, mtime_t, bool);
@@ -208,20 +251,17 @@ static int Open(vlc_object_t *p_this)
     p_sys->i_read_duration   = 0;
     p_sys->i_start_dts = VLC_TS_INVALID;
     p_sys->b_fragmented = false;
+    p_sys->b_mdat_sent  = false;
+    p_sys->i_reserve_pos  = 0;
+    p_sys->i_reserve_size = 0;
+    p_sys->i_reserve_duration = 0;
+    if (var_GetBool(p_mux, SOUT_CFG_PREFIX "faststart"))
+        p_sys->i_reserve_duration = CLOCK_FREQ *
+                var_GetInteger(p_mux, SOUT_CFG_PREFIX "moov-reserve");
 
     if (!p_sys->b_mov) {
         /* Now add ftyp header */
-        if(p_sys->b_3gp)
-        {
-            vlc_fourcc_t extra[] = {MAJOR_3gp4, MAJOR_avc1};
-            box = mp4mux_GetFtyp(MAJOR_3gp6, 0, extra, ARRAY_SIZE(extra));
-        }
-        else
-        {
-            vlc_fourcc_t extra[] = {MAJOR_mp41, MAJOR_avc1};
-            box = mp4mux_GetFtyp(MAJOR_isom, 0, extra, ARRAY_SIZE(extra));
-        }
-
+        box = BuildFtyp(p_sys);
         if(!box)
         {
             free(p_sys);
@@ -237,23 +277,220 @@ static int Open(vlc_object_t *p_this)
      * Quicktime actually doesn't like the 64 bits extensions !!! */
     p_sys->b_64_ext = false;
 
-    /* Now add mdat header */
-    box = box_new("mdat");
-    if(!box)
+    /* The moov reservation depends on the tracks, the mdat header
+     * is then written once all of them are known */
+    if (p_sys->i_reserve_duration == 0 && WriteMdatHeader(p_mux) != VLC_SUCCESS)
     {
         free(p_sys);
         return VLC_ENOMEM;
     }
+
+    return VLC_SUCCESS;
+}
+
+static bo_t *BuildFtyp(const sout_mux_sys_t *p_sys)
+{
+    if(p_sys->b_3gp)
+    {
+        vlc_fourcc_t extra[] = {MAJOR_3gp4, MAJOR_avc1};
+        return mp4mux_GetFtyp(MAJOR_3gp6, 0, extra, ARRAY_SIZE(extra));
+    }
+    else
+    {
+        vlc_fourcc_t extra[] = {MAJOR_mp41, MAJOR_avc1};
+        return mp4mux_GetFtyp(MAJOR_isom, 0, extra, ARRAY_SIZE(extra));
+    }
+}
+
+/* Worst case moov bytes per sample: stsz, co64, stts, ctts, stss, stsc */
+#define MOOV_VIDEO_SAMPLE_SIZE 36
+#define MOOV_OTHER_SAMPLE_SIZE 24
+#define MOOV_TRACK_SIZE        2048
+
+static uint64_t EstimateMoovSize(sout_mux_t *p_mux)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    const uint64_t i_duration = p_sys->i_reserve_duration / CLOCK_FREQ;
+    uint64_t i_size = MOOV_TRACK_SIZE;
+    uint64_t i_bitrate = 0;
+    bool b_bitrate_known = true;
+
+    for (unsigned int i = 0; i < p_sys->i_nb_streams; i++)
+    {
+        const es_format_t *p_fmt = &p_sys->pp_streams[i]->mux.fmt;
+        uint64_t i_samples; /* per 1000s */
+
+        switch (p_fmt->i_cat)
+        {
+        case VIDEO_ES:
+            i_samples = 1000 * p_fmt->video.i_frame_rate /
+                        p_fmt->video.i_frame_rate_base;
+            i_size += i_duration * i_samples / 1000 * MOOV_VIDEO_SAMPLE_SIZE;
+            break;
+        case AUDIO_ES:
+        {
+            unsigned i_frame_length = p_fmt->audio.i_frame_length;
+            if (i_frame_length == 0)
+            {
+                switch (p_fmt->i_codec)
+                {
+                case VLC_CODEC_MPGA:
+                case VLC_CODEC_MP3:    i_frame_length = 1152; break;
+                case VLC_CODEC_A52:
+                case VLC_CODEC_EAC3:   i_frame_length = 1536; break;
+                case VLC_CODEC_DTS:    i_frame_length = 512;  break;
+                case VLC_CODEC_AMR_NB:
+                case VLC_CODEC_AMR_WB: i_frame_length = p_fmt->audio.i_rate / 50; break;
+                default:               i_frame_length = 1024; break;
+                }
+            }
+            i_samples = 1000 * p_fmt->audio.i_rate / __MAX(i_frame_length, 1);
+            i_size += i_duration * i_samples / 1000 * MOOV_OTHER_SAMPLE_SIZE;
+            break;
+        }
+        default:
+            /* subtitles and their clearing samples */
+            i_size += i_duration * 2 * MOOV_OTHER_SAMPLE_SIZE;
+            break;
+        }
+
+        i_size += MOOV_TRACK_SIZE;
+        if (p_fmt->i_bitrate)
+            i_bitrate += p_fmt->i_bitrate;
+        else
+            b_bitrate_known = false;
+    }
+
+    /* 32 bits chunk offsets are enough when the file stays below 4GB */
+    if (b_bitrate_known && i_bitrate * i_duration / 8 < (UINT64_C(1) << 32))
+        i_size -= i_size / 9;
+
+    /* safety margin */
+    return i_size + i_size / 8;
+}
+
+static int WriteMdatHeader(sout_mux_t *p_mux)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    bo_t *box;
+
+    if (p_sys->i_reserve_duration)
+    {
+        /* Reserve space for the moov as a free box */
+        p_sys->i_reserve_pos  = p_sys->i_pos;
+        p_sys->i_reserve_size = EstimateMoovSize(p_mux);
+        msg_Dbg(p_mux, "reserving %"PRIu64" bytes for moov", p_sys->i_reserve_size);
+
+        for (uint64_t i_left = p_sys->i_reserve_size; i_left > 0; )
+        {
+            size_t i_chunk = __MIN(i_left, 65536);
+            block_t *p_free = block_Alloc(i_chunk);
+            if (!p_free)
+                return VLC_ENOMEM;
+            memset(p_free->p_buffer, 0, i_chunk);
+            if (i_left == p_sys->i_reserve_size)
+            {
+                SetDWBE(p_free->p_buffer, p_sys->i_reserve_size);
+                memcpy(&p_free->p_buffer[4], "free", 4);
+            }
+            sout_AccessOutWrite(p_mux->p_access, p_free);
+            i_left -= i_chunk;
+        }
+        p_sys->i_pos += p_sys->i_reserve_size;
+        p_sys->i_mdat_pos = p_sys->i_pos;
+    }
+
+    /* Now add mdat header */
+    box = box_new("mdat");
+    if(!box)
+        return VLC_ENOMEM;
     bo_add_64be  (box, 0); // enough to store an extended size
 
     if(box->b)
         p_sys->i_pos += box->b->i_buffer;
 
     box_send(p_mux, box);
+    p_sys->b_mdat_sent = true;
 
     return VLC_SUCCESS;
 }
 
+/*****************************************************************************
+ * ShiftChunkOffsets: relocate the samples to chunks table in a MOOV header
+ *****************************************************************************/
+static void ShiftChunkOffsets(sout_mux_sys_t *p_sys, bo_t *moov, bool b_stco64,
+                              int64_t i_shift)
+{
+    for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++) {
+        mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
+        unsigned i_written = 0;
+        for (unsigned i = 0; i < p_stream->mux.i_entry_count; ) {
+            mp4mux_entry_t *entry = p_stream->mux.entry;
+            if (b_stco64)
+                bo_set_64be(moov, p_stream->mux.i_stco_pos + i_written++ * 8, entry[i].i_pos + i_shift);
+            else
+                bo_set_32be(moov, p_stream->mux.i_stco_pos + i_written++ * 4, entry[i].i_pos + i_shift);
+
+            for (; i < p_stream->mux.i_entry_count; i++)
+                if (i >= p_stream->mux.i_entry_count - 1 ||
+                    entry[i].i_pos + entry[i].i_size != entry[i+1].i_pos) {
+                    i++;
+                    break;
+                }
+        }
+    }
+}
+
+/*****************************************************************************
+ * WriteSidecar: write ftyp and moov, relocated for the mdat, next to the
+ * output file. sidecar + file[mdat_pos, moov_pos) is a "fast start" file.
+ *****************************************************************************/
+static void WriteSidecar(sout_mux_t *p_mux, bo_t *moov, bool b_stco64)
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+    sout_access_out_t *p_access = p_mux->p_access;
+    char *psz_sidecar;
+
+    if (!p_access->psz_path || strcmp(p_access->psz_access, "file") ||
+        asprintf(&psz_sidecar, "%s.moov", p_access->psz_path) < 0)
+    {
+        msg_Warn(p_mux, "cannot write a sidecar moov for this output");
+        return;
+    }
+
+    bo_t *ftyp = p_sys->b_mov ? NULL : BuildFtyp(p_sys);
+    const uint64_t i_header = (ftyp && ftyp->b ? ftyp->b->i_buffer : 0) +
+                              moov->b->i_buffer;
+
+    /* moov is written at the end of the file afterwards, so work on a copy */
+    bo_t sidecar_moov = { .b = block_Duplicate(moov->b), .basesize = moov->basesize };
+    if (!sidecar_moov.b)
+        goto end;
+    ShiftChunkOffsets(p_sys, &sidecar_moov, b_stco64,
+                      (int64_t) i_header - (int64_t) p_sys->i_mdat_pos);
+
+    FILE *file = vlc_fopen(psz_sidecar, "wb");
+    if (file)
+    {
+        if ((ftyp && ftyp->b &&
+             fwrite(ftyp->b->p_buffer, ftyp->b->i_buffer, 1, file) != 1) ||
+            fwrite(sidecar_moov.b->p_buffer, sidecar_moov.b->i_buffer, 1, file) != 1)
+            msg_Err(p_mux, "cannot write `%s'", psz_sidecar);
+        fclose(file);
+        msg_Info(p_mux, "sidecar moov written to `%s', append bytes %"PRIu64
+                 " to %"PRIu64" of the file to get a fast start file",
+                 psz_sidecar, p_sys->i_mdat_pos, p_sys->i_pos);
+    }
+    else
+        msg_Err(p_mux, "cannot open `%s' (%s)", psz_sidecar, vlc_strerror_c(errno));
+
+    block_Release(sidecar_moov.b);
+end:
+    if (ftyp)
+        bo_free(ftyp);
+    free(psz_sidecar);
+}
+
 /*****************************************************************************
  * Close:
  *****************************************************************************/
@@ -264,6 +501,9 @@ static void Close(vlc_object_t *p_this)
 
     msg_Dbg(p_mux, "Close");
 
+    if (!p_sys->b_mdat_sent && WriteMdatHeader(p_mux) != VLC_SUCCESS)
+        goto cleanup;
+
     /* Update mdat size */
     bo_t bo;
     if (!bo_init(&bo, 16))
@@ -290,6 +530,32 @@ static void Close(vlc_object_t *p_this)
 
     /* Check we need to create "fast start" files */
     p_sys->b_fast_start = var_GetBool(p_this, SOUT_CFG_PREFIX "faststart");
+
+    if (p_sys->b_fast_start && p_sys->i_reserve_size && moov && moov->b) {
+        const uint64_t i_moov_size = moov->b->i_buffer;
+
+        if (i_moov_size == p_sys->i_reserve_size ||
+            i_moov_size + 8 <= p_sys->i_reserve_size) {
+            /* Fits into the reserved space, the remaining stays a free box */
+            i_moov_pos = p_sys->i_reserve_pos;
+            if (i_moov_size < p_sys->i_reserve_size && bo_init(&bo, 8)) {
+                bo_add_32be  (&bo, p_sys->i_reserve_size - i_moov_size);
+                bo_add_fourcc(&bo, "free");
+                sout_AccessOutSeek(p_mux->p_access, i_moov_pos + i_moov_size);
+                sout_AccessOutWrite(p_mux->p_access, bo.b);
+            }
+            msg_Dbg(p_this, "moov written in reserved space (%"PRIu64"/%"PRIu64")",
+                    i_moov_size, p_sys->i_reserve_size);
+        } else {
+            msg_Warn(p_this, "moov (%"PRIu64" bytes) does not fit the reserved "
+                     "%"PRIu64" bytes, writing it at the end", i_moov_size,
+                     p_sys->i_reserve_size);
+            if (var_GetBool(p_this, SOUT_CFG_PREFIX "moov-sidecar"))
+                WriteSidecar(p_mux, moov, b_stco64);
+        }
+        p_sys->b_fast_start = false;
+    }
+
     while (p_sys->b_fast_start && moov && moov->b) {
         /* Move data to the end of the file so we can fit the moov header
          * at the start */
@@ -322,24 +588,7 @@ static void Close(vlc_object_t *p_this)
         p_sys->i_mdat_pos += moov->b->i_buffer;
 
         /* Fix-up samples to chunks table in MOOV header */
-        for (unsigned int i_trak = 0; i_trak < p_sys->i_nb_streams; i_trak++) {
-            mp4_stream_t *p_stream = p_sys->pp_streams[i_trak];
-            unsigned i_written = 0;
-            for (unsigned i = 0; i < p_stream->mux.i_entry_count; ) {
-                mp4mux_entry_t *entry = p_stream->mux.entry;
-                if (b_stco64)
-                    bo_set_64be(moov, p_stream->mux.i_stco_pos + i_written++ * 8, entry[i].i_pos + p_sys->i_mdat_pos - i_moov_pos);
-                else
-                    bo_set_32be(moov, p_stream->mux.i_stco_pos + i_written++ * 4, entry[i].i_pos + p_sys->i_mdat_pos - i_moov_pos);
-
-                for (; i < p_stream->mux.i_entry_count; i++)
-                    if (i >= p_stream->mux.i_entry_count - 1 ||
-                        entry[i].i_pos + entry[i].i_size != entry[i+1].i_pos) {
-                        i++;
-                        break;
-                    }
-            }
-        }
+        ShiftChunkOffsets(p_sys, moov, b_stco64, p_sys->i_mdat_pos - i_moov_pos);
 
         p_sys->b_fast_start = false;
     }
@@ -582,6 +831,9 @@ static int Mux(sout_mux_t *p_mux)
 {
     sout_mux_sys_t *p_sys = p_mux->p_sys;
 
+    if (!p_sys->b_mdat_sent && WriteMdatHeader(p_mux) != VLC_SUCCESS)
+        return VLC_ENOMEM;
+
     for (;;) {
         int i_stream = sout_MuxGetStream(p_mux, 2, NULL);
         if (i_stream < 0)
@@ -780,8 +1032,6 @@ static void box_send(sout_mux_t *p_mux,  bo_t *box)
 /***************************************************************************
     MP4 Live submodule
 ****************************************************************************/
-#define FRAGMENT_LENGTH  (CLOCK_FREQ * 3/2)
-
 #define ENQUEUE_ENTRY(object, entry) \
     do {\
         if (object.p_last)\
@@ -846,6 +1096,8 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
 
     bo_t            *moof, *mfhd;
     size_t           i_fixupoffset = 0;
+    bool             b_sync = true;
+    mtime_t          i_end_time = p_sys->i_written_duration;
 
     *pi_mdat_total_size = 0;
 
@@ -945,7 +1197,10 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
             uint32_t i_trun_flags = 0x0;
 
             if (p_stream->b_hasiframes && !(p_stream->read.p_first->p_block->i_flags & BLOCK_FLAG_TYPE_I))
+            {
                 i_trun_flags |= MP4_TRUN_FIRST_FLAGS;
+                b_sync = false;
+            }
 
             if (!b_allsamelength ||
                 ( !(i_tfhd_flags & MP4_TFHD_DFLT_SAMPLE_DURATION) && p_stream->mux.i_trex_default_length == 0 ))
@@ -1028,6 +1283,9 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
                 i_time += p_entry->p_block->i_length;
             }
 
+            if (i_time > i_end_time)
+                i_end_time = i_time;
+
             box_gather(traf, trun);
         }
 
@@ -1049,8 +1307,14 @@ static bo_t *GetMoofBox(sout_mux_t *p_mux, size_t *pi_mdat_total_size,
         bo_set_32be(moof, i_fixupoffset, moof->b->i_buffer + 8);
     }
 
-    /* set iframe flag, so the streaming server always starts from moof */
-    moof->b->i_flags |= BLOCK_FLAG_TYPE_I;
+    /* set iframe flag when all tracks start on a sync sample, so the
+     * streaming server and segmenters only start from decodable moofs */
+    if (b_sync)
+        moof->b->i_flags |= BLOCK_FLAG_TYPE_I;
+
+    /* fragment time span, used by segmenting access outputs */
+    moof->b->i_dts = moof->b->i_pts = p_sys->i_start_dts + p_sys->i_written_duration;
+    moof->b->i_length = i_end_time - p_sys->i_written_duration;
 
     return moof;
 }
@@ -1179,6 +1443,8 @@ static int OpenFrag(vlc_object_t *p_this)
     if (!p_sys)
         return VLC_ENOMEM;
 
+    config_ChainParse(p_mux, SOUT_CFG_PREFIX_FRAG, ppsz_sout_frag_options, p_mux->p_cfg);
+
     p_mux->p_sys = (sout_mux_sys_t *) p_sys;
     p_mux->pf_control   = Control;
     p_mux->pf_addstream = AddStream;
@@ -1202,6 +1468,8 @@ static int OpenFrag(vlc_object_t *p_this)
     p_sys->b_fragmented  = true;
     p_sys->i_start_dts = VLC_TS_INVALID;
     p_sys->i_mfhd_sequence = 1;
+    p_sys->i_fragment_length = CLOCK_FREQ / 1000 *
+            var_GetInteger(p_mux, SOUT_CFG_PREFIX_FRAG "fragment-duration");
 
     return VLC_SUCCESS;
 }
@@ -1210,7 +1478,7 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
 {
     sout_mux_sys_t *p_sys = (sout_mux_sys_t*) p_mux->p_sys;
     bo_t *moof = NULL;
-    mtime_t i_barrier_time = p_sys->i_written_duration + FRAGMENT_LENGTH;
+    mtime_t i_barrier_time = p_sys->i_written_duration + p_sys->i_fragment_length;
     size_t i_mdat_size = 0;
     bool b_has_samples = false;
 
@@ -1258,7 +1526,6 @@ static void WriteFragments(sout_mux_t *p_mux, bool b_flush)
     {
         msg_Dbg(p_mux, "writing moof @ %"PRId64, p_sys->i_pos);
         p_sys->i_pos += moof->b->i_buffer;
-        assert(moof->b->i_flags & BLOCK_FLAG_TYPE_I); /* http sout */
         box_send(p_mux, moof);
         msg_Dbg(p_mux, "writing mdat @ %"PRId64, p_sys->i_pos);
         WriteFragmentMDAT(p_mux, i_mdat_size);
@@ -1419,7 +1686,7 @@ static int MuxFrag(sout_mux_t *p_mux)
         p_stream->p_held_entry = NULL;
 
         if (p_stream->b_hasiframes && (p_heldblock->i_flags & BLOCK_FLAG_TYPE_I) &&
-            p_stream->mux.i_read_duration - p_sys->i_written_duration < FRAGMENT_LENGTH)
+            p_stream->mux.i_read_duration - p_sys->i_written_duration < p_sys->i_fragment_length)
         {
             /* Flag the last iframe time, we'll use it as boundary so it will start
                next fragment */
@@ -1468,7 +1735,7 @@ static int MuxFrag(sout_mux_t *p_mux)
     p_sys->i_written_duration = i_min_written_duration;
 
     /* we have prerolled enough to know all streams, and have enough date to create a fragment */
-    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= FRAGMENT_LENGTH)
+    if (p_stream->read.p_first && p_sys->i_read_duration - p_sys->i_written_duration >= p_sys->i_fragment_length)
         WriteFragments(p_mux, false);
 
     return VLC_SUCCESS;
@@ -27,6 +27,7 @@
 #endif
 
 #include <vlc_common.h>
+#include <vlc_cpu.h>
 
 #include "csa.h"
 
@@ -610,3 +611,188 @@ static void csa_BlockCypher( uint8_t kk[57], uint8_t bd[8], uint8_t ib[8] )
     }
 }
 
+
+/*****************************************************************************
+ * Batch engine
+ *****************************************************************************/
+/* Transposes a 8x8 bits matrix, with byte k holding the row k */
+static inline uint64_t csa_Transpose8x8( uint64_t x )
+{
+    uint64_t t;
+
+    t = ( x ^ ( x >>  7 ) ) & 0x00AA00AA00AA00AAULL;
+    x ^= t ^ ( t <<  7 );
+    t = ( x ^ ( x >> 14 ) ) & 0x0000CCCC0000CCCCULL;
+    x ^= t ^ ( t << 14 );
+    t = ( x ^ ( x >> 28 ) ) & 0x00000000F0F0F0F0ULL;
+    x ^= t ^ ( t << 28 );
+    return x;
+}
+
+typedef void (*csa_bs_func_t)( const uint8_t ck[8], const uint8_t kk[57],
+                               uint8_t *const *pp_data, const int *pi_len,
+                               int i_lanes );
+
+// ================= C =================
+#define BS_WORD uint64_t
+#define BS_LANES 64
+#define VLC_TARGET
+#define RENAME(a) a ## _c
+#include "csa_bs_template.h"
+#undef BS_WORD
+#undef BS_LANES
+#undef VLC_TARGET
+#undef RENAME
+
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+// ================= SSE2 =================
+#define HAVE_CSA_BS_SSE2
+typedef long long csa_bs_sse2_t __attribute__ ((vector_size (16)));
+#define BS_WORD csa_bs_sse2_t
+#define BS_LANES 128
+#define VLC_TARGET __attribute__ ((__target__ ("sse2")))
+#define RENAME(a) a ## _sse2
+#include "csa_bs_template.h"
+#undef BS_WORD
+#undef BS_LANES
+#undef VLC_TARGET
+#undef RENAME
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+// ================= AVX2 =================
+#define HAVE_CSA_BS_AVX2
+typedef long long csa_bs_avx2_t __attribute__ ((vector_size (32)));
+#define BS_WORD csa_bs_avx2_t
+#define BS_LANES 256
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#define RENAME(a) a ## _avx2
+#include "csa_bs_template.h"
+#undef BS_WORD
+#undef BS_LANES
+#undef VLC_TARGET
+#undef RENAME
+#endif
+
+/* Runs the widest engine the remaining packets can fill */
+static void csa_BatchRun( bool b_encrypt, const uint8_t ck[8],
+                          const uint8_t kk[57], uint8_t **pp_data,
+                          const int *pi_len, int i_count )
+{
+    while( i_count > 0 )
+    {
+        csa_bs_func_t pf = b_encrypt ? csa_BsEncrypt_c : csa_BsDecrypt_c;
+        int i_lanes = 64;
+
+#ifdef HAVE_CSA_BS_AVX2
+        if( i_count > 128 && vlc_CPU_AVX2() )
+        {
+            pf = b_encrypt ? csa_BsEncrypt_avx2 : csa_BsDecrypt_avx2;
+            i_lanes = 256;
+        }
+        else
+#endif
+#ifdef HAVE_CSA_BS_SSE2
+        if( i_count > 64 && vlc_CPU_SSE2() )
+        {
+            pf = b_encrypt ? csa_BsEncrypt_sse2 : csa_BsDecrypt_sse2;
+            i_lanes = 128;
+        }
+#endif
+        i_lanes = __MIN( i_lanes, i_count );
+        pf( ck, kk, pp_data, pi_len, i_lanes );
+
+        pp_data += i_lanes;
+        pi_len += i_lanes;
+        i_count -= i_lanes;
+    }
+}
+
+static int csa_PayloadOffset( const uint8_t *pkt )
+{
+    /* skip adaption field */
+    return ( pkt[3]&0x20 ) ? 4 + pkt[4] + 1 : 4;
+}
+
+/*****************************************************************************
+ * csa_EncryptBatch:
+ *****************************************************************************/
+void csa_EncryptBatch( csa_t *c, uint8_t **pp_pkt, int i_pkt, int i_pkt_size )
+{
+    const uint8_t *ck = c->use_odd ? c->o_ck : c->e_ck;
+    const uint8_t *kk = c->use_odd ? c->o_kk : c->e_kk;
+    uint8_t *pp_data[CSA_BATCH_SIZE];
+    int      pi_len[CSA_BATCH_SIZE];
+    int      i_lanes = 0;
+
+    for( int i = 0; i < i_pkt; i++ )
+    {
+        uint8_t *pkt = pp_pkt[i];
+        const int i_hdr = csa_PayloadOffset( pkt );
+
+        /* set transport scrambling control */
+        pkt[3] |= c->use_odd ? 0xc0 : 0x80;
+
+        if( i_pkt_size - i_hdr < 8 )
+        {
+            pkt[3] &= 0x3f;
+            continue;
+        }
+
+        pp_data[i_lanes] = &pkt[i_hdr];
+        pi_len[i_lanes] = i_pkt_size - i_hdr;
+        if( ++i_lanes == CSA_BATCH_SIZE )
+        {
+            csa_BatchRun( true, ck, kk, pp_data, pi_len, i_lanes );
+            i_lanes = 0;
+        }
+    }
+    if( i_lanes > 0 )
+        csa_BatchRun( true, ck, kk, pp_data, pi_len, i_lanes );
+}
+
+/*****************************************************************************
+ * csa_DecryptBatch:
+ *****************************************************************************/
+void csa_DecryptBatch( csa_t *c, uint8_t **pp_pkt, int i_pkt, int i_pkt_size )
+{
+    /* odd key packets first, even key packets from the end */
+    uint8_t *pp_data[CSA_BATCH_SIZE];
+    int      pi_len[CSA_BATCH_SIZE];
+    int      i_odd = 0, i_even = 0;
+
+    for( int i = 0; i < i_pkt; i++ )
+    {
+        uint8_t *pkt = pp_pkt[i];
+        const int i_hdr = csa_PayloadOffset( pkt );
+
+        /* transport scrambling control */
+        if( (pkt[3]&0x80) == 0 )
+            continue;
+
+        /* too short payloads keep the single packet behaviour */
+        if( 188 - i_hdr < 8 || i_pkt_size - i_hdr < 8 )
+        {
+            csa_Decrypt( c, pkt, i_pkt_size );
+            continue;
+        }
+
+        const bool b_odd = pkt[3]&0x40;
+        pkt[3] &= 0x3f;
+
+        const int i_lane = b_odd ? i_odd++ : CSA_BATCH_SIZE - ++i_even;
+        pp_data[i_lane] = &pkt[i_hdr];
+        pi_len[i_lane] = i_pkt_size - i_hdr;
+
+        if( i_odd + i_even == CSA_BATCH_SIZE )
+        {
+            csa_BatchRun( false, c->o_ck, c->o_kk, pp_data, pi_len, i_odd );
+            csa_BatchRun( false, c->e_ck, c->e_kk, &pp_data[i_odd],
+                          &pi_len[i_odd], i_even );
+            i_odd = i_even = 0;
+        }
+    }
+    csa_BatchRun( false, c->o_ck, c->o_kk, pp_data, pi_len, i_odd );
+    csa_BatchRun( false, c->e_ck, c->e_kk, &pp_data[CSA_BATCH_SIZE - i_even],
+                  &pi_len[CSA_BATCH_SIZE - i_even], i_even );
+}
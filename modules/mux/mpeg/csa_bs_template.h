@@ -0,0 +1,586 @@
+/*****************************************************************************
+ * csa_bs_template.h: bitsliced CSA batch engine
+ *****************************************************************************
+ * Copyright (C) 2004-2005 Laurent Aimar
+ * Copyright (C) the deCSA authors
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* This file is included by csa.c once per word type, with:
+ *  - BS_WORD: an integer or vector type supporting & | ^ ~
+ *  - BS_LANES: the number of bits in BS_WORD, ie. packets per batch
+ *  - VLC_TARGET: the target attribute of the instance
+ *  - RENAME(a): suffixes the function names
+ *
+ * The stream cypher is bitsliced: each state bit is a BS_WORD holding that
+ * bit for every packet of the batch. The block cypher uses 8 bits
+ * S-boxes which are not worth a boolean circuit, it is byte sliced instead:
+ * the table lookups stay scalar and the register shuffling is done on
+ * BS_LANES wide byte rows.
+ */
+
+#define BS_BYTES (BS_LANES / 8)
+#define BS_ZERO  ((BS_WORD){ 0 })
+
+/* Stream cypher S-boxes, in algebraic normal form.
+ * s[n][1] and s[n][0] are the high and low output bits of sbox n+1 */
+VLC_TARGET
+static inline void RENAME(csa_BsSboxes)( BS_WORD A[11][4], BS_WORD s[7][2] )
+{
+    /* sbox1 */
+    {
+        const BS_WORD x4 = A[4][0], x3 = A[1][2], x2 = A[6][1],
+                      x1 = A[7][3], x0 = A[9][0];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m5 = x0 & x2;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m17 = x0 & x4;
+        const BS_WORD m20 = x2 & x4;
+        const BS_WORD m24 = x3 & x4;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m13 = m5 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m19 = m3 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m26 = m10 & x4;
+        const BS_WORD m28 = m12 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m29 = m13 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[0][1] = ~(x0 ^ x1 ^ m3 ^ m5 ^ m6 ^ m9 ^ m10 ^ m12 ^ m13 ^ m14 ^ x4 ^
+                    m19 ^ m20 ^ m22 ^ m24 ^ m26 ^ m27 ^ m28 ^ m30);
+        s[0][0] = x1 ^ m5 ^ x3 ^ m9 ^ m11 ^ m17 ^ m24 ^ m26 ^ m28 ^ m29;
+    }
+    /* sbox2 */
+    {
+        const BS_WORD x4 = A[2][1], x3 = A[3][2], x2 = A[6][3],
+                      x1 = A[7][0], x0 = A[9][1];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m5 = x0 & x2;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m20 = x2 & x4;
+        const BS_WORD m24 = x3 & x4;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m13 = m5 & x3;
+        const BS_WORD m19 = m3 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m25 = m9 & x4;
+        const BS_WORD m26 = m10 & x4;
+        const BS_WORD m28 = m12 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m29 = m13 & x4;
+        s[1][1] = ~(x0 ^ x1 ^ m5 ^ m6 ^ m7 ^ x3 ^ m22 ^ m25 ^ m26 ^ m27 ^ m28);
+        s[1][0] = ~(x1 ^ x2 ^ m5 ^ m11 ^ m13 ^ m19 ^ m20 ^ m24 ^ m27 ^ m29);
+    }
+    /* sbox3 */
+    {
+        const BS_WORD x4 = A[1][3], x3 = A[2][0], x2 = A[5][1],
+                      x1 = A[5][3], x0 = A[6][2];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m5 = x0 & x2;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m18 = x1 & x4;
+        const BS_WORD m20 = x2 & x4;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m19 = m3 & x4;
+        const BS_WORD m21 = m5 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m25 = m9 & x4;
+        const BS_WORD m28 = m12 & x4;
+        const BS_WORD m23 = m7 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[2][1] = ~(x0 ^ x1 ^ m5 ^ m6 ^ m7 ^ x3 ^ m9 ^ m10 ^ m11 ^ m12 ^ m14 ^
+                    x4 ^ m18 ^ m19 ^ m20 ^ m21 ^ m22 ^ m23 ^ m25 ^ m28 ^ m30);
+        s[2][0] = x1 ^ m3 ^ m5 ^ x3 ^ x4;
+    }
+    /* sbox4 */
+    {
+        const BS_WORD x4 = A[3][3], x3 = A[1][1], x2 = A[2][3],
+                      x1 = A[4][2], x0 = A[8][0];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m17 = x0 & x4;
+        const BS_WORD m18 = x1 & x4;
+        const BS_WORD m24 = x3 & x4;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m25 = m9 & x4;
+        const BS_WORD m28 = m12 & x4;
+        const BS_WORD m23 = m7 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[3][1] = ~(x0 ^ m3 ^ x2 ^ m7 ^ x3 ^ m14 ^ x4 ^ m17 ^ m18 ^ m23 ^
+                    m24 ^ m25 ^ m27 ^ m28 ^ m30);
+        s[3][0] = ~(x1 ^ m3 ^ x2 ^ m9 ^ m11 ^ m12 ^ m17 ^ m18 ^ m23 ^ m24 ^
+                    m25 ^ m27 ^ m28 ^ m30);
+    }
+    /* sbox5 */
+    {
+        const BS_WORD x4 = A[5][2], x3 = A[4][3], x2 = A[6][0],
+                      x1 = A[8][1], x0 = A[9][2];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m5 = x0 & x2;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m17 = x0 & x4;
+        const BS_WORD m18 = x1 & x4;
+        const BS_WORD m20 = x2 & x4;
+        const BS_WORD m24 = x3 & x4;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m13 = m5 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m21 = m5 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m25 = m9 & x4;
+        const BS_WORD m26 = m10 & x4;
+        const BS_WORD m23 = m7 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m29 = m13 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[4][1] = ~(x0 ^ x1 ^ m3 ^ m5 ^ m6 ^ m7 ^ x3 ^ m9 ^ m11 ^ m13 ^ m14 ^
+                    m17 ^ m18 ^ m20 ^ m22 ^ m23 ^ m25 ^ m26 ^ m29 ^ m30);
+        s[4][0] = m3 ^ x2 ^ m5 ^ m7 ^ m9 ^ m10 ^ m13 ^ m17 ^ m20 ^ m21 ^ m22 ^
+                    m23 ^ m24 ^ m25 ^ m26 ^ m27;
+    }
+    /* sbox6 */
+    {
+        const BS_WORD x4 = A[3][1], x3 = A[4][1], x2 = A[5][0],
+                      x1 = A[7][2], x0 = A[9][3];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m5 = x0 & x2;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m9 = x0 & x3;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m13 = m5 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m19 = m3 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m25 = m9 & x4;
+        const BS_WORD m23 = m7 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[5][1] = x1 ^ m5 ^ m11 ^ m12 ^ m13 ^ x4 ^ m19 ^ m25;
+        s[5][0] = x0 ^ x2 ^ m6 ^ m7 ^ m10 ^ m12 ^ m14 ^ m19 ^ m22 ^ m23 ^
+                    m27 ^ m30;
+    }
+    /* sbox7 */
+    {
+        const BS_WORD x4 = A[2][2], x3 = A[3][0], x2 = A[7][1],
+                      x1 = A[8][2], x0 = A[8][3];
+        const BS_WORD m3 = x0 & x1;
+        const BS_WORD m6 = x1 & x2;
+        const BS_WORD m10 = x1 & x3;
+        const BS_WORD m12 = x2 & x3;
+        const BS_WORD m17 = x0 & x4;
+        const BS_WORD m20 = x2 & x4;
+        const BS_WORD m7 = m3 & x2;
+        const BS_WORD m11 = m3 & x3;
+        const BS_WORD m14 = m6 & x3;
+        const BS_WORD m19 = m3 & x4;
+        const BS_WORD m22 = m6 & x4;
+        const BS_WORD m26 = m10 & x4;
+        const BS_WORD m23 = m7 & x4;
+        const BS_WORD m27 = m11 & x4;
+        const BS_WORD m30 = m14 & x4;
+        s[6][1] = x0 ^ x1 ^ m3 ^ x2 ^ x3 ^ m11 ^ m17 ^ m19 ^ m20 ^ m22 ^ m23 ^
+                    m27 ^ m30;
+        s[6][0] = x0 ^ m3 ^ x2 ^ m6 ^ m7 ^ x3 ^ m12 ^ x4 ^ m26 ^ m27;
+    }
+}
+
+/* Loads an 8 bytes block of every lane as 64 words: w[8*i+b] holds the
+ * bit b of the byte i */
+VLC_TARGET
+static void RENAME(csa_BsLoadBlock)( BS_WORD w[64], uint8_t *const *pp_data,
+                                     int i_lanes )
+{
+    for( int i = 0; i < 64; i++ )
+        w[i] = BS_ZERO;
+
+    for( int g = 0; g < BS_BYTES && 8 * g < i_lanes; g++ )
+    {
+        const int i_group = __MIN( 8, i_lanes - 8 * g );
+
+        for( int i = 0; i < 8; i++ )
+        {
+            uint64_t m = 0;
+            for( int k = 0; k < i_group; k++ )
+                m |= (uint64_t)pp_data[8 * g + k][i] << (8 * k);
+            m = csa_Transpose8x8( m );
+            for( int b = 0; b < 8; b++ )
+                ((uint8_t *)&w[8 * i + b])[g] = m >> (8 * b);
+        }
+    }
+}
+
+/* Generates 8 bytes of key stream for every lane. With b_init, the state
+ * is loaded from the key and the lanes first block instead and nothing is
+ * output */
+VLC_TARGET
+static void RENAME(csa_BsStream)( BS_WORD A[11][4], BS_WORD B[11][4],
+                                  BS_WORD XYZDEF[6][4], BS_WORD pqr[3],
+                                  const BS_WORD *sb, BS_WORD cb[64] )
+{
+    BS_WORD *X = XYZDEF[0], *Y = XYZDEF[1], *Z = XYZDEF[2];
+    BS_WORD *D = XYZDEF[3], *E = XYZDEF[4], *F = XYZDEF[5];
+    BS_WORD s[7][2];
+
+    for( int i = 0; i < 8; i++ )
+    {
+        for( int j = 0; j < 4; j++ )
+        {
+            BS_WORD next_A1[4], next_B1[4], extra_B[4];
+            BS_WORD carry;
+
+            RENAME(csa_BsSboxes)( A, s );
+
+            extra_B[3] = B[3][0] ^ B[6][1] ^ B[7][2] ^ B[9][3];
+            extra_B[2] = B[6][0] ^ B[8][1] ^ B[3][3] ^ B[4][2];
+            extra_B[1] = B[5][3] ^ B[8][2] ^ B[4][0] ^ B[5][1];
+            extra_B[0] = B[9][2] ^ B[6][3] ^ B[3][1] ^ B[8][0];
+
+            for( int b = 0; b < 4; b++ )
+            {
+                /* T1 and T2, the input nibbles are only used during
+                 * initialisation: in1 is the high nibble of the byte */
+                next_A1[b] = A[10][b] ^ X[b];
+                next_B1[b] = B[7][b] ^ B[10][b] ^ Y[b];
+                if( sb )
+                {
+                    const int in1 = 8 * i + 4 + b, in2 = 8 * i + b;
+
+                    next_A1[b] ^= D[b] ^ sb[(j & 1) ? in2 : in1];
+                    next_B1[b] ^= sb[(j & 1) ? in1 : in2];
+                }
+            }
+
+            /* if p=1, rotate next_B1 left */
+            const BS_WORD b3 = next_B1[3];
+            for( int b = 3; b > 0; b-- )
+                next_B1[b] ^= pqr[0] & ( next_B1[b] ^ next_B1[b - 1] );
+            next_B1[0] ^= pqr[0] & ( next_B1[0] ^ b3 );
+
+            /* T4: if q=1, F = Z + E + r with r the carry, else F = E */
+            carry = pqr[2];
+            for( int b = 0; b < 4; b++ )
+            {
+                const BS_WORD ze = Z[b] ^ E[b];
+                const BS_WORD sum = ze ^ carry;
+                const BS_WORD next_E = F[b];
+
+                carry = ( Z[b] & E[b] ) | ( carry & ze );
+
+                /* T3 */
+                D[b] = ze ^ extra_B[b];
+
+                F[b] = E[b] ^ ( pqr[1] & ( sum ^ E[b] ) );
+                E[b] = next_E;
+            }
+            pqr[2] ^= pqr[1] & ( carry ^ pqr[2] );
+
+            for( int k = 10; k > 1; k-- )
+            {
+                for( int b = 0; b < 4; b++ )
+                {
+                    A[k][b] = A[k - 1][b];
+                    B[k][b] = B[k - 1][b];
+                }
+            }
+            for( int b = 0; b < 4; b++ )
+            {
+                A[1][b] = next_A1[b];
+                B[1][b] = next_B1[b];
+            }
+
+            X[3] = s[3][0]; X[2] = s[2][0]; X[1] = s[1][1]; X[0] = s[0][1];
+            Y[3] = s[5][0]; Y[2] = s[4][0]; Y[1] = s[3][1]; Y[0] = s[2][1];
+            Z[3] = s[1][0]; Z[2] = s[0][0]; Z[1] = s[5][1]; Z[0] = s[4][1];
+            pqr[0] = s[6][1];
+            pqr[1] = s[6][0];
+
+            /* 2 output bits per round, most significant first */
+            if( !sb )
+            {
+                cb[8 * i + 7 - 2 * j] = D[3] ^ D[2];
+                cb[8 * i + 6 - 2 * j] = D[1] ^ D[0];
+            }
+        }
+    }
+}
+
+/* Xors the key stream in the bytes [8, pi_len[l]) of every lane, the
+ * stream cypher being initialised with the bytes [0, 8) */
+VLC_TARGET
+static void RENAME(csa_BsStreamXor)( const uint8_t ck[8],
+                                     uint8_t *const *pp_data,
+                                     const int *pi_len, int i_lanes )
+{
+    BS_WORD A[11][4], B[11][4], XYZDEF[6][4], pqr[3];
+    BS_WORD w[64];
+    int i_len = 0;
+
+    for( int l = 0; l < i_lanes; l++ )
+        i_len = __MAX( i_len, pi_len[l] );
+
+    /* load first 32 bits of CK into A[1]..A[8], last 32 bits of CK into
+     * B[1]..B[8], all other regs = 0 */
+    for( int k = 0; k < 11; k++ )
+        for( int b = 0; b < 4; b++ )
+            A[k][b] = B[k][b] = BS_ZERO;
+    for( int i = 0; i < 4; i++ )
+    {
+        for( int b = 0; b < 4; b++ )
+        {
+            if( ( ck[i] >> ( 4 + b ) ) & 1 )
+                A[1 + 2 * i][b] = ~BS_ZERO;
+            if( ( ck[i] >> b ) & 1 )
+                A[2 + 2 * i][b] = ~BS_ZERO;
+            if( ( ck[4 + i] >> ( 4 + b ) ) & 1 )
+                B[1 + 2 * i][b] = ~BS_ZERO;
+            if( ( ck[4 + i] >> b ) & 1 )
+                B[2 + 2 * i][b] = ~BS_ZERO;
+        }
+    }
+    for( int k = 0; k < 6; k++ )
+        for( int b = 0; b < 4; b++ )
+            XYZDEF[k][b] = BS_ZERO;
+    pqr[0] = pqr[1] = pqr[2] = BS_ZERO;
+
+    RENAME(csa_BsLoadBlock)( w, pp_data, i_lanes );
+    RENAME(csa_BsStream)( A, B, XYZDEF, pqr, w, NULL );
+
+    for( int i_pos = 8; i_pos < i_len; i_pos += 8 )
+    {
+        RENAME(csa_BsStream)( A, B, XYZDEF, pqr, NULL, w );
+
+        for( int g = 0; g < BS_BYTES && 8 * g < i_lanes; g++ )
+        {
+            const int i_group = __MIN( 8, i_lanes - 8 * g );
+
+            for( int i = 0; i < 8; i++ )
+            {
+                uint64_t m = 0;
+                for( int b = 0; b < 8; b++ )
+                    m |= (uint64_t)((const uint8_t *)&w[8 * i + b])[g] << (8 * b);
+                m = csa_Transpose8x8( m );
+
+                for( int k = 0; k < i_group; k++ )
+                {
+                    if( i_pos + i < pi_len[8 * g + k] )
+                        pp_data[8 * g + k][i_pos + i] ^= m >> (8 * k);
+                }
+            }
+        }
+    }
+}
+
+/* Block cypher, chained backward from the last complete block */
+VLC_TARGET
+static void RENAME(csa_BsBlockCypher)( const uint8_t kk[57],
+                                       uint8_t *const *pp_data,
+                                       const int *pi_len, int i_lanes )
+{
+    uint8_t rows[8][BS_LANES];
+    uint8_t sbox_out[BS_LANES], perm_out[BS_LANES];
+    int i_blocks = 0;
+
+    memset( rows, 0, sizeof(rows) );
+    memset( sbox_out, 0, sizeof(sbox_out) );
+    memset( perm_out, 0, sizeof(perm_out) );
+
+    for( int l = 0; l < i_lanes; l++ )
+        i_blocks = __MAX( i_blocks, pi_len[l] / 8 );
+
+    /* rows keep the previous cyphered block (or zero) between blocks */
+    for( int n = i_blocks - 1; n >= 0; n-- )
+    {
+        uint8_t *R[9];
+
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            if( n < pi_len[l] / 8 )
+            {
+                for( int i = 0; i < 8; i++ )
+                    rows[i][l] ^= pp_data[l][8 * n + i];
+            }
+        }
+
+        for( int i = 0; i < 8; i++ )
+            R[i + 1] = rows[i];
+
+        for( int k = 1; k <= 56; k++ )
+        {
+            uint8_t *next_R1 = R[2];
+
+            for( int l = 0; l < i_lanes; l++ )
+            {
+                sbox_out[l] = block_sbox[ kk[k] ^ R[8][l] ];
+                perm_out[l] = block_perm[ sbox_out[l] ];
+            }
+            for( int l = 0; l < BS_LANES; l++ )
+            {
+                R[3][l] ^= R[1][l];
+                R[4][l] ^= R[1][l];
+                R[5][l] ^= R[1][l];
+                R[7][l] ^= perm_out[l];
+                R[1][l] ^= sbox_out[l];
+            }
+            /* R2 = R3 ^ R1, R3 = R4 ^ R1, R4 = R5 ^ R1, R5 = R6,
+             * R6 = R7 ^ perm, R7 = R8, R8 = R1 ^ sbox */
+            uint8_t *R1 = R[1];
+            R[2] = R[3]; R[3] = R[4]; R[4] = R[5]; R[5] = R[6];
+            R[6] = R[7]; R[7] = R[8]; R[8] = R1; R[1] = next_R1;
+        }
+
+        /* copy out, and reorder the rows storage for the next block */
+        uint8_t tmp[8][BS_LANES];
+        for( int i = 0; i < 8; i++ )
+            memcpy( tmp[i], R[i + 1], BS_LANES );
+        memcpy( rows, tmp, sizeof(rows) );
+
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            if( n < pi_len[l] / 8 )
+            {
+                for( int i = 0; i < 8; i++ )
+                    pp_data[l][8 * n + i] = rows[i][l];
+            }
+            else
+            {
+                for( int i = 0; i < 8; i++ )
+                    rows[i][l] = 0;
+            }
+        }
+    }
+}
+
+/* Block decypher, each block being xored with the next (still cyphered)
+ * one, the last complete block with zero */
+VLC_TARGET
+static void RENAME(csa_BsBlockDecypher)( const uint8_t kk[57],
+                                         uint8_t *const *pp_data,
+                                         const int *pi_len, int i_lanes )
+{
+    uint8_t rows[8][BS_LANES];
+    uint8_t sbox_out[BS_LANES], perm_out[BS_LANES];
+    int i_blocks = 0;
+
+    memset( sbox_out, 0, sizeof(sbox_out) );
+    memset( perm_out, 0, sizeof(perm_out) );
+
+    for( int l = 0; l < i_lanes; l++ )
+        i_blocks = __MAX( i_blocks, pi_len[l] / 8 );
+
+    for( int n = 0; n < i_blocks; n++ )
+    {
+        uint8_t *R[9];
+
+        memset( rows, 0, sizeof(rows) );
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            if( n < pi_len[l] / 8 )
+            {
+                for( int i = 0; i < 8; i++ )
+                    rows[i][l] = pp_data[l][8 * n + i];
+            }
+        }
+
+        for( int i = 0; i < 8; i++ )
+            R[i + 1] = rows[i];
+
+        for( int k = 56; k > 0; k-- )
+        {
+            uint8_t *next_R8 = R[7];
+
+            for( int l = 0; l < i_lanes; l++ )
+            {
+                sbox_out[l] = block_sbox[ kk[k] ^ R[7][l] ];
+                perm_out[l] = block_perm[ sbox_out[l] ];
+            }
+            for( int l = 0; l < BS_LANES; l++ )
+            {
+                const uint8_t t = R[8][l] ^ sbox_out[l];
+
+                R[6][l] ^= perm_out[l];
+                R[4][l] ^= t;
+                R[3][l] ^= t;
+                R[2][l] ^= t;
+                R[8][l] = t;
+            }
+            /* R7 = R6 ^ perm, R6 = R5, R5 = R4 ^ R8 ^ sbox,
+             * R4 = R3 ^ R8 ^ sbox, R3 = R2 ^ R8 ^ sbox, R2 = R1,
+             * R1 = R8 ^ sbox, R8 = R7 */
+            uint8_t *R8 = R[8];
+            R[7] = R[6]; R[6] = R[5]; R[5] = R[4]; R[4] = R[3];
+            R[3] = R[2]; R[2] = R[1]; R[1] = R8; R[8] = next_R8;
+        }
+
+        for( int l = 0; l < i_lanes; l++ )
+        {
+            const int i_lane_blocks = pi_len[l] / 8;
+
+            if( n >= i_lane_blocks )
+                continue;
+            for( int i = 0; i < 8; i++ )
+            {
+                uint8_t next = n + 1 < i_lane_blocks
+                             ? pp_data[l][8 * (n + 1) + i] : 0;
+                pp_data[l][8 * n + i] = R[i + 1][l] ^ next;
+            }
+        }
+    }
+}
+
+VLC_TARGET
+static void RENAME(csa_BsEncrypt)( const uint8_t ck[8], const uint8_t kk[57],
+                                   uint8_t *const *pp_data,
+                                   const int *pi_len, int i_lanes )
+{
+    RENAME(csa_BsBlockCypher)( kk, pp_data, pi_len, i_lanes );
+    RENAME(csa_BsStreamXor)( ck, pp_data, pi_len, i_lanes );
+}
+
+VLC_TARGET
+static void RENAME(csa_BsDecrypt)( const uint8_t ck[8], const uint8_t kk[57],
+                                   uint8_t *const *pp_data,
+                                   const int *pi_len, int i_lanes )
+{
+    RENAME(csa_BsStreamXor)( ck, pp_data, pi_len, i_lanes );
+    RENAME(csa_BsBlockDecypher)( kk, pp_data, pi_len, i_lanes );
+}
+
+#undef BS_ZERO
+#undef BS_BYTES
@@ -473,6 +473,7 @@ static void TSSchedule  ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
 static void TSDate      ( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
                           mtime_t i_pcr_length, mtime_t i_pcr_dts );
+static void TSEncrypt   ( sout_mux_t *p_mux, uint8_t **pp_pkt, int i_pkt );
 static void GetPAT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 static void GetPMT( sout_mux_t *p_mux, sout_buffer_chain_t *c );
 
@@ -1749,10 +1750,14 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         i_pcr_length = i_packet_count;
     }
 
+    /* Scrambled packets are gathered and encrypted together */
+    uint8_t *pp_scrambled[CSA_BATCH_SIZE];
+    int i_scrambled = 0;
+
     /* msg_Dbg( p_mux, "real pck=%d", i_packet_count ); */
-    for (int i = 0; i < i_packet_count; i++ )
+    block_t *p_ts = p_chain_ts->p_first;
+    for (int i = 0; i < i_packet_count; i++, p_ts = p_ts->p_next )
     {
-        block_t *p_ts = BufferChainGet( p_chain_ts );
         mtime_t i_new_dts = i_pcr_dts + i_pcr_length * i / i_packet_count;
 
         p_ts->i_dts    = i_new_dts;
@@ -1765,16 +1770,31 @@ static void TSDate( sout_mux_t *p_mux, sout_buffer_chain_t *p_chain_ts,
         }
         if( p_ts->i_flags & BLOCK_FLAG_SCRAMBLED )
         {
-            vlc_mutex_lock( &p_sys->csa_lock );
-            csa_Encrypt( p_sys->csa, p_ts->p_buffer, p_sys->i_csa_pkt_size );
-            vlc_mutex_unlock( &p_sys->csa_lock );
+            pp_scrambled[i_scrambled++] = p_ts->p_buffer;
+            if( i_scrambled == CSA_BATCH_SIZE )
+            {
+                TSEncrypt( p_mux, pp_scrambled, i_scrambled );
+                i_scrambled = 0;
+            }
         }
 
         /* latency */
         p_ts->i_dts += p_sys->i_shaping_delay * 3 / 2;
+    }
+    if( i_scrambled > 0 )
+        TSEncrypt( p_mux, pp_scrambled, i_scrambled );
 
+    while( ( p_ts = BufferChainGet( p_chain_ts ) ) )
         sout_AccessOutWrite( p_mux->p_access, p_ts );
-    }
+}
+
+static void TSEncrypt( sout_mux_t *p_mux, uint8_t **pp_pkt, int i_pkt )
+{
+    sout_mux_sys_t *p_sys = p_mux->p_sys;
+
+    vlc_mutex_lock( &p_sys->csa_lock );
+    csa_EncryptBatch( p_sys->csa, pp_pkt, i_pkt, p_sys->i_csa_pkt_size );
+    vlc_mutex_unlock( &p_sys->csa_lock );
 }
 
 static block_t *TSNew( sout_mux_t *p_mux, sout_input_sys_t *p_stream,
@@ -126,7 +126,10 @@ static void Finish( sout_stream_t *p_stream )
 {
     sout_stream_sys_t *p_sys = p_stream->p_sys;
     char *psz_fingerprint = NULL;
-    if ( p_sys->b_finished && chromaprint_finish( p_sys->p_chromaprint_ctx ) )
+    /* A track shorter than the duration, or cut by the input stop time,
+     * still gets the fingerprint of what was fed */
+    if ( p_sys->id != NULL && p_sys->i_total_samples > 0 &&
+         chromaprint_finish( p_sys->p_chromaprint_ctx ) )
     {
         chromaprint_get_fingerprint( p_sys->p_chromaprint_ctx,
                                      &psz_fingerprint );
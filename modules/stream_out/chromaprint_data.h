@@ -25,3 +25,7 @@ struct chromaprint_fingerprint_t
 };
 
 typedef struct chromaprint_fingerprint_t chromaprint_fingerprint_t;
+
+/* Chromaprint works on mono audio at this rate: feeding it that format
+ * spares its own downmix and resampling */
+#define CHROMAPRINT_SAMPLE_RATE 11025
@@ -353,10 +353,23 @@ error:
     } while( p_audio_bufs );
 
 end:
-    /* Drain encoder */
+    /* Drain filters and encoder */
     if( unlikely( !b_error && in == NULL ) )
     {
         block_t *p_block;
+
+        if( id->p_af_chain != NULL )
+        {
+            block_t *p_audio_buf = aout_FiltersDrain( id->p_af_chain );
+            if( p_audio_buf != NULL )
+            {
+                p_audio_buf->i_dts = p_audio_buf->i_pts;
+                p_block = id->p_encoder->pf_encode_audio( id->p_encoder,
+                                                          p_audio_buf );
+                block_ChainAppend( out, p_block );
+                block_Release( p_audio_buf );
+            }
+        }
         do {
            p_block = id->p_encoder->pf_encode_audio(id->p_encoder, NULL );
            block_ChainAppend( out, p_block );
@@ -115,6 +115,10 @@ static void Destroy( vlc_object_t * );
 #define SHADOW_ANGLE_TEXT N_("Shadow angle")
 #define SHADOW_DISTANCE_TEXT N_("Shadow distance")
 
+#define GLYPH_CACHE_TEXT N_("Glyph cache size (KiB)")
+#define GLYPH_CACHE_LONGTEXT N_("Memory used to keep loaded and rendered " \
+    "glyphs across subtitles. 0 disables the cache.")
+
 #define TEXT_DIRECTION_TEXT N_("Text direction")
 #define TEXT_DIRECTION_LONGTEXT N_("Paragraph base direction for the Unicode bi-directional algorithm.")
 
@@ -233,6 +237,9 @@ vlc_module_begin ()
     add_bool( "freetype-yuvp", false, YUVP_TEXT,
               YUVP_LONGTEXT, true )
 
+    add_integer_with_range( "freetype-glyph-cache", 4096, 0, 1048576,
+                            GLYPH_CACHE_TEXT, GLYPH_CACHE_LONGTEXT, true )
+
 #ifdef HAVE_FRIBIDI
     add_integer_with_range( "freetype-text-direction", 0, 0, 2, TEXT_DIRECTION_TEXT,
                             TEXT_DIRECTION_LONGTEXT, false )
@@ -1233,6 +1240,11 @@ static int Create( vlc_object_t *p_this )
 
     p_sys->i_scale = 100;
 
+    /* Glyph cache */
+    int64_t i_cache_size = var_InheritInteger( p_filter, "freetype-glyph-cache" );
+    if( i_cache_size > 0 )
+        p_sys->p_glyph_cache = GlyphCacheNew( i_cache_size * 1024 );
+
     /* default style to apply to uncomplete segmeents styles */
     p_sys->p_default_style = text_style_Create( STYLE_FULLY_SET );
     if(unlikely(!p_sys->p_default_style))
@@ -1350,6 +1362,13 @@ static void Destroy( vlc_object_t *p_this )
     DumpDictionary( p_filter, &p_sys->fallback_map, true, -1 );
 #endif
 
+    /* Caches, which hold glyphs of the faces and the library */
+    if( p_sys->p_glyph_cache )
+    {
+        GlyphCacheDump( p_this, p_sys->p_glyph_cache, "glyph" );
+        GlyphCacheDelete( p_sys->p_glyph_cache );
+    }
+
     /* Text styles */
     text_style_Delete( p_sys->p_default_style );
     text_style_Delete( p_sys->p_forced_style );
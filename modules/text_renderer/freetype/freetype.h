@@ -47,6 +47,8 @@
 #include FT_GLYPH_H
 #include FT_STROKER_H
 
+#include "glyph_cache.h"
+
 /* Consistency between Freetype versions and platforms */
 #define FT_FLOOR(X)     ((X & -64) >> 6)
 #define FT_CEIL(X)      (((X + 63) & -64) >> 6)
@@ -111,6 +113,9 @@ struct filter_sys_t
     /** Font face cache */
     vlc_dictionary_t  face_map;
 
+    /** Loaded and rasterized glyphs cache, NULL if disabled */
+    glyph_cache_t    *p_glyph_cache;
+
     int               i_fallback_counter;
 
     /* Current scaling of the text, default is 100 (%) */
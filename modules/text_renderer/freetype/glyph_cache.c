@@ -0,0 +1,219 @@
+/*****************************************************************************
+ * glyph_cache.c : Glyph cache
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph cache
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <vlc_common.h>
+
+#include "glyph_cache.h"
+
+#define GLYPH_CACHE_BUCKETS 1024
+
+typedef struct cache_entry_t cache_entry_t;
+struct cache_entry_t
+{
+    cache_entry_t *p_hash_next;         /**< next entry in the bucket */
+    cache_entry_t *p_prev;              /**< more recently used entry */
+    cache_entry_t *p_next;              /**< less recently used entry */
+
+    uint32_t       i_hash;
+    size_t         i_size;              /**< accounted memory */
+    void          *p_value;
+    void         (*pf_free)( void * );
+
+    size_t         i_key_size;
+    unsigned char  p_key[];
+};
+
+struct glyph_cache_t
+{
+    cache_entry_t *pp_buckets[ GLYPH_CACHE_BUCKETS ];
+    cache_entry_t *p_first;             /**< most recently used entry */
+    cache_entry_t *p_last;              /**< least recently used entry */
+
+    size_t         i_size;
+    size_t         i_max_size;
+    unsigned       i_entries;
+
+    unsigned long  i_hits;
+    unsigned long  i_misses;
+    unsigned long  i_evictions;
+};
+
+static uint32_t Hash( const unsigned char *p_key, size_t i_size )
+{
+    /* FNV-1a */
+    uint32_t i_hash = 2166136261u;
+    for( size_t i = 0; i < i_size; i++ )
+        i_hash = ( i_hash ^ p_key[ i ] ) * 16777619u;
+    return i_hash;
+}
+
+static void Unlink( glyph_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    if( p_entry->p_prev )
+        p_entry->p_prev->p_next = p_entry->p_next;
+    else
+        p_cache->p_first = p_entry->p_next;
+    if( p_entry->p_next )
+        p_entry->p_next->p_prev = p_entry->p_prev;
+    else
+        p_cache->p_last = p_entry->p_prev;
+}
+
+static void LinkFirst( glyph_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    p_entry->p_prev = NULL;
+    p_entry->p_next = p_cache->p_first;
+    if( p_cache->p_first )
+        p_cache->p_first->p_prev = p_entry;
+    else
+        p_cache->p_last = p_entry;
+    p_cache->p_first = p_entry;
+}
+
+static void FreeEntry( cache_entry_t *p_entry )
+{
+    p_entry->pf_free( p_entry->p_value );
+    free( p_entry );
+}
+
+static void Evict( glyph_cache_t *p_cache, cache_entry_t *p_entry )
+{
+    cache_entry_t **pp_entry =
+        &p_cache->pp_buckets[ p_entry->i_hash % GLYPH_CACHE_BUCKETS ];
+    while( *pp_entry != p_entry )
+        pp_entry = &(*pp_entry)->p_hash_next;
+    *pp_entry = p_entry->p_hash_next;
+
+    Unlink( p_cache, p_entry );
+    p_cache->i_size -= p_entry->i_size;
+    p_cache->i_entries--;
+    FreeEntry( p_entry );
+}
+
+glyph_cache_t *GlyphCacheNew( size_t i_max_bytes )
+{
+    glyph_cache_t *p_cache = calloc( 1, sizeof( *p_cache ) );
+    if( unlikely( !p_cache ) )
+        return NULL;
+
+    p_cache->i_max_size = i_max_bytes;
+    return p_cache;
+}
+
+void GlyphCacheDelete( glyph_cache_t *p_cache )
+{
+    for( cache_entry_t *p_entry = p_cache->p_first; p_entry; )
+    {
+        cache_entry_t *p_next = p_entry->p_next;
+        FreeEntry( p_entry );
+        p_entry = p_next;
+    }
+    free( p_cache );
+}
+
+void *GlyphCacheGet( glyph_cache_t *p_cache,
+                     const void *p_key, size_t i_key_size )
+{
+    const uint32_t i_hash = Hash( p_key, i_key_size );
+
+    for( cache_entry_t *p_entry = p_cache->pp_buckets[ i_hash % GLYPH_CACHE_BUCKETS ];
+         p_entry; p_entry = p_entry->p_hash_next )
+    {
+        if( p_entry->i_hash != i_hash || p_entry->i_key_size != i_key_size
+         || memcmp( p_entry->p_key, p_key, i_key_size ) )
+            continue;
+
+        if( p_cache->p_first != p_entry )
+        {
+            Unlink( p_cache, p_entry );
+            LinkFirst( p_cache, p_entry );
+        }
+        p_cache->i_hits++;
+        return p_entry->p_value;
+    }
+
+    p_cache->i_misses++;
+    return NULL;
+}
+
+void GlyphCachePut( glyph_cache_t *p_cache,
+                    const void *p_key, size_t i_key_size,
+                    void *p_value, size_t i_value_size,
+                    void (*pf_free)( void * ) )
+{
+    const size_t i_size = sizeof( cache_entry_t ) + i_key_size + i_value_size;
+
+    if( i_size > p_cache->i_max_size / 2 )
+    {
+        pf_free( p_value );
+        return;
+    }
+
+    cache_entry_t *p_entry = malloc( sizeof( *p_entry ) + i_key_size );
+    if( unlikely( !p_entry ) )
+    {
+        pf_free( p_value );
+        return;
+    }
+
+    p_entry->i_hash = Hash( p_key, i_key_size );
+    p_entry->i_size = i_size;
+    p_entry->p_value = p_value;
+    p_entry->pf_free = pf_free;
+    p_entry->i_key_size = i_key_size;
+    memcpy( p_entry->p_key, p_key, i_key_size );
+
+    while( p_cache->p_last && p_cache->i_size + i_size > p_cache->i_max_size )
+    {
+        Evict( p_cache, p_cache->p_last );
+        p_cache->i_evictions++;
+    }
+
+    cache_entry_t **pp_bucket =
+        &p_cache->pp_buckets[ p_entry->i_hash % GLYPH_CACHE_BUCKETS ];
+    p_entry->p_hash_next = *pp_bucket;
+    *pp_bucket = p_entry;
+    LinkFirst( p_cache, p_entry );
+    p_cache->i_size += i_size;
+    p_cache->i_entries++;
+}
+
+void GlyphCacheDump( vlc_object_t *p_obj, const glyph_cache_t *p_cache,
+                     const char *psz_name )
+{
+    const unsigned long i_lookups = p_cache->i_hits + p_cache->i_misses;
+
+    msg_Dbg( p_obj, "%s cache: %u entries, %zu/%zu KiB, "
+             "%lu hits, %lu misses (%lu%%), %lu evictions", psz_name,
+             p_cache->i_entries, p_cache->i_size / 1024,
+             p_cache->i_max_size / 1024, p_cache->i_hits, p_cache->i_misses,
+             i_lookups ? p_cache->i_hits * 100 / i_lookups : 0,
+             p_cache->i_evictions );
+}
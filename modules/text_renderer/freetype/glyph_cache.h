@@ -0,0 +1,79 @@
+/*****************************************************************************
+ * glyph_cache.h : Glyph cache
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_FREETYPE_GLYPH_CACHE_H
+#define VLC_FREETYPE_GLYPH_CACHE_H
+
+/** \ingroup freetype
+ * @{
+ * \file
+ * Glyph cache
+ *
+ * A memory bounded cache of values indexed by binary keys, with least
+ * recently used eviction. Keys are compared bytewise, so they must be
+ * fully initialized, padding included.
+ *
+ * Values returned by GlyphCacheGet() remain valid until the next call to
+ * GlyphCachePut() or GlyphCacheDelete(): callers should copy them before
+ * storing anything else.
+ */
+
+typedef struct glyph_cache_t glyph_cache_t;
+
+/**
+ * Creates a cache
+ *
+ * \param i_max_bytes memory limit of the cached values and keys
+ */
+glyph_cache_t *GlyphCacheNew( size_t i_max_bytes );
+
+/**
+ * Destroys a cache and all its values
+ */
+void GlyphCacheDelete( glyph_cache_t *p_cache );
+
+/**
+ * Looks a value up
+ *
+ * \return the value, or NULL if it is not in the cache
+ */
+void *GlyphCacheGet( glyph_cache_t *p_cache,
+                     const void *p_key, size_t i_key_size );
+
+/**
+ * Stores a value, evicting the least recently used ones if needed
+ *
+ * The cache owns the value from then on, and releases it with \p pf_free,
+ * including when it cannot be stored.
+ *
+ * \param i_value_size memory accounted for the value
+ */
+void GlyphCachePut( glyph_cache_t *p_cache,
+                    const void *p_key, size_t i_key_size,
+                    void *p_value, size_t i_value_size,
+                    void (*pf_free)( void * ) );
+
+/**
+ * Prints the cache usage and hit rate
+ */
+void GlyphCacheDump( vlc_object_t *p_obj, const glyph_cache_t *p_cache,
+                     const char *psz_name );
+
+#endif
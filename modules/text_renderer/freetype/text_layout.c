@@ -65,6 +65,7 @@
 #include "freetype.h"
 #include "text_layout.h"
 #include "platform_fonts.h"
+#include "glyph_cache.h"
 
 /* Win32 */
 #ifdef _WIN32
@@ -115,6 +116,35 @@ typedef struct run_desc_t
 
 } run_desc_t;
 
+/**
+ * Glyph cache key. Faces are loaded for a given size and kept until the
+ * module is closed, so the face identifies both the font and its size.
+ */
+typedef struct glyph_key_t
+{
+    FT_Face  p_face;            /**< NULL if the glyph is not cacheable */
+    FT_UInt  i_glyph_index;
+    int      i_outline_radius;  /**< stroker radius, -1 without outline */
+    uint16_t i_style_flags;     /**< synthesized bold and italic */
+    uint8_t  i_kind;            /**< GLYPH_KIND_* */
+    uint8_t  i_origin_x;        /**< sub-pixel origin of bitmaps, 26.6 */
+    uint8_t  i_origin_y;
+} glyph_key_t;
+
+enum
+{
+    GLYPH_KIND_OUTLINES,        /**< loaded glyph and its stroked outline */
+    GLYPH_KIND_GLYPH_BITMAP,    /**< rasterized glyph */
+    GLYPH_KIND_OUTLINE_BITMAP,  /**< rasterized outline */
+};
+
+typedef struct cached_outlines_t
+{
+    FT_Glyph  p_glyph;
+    FT_Glyph  p_outline;
+    FT_Vector advance;
+} cached_outlines_t;
+
 /**
  * Glyph bitmaps. Advance and offset are 26.6 values
  */
@@ -130,6 +160,7 @@ typedef struct glyph_bitmaps_t
     int      i_y_offset;
     int      i_x_advance;
     int      i_y_advance;
+    glyph_key_t key;
 } glyph_bitmaps_t;
 
 typedef struct paragraph_t
@@ -213,6 +244,142 @@ line_desc_t *NewLine( int i_count )
     return p_line;
 }
 
+static size_t GlyphSize( FT_Glyph p_glyph )
+{
+    if( p_glyph->format == FT_GLYPH_FORMAT_OUTLINE )
+    {
+        const FT_Outline *p_outline = &( (FT_OutlineGlyph) p_glyph )->outline;
+        return sizeof( FT_OutlineGlyphRec )
+             + p_outline->n_points * ( sizeof( FT_Vector ) + 1 )
+             + p_outline->n_contours * sizeof( short );
+    }
+    if( p_glyph->format == FT_GLYPH_FORMAT_BITMAP )
+    {
+        const FT_Bitmap *p_bitmap = &( (FT_BitmapGlyph) p_glyph )->bitmap;
+        return sizeof( FT_BitmapGlyphRec )
+             + p_bitmap->rows * abs( p_bitmap->pitch );
+    }
+    return sizeof( FT_GlyphRec );
+}
+
+static void FreeCachedGlyph( void *p_glyph )
+{
+    FT_Done_Glyph( p_glyph );
+}
+
+static void FreeCachedOutlines( void *p_data )
+{
+    cached_outlines_t *p_cached = p_data;
+
+    FT_Done_Glyph( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        FT_Done_Glyph( p_cached->p_outline );
+    free( p_cached );
+}
+
+/**
+ * Gives the glyph bitmaps their own copy of cached outlines
+ */
+static int CopyCachedOutlines( const cached_outlines_t *p_cached,
+                               glyph_bitmaps_t *p_bitmaps )
+{
+    if( FT_Glyph_Copy( p_cached->p_glyph, &p_bitmaps->p_glyph ) )
+        return VLC_ENOMEM;
+
+    p_bitmaps->p_outline = 0;
+    if( p_cached->p_outline
+     && FT_Glyph_Copy( p_cached->p_outline, &p_bitmaps->p_outline ) )
+    {
+        FT_Done_Glyph( p_bitmaps->p_glyph );
+        return VLC_ENOMEM;
+    }
+    return VLC_SUCCESS;
+}
+
+static void CacheOutlines( glyph_cache_t *p_cache,
+                           const glyph_bitmaps_t *p_bitmaps,
+                           const FT_Vector *p_advance )
+{
+    cached_outlines_t *p_cached = malloc( sizeof( *p_cached ) );
+    if( unlikely( !p_cached ) )
+        return;
+
+    p_cached->p_outline = 0;
+    p_cached->advance = *p_advance;
+    if( FT_Glyph_Copy( p_bitmaps->p_glyph, &p_cached->p_glyph ) )
+    {
+        free( p_cached );
+        return;
+    }
+    if( p_bitmaps->p_outline
+     && FT_Glyph_Copy( p_bitmaps->p_outline, &p_cached->p_outline ) )
+    {
+        FreeCachedOutlines( p_cached );
+        return;
+    }
+
+    size_t i_size = sizeof( *p_cached ) + GlyphSize( p_cached->p_glyph );
+    if( p_cached->p_outline )
+        i_size += GlyphSize( p_cached->p_outline );
+
+    GlyphCachePut( p_cache, &p_bitmaps->key, sizeof( p_bitmaps->key ),
+                   p_cached, i_size, FreeCachedOutlines );
+}
+
+/**
+ * Rasterizes a glyph at the pen position like FT_Glyph_To_Bitmap() does.
+ *
+ * Outline glyphs translated by whole pixels rasterize to the same bitmap,
+ * so bitmaps are cached for their sub-pixel origin and moved into place.
+ */
+static FT_Error RenderGlyph( glyph_cache_t *p_cache, FT_Glyph *pp_glyph,
+                             const glyph_key_t *p_key, int i_kind,
+                             FT_Vector *p_pen, bool b_destroy )
+{
+    if( !p_cache || !p_key->p_face
+     || (*pp_glyph)->format != FT_GLYPH_FORMAT_OUTLINE )
+        return FT_Glyph_To_Bitmap( pp_glyph, FT_RENDER_MODE_NORMAL,
+                                   p_pen, b_destroy );
+
+    glyph_key_t key = *p_key;
+    key.i_kind = i_kind;
+    key.i_origin_x = p_pen->x & 63;
+    key.i_origin_y = p_pen->y & 63;
+
+    FT_Glyph p_bitmap;
+    FT_Glyph p_cached = GlyphCacheGet( p_cache, &key, sizeof( key ) );
+    if( p_cached )
+    {
+        FT_Error err = FT_Glyph_Copy( p_cached, &p_bitmap );
+        if( err )
+            return err;
+    }
+    else
+    {
+        FT_Vector origin = { .x = key.i_origin_x, .y = key.i_origin_y };
+
+        p_bitmap = *pp_glyph;
+        FT_Error err = FT_Glyph_To_Bitmap( &p_bitmap, FT_RENDER_MODE_NORMAL,
+                                           &origin, 0 );
+        if( err )
+            return err;
+
+        FT_Glyph p_copy;
+        if( !FT_Glyph_Copy( p_bitmap, &p_copy ) )
+            GlyphCachePut( p_cache, &key, sizeof( key ), p_copy,
+                           GlyphSize( p_copy ), FreeCachedGlyph );
+    }
+
+    FT_BitmapGlyph p_bitmap_glyph = (FT_BitmapGlyph) p_bitmap;
+    p_bitmap_glyph->left += ( p_pen->x - key.i_origin_x ) / 64;
+    p_bitmap_glyph->top  += ( p_pen->y - key.i_origin_y ) / 64;
+
+    if( b_destroy )
+        FT_Done_Glyph( *pp_glyph );
+    *pp_glyph = p_bitmap;
+    return 0;
+}
+
 static void FixGlyph( FT_Glyph glyph, FT_BBox *p_bbox,
                       FT_Pos i_x_advance, FT_Pos i_y_advance,
                       const FT_Vector *p_pen )
@@ -955,6 +1122,7 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
         else
             p_face = p_run->p_face;
 
+        int i_outline_radius = -1;
         if( p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
         {
             double f_outline_thickness =
@@ -965,8 +1133,17 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                             i_radius,
                             FT_STROKER_LINECAP_ROUND,
                             FT_STROKER_LINEJOIN_ROUND, 0 );
+            i_outline_radius = i_radius;
         }
 
+        uint16_t i_synthesized_flags = 0;
+        if( ( p_style->i_style_flags & STYLE_BOLD )
+              && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
+            i_synthesized_flags |= STYLE_BOLD;
+        if( ( p_style->i_style_flags & STYLE_ITALIC )
+              && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
+            i_synthesized_flags |= STYLE_ITALIC;
+
         for( int j = p_run->i_start_offset; j < p_run->i_end_offset; ++j )
         {
             int i_glyph_index;
@@ -1017,39 +1194,59 @@ static int LoadGlyphs( filter_t *p_filter, paragraph_t *p_paragraph,
                     SKIP_GLYPH( p_bitmaps )
             }
 
-            if( FT_Load_Glyph( p_face, i_glyph_index,
-                               FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
-             && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
-                SKIP_GLYPH( p_bitmaps )
+            glyph_key_t *p_key = &p_bitmaps->key;
+            memset( p_key, 0, sizeof( *p_key ) );
+            p_key->p_face = p_face;
+            p_key->i_glyph_index = i_glyph_index;
+            p_key->i_outline_radius = i_outline_radius;
+            p_key->i_style_flags = i_synthesized_flags;
+            p_key->i_kind = GLYPH_KIND_OUTLINES;
 
-            if( ( p_style->i_style_flags & STYLE_BOLD )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_BOLD ) )
-                FT_GlyphSlot_Embolden( p_face->glyph );
-            if( ( p_style->i_style_flags & STYLE_ITALIC )
-                  && !( p_face->style_flags & FT_STYLE_FLAG_ITALIC ) )
-                FT_GlyphSlot_Oblique( p_face->glyph );
+            const cached_outlines_t *p_cached = p_sys->p_glyph_cache ?
+                GlyphCacheGet( p_sys->p_glyph_cache, p_key, sizeof( *p_key ) ) : NULL;
+            FT_Vector advance;
 
-            if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
-                SKIP_GLYPH( p_bitmaps )
+            if( p_cached && !CopyCachedOutlines( p_cached, p_bitmaps ) )
+                advance = p_cached->advance;
+            else
+            {
+                if( FT_Load_Glyph( p_face, i_glyph_index,
+                                   FT_LOAD_NO_BITMAP | FT_LOAD_DEFAULT )
+                 && FT_Load_Glyph( p_face, i_glyph_index, FT_LOAD_DEFAULT ) )
+                    SKIP_GLYPH( p_bitmaps )
 
-#undef SKIP_GLYPH
+                if( i_synthesized_flags & STYLE_BOLD )
+                    FT_GlyphSlot_Embolden( p_face->glyph );
+                if( i_synthesized_flags & STYLE_ITALIC )
+                    FT_GlyphSlot_Oblique( p_face->glyph );
 
-            if( p_filter->p_sys->p_stroker && (p_style->i_style_flags & STYLE_OUTLINE) )
-            {
-                p_bitmaps->p_outline = p_bitmaps->p_glyph;
-                if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
-                                           p_filter->p_sys->p_stroker, 0, 0 ) )
-                    p_bitmaps->p_outline = 0;
+                if( FT_Get_Glyph( p_face->glyph, &p_bitmaps->p_glyph ) )
+                    SKIP_GLYPH( p_bitmaps )
+
+                p_bitmaps->p_outline = 0;
+                if( i_outline_radius >= 0 )
+                {
+                    p_bitmaps->p_outline = p_bitmaps->p_glyph;
+                    if( FT_Glyph_StrokeBorder( &p_bitmaps->p_outline,
+                                               p_sys->p_stroker, 0, 0 ) )
+                        p_bitmaps->p_outline = 0;
+                }
+
+                advance = p_face->glyph->advance;
+                if( p_sys->p_glyph_cache )
+                    CacheOutlines( p_sys->p_glyph_cache, p_bitmaps, &advance );
             }
 
+#undef SKIP_GLYPH
+
             if( p_style->i_shadow_alpha != STYLE_ALPHA_TRANSPARENT )
                 p_bitmaps->p_shadow = p_bitmaps->p_outline ?
                                       p_bitmaps->p_outline : p_bitmaps->p_glyph;
 
             if( b_overwrite_advance )
             {
-                p_bitmaps->i_x_advance = p_face->glyph->advance.x;
-                p_bitmaps->i_y_advance = p_face->glyph->advance.y;
+                p_bitmaps->i_x_advance = advance.x;
+                p_bitmaps->i_y_advance = advance.y;
             }
         }
 
@@ -1152,8 +1349,10 @@ static int LayoutLine( filter_t *p_filter,
 
         if( p_bitmaps->p_shadow )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_shadow, FT_RENDER_MODE_NORMAL,
-                                    &pen_shadow, 0 ) )
+            const int i_kind = p_bitmaps->p_shadow == p_bitmaps->p_outline ?
+                               GLYPH_KIND_OUTLINE_BITMAP : GLYPH_KIND_GLYPH_BITMAP;
+            if( RenderGlyph( p_sys->p_glyph_cache, &p_bitmaps->p_shadow,
+                             &p_bitmaps->key, i_kind, &pen_shadow, false ) )
                 p_bitmaps->p_shadow = 0;
             else
                 FT_Glyph_Get_CBox( p_bitmaps->p_shadow, ft_glyph_bbox_pixels,
@@ -1161,8 +1360,9 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_glyph )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_glyph, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys->p_glyph_cache, &p_bitmaps->p_glyph,
+                             &p_bitmaps->key, GLYPH_KIND_GLYPH_BITMAP,
+                             &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_glyph );
                 if( p_bitmaps->p_outline )
@@ -1178,8 +1378,9 @@ static int LayoutLine( filter_t *p_filter,
         }
         if( p_bitmaps->p_outline )
         {
-            if( FT_Glyph_To_Bitmap( &p_bitmaps->p_outline, FT_RENDER_MODE_NORMAL,
-                                    &pen_new, 1 ) )
+            if( RenderGlyph( p_sys->p_glyph_cache, &p_bitmaps->p_outline,
+                             &p_bitmaps->key, GLYPH_KIND_OUTLINE_BITMAP,
+                             &pen_new, true ) )
             {
                 FT_Done_Glyph( p_bitmaps->p_outline );
                 p_bitmaps->p_outline = 0;
@@ -0,0 +1,796 @@
+/*****************************************************************************
+ * chroma_simd.c: SIMD conversions between YUV formats and to RGBA
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*****************************************************************************
+ * Preamble
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <math.h>
+
+#include <vlc_common.h>
+#include <vlc_plugin.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+static int  Open ( vlc_object_t * );
+static void Close( vlc_object_t * );
+
+vlc_module_begin ()
+    set_description( N_("SIMD YUV and YUV to RGB conversions") )
+    set_capability( "video converter", 200 )
+    set_callbacks( Open, Close )
+vlc_module_end ()
+
+/*****************************************************************************
+ * Line kernels
+ *****************************************************************************/
+
+/* Parameters of the YUV to RGB conversion: the coefficients are in Q13 and
+ * the result is shifted down by i_shift, 13 for 8 bits samples and 15 for
+ * 10 bits samples, so that the same coefficients serve both depths. */
+typedef struct
+{
+    int16_t i_y_offset;
+    int16_t i_c_offset;
+    int16_t i_cy, i_crv, i_cgu, i_cgv, i_cbu;
+    unsigned i_shift;
+    bool b_bgra;
+} yuv_rgb_t;
+
+typedef struct
+{
+    void (*interleave8)( uint8_t *, const uint8_t *, const uint8_t *,
+                         unsigned );
+    void (*deinterleave8)( uint8_t *, uint8_t *, const uint8_t *, unsigned );
+    void (*interleave16)( uint16_t *, const uint16_t *, const uint16_t *,
+                          unsigned, unsigned );
+    void (*deinterleave16)( uint16_t *, uint16_t *, const uint16_t *,
+                            unsigned, unsigned );
+    void (*shift_left16)( uint16_t *, const uint16_t *, unsigned, unsigned );
+    void (*shift_right16)( uint16_t *, const uint16_t *, unsigned, unsigned );
+    void (*average8)( uint8_t *, const uint8_t *, const uint8_t *, unsigned );
+    void (*average16)( uint16_t *, const uint16_t *, const uint16_t *,
+                       unsigned );
+    void (*yuv_rgba8)( uint8_t *, const uint8_t *, const uint8_t *,
+                       const uint8_t *, unsigned, const yuv_rgb_t * );
+    void (*yuv_rgba16)( uint8_t *, const uint16_t *, const uint16_t *,
+                        const uint16_t *, unsigned, const yuv_rgb_t * );
+} chroma_kernels_t;
+
+static void Interleave8C( uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                          unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+    {
+        dst[2 * i    ] = u[i];
+        dst[2 * i + 1] = v[i];
+    }
+}
+
+static void Deinterleave8C( uint8_t *u, uint8_t *v, const uint8_t *src,
+                            unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+    {
+        u[i] = src[2 * i    ];
+        v[i] = src[2 * i + 1];
+    }
+}
+
+static void Interleave16C( uint16_t *dst, const uint16_t *u,
+                           const uint16_t *v, unsigned n, unsigned shift )
+{
+    for( unsigned i = 0; i < n; i++ )
+    {
+        dst[2 * i    ] = u[i] << shift;
+        dst[2 * i + 1] = v[i] << shift;
+    }
+}
+
+static void Deinterleave16C( uint16_t *u, uint16_t *v, const uint16_t *src,
+                             unsigned n, unsigned shift )
+{
+    for( unsigned i = 0; i < n; i++ )
+    {
+        u[i] = src[2 * i    ] >> shift;
+        v[i] = src[2 * i + 1] >> shift;
+    }
+}
+
+static void ShiftLeft16C( uint16_t *dst, const uint16_t *src, unsigned n,
+                          unsigned shift )
+{
+    for( unsigned i = 0; i < n; i++ )
+        dst[i] = src[i] << shift;
+}
+
+static void ShiftRight16C( uint16_t *dst, const uint16_t *src, unsigned n,
+                           unsigned shift )
+{
+    for( unsigned i = 0; i < n; i++ )
+        dst[i] = src[i] >> shift;
+}
+
+static void Average8C( uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                       unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+        dst[i] = (a[i] + b[i] + 1) >> 1;
+}
+
+static void Average16C( uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                        unsigned n )
+{
+    for( unsigned i = 0; i < n; i++ )
+        dst[i] = (a[i] + b[i] + 1) >> 1;
+}
+
+static inline uint8_t ClipRgb( int v, unsigned shift )
+{
+    v >>= shift;
+    return v < 0 ? 0 : v > 255 ? 255 : v;
+}
+
+static inline void YuvToRgbaPixel( uint8_t *dst, int y, int u, int v,
+                                   const yuv_rgb_t *p )
+{
+    const int l = (y - p->i_y_offset) * p->i_cy + (1 << (p->i_shift - 1));
+    u -= p->i_c_offset;
+    v -= p->i_c_offset;
+
+    const uint8_t r = ClipRgb( l + v * p->i_crv, p->i_shift );
+    const uint8_t g = ClipRgb( l + u * p->i_cgu + v * p->i_cgv, p->i_shift );
+    const uint8_t b = ClipRgb( l + u * p->i_cbu, p->i_shift );
+
+    dst[0] = p->b_bgra ? b : r;
+    dst[1] = g;
+    dst[2] = p->b_bgra ? r : b;
+    dst[3] = 0xff;
+}
+
+/* The chroma is subsampled horizontally by 2 */
+static void YuvToRgba8C( uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                         const uint8_t *v, unsigned width, const yuv_rgb_t *p )
+{
+    for( unsigned x = 0; x < width; x++ )
+        YuvToRgbaPixel( &dst[4 * x], y[x], u[x / 2], v[x / 2], p );
+}
+
+static void YuvToRgba16C( uint8_t *dst, const uint16_t *y, const uint16_t *u,
+                          const uint16_t *v, unsigned width,
+                          const yuv_rgb_t *p )
+{
+    for( unsigned x = 0; x < width; x++ )
+        YuvToRgbaPixel( &dst[4 * x], y[x], u[x / 2], v[x / 2], p );
+}
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define HAVE_CHROMA_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static void Interleave8AVX2( uint8_t *dst, const uint8_t *u, const uint8_t *v,
+                             unsigned n )
+{
+    unsigned i = 0;
+
+    for( ; i + 32 <= n; i += 32 )
+    {
+        const __m256i a = _mm256_loadu_si256( (const __m256i *)&u[i] );
+        const __m256i b = _mm256_loadu_si256( (const __m256i *)&v[i] );
+        const __m256i lo = _mm256_unpacklo_epi8( a, b );
+        const __m256i hi = _mm256_unpackhi_epi8( a, b );
+
+        _mm256_storeu_si256( (__m256i *)&dst[2 * i],
+                             _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+        _mm256_storeu_si256( (__m256i *)&dst[2 * i + 32],
+                             _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+    }
+    Interleave8C( &dst[2 * i], &u[i], &v[i], n - i );
+}
+
+VLC_TARGET
+static void Deinterleave8AVX2( uint8_t *u, uint8_t *v, const uint8_t *src,
+                               unsigned n )
+{
+    const __m256i mask = _mm256_set1_epi16( 0xff );
+    unsigned i = 0;
+
+    for( ; i + 32 <= n; i += 32 )
+    {
+        const __m256i a = _mm256_loadu_si256( (const __m256i *)&src[2 * i] );
+        const __m256i b = _mm256_loadu_si256( (const __m256i *)&src[2 * i + 32] );
+        const __m256i eu = _mm256_packus_epi16( _mm256_and_si256( a, mask ),
+                                                _mm256_and_si256( b, mask ) );
+        const __m256i ev = _mm256_packus_epi16( _mm256_srli_epi16( a, 8 ),
+                                                _mm256_srli_epi16( b, 8 ) );
+
+        _mm256_storeu_si256( (__m256i *)&u[i],
+                             _mm256_permute4x64_epi64( eu, 0xd8 ) );
+        _mm256_storeu_si256( (__m256i *)&v[i],
+                             _mm256_permute4x64_epi64( ev, 0xd8 ) );
+    }
+    Deinterleave8C( &u[i], &v[i], &src[2 * i], n - i );
+}
+
+VLC_TARGET
+static void Interleave16AVX2( uint16_t *dst, const uint16_t *u,
+                              const uint16_t *v, unsigned n, unsigned shift )
+{
+    const __m128i count = _mm_cvtsi32_si128( shift );
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m256i a = _mm256_sll_epi16(
+            _mm256_loadu_si256( (const __m256i *)&u[i] ), count );
+        const __m256i b = _mm256_sll_epi16(
+            _mm256_loadu_si256( (const __m256i *)&v[i] ), count );
+        const __m256i lo = _mm256_unpacklo_epi16( a, b );
+        const __m256i hi = _mm256_unpackhi_epi16( a, b );
+
+        _mm256_storeu_si256( (__m256i *)&dst[2 * i],
+                             _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+        _mm256_storeu_si256( (__m256i *)&dst[2 * i + 16],
+                             _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+    }
+    Interleave16C( &dst[2 * i], &u[i], &v[i], n - i, shift );
+}
+
+VLC_TARGET
+static void Deinterleave16AVX2( uint16_t *u, uint16_t *v, const uint16_t *src,
+                                unsigned n, unsigned shift )
+{
+    const __m128i count = _mm_cvtsi32_si128( shift );
+    const __m256i mask = _mm256_set1_epi32( 0xffff );
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+    {
+        const __m256i a = _mm256_srl_epi16(
+            _mm256_loadu_si256( (const __m256i *)&src[2 * i] ), count );
+        const __m256i b = _mm256_srl_epi16(
+            _mm256_loadu_si256( (const __m256i *)&src[2 * i + 16] ), count );
+        const __m256i eu = _mm256_packus_epi32( _mm256_and_si256( a, mask ),
+                                                _mm256_and_si256( b, mask ) );
+        const __m256i ev = _mm256_packus_epi32( _mm256_srli_epi32( a, 16 ),
+                                                _mm256_srli_epi32( b, 16 ) );
+
+        _mm256_storeu_si256( (__m256i *)&u[i],
+                             _mm256_permute4x64_epi64( eu, 0xd8 ) );
+        _mm256_storeu_si256( (__m256i *)&v[i],
+                             _mm256_permute4x64_epi64( ev, 0xd8 ) );
+    }
+    Deinterleave16C( &u[i], &v[i], &src[2 * i], n - i, shift );
+}
+
+VLC_TARGET
+static void ShiftLeft16AVX2( uint16_t *dst, const uint16_t *src, unsigned n,
+                             unsigned shift )
+{
+    const __m128i count = _mm_cvtsi32_si128( shift );
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+        _mm256_storeu_si256( (__m256i *)&dst[i], _mm256_sll_epi16(
+            _mm256_loadu_si256( (const __m256i *)&src[i] ), count ) );
+    ShiftLeft16C( &dst[i], &src[i], n - i, shift );
+}
+
+VLC_TARGET
+static void ShiftRight16AVX2( uint16_t *dst, const uint16_t *src, unsigned n,
+                              unsigned shift )
+{
+    const __m128i count = _mm_cvtsi32_si128( shift );
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+        _mm256_storeu_si256( (__m256i *)&dst[i], _mm256_srl_epi16(
+            _mm256_loadu_si256( (const __m256i *)&src[i] ), count ) );
+    ShiftRight16C( &dst[i], &src[i], n - i, shift );
+}
+
+VLC_TARGET
+static void Average8AVX2( uint8_t *dst, const uint8_t *a, const uint8_t *b,
+                          unsigned n )
+{
+    unsigned i = 0;
+
+    for( ; i + 32 <= n; i += 32 )
+        _mm256_storeu_si256( (__m256i *)&dst[i], _mm256_avg_epu8(
+            _mm256_loadu_si256( (const __m256i *)&a[i] ),
+            _mm256_loadu_si256( (const __m256i *)&b[i] ) ) );
+    Average8C( &dst[i], &a[i], &b[i], n - i );
+}
+
+VLC_TARGET
+static void Average16AVX2( uint16_t *dst, const uint16_t *a, const uint16_t *b,
+                           unsigned n )
+{
+    unsigned i = 0;
+
+    for( ; i + 16 <= n; i += 16 )
+        _mm256_storeu_si256( (__m256i *)&dst[i], _mm256_avg_epu16(
+            _mm256_loadu_si256( (const __m256i *)&a[i] ),
+            _mm256_loadu_si256( (const __m256i *)&b[i] ) ) );
+    Average16C( &dst[i], &a[i], &b[i], n - i );
+}
+
+/* Converts 16 pixels, given their luma and their 8 chroma samples in 16 bits
+ * lanes with the offsets removed. The chroma contributions are computed once
+ * per chroma sample with pmaddwd on (u, v) pairs, then duplicated to match
+ * the order of the luma products: unpacklo/hi work within 128 bits lanes,
+ * so both hold pixels 0-3 and 8-11, then 4-7 and 12-15. */
+VLC_TARGET
+static inline void YuvToRgba16Pixels( uint8_t *dst, __m256i y, __m128i u,
+                                      __m128i v, const yuv_rgb_t *p )
+{
+    const __m256i one = _mm256_set1_epi16( 1 );
+    const __m256i cy = _mm256_set1_epi32( (1 << (16 + p->i_shift - 1))
+                                          | (uint16_t)p->i_cy );
+    const __m256i cr = _mm256_set1_epi32( (uint32_t)(uint16_t)p->i_crv << 16 );
+    const __m256i cg = _mm256_set1_epi32( ((uint32_t)(uint16_t)p->i_cgv << 16)
+                                          | (uint16_t)p->i_cgu );
+    const __m256i cb = _mm256_set1_epi32( (uint16_t)p->i_cbu );
+    const __m128i count = _mm_cvtsi32_si128( p->i_shift );
+
+    const __m256i uv = _mm256_set_m128i( _mm_unpackhi_epi16( u, v ),
+                                         _mm_unpacklo_epi16( u, v ) );
+    const __m256i lum_lo = _mm256_madd_epi16( _mm256_unpacklo_epi16( y, one ),
+                                              cy );
+    const __m256i lum_hi = _mm256_madd_epi16( _mm256_unpackhi_epi16( y, one ),
+                                              cy );
+    __m256i rgb[3];
+    const __m256i coefs[3] = { cr, cg, cb };
+
+    for( int i = 0; i < 3; i++ )
+    {
+        const __m256i c = _mm256_madd_epi16( uv, coefs[i] );
+        const __m256i lo = _mm256_sra_epi32(
+            _mm256_add_epi32( lum_lo, _mm256_unpacklo_epi32( c, c ) ), count );
+        const __m256i hi = _mm256_sra_epi32(
+            _mm256_add_epi32( lum_hi, _mm256_unpackhi_epi32( c, c ) ), count );
+        rgb[i] = _mm256_packs_epi32( lo, hi );
+    }
+
+    /* Per 128 bits lane: 8 first components then 8 second components,
+     * shuffled into pairs */
+    const __m256i pairs = _mm256_setr_epi8(
+        0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15,
+        0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15 );
+    const __m256i first = p->b_bgra ? rgb[2] : rgb[0];
+    const __m256i third = p->b_bgra ? rgb[0] : rgb[2];
+    const __m256i xg = _mm256_shuffle_epi8(
+        _mm256_packus_epi16( first, rgb[1] ), pairs );
+    const __m256i za = _mm256_shuffle_epi8(
+        _mm256_packus_epi16( third, _mm256_set1_epi16( 0xff ) ), pairs );
+    const __m256i lo = _mm256_unpacklo_epi16( xg, za );
+    const __m256i hi = _mm256_unpackhi_epi16( xg, za );
+
+    _mm256_storeu_si256( (__m256i *)&dst[0],
+                         _mm256_permute2x128_si256( lo, hi, 0x20 ) );
+    _mm256_storeu_si256( (__m256i *)&dst[32],
+                         _mm256_permute2x128_si256( lo, hi, 0x31 ) );
+}
+
+VLC_TARGET
+static void YuvToRgba8AVX2( uint8_t *dst, const uint8_t *y, const uint8_t *u,
+                            const uint8_t *v, unsigned width,
+                            const yuv_rgb_t *p )
+{
+    const __m256i y_offset = _mm256_set1_epi16( p->i_y_offset );
+    const __m128i c_offset = _mm_set1_epi16( p->i_c_offset );
+    unsigned x = 0;
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        const __m256i yy = _mm256_sub_epi16( _mm256_cvtepu8_epi16(
+            _mm_loadu_si128( (const __m128i *)&y[x] ) ), y_offset );
+        const __m128i uu = _mm_sub_epi16( _mm_cvtepu8_epi16(
+            _mm_loadl_epi64( (const __m128i *)&u[x / 2] ) ), c_offset );
+        const __m128i vv = _mm_sub_epi16( _mm_cvtepu8_epi16(
+            _mm_loadl_epi64( (const __m128i *)&v[x / 2] ) ), c_offset );
+
+        YuvToRgba16Pixels( &dst[4 * x], yy, uu, vv, p );
+    }
+    YuvToRgba8C( &dst[4 * x], &y[x], &u[x / 2], &v[x / 2], width - x, p );
+}
+
+VLC_TARGET
+static void YuvToRgba16AVX2( uint8_t *dst, const uint16_t *y,
+                             const uint16_t *u, const uint16_t *v,
+                             unsigned width, const yuv_rgb_t *p )
+{
+    const __m256i y_offset = _mm256_set1_epi16( p->i_y_offset );
+    const __m128i c_offset = _mm_set1_epi16( p->i_c_offset );
+    unsigned x = 0;
+
+    for( ; x + 16 <= width; x += 16 )
+    {
+        const __m256i yy = _mm256_sub_epi16(
+            _mm256_loadu_si256( (const __m256i *)&y[x] ), y_offset );
+        const __m128i uu = _mm_sub_epi16(
+            _mm_loadu_si128( (const __m128i *)&u[x / 2] ), c_offset );
+        const __m128i vv = _mm_sub_epi16(
+            _mm_loadu_si128( (const __m128i *)&v[x / 2] ), c_offset );
+
+        YuvToRgba16Pixels( &dst[4 * x], yy, uu, vv, p );
+    }
+    YuvToRgba16C( &dst[4 * x], &y[x], &u[x / 2], &v[x / 2], width - x, p );
+}
+
+static const chroma_kernels_t kernels_avx2 = {
+    Interleave8AVX2, Deinterleave8AVX2, Interleave16AVX2, Deinterleave16AVX2,
+    ShiftLeft16AVX2, ShiftRight16AVX2, Average8AVX2, Average16AVX2,
+    YuvToRgba8AVX2, YuvToRgba16AVX2,
+};
+#undef VLC_TARGET
+#endif
+
+/*****************************************************************************
+ * Picture conversions
+ *****************************************************************************/
+
+struct filter_sys_t
+{
+    void (*pf_convert)( filter_t *, picture_t *, picture_t * );
+    const chroma_kernels_t *kernels;
+    unsigned i_width;
+    unsigned i_height;
+    unsigned i_pixel_size;
+    unsigned i_ry; /* vertical chroma subsampling of the YUV to RGBA input */
+    bool b_swap_uv;
+    yuv_rgb_t yuv_rgb;
+};
+
+#define LINE(pic, plane, y) \
+    (&(pic)->p[plane].p_pixels[(y) * (pic)->p[plane].i_pitch])
+
+static void CopyLuma( filter_sys_t *p_sys, picture_t *p_src, picture_t *p_dst )
+{
+    for( unsigned y = 0; y < p_sys->i_height; y++ )
+        memcpy( LINE(p_dst, Y_PLANE, y), LINE(p_src, Y_PLANE, y),
+                p_sys->i_width * p_sys->i_pixel_size );
+}
+
+/* I420, J420 and YV12 to NV12; I420_10L to P010 */
+static void PlanarToSemiPlanar( filter_t *p_filter, picture_t *p_src,
+                                picture_t *p_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_cwidth = (p_sys->i_width + 1) / 2;
+    const int u = p_sys->b_swap_uv ? V_PLANE : U_PLANE;
+    const int v = p_sys->b_swap_uv ? U_PLANE : V_PLANE;
+
+    if( p_sys->i_pixel_size == 1 )
+    {
+        CopyLuma( p_sys, p_src, p_dst );
+        for( unsigned y = 0; y < (p_sys->i_height + 1) / 2; y++ )
+            p_sys->kernels->interleave8( LINE(p_dst, 1, y),
+                                         LINE(p_src, u, y),
+                                         LINE(p_src, v, y), i_cwidth );
+    }
+    else
+    {
+        for( unsigned y = 0; y < p_sys->i_height; y++ )
+            p_sys->kernels->shift_left16( (uint16_t *)LINE(p_dst, Y_PLANE, y),
+                                          (const uint16_t *)LINE(p_src, Y_PLANE, y),
+                                          p_sys->i_width, 6 );
+        for( unsigned y = 0; y < (p_sys->i_height + 1) / 2; y++ )
+            p_sys->kernels->interleave16( (uint16_t *)LINE(p_dst, 1, y),
+                                          (const uint16_t *)LINE(p_src, u, y),
+                                          (const uint16_t *)LINE(p_src, v, y),
+                                          i_cwidth, 6 );
+    }
+}
+
+/* NV12 to I420, J420 and YV12; P010 to I420_10L */
+static void SemiPlanarToPlanar( filter_t *p_filter, picture_t *p_src,
+                                picture_t *p_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_cwidth = (p_sys->i_width + 1) / 2;
+    const int u = p_sys->b_swap_uv ? V_PLANE : U_PLANE;
+    const int v = p_sys->b_swap_uv ? U_PLANE : V_PLANE;
+
+    if( p_sys->i_pixel_size == 1 )
+    {
+        CopyLuma( p_sys, p_src, p_dst );
+        for( unsigned y = 0; y < (p_sys->i_height + 1) / 2; y++ )
+            p_sys->kernels->deinterleave8( LINE(p_dst, u, y),
+                                           LINE(p_dst, v, y),
+                                           LINE(p_src, 1, y), i_cwidth );
+    }
+    else
+    {
+        for( unsigned y = 0; y < p_sys->i_height; y++ )
+            p_sys->kernels->shift_right16( (uint16_t *)LINE(p_dst, Y_PLANE, y),
+                                           (const uint16_t *)LINE(p_src, Y_PLANE, y),
+                                           p_sys->i_width, 6 );
+        for( unsigned y = 0; y < (p_sys->i_height + 1) / 2; y++ )
+            p_sys->kernels->deinterleave16( (uint16_t *)LINE(p_dst, u, y),
+                                            (uint16_t *)LINE(p_dst, v, y),
+                                            (const uint16_t *)LINE(p_src, 1, y),
+                                            i_cwidth, 6 );
+    }
+}
+
+/* I422 and J422 to I420, J420 and YV12; I422_10L to I420_10L: each chroma
+ * line is the average of two source lines */
+static void I422ToI420( filter_t *p_filter, picture_t *p_src,
+                        picture_t *p_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const unsigned i_cwidth = (p_sys->i_width + 1) / 2;
+
+    CopyLuma( p_sys, p_src, p_dst );
+    for( int plane = U_PLANE; plane <= V_PLANE; plane++ )
+    {
+        const int i_dst_plane = p_sys->b_swap_uv ? V_PLANE + U_PLANE - plane
+                                                 : plane;
+
+        for( unsigned y = 0; y < (p_sys->i_height + 1) / 2; y++ )
+        {
+            const unsigned y1 = __MIN(2 * y + 1, p_sys->i_height - 1);
+
+            if( p_sys->i_pixel_size == 1 )
+                p_sys->kernels->average8( LINE(p_dst, i_dst_plane, y),
+                                          LINE(p_src, plane, 2 * y),
+                                          LINE(p_src, plane, y1), i_cwidth );
+            else
+                p_sys->kernels->average16( (uint16_t *)LINE(p_dst, i_dst_plane, y),
+                                           (const uint16_t *)LINE(p_src, plane, 2 * y),
+                                           (const uint16_t *)LINE(p_src, plane, y1),
+                                           i_cwidth );
+        }
+    }
+}
+
+/* 4:2:0 and 4:2:2 planar YUV to RGBA and BGRA */
+static void YuvToRgba( filter_t *p_filter, picture_t *p_src,
+                       picture_t *p_dst )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    const int u = p_sys->b_swap_uv ? V_PLANE : U_PLANE;
+    const int v = p_sys->b_swap_uv ? U_PLANE : V_PLANE;
+
+    for( unsigned y = 0; y < p_sys->i_height; y++ )
+    {
+        const unsigned cy = y / p_sys->i_ry;
+
+        if( p_sys->i_pixel_size == 1 )
+            p_sys->kernels->yuv_rgba8( LINE(p_dst, 0, y),
+                                       LINE(p_src, Y_PLANE, y),
+                                       LINE(p_src, u, cy), LINE(p_src, v, cy),
+                                       p_sys->i_width, &p_sys->yuv_rgb );
+        else
+            p_sys->kernels->yuv_rgba16( LINE(p_dst, 0, y),
+                                        (const uint16_t *)LINE(p_src, Y_PLANE, y),
+                                        (const uint16_t *)LINE(p_src, u, cy),
+                                        (const uint16_t *)LINE(p_src, v, cy),
+                                        p_sys->i_width, &p_sys->yuv_rgb );
+    }
+}
+
+static void Convert( filter_t *p_filter, picture_t *p_src, picture_t *p_dst )
+{
+    p_filter->p_sys->pf_convert( p_filter, p_src, p_dst );
+}
+
+VIDEO_FILTER_WRAPPER( Convert )
+
+/*****************************************************************************
+ * YUV to RGB coefficients
+ *****************************************************************************/
+static void SetupYuvRgb( yuv_rgb_t *p, const video_format_t *p_fmt,
+                         unsigned i_depth )
+{
+    static const struct { float kr, kb; } weights[] = {
+        [COLOR_SPACE_BT601]  = { 0.299f,  0.114f  },
+        [COLOR_SPACE_BT709]  = { 0.2126f, 0.0722f },
+        [COLOR_SPACE_BT2020] = { 0.2627f, 0.0593f },
+    };
+    video_color_space_t space = p_fmt->space;
+
+    if( space != COLOR_SPACE_BT601 && space != COLOR_SPACE_BT709
+     && space != COLOR_SPACE_BT2020 )
+        space = p_fmt->i_visible_height > 576 ? COLOR_SPACE_BT709
+                                              : COLOR_SPACE_BT601;
+
+    const bool b_full = p_fmt->b_color_range_full
+                     || p_fmt->i_chroma == VLC_CODEC_J420
+                     || p_fmt->i_chroma == VLC_CODEC_J422;
+    const float kr = weights[space].kr, kb = weights[space].kb;
+    const float kg = 1.f - kr - kb;
+    const float ky = b_full ? 1.f : 255.f / 219.f;
+    const float kc = b_full ? 1.f : 255.f / 224.f;
+    const float q = 1 << 13;
+
+    p->i_y_offset = b_full ? 0 : 16 << (i_depth - 8);
+    p->i_c_offset = 128 << (i_depth - 8);
+    p->i_cy  = lroundf( ky * q );
+    p->i_crv = lroundf( 2.f * (1.f - kr) * kc * q );
+    p->i_cgu = lroundf( -2.f * (1.f - kb) * kb / kg * kc * q );
+    p->i_cgv = lroundf( -2.f * (1.f - kr) * kr / kg * kc * q );
+    p->i_cbu = lroundf( 2.f * (1.f - kb) * kc * q );
+    p->i_shift = 13 + i_depth - 8;
+}
+
+/*****************************************************************************
+ * Open: probe the conversion
+ *****************************************************************************/
+static int Open( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+    const video_format_t *p_in = &p_filter->fmt_in.video;
+    const video_format_t *p_out = &p_filter->fmt_out.video;
+    const chroma_kernels_t *p_kernels;
+
+#ifdef HAVE_CHROMA_AVX2
+    if( vlc_CPU_AVX2() )
+        p_kernels = &kernels_avx2;
+    else
+#endif
+        return VLC_EGENERIC;
+
+    /* resizing not supported */
+    if( p_in->i_x_offset + p_in->i_visible_width !=
+            p_out->i_x_offset + p_out->i_visible_width
+     || p_in->i_y_offset + p_in->i_visible_height !=
+            p_out->i_y_offset + p_out->i_visible_height
+     || p_in->orientation != p_out->orientation )
+        return VLC_EGENERIC;
+
+    void (*pf_convert)( filter_t *, picture_t *, picture_t * ) = NULL;
+    bool b_swap_uv = false;
+
+    switch( p_in->i_chroma )
+    {
+        case VLC_CODEC_YV12:
+            b_swap_uv = true;
+            /* fall through */
+        case VLC_CODEC_I420:
+        case VLC_CODEC_J420:
+            if( p_out->i_chroma == VLC_CODEC_NV12 )
+                pf_convert = PlanarToSemiPlanar;
+            break;
+        case VLC_CODEC_I420_10L:
+            if( p_out->i_chroma == VLC_CODEC_P010 )
+                pf_convert = PlanarToSemiPlanar;
+            break;
+        case VLC_CODEC_NV12:
+            if( p_out->i_chroma == VLC_CODEC_I420
+             || p_out->i_chroma == VLC_CODEC_J420 )
+                pf_convert = SemiPlanarToPlanar;
+            else if( p_out->i_chroma == VLC_CODEC_YV12 )
+            {
+                pf_convert = SemiPlanarToPlanar;
+                b_swap_uv = true;
+            }
+            break;
+        case VLC_CODEC_P010:
+            if( p_out->i_chroma == VLC_CODEC_I420_10L )
+                pf_convert = SemiPlanarToPlanar;
+            break;
+        case VLC_CODEC_I422:
+        case VLC_CODEC_J422:
+            if( p_out->i_chroma == VLC_CODEC_I420
+             || p_out->i_chroma == VLC_CODEC_J420 )
+                pf_convert = I422ToI420;
+            else if( p_out->i_chroma == VLC_CODEC_YV12 )
+            {
+                pf_convert = I422ToI420;
+                b_swap_uv = true;
+            }
+            break;
+        case VLC_CODEC_I422_10L:
+            if( p_out->i_chroma == VLC_CODEC_I420_10L )
+                pf_convert = I422ToI420;
+            break;
+    }
+
+    bool b_bgra = false;
+    if( pf_convert == NULL )
+    {
+        switch( p_in->i_chroma )
+        {
+            case VLC_CODEC_YV12:
+                b_swap_uv = true;
+                break;
+            case VLC_CODEC_I420:
+            case VLC_CODEC_J420:
+            case VLC_CODEC_I422:
+            case VLC_CODEC_J422:
+            case VLC_CODEC_I420_10L:
+            case VLC_CODEC_I422_10L:
+                break;
+            default:
+                return VLC_EGENERIC;
+        }
+
+        switch( p_out->i_chroma )
+        {
+            case VLC_CODEC_RGBA:
+                break;
+            case VLC_CODEC_BGRA:
+                b_bgra = true;
+                break;
+            case VLC_CODEC_RGB32:
+            {
+                /* Only the layout matching BGRA in memory */
+                video_format_t fmt = *p_out;
+                video_format_FixRgb( &fmt );
+#ifdef WORDS_BIGENDIAN
+                if( fmt.i_rmask != 0x0000ff00 || fmt.i_gmask != 0x00ff0000
+                 || fmt.i_bmask != 0xff000000 )
+#else
+                if( fmt.i_rmask != 0x00ff0000 || fmt.i_gmask != 0x0000ff00
+                 || fmt.i_bmask != 0x000000ff )
+#endif
+                    return VLC_EGENERIC;
+                b_bgra = true;
+                break;
+            }
+            default:
+                return VLC_EGENERIC;
+        }
+        pf_convert = YuvToRgba;
+    }
+
+    const vlc_chroma_description_t *p_desc =
+        vlc_fourcc_GetChromaDescription( p_in->i_chroma );
+    filter_sys_t *p_sys = malloc( sizeof(*p_sys) );
+    if( unlikely(p_sys == NULL) )
+        return VLC_ENOMEM;
+
+    p_sys->pf_convert = pf_convert;
+    p_sys->kernels = p_kernels;
+    p_sys->i_width = p_in->i_x_offset + p_in->i_visible_width;
+    p_sys->i_height = p_in->i_y_offset + p_in->i_visible_height;
+    p_sys->i_pixel_size = p_desc->pixel_size;
+    p_sys->i_ry = p_desc->p[U_PLANE].h.den;
+    p_sys->b_swap_uv = b_swap_uv;
+    if( pf_convert == YuvToRgba )
+    {
+        SetupYuvRgb( &p_sys->yuv_rgb, p_in, p_desc->pixel_bits );
+        p_sys->yuv_rgb.b_bgra = b_bgra;
+    }
+
+    p_filter->p_sys = p_sys;
+    p_filter->pf_video_filter = Convert_Filter;
+
+    msg_Dbg( p_filter, "%4.4s to %4.4s conversion",
+             (const char *)&p_in->i_chroma, (const char *)&p_out->i_chroma );
+    return VLC_SUCCESS;
+}
+
+static void Close( vlc_object_t *p_this )
+{
+    filter_t *p_filter = (filter_t *)p_this;
+
+    free( p_filter->p_sys );
+}
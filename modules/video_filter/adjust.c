@@ -222,6 +222,177 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
+/*****************************************************************************
+ * Slices of the picture, processed in parallel
+ *****************************************************************************/
+typedef struct
+{
+    picture_t *p_in;
+    picture_t *p_out;
+    const int *pi_luma;
+    bool b_16bit;
+    int i_y_offset;
+
+    int (*pf_sat_hue)( picture_t *, picture_t *, int, int, int, int, int );
+    int i_sin, i_cos, i_sat, i_x, i_y;
+} adjust_slice_t;
+
+static void PlanarSlice( filter_t *p_filter, void *opaque,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const adjust_slice_t *p_slice = opaque;
+    const int *pi_luma = p_slice->pi_luma;
+    picture_t pic, outpic;
+    picture_t *p_pic = &pic, *p_outpic = &outpic;
+
+    VLC_UNUSED(p_filter);
+    SlicePicture( p_pic, p_slice->p_in, i_slice, i_slices );
+    SlicePicture( p_outpic, p_slice->p_out, i_slice, i_slices );
+
+    /*
+     * Do the Y plane
+     */
+    if ( p_slice->b_16bit )
+    {
+        uint16_t *p_in, *p_in_end, *p_line_end;
+        uint16_t *p_out;
+        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
+        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
+            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
+
+        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
+                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
+            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
+                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
+        }
+    }
+    else
+    {
+        uint8_t *p_in, *p_in_end, *p_line_end;
+        uint8_t *p_out;
+        p_in = p_pic->p[Y_PLANE].p_pixels;
+        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
+                 * p_pic->p[Y_PLANE].i_pitch - 8;
+
+        p_out = p_outpic->p[Y_PLANE].p_pixels;
+
+        for( ; p_in < p_in_end ; )
+        {
+            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                /* Do 8 pixels at a time */
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_line_end += 8;
+
+            for( ; p_in < p_line_end ; )
+            {
+                *p_out++ = pi_luma[ *p_in++ ];
+            }
+
+            p_in += p_pic->p[Y_PLANE].i_pitch
+                  - p_pic->p[Y_PLANE].i_visible_pitch;
+            p_out += p_outpic->p[Y_PLANE].i_pitch
+                   - p_outpic->p[Y_PLANE].i_visible_pitch;
+        }
+    }
+
+    /*
+     * Do the U and V planes
+     */
+    p_slice->pf_sat_hue( p_pic, p_outpic, p_slice->i_sin, p_slice->i_cos,
+                         p_slice->i_sat, p_slice->i_x, p_slice->i_y );
+}
+
+static void PackedSlice( filter_t *p_filter, void *opaque,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const adjust_slice_t *p_slice = opaque;
+    const int *pi_luma = p_slice->pi_luma;
+    picture_t pic, outpic;
+    picture_t *p_pic = &pic, *p_outpic = &outpic;
+    uint8_t *p_in, *p_in_end, *p_line_end;
+    uint8_t *p_out;
+
+    VLC_UNUSED(p_filter);
+    SlicePicture( p_pic, p_slice->p_in, i_slice, i_slices );
+    SlicePicture( p_outpic, p_slice->p_out, i_slice, i_slices );
+
+    const int i_pitch = p_pic->p->i_pitch;
+    const int i_visible_pitch = p_pic->p->i_visible_pitch;
+
+    /*
+     * Do the Y plane
+     */
+
+    p_in = p_pic->p->p_pixels + p_slice->i_y_offset;
+    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
+
+    p_out = p_outpic->p->p_pixels + p_slice->i_y_offset;
+
+    for( ; p_in < p_in_end ; )
+    {
+        p_line_end = p_in + i_visible_pitch - 8 * 4;
+
+        for( ; p_in < p_line_end ; )
+        {
+            /* Do 8 pixels at a time */
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+        }
+
+        p_line_end += 8 * 4;
+
+        for( ; p_in < p_line_end ; )
+        {
+            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
+        }
+
+        p_in += i_pitch - p_pic->p->i_visible_pitch;
+        p_out += i_pitch - p_outpic->p->i_visible_pitch;
+    }
+
+    /*
+     * Do the U and V planes
+     */
+    p_slice->pf_sat_hue( p_pic, p_outpic, p_slice->i_sin, p_slice->i_cos,
+                         p_slice->i_sat, p_slice->i_x, p_slice->i_y );
+}
+
 /*****************************************************************************
  * Run the filter on a Planar YUV picture
  *****************************************************************************/
@@ -316,82 +487,6 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-    if ( b_16bit )
-    {
-        uint16_t *p_in, *p_in_end, *p_line_end;
-        uint16_t *p_out;
-        p_in = (uint16_t *) p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-            * (p_pic->p[Y_PLANE].i_pitch >> 1) - 8;
-
-        p_out = (uint16_t *) p_outpic->p[Y_PLANE].p_pixels;
-
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + (p_pic->p[Y_PLANE].i_visible_pitch >> 1) - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += (p_pic->p[Y_PLANE].i_pitch >> 1)
-                - (p_pic->p[Y_PLANE].i_visible_pitch >> 1);
-            p_out += (p_outpic->p[Y_PLANE].i_pitch >> 1)
-                - (p_outpic->p[Y_PLANE].i_visible_pitch >> 1);
-        }
-    }
-    else
-    {
-        uint8_t *p_in, *p_in_end, *p_line_end;
-        uint8_t *p_out;
-        p_in = p_pic->p[Y_PLANE].p_pixels;
-        p_in_end = p_in + p_pic->p[Y_PLANE].i_visible_lines
-                 * p_pic->p[Y_PLANE].i_pitch - 8;
-
-        p_out = p_outpic->p[Y_PLANE].p_pixels;
-
-        for( ; p_in < p_in_end ; )
-        {
-            p_line_end = p_in + p_pic->p[Y_PLANE].i_visible_pitch - 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                /* Do 8 pixels at a time */
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-                *p_out++ = pi_luma[ *p_in++ ]; *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_line_end += 8;
-
-            for( ; p_in < p_line_end ; )
-            {
-                *p_out++ = pi_luma[ *p_in++ ];
-            }
-
-            p_in += p_pic->p[Y_PLANE].i_pitch
-                  - p_pic->p[Y_PLANE].i_visible_pitch;
-            p_out += p_outpic->p[Y_PLANE].i_pitch
-                   - p_outpic->p[Y_PLANE].i_visible_pitch;
-        }
-    }
-
     /*
      * Do the U and V planes
      */
@@ -403,20 +498,19 @@ static picture_t *FilterPlanar( filter_t *p_filter, picture_t *p_pic )
     int i_x = ( cosf(f_hue) + sinf(f_hue) ) * f_range * i_mid;
     int i_y = ( cosf(f_hue) - sinf(f_hue) ) * f_range * i_mid;
 
-    if ( i_sat > i_range )
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
-    else
-    {
-        /* Currently no errors are implemented in the function, if any are added
-         * check them here */
-        p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y );
-    }
+    adjust_slice_t slice = {
+        .p_in = p_pic, .p_out = p_outpic, .pi_luma = pi_luma,
+        .b_16bit = b_16bit,
+        /* Currently no errors are implemented in the functions, if any are
+         * added check them here */
+        .pf_sat_hue = i_sat > i_range ? p_sys->pf_process_sat_hue_clip
+                                      : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    filter_RunSlices( p_filter,
+                      filter_GetSliceCount( p_filter,
+                                            p_pic->p[Y_PLANE].i_visible_lines ),
+                      PlanarSlice, &slice );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -430,12 +524,8 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     int pi_gamma[256];
 
     picture_t *p_outpic;
-    uint8_t *p_in, *p_in_end, *p_line_end;
-    uint8_t *p_out;
     int i_y_offset, i_u_offset, i_v_offset;
 
-    int i_pitch, i_visible_pitch;
-
     bool b_thres;
     double  f_hue;
     double  f_gamma;
@@ -446,9 +536,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
 
     if( !p_pic ) return NULL;
 
-    i_pitch = p_pic->p->i_pitch;
-    i_visible_pitch = p_pic->p->i_visible_pitch;
-
     if( GetPackedYuvOffsets( p_pic->format.i_chroma, &i_y_offset,
                              &i_u_offset, &i_v_offset ) != VLC_SUCCESS )
     {
@@ -517,43 +604,6 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
         i_sat = 0;
     }
 
-    /*
-     * Do the Y plane
-     */
-
-    p_in = p_pic->p->p_pixels + i_y_offset;
-    p_in_end = p_in + p_pic->p->i_visible_lines * p_pic->p->i_pitch - 8 * 4;
-
-    p_out = p_outpic->p->p_pixels + i_y_offset;
-
-    for( ; p_in < p_in_end ; )
-    {
-        p_line_end = p_in + i_visible_pitch - 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            /* Do 8 pixels at a time */
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_line_end += 8 * 4;
-
-        for( ; p_in < p_line_end ; )
-        {
-            *p_out = pi_luma[ *p_in ]; p_in += 2; p_out += 2;
-        }
-
-        p_in += i_pitch - p_pic->p->i_visible_pitch;
-        p_out += i_pitch - p_outpic->p->i_visible_pitch;
-    }
-
     /*
      * Do the U and V planes
      */
@@ -564,32 +614,17 @@ static picture_t *FilterPacked( filter_t *p_filter, picture_t *p_pic )
     i_x = ( cos(f_hue) + sin(f_hue) ) * 32768;
     i_y = ( cos(f_hue) - sin(f_hue) ) * 32768;
 
-    if ( i_sat > 256 )
-    {
-        if ( p_sys->pf_process_sat_hue_clip( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                             i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
-    }
-    else
-    {
-        if ( p_sys->pf_process_sat_hue( p_pic, p_outpic, i_sin, i_cos, i_sat,
-                                        i_x, i_y ) != VLC_SUCCESS )
-        {
-            /* Currently only one error can happen in the function, but if there
-             * will be more of them, this message must go away */
-            msg_Warn( p_filter, "Unsupported input chroma (%4.4s)",
-                      (char*)&(p_pic->format.i_chroma) );
-            picture_Release( p_pic );
-            return NULL;
-        }
-    }
+    /* The chroma was checked above, the sat/hue functions cannot fail */
+    adjust_slice_t slice = {
+        .p_in = p_pic, .p_out = p_outpic, .pi_luma = pi_luma,
+        .i_y_offset = i_y_offset,
+        .pf_sat_hue = i_sat > 256 ? p_sys->pf_process_sat_hue_clip
+                                  : p_sys->pf_process_sat_hue,
+        .i_sin = i_sin, .i_cos = i_cos, .i_sat = i_sat, .i_x = i_x, .i_y = i_y,
+    };
+    filter_RunSlices( p_filter,
+                      filter_GetSliceCount( p_filter, p_pic->p->i_visible_lines ),
+                      PackedSlice, &slice );
 
     return CopyInfoAndRelease( p_outpic, p_pic );
 }
@@ -28,8 +28,11 @@
 # include "config.h"
 #endif
 
+#include <algorithm>
+
 #include <vlc_common.h>
 #include <vlc_plugin.h>
+#include <vlc_cpu.h>
 #include <vlc_filter.h>
 #include <vlc_picture.h>
 #include "filter_picture.h"
@@ -60,6 +63,12 @@ void merge(T *dst, unsigned src, unsigned f)
     *dst = div255((255 - f) * (*dst) + src * f);
 }
 
+/* merge() of a source sample with its alpha scaled by the global alpha */
+static inline void BlendSample(uint8_t *dst, unsigned src, unsigned a, int alpha)
+{
+    merge(dst, src, div255(alpha * a));
+}
+
 struct CPixel {
     unsigned i, j, k;
     unsigned a;
@@ -79,6 +88,18 @@ public:
     {
         return fmt;
     }
+    const picture_t *getPicture() const
+    {
+        return picture;
+    }
+    unsigned getX() const
+    {
+        return x;
+    }
+    unsigned getY() const
+    {
+        return y;
+    }
     bool isFull(unsigned) const
     {
         return true;
@@ -623,11 +644,359 @@ static const struct {
 #undef YUV
 };
 
+/*****************************************************************************
+ * SIMD blending of 8 bits sources onto I420, NV12 and RV32
+ *****************************************************************************/
+typedef struct {
+    void (*plane)(uint8_t *, const uint8_t *, const uint8_t *, unsigned, int);
+    void (*plane_sub2)(uint8_t *, const uint8_t *, const uint8_t *, unsigned,
+                       int);
+    void (*packed_sub2)(uint8_t *, const uint8_t *, const uint8_t *,
+                        const uint8_t *, unsigned, int);
+    void (*pixels32)(uint8_t *, const uint8_t *, unsigned, int,
+                     const uint8_t[4], const uint8_t[4]);
+} blend_kernels_t;
+
+#if (defined(CAN_COMPILE_SSSE3) || defined(CAN_COMPILE_AVX2)) && \
+    (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#ifdef CAN_COMPILE_SSSE3
+// ================ SSSE3 =================
+#define HAVE_BLEND_SSSE3
+#define VLC_TARGET __attribute__ ((__target__ ("ssse3")))
+#define RENAME(a) a ## SSSE3
+#define VEC __m128i
+#define STEP 16
+#define V_LOAD(p) _mm_loadu_si128((const __m128i *)(p))
+#define V_STORE(p, v) _mm_storeu_si128((__m128i *)(p), v)
+#define V_SET1_16 _mm_set1_epi16
+#define V_AND _mm_and_si128
+#define V_OR _mm_or_si128
+#define V_ADD16 _mm_add_epi16
+#define V_SUB16 _mm_sub_epi16
+#define V_MUL16 _mm_mullo_epi16
+#define V_SLLI16 _mm_slli_epi16
+#define V_SRLI16 _mm_srli_epi16
+#define V_SHUFFLE _mm_shuffle_epi8
+#define V_WIDEN_LO(v) _mm_unpacklo_epi8(v, _mm_setzero_si128())
+#define V_WIDEN_HI(v) _mm_unpackhi_epi8(v, _mm_setzero_si128())
+#define V_NARROW _mm_packus_epi16
+#include "blend_template.h"
+#undef V_NARROW
+#undef V_WIDEN_HI
+#undef V_WIDEN_LO
+#undef V_SHUFFLE
+#undef V_SRLI16
+#undef V_SLLI16
+#undef V_MUL16
+#undef V_SUB16
+#undef V_ADD16
+#undef V_OR
+#undef V_AND
+#undef V_SET1_16
+#undef V_STORE
+#undef V_LOAD
+#undef STEP
+#undef VEC
+#undef RENAME
+#undef VLC_TARGET
+#endif
+
+#ifdef CAN_COMPILE_AVX2
+// ================= AVX2 =================
+#define HAVE_BLEND_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#define RENAME(a) a ## AVX2
+#define VEC __m256i
+#define STEP 32
+#define V_LOAD(p) _mm256_loadu_si256((const __m256i *)(p))
+#define V_STORE(p, v) _mm256_storeu_si256((__m256i *)(p), v)
+#define V_SET1_16 _mm256_set1_epi16
+#define V_AND _mm256_and_si256
+#define V_OR _mm256_or_si256
+#define V_ADD16 _mm256_add_epi16
+#define V_SUB16 _mm256_sub_epi16
+#define V_MUL16 _mm256_mullo_epi16
+#define V_SLLI16 _mm256_slli_epi16
+#define V_SRLI16 _mm256_srli_epi16
+#define V_SHUFFLE _mm256_shuffle_epi8
+#define V_WIDEN_LO(v) _mm256_cvtepu8_epi16(_mm256_castsi256_si128(v))
+#define V_WIDEN_HI(v) _mm256_cvtepu8_epi16(_mm256_extracti128_si256(v, 1))
+#define V_NARROW(lo, hi) \
+    _mm256_permute4x64_epi64(_mm256_packus_epi16(lo, hi), 0xd8)
+#include "blend_template.h"
+#undef V_NARROW
+#undef V_WIDEN_HI
+#undef V_WIDEN_LO
+#undef V_SHUFFLE
+#undef V_SRLI16
+#undef V_SLLI16
+#undef V_MUL16
+#undef V_SUB16
+#undef V_ADD16
+#undef V_OR
+#undef V_AND
+#undef V_SET1_16
+#undef V_STORE
+#undef V_LOAD
+#undef STEP
+#undef VEC
+#undef RENAME
+#undef VLC_TARGET
+#endif
+#endif
+
+/* Number of source pixels converted at once before blending */
+#define BLEND_CHUNK 256
+
+typedef void (*blend_simd_function_t)(const blend_kernels_t &k,
+                                      const CPicture &dst_data,
+                                      const CPicture &src_data,
+                                      unsigned width, unsigned height,
+                                      int alpha);
+
+/* Blends a segment of a YUVA line starting at column x, chroma included
+ * only on the lines and columns which hold chroma samples */
+template <bool semiplanar>
+static void BlendLine420(const blend_kernels_t &k, uint8_t *const dst[3],
+                         bool chroma, unsigned x,
+                         const uint8_t *const src[4], unsigned count,
+                         int alpha)
+{
+    k.plane(&dst[0][x], src[0], src[3], count, alpha);
+    if (!chroma)
+        return;
+
+    const unsigned dx = x & 1;
+    if (count <= dx)
+        return;
+    const unsigned chroma_count = (count - dx + 1) / 2;
+    if (semiplanar) {
+        k.packed_sub2(&dst[1][(x + dx) & ~1u], &src[1][dx], &src[2][dx],
+                      &src[3][dx], chroma_count, alpha);
+    } else {
+        k.plane_sub2(&dst[1][(x + dx) / 2], &src[1][dx], &src[3][dx],
+                     chroma_count, alpha);
+        k.plane_sub2(&dst[2][(x + dx) / 2], &src[2][dx], &src[3][dx],
+                     chroma_count, alpha);
+    }
+}
+
+/* Planes of a 4:2:0 destination: Y, then U and V or the UV plane */
+template <bool semiplanar, bool swap_uv>
+static void GetLines420(uint8_t *dst[3], const CPicture &data)
+{
+    const picture_t *pic = data.getPicture();
+    const unsigned y = data.getY();
+
+    dst[0] = &pic->p[0].p_pixels[y * pic->p[0].i_pitch];
+    if (semiplanar) {
+        dst[1] = &pic->p[1].p_pixels[y / 2 * pic->p[1].i_pitch];
+        dst[2] = NULL;
+    } else {
+        dst[1] = &pic->p[swap_uv ? 2 : 1].p_pixels[y / 2 * pic->p[swap_uv ? 2 : 1].i_pitch];
+        dst[2] = &pic->p[swap_uv ? 1 : 2].p_pixels[y / 2 * pic->p[swap_uv ? 1 : 2].i_pitch];
+    }
+}
+
+template <bool semiplanar, bool swap_uv>
+static void NextLine420(uint8_t *dst[3], const picture_t *pic, unsigned y)
+{
+    dst[0] += pic->p[0].i_pitch;
+    if (y % 2 == 0) {
+        dst[1] += pic->p[semiplanar || !swap_uv ? 1 : 2].i_pitch;
+        if (!semiplanar)
+            dst[2] += pic->p[swap_uv ? 1 : 2].i_pitch;
+    }
+}
+
+template <bool semiplanar, bool swap_uv>
+static void BlendYUVATo420(const blend_kernels_t &k,
+                           const CPicture &dst_data, const CPicture &src_data,
+                           unsigned width, unsigned height, int alpha)
+{
+    const picture_t *srcpic = src_data.getPicture();
+    const unsigned x = dst_data.getX();
+    unsigned y = dst_data.getY();
+    uint8_t *dst[3];
+    const uint8_t *src[4];
+
+    GetLines420<semiplanar, swap_uv>(dst, dst_data);
+    for (unsigned i = 0; i < 4; i++)
+        src[i] = &srcpic->p[i].p_pixels[src_data.getY() * srcpic->p[i].i_pitch
+                                        + src_data.getX()];
+    /* Swapped NV21 chroma is blended as NV12 with U and V exchanged */
+    if (semiplanar && swap_uv)
+        std::swap(src[1], src[2]);
+
+    for (unsigned line = 0; line < height; line++) {
+        BlendLine420<semiplanar>(k, dst, y % 2 == 0, x, src, width, alpha);
+
+        for (unsigned i = 0; i < 4; i++)
+            src[i] += srcpic->p[i].i_pitch;
+        y++;
+        NextLine420<semiplanar, swap_uv>(dst, dst_data.getPicture(), y);
+    }
+}
+
+template <bool swap_uv>
+static void BlendYUVPTo420(const blend_kernels_t &k,
+                           const CPicture &dst_data, const CPicture &src_data,
+                           unsigned width, unsigned height, int alpha)
+{
+    const picture_t *srcpic = src_data.getPicture();
+    const video_palette_t *palette = src_data.getFormat()->p_palette;
+    const unsigned x = dst_data.getX();
+    unsigned y = dst_data.getY();
+    const uint8_t *index = &srcpic->p[0].p_pixels[src_data.getY() * srcpic->p[0].i_pitch
+                                                  + src_data.getX()];
+    uint8_t planes[4][BLEND_CHUNK];
+    const uint8_t *const src[4] = { planes[0], planes[1], planes[2], planes[3] };
+    uint8_t *dst[3];
+
+    GetLines420<false, swap_uv>(dst, dst_data);
+    for (unsigned line = 0; line < height; line++) {
+        for (unsigned offset = 0; offset < width; offset += BLEND_CHUNK) {
+            const unsigned count = __MIN(width - offset, BLEND_CHUNK);
+
+            for (unsigned i = 0; i < count; i++) {
+                const uint8_t *entry = palette->palette[index[offset + i]];
+                planes[0][i] = entry[0];
+                planes[1][i] = entry[1];
+                planes[2][i] = entry[2];
+                planes[3][i] = entry[3];
+            }
+            BlendLine420<false>(k, dst, y % 2 == 0, x + offset, src, count,
+                                alpha);
+        }
+        index += srcpic->p[0].i_pitch;
+        y++;
+        NextLine420<false, swap_uv>(dst, dst_data.getPicture(), y);
+    }
+}
+
+/* Byte offsets of the components of a 32 bits RGB destination, in a form
+ * usable by the pixels32 kernel, given the R, G, B and alpha offsets within
+ * the source pixels */
+static bool GetShufflesRV32(const video_format_t *fmt, const uint8_t src[4],
+                            uint8_t shuffle_src[4], uint8_t shuffle_a[4])
+{
+    const int shifts[3] = { fmt->i_lrshift, fmt->i_lgshift, fmt->i_lbshift };
+
+    memset(shuffle_src, 0x80, 4);
+    memset(shuffle_a, 0x80, 4);
+    for (unsigned i = 0; i < 3; i++) {
+        if (shifts[i] % 8 || shifts[i] > 24)
+            return false;
+#ifdef WORDS_BIGENDIAN
+        const unsigned offset = (32 - shifts[i]) / 8;
+#else
+        const unsigned offset = shifts[i] / 8;
+#endif
+        if (offset > 3 || shuffle_src[offset] != 0x80)
+            return false;
+        shuffle_src[offset] = src[i];
+        shuffle_a[offset] = src[3];
+    }
+    return true;
+}
+
+static void BlendRGBAToRV32(const blend_kernels_t &k,
+                            const CPicture &dst_data, const CPicture &src_data,
+                            unsigned width, unsigned height, int alpha)
+{
+    static const uint8_t rgba[4] = { 0, 1, 2, 3 };
+    const picture_t *dstpic = dst_data.getPicture();
+    const picture_t *srcpic = src_data.getPicture();
+    uint8_t shuffle_src[4], shuffle_a[4];
+
+    if (!GetShufflesRV32(dst_data.getFormat(), rgba, shuffle_src, shuffle_a)) {
+        Blend<CPictureRGB32, CPictureRGBA, compose<convertNone, convertNone> >(
+            dst_data, src_data, width, height, alpha);
+        return;
+    }
+
+    uint8_t *dst = &dstpic->p[0].p_pixels[dst_data.getY() * dstpic->p[0].i_pitch
+                                          + 4 * dst_data.getX()];
+    const uint8_t *src = &srcpic->p[0].p_pixels[src_data.getY() * srcpic->p[0].i_pitch
+                                                + 4 * src_data.getX()];
+    for (unsigned line = 0; line < height; line++) {
+        k.pixels32(dst, src, width, alpha, shuffle_src, shuffle_a);
+        dst += dstpic->p[0].i_pitch;
+        src += srcpic->p[0].i_pitch;
+    }
+}
+
+static void BlendYUVAToRV32(const blend_kernels_t &k,
+                            const CPicture &dst_data, const CPicture &src_data,
+                            unsigned width, unsigned height, int alpha)
+{
+    static const uint8_t rgba[4] = { 0, 1, 2, 3 };
+    const picture_t *dstpic = dst_data.getPicture();
+    const picture_t *srcpic = src_data.getPicture();
+    uint8_t shuffle_src[4], shuffle_a[4];
+
+    if (!GetShufflesRV32(dst_data.getFormat(), rgba, shuffle_src, shuffle_a)) {
+        Blend<CPictureRGB32, CPictureYUVA, compose<convertNone, convertYuv8ToRgb> >(
+            dst_data, src_data, width, height, alpha);
+        return;
+    }
+
+    uint8_t *dst = &dstpic->p[0].p_pixels[dst_data.getY() * dstpic->p[0].i_pitch
+                                          + 4 * dst_data.getX()];
+    const uint8_t *src[4];
+    for (unsigned i = 0; i < 4; i++)
+        src[i] = &srcpic->p[i].p_pixels[src_data.getY() * srcpic->p[i].i_pitch
+                                        + src_data.getX()];
+
+    uint8_t pixels[4 * BLEND_CHUNK];
+    for (unsigned line = 0; line < height; line++) {
+        for (unsigned offset = 0; offset < width; offset += BLEND_CHUNK) {
+            const unsigned count = __MIN(width - offset, BLEND_CHUNK);
+
+            for (unsigned i = 0; i < count; i++) {
+                int r, g, b;
+                yuv_to_rgb(&r, &g, &b, src[0][offset + i],
+                           src[1][offset + i], src[2][offset + i]);
+                pixels[4 * i + 0] = r;
+                pixels[4 * i + 1] = g;
+                pixels[4 * i + 2] = b;
+                pixels[4 * i + 3] = src[3][offset + i];
+            }
+            k.pixels32(&dst[4 * offset], pixels, count, alpha,
+                       shuffle_src, shuffle_a);
+        }
+        dst += dstpic->p[0].i_pitch;
+        for (unsigned i = 0; i < 4; i++)
+            src[i] += srcpic->p[i].i_pitch;
+    }
+}
+
+static const struct {
+    vlc_fourcc_t          dst;
+    vlc_fourcc_t          src;
+    blend_simd_function_t blend;
+} blends_simd[] = {
+    { VLC_CODEC_I420,  VLC_CODEC_YUVA, BlendYUVATo420<false, false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVA, BlendYUVATo420<false, false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVA, BlendYUVATo420<false, true> },
+    { VLC_CODEC_NV12,  VLC_CODEC_YUVA, BlendYUVATo420<true, false> },
+    { VLC_CODEC_NV21,  VLC_CODEC_YUVA, BlendYUVATo420<true, true> },
+    { VLC_CODEC_RGB32, VLC_CODEC_YUVA, BlendYUVAToRV32 },
+    { VLC_CODEC_RGB32, VLC_CODEC_RGBA, BlendRGBAToRV32 },
+    { VLC_CODEC_I420,  VLC_CODEC_YUVP, BlendYUVPTo420<false> },
+    { VLC_CODEC_J420,  VLC_CODEC_YUVP, BlendYUVPTo420<false> },
+    { VLC_CODEC_YV12,  VLC_CODEC_YUVP, BlendYUVPTo420<true> },
+};
+
 struct filter_sys_t {
-    filter_sys_t() : blend(NULL)
+    filter_sys_t() : blend(NULL), blend_simd(NULL), kernels(NULL)
     {
     }
     blend_function_t blend;
+    blend_simd_function_t blend_simd;
+    const blend_kernels_t *kernels;
 };
 
 /**
@@ -655,13 +1024,17 @@ static void Blend(filter_t *filter,
     video_format_FixRgb(&filter->fmt_out.video);
     video_format_FixRgb(&filter->fmt_in.video);
 
-    sys->blend(CPicture(dst, &filter->fmt_out.video,
-                        filter->fmt_out.video.i_x_offset + x_offset,
-                        filter->fmt_out.video.i_y_offset + y_offset),
-               CPicture(src, &filter->fmt_in.video,
-                        filter->fmt_in.video.i_x_offset,
-                        filter->fmt_in.video.i_y_offset),
-               width, height, alpha);
+    const CPicture dst_data(dst, &filter->fmt_out.video,
+                            filter->fmt_out.video.i_x_offset + x_offset,
+                            filter->fmt_out.video.i_y_offset + y_offset);
+    const CPicture src_data(src, &filter->fmt_in.video,
+                            filter->fmt_in.video.i_x_offset,
+                            filter->fmt_in.video.i_y_offset);
+
+    if (sys->blend_simd)
+        sys->blend_simd(*sys->kernels, dst_data, src_data, width, height, alpha);
+    else
+        sys->blend(dst_data, src_data, width, height, alpha);
 }
 
 static int Open(vlc_object_t *object)
@@ -676,6 +1049,25 @@ static int Open(vlc_object_t *object)
             sys->blend = blends[i].blend;
     }
 
+#if defined(HAVE_BLEND_AVX2)
+    if (vlc_CPU_AVX2())
+        sys->kernels = &blend_kernelsAVX2;
+    else
+#endif
+#if defined(HAVE_BLEND_SSSE3)
+    if (vlc_CPU_SSSE3())
+        sys->kernels = &blend_kernelsSSSE3;
+    else
+#endif
+        sys->kernels = NULL;
+
+    if (sys->kernels) {
+        for (size_t i = 0; i < sizeof(blends_simd) / sizeof(*blends_simd); i++) {
+            if (blends_simd[i].src == src && blends_simd[i].dst == dst)
+                sys->blend_simd = blends_simd[i].blend;
+        }
+    }
+
     if (!sys->blend) {
        msg_Err(filter, "no matching alpha blending routine (chroma: %4.4s -> %4.4s)",
                (char *)&src, (char *)&dst);
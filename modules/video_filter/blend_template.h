@@ -0,0 +1,167 @@
+/*****************************************************************************
+ * blend_template.h: SIMD alpha blending kernels
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Vectorized versions of merge() for 8 bits samples, bit-exact with it.
+ *
+ * Every kernel builds, for a vector of destination bytes, the matching
+ * vectors of source samples and of source alpha, then blends them in 16 bits
+ * lanes: (255 - a) * d + a * s never exceeds 255 * 255, and neither does
+ * div255() of it. A null alpha leaves the destination unchanged, so that the
+ * transparent pixels need not be skipped.
+ *
+ * The includer provides VEC, STEP (bytes per vector), V_LOAD, V_STORE,
+ * V_SET1_16, V_AND, V_OR, V_ADD16, V_SUB16, V_MUL16, V_SLLI16, V_SRLI16,
+ * V_SHUFFLE, V_WIDEN_LO/V_WIDEN_HI (first/second half of the bytes as 16 bits
+ * lanes, in order) and V_NARROW, the reverse of the widening.
+ */
+
+VLC_TARGET static inline VEC RENAME(Div255)(VEC v)
+{
+    return V_SRLI16(V_ADD16(V_ADD16(v, V_SRLI16(v, 8)), V_SET1_16(1)), 8);
+}
+
+VLC_TARGET static inline VEC RENAME(Merge16)(VEC d, VEC s, VEC a, VEC alpha)
+{
+    a = RENAME(Div255)(V_MUL16(a, alpha));
+    return RENAME(Div255)(V_ADD16(V_MUL16(V_SUB16(V_SET1_16(255), a), d),
+                                  V_MUL16(a, s)));
+}
+
+VLC_TARGET static inline VEC RENAME(Merge8)(VEC d, VEC s, VEC a, VEC alpha)
+{
+    return V_NARROW(RENAME(Merge16)(V_WIDEN_LO(d), V_WIDEN_LO(s),
+                                    V_WIDEN_LO(a), alpha),
+                    RENAME(Merge16)(V_WIDEN_HI(d), V_WIDEN_HI(s),
+                                    V_WIDEN_HI(a), alpha));
+}
+
+/* dst[i] = merge(src[i], a[i]) for i < count */
+VLC_TARGET static void RENAME(BlendPlane)(uint8_t *dst, const uint8_t *src,
+                                          const uint8_t *a, unsigned count,
+                                          int alpha)
+{
+    const VEC valpha = V_SET1_16(alpha);
+    unsigned i = 0;
+
+    for (; i + STEP <= count; i += STEP)
+        V_STORE(&dst[i], RENAME(Merge8)(V_LOAD(&dst[i]), V_LOAD(&src[i]),
+                                        V_LOAD(&a[i]), valpha));
+    for (; i < count; i++)
+        BlendSample(&dst[i], src[i], a[i], alpha);
+}
+
+/* dst[i] = merge(src[2 * i], a[2 * i]) for i < count */
+VLC_TARGET static void RENAME(BlendPlaneSub2)(uint8_t *dst, const uint8_t *src,
+                                              const uint8_t *a, unsigned count,
+                                              int alpha)
+{
+    const VEC valpha = V_SET1_16(alpha);
+    const VEC even = V_SET1_16(0xff);
+    unsigned i = 0;
+
+    /* The last source sample used is src[2 * count - 2]: do not read the
+     * one after it */
+    for (; i + STEP < count; i += STEP) {
+        const VEC d = V_LOAD(&dst[i]);
+        const uint8_t *s = &src[2 * i];
+        const uint8_t *sa = &a[2 * i];
+
+        V_STORE(&dst[i], V_NARROW(
+            RENAME(Merge16)(V_WIDEN_LO(d), V_AND(V_LOAD(s), even),
+                            V_AND(V_LOAD(sa), even), valpha),
+            RENAME(Merge16)(V_WIDEN_HI(d), V_AND(V_LOAD(s + STEP), even),
+                            V_AND(V_LOAD(sa + STEP), even), valpha)));
+    }
+    for (; i < count; i++)
+        BlendSample(&dst[i], src[2 * i], a[2 * i], alpha);
+}
+
+/* dst[2 * i] = merge(src0[2 * i], a[2 * i]) and
+ * dst[2 * i + 1] = merge(src1[2 * i], a[2 * i]) for i < count */
+VLC_TARGET static void RENAME(BlendPackedSub2)(uint8_t *dst,
+                                               const uint8_t *src0,
+                                               const uint8_t *src1,
+                                               const uint8_t *a,
+                                               unsigned count, int alpha)
+{
+    const VEC valpha = V_SET1_16(alpha);
+    const VEC even = V_SET1_16(0xff);
+    unsigned i = 0;
+
+    for (; i + STEP / 2 < count; i += STEP / 2) {
+        const VEC s = V_OR(V_AND(V_LOAD(&src0[2 * i]), even),
+                           V_SLLI16(V_LOAD(&src1[2 * i]), 8));
+        const VEC sa = V_AND(V_LOAD(&a[2 * i]), even);
+
+        V_STORE(&dst[2 * i], RENAME(Merge8)(V_LOAD(&dst[2 * i]), s,
+                                            V_OR(sa, V_SLLI16(sa, 8)),
+                                            valpha));
+    }
+    for (; i < count; i++) {
+        BlendSample(&dst[2 * i    ], src0[2 * i], a[2 * i], alpha);
+        BlendSample(&dst[2 * i + 1], src1[2 * i], a[2 * i], alpha);
+    }
+}
+
+/* Blends 4 bytes pixels: the shuffles give, for each destination byte, the
+ * index of the source sample and of the source alpha within the pixel, or
+ * 0x80 to leave the byte untouched. */
+VLC_TARGET static void RENAME(BlendPixels32)(uint8_t *dst, const uint8_t *src,
+                                             unsigned count, int alpha,
+                                             const uint8_t shuffle_src[4],
+                                             const uint8_t shuffle_a[4])
+{
+    const VEC valpha = V_SET1_16(alpha);
+    uint8_t mask_src[STEP], mask_a[STEP];
+
+    for (unsigned i = 0; i < STEP; i++) {
+        const unsigned base = i & ~3;
+        mask_src[i] = shuffle_src[i & 3] & 0x80 ? 0x80 : base + shuffle_src[i & 3];
+        mask_a[i]   = shuffle_a[i & 3]   & 0x80 ? 0x80 : base + shuffle_a[i & 3];
+    }
+
+    const VEC vshuffle_src = V_LOAD(mask_src);
+    const VEC vshuffle_a   = V_LOAD(mask_a);
+    unsigned i = 0;
+
+    for (; i + STEP / 4 <= count; i += STEP / 4) {
+        const VEC s = V_LOAD(&src[4 * i]);
+
+        V_STORE(&dst[4 * i], RENAME(Merge8)(V_LOAD(&dst[4 * i]),
+                                            V_SHUFFLE(s, vshuffle_src),
+                                            V_SHUFFLE(s, vshuffle_a),
+                                            valpha));
+    }
+    for (; i < count; i++) {
+        for (unsigned j = 0; j < 4; j++) {
+            if (shuffle_src[j] & 0x80)
+                continue;
+            BlendSample(&dst[4 * i + j], src[4 * i + shuffle_src[j]],
+                        src[4 * i + shuffle_a[j]], alpha);
+        }
+    }
+}
+
+static const blend_kernels_t RENAME(blend_kernels) = {
+    RENAME(BlendPlane),
+    RENAME(BlendPlaneSub2),
+    RENAME(BlendPackedSub2),
+    RENAME(BlendPixels32),
+};
@@ -69,6 +69,16 @@ static picture_t *Filter( filter_t *, picture_t * );
 #define BLEND_CHROMA_LONGTEXT N_("Chroma which the blend image will be loaded" \
                                  " in")
 
+#define PAIRS_TEXT N_("Chroma pairs to benchmark")
+#define PAIRS_LONGTEXT N_("Comma separated list of blend>base chroma pairs " \
+    "(e.g. YUVA>I420,RGBA>RV32) blended using generated pictures. If empty, " \
+    "the base and blend images are used instead.")
+
+#define WIDTH_TEXT N_("Width of the generated pictures")
+#define HEIGHT_TEXT N_("Height of the generated pictures")
+#define SIZE_LONGTEXT N_("Dimension of the pictures generated for the " \
+                         "chroma pairs benchmark")
+
 #define CFG_PREFIX "blendbench-"
 
 vlc_module_begin ()
@@ -83,6 +93,11 @@ vlc_module_begin ()
               LOOPS_LONGTEXT, false )
     add_integer_with_range( CFG_PREFIX "alpha", 128, 0, 255, ALPHA_TEXT,
               ALPHA_LONGTEXT, false )
+    add_string( CFG_PREFIX "pairs", "", PAIRS_TEXT, PAIRS_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "width", 1920, 16, 8192, WIDTH_TEXT,
+              SIZE_LONGTEXT, false )
+    add_integer_with_range( CFG_PREFIX "height", 1080, 16, 8192, HEIGHT_TEXT,
+              SIZE_LONGTEXT, false )
 
     set_section( N_("Base image"), NULL )
     add_loadfile( CFG_PREFIX "base-image", NULL, BASE_IMAGE_TEXT,
@@ -100,8 +115,8 @@ vlc_module_begin ()
 vlc_module_end ()
 
 static const char *const ppsz_filter_options[] = {
-    "loops", "alpha", "base-image", "base-chroma", "blend-image",
-    "blend-chroma", NULL
+    "loops", "alpha", "pairs", "width", "height", "base-image", "base-chroma",
+    "blend-image", "blend-chroma", NULL
 };
 
 /*****************************************************************************
@@ -112,6 +127,9 @@ struct filter_sys_t
     bool b_done;
     int i_loops, i_alpha;
 
+    char *psz_pairs;
+    unsigned i_width, i_height;
+
     picture_t *p_base_image;
     picture_t *p_blend_image;
 
@@ -175,6 +193,17 @@ static int Create( vlc_object_t *p_this )
                                                   CFG_PREFIX "loops" );
     p_sys->i_alpha = var_CreateGetIntegerCommand( p_filter,
                                                   CFG_PREFIX "alpha" );
+    p_sys->i_width = var_CreateGetIntegerCommand( p_filter,
+                                                  CFG_PREFIX "width" );
+    p_sys->i_height = var_CreateGetIntegerCommand( p_filter,
+                                                   CFG_PREFIX "height" );
+    p_sys->p_base_image = NULL;
+    p_sys->p_blend_image = NULL;
+
+    p_sys->psz_pairs = var_CreateGetStringCommand( p_filter,
+                                                   CFG_PREFIX "pairs" );
+    if( p_sys->psz_pairs != NULL && *p_sys->psz_pairs != '\0' )
+        return VLC_SUCCESS;
 
     psz_temp = var_CreateGetStringCommand( p_filter, CFG_PREFIX "base-chroma" );
     p_sys->i_base_chroma = !psz_temp || strlen( psz_temp ) != 4 ? 0 :
@@ -186,6 +215,7 @@ static int Create( vlc_object_t *p_this )
     free( psz_cmd );
     if( i_ret != VLC_SUCCESS )
     {
+        free( p_sys->psz_pairs );
         free( p_sys );
         return i_ret;
     }
@@ -204,6 +234,7 @@ static int Create( vlc_object_t *p_this )
     if( i_ret != VLC_SUCCESS )
     {
         picture_Release( p_sys->p_base_image );
+        free( p_sys->psz_pairs );
         free( p_sys );
 
         return VLC_EGENERIC;
@@ -220,57 +251,184 @@ static void Destroy( vlc_object_t *p_this )
     filter_t *p_filter = (filter_t *)p_this;
     filter_sys_t *p_sys = p_filter->p_sys;
 
-    picture_Release( p_sys->p_base_image );
-    picture_Release( p_sys->p_blend_image );
+    if( p_sys->p_base_image )
+        picture_Release( p_sys->p_base_image );
+    if( p_sys->p_blend_image )
+        picture_Release( p_sys->p_blend_image );
+    free( p_sys->psz_pairs );
+    free( p_sys );
 }
 
 /*****************************************************************************
- * Render: displays previously rendered output
+ * blendbench_Run: blends a picture onto another one the requested number of
+ * times and reports the throughput
  *****************************************************************************/
-static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+static int blendbench_Run( filter_t *p_filter, const char *psz_name,
+                           picture_t *p_base, const video_format_t *p_fmt_base,
+                           picture_t *p_blend,
+                           const video_format_t *p_fmt_blend )
 {
     filter_sys_t *p_sys = p_filter->p_sys;
-    filter_t *p_blend;
+    filter_t *p_blender;
 
-    if( p_sys->b_done )
-        return p_pic;
+    p_blender = vlc_object_create( p_filter, sizeof(filter_t) );
+    if( !p_blender )
+        return VLC_ENOMEM;
+    p_blender->fmt_out.video = *p_fmt_base;
+    p_blender->fmt_in.video = *p_fmt_blend;
+    p_blender->p_module = module_need( p_blender, "video blending", NULL,
+                                       false );
+    if( !p_blender->p_module )
+    {
+        msg_Err( p_filter, "%s: no blending module", psz_name );
+        vlc_object_release( p_blender );
+        return VLC_EGENERIC;
+    }
 
-    p_blend = vlc_object_create( p_filter, sizeof(filter_t) );
-    if( !p_blend )
+    mtime_t time = mdate();
+    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
     {
-        picture_Release( p_pic );
-        return NULL;
+        p_blender->pf_video_blend( p_blender, p_base, p_blend,
+                                   0, 0, p_sys->i_alpha );
     }
-    p_blend->fmt_out.video = p_sys->p_base_image->format;
-    p_blend->fmt_in.video = p_sys->p_blend_image->format;
-    p_blend->p_module = module_need( p_blend, "video blending", NULL, false );
-    if( !p_blend->p_module )
+    time = mdate() - time;
+    if( time <= 0 )
+        time = 1;
+
+    const float f_images = (float) p_sys->i_loops / time * 1000000;
+    msg_Info( p_filter, "%s: blended %d images in %f sec", psz_name,
+              p_sys->i_loops, time / 1000000.0f );
+    msg_Info( p_filter, "%s: speed is %f images/second, %f Mpixels/second",
+              psz_name, f_images, f_images * p_fmt_blend->i_visible_width *
+                                  p_fmt_blend->i_visible_height / 1000000 );
+
+    module_unneed( p_blender, p_blender->p_module );
+    vlc_object_release( p_blender );
+    return VLC_SUCCESS;
+}
+
+/*****************************************************************************
+ * blendbench_NewPicture: generates a picture with varying samples and an
+ * alpha covering transparent, opaque and translucent areas
+ *****************************************************************************/
+static picture_t *blendbench_NewPicture( video_format_t *p_fmt,
+                                         vlc_fourcc_t i_chroma,
+                                         unsigned i_width, unsigned i_height )
+{
+    video_format_Init( p_fmt, i_chroma );
+    p_fmt->i_width = p_fmt->i_visible_width = i_width;
+    p_fmt->i_height = p_fmt->i_visible_height = i_height;
+    p_fmt->i_sar_num = p_fmt->i_sar_den = 1;
+    if( i_chroma == VLC_CODEC_YUVP )
     {
-        picture_Release( p_pic );
-        vlc_object_release( p_blend );
+        p_fmt->p_palette = malloc( sizeof(*p_fmt->p_palette) );
+        if( !p_fmt->p_palette )
+            return NULL;
+        p_fmt->p_palette->i_entries = 256;
+        for( unsigned i = 0; i < 256; i++ )
+        {
+            p_fmt->p_palette->palette[i][0] = i;
+            p_fmt->p_palette->palette[i][1] = 255 - i;
+            p_fmt->p_palette->palette[i][2] = i * 7;
+            p_fmt->p_palette->palette[i][3] = i < 64 ? 0 : i < 128 ? 255 : i;
+        }
+    }
+    else
+        video_format_FixRgb( p_fmt );
+
+    picture_t *p_pic = picture_NewFromFormat( p_fmt );
+    if( !p_pic )
+    {
+        video_format_Clean( p_fmt );
         return NULL;
     }
 
-    mtime_t time = mdate();
-    for( int i_iter = 0; i_iter < p_sys->i_loops; ++i_iter )
+    for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
     {
-        p_blend->pf_video_blend( p_blend,
-                                 p_sys->p_base_image, p_sys->p_blend_image,
-                                 0, 0, p_sys->i_alpha );
+        plane_t *p = &p_pic->p[i_plane];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] =
+                    (x + (y << i_plane)) * (2 * i_plane + 1);
     }
-    time = mdate() - time;
+    return p_pic;
+}
 
-    msg_Info( p_filter, "Blended %d images in %f sec", p_sys->i_loops,
-              time / 1000000.0f );
-    msg_Info( p_filter, "Speed is: %f images/second, %f pixels/second",
-              (float) p_sys->i_loops / time * 1000000,
-              (float) p_sys->i_loops / time * 1000000 *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_pitch *
-                  p_sys->p_blend_image->p[Y_PLANE].i_visible_lines );
+static void blendbench_Pair( filter_t *p_filter, const char *psz_pair )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+    video_format_t fmt_base, fmt_blend;
 
-    module_unneed( p_blend, p_blend->p_module );
+    if( strlen( psz_pair ) != 9 || psz_pair[4] != '>' )
+    {
+        msg_Err( p_filter, "invalid chroma pair %s", psz_pair );
+        return;
+    }
 
-    vlc_object_release( p_blend );
+    const vlc_fourcc_t i_blend_chroma =
+        VLC_FOURCC( psz_pair[0], psz_pair[1], psz_pair[2], psz_pair[3] );
+    const vlc_fourcc_t i_base_chroma =
+        VLC_FOURCC( psz_pair[5], psz_pair[6], psz_pair[7], psz_pair[8] );
+
+    picture_t *p_base = blendbench_NewPicture( &fmt_base, i_base_chroma,
+                                               p_sys->i_width,
+                                               p_sys->i_height );
+    picture_t *p_blend = blendbench_NewPicture( &fmt_blend, i_blend_chroma,
+                                                p_sys->i_width,
+                                                p_sys->i_height );
+    if( p_base && p_blend )
+        blendbench_Run( p_filter, psz_pair, p_base, &fmt_base,
+                        p_blend, &fmt_blend );
+    else
+        msg_Err( p_filter, "%s: cannot allocate the pictures", psz_pair );
+
+    if( p_base )
+    {
+        picture_Release( p_base );
+        video_format_Clean( &fmt_base );
+    }
+    if( p_blend )
+    {
+        picture_Release( p_blend );
+        video_format_Clean( &fmt_blend );
+    }
+}
+
+/*****************************************************************************
+ * Render: displays previously rendered output
+ *****************************************************************************/
+static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
+{
+    filter_sys_t *p_sys = p_filter->p_sys;
+
+    if( p_sys->b_done )
+        return p_pic;
+
+    if( p_sys->p_base_image == NULL )
+    {
+        char *psz_pairs = strdup( p_sys->psz_pairs );
+        char *psz_state;
+
+        if( psz_pairs == NULL )
+        {
+            picture_Release( p_pic );
+            return NULL;
+        }
+        for( char *psz_pair = strtok_r( psz_pairs, ",", &psz_state );
+             psz_pair != NULL;
+             psz_pair = strtok_r( NULL, ",", &psz_state ) )
+            blendbench_Pair( p_filter, psz_pair );
+        free( psz_pairs );
+    }
+    else if( blendbench_Run( p_filter, "Image", p_sys->p_base_image,
+                             &p_sys->p_base_image->format,
+                             p_sys->p_blend_image,
+                             &p_sys->p_blend_image->format ) != VLC_SUCCESS )
+    {
+        picture_Release( p_pic );
+        return NULL;
+    }
 
     p_sys->b_done = true;
     return p_pic;
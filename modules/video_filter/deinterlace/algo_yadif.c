@@ -47,6 +47,77 @@
    Necessary preprocessor macros are defined in common.h. */
 #include "yadif.h"
 
+typedef struct
+{
+    picture_t *p_dst;
+    const picture_t *p_prev;
+    const picture_t *p_cur;
+    const picture_t *p_next;
+    int i_field;
+    int i_parity;
+    int i_pixel_size;
+    void (*pf_filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
+                      int w, int prefs, int mrefs, int parity, int mode);
+} yadif_slice_t;
+
+static void RenderYadifSlice( filter_t *p_filter, void *opaque,
+                              unsigned i_slice, unsigned i_slices )
+{
+    const yadif_slice_t *p_slice = opaque;
+    const int i_field = p_slice->i_field;
+    const int yadif_parity = p_slice->i_parity;
+
+    VLC_UNUSED(p_filter);
+    for( int n = 0; n < p_slice->p_dst->i_planes; n++ )
+    {
+        const plane_t *prevp = &p_slice->p_prev->p[n];
+        const plane_t *curp  = &p_slice->p_cur->p[n];
+        const plane_t *nextp = &p_slice->p_next->p[n];
+        plane_t *dstp        = &p_slice->p_dst->p[n];
+        int i_start, i_end;
+
+        /* The first and last lines are not filtered */
+        filter_SliceRows( dstp->i_visible_lines - 2, 1, i_slice, i_slices,
+                          &i_start, &i_end );
+
+        for( int y = i_start + 1; y < i_end + 1; y++ )
+        {
+            if( (y % 2) == i_field  ||  yadif_parity == 2 )
+            {
+                memcpy( &dstp->p_pixels[y * dstp->i_pitch],
+                            &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
+            }
+            else
+            {
+                int mode;
+                /* Spatial checks only when enough data */
+                mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
+
+                assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
+                p_slice->pf_filter( &dstp->p_pixels[y * dstp->i_pitch],
+                        &prevp->p_pixels[y * prevp->i_pitch],
+                        &curp->p_pixels[y * curp->i_pitch],
+                        &nextp->p_pixels[y * nextp->i_pitch],
+                        dstp->i_visible_pitch / p_slice->i_pixel_size,
+                        y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
+                        y  - 1  ?  -curp->i_pitch : curp->i_pitch,
+                        yadif_parity,
+                        mode );
+            }
+
+            /* We duplicate the first and last lines */
+            if( y == 1 )
+                memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+            else if( y == dstp->i_visible_lines - 2 )
+                memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
+                           &dstp->p_pixels[ y    * dstp->i_pitch],
+                           dstp->i_pitch);
+        }
+    }
+}
+
 int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
                  int i_order, int i_field )
 {
@@ -108,6 +179,16 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
         void (*filter)(uint8_t *dst, uint8_t *prev, uint8_t *cur, uint8_t *next,
                        int w, int prefs, int mrefs, int parity, int mode);
 
+#if defined(HAVE_YADIF_AVX512)
+        if( vlc_CPU_AVX512() )
+            filter = yadif_filter_line_avx512;
+        else
+#endif
+#if defined(HAVE_YADIF_AVX2)
+        if( vlc_CPU_AVX2() )
+            filter = yadif_filter_line_avx2;
+        else
+#endif
 #if defined(HAVE_YADIF_SSSE3)
         if( vlc_CPU_SSSE3() )
             filter = yadif_filter_line_ssse3;
@@ -126,52 +207,30 @@ int RenderYadif( filter_t *p_filter, picture_t *p_dst, picture_t *p_src,
             filter = yadif_filter_line_c;
 
         if( p_sys->chroma->pixel_size == 2 )
-            filter = yadif_filter_line_c_16bit;
-
-        for( int n = 0; n < p_dst->i_planes; n++ )
         {
-            const plane_t *prevp = &p_prev->p[n];
-            const plane_t *curp  = &p_cur->p[n];
-            const plane_t *nextp = &p_next->p[n];
-            plane_t *dstp        = &p_dst->p[n];
-
-            for( int y = 1; y < dstp->i_visible_lines - 1; y++ )
-            {
-                if( (y % 2) == i_field  ||  yadif_parity == 2 )
-                {
-                    memcpy( &dstp->p_pixels[y * dstp->i_pitch],
-                                &curp->p_pixels[y * curp->i_pitch], dstp->i_visible_pitch );
-                }
-                else
-                {
-                    int mode;
-                    /* Spatial checks only when enough data */
-                    mode = (y >= 2 && y < dstp->i_visible_lines - 2) ? 0 : 2;
-
-                    assert( prevp->i_pitch == curp->i_pitch && curp->i_pitch == nextp->i_pitch );
-                    filter( &dstp->p_pixels[y * dstp->i_pitch],
-                            &prevp->p_pixels[y * prevp->i_pitch],
-                            &curp->p_pixels[y * curp->i_pitch],
-                            &nextp->p_pixels[y * nextp->i_pitch],
-                            dstp->i_visible_pitch,
-                            y < dstp->i_visible_lines - 2  ? curp->i_pitch : -curp->i_pitch,
-                            y  - 1  ?  -curp->i_pitch : curp->i_pitch,
-                            yadif_parity,
-                            mode );
-                }
-
-                /* We duplicate the first and last lines */
-                if( y == 1 )
-                    memcpy(&dstp->p_pixels[(y-1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-                else if( y == dstp->i_visible_lines - 2 )
-                    memcpy(&dstp->p_pixels[(y+1) * dstp->i_pitch],
-                               &dstp->p_pixels[ y    * dstp->i_pitch],
-                               dstp->i_pitch);
-            }
+#if defined(HAVE_YADIF_AVX512)
+            if( vlc_CPU_AVX512() )
+                filter = yadif_filter_line_16bit_avx512;
+            else
+#endif
+#if defined(HAVE_YADIF_AVX2)
+            if( vlc_CPU_AVX2() )
+                filter = yadif_filter_line_16bit_avx2;
+            else
+#endif
+                filter = yadif_filter_line_c_16bit;
         }
 
+        yadif_slice_t slice = {
+            .p_dst = p_dst, .p_prev = p_prev, .p_cur = p_cur, .p_next = p_next,
+            .i_field = i_field, .i_parity = yadif_parity,
+            .i_pixel_size = p_sys->chroma->pixel_size, .pf_filter = filter,
+        };
+        filter_RunSlices( p_filter,
+                          filter_GetSliceCount( p_filter,
+                                                p_dst->p[0].i_visible_lines ),
+                          RenderYadifSlice, &slice );
+
         p_sys->i_frame_offset = 1; /* p_cur will be rendered at next frame, too */
 
         return VLC_SUCCESS;
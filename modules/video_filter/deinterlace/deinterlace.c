@@ -665,6 +665,22 @@ notsupp:
         p_sys->pf_merge = MergeAltivec;
     else
 #endif
+#if defined(CAN_COMPILE_AVX512)
+    if( vlc_CPU_AVX512() )
+    {
+        p_sys->pf_merge = pixel_size == 1 ? Merge8BitAVX512 : Merge16BitAVX512;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
+#if defined(CAN_COMPILE_AVX2)
+    if( vlc_CPU_AVX2() )
+    {
+        p_sys->pf_merge = pixel_size == 1 ? Merge8BitAVX2 : Merge16BitAVX2;
+        p_sys->pf_end_merge = NULL;
+    }
+    else
+#endif
 #if defined(CAN_COMPILE_SSE2)
     if( vlc_CPU_SSE2() )
     {
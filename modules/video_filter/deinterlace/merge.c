@@ -178,6 +178,157 @@ void Merge16BitSSE2( void *_p_dest, const void *_p_s1, const void *_p_s2,
 
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+/* pavgb/pavgw round up, unlike the C version. Subtracting the lowest bit of
+ * (a ^ b) rounds down instead, so that the result is bit-exact. */
+static const uint8_t __attribute__((aligned (64))) pb_lsb[64] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+static const uint16_t __attribute__((aligned (64))) pw_lsb[32] = {
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+    1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1, 1,
+};
+
+void Merge8BitAVX2( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                    size_t i_bytes )
+{
+    uint8_t *p_dest = _p_dest;
+    const uint8_t *p_s1 = _p_s1;
+    const uint8_t *p_s2 = _p_s2;
+
+    for( ; i_bytes > 0 && ((uintptr_t)p_s1 & 31); i_bytes-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+
+    for( ; i_bytes >= 32; i_bytes -= 32 )
+    {
+        __asm__  __volatile__( "vmovdqu %1,%%ymm0;"
+                               "vmovdqu %2,%%ymm1;"
+                               "vpavgb %%ymm1, %%ymm0, %%ymm2;"
+                               "vpxor %%ymm1, %%ymm0, %%ymm0;"
+                               "vpand %3, %%ymm0, %%ymm0;"
+                               "vpsubb %%ymm0, %%ymm2, %%ymm2;"
+                               "vmovdqu %%ymm2, %0" :"=m" (*p_dest):
+                                                 "m" (*p_s1),
+                                                 "m" (*p_s2),
+                                                 "m" (*pb_lsb)
+                                                 : "xmm0", "xmm1", "xmm2" );
+        p_dest += 32;
+        p_s1 += 32;
+        p_s2 += 32;
+    }
+    __asm__ __volatile__( "vzeroupper" );
+
+    for( ; i_bytes > 0; i_bytes-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+
+void Merge16BitAVX2( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                     size_t i_bytes )
+{
+    uint16_t *p_dest = _p_dest;
+    const uint16_t *p_s1 = _p_s1;
+    const uint16_t *p_s2 = _p_s2;
+
+    size_t i_words = i_bytes / 2;
+    for( ; i_words > 0 && ((uintptr_t)p_s1 & 31); i_words-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+
+    for( ; i_words >= 16; i_words -= 16 )
+    {
+        __asm__  __volatile__( "vmovdqu %1,%%ymm0;"
+                               "vmovdqu %2,%%ymm1;"
+                               "vpavgw %%ymm1, %%ymm0, %%ymm2;"
+                               "vpxor %%ymm1, %%ymm0, %%ymm0;"
+                               "vpand %3, %%ymm0, %%ymm0;"
+                               "vpsubw %%ymm0, %%ymm2, %%ymm2;"
+                               "vmovdqu %%ymm2, %0" :"=m" (*p_dest):
+                                                 "m" (*p_s1),
+                                                 "m" (*p_s2),
+                                                 "m" (*pw_lsb)
+                                                 : "xmm0", "xmm1", "xmm2" );
+        p_dest += 16;
+        p_s1 += 16;
+        p_s2 += 16;
+    }
+    __asm__ __volatile__( "vzeroupper" );
+
+    for( ; i_words > 0; i_words-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX512)
+void Merge8BitAVX512( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                      size_t i_bytes )
+{
+    uint8_t *p_dest = _p_dest;
+    const uint8_t *p_s1 = _p_s1;
+    const uint8_t *p_s2 = _p_s2;
+
+    for( ; i_bytes > 0 && ((uintptr_t)p_s1 & 63); i_bytes-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+
+    for( ; i_bytes >= 64; i_bytes -= 64 )
+    {
+        __asm__  __volatile__( "vmovdqu64 %1,%%zmm0;"
+                               "vmovdqu64 %2,%%zmm1;"
+                               "vpavgb %%zmm1, %%zmm0, %%zmm2;"
+                               "vpxorq %%zmm1, %%zmm0, %%zmm0;"
+                               "vpandq %3, %%zmm0, %%zmm0;"
+                               "vpsubb %%zmm0, %%zmm2, %%zmm2;"
+                               "vmovdqu64 %%zmm2, %0" :"=m" (*p_dest):
+                                                 "m" (*p_s1),
+                                                 "m" (*p_s2),
+                                                 "m" (*pb_lsb)
+                                                 : "xmm0", "xmm1", "xmm2" );
+        p_dest += 64;
+        p_s1 += 64;
+        p_s2 += 64;
+    }
+    __asm__ __volatile__( "vzeroupper" );
+
+    for( ; i_bytes > 0; i_bytes-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+
+void Merge16BitAVX512( void *_p_dest, const void *_p_s1, const void *_p_s2,
+                       size_t i_bytes )
+{
+    uint16_t *p_dest = _p_dest;
+    const uint16_t *p_s1 = _p_s1;
+    const uint16_t *p_s2 = _p_s2;
+
+    size_t i_words = i_bytes / 2;
+    for( ; i_words > 0 && ((uintptr_t)p_s1 & 63); i_words-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+
+    for( ; i_words >= 32; i_words -= 32 )
+    {
+        __asm__  __volatile__( "vmovdqu64 %1,%%zmm0;"
+                               "vmovdqu64 %2,%%zmm1;"
+                               "vpavgw %%zmm1, %%zmm0, %%zmm2;"
+                               "vpxorq %%zmm1, %%zmm0, %%zmm0;"
+                               "vpandq %3, %%zmm0, %%zmm0;"
+                               "vpsubw %%zmm0, %%zmm2, %%zmm2;"
+                               "vmovdqu64 %%zmm2, %0" :"=m" (*p_dest):
+                                                 "m" (*p_s1),
+                                                 "m" (*p_s2),
+                                                 "m" (*pw_lsb)
+                                                 : "xmm0", "xmm1", "xmm2" );
+        p_dest += 32;
+        p_s1 += 32;
+        p_s2 += 32;
+    }
+    __asm__ __volatile__( "vzeroupper" );
+
+    for( ; i_words > 0; i_words-- )
+        *p_dest++ = ( *p_s1++ + *p_s2++ ) >> 1;
+}
+#endif
+
 #ifdef CAN_COMPILE_C_ALTIVEC
 void MergeAltivec( void *_p_dest, const void *_p_s1,
                    const void *_p_s2, size_t i_bytes )
@@ -158,6 +158,50 @@ void Merge8BitSSE2( void *, const void *, const void *, size_t );
 void Merge16BitSSE2( void *, const void *, const void *, size_t );
 #endif
 
+#if defined(CAN_COMPILE_AVX2)
+/**
+ * AVX2 routine to blend 8 bit pixels from two picture lines.
+ * Unlike the SSE2 version, it is bit-exact with Merge8BitGeneric().
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge8BitAVX2( void *, const void *, const void *, size_t );
+/**
+ * AVX2 routine to blend 16 bit pixels from two picture lines.
+ * Unlike the SSE2 version, it is bit-exact with Merge16BitGeneric().
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge16BitAVX2( void *, const void *, const void *, size_t );
+#endif
+
+#if defined(CAN_COMPILE_AVX512)
+/**
+ * AVX-512 (F and BW) routine to blend 8 bit pixels from two picture lines.
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge8BitAVX512( void *, const void *, const void *, size_t );
+/**
+ * AVX-512 (F and BW) routine to blend 16 bit pixels from two picture lines.
+ *
+ * @param _p_dest Target
+ * @param _p_s1 Source line A
+ * @param _p_s2 Source line B
+ * @param i_bytes Number of bytes to merge
+ */
+void Merge16BitAVX512( void *, const void *, const void *, size_t );
+#endif
+
 #if defined(CAN_COMPILE_ARM)
 /**
  * ARM NEON routine to blend pixels from two picture lines.
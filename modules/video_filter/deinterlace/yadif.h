@@ -142,3 +142,173 @@ static void yadif_filter_line_c_16bit(uint16_t *dst, uint16_t *prev, uint16_t *c
     prefs /= 2;
     FILTER
 }
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+// ================= AVX2 =================
+#define HAVE_YADIF_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+#define VEC __m256i
+#define MASK __m256i
+#define M_AND(m,n) _mm256_and_si256(m, n)
+#define V_SELECT(m,a,b) _mm256_blendv_epi8(a, b, m)
+
+#define PIXEL uint8_t
+#define STEP 16
+#define V_LOAD(p) _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i *)(p)))
+#define V_STORE(p,v) _mm_storeu_si128((__m128i *)(p), \
+    _mm_packus_epi16(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)))
+#define V_ADD _mm256_add_epi16
+#define V_SUB _mm256_sub_epi16
+#define V_SRA1(a) _mm256_srai_epi16(a, 1)
+#define V_ABS _mm256_abs_epi16
+#define V_MIN _mm256_min_epi16
+#define V_MAX _mm256_max_epi16
+#define V_SET1 _mm256_set1_epi16
+#define V_LT(a,b) _mm256_cmpgt_epi16(b, a)
+#define TAIL yadif_filter_line_c
+#define RENAME(a) a ## _avx2
+#include "yadif_avx_template.h"
+#undef RENAME
+#undef TAIL
+#undef V_LT
+#undef V_SET1
+#undef V_MAX
+#undef V_MIN
+#undef V_ABS
+#undef V_SRA1
+#undef V_SUB
+#undef V_ADD
+#undef V_STORE
+#undef V_LOAD
+#undef STEP
+#undef PIXEL
+
+#define PIXEL uint16_t
+#define STEP 8
+#define V_LOAD(p) _mm256_cvtepu16_epi32(_mm_loadu_si128((const __m128i *)(p)))
+#define V_STORE(p,v) _mm_storeu_si128((__m128i *)(p), \
+    _mm_packus_epi32(_mm256_castsi256_si128(v), _mm256_extracti128_si256(v, 1)))
+#define V_ADD _mm256_add_epi32
+#define V_SUB _mm256_sub_epi32
+#define V_SRA1(a) _mm256_srai_epi32(a, 1)
+#define V_ABS _mm256_abs_epi32
+#define V_MIN _mm256_min_epi32
+#define V_MAX _mm256_max_epi32
+#define V_SET1 _mm256_set1_epi32
+#define V_LT(a,b) _mm256_cmpgt_epi32(b, a)
+#define TAIL yadif_filter_line_c_16bit
+#define RENAME(a) a ## _16bit_avx2
+#include "yadif_avx_template.h"
+#undef RENAME
+#undef TAIL
+#undef V_LT
+#undef V_SET1
+#undef V_MAX
+#undef V_MIN
+#undef V_ABS
+#undef V_SRA1
+#undef V_SUB
+#undef V_ADD
+#undef V_STORE
+#undef V_LOAD
+#undef STEP
+#undef PIXEL
+
+#undef V_SELECT
+#undef M_AND
+#undef MASK
+#undef VEC
+#undef VLC_TARGET
+
+#if defined(CAN_COMPILE_AVX512)
+// ================ AVX-512 ===============
+/* gcc implements the unmasked AVX-512 intrinsics as masked ones with an
+ * undefined pass-through register, which -Wmaybe-uninitialized reports once
+ * inlined. The full mask never reads that register. */
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic push
+# pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+#endif
+#define HAVE_YADIF_AVX512
+#define VLC_TARGET __attribute__ ((__target__ ("avx512f,avx512bw")))
+#define VEC __m512i
+#define M_AND(m,n) ((m) & (n))
+
+#define PIXEL uint8_t
+#define STEP 32
+#define MASK __mmask32
+#define V_LOAD(p) _mm512_cvtepu8_epi16(_mm256_loadu_si256((const __m256i *)(p)))
+#define V_STORE(p,v) _mm256_storeu_si256((__m256i *)(p), _mm512_cvtepi16_epi8(v))
+#define V_ADD _mm512_add_epi16
+#define V_SUB _mm512_sub_epi16
+#define V_SRA1(a) _mm512_srai_epi16(a, 1)
+#define V_ABS _mm512_abs_epi16
+#define V_MIN _mm512_min_epi16
+#define V_MAX _mm512_max_epi16
+#define V_SET1 _mm512_set1_epi16
+#define V_LT _mm512_cmplt_epi16_mask
+#define V_SELECT _mm512_mask_blend_epi16
+#define TAIL yadif_filter_line_c
+#define RENAME(a) a ## _avx512
+#include "yadif_avx_template.h"
+#undef RENAME
+#undef TAIL
+#undef V_SELECT
+#undef V_LT
+#undef V_SET1
+#undef V_MAX
+#undef V_MIN
+#undef V_ABS
+#undef V_SRA1
+#undef V_SUB
+#undef V_ADD
+#undef V_STORE
+#undef V_LOAD
+#undef MASK
+#undef STEP
+#undef PIXEL
+
+#define PIXEL uint16_t
+#define STEP 16
+#define MASK __mmask16
+#define V_LOAD(p) _mm512_cvtepu16_epi32(_mm256_loadu_si256((const __m256i *)(p)))
+#define V_STORE(p,v) _mm256_storeu_si256((__m256i *)(p), _mm512_cvtepi32_epi16(v))
+#define V_ADD _mm512_add_epi32
+#define V_SUB _mm512_sub_epi32
+#define V_SRA1(a) _mm512_srai_epi32(a, 1)
+#define V_ABS _mm512_abs_epi32
+#define V_MIN _mm512_min_epi32
+#define V_MAX _mm512_max_epi32
+#define V_SET1 _mm512_set1_epi32
+#define V_LT _mm512_cmplt_epi32_mask
+#define V_SELECT _mm512_mask_blend_epi32
+#define TAIL yadif_filter_line_c_16bit
+#define RENAME(a) a ## _16bit_avx512
+#include "yadif_avx_template.h"
+#undef RENAME
+#undef TAIL
+#undef V_SELECT
+#undef V_LT
+#undef V_SET1
+#undef V_MAX
+#undef V_MIN
+#undef V_ABS
+#undef V_SRA1
+#undef V_SUB
+#undef V_ADD
+#undef V_STORE
+#undef V_LOAD
+#undef MASK
+#undef STEP
+#undef PIXEL
+
+#undef M_AND
+#undef VEC
+#undef VLC_TARGET
+#if defined(__GNUC__) && !defined(__clang__)
+# pragma GCC diagnostic pop
+#endif
+#endif
+#endif
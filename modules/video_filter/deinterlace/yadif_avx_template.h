@@ -0,0 +1,132 @@
+/*****************************************************************************
+ * yadif_avx_template.h: AVX2 and AVX-512 Yadif filter line
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/* Vectorized version of the C FILTER from yadif.h, bit-exact with it.
+ *
+ * The pixels are widened to 16 bits lanes (8 bits samples) or 32 bits lanes
+ * (16 bits samples) so that no intermediate value can overflow. The includer
+ * provides the following macros:
+ *  - PIXEL, VEC, MASK and STEP (pixels per iteration);
+ *  - V_LOAD(p) / V_STORE(p, v) converting from/to PIXEL;
+ *  - V_ADD, V_SUB, V_SRA1, V_ABS, V_MIN, V_MAX and V_SET1;
+ *  - V_LT(a, b) returning the a < b mask, M_AND(m, n) and V_SELECT(m, a, b)
+ *    returning b where m is set and a elsewhere;
+ *  - TAIL, the C function used for the remaining pixels.
+ */
+
+#define V_AVG(a, b) V_SRA1(V_ADD(a, b))
+#define V_DIFF(a, b) V_ABS(V_SUB(a, b))
+#define V_SCORE(j) \
+    V_ADD(V_ADD(V_DIFF(V_LOAD(&cur[mrefs-1+(j)]), V_LOAD(&cur[prefs-1-(j)])), \
+                V_DIFF(V_LOAD(&cur[mrefs  +(j)]), V_LOAD(&cur[prefs  -(j)]))), \
+                V_DIFF(V_LOAD(&cur[mrefs+1+(j)]), V_LOAD(&cur[prefs+1-(j)])))
+#define V_CHECK(j, valid) \
+    do { \
+        VEC score = V_SCORE(j); \
+        valid = M_AND(valid, V_LT(score, spatial_score)); \
+        spatial_score = V_SELECT(valid, spatial_score, score); \
+        spatial_pred = V_SELECT(valid, spatial_pred, \
+            V_AVG(V_LOAD(&cur[mrefs+(j)]), V_LOAD(&cur[prefs-(j)]))); \
+    } while(0)
+
+VLC_TARGET static void RENAME(yadif_filter_line)(uint8_t *_dst,
+                              uint8_t *_prev, uint8_t *_cur, uint8_t *_next,
+                              int w, int prefs, int mrefs, int parity, int mode)
+{
+    PIXEL *dst  = (PIXEL *)_dst;
+    PIXEL *prev = (PIXEL *)_prev;
+    PIXEL *cur  = (PIXEL *)_cur;
+    PIXEL *next = (PIXEL *)_next;
+    PIXEL *prev2 = parity ? prev : cur ;
+    PIXEL *next2 = parity ? cur  : next;
+    const VEC zero = V_SET1(0);
+    const VEC one = V_SET1(1);
+    int x;
+
+    /* The references are given in bytes */
+    prefs /= (int)sizeof(PIXEL);
+    mrefs /= (int)sizeof(PIXEL);
+
+    for( x = 0; x + STEP <= w; x += STEP )
+    {
+        const VEC c = V_LOAD(&cur[mrefs]);
+        const VEC e = V_LOAD(&cur[prefs]);
+        const VEC p2 = V_LOAD(prev2);
+        const VEC n2 = V_LOAD(next2);
+        const VEC d = V_AVG(p2, n2);
+        const VEC temporal_diff0 = V_DIFF(p2, n2);
+        const VEC temporal_diff1 = V_SRA1(V_ADD(V_DIFF(V_LOAD(&prev[mrefs]), c),
+                                                V_DIFF(V_LOAD(&prev[prefs]), e)));
+        const VEC temporal_diff2 = V_SRA1(V_ADD(V_DIFF(V_LOAD(&next[mrefs]), c),
+                                                V_DIFF(V_LOAD(&next[prefs]), e)));
+        VEC diff = V_MAX(V_MAX(V_SRA1(temporal_diff0), temporal_diff1),
+                         temporal_diff2);
+        VEC spatial_pred = V_AVG(c, e);
+        VEC spatial_score = V_SUB(V_ADD(V_ADD(
+                V_DIFF(V_LOAD(&cur[mrefs-1]), V_LOAD(&cur[prefs-1])),
+                V_DIFF(c, e)),
+                V_DIFF(V_LOAD(&cur[mrefs+1]), V_LOAD(&cur[prefs+1]))), one);
+        MASK valid;
+
+        /* CHECK(-2) only applies if CHECK(-1) improved the score */
+        valid = V_LT(zero, one);
+        V_CHECK(-1, valid);
+        V_CHECK(-2, valid);
+        valid = V_LT(zero, one);
+        V_CHECK( 1, valid);
+        V_CHECK( 2, valid);
+
+        if( mode < 2 )
+        {
+            const VEC b = V_AVG(V_LOAD(&prev2[2*mrefs]), V_LOAD(&next2[2*mrefs]));
+            const VEC f = V_AVG(V_LOAD(&prev2[2*prefs]), V_LOAD(&next2[2*prefs]));
+            const VEC de = V_SUB(d, e);
+            const VEC dc = V_SUB(d, c);
+            const VEC bc = V_SUB(b, c);
+            const VEC fe = V_SUB(f, e);
+            const VEC max = V_MAX(V_MAX(de, dc), V_MIN(bc, fe));
+            const VEC min = V_MIN(V_MIN(de, dc), V_MAX(bc, fe));
+
+            diff = V_MAX(V_MAX(diff, min), V_SUB(zero, max));
+        }
+
+        /* diff is never negative, so the clipping order does not matter */
+        spatial_pred = V_MIN(V_MAX(spatial_pred, V_SUB(d, diff)),
+                             V_ADD(d, diff));
+        V_STORE(dst, spatial_pred);
+
+        dst += STEP;
+        cur += STEP;
+        prev += STEP;
+        next += STEP;
+        prev2 += STEP;
+        next2 += STEP;
+    }
+
+    if( x < w )
+        TAIL((void *)dst, (void *)prev, (void *)cur, (void *)next, w - x,
+             prefs * (int)sizeof(PIXEL), mrefs * (int)sizeof(PIXEL),
+             parity, mode);
+}
+
+#undef V_CHECK
+#undef V_SCORE
+#undef V_DIFF
+#undef V_AVG
@@ -163,3 +163,24 @@ static inline picture_t *CopyInfoAndRelease( picture_t *p_outpic, picture_t *p_i
 
     return p_outpic;
 }
+
+/**
+ * Makes p_view a shallow copy of p_pic restricted to one slice: every
+ * plane is cut into i_slices bands of rows, and only the i_slice-th one
+ * is kept. The view shares the pixels of p_pic and must not be released.
+ */
+static inline void SlicePicture( picture_t *p_view, const picture_t *p_pic,
+                                 unsigned i_slice, unsigned i_slices )
+{
+    *p_view = *p_pic;
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_view->p[i];
+        int i_start, i_end;
+
+        filter_SliceRows( p->i_visible_lines, 1, i_slice, i_slices,
+                          &i_start, &i_end );
+        p->p_pixels += i_start * p->i_pitch;
+        p->i_lines = p->i_visible_lines = i_end - i_start;
+    }
+}
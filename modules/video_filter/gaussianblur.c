@@ -186,12 +186,106 @@ static void Destroy( vlc_object_t *p_this )
     free( p_filter->p_sys );
 }
 
+typedef struct
+{
+    filter_sys_t *p_sys;
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+    int i_plane;
+} gaussianblur_slice_t;
+
+static void HorizontalSlice( filter_t *p_filter, void *opaque,
+                             unsigned i_slice, unsigned i_slices )
+{
+    const gaussianblur_slice_t *p_slice = opaque;
+    const picture_t *p_pic = p_slice->p_pic;
+    const int i_plane = p_slice->i_plane;
+    const int i_dim = p_slice->p_sys->i_dim;
+    const type_t *pt_distribution = p_slice->p_sys->pt_distribution;
+    type_t *pt_buffer = p_slice->p_sys->pt_buffer;
+
+    const uint8_t *p_in = p_pic->p[i_plane].p_pixels;
+
+    const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
+    const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+    const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+    const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+    int i_start, i_end;
+
+    VLC_UNUSED(p_filter);
+    filter_SliceRows( i_visible_lines, 1, i_slice, i_slices,
+                      &i_start, &i_end );
+
+    for( int i_line = i_start; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
+                 x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
+                 x++ )
+            {
+                t_value += pt_distribution[x+i_dim] *
+                           p_in[c+(x>>x_factor)];
+            }
+            pt_buffer[c] = t_value;
+        }
+    }
+}
+
+static void VerticalSlice( filter_t *p_filter, void *opaque,
+                           unsigned i_slice, unsigned i_slices )
+{
+    const gaussianblur_slice_t *p_slice = opaque;
+    const picture_t *p_pic = p_slice->p_pic;
+    picture_t *p_outpic = p_slice->p_outpic;
+    const int i_plane = p_slice->i_plane;
+    const int i_dim = p_slice->p_sys->i_dim;
+    const type_t *pt_distribution = p_slice->p_sys->pt_distribution;
+    const type_t *pt_buffer = p_slice->p_sys->pt_buffer;
+    const type_t *pt_scale = p_slice->p_sys->pt_scale;
+
+    uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
+
+    const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
+    const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
+    const int i_in_pitch = p_pic->p[i_plane].i_pitch;
+
+    const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
+    const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
+    int i_start, i_end;
+
+    VLC_UNUSED(p_filter);
+    filter_SliceRows( i_visible_lines, 1, i_slice, i_slices,
+                      &i_start, &i_end );
+
+    for( int i_line = i_start; i_line < i_end; i_line++ )
+    {
+        for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
+        {
+            type_t t_value = 0;
+            const int c = i_line*i_in_pitch+i_col;
+            for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
+                 y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
+                 y++ )
+            {
+                t_value += pt_distribution[y+i_dim] *
+                           pt_buffer[c+(y>>y_factor)*i_in_pitch];
+            }
+
+            const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
+            p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
+        }
+    }
+}
+
 static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 {
     picture_t *p_outpic;
     filter_sys_t *p_sys = p_filter->p_sys;
     const int i_dim = p_sys->i_dim;
-    type_t *pt_buffer;
     type_t *pt_scale;
     const type_t *pt_distribution = p_sys->pt_distribution;
 
@@ -210,7 +304,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
                                p_pic->p[Y_PLANE].i_pitch * sizeof( type_t ) );
     }
 
-    pt_buffer = p_sys->pt_buffer;
     if( !p_sys->pt_scale )
     {
         const int i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
@@ -243,54 +336,18 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
         }
     }
 
-    pt_scale = p_sys->pt_scale;
+    gaussianblur_slice_t slice = {
+        .p_sys = p_sys, .p_pic = p_pic, .p_outpic = p_outpic,
+    };
     for( int i_plane = 0 ; i_plane < p_pic->i_planes ; i_plane++ )
     {
+        const unsigned i_slices =
+            filter_GetSliceCount( p_filter, p_pic->p[i_plane].i_visible_lines );
 
-        uint8_t *p_in = p_pic->p[i_plane].p_pixels;
-        uint8_t *p_out = p_outpic->p[i_plane].p_pixels;
-
-        const int i_visible_lines = p_pic->p[i_plane].i_visible_lines;
-        const int i_visible_pitch = p_pic->p[i_plane].i_visible_pitch;
-        const int i_in_pitch = p_pic->p[i_plane].i_pitch;
-
-        const int x_factor = p_pic->p[Y_PLANE].i_visible_pitch/i_visible_pitch-1;
-        const int y_factor = p_pic->p[Y_PLANE].i_visible_lines/i_visible_lines-1;
-
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int x = __MAX( -i_dim, -i_col*(x_factor+1) );
-                     x <= __MIN( i_dim, (i_visible_pitch - i_col)*(x_factor+1) + 1 );
-                     x++ )
-                {
-                    t_value += pt_distribution[x+i_dim] *
-                               p_in[c+(x>>x_factor)];
-                }
-                pt_buffer[c] = t_value;
-            }
-        }
-        for( int i_line = 0; i_line < i_visible_lines; i_line++ )
-        {
-            for( int i_col = 0; i_col < i_visible_pitch; i_col++ )
-            {
-                type_t t_value = 0;
-                const int c = i_line*i_in_pitch+i_col;
-                for( int y = __MAX( -i_dim, (-i_line)*(y_factor+1) );
-                     y <= __MIN( i_dim, (i_visible_lines - i_line)*(y_factor+1) - 1 );
-                     y++ )
-                {
-                    t_value += pt_distribution[y+i_dim] *
-                               pt_buffer[c+(y>>y_factor)*i_in_pitch];
-                }
-
-                const type_t t_scale = pt_scale[(i_line<<y_factor)*(i_in_pitch<<x_factor)+(i_col<<x_factor)];
-                p_out[i_line * p_outpic->p[i_plane].i_pitch + i_col] = (uint8_t)(t_value / t_scale); // FIXME wouldn't it be better to round instead of trunc ?
-            }
-        }
+        /* The vertical pass needs the whole plane of the horizontal one */
+        slice.i_plane = i_plane;
+        filter_RunSlices( p_filter, i_slices, HorizontalSlice, &slice );
+        filter_RunSlices( p_filter, i_slices, VerticalSlice, &slice );
     }
 
     return CopyInfoAndRelease( p_outpic, p_pic );
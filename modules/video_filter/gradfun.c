@@ -108,6 +108,9 @@ struct filter_sys_t {
     int              radius;
     const vlc_chroma_description_t *chroma;
     struct vf_priv_s cfg;
+    /* One working buffer per slice */
+    size_t           buf_size;
+    unsigned         buf_count;
 };
 
 static int Open(vlc_object_t *object)
@@ -137,6 +140,8 @@ static int Open(vlc_object_t *object)
     cfg->thresh      = 0.0;
     cfg->radius      = 0;
     cfg->buf         = NULL;
+    sys->buf_size    = 0;
+    sys->buf_count   = 0;
 
 #if HAVE_SSE2 && HAVE_6REGS
     if (vlc_CPU_SSE2())
@@ -173,6 +178,48 @@ static void Close(vlc_object_t *object)
     free(sys);
 }
 
+struct gradfun_slice {
+    filter_sys_t    *sys;
+    const picture_t *src;
+    picture_t       *dst;
+    int             plane;
+    int             width;
+    int             height;
+    int             radius;
+};
+
+/* The blur is a running sum over the 2 * radius rows around the filtered one,
+ * so each band is filtered from far enough above and below to reach the
+ * same state as a whole plane pass. Bands start on multiples of 8 rows to
+ * keep the dithering pattern in phase. */
+static void FilterSlice(filter_t *filter, void *opaque,
+                        unsigned index, unsigned count)
+{
+    const struct gradfun_slice *slice = opaque;
+    filter_sys_t *sys = slice->sys;
+    const plane_t *srcp = &slice->src->p[slice->plane];
+    plane_t       *dstp = &slice->dst->p[slice->plane];
+    const int r = slice->radius;
+    const int margin = (2 * r + 2 + 7) & ~7;
+    int start, end;
+
+    VLC_UNUSED(filter);
+    filter_SliceRows(slice->height, 8, index, count, &start, &end);
+    if (start >= end)
+        return;
+
+    int top    = __MAX(start - margin, 0);
+    int bottom = __MIN(end + margin, slice->height);
+
+    struct vf_priv_s cfg = sys->cfg;
+    cfg.buf += index * sys->buf_size;
+
+    filter_plane(&cfg, &dstp->p_pixels[top * dstp->i_pitch],
+                 &srcp->p_pixels[top * srcp->i_pitch],
+                 slice->width, bottom - top, dstp->i_pitch, srcp->i_pitch, r,
+                 start - top, end - top);
+}
+
 static picture_t *Filter(filter_t *filter, picture_t *src)
 {
     filter_sys_t *sys = filter->p_sys;
@@ -191,13 +238,20 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     const video_format_t *fmt = &filter->fmt_in.video;
     struct vf_priv_s *cfg = &sys->cfg;
 
+    const unsigned slices = filter_GetSliceCount(filter, fmt->i_height);
+
     cfg->thresh = (1 << 15) / strength;
-    if (cfg->radius != radius) {
-        cfg->radius = radius;
-        cfg->buf    = vlc_memalign(16,
-                                   (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32) * sizeof(*cfg->buf));
+    if (cfg->radius != radius || sys->buf_count < slices) {
+        cfg->radius    = radius;
+        sys->buf_size  = (((fmt->i_width + 15) & ~15) * (cfg->radius + 1) / 2 + 32);
+        sys->buf_count = slices;
+        vlc_free(cfg->buf);
+        cfg->buf       = vlc_memalign(16, slices * sys->buf_size * sizeof(*cfg->buf));
     }
 
+    struct gradfun_slice slice = {
+        .sys = sys, .src = src, .dst = dst,
+    };
     for (int i = 0; i < dst->i_planes; i++) {
         const plane_t *srcp = &src->p[i];
         plane_t       *dstp = &dst->p[i];
@@ -209,8 +263,11 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
                  cfg->radius  * chroma->p[i].h.num / chroma->p[i].h.den) / 2;
         r = VLC_CLIP((r + 1) & ~1, RADIUS_MIN, RADIUS_MAX);
         if (__MIN(w, h) > 2 * r && cfg->buf) {
-            filter_plane(cfg, dstp->p_pixels, srcp->p_pixels,
-                         w, h, dstp->i_pitch, srcp->i_pitch, r);
+            slice.plane  = i;
+            slice.width  = w;
+            slice.height = h;
+            slice.radius = r;
+            filter_RunSlices(filter, slices, FilterSlice, &slice);
         } else {
             plane_CopyPixels(dstp, srcp);
         }
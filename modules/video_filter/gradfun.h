@@ -222,8 +222,10 @@ static void blur_line_sse2(uint16_t *dc, uint16_t *buf, uint16_t *buf1,
 }
 #endif // HAVE_6REGS && HAVE_SSE2
 
+/* Only the rows in [ystart, yend[ are written to dst */
 static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
-                         int width, int height, int dstride, int sstride, int r)
+                         int width, int height, int dstride, int sstride, int r,
+                         int ystart, int yend)
 {
     int bstride = ((width+15)&~15)/2;
     int y;
@@ -255,11 +257,14 @@ static void filter_plane(struct vf_priv_s *ctx, uint8_t *dst, uint8_t *src,
         }
         if (y == r) {
             for (y=0; y<r; y++)
-                ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+                if (y >= ystart && y < yend)
+                    ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
         }
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+        if (y >= ystart && y < yend)
+            ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
         if (++y >= height) break;
-        ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
+        if (y >= ystart && y < yend)
+            ctx->filter_line(dst+y*dstride, src+y*sstride, dc-r/2, width, thresh, dither[y&7]);
         if (++y >= height) break;
     }
 }
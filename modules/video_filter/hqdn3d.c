@@ -91,6 +91,9 @@ struct filter_sys_t
 {
     const vlc_chroma_description_t *chroma;
     int w[3], h[3];
+    int wmax;
+    /* Horizontally low passed planes, when filtering in slices */
+    unsigned int *rows[3];
 
     struct vf_priv_s cfg;
     bool   b_recalc_coefs;
@@ -138,7 +141,11 @@ static int Open(vlc_object_t *this)
         if (sys->w[i] > wmax) wmax = sys->w[i];
         sys->h[i] = fmt_out->i_height * chroma->p[i].h.num / chroma->p[i].h.den;
     }
-    cfg->Line = malloc(wmax*sizeof(unsigned int));
+    sys->wmax = wmax;
+    /* The previous row of each plane: slices filter the planes at the same
+     * time, but a whole plane pass only uses the first one, and the second
+     * for its current row */
+    cfg->Line = malloc(3*wmax*sizeof(unsigned int));
     if (!cfg->Line) {
         free(sys);
         return VLC_ENOMEM;
@@ -184,11 +191,81 @@ static void Close(vlc_object_t *this)
 
     for (int i = 0; i < 3; ++i) {
         free(cfg->Frame[i]);
+        free(sys->rows[i]);
     }
     free(cfg->Line);
     free(sys);
 }
 
+struct hqdn3d_slice
+{
+    filter_sys_t    *sys;
+    const picture_t *src;
+    picture_t       *dst;
+};
+
+static bool IsSpatial(const struct vf_priv_s *cfg, int plane)
+{
+    return cfg->Coefs[plane == 0 ? 0 : 2][0] != 0;
+}
+
+/* The recursive low passes run along the rows, then down the columns. The
+ * rows of a plane are split between the slices first, then its columns,
+ * so that the output is the same as a whole plane pass. */
+static void FilterRowSlice(filter_t *filter, void *opaque,
+                           unsigned index, unsigned count)
+{
+    const struct hqdn3d_slice *slice = opaque;
+    filter_sys_t *sys = slice->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    VLC_UNUSED(filter);
+    for (int i = 0; i < 3; i++) {
+        const int w = sys->w[i];
+        int start, end;
+
+        filter_SliceRows(sys->h[i], 1, index, count, &start, &end);
+        if (!IsSpatial(cfg, i)) {
+            deNoiseTemporal(slice->src->p[i].p_pixels,
+                            slice->dst->p[i].p_pixels, cfg->Frame[i], w,
+                            slice->src->p[i].i_pitch,
+                            slice->dst->p[i].i_pitch,
+                            &cfg->Coefs[i == 0 ? 1 : 3][0], start, end);
+            continue;
+        }
+        for (int y = start; y < end; y++)
+            deNoiseRow(&slice->src->p[i].p_pixels[y * slice->src->p[i].i_pitch],
+                       &sys->rows[i][y * w], w, &cfg->Coefs[i == 0 ? 0 : 2][0],
+                       y == 0 && !cfg->Coefs[i == 0 ? 1 : 3][0]);
+    }
+}
+
+static void FilterColumnSlice(filter_t *filter, void *opaque,
+                              unsigned index, unsigned count)
+{
+    const struct hqdn3d_slice *slice = opaque;
+    filter_sys_t *sys = slice->sys;
+    struct vf_priv_s *cfg = &sys->cfg;
+
+    VLC_UNUSED(filter);
+    for (int i = 0; i < 3; i++) {
+        const int w = sys->w[i];
+        int start, end;
+
+        if (!IsSpatial(cfg, i))
+            continue;
+        /* Whole cache lines of output per slice */
+        filter_SliceRows(w, 64, index, count, &start, &end);
+        for (int y = 0; y < sys->h[i]; y++)
+            deNoiseColumns(&sys->rows[i][y * w],
+                           &slice->dst->p[i].p_pixels[y * slice->dst->p[i].i_pitch],
+                           &cfg->Line[i * sys->wmax], &cfg->Frame[i][y * w],
+                           y == 0,
+                           &cfg->Coefs[i == 0 ? 0 : 2][0],
+                           &cfg->Coefs[i == 0 ? 1 : 3][0], start, end);
+    }
+}
+
 /*****************************************************************************
  * Filter
  *****************************************************************************/
@@ -221,30 +298,37 @@ static picture_t *Filter(filter_t *filter, picture_t *src)
     }
     vlc_mutex_unlock( &sys->coefs_mutex );
 
-    deNoise(src->p[0].p_pixels, dst->p[0].p_pixels,
-            cfg->Line, &cfg->Frame[0], sys->w[0], sys->h[0],
-            src->p[0].i_pitch, dst->p[0].i_pitch,
-            cfg->Coefs[0],
-            cfg->Coefs[0],
-            cfg->Coefs[1]);
-    deNoise(src->p[1].p_pixels, dst->p[1].p_pixels,
-            cfg->Line, &cfg->Frame[1], sys->w[1], sys->h[1],
-            src->p[1].i_pitch, dst->p[1].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-    deNoise(src->p[2].p_pixels, dst->p[2].p_pixels,
-            cfg->Line, &cfg->Frame[2], sys->w[2], sys->h[2],
-            src->p[2].i_pitch, dst->p[2].i_pitch,
-            cfg->Coefs[2],
-            cfg->Coefs[2],
-            cfg->Coefs[3]);
-
-    if(unlikely(!cfg->Frame[0] || !cfg->Frame[1] || !cfg->Frame[2]))
-    {
-        picture_Release( src );
-        picture_Release( dst );
-        return NULL;
+    for (int i = 0; i < 3; i++) {
+        if (unlikely(!deNoiseInit(src->p[i].p_pixels, &cfg->Frame[i],
+                                  sys->w[i], sys->h[i], src->p[i].i_pitch)))
+        {
+            picture_Release( src );
+            picture_Release( dst );
+            return NULL;
+        }
+    }
+
+    unsigned slices = filter_GetSliceCount(filter, sys->h[0]);
+    for (int i = 0; i < 3 && slices > 1; i++) {
+        if (!sys->rows[i])
+            sys->rows[i] = malloc(sys->w[i] * sys->h[i] * sizeof(unsigned int));
+        if (!sys->rows[i])
+            slices = 1;
+    }
+
+    if (slices > 1) {
+        struct hqdn3d_slice slice = { .sys = sys, .src = src, .dst = dst };
+        filter_RunSlices(filter, slices, FilterRowSlice, &slice);
+        filter_RunSlices(filter, slices, FilterColumnSlice, &slice);
+    } else {
+        for (int i = 0; i < 3; i++)
+            deNoise(src->p[i].p_pixels, dst->p[i].p_pixels,
+                    cfg->Line, &cfg->Line[sys->wmax], cfg->Frame[i],
+                    sys->w[i], sys->h[i],
+                    src->p[i].i_pitch, dst->p[i].i_pitch,
+                    &cfg->Coefs[i == 0 ? 0 : 2][0],
+                    &cfg->Coefs[i == 0 ? 0 : 2][0],
+                    &cfg->Coefs[i == 0 ? 1 : 3][0]);
     }
 
     return CopyInfoAndRelease(dst, src);
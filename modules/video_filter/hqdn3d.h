@@ -46,135 +46,111 @@ static /*inline*/ unsigned int LowPassMul(unsigned int PrevMul, unsigned int Cur
     return CurrMul + Coef[d];
 }
 
-static void deNoiseTemporal(
-                    unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned short *FrameAnt,
-                    int W, int H, int sStride, int dStride,
-                    int *Temporal)
+static unsigned short *deNoiseInit(unsigned char *Frame, // mpi->planes[x]
+                                   unsigned short **FrameAntPtr,
+                                   int W, int H, int sStride)
 {
-    unsigned int PixelDst;
+    unsigned short* FrameAnt=(*FrameAntPtr);
 
-    for (long Y = 0; Y < H; Y++){
-        for (long X = 0; X < W; X++){
-            PixelDst = LowPassMul(FrameAnt[X]<<8, Frame[X]<<16, Temporal);
-            FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+    if(!FrameAnt){
+        (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
+        if(!FrameAnt)
+            return NULL;
+        for (long Y = 0; Y < H; Y++){
+            unsigned short* dst=&FrameAnt[Y*W];
+            unsigned char* src=Frame+Y*sStride;
+            for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
         }
-        Frame += sStride;
-        FrameDest += dStride;
-        FrameAnt += W;
     }
+    return FrameAnt;
 }
 
-static void deNoiseSpacial(
-                    unsigned char *Frame,        // mpi->planes[x]
-                    unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,       // vf->priv->Line (width bytes)
-                    int W, int H, int sStride, int dStride,
-                    int *Horizontal, int *Vertical)
+/* Denoises the rows in [Start, End[ temporally only */
+static void deNoiseTemporal(unsigned char *Frame,        // mpi->planes[x]
+                            unsigned char *FrameDest,    // dmpi->planes[x]
+                            unsigned short *FrameAnt,
+                            int W, int sStride, int dStride,
+                            int *Temporal, int Start, int End)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
     unsigned int PixelDst;
 
-    /* First pixel has no left nor top neighbor. */
-    PixelDst = LineAnt[0] = PixelAnt = Frame[0]<<16;
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
+    for (long Y = Start; Y < End; Y++){
+        unsigned char *Src = &Frame[Y*sStride];
+        unsigned char *Dst = &FrameDest[Y*dStride];
+        unsigned short *LinePrev = &FrameAnt[Y*W];
+        for (long X = 0; X < W; X++){
+            PixelDst = LowPassMul(LinePrev[X]<<8, Src[X]<<16, Temporal);
+            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            Dst[X]= ((PixelDst+0x10007FFF)>>16);
+        }
+    }
+}
+
+/* Low passes a row horizontally. The first pixel has no left neighbor.
+ * Without temporal low pass, the pixels of the first row of a plane are all
+ * low passed against the first one. */
+static void deNoiseRow(const unsigned char *Src, unsigned int *Dst, int W,
+                       int *Horizontal, bool FirstSpatial)
+{
+    unsigned int PixelAnt = Dst[0] = Src[0]<<16;
 
-    /* First line has no top neighbor, only left. */
-    for (long X = 1; X < W; X++){
-        PixelDst = LineAnt[X] = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
+    if (FirstSpatial) {
+        for (long X = 1; X < W; X++)
+            Dst[X] = LowPassMul(PixelAnt, Src[X]<<16, Horizontal);
+        return;
     }
+    for (long X = 1; X < W; X++)
+        Dst[X] = PixelAnt = LowPassMul(PixelAnt, Src[X]<<16, Horizontal);
+}
+
+/* Low passes the columns in [Start, End[ of a horizontally low passed row
+ * vertically, then temporally if enabled. LineAnt holds the previous row,
+ * the first row of a plane has no top neighbor. */
+static void deNoiseColumns(const unsigned int *Src, unsigned char *Dst,
+                           unsigned int *LineAnt, unsigned short *LinePrev,
+                           bool First, int *Vertical, int *Temporal,
+                           int Start, int End)
+{
+    unsigned int PixelDst;
 
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        PixelDst = LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            PixelDst = LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
+    if (First)
+        memcpy(&LineAnt[Start], &Src[Start], (End - Start) * sizeof(*Src));
+    else
+        for (long X = Start; X < End; X++)
+            LineAnt[X] = LowPassMul(LineAnt[X], Src[X], Vertical);
+
+    if(!Temporal[0]){
+        for (long X = Start; X < End; X++)
+            Dst[X]= ((LineAnt[X]+0x10007FFF)>>16);
+    } else {
+        for (long X = Start; X < End; X++){
+            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
+            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
+            Dst[X]= ((PixelDst+0x10007FFF)>>16);
         }
     }
 }
 
+/* Denoises a whole plane. Row is a buffer of W entries. */
 static void deNoise(unsigned char *Frame,        // mpi->planes[x]
                     unsigned char *FrameDest,    // dmpi->planes[x]
-                    unsigned int *LineAnt,      // vf->priv->Line (width bytes)
-                    unsigned short **FrameAntPtr,
+                    unsigned int *LineAnt,       // width entries
+                    unsigned int *Row,           // width entries
+                    unsigned short *FrameAnt,
                     int W, int H, int sStride, int dStride,
                     int *Horizontal, int *Vertical, int *Temporal)
 {
-    long sLineOffs = 0, dLineOffs = 0;
-    unsigned int PixelAnt;
-    unsigned int PixelDst;
-    unsigned short* FrameAnt=(*FrameAntPtr);
-
-    if(!FrameAnt){
-        (*FrameAntPtr)=FrameAnt=malloc(W*H*sizeof(unsigned short));
-        if(!FrameAnt)
-            return;
-        for (long Y = 0; Y < H; Y++){
-            unsigned short* dst=&FrameAnt[Y*W];
-            unsigned char* src=Frame+Y*sStride;
-            for (long X = 0; X < W; X++) dst[X]=src[X]<<8;
-        }
-    }
-
     if(!Horizontal[0] && !Vertical[0]){
-        deNoiseTemporal(Frame, FrameDest, FrameAnt,
-                        W, H, sStride, dStride, Temporal);
-        return;
-    }
-    if(!Temporal[0]){
-        deNoiseSpacial(Frame, FrameDest, LineAnt,
-                       W, H, sStride, dStride, Horizontal, Vertical);
+        deNoiseTemporal(Frame, FrameDest, FrameAnt, W, sStride, dStride,
+                        Temporal, 0, H);
         return;
     }
 
-    /* First pixel has no left nor top neighbor. Only previous frame */
-    LineAnt[0] = PixelAnt = Frame[0]<<16;
-    PixelDst = LowPassMul(FrameAnt[0]<<8, PixelAnt, Temporal);
-    FrameAnt[0] = ((PixelDst+0x1000007F)>>8);
-    FrameDest[0]= ((PixelDst+0x10007FFF)>>16);
-
-    /* First line has no top neighbor. Only left one for each pixel and
-     * last frame */
-    for (long X = 1; X < W; X++){
-        LineAnt[X] = PixelAnt = LowPassMul(PixelAnt, Frame[X]<<16, Horizontal);
-        PixelDst = LowPassMul(FrameAnt[X]<<8, PixelAnt, Temporal);
-        FrameAnt[X] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[X]= ((PixelDst+0x10007FFF)>>16);
-    }
-
-    for (long Y = 1; Y < H; Y++){
-        unsigned int PixelAnt;
-        unsigned short* LinePrev=&FrameAnt[Y*W];
-        sLineOffs += sStride, dLineOffs += dStride;
-        /* First pixel on each line doesn't have previous pixel */
-        PixelAnt = Frame[sLineOffs]<<16;
-        LineAnt[0] = LowPassMul(LineAnt[0], PixelAnt, Vertical);
-        PixelDst = LowPassMul(LinePrev[0]<<8, LineAnt[0], Temporal);
-        LinePrev[0] = ((PixelDst+0x1000007F)>>8);
-        FrameDest[dLineOffs]= ((PixelDst+0x10007FFF)>>16);
-
-        for (long X = 1; X < W; X++){
-            unsigned int PixelDst;
-            /* The rest are normal */
-            PixelAnt = LowPassMul(PixelAnt, Frame[sLineOffs+X]<<16, Horizontal);
-            LineAnt[X] = LowPassMul(LineAnt[X], PixelAnt, Vertical);
-            PixelDst = LowPassMul(LinePrev[X]<<8, LineAnt[X], Temporal);
-            LinePrev[X] = ((PixelDst+0x1000007F)>>8);
-            FrameDest[dLineOffs+X]= ((PixelDst+0x10007FFF)>>16);
-        }
+    for (long Y = 0; Y < H; Y++){
+        deNoiseRow(&Frame[Y*sStride], Row, W, Horizontal,
+                   Y == 0 && !Temporal[0]);
+        deNoiseColumns(Row, &FrameDest[Y*dStride], LineAnt, &FrameAnt[Y*W],
+                       Y == 0, Vertical, Temporal, 0, W);
     }
 }
 
@@ -160,6 +160,61 @@ static void Destroy( vlc_object_t *p_this )
     free( p_sys );
 }
 
+typedef struct
+{
+    const picture_t *p_pic;
+    picture_t *p_outpic;
+    int sigma;
+} sharpen_slice_t;
+
+/* Convolves the inner rows of one band of the Y plane */
+static void FilterSlice( filter_t *p_filter, void *opaque,
+                         unsigned i_slice, unsigned i_slices )
+{
+    const sharpen_slice_t *p_slice = opaque;
+    const uint8_t *restrict p_src = p_slice->p_pic->p[Y_PLANE].p_pixels;
+    uint8_t *restrict p_out = p_slice->p_outpic->p[Y_PLANE].p_pixels;
+    const int i_src_pitch = p_slice->p_pic->p[Y_PLANE].i_pitch;
+    const int i_out_pitch = p_slice->p_outpic->p[Y_PLANE].i_pitch;
+    const unsigned i_visible_lines = p_slice->p_pic->p[Y_PLANE].i_visible_lines;
+    const unsigned i_visible_pitch = p_slice->p_pic->p[Y_PLANE].i_visible_pitch;
+    const int sigma = p_slice->sigma;
+    const int v1 = -1;
+    const int v2 = 3; /* 2^3 = 8 */
+    int pix;
+    int i_start, i_end;
+
+    VLC_UNUSED(p_filter);
+    /* Avoid border lines */
+    filter_SliceRows( i_visible_lines - 2, 1, i_slice, i_slices,
+                      &i_start, &i_end );
+
+    for( unsigned i = i_start + 1; i < (unsigned)i_end + 1; i++ )
+    {
+        p_out[i * i_out_pitch] = p_src[i * i_src_pitch];
+
+        for( unsigned j = 1; j < i_visible_pitch - 1; j++ )
+        {
+            pix = (p_src[(i - 1) * i_src_pitch + j - 1] * v1) +
+                  (p_src[(i - 1) * i_src_pitch + j    ] * v1) +
+                  (p_src[(i - 1) * i_src_pitch + j + 1] * v1) +
+                  (p_src[(i    ) * i_src_pitch + j - 1] * v1) +
+                  (p_src[(i    ) * i_src_pitch + j    ] << v2) +
+                  (p_src[(i    ) * i_src_pitch + j + 1] * v1) +
+                  (p_src[(i + 1) * i_src_pitch + j - 1] * v1) +
+                  (p_src[(i + 1) * i_src_pitch + j    ] * v1) +
+                  (p_src[(i + 1) * i_src_pitch + j + 1] * v1);
+
+           pix = pix >= 0 ? clip(pix) : -clip(pix * -1);
+           p_out[i * i_out_pitch + j] = clip( p_src[i * i_src_pitch + j]
+                                              + ((pix * sigma) >> 20));
+        }
+
+        p_out[i * i_out_pitch + i_visible_pitch - 1] =
+            p_src[i * i_src_pitch + i_visible_pitch - 1];
+    }
+}
+
 /*****************************************************************************
  * Render: displays previously rendered output
  *****************************************************************************
@@ -174,9 +229,6 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
     uint8_t *restrict p_out = NULL;
     int i_src_pitch;
     int i_out_pitch;
-    int pix;
-    const int v1 = -1;
-    const int v2 = 3; /* 2^3 = 8 */
     const unsigned i_visible_lines = p_pic->p[Y_PLANE].i_visible_lines;
     const unsigned i_visible_pitch = p_pic->p[Y_PLANE].i_visible_pitch;
     const int sigma = var_GetFloat( p_filter, FILTER_PREFIX "sigma" ) * (1 << 20);
@@ -199,30 +251,14 @@ static picture_t *Filter( filter_t *p_filter, picture_t *p_pic )
 
     memcpy(p_out, p_src, i_visible_pitch);
 
-    for( unsigned i = 1; i < i_visible_lines - 1; i++ )
-    {
-        p_out[i * i_out_pitch] = p_src[i * i_src_pitch];
+    sharpen_slice_t slice = {
+        .p_pic = p_pic, .p_outpic = p_outpic, .sigma = sigma,
+    };
+    if( i_visible_lines > 2 )
+        filter_RunSlices( p_filter,
+                          filter_GetSliceCount( p_filter, i_visible_lines - 2 ),
+                          FilterSlice, &slice );
 
-        for( unsigned j = 1; j < i_visible_pitch - 1; j++ )
-        {
-            pix = (p_src[(i - 1) * i_src_pitch + j - 1] * v1) +
-                  (p_src[(i - 1) * i_src_pitch + j    ] * v1) +
-                  (p_src[(i - 1) * i_src_pitch + j + 1] * v1) +
-                  (p_src[(i    ) * i_src_pitch + j - 1] * v1) +
-                  (p_src[(i    ) * i_src_pitch + j    ] << v2) +
-                  (p_src[(i    ) * i_src_pitch + j + 1] * v1) +
-                  (p_src[(i + 1) * i_src_pitch + j - 1] * v1) +
-                  (p_src[(i + 1) * i_src_pitch + j    ] * v1) +
-                  (p_src[(i + 1) * i_src_pitch + j + 1] * v1);
-
-           pix = pix >= 0 ? clip(pix) : -clip(pix * -1);
-           p_out[i * i_out_pitch + j] = clip( p_src[i * i_src_pitch + j]
-                                              + ((pix * sigma) >> 20));
-        }
-
-        p_out[i * i_out_pitch + i_visible_pitch - 1] =
-            p_src[i * i_src_pitch + i_visible_pitch - 1];
-    }
     memcpy(&p_out[(i_visible_lines - 1) * i_out_pitch],
            &p_src[(i_visible_lines - 1) * i_src_pitch], i_visible_pitch);
 
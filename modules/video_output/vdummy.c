@@ -87,7 +87,8 @@ static int Open(vlc_object_t *object,
         return VLC_EGENERIC;
     sys->pool = NULL;
 
-    /* p_vd->info is not modified */
+    /* Pictures are never written, any memory layout will do */
+    vd->info.accepts_views = true;
 
     char *chroma = var_InheritString(vd, "dummy-chroma");
     if (chroma) {
@@ -184,14 +184,25 @@ static void Close( vlc_object_t *p_this )
 static int Filter( video_splitter_t *p_splitter,
                    picture_t *pp_dst[], picture_t *p_src )
 {
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
+    /* Every clone shows the whole picture */
+    unsigned pi_origin[p_splitter->i_output];
+    bool pb_view[p_splitter->i_output];
+
+    for( int i = 0; i < p_splitter->i_output; i++ )
+    {
+        pi_origin[i] = 0;
+        pb_view[i] = true;
+    }
+    if( video_splitter_NewPictureView( p_splitter, pp_dst, p_src,
+                                       pi_origin, pi_origin, pb_view ) )
     {
         picture_Release( p_src );
         return VLC_EGENERIC;
     }
 
     for( int i = 0; i < p_splitter->i_output; i++ )
-        picture_Copy( pp_dst[i], p_src );
+        if( !pb_view[i] )
+            picture_Copy( pp_dst[i], p_src );
 
     picture_Release( p_src );
     return VLC_SUCCESS;
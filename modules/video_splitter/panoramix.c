@@ -719,8 +719,33 @@ static void Close( vlc_object_t *p_this )
 static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t *p_src )
 {
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
+    unsigned pi_x[COL_MAX * ROW_MAX];
+    unsigned pi_y[COL_MAX * ROW_MAX];
+    bool pb_view[COL_MAX * ROW_MAX];
 
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
+    for( int y = 0; y < p_sys->i_row; y++ )
+    {
+        for( int x = 0; x < p_sys->i_col; x++ )
+        {
+            const panoramix_output_t *p_output = &p_sys->pp_output[x][y];
+            if( !p_output->b_active )
+                continue;
+
+            /* Only the outputs without black or blended borders are
+             * unmodified areas of the source */
+            const panoramix_filter_t *p_cfg = &p_output->filter;
+            pi_x[p_output->i_output] = p_output->i_src_x;
+            pi_y[p_output->i_output] = p_output->i_src_y;
+            pb_view[p_output->i_output] =
+                !p_cfg->black.i_left && !p_cfg->black.i_right &&
+                !p_cfg->black.i_top && !p_cfg->black.i_bottom &&
+                !p_cfg->attenuate.i_left && !p_cfg->attenuate.i_right &&
+                !p_cfg->attenuate.i_top && !p_cfg->attenuate.i_bottom;
+        }
+    }
+
+    if( video_splitter_NewPictureView( p_splitter, pp_dst, p_src,
+                                       pi_x, pi_y, pb_view ) )
     {
         picture_Release( p_src );
         return VLC_EGENERIC;
@@ -731,7 +756,7 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
         for( int x = 0; x < p_sys->i_col; x++ )
         {
             const panoramix_output_t *p_output = &p_sys->pp_output[x][y];
-            if( !p_output->b_active )
+            if( !p_output->b_active || pb_view[p_output->i_output] )
                 continue;
 
             /* */
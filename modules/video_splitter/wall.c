@@ -390,8 +390,27 @@ static void Close( vlc_object_t *p_this )
 static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t *p_src )
 {
     video_splitter_sys_t *p_sys = p_splitter->p_sys;
+    unsigned pi_x[COL_MAX * ROW_MAX];
+    unsigned pi_y[COL_MAX * ROW_MAX];
+    bool pb_view[COL_MAX * ROW_MAX];
 
-    if( video_splitter_NewPicture( p_splitter, pp_dst ) )
+    for( int y = 0; y < p_sys->i_row; y++ )
+    {
+        for( int x = 0; x < p_sys->i_col; x++ )
+        {
+            const wall_output_t *p_output = &p_sys->pp_output[x][y];
+            if( !p_output->b_active )
+                continue;
+
+            pi_x[p_output->i_output] = p_output->i_left;
+            pi_y[p_output->i_output] = p_output->i_top;
+            pb_view[p_output->i_output] = true;
+        }
+    }
+
+    /* Outputs showing a view of the source picture need no copy */
+    if( video_splitter_NewPictureView( p_splitter, pp_dst, p_src,
+                                       pi_x, pi_y, pb_view ) )
     {
         picture_Release( p_src );
         return VLC_EGENERIC;
@@ -402,7 +421,7 @@ static int Filter( video_splitter_t *p_splitter, picture_t *pp_dst[], picture_t
         for( int x = 0; x < p_sys->i_col; x++ )
         {
             wall_output_t *p_output = &p_sys->pp_output[x][y];
-            if( !p_output->b_active )
+            if( !p_output->b_active || pb_view[p_output->i_output] )
                 continue;
 
             picture_t *p_dst = pp_dst[p_output->i_output];
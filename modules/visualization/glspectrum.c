@@ -33,6 +33,7 @@
 #include <vlc_opengl.h>
 #include <vlc_filter.h>
 #include <vlc_rand.h>
+#include <vlc_fft.h>
 
 #ifdef __APPLE__
 # include <OpenGL/gl.h>
@@ -42,7 +43,6 @@
 
 #include <math.h>
 
-#include "visual/fft.h"
 #include "visual/window.h"
 
 
@@ -94,6 +94,8 @@ struct filter_sys_t
 
     /* FFT window parameters */
     window_param wind_param;
+    window_context wind_ctx;
+    vlc_fft_t *fft;
 };
 
 
@@ -133,6 +135,16 @@ static int Open(vlc_object_t * p_this)
 
     /* Fetch the FFT window parameters */
     window_get_param( VLC_OBJECT( p_filter ), &p_sys->wind_param );
+    p_sys->wind_ctx = (window_context){ NULL, 0 };
+
+    p_sys->fft = vlc_fft_New(FFT_BUFFER_SIZE);
+    if (p_sys->fft == NULL)
+        goto error;
+    if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &p_sys->wind_ctx))
+    {
+        msg_Err(p_filter, "unable to initialize FFT window");
+        goto error;
+    }
 
     /* Create the FIFO for the audio data. */
     p_sys->fifo = block_FifoNew();
@@ -164,6 +176,9 @@ static int Open(vlc_object_t * p_this)
     return VLC_SUCCESS;
 
 error:
+    window_close(&p_sys->wind_ctx);
+    if (p_sys->fft != NULL)
+        vlc_fft_Delete(p_sys->fft);
     free(p_sys);
     return VLC_EGENERIC;
 }
@@ -186,6 +201,8 @@ static void Close(vlc_object_t *p_this)
     vlc_gl_surface_Destroy(p_sys->gl);
     block_FifoRelease(p_sys->fifo);
     free(p_sys->p_prev_s16_buff);
+    window_close(&p_sys->wind_ctx);
+    vlc_fft_Delete(p_sys->fft);
     free(p_sys);
 }
 
@@ -370,13 +387,11 @@ static void *Thread( void *p_data )
         const unsigned xscale[] = {0,1,2,3,4,5,6,7,8,11,15,20,27,
                                    36,47,62,82,107,141,184,255};
 
-        fft_state *p_state = NULL; /* internal FFT data */
-        DEFINE_WIND_CONTEXT(wind_ctx); /* internal window data */
-
         unsigned i, j;
         float p_output[FFT_BUFFER_SIZE];           /* Raw FFT Result  */
         int16_t p_buffer1[FFT_BUFFER_SIZE];        /* Buffer on which we perform
                                                       the FFT (first channel) */
+        float p_samples[FFT_BUFFER_SIZE];          /* Windowed first channel */
         int16_t p_dest[FFT_BUFFER_SIZE];           /* Adapted FFT result */
         float *p_buffl = (float*)block->p_buffer;  /* Original buffer */
 
@@ -417,17 +432,6 @@ static void *Thread( void *p_data )
 
             p_buffl++; p_buffs++;
         }
-        p_state = visual_fft_init();
-        if (!p_state)
-        {
-            msg_Err(p_filter,"unable to initialize FFT transform");
-            goto release;
-        }
-        if (!window_init(FFT_BUFFER_SIZE, &p_sys->wind_param, &wind_ctx))
-        {
-            msg_Err(p_filter,"unable to initialize FFT window");
-            goto release;
-        }
         p_buffs = p_s16_buff;
         for (i = 0 ; i < FFT_BUFFER_SIZE; i++)
         {
@@ -438,8 +442,10 @@ static void *Thread( void *p_data )
             if (p_buffs >= &p_s16_buff[block->i_nb_samples * p_sys->i_channels])
                 p_buffs = p_s16_buff;
         }
-        window_scale_in_place (p_buffer1, &wind_ctx);
-        fft_perform (p_buffer1, p_output, p_state);
+        window_scale_in_place (p_buffer1, &p_sys->wind_ctx);
+        for (i = 0; i < FFT_BUFFER_SIZE; i++)
+            p_samples[i] = p_buffer1[i];
+        vlc_fft_Power(p_sys->fft, p_output, p_samples);
 
         for (i = 0; i< FFT_BUFFER_SIZE; ++i)
             p_dest[i] = p_output[i] *  (2 ^ 16)
@@ -486,8 +492,6 @@ static void *Thread( void *p_data )
         vlc_gl_Swap(gl);
 
 release:
-        window_close(&wind_ctx);
-        fft_close(p_state);
         vlc_gl_ReleaseCurrent(gl);
         block_Release(block);
         vlc_restorecancel(canc);
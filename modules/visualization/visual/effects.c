@@ -32,11 +32,11 @@
 #include <vlc_common.h>
 #include <vlc_picture.h>
 #include <vlc_block.h>
+#include <vlc_fft.h>
 
 #include "visual.h"
 #include <math.h>
 
-#include "fft.h"
 #include "window.h"
 
 #define PEAK_SPEED 1
@@ -75,6 +75,8 @@ typedef struct spectrum_data
     int16_t *p_prev_s16_buff;
 
     window_param wind_param;
+    window_context wind_ctx;
+    vlc_fft_t *p_fft;
 } spectrum_data;
 
 static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
@@ -104,14 +106,12 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
      110,115,121,130,141,152,163,174,185,200,255};
     const int *xscale;
 
-    fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
-
     int i , j , y , k;
     int i_line;
     int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
     int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
                                              the FFT (first channel) */
+    float p_samples[FFT_BUFFER_SIZE];     /* Windowed first channel */
 
     float *p_buffl =                     /* Original buffer */
             (float*)p_buffer->p_buffer;
@@ -138,6 +138,20 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->p_prev_s16_buff = NULL;
 
         window_get_param( p_aout, &p_data->wind_param );
+        p_data->wind_ctx = (window_context){ NULL, 0 };
+        p_data->p_fft = vlc_fft_New( FFT_BUFFER_SIZE );
+        if( p_data->p_fft != NULL &&
+            !window_init( FFT_BUFFER_SIZE, &p_data->wind_param,
+                          &p_data->wind_ctx ) )
+        {
+            vlc_fft_Delete( p_data->p_fft );
+            p_data->p_fft = NULL;
+        }
+    }
+    if( !p_data->p_fft )
+    {
+        msg_Err( p_aout, "unable to initialize FFT transform" );
+        return -1;
     }
     peaks = (int *)p_data->peaks;
     prev_heights = (int *)p_data->prev_heights;
@@ -186,20 +200,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
-    }
     p_buffs = p_s16_buff;
     for ( i = 0 ; i < FFT_BUFFER_SIZE ; i++)
     {
@@ -211,8 +211,10 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
             p_buffs = p_s16_buff;
 
     }
-    window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
+    for( i = 0; i < FFT_BUFFER_SIZE; i++ )
+        p_samples[i] = p_buffer1[i];
+    vlc_fft_Power( p_data->p_fft, p_output, p_samples );
     for( i = 0; i< FFT_BUFFER_SIZE ; i++ )
         p_dest[i] = p_output[i] *  ( 2 ^ 16 ) / ( ( FFT_BUFFER_SIZE / 2 * 32768 ) ^ 2 );
 
@@ -359,10 +361,6 @@ static int spectrum_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -374,6 +372,9 @@ static void spectrum_Free( void *data )
 
     if( p_data != NULL )
     {
+        if( p_data->p_fft != NULL )
+            vlc_fft_Delete( p_data->p_fft );
+        window_close( &p_data->wind_ctx );
         free( p_data->peaks );
         free( p_data->prev_heights );
         free( p_data->p_prev_s16_buff );
@@ -393,6 +394,8 @@ typedef struct
     int16_t *p_prev_s16_buff;
 
     window_param wind_param;
+    window_context wind_ctx;
+    vlc_fft_t *p_fft;
 } spectrometer_data;
 
 static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
@@ -442,14 +445,12 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
     const int *xscale;
     const double y_scale =  3.60673760222;  /* (log 256) */
 
-    fft_state *p_state;                 /* internal FFT data */
-    DEFINE_WIND_CONTEXT( wind_ctx );    /* internal window data */
-
     int i , j , k;
     int i_line = 0;
     int16_t p_dest[FFT_BUFFER_SIZE];      /* Adapted FFT result */
     int16_t p_buffer1[FFT_BUFFER_SIZE];   /* Buffer on which we perform
                                              the FFT (first channel) */
+    float p_samples[FFT_BUFFER_SIZE];     /* Windowed first channel */
     float *p_buffl =                     /* Original buffer */
             (float*)p_buffer->p_buffer;
 
@@ -477,7 +478,22 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         p_data->i_prev_nb_samples = 0;
         p_data->p_prev_s16_buff = NULL;
         window_get_param( p_aout, &p_data->wind_param );
+        p_data->wind_ctx = (window_context){ NULL, 0 };
         p_effect->p_data = (void*)p_data;
+
+        p_data->p_fft = vlc_fft_New( FFT_BUFFER_SIZE );
+        if( p_data->p_fft != NULL &&
+            !window_init( FFT_BUFFER_SIZE, &p_data->wind_param,
+                          &p_data->wind_ctx ) )
+        {
+            vlc_fft_Delete( p_data->p_fft );
+            p_data->p_fft = NULL;
+        }
+    }
+    if( !p_data->p_fft )
+    {
+        msg_Err( p_aout, "unable to initialize FFT transform" );
+        return -1;
     }
     peaks = p_data->peaks;
 
@@ -534,20 +550,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
 
         p_buffl++ ; p_buffs++ ;
     }
-    p_state  = visual_fft_init();
-    if( !p_state)
-    {
-        msg_Err(p_aout,"unable to initialize FFT transform");
-        free( height );
-        return -1;
-    }
-    if( !window_init( FFT_BUFFER_SIZE, &p_data->wind_param, &wind_ctx ) )
-    {
-        fft_close( p_state );
-        free( height );
-        msg_Err(p_aout,"unable to initialize FFT window");
-        return -1;
-    }
     p_buffs = p_s16_buff;
     for ( i = 0 ; i < FFT_BUFFER_SIZE; i++)
     {
@@ -558,8 +560,10 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         if( p_buffs >= &p_s16_buff[p_buffer->i_nb_samples * p_effect->i_nb_chans] )
             p_buffs = p_s16_buff;
     }
-    window_scale_in_place( p_buffer1, &wind_ctx );
-    fft_perform( p_buffer1, p_output, p_state);
+    window_scale_in_place( p_buffer1, &p_data->wind_ctx );
+    for( i = 0; i < FFT_BUFFER_SIZE; i++ )
+        p_samples[i] = p_buffer1[i];
+    vlc_fft_Power( p_data->p_fft, p_output, p_samples );
     for(i = 0; i < FFT_BUFFER_SIZE; i++)
     {
         int sqrti = sqrt(p_output[i]);
@@ -856,10 +860,6 @@ static int spectrometer_Run(visual_effect_t * p_effect, vlc_object_t *p_aout,
         }
     }
 
-    window_close( &wind_ctx );
-
-    fft_close( p_state );
-
     free( height );
 
     return 0;
@@ -871,6 +871,9 @@ static void spectrometer_Free( void *data )
 
     if( p_data != NULL )
     {
+        if( p_data->p_fft != NULL )
+            vlc_fft_Delete( p_data->p_fft );
+        window_close( &p_data->wind_ctx );
         free( p_data->peaks );
         free( p_data->p_prev_s16_buff );
         free( p_data );
@@ -26,6 +26,9 @@
 
 #include <vlc_common.h>
 
+/* Length of the FFT of the spectrum visualizations */
+#define FFT_BUFFER_SIZE 512
+
 /* Window type enum */
 enum _enum_window_type { NONE, HANN, FLATTOP, BLACKMANHARRIS, KAISER };
 
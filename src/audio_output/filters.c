@@ -42,8 +42,166 @@
 #include <libvlc.h>
 #include "aout_internal.h"
 
+#define AOUT_MAX_FILTERS 10
+
+/** Maximum number of idle buffers kept for recycling */
+#define AOUT_ARENA_MAX 8
+/** Minimum size of a recycled buffer (bytes) */
+#define AOUT_ARENA_MIN_SIZE 4096
+/** Alignment of recycled buffers */
+#define AOUT_ARENA_ALIGN 32
+
+typedef struct aout_arena_buffer aout_arena_buffer_t;
+
+/**
+ * Pool of output buffers recycled between the filters of a pipeline.
+ *
+ * Buffers outlive the pipeline if the audio output still holds them, hence
+ * the arena is reference counted by its outstanding buffers.
+ */
+typedef struct
+{
+    vlc_mutex_t lock;
+    unsigned refs; /**< Outstanding buffers, plus one for the pipeline */
+    bool alive; /**< Whether the pipeline still exists */
+    unsigned count; /**< Number of idle buffers */
+    aout_arena_buffer_t *idle[AOUT_ARENA_MAX]; /**< Idle buffers */
+} aout_arena_t;
+
+struct aout_arena_buffer
+{
+    block_t self;
+    aout_arena_t *arena;
+    size_t size; /**< Allocated payload size */
+};
+
+struct aout_filters
+{
+    filter_t *rate_filter; /**< The filter adjusting samples count
+        (either the scaletempo filter or a resampler) */
+    filter_t *resampler; /**< The resampler */
+    int resampling; /**< Current resampling (Hz) */
+    const aout_request_vout_t *request_vout; /**< Visualization callback */
+    aout_arena_t *arena; /**< Recycled filter output buffers */
+
+    unsigned count; /**< Number of filters */
+    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
+        (e.g. equalization) and their conversions */
+};
+
+static aout_arena_t *aout_ArenaNew (void)
+{
+    aout_arena_t *arena = malloc (sizeof (*arena));
+    if (unlikely(arena == NULL))
+        return NULL;
+
+    vlc_mutex_init (&arena->lock);
+    arena->refs = 1;
+    arena->alive = true;
+    arena->count = 0;
+    return arena;
+}
+
+static void aout_ArenaDestroy (aout_arena_t *arena)
+{
+    vlc_mutex_destroy (&arena->lock);
+    free (arena);
+}
+
+/**
+ * Releases the pipeline reference to an arena.
+ * The arena is destroyed once all its buffers are released too.
+ */
+static void aout_ArenaDelete (aout_arena_t *arena)
+{
+    vlc_mutex_lock (&arena->lock);
+    while (arena->count > 0)
+        free (arena->idle[--arena->count]);
+    arena->alive = false;
+    bool last = --arena->refs == 0;
+    vlc_mutex_unlock (&arena->lock);
+
+    if (last)
+        aout_ArenaDestroy (arena);
+}
+
+static void aout_ArenaRelease (block_t *block)
+{
+    aout_arena_buffer_t *buf = (aout_arena_buffer_t *)block;
+    aout_arena_t *arena = buf->arena;
+
+    vlc_mutex_lock (&arena->lock);
+    if (arena->alive && arena->count < AOUT_ARENA_MAX)
+    {
+        arena->idle[arena->count++] = buf;
+        buf = NULL;
+    }
+    bool last = --arena->refs == 0;
+    vlc_mutex_unlock (&arena->lock);
+
+    free (buf);
+    if (last)
+        aout_ArenaDestroy (arena);
+}
+
+/**
+ * Gets a filter output buffer from the pipeline arena.
+ * An idle buffer is recycled if it is large enough; otherwise a new buffer is
+ * allocated, rounded up to a power of two so that it can be recycled for
+ * slightly larger periods.
+ */
+static block_t *aout_ArenaBufferNew (filter_t *filter, size_t size)
+{
+    aout_filters_t *filters = (aout_filters_t *)filter->owner.sys;
+    aout_arena_t *arena = filters->arena;
+    aout_arena_buffer_t *buf = NULL, *stale = NULL;
+
+    vlc_mutex_lock (&arena->lock);
+    for (unsigned i = 0; i < arena->count; i++)
+        if (arena->idle[i]->size >= size)
+        {
+            buf = arena->idle[i];
+            arena->idle[i] = arena->idle[--arena->count];
+            break;
+        }
+    if (buf == NULL && arena->count == AOUT_ARENA_MAX)
+        stale = arena->idle[--arena->count]; /* make room for a larger one */
+    arena->refs++;
+    vlc_mutex_unlock (&arena->lock);
+
+    free (stale);
+
+    if (buf == NULL)
+    {
+        size_t alloc = AOUT_ARENA_MIN_SIZE;
+        while (alloc < size && alloc <= SIZE_MAX / 2)
+            alloc *= 2;
+        if (alloc < size)
+            alloc = size;
+
+        buf = malloc (sizeof (*buf) + AOUT_ARENA_ALIGN - 1 + alloc);
+        if (unlikely(buf == NULL))
+        {   /* Drop the reference taken above (the pipeline holds another) */
+            vlc_mutex_lock (&arena->lock);
+            arena->refs--;
+            vlc_mutex_unlock (&arena->lock);
+            return NULL;
+        }
+        buf->arena = arena;
+        buf->size = alloc;
+    }
+
+    uintptr_t payload = (uintptr_t)(buf + 1);
+    payload = (payload + AOUT_ARENA_ALIGN - 1)
+            & ~(uintptr_t)(AOUT_ARENA_ALIGN - 1);
+    block_Init (&buf->self, (void *)payload, buf->size);
+    buf->self.i_buffer = size;
+    buf->self.pf_release = aout_ArenaRelease;
+    return &buf->self;
+}
+
 static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
-                               const char *name, filter_owner_sys_t *owner,
+                               const char *name, aout_filters_t *owner,
                                const audio_sample_format_t *infmt,
                                const audio_sample_format_t *outfmt)
 {
@@ -51,7 +209,8 @@ static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
     if (unlikely(filter == NULL))
         return NULL;
 
-    filter->owner.sys = owner;
+    filter->owner.sys = (filter_owner_sys_t *)owner;
+    filter->owner.audio.buffer_new = aout_ArenaBufferNew;
     filter->fmt_in.audio = *infmt;
     filter->fmt_in.i_codec = infmt->i_format;
     filter->fmt_out.audio = *outfmt;
@@ -70,18 +229,18 @@ static filter_t *CreateFilter (vlc_object_t *obj, const char *type,
     return filter;
 }
 
-static filter_t *FindConverter (vlc_object_t *obj,
+static filter_t *FindConverter (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter (obj, "audio converter", NULL, NULL, infmt, outfmt);
+    return CreateFilter (obj, "audio converter", NULL, owner, infmt, outfmt);
 }
 
-static filter_t *FindResampler (vlc_object_t *obj,
+static filter_t *FindResampler (vlc_object_t *obj, aout_filters_t *owner,
                                 const audio_sample_format_t *infmt,
                                 const audio_sample_format_t *outfmt)
 {
-    return CreateFilter (obj, "audio resampler", "$audio-resampler", NULL,
+    return CreateFilter (obj, "audio resampler", "$audio-resampler", owner,
                          infmt, outfmt);
 }
 
@@ -99,7 +258,8 @@ static void aout_FiltersPipelineDestroy(filter_t *const *filters, unsigned n)
     }
 }
 
-static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
+static filter_t *TryFormat (vlc_object_t *obj, aout_filters_t *owner,
+                            vlc_fourcc_t codec,
                             audio_sample_format_t *restrict fmt)
 {
     audio_sample_format_t output = *fmt;
@@ -108,7 +268,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
     output.i_format = codec;
     aout_FormatPrepare (&output);
 
-    filter_t *filter = FindConverter (obj, fmt, &output);
+    filter_t *filter = FindConverter (obj, owner, fmt, &output);
     if (filter != NULL)
         *fmt = output;
     return filter;
@@ -117,6 +277,7 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
 /**
  * Allocates audio format conversion filters
  * @param obj parent VLC object for new filters
+ * @param owner pipeline owning the new filters
  * @param filters table of filters [IN/OUT]
  * @param count pointer to the number of filters in the table [IN/OUT]
  * @param max size of filters table [IN]
@@ -124,7 +285,8 @@ static filter_t *TryFormat (vlc_object_t *obj, vlc_fourcc_t codec,
  * @param outfmt output audio format
  * @return 0 on success, -1 on failure
  */
-static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
+static int aout_FiltersPipelineCreate(vlc_object_t *obj, aout_filters_t *owner,
+                                      filter_t **filters,
                                       unsigned *count, unsigned max,
                                  const audio_sample_format_t *restrict infmt,
                                  const audio_sample_format_t *restrict outfmt)
@@ -145,9 +307,9 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (n == max)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, VLC_CODEC_S32N, &input);
+        filter_t *f = TryFormat (obj, owner, VLC_CODEC_S32N, &input);
         if (f == NULL)
-            f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -168,7 +330,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
             if (n == max)
                 goto overflow;
 
-            filter_t *f = TryFormat (obj, VLC_CODEC_FL32, &input);
+            filter_t *f = TryFormat (obj, owner, VLC_CODEC_FL32, &input);
             if (f == NULL)
             {
                 msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -187,9 +349,23 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         output.i_rate = input.i_rate;
         output.i_physical_channels = outfmt->i_physical_channels;
         output.i_original_channels = outfmt->i_original_channels;
-        aout_FormatPrepare (&output);
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = NULL;
+        /* Without resampling, try to remix straight to the output format */
+        if (input.i_rate == outfmt->i_rate && AOUT_FMT_LINEAR(outfmt)
+         && input.i_format != outfmt->i_format)
+        {
+            output.i_format = outfmt->i_format;
+            aout_FormatPrepare (&output);
+            f = FindConverter (obj, owner, &input, &output);
+        }
+
+        if (f == NULL)
+        {
+            output.i_format = input.i_format;
+            aout_FormatPrepare (&output);
+            f = FindConverter (obj, owner, &input, &output);
+        }
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -210,7 +386,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         audio_sample_format_t output = input;
         output.i_rate = outfmt->i_rate;
 
-        filter_t *f = FindConverter (obj, &input, &output);
+        filter_t *f = FindConverter (obj, owner, &input, &output);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -228,7 +404,7 @@ static int aout_FiltersPipelineCreate(vlc_object_t *obj, filter_t **filters,
         if (max == 0)
             goto overflow;
 
-        filter_t *f = TryFormat (obj, outfmt->i_format, &input);
+        filter_t *f = TryFormat (obj, owner, outfmt->i_format, &input);
         if (f == NULL)
         {
             msg_Err (obj, "cannot find %s for conversion pipeline",
@@ -311,21 +487,6 @@ static void aout_FiltersPipelineFlush(filter_t *const *filters,
         filter_Flush (filters[i]);
 }
 
-
-#define AOUT_MAX_FILTERS 10
-
-struct aout_filters
-{
-    filter_t *rate_filter; /**< The filter adjusting samples count
-        (either the scaletempo filter or a resampler) */
-    filter_t *resampler; /**< The resampler */
-    int resampling; /**< Current resampling (Hz) */
-
-    unsigned count; /**< Number of filters */
-    filter_t *tab[AOUT_MAX_FILTERS]; /**< Configured user filters
-        (e.g. equalization) and their conversions */
-};
-
 /** Callback for visualization selection */
 static int VisualizationCallback (vlc_object_t *obj, const char *var,
                                   vlc_value_t oldval, vlc_value_t newval,
@@ -360,7 +521,8 @@ vout_thread_t *aout_filter_RequestVout (filter_t *filter, vout_thread_t *vout,
      * If you want to use visualization filters from another place, you will
      * need to add a new pf_aout_request_vout callback or store a pointer
      * to aout_request_vout_t inside filter_t (i.e. a level of indirection). */
-    const aout_request_vout_t *req = filter->owner.sys;
+    const aout_filters_t *filters = (aout_filters_t *)filter->owner.sys;
+    const aout_request_vout_t *req = filters->request_vout;
     char *visual = var_InheritString (filter->obj.parent, "audio-visual");
     /* NOTE: Disable recycling to always close the filter vout because OpenGL
      * visualizations do not use this function to ask for a context. */
@@ -371,7 +533,7 @@ vout_thread_t *aout_filter_RequestVout (filter_t *filter, vout_thread_t *vout,
 }
 
 static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
-                        aout_filters_t *restrict filters, const void *owner,
+                        aout_filters_t *restrict filters,
                         audio_sample_format_t *restrict infmt,
                         const audio_sample_format_t *restrict outfmt)
 {
@@ -382,8 +544,7 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
         return -1;
     }
 
-    filter_t *filter = CreateFilter (obj, type, name,
-                                     (void *)owner, infmt, outfmt);
+    filter_t *filter = CreateFilter (obj, type, name, filters, infmt, outfmt);
     if (filter == NULL)
     {
         msg_Err (obj, "cannot add user %s \"%s\" (skipped)", type, name);
@@ -391,8 +552,9 @@ static int AppendFilter(vlc_object_t *obj, const char *type, const char *name,
     }
 
     /* convert to the filter input format if necessary */
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                                    max - 1, infmt, &filter->fmt_in.audio))
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab,
+                                    &filters->count, max - 1, infmt,
+                                    &filter->fmt_in.audio))
     {
         msg_Err (filter, "cannot add user %s \"%s\" (skipped)", type, name);
         module_unneed (filter, filter->p_module);
@@ -434,7 +596,14 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     filters->rate_filter = NULL;
     filters->resampler = NULL;
     filters->resampling = 0;
+    filters->request_vout = request_vout;
     filters->count = 0;
+    filters->arena = aout_ArenaNew ();
+    if (unlikely(filters->arena == NULL))
+    {
+        free (filters);
+        return NULL;
+    }
 
     /* Prepare format structure */
     aout_FormatPrint (obj, "input", infmt);
@@ -451,7 +620,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         if (!AOUT_FMTS_IDENTICAL(infmt, outfmt))
         {
             aout_FormatsPrint (obj, "pass-through:", infmt, outfmt);
-            filters->tab[0] = FindConverter(obj, infmt, outfmt);
+            filters->tab[0] = FindConverter(obj, filters, infmt, outfmt);
             if (filters->tab[0] == NULL)
             {
                 msg_Err (obj, "cannot setup pass-through");
@@ -471,7 +640,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     if (var_InheritBool (obj, "audio-time-stretch"))
     {
         if (AppendFilter(obj, "audio filter", "scaletempo",
-                         filters, NULL, &input_format, &output_format) == 0)
+                         filters, &input_format, &output_format) == 0)
             filters->rate_filter = filters->tab[filters->count - 1];
     }
 
@@ -482,7 +651,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         while ((name = strsep (&p, " :")) != NULL)
         {
             AppendFilter(obj, "audio filter", name, filters,
-                         NULL, &input_format, &output_format);
+                         &input_format, &output_format);
         }
         free (str);
     }
@@ -492,14 +661,15 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
         char *visual = var_InheritString (obj, "audio-visual");
         if (visual != NULL && strcasecmp (visual, "none"))
             AppendFilter(obj, "visualization", visual, filters,
-                         request_vout, &input_format, &output_format);
+                         &input_format, &output_format);
         free (visual);
     }
 
     /* convert to the output format (minus resampling) if necessary */
     output_format.i_rate = input_format.i_rate;
-    if (aout_FiltersPipelineCreate (obj, filters->tab, &filters->count,
-                              AOUT_MAX_FILTERS, &input_format, &output_format))
+    if (aout_FiltersPipelineCreate (obj, filters, filters->tab,
+                                    &filters->count, AOUT_MAX_FILTERS,
+                                    &input_format, &output_format))
     {
         msg_Err (obj, "cannot setup filtering pipeline");
         goto error;
@@ -509,7 +679,7 @@ aout_filters_t *aout_FiltersNew (vlc_object_t *obj,
     /* insert the resampler */
     output_format.i_rate = outfmt->i_rate;
     assert (AOUT_FMTS_IDENTICAL(&output_format, outfmt));
-    filters->resampler = FindResampler (obj, &input_format,
+    filters->resampler = FindResampler (obj, filters, &input_format,
                                         &output_format);
     if (filters->resampler == NULL && input_format.i_rate != outfmt->i_rate)
     {
@@ -525,6 +695,7 @@ error:
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (request_vout != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    aout_ArenaDelete (filters->arena);
     free (filters);
     return NULL;
 }
@@ -545,6 +716,7 @@ void aout_FiltersDelete (vlc_object_t *obj, aout_filters_t *filters)
     aout_FiltersPipelineDestroy (filters->tab, filters->count);
     if (obj != NULL)
         var_DelCallback (obj, "visual", VisualizationCallback, NULL);
+    aout_ArenaDelete (filters->arena);
     free (filters);
 }
 
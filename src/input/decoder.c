@@ -78,6 +78,11 @@ struct decoder_owner_sys_t
     sout_instance_t         *p_sout;
     sout_packetizer_input_t *p_sout_input;
 
+    /* Record: packetized blocks are also sent there */
+    vlc_mutex_t              record_lock;
+    sout_instance_t         *p_sout_record;
+    sout_packetizer_input_t *p_sout_record_input;
+
     vlc_thread_t     thread;
 
     void (*pf_update_stat)( decoder_owner_sys_t *, unsigned decoded, unsigned lost );
@@ -763,6 +768,63 @@ static void DecoderFixTs( decoder_t *p_dec, mtime_t *pi_ts0, mtime_t *pi_ts1,
 }
 
 #ifdef ENABLE_SOUT
+/* This function tees an already packetized block to the record output
+ */
+static void DecoderRecord( decoder_t *p_dec, const es_format_t *p_fmt,
+                           block_t *p_block )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_mutex_lock( &p_owner->record_lock );
+    if( p_owner->p_sout_record == NULL )
+        goto out;
+
+    if( p_owner->p_sout_record_input == NULL )
+    {
+        /* Start on a sync point, so that the record can be decoded from its
+         * beginning */
+        if( p_fmt->i_cat == VIDEO_ES
+         && ( p_block->i_flags & BLOCK_FLAG_TYPE_MASK )
+         && !( p_block->i_flags & BLOCK_FLAG_TYPE_I ) )
+            goto out;
+
+        es_format_t fmt;
+        es_format_Copy( &fmt, p_fmt );
+        fmt.i_group = p_dec->fmt_in.i_group;
+        fmt.i_id = p_dec->fmt_in.i_id;
+        if( p_dec->fmt_in.psz_language )
+        {
+            free( fmt.psz_language );
+            fmt.psz_language = strdup( p_dec->fmt_in.psz_language );
+        }
+
+        p_owner->p_sout_record_input =
+            sout_InputNew( p_owner->p_sout_record, &fmt );
+        es_format_Clean( &fmt );
+
+        if( p_owner->p_sout_record_input == NULL )
+        {
+            msg_Err( p_dec, "cannot create record output (%4.4s)",
+                     (char *)&p_fmt->i_codec );
+            p_owner->p_sout_record = NULL;
+            goto out;
+        }
+    }
+
+    block_t *p_record_block = block_Duplicate( p_block );
+    if( p_record_block != NULL )
+    {
+        vlc_mutex_lock( &p_owner->lock );
+        DecoderFixTs( p_dec, &p_record_block->i_dts, &p_record_block->i_pts,
+                      &p_record_block->i_length, NULL, INT64_MAX );
+        vlc_mutex_unlock( &p_owner->lock );
+
+        sout_InputSendBuffer( p_owner->p_sout_record_input, p_record_block );
+    }
+out:
+    vlc_mutex_unlock( &p_owner->record_lock );
+}
+
 static int DecoderPlaySout( decoder_t *p_dec, block_t *p_sout_block )
 {
     decoder_owner_sys_t *p_owner = p_dec->p_owner;
@@ -837,6 +899,8 @@ static void DecoderProcessSout( decoder_t *p_dec, block_t *p_block )
 
             p_sout_block->p_next = NULL;
 
+            DecoderRecord( p_dec, &p_owner->fmt, p_sout_block );
+
             if( DecoderPlaySout( p_dec, p_sout_block ) == VLC_EGENERIC )
             {
                 msg_Err( p_dec, "cannot continue streaming due to errors" );
@@ -1374,6 +1438,10 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
                 block_t *p_next = p_packetized_block->p_next;
                 p_packetized_block->p_next = NULL;
 
+#ifdef ENABLE_SOUT
+                DecoderRecord( p_dec, &p_packetizer->fmt_out,
+                               p_packetized_block );
+#endif
                 DecoderDecode( p_dec, p_packetized_block );
                 if( p_owner->error )
                 {
@@ -1389,7 +1457,15 @@ static void DecoderProcess( decoder_t *p_dec, block_t *p_block )
             DecoderDecode( p_dec, NULL );
     }
     else
+    {
+#ifdef ENABLE_SOUT
+        /* Reloaded blocks went through here already */
+        if( p_block != NULL
+         && !( p_block->i_flags & BLOCK_FLAG_CORE_PRIVATE_RELOADED ) )
+            DecoderRecord( p_dec, &p_dec->fmt_in, p_block );
+#endif
         DecoderDecode( p_dec, p_block );
+    }
     return;
 
 error:
@@ -1595,6 +1671,8 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     p_owner->i_spu_order = 0;
     p_owner->p_sout = p_sout;
     p_owner->p_sout_input = NULL;
+    p_owner->p_sout_record = NULL;
+    p_owner->p_sout_record_input = NULL;
     p_owner->p_packetizer = NULL;
 
     p_owner->b_fmt_description = false;
@@ -1628,6 +1706,7 @@ static decoder_t * CreateDecoder( vlc_object_t *p_parent,
     }
 
     vlc_mutex_init( &p_owner->lock );
+    vlc_mutex_init( &p_owner->record_lock );
     vlc_cond_init( &p_owner->wait_request );
     vlc_cond_init( &p_owner->wait_acknowledge );
     vlc_cond_init( &p_owner->wait_fifo );
@@ -1770,6 +1849,10 @@ static void DeleteDecoder( decoder_t * p_dec )
     {
         sout_InputDelete( p_owner->p_sout_input );
     }
+    if( p_owner->p_sout_record_input )
+    {
+        sout_InputDelete( p_owner->p_sout_record_input );
+    }
 #endif
     es_format_Clean( &p_owner->fmt );
 
@@ -1798,6 +1881,7 @@ static void DeleteDecoder( decoder_t * p_dec )
     vlc_cond_destroy( &p_owner->wait_acknowledge );
     vlc_cond_destroy( &p_owner->wait_request );
     vlc_mutex_destroy( &p_owner->lock );
+    vlc_mutex_destroy( &p_owner->record_lock );
 
     vlc_object_release( p_dec );
 
@@ -2288,3 +2372,19 @@ void input_DecoderGetObjects( decoder_t *p_dec,
         *pp_aout = p_owner->p_aout ? vlc_object_hold( p_owner->p_aout ) : NULL;
     vlc_mutex_unlock( &p_owner->lock );
 }
+
+void input_DecoderSetRecord( decoder_t *p_dec, sout_instance_t *p_sout )
+{
+    decoder_owner_sys_t *p_owner = p_dec->p_owner;
+
+    vlc_mutex_lock( &p_owner->record_lock );
+#ifdef ENABLE_SOUT
+    if( p_owner->p_sout_record_input != NULL )
+    {
+        sout_InputDelete( p_owner->p_sout_record_input );
+        p_owner->p_sout_record_input = NULL;
+    }
+#endif
+    p_owner->p_sout_record = p_sout;
+    vlc_mutex_unlock( &p_owner->record_lock );
+}
@@ -108,4 +108,14 @@ size_t input_DecoderGetFifoSize( decoder_t *p_dec );
  */
 void input_DecoderGetObjects( decoder_t *, vout_thread_t **, audio_output_t ** );
 
+/**
+ * This function sets the stream output that the packetized data of the decoder
+ * is also sent to, or stops sending it if p_sout is NULL.
+ *
+ * The recording starts on the next sync point. The stream output must remain
+ * valid until this function is called again with NULL or the decoder is
+ * deleted.
+ */
+void input_DecoderSetRecord( decoder_t *, sout_instance_t *p_sout );
+
 #endif
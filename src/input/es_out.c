@@ -168,6 +168,7 @@ struct es_out_sys_t
 
     /* Record */
     sout_instance_t *p_sout_record;
+    bool            b_record_tee; /* decoders feed p_sout_record directly */
 
     /* Used only to limit debugging output */
     int         i_prev_stream_level;
@@ -485,8 +486,22 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
         }
 
         char *psz_sout = NULL;  // TODO conf
+        char *psz_mux = var_GetNonEmptyString( p_input, "input-record-mux" );
 
-        if( !psz_sout && psz_path )
+        if( !psz_sout && psz_path && psz_mux )
+        {
+            /* Mux the packetized data of the played ES, no need to parse
+             * them again */
+            char *psz_file = input_CreateFilename( p_input, psz_path, INPUT_RECORD_PREFIX, psz_mux );
+            if( psz_file )
+            {
+                if( asprintf( &psz_sout, "#std{access=file,mux=%s,dst='%s'}",
+                              psz_mux, psz_file ) < 0 )
+                    psz_sout = NULL;
+                free( psz_file );
+            }
+        }
+        else if( !psz_sout && psz_path )
         {
             char *psz_file = input_CreateFilename( p_input, psz_path, INPUT_RECORD_PREFIX, NULL );
             if( psz_file )
@@ -496,6 +511,8 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
                 free( psz_file );
             }
         }
+        p_sys->b_record_tee = psz_mux != NULL;
+        free( psz_mux );
         free( psz_path );
 
         if( !psz_sout )
@@ -516,6 +533,12 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
             if( !p_es->p_dec || p_es->p_master )
                 continue;
 
+            if( p_sys->b_record_tee )
+            {
+                input_DecoderSetRecord( p_es->p_dec, p_sys->p_sout_record );
+                continue;
+            }
+
             p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
             if( p_es->p_dec_record && p_sys->b_buffering )
                 input_DecoderStartWait( p_es->p_dec_record );
@@ -527,6 +550,9 @@ static int EsOutSetRecord(  es_out_t *out, bool b_record )
         {
             es_out_id_t *p_es = p_sys->es[i];
 
+            if( p_sys->b_record_tee && p_es->p_dec && !p_es->p_master )
+                input_DecoderSetRecord( p_es->p_dec, NULL );
+
             if( !p_es->p_dec_record )
                 continue;
 
@@ -1670,7 +1696,9 @@ static void EsCreateDecoder( es_out_t *out, es_out_id_t *p_es )
         if( p_sys->b_buffering )
             input_DecoderStartWait( p_es->p_dec );
 
-        if( !p_es->p_master && p_sys->p_sout_record )
+        if( !p_es->p_master && p_sys->p_sout_record && p_sys->b_record_tee )
+            input_DecoderSetRecord( p_es->p_dec, p_sys->p_sout_record );
+        else if( !p_es->p_master && p_sys->p_sout_record )
         {
             p_es->p_dec_record = input_DecoderNew( p_input, &p_es->fmt, p_es->p_pgrm->p_clock, p_sys->p_sout_record );
             if( p_es->p_dec_record && p_sys->b_buffering )
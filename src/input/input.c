@@ -553,7 +553,16 @@ static void MainLoopDemux( input_thread_t *p_input, bool *pb_changed )
 
     *pb_changed = false;
 
-    if( input_priv(p_input)->i_stop > 0 && input_priv(p_input)->i_time >= input_priv(p_input)->i_stop )
+    /* The statistics only refresh i_time every 250 ms of wall time. That is
+     * fine when the clock paces the input, but an input running as fast as
+     * the sout allows can demux way past its stop time in that while. */
+    mtime_t i_time = input_priv(p_input)->i_time;
+    if( input_priv(p_input)->i_stop > 0
+     && input_priv(p_input)->b_out_pace_control
+     && demux_Control( p_demux, DEMUX_GET_TIME, &i_time ) )
+        i_time = input_priv(p_input)->i_time;
+
+    if( input_priv(p_input)->i_stop > 0 && i_time >= input_priv(p_input)->i_stop )
         i_ret = VLC_DEMUXER_EOF;
     else
         i_ret = demux_Demux( p_demux );
@@ -2538,6 +2547,13 @@ static input_source_t *InputSourceNew( input_thread_t *p_input,
 #ifdef ENABLE_SOUT
     if( !var_GetBool( p_input, "input-record-native" ) )
         in->b_can_stream_record = false;
+    char *psz_record_mux = var_GetNonEmptyString( p_input, "input-record-mux" );
+    if( psz_record_mux )
+    {
+        /* Recording the played elementary streams is cheaper */
+        in->b_can_stream_record = false;
+        free( psz_record_mux );
+    }
     var_SetBool( p_input, "can-record", true );
 #else
     var_SetBool( p_input, "can-record", in->b_can_stream_record );
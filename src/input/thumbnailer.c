@@ -0,0 +1,695 @@
+/*****************************************************************************
+ * thumbnailer.c: Thumbnail extraction
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include <vlc_thumbnailer.h>
+#include <vlc_codec.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_image.h>
+#include <vlc_interrupt.h>
+#include <vlc_modules.h>
+
+#include "demux.h"
+#include "stream.h"
+#include "input_internal.h"
+
+#define THUMBNAILER_MAX_WORKERS 16
+
+/*****************************************************************************
+ * Structures/definitions
+ *****************************************************************************/
+typedef struct thumbnailer_request_t thumbnailer_request_t;
+struct thumbnailer_request_t
+{
+    thumbnailer_request_t   *p_next;
+
+    input_item_t            *p_item;
+    vlc_thumbnailer_params_t params;
+    vlc_thumbnailer_cb       pf_cb;
+    void                    *data;
+};
+
+typedef struct
+{
+    vlc_thumbnailer_t *p_thumbnailer;
+    vlc_thread_t       thread;
+    vlc_interrupt_t   *p_interrupt;
+} thumbnailer_worker_t;
+
+struct vlc_thumbnailer_t
+{
+    vlc_object_t *p_obj;
+
+    vlc_mutex_t   lock;
+    vlc_cond_t    wait;
+
+    /* Requests waiting for a worker, oldest first */
+    thumbnailer_request_t  *p_first;
+    thumbnailer_request_t **pp_last;
+    bool                    b_quit;
+
+    unsigned              i_workers;
+    thumbnailer_worker_t  workers[];
+};
+
+/* Extraction of a single picture */
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+struct es_out_sys_t
+{
+    vlc_object_t *p_obj;
+
+    /* Selected video elementary stream */
+    es_out_id_t  *p_video;
+    es_format_t   fmt;
+
+    decoder_t    *p_packetizer;
+    decoder_t    *p_decoder;
+
+    picture_t    *p_picture;
+    bool          b_error;
+};
+
+/*****************************************************************************
+ * Decoding
+ *****************************************************************************/
+static int VideoUpdateFormat( decoder_t *p_dec )
+{
+    p_dec->fmt_out.video.i_chroma = p_dec->fmt_out.i_codec;
+    return 0;
+}
+
+static picture_t *VideoNewBuffer( decoder_t *p_dec )
+{
+    return picture_NewFromFormat( &p_dec->fmt_out.video );
+}
+
+static int VideoQueue( decoder_t *p_dec, picture_t *p_pic,
+                       block_t *p_cc, bool p_cc_present[4] )
+{
+    es_out_sys_t *p_sys = p_dec->p_queue_ctx;
+    (void) p_cc_present;
+
+    if( p_cc != NULL )
+        block_Release( p_cc );
+
+    /* Only the first picture after the seek is kept */
+    if( p_sys->p_picture == NULL )
+        p_sys->p_picture = p_pic;
+    else
+        picture_Release( p_pic );
+    return 0;
+}
+
+static void DeleteDecoder( decoder_t *p_dec )
+{
+    if( p_dec->p_module != NULL )
+        module_unneed( p_dec, p_dec->p_module );
+
+    es_format_Clean( &p_dec->fmt_in );
+    es_format_Clean( &p_dec->fmt_out );
+    if( p_dec->p_description )
+        vlc_meta_Delete( p_dec->p_description );
+    vlc_object_release( p_dec );
+}
+
+static decoder_t *CreateDecoder( es_out_sys_t *p_sys, const es_format_t *p_fmt,
+                                 bool b_packetizer )
+{
+    decoder_t *p_dec = vlc_custom_create( p_sys->p_obj, sizeof( *p_dec ),
+                                          b_packetizer ? "packetizer"
+                                                       : "decoder" );
+    if( unlikely(p_dec == NULL) )
+        return NULL;
+
+    p_dec->b_frame_drop_allowed = false;
+    p_dec->i_extra_picture_buffers = 0;
+    p_dec->pf_vout_format_update = VideoUpdateFormat;
+    p_dec->pf_vout_buffer_new = VideoNewBuffer;
+    p_dec->pf_queue_video = VideoQueue;
+    p_dec->p_queue_ctx = p_sys;
+
+    es_format_Copy( &p_dec->fmt_in, p_fmt );
+    es_format_Init( &p_dec->fmt_out, UNKNOWN_ES, 0 );
+
+    if( b_packetizer )
+        p_dec->p_module = module_need( p_dec, "packetizer", "$packetizer",
+                                       false );
+    else
+        p_dec->p_module = module_need( p_dec, "decoder", "$codec", false );
+
+    if( p_dec->p_module == NULL )
+    {
+        msg_Err( p_sys->p_obj, "cannot find %s for `%4.4s'",
+                 b_packetizer ? "packetizer" : "decoder",
+                 (const char *)&p_fmt->i_codec );
+        DeleteDecoder( p_dec );
+        return NULL;
+    }
+    return p_dec;
+}
+
+static void DecodeBlock( es_out_sys_t *p_sys, block_t *p_block )
+{
+    if( p_sys->p_picture != NULL || p_sys->b_error )
+        goto drop;
+
+    if( p_sys->p_decoder == NULL )
+    {
+        /* Nothing to drain */
+        if( p_block == NULL )
+            return;
+
+        /* Create the decoder once the packetizer has parsed the format */
+        p_sys->p_decoder = CreateDecoder( p_sys, p_sys->p_packetizer ?
+                                          &p_sys->p_packetizer->fmt_out :
+                                          &p_sys->fmt, false );
+        if( p_sys->p_decoder == NULL )
+        {
+            p_sys->b_error = true;
+            goto drop;
+        }
+    }
+
+    if( p_sys->p_decoder->pf_decode( p_sys->p_decoder, p_block )
+            != VLCDEC_SUCCESS )
+        p_sys->b_error = true;
+    return;
+
+drop:
+    if( p_block != NULL )
+        block_Release( p_block );
+}
+
+/**
+ * Decodes a block of the selected stream, or drains the decoder if p_block
+ * is NULL.
+ */
+static void Decode( es_out_sys_t *p_sys, block_t *p_block )
+{
+    if( p_sys->p_packetizer == NULL )
+    {
+        DecodeBlock( p_sys, p_block );
+        return;
+    }
+
+    decoder_t *p_packetizer = p_sys->p_packetizer;
+    block_t **pp_block = p_block ? &p_block : NULL;
+    block_t *p_packetized;
+
+    while( (p_packetized = p_packetizer->pf_packetize( p_packetizer,
+                                                       pp_block )) )
+    {
+        while( p_packetized != NULL )
+        {
+            block_t *p_next = p_packetized->p_next;
+
+            p_packetized->p_next = NULL;
+            DecodeBlock( p_sys, p_packetized );
+            p_packetized = p_next;
+        }
+    }
+    if( pp_block == NULL )
+        DecodeBlock( p_sys, NULL );
+}
+
+/*****************************************************************************
+ * Elementary streams output
+ *****************************************************************************/
+static es_out_id_t *EsOutAdd( es_out_t *p_out, const es_format_t *p_fmt )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+    es_out_id_t *p_id = malloc( sizeof( *p_id ) );
+    if( unlikely(p_id == NULL) )
+        return NULL;
+
+    p_id->i_cat = p_fmt->i_cat;
+
+    /* Audio and other streams are never decoded */
+    if( p_fmt->i_cat != VIDEO_ES || p_sys->p_video != NULL )
+        return p_id;
+
+    es_format_Copy( &p_sys->fmt, p_fmt );
+    if( !p_fmt->b_packetized )
+    {
+        p_sys->p_packetizer = CreateDecoder( p_sys, p_fmt, true );
+        if( p_sys->p_packetizer == NULL )
+            p_sys->b_error = true;
+    }
+    p_sys->p_video = p_id;
+    return p_id;
+}
+
+static int EsOutSend( es_out_t *p_out, es_out_id_t *p_id, block_t *p_block )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+
+    if( p_id != p_sys->p_video )
+    {
+        block_Release( p_block );
+        return VLC_SUCCESS;
+    }
+
+    Decode( p_sys, p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *p_out, es_out_id_t *p_id )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+
+    if( p_id == p_sys->p_video )
+    {
+        if( p_sys->p_decoder != NULL )
+            DeleteDecoder( p_sys->p_decoder );
+        if( p_sys->p_packetizer != NULL )
+            DeleteDecoder( p_sys->p_packetizer );
+        es_format_Clean( &p_sys->fmt );
+        p_sys->p_decoder = p_sys->p_packetizer = NULL;
+        p_sys->p_video = NULL;
+    }
+    free( p_id );
+}
+
+static int EsOutControl( es_out_t *p_out, int i_query, va_list args )
+{
+    es_out_sys_t *p_sys = p_out->p_sys;
+
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+        {
+            es_out_id_t *p_id = va_arg( args, es_out_id_t * );
+            bool *pb_enabled = va_arg( args, bool * );
+            *pb_enabled = p_id == p_sys->p_video;
+            return VLC_SUCCESS;
+        }
+        case ES_OUT_GET_EMPTY:
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+/*****************************************************************************
+ * Extraction
+ *****************************************************************************/
+static demux_t *DemuxNew( vlc_object_t *p_obj, const char *psz_mrl,
+                          es_out_t *p_out )
+{
+    const char *psz_access, *psz_demux, *psz_path, *psz_anchor = NULL;
+    char *psz_demux_var = NULL;
+    char *psz_dup = strdup( psz_mrl );
+    if( unlikely(psz_dup == NULL) )
+        return NULL;
+
+    input_SplitMRL( &psz_access, &psz_demux, &psz_path, &psz_anchor, psz_dup );
+    if( psz_demux == NULL || psz_demux[0] == '\0' )
+        psz_demux = psz_demux_var = var_InheritString( p_obj, "demux" );
+    if( psz_demux == NULL )
+        psz_demux = "any";
+
+    /* Try an access demux first */
+    demux_t *p_demux = demux_NewAdvanced( p_obj, NULL, psz_access, psz_demux,
+                                          psz_path, NULL, p_out, false );
+    if( p_demux == NULL )
+    {
+        stream_t *p_stream = stream_AccessNew( p_obj, NULL, false, psz_mrl );
+        if( p_stream != NULL )
+        {
+            p_stream = stream_FilterAutoNew( p_stream );
+            p_demux = demux_NewAdvanced( p_obj, NULL, psz_access, psz_demux,
+                                         psz_path, p_stream, p_out, false );
+            if( p_demux == NULL )
+                vlc_stream_Delete( p_stream );
+        }
+    }
+    free( psz_demux_var );
+    free( psz_dup );
+    return p_demux;
+}
+
+static block_t *Encode( vlc_object_t *p_obj, picture_t *p_pic,
+                        const vlc_thumbnailer_params_t *p_params )
+{
+    video_format_t fmt_in = p_pic->format;
+    video_format_t fmt_out;
+
+    /* Keep the display aspect ratio for the missing dimension */
+    unsigned i_width = fmt_in.i_visible_width;
+    unsigned i_height = fmt_in.i_visible_height;
+    if( fmt_in.i_sar_num > 0 && fmt_in.i_sar_den > 0 )
+        i_width = (uint64_t)i_width * fmt_in.i_sar_num / fmt_in.i_sar_den;
+    if( i_width == 0 || i_height == 0 )
+    {
+        msg_Err( p_obj, "invalid picture size %ux%u",
+                 fmt_in.i_visible_width, fmt_in.i_visible_height );
+        return NULL;
+    }
+
+    if( p_params->i_width > 0 && p_params->i_height == 0 )
+    {
+        i_height = (uint64_t)i_height * p_params->i_width / i_width;
+        i_width = p_params->i_width;
+    }
+    else if( p_params->i_height > 0 && p_params->i_width == 0 )
+    {
+        i_width = (uint64_t)i_width * p_params->i_height / i_height;
+        i_height = p_params->i_height;
+    }
+    else if( p_params->i_width > 0 && p_params->i_height > 0 )
+    {
+        i_width = p_params->i_width;
+        i_height = p_params->i_height;
+    }
+
+    msg_Dbg( p_obj, "encoding %ux%u %4.4s picture to %ux%u %4.4s",
+             fmt_in.i_visible_width, fmt_in.i_visible_height,
+             (const char *)&fmt_in.i_chroma, i_width, i_height,
+             (const char *)&p_params->i_codec );
+
+    video_format_Init( &fmt_out, p_params->i_codec );
+    fmt_out.i_width = fmt_out.i_visible_width = __MAX( i_width, 1 );
+    fmt_out.i_height = fmt_out.i_visible_height = __MAX( i_height, 1 );
+    fmt_out.i_sar_num = fmt_out.i_sar_den = 1;
+
+    image_handler_t *p_image = image_HandlerCreate( p_obj );
+    if( unlikely(p_image == NULL) )
+        return NULL;
+
+    block_t *p_block = image_Write( p_image, p_pic, &fmt_in, &fmt_out );
+    image_HandlerDelete( p_image );
+    return p_block;
+}
+
+static block_t *Extract( vlc_thumbnailer_t *p_thumbnailer,
+                         const thumbnailer_request_t *p_req )
+{
+    const vlc_thumbnailer_params_t *p_params = &p_req->params;
+
+    char *psz_mrl = input_item_GetURI( p_req->p_item );
+    if( psz_mrl == NULL )
+        return NULL;
+
+    /* The options of the item apply to the demuxer and the decoder, as for
+     * an input thread */
+    vlc_object_t *p_obj = vlc_object_create( p_thumbnailer->p_obj,
+                                             sizeof( *p_obj ) );
+    if( unlikely(p_obj == NULL) )
+    {
+        free( psz_mrl );
+        return NULL;
+    }
+    input_item_ApplyOptions( p_obj, p_req->p_item );
+
+    /* Pictures are decoded in system memory */
+    var_Create( p_obj, "avcodec-hw", VLC_VAR_STRING );
+    var_SetString( p_obj, "avcodec-hw", "none" );
+
+    es_out_sys_t sys = {
+        .p_obj = p_obj,
+    };
+    es_out_t out = {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDel,
+        .pf_control = EsOutControl,
+        .p_sys = &sys,
+    };
+
+    demux_t *p_demux = DemuxNew( p_obj, psz_mrl, &out );
+    if( p_demux == NULL )
+    {
+        msg_Err( p_obj, "cannot open `%s'", psz_mrl );
+        vlc_object_release( p_obj );
+        free( psz_mrl );
+        return NULL;
+    }
+
+    /* Land on the nearest keyframe: the first decoded picture is used */
+    int i_ret;
+    if( p_params->i_time >= 0 )
+        i_ret = demux_Control( p_demux, DEMUX_SET_TIME, p_params->i_time,
+                               false );
+    else
+        i_ret = demux_Control( p_demux, DEMUX_SET_POSITION,
+                               (double)p_params->f_pos, false );
+    if( i_ret != VLC_SUCCESS )
+        msg_Dbg( p_obj, "cannot seek `%s', using the first picture", psz_mrl );
+
+    while( sys.p_picture == NULL && !sys.b_error )
+    {
+        if( vlc_killed() )
+            break;
+
+        if( demux_Demux( p_demux ) != VLC_DEMUXER_SUCCESS )
+        {
+            if( sys.p_video != NULL )
+                Decode( &sys, NULL );
+            break;
+        }
+    }
+
+    demux_Delete( p_demux );
+    /* The demuxer may not have deleted its streams */
+    if( sys.p_video != NULL )
+        EsOutDel( &out, sys.p_video );
+
+    block_t *p_image = NULL;
+    if( sys.p_picture != NULL )
+    {
+        p_image = Encode( p_obj, sys.p_picture, p_params );
+        picture_Release( sys.p_picture );
+    }
+    else
+        msg_Warn( p_obj, "no picture decoded from `%s'", psz_mrl );
+
+    vlc_object_release( p_obj );
+    free( psz_mrl );
+    return p_image;
+}
+
+/*****************************************************************************
+ * Workers
+ *****************************************************************************/
+static void TimeoutCallback( void *data )
+{
+    vlc_interrupt_kill( data );
+}
+
+/**
+ * Extracts a thumbnail within the request timeout. The request runs in its
+ * own interrupt context, killed by a timer at the deadline, so that blocking
+ * reads are aborted too. Killing the worker context still aborts it.
+ */
+static block_t *ExtractTimed( vlc_thumbnailer_t *p_thumbnailer,
+                              const thumbnailer_request_t *p_req )
+{
+    if( p_req->params.i_timeout <= 0 )
+        return Extract( p_thumbnailer, p_req );
+
+    vlc_interrupt_t *p_interrupt = vlc_interrupt_create();
+    if( unlikely(p_interrupt == NULL) )
+        return NULL;
+
+    vlc_timer_t timer;
+    if( vlc_timer_create( &timer, TimeoutCallback, p_interrupt ) )
+    {
+        vlc_interrupt_destroy( p_interrupt );
+        return NULL;
+    }
+
+    void *forward[2];
+    vlc_interrupt_forward_start( p_interrupt, forward );
+    vlc_interrupt_t *p_worker_interrupt = vlc_interrupt_set( p_interrupt );
+    const mtime_t i_deadline = mdate() + p_req->params.i_timeout;
+    vlc_timer_schedule( timer, true, i_deadline, 0 );
+
+    block_t *p_image = Extract( p_thumbnailer, p_req );
+    if( p_image == NULL && mdate() >= i_deadline )
+        msg_Warn( p_thumbnailer->p_obj, "thumbnail request timed out" );
+
+    /* Destroying the timer waits for a callback in progress */
+    vlc_timer_destroy( timer );
+    vlc_interrupt_set( p_worker_interrupt );
+    vlc_interrupt_forward_stop( forward );
+    vlc_interrupt_destroy( p_interrupt );
+    return p_image;
+}
+
+static void RequestDelete( thumbnailer_request_t *p_req )
+{
+    input_item_Release( p_req->p_item );
+    free( p_req );
+}
+
+static void *Thread( void *data )
+{
+    thumbnailer_worker_t *p_worker = data;
+    vlc_thumbnailer_t *p_thumbnailer = p_worker->p_thumbnailer;
+
+    vlc_interrupt_set( p_worker->p_interrupt );
+
+    vlc_mutex_lock( &p_thumbnailer->lock );
+    for( ;; )
+    {
+        while( !p_thumbnailer->b_quit && p_thumbnailer->p_first == NULL )
+            vlc_cond_wait( &p_thumbnailer->wait, &p_thumbnailer->lock );
+        if( p_thumbnailer->b_quit )
+            break;
+
+        thumbnailer_request_t *p_req = p_thumbnailer->p_first;
+        p_thumbnailer->p_first = p_req->p_next;
+        if( p_thumbnailer->p_first == NULL )
+            p_thumbnailer->pp_last = &p_thumbnailer->p_first;
+        vlc_mutex_unlock( &p_thumbnailer->lock );
+
+        block_t *p_image = ExtractTimed( p_thumbnailer, p_req );
+        p_req->pf_cb( p_req->data, p_image );
+        RequestDelete( p_req );
+
+        vlc_mutex_lock( &p_thumbnailer->lock );
+    }
+    vlc_mutex_unlock( &p_thumbnailer->lock );
+    return NULL;
+}
+
+#undef vlc_thumbnailer_Create
+vlc_thumbnailer_t *vlc_thumbnailer_Create( vlc_object_t *p_parent,
+                                           unsigned i_workers )
+{
+    i_workers = VLC_CLIP( i_workers, 1, THUMBNAILER_MAX_WORKERS );
+
+    vlc_thumbnailer_t *p_thumbnailer =
+        malloc( sizeof( *p_thumbnailer ) + i_workers * sizeof( thumbnailer_worker_t ) );
+    if( unlikely(p_thumbnailer == NULL) )
+        return NULL;
+
+    p_thumbnailer->p_obj = vlc_object_create( p_parent, sizeof( vlc_object_t ) );
+    if( unlikely(p_thumbnailer->p_obj == NULL) )
+    {
+        free( p_thumbnailer );
+        return NULL;
+    }
+    vlc_mutex_init( &p_thumbnailer->lock );
+    vlc_cond_init( &p_thumbnailer->wait );
+    p_thumbnailer->p_first = NULL;
+    p_thumbnailer->pp_last = &p_thumbnailer->p_first;
+    p_thumbnailer->b_quit = false;
+    p_thumbnailer->i_workers = 0;
+
+    for( unsigned i = 0; i < i_workers; i++ )
+    {
+        thumbnailer_worker_t *p_worker = &p_thumbnailer->workers[i];
+
+        p_worker->p_thumbnailer = p_thumbnailer;
+        p_worker->p_interrupt = vlc_interrupt_create();
+        if( unlikely(p_worker->p_interrupt == NULL) )
+            break;
+        if( vlc_clone( &p_worker->thread, Thread, p_worker,
+                       VLC_THREAD_PRIORITY_LOW ) )
+        {
+            vlc_interrupt_destroy( p_worker->p_interrupt );
+            break;
+        }
+        p_thumbnailer->i_workers++;
+    }
+
+    if( p_thumbnailer->i_workers == 0 )
+    {
+        msg_Err( p_parent, "cannot spawn thumbnailer threads" );
+        vlc_thumbnailer_Delete( p_thumbnailer );
+        return NULL;
+    }
+    return p_thumbnailer;
+}
+
+int vlc_thumbnailer_Request( vlc_thumbnailer_t *p_thumbnailer,
+                             input_item_t *p_item,
+                             const vlc_thumbnailer_params_t *p_params,
+                             vlc_thumbnailer_cb pf_cb, void *data )
+{
+    thumbnailer_request_t *p_req = malloc( sizeof( *p_req ) );
+    if( unlikely(p_req == NULL) )
+        return VLC_ENOMEM;
+
+    p_req->p_next = NULL;
+    p_req->p_item = input_item_Hold( p_item );
+    p_req->params = *p_params;
+    p_req->pf_cb = pf_cb;
+    p_req->data = data;
+
+    vlc_mutex_lock( &p_thumbnailer->lock );
+    *p_thumbnailer->pp_last = p_req;
+    p_thumbnailer->pp_last = &p_req->p_next;
+    vlc_cond_signal( &p_thumbnailer->wait );
+    vlc_mutex_unlock( &p_thumbnailer->lock );
+    return VLC_SUCCESS;
+}
+
+void vlc_thumbnailer_Delete( vlc_thumbnailer_t *p_thumbnailer )
+{
+    vlc_mutex_lock( &p_thumbnailer->lock );
+    thumbnailer_request_t *p_req = p_thumbnailer->p_first;
+    p_thumbnailer->p_first = NULL;
+    p_thumbnailer->pp_last = &p_thumbnailer->p_first;
+    p_thumbnailer->b_quit = true;
+    vlc_cond_broadcast( &p_thumbnailer->wait );
+    vlc_mutex_unlock( &p_thumbnailer->lock );
+
+    for( unsigned i = 0; i < p_thumbnailer->i_workers; i++ )
+    {
+        thumbnailer_worker_t *p_worker = &p_thumbnailer->workers[i];
+
+        vlc_interrupt_kill( p_worker->p_interrupt );
+        vlc_join( p_worker->thread, NULL );
+        vlc_interrupt_destroy( p_worker->p_interrupt );
+    }
+
+    /* Canceled requests */
+    while( p_req != NULL )
+    {
+        thumbnailer_request_t *p_next = p_req->p_next;
+
+        p_req->pf_cb( p_req->data, NULL );
+        RequestDelete( p_req );
+        p_req = p_next;
+    }
+
+    vlc_cond_destroy( &p_thumbnailer->wait );
+    vlc_mutex_destroy( &p_thumbnailer->lock );
+    vlc_object_release( p_thumbnailer->p_obj );
+    free( p_thumbnailer );
+}
@@ -520,6 +520,7 @@ void input_ConfigVarInit ( input_thread_t *p_input )
 
     /* */
     var_Create( p_input, "input-record-native", VLC_VAR_BOOL | VLC_VAR_DOINHERIT );
+    var_Create( p_input, "input-record-mux", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
 
     /* */
     var_Create( p_input, "access", VLC_VAR_STRING | VLC_VAR_DOINHERIT );
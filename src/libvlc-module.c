@@ -386,6 +386,17 @@ static const char *const ppsz_pos_descriptions[] =
     "picture quality, for instance deinterlacing, or distort " \
     "the video.")
 
+#define VIDEO_FILTER_THREADS_TEXT N_("Video filter threads")
+#define VIDEO_FILTER_THREADS_LONGTEXT N_( \
+    "Number of threads used by slice-threaded video filters " \
+    "(0 means one per CPU).")
+
+#define VIDEO_FILTER_PIPELINE_TEXT N_("Pipeline video filters")
+#define VIDEO_FILTER_PIPELINE_LONGTEXT N_( \
+    "Run the deinterlacing and post-processing filters on their own " \
+    "thread, ahead of the display, so that slow filters do not delay " \
+    "the presentation of pictures.")
+
 #define SNAP_PATH_TEXT N_("Video snapshot directory (or filename)")
 #define SNAP_PATH_LONGTEXT N_( \
     "Directory where the video snapshots will be stored.")
@@ -475,6 +486,13 @@ static const char *const ppsz_pos_descriptions[] =
     "This drops frames that are late (arrive to the video output after " \
     "their intended display date)." )
 
+#define VIDEO_POOL_GROW_TEXT N_("Grow the picture pool")
+#define VIDEO_POOL_GROW_LONGTEXT N_( \
+    "When the video output cannot use the display buffers, allocate " \
+    "additional pictures in system memory if deep reordering or " \
+    "filtering holds all of them, rather than stalling the decoder. " \
+    "This uses more memory.")
+
 #define QUIET_SYNCHRO_TEXT N_("Quiet synchro")
 #define QUIET_SYNCHRO_LONGTEXT N_( \
     "This avoids flooding the message log with debug output from the " \
@@ -673,6 +691,19 @@ static const char *const ppsz_prefres[] = {
     "When possible, the input stream will be recorded instead of using " \
     "the stream output module" )
 
+#define INPUT_RECORD_MUX_TEXT N_("Record muxer")
+#define INPUT_RECORD_MUX_LONGTEXT N_( \
+    "When set, the elementary streams being played are recorded directly " \
+    "into this container, reusing the data already parsed for playback. " \
+    "Only the selected program and tracks are recorded. This takes " \
+    "precedence over native stream recording. When unset, the legacy " \
+    "stream or stream output recording is used." )
+
+static const char *const ppsz_input_record_mux[] = {
+    "", "ts", "mkv", "mp4" };
+static const char *const ppsz_input_record_mux_text[] = {
+    N_("Disabled (legacy record)"), "MPEG-TS", "Matroska", "MP4" };
+
 #define INPUT_TIMESHIFT_PATH_TEXT N_("Timeshift directory")
 #define INPUT_TIMESHIFT_PATH_LONGTEXT N_( \
     "Directory used to store the timeshift temporary files." )
@@ -1530,6 +1561,8 @@ vlc_module_begin ()
         change_private ()
     add_bool( "drop-late-frames", 1, DROP_LATE_FRAMES_TEXT,
               DROP_LATE_FRAMES_LONGTEXT, true )
+    add_bool( "video-pool-grow", false, VIDEO_POOL_GROW_TEXT,
+              VIDEO_POOL_GROW_LONGTEXT, true )
     /* Used in vout_synchro */
     add_bool( "skip-frames", 1, SKIP_FRAMES_TEXT,
               SKIP_FRAMES_LONGTEXT, true )
@@ -1627,6 +1660,11 @@ vlc_module_begin ()
     set_subcategory( SUBCAT_VIDEO_VFILTER )
     add_module_list( "video-filter", "video filter", NULL,
                      VIDEO_FILTER_TEXT, VIDEO_FILTER_LONGTEXT, false )
+    add_integer( "video-filter-threads", 0, VIDEO_FILTER_THREADS_TEXT,
+                 VIDEO_FILTER_THREADS_LONGTEXT, true )
+        change_integer_range( 0, 64 )
+    add_bool( "video-filter-pipeline", false, VIDEO_FILTER_PIPELINE_TEXT,
+              VIDEO_FILTER_PIPELINE_LONGTEXT, true )
 
     set_subcategory( SUBCAT_VIDEO_SPLITTER )
     add_module_list( "video-splitter", "video splitter", NULL,
@@ -1872,6 +1910,9 @@ vlc_module_begin ()
                 INPUT_RECORD_PATH_LONGTEXT, true )
     add_bool( "input-record-native", true, INPUT_RECORD_NATIVE_TEXT,
               INPUT_RECORD_NATIVE_LONGTEXT, true )
+    add_string( "input-record-mux", "", INPUT_RECORD_MUX_TEXT,
+                INPUT_RECORD_MUX_LONGTEXT, true )
+        change_string_list( ppsz_input_record_mux, ppsz_input_record_mux_text )
 
     add_directory( "input-timeshift-path", NULL, INPUT_TIMESHIFT_PATH_TEXT,
                 INPUT_TIMESHIFT_PATH_LONGTEXT, true )
@@ -102,6 +102,7 @@ libvlc_int_t * libvlc_InternalCreate( void )
     priv = libvlc_priv (p_libvlc);
     priv->playlist = NULL;
     priv->p_vlm = NULL;
+    priv->slices = NULL;
 
     vlc_ExitInit( &priv->exit );
 
@@ -538,6 +539,7 @@ void libvlc_InternalCleanup( libvlc_int_t *p_libvlc )
         playlist_preparser_Delete(priv->parser);
 
     vlc_DeinitActions( p_libvlc, priv->actions );
+    vlc_slices_Destroy( priv->slices );
 
     /* Save the configuration */
     if( !var_InheritBool( p_libvlc, "ignore-config" ) )
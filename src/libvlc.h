@@ -135,6 +135,7 @@ void vlc_object_set_destructor (vlc_object_t *, vlc_destructor_t);
  */
 typedef struct vlc_dialog_provider vlc_dialog_provider;
 typedef struct vlc_keystore vlc_keystore;
+typedef struct vlc_slices vlc_slices_t;
 
 typedef struct libvlc_priv_t
 {
@@ -151,6 +152,7 @@ typedef struct libvlc_priv_t
     struct playlist_t *playlist; ///< Playlist for interfaces
     struct playlist_preparser_t *parser; ///< Input item meta data handler
     struct vlc_actions *actions; ///< Hotkeys handler
+    vlc_slices_t      *slices; ///< Slice worker pool (or NULL)
 
     /* Exit callback */
     vlc_exit_t       exit;
@@ -165,6 +167,14 @@ int intf_InsertItem(libvlc_int_t *, const char *mrl, unsigned optc,
                     const char * const *optv, unsigned flags);
 void intf_DestroyAll( libvlc_int_t * );
 
+/*
+ * Slice worker pool
+ */
+unsigned vlc_slices_GetThreads( libvlc_int_t * );
+void vlc_slices_Run( libvlc_int_t *, unsigned count,
+                     void (*)( void *, unsigned, unsigned ), void * );
+void vlc_slices_Destroy( vlc_slices_t * );
+
 #define libvlc_stats( o ) (libvlc_priv((VLC_OBJECT(o))->obj.libvlc)->b_stats)
 
 /*
@@ -127,6 +127,7 @@ void vlc_CPU_init (void)
 
 #if defined( __i386__ ) || defined( __x86_64__ )
      unsigned int i_eax, i_ebx, i_ecx, i_edx;
+     unsigned int i_level;
      bool b_amd;
 
     /* Needed for x86 CPU capabilities detection */
@@ -136,13 +137,13 @@ void vlc_CPU_init (void)
                    "cpuid\n\t" \
                    "xchgl %%ebx,%1\n\t" \
                    : "=a" (i_eax), "=r" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # else
 #  define cpuid(reg) \
      asm volatile ("cpuid\n\t" \
                    : "=a" (i_eax), "=b" (i_ebx), "=c" (i_ecx), "=d" (i_edx) \
-                   : "a" (reg) \
+                   : "a" (reg), "c" (0) \
                    : "cc");
 # endif
      /* Check if the OS really supports the requested instructions */
@@ -172,6 +173,7 @@ void vlc_CPU_init (void)
 
     /* the CPU supports the CPUID instruction - get its level */
     cpuid( 0x00000000 );
+    i_level = i_eax;
 
 # if defined (__i386__) && !defined (__i586__) \
   && !defined (__i686__) && !defined (__pentium4__) \
@@ -212,6 +214,33 @@ void vlc_CPU_init (void)
             i_capabilities |= VLC_CPU_SSE4_2;
     }
 
+    /* AVX needs the OS to save the YMM registers (OSXSAVE and XCR0) */
+    if( ( i_ecx & 0x18000000 ) == 0x18000000 )
+    {
+        unsigned int i_xcr0, i_xcr0_high;
+
+        /* xgetbv, spelled out for older assemblers */
+        asm volatile (".byte 0x0f, 0x01, 0xd0\n\t"
+                      : "=a" (i_xcr0), "=d" (i_xcr0_high) : "c" (0));
+        (void) i_xcr0_high;
+
+        if( ( i_xcr0 & 0x06 ) == 0x06 )
+        {
+            i_capabilities |= VLC_CPU_AVX;
+
+            if( i_level >= 7 )
+            {
+                cpuid( 0x00000007 );
+                if( i_ebx & 0x00000020 )
+                    i_capabilities |= VLC_CPU_AVX2;
+                /* AVX-512 F and BW, with the opmask and ZMM states saved */
+                if( ( i_ebx & 0x40010000 ) == 0x40010000
+                 && ( i_xcr0 & 0xe0 ) == 0xe0 )
+                    i_capabilities |= VLC_CPU_AVX512;
+            }
+        }
+    }
+
     /* test for additional capabilities */
     cpuid( 0x80000000 );
 
@@ -307,6 +336,8 @@ void vlc_CPU_dump (vlc_object_t *obj)
         vlc_memstream_puts(&stream, "AVX ");
     if (vlc_CPU_AVX2())
         vlc_memstream_puts(&stream, "AVX2 ");
+    if (vlc_CPU_AVX512())
+        vlc_memstream_puts(&stream, "AVX-512 ");
     if (vlc_CPU_3dNOW())
         vlc_memstream_puts(&stream, "3DNow! ");
     if (vlc_CPU_XOP())
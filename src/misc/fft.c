@@ -0,0 +1,452 @@
+/*****************************************************************************
+ * fft.c: real fast Fourier transform
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The real transform of N samples is computed by a complex transform of the
+ * N / 2 pairs of even and odd samples, whose spectrum is then split into the
+ * spectra of the even and odd samples. The complex transform is an iterative
+ * radix-2 decimation in time, on split real and imaginary arrays: the first
+ * two passes are merged into a radix-4 pass without multiplications, and the
+ * others are vectorized over the butterflies of each group. The inverse
+ * transform conjugates its input and output to reuse the forward passes.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_fft.h>
+
+struct fft_tables
+{
+    unsigned size; /**< Complex transform length (half the real length) */
+    unsigned refs;
+    unsigned *bitrev; /**< Bit reversal permutation */
+    float *wr, *wi; /**< Twiddles of the pass of half-groups of h at [h, 2h) */
+    float *rc, *rs; /**< cos, sin of pi.k / size, to split the spectrum */
+};
+
+struct vlc_fft
+{
+    struct fft_tables *tables;
+    void (*passes)(const struct fft_tables *, float *, float *);
+    float *zr, *zi; /**< Complex transform (size) */
+    float *spectrum; /**< Power spectrum scratch (2 x size) */
+};
+
+/*** Tables, shared by the transforms of the same length ***/
+static vlc_mutex_t tables_lock = VLC_STATIC_MUTEX;
+static struct fft_tables *tables_cache[32];
+
+static void TablesDelete(struct fft_tables *t)
+{
+    vlc_free(t->rs);
+    vlc_free(t->rc);
+    vlc_free(t->wi);
+    vlc_free(t->wr);
+    free(t->bitrev);
+    free(t);
+}
+
+static struct fft_tables *TablesNew(unsigned bits)
+{
+    struct fft_tables *t = malloc(sizeof (*t));
+    if (unlikely(t == NULL))
+        return NULL;
+
+    const unsigned n = 1u << bits;
+
+    t->size = n;
+    t->refs = 1;
+    t->bitrev = malloc(n * sizeof (*t->bitrev));
+    t->wr = vlc_memalign(32, n * sizeof (float));
+    t->wi = vlc_memalign(32, n * sizeof (float));
+    t->rc = vlc_memalign(32, n * sizeof (float));
+    t->rs = vlc_memalign(32, n * sizeof (float));
+    if (unlikely(t->bitrev == NULL || t->wr == NULL || t->wi == NULL
+              || t->rc == NULL || t->rs == NULL))
+    {
+        TablesDelete(t);
+        return NULL;
+    }
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        unsigned r = 0;
+
+        for (unsigned b = 0; b < bits; b++)
+            r |= ((k >> b) & 1) << (bits - 1 - b);
+        t->bitrev[k] = r;
+        t->rc[k] = cos(M_PI * k / n);
+        t->rs[k] = sin(M_PI * k / n);
+    }
+
+    /* exp(-i.pi.j / h) for the butterflies j of half-groups of h */
+    t->wr[0] = t->wi[0] = 0.f;
+    for (unsigned h = 1; h < n; h *= 2)
+        for (unsigned j = 0; j < h; j++)
+        {
+            t->wr[h + j] = cos(M_PI * j / h);
+            t->wi[h + j] = -sin(M_PI * j / h);
+        }
+    return t;
+}
+
+static struct fft_tables *TablesHold(unsigned bits)
+{
+    struct fft_tables *t;
+
+    vlc_mutex_lock(&tables_lock);
+    t = tables_cache[bits];
+    if (t != NULL)
+        t->refs++;
+    else
+        t = tables_cache[bits] = TablesNew(bits);
+    vlc_mutex_unlock(&tables_lock);
+    return t;
+}
+
+static void TablesRelease(struct fft_tables *t)
+{
+    unsigned bits = 0;
+
+    while ((1u << bits) < t->size)
+        bits++;
+
+    vlc_mutex_lock(&tables_lock);
+    assert(tables_cache[bits] == t);
+    if (--t->refs == 0)
+        tables_cache[bits] = NULL;
+    else
+        t = NULL;
+    vlc_mutex_unlock(&tables_lock);
+
+    if (t != NULL)
+        TablesDelete(t);
+}
+
+/*** Complex transform passes ***/
+
+/* The passes of half-groups of 1 and 2: their twiddles are 1 and -i */
+static void FirstPasses(float *restrict zr, float *restrict zi, unsigned n)
+{
+    for (unsigned i = 0; i < n; i += 4)
+    {
+        const float t0r = zr[i] + zr[i + 1], t0i = zi[i] + zi[i + 1];
+        const float t1r = zr[i] - zr[i + 1], t1i = zi[i] - zi[i + 1];
+        const float t2r = zr[i + 2] + zr[i + 3], t2i = zi[i + 2] + zi[i + 3];
+        const float t3r = zr[i + 2] - zr[i + 3], t3i = zi[i + 2] - zi[i + 3];
+
+        zr[i] = t0r + t2r;
+        zi[i] = t0i + t2i;
+        zr[i + 2] = t0r - t2r;
+        zi[i + 2] = t0i - t2i;
+        zr[i + 1] = t1r + t3i;
+        zi[i + 1] = t1i - t3r;
+        zr[i + 3] = t1r - t3i;
+        zi[i + 3] = t1i + t3r;
+    }
+}
+
+static void PassesC(const struct fft_tables *t, float *restrict zr,
+                    float *restrict zi)
+{
+    const unsigned n = t->size;
+
+    FirstPasses(zr, zi, n);
+    for (unsigned h = 4; h < n; h *= 2)
+    {
+        const float *wr = t->wr + h, *wi = t->wi + h;
+
+        for (unsigned i = 0; i < n; i += 2 * h)
+        {
+            float *ar = zr + i, *ai = zi + i, *br = ar + h, *bi = ai + h;
+
+            for (unsigned j = 0; j < h; j++)
+            {
+                const float tr = br[j] * wr[j] - bi[j] * wi[j];
+                const float ti = br[j] * wi[j] + bi[j] * wr[j];
+
+                br[j] = ar[j] - tr;
+                bi[j] = ai[j] - ti;
+                ar[j] += tr;
+                ai[j] += ti;
+            }
+        }
+    }
+}
+
+#if defined(CAN_COMPILE_SSE2) && (defined(__GNUC__) || defined(__clang__))
+#include <emmintrin.h>
+
+#define HAVE_FFT_SSE2
+
+__attribute__ ((__target__ ("sse2")))
+static inline void ButterfliesSSE2(float *ar, float *ai, float *br,
+                                   float *bi, const float *wr,
+                                   const float *wi, unsigned h)
+{
+    for (unsigned j = 0; j < h; j += 4)
+    {
+        const __m128 xr = _mm_load_ps(br + j), xi = _mm_load_ps(bi + j);
+        const __m128 cr = _mm_load_ps(wr + j), ci = _mm_load_ps(wi + j);
+        const __m128 tr = _mm_sub_ps(_mm_mul_ps(xr, cr), _mm_mul_ps(xi, ci));
+        const __m128 ti = _mm_add_ps(_mm_mul_ps(xr, ci), _mm_mul_ps(xi, cr));
+        const __m128 yr = _mm_load_ps(ar + j), yi = _mm_load_ps(ai + j);
+
+        _mm_store_ps(br + j, _mm_sub_ps(yr, tr));
+        _mm_store_ps(bi + j, _mm_sub_ps(yi, ti));
+        _mm_store_ps(ar + j, _mm_add_ps(yr, tr));
+        _mm_store_ps(ai + j, _mm_add_ps(yi, ti));
+    }
+}
+
+__attribute__ ((__target__ ("sse2")))
+static void PassesSSE2(const struct fft_tables *t, float *zr, float *zi)
+{
+    const unsigned n = t->size;
+
+    FirstPasses(zr, zi, n);
+    for (unsigned h = 4; h < n; h *= 2)
+        for (unsigned i = 0; i < n; i += 2 * h)
+            ButterfliesSSE2(zr + i, zi + i, zr + i + h, zi + i + h,
+                            t->wr + h, t->wi + h, h);
+}
+#endif
+
+#if defined(CAN_COMPILE_AVX2) && (defined(__GNUC__) || defined(__clang__))
+#include <immintrin.h>
+
+#define HAVE_FFT_AVX2
+#define VLC_TARGET __attribute__ ((__target__ ("avx2")))
+
+VLC_TARGET
+static void PassesAVX2(const struct fft_tables *t, float *zr, float *zi)
+{
+    const unsigned n = t->size;
+
+    FirstPasses(zr, zi, n);
+    if (n > 4)
+        for (unsigned i = 0; i < n; i += 8)
+            ButterfliesSSE2(zr + i, zi + i, zr + i + 4, zi + i + 4,
+                            t->wr + 4, t->wi + 4, 4);
+
+    for (unsigned h = 8; h < n; h *= 2)
+        for (unsigned i = 0; i < n; i += 2 * h)
+        {
+            float *ar = zr + i, *ai = zi + i, *br = ar + h, *bi = ai + h;
+            const float *wr = t->wr + h, *wi = t->wi + h;
+
+            for (unsigned j = 0; j < h; j += 8)
+            {
+                const __m256 xr = _mm256_load_ps(br + j);
+                const __m256 xi = _mm256_load_ps(bi + j);
+                const __m256 cr = _mm256_load_ps(wr + j);
+                const __m256 ci = _mm256_load_ps(wi + j);
+                const __m256 tr = _mm256_sub_ps(_mm256_mul_ps(xr, cr),
+                                                _mm256_mul_ps(xi, ci));
+                const __m256 ti = _mm256_add_ps(_mm256_mul_ps(xr, ci),
+                                                _mm256_mul_ps(xi, cr));
+                const __m256 yr = _mm256_load_ps(ar + j);
+                const __m256 yi = _mm256_load_ps(ai + j);
+
+                _mm256_store_ps(br + j, _mm256_sub_ps(yr, tr));
+                _mm256_store_ps(bi + j, _mm256_sub_ps(yi, ti));
+                _mm256_store_ps(ar + j, _mm256_add_ps(yr, tr));
+                _mm256_store_ps(ai + j, _mm256_add_ps(yi, ti));
+            }
+        }
+}
+#undef VLC_TARGET
+#endif
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+
+#define HAVE_FFT_NEON
+
+static void PassesNEON(const struct fft_tables *t, float *zr, float *zi)
+{
+    const unsigned n = t->size;
+
+    FirstPasses(zr, zi, n);
+    for (unsigned h = 4; h < n; h *= 2)
+        for (unsigned i = 0; i < n; i += 2 * h)
+        {
+            float *ar = zr + i, *ai = zi + i, *br = ar + h, *bi = ai + h;
+            const float *wr = t->wr + h, *wi = t->wi + h;
+
+            for (unsigned j = 0; j < h; j += 4)
+            {
+                const float32x4_t xr = vld1q_f32(br + j);
+                const float32x4_t xi = vld1q_f32(bi + j);
+                const float32x4_t cr = vld1q_f32(wr + j);
+                const float32x4_t ci = vld1q_f32(wi + j);
+                const float32x4_t tr = vmlsq_f32(vmulq_f32(xr, cr), xi, ci);
+                const float32x4_t ti = vmlaq_f32(vmulq_f32(xr, ci), xi, cr);
+                const float32x4_t yr = vld1q_f32(ar + j);
+                const float32x4_t yi = vld1q_f32(ai + j);
+
+                vst1q_f32(br + j, vsubq_f32(yr, tr));
+                vst1q_f32(bi + j, vsubq_f32(yi, ti));
+                vst1q_f32(ar + j, vaddq_f32(yr, tr));
+                vst1q_f32(ai + j, vaddq_f32(yi, ti));
+            }
+        }
+}
+#endif
+
+/*** Real transform ***/
+vlc_fft_t *vlc_fft_New(unsigned size)
+{
+    if (size < 8 || (size & (size - 1)))
+        return NULL;
+
+    unsigned bits = 0;
+    while ((2u << bits) < size)
+        bits++;
+
+    vlc_fft_t *fft = malloc(sizeof (*fft));
+    if (unlikely(fft == NULL))
+        return NULL;
+
+    fft->tables = TablesHold(bits);
+    fft->zr = vlc_memalign(32, size / 2 * sizeof (float));
+    fft->zi = vlc_memalign(32, size / 2 * sizeof (float));
+    fft->spectrum = malloc(size * sizeof (float));
+    if (unlikely(fft->tables == NULL || fft->zr == NULL || fft->zi == NULL
+              || fft->spectrum == NULL))
+    {
+        if (fft->tables != NULL)
+            TablesRelease(fft->tables);
+        vlc_free(fft->zr);
+        vlc_free(fft->zi);
+        free(fft->spectrum);
+        free(fft);
+        return NULL;
+    }
+
+    fft->passes = PassesC;
+#ifdef HAVE_FFT_SSE2
+    if (vlc_CPU_SSE2())
+        fft->passes = PassesSSE2;
+#endif
+#ifdef HAVE_FFT_AVX2
+    if (vlc_CPU_AVX2())
+        fft->passes = PassesAVX2;
+#endif
+#ifdef HAVE_FFT_NEON
+    fft->passes = PassesNEON;
+#endif
+    return fft;
+}
+
+void vlc_fft_Delete(vlc_fft_t *fft)
+{
+    TablesRelease(fft->tables);
+    free(fft->spectrum);
+    vlc_free(fft->zi);
+    vlc_free(fft->zr);
+    free(fft);
+}
+
+void vlc_fft_Forward(vlc_fft_t *fft, float *restrict spectrum,
+                     const float *restrict x)
+{
+    const struct fft_tables *t = fft->tables;
+    const unsigned n = t->size;
+    const float *rc = t->rc, *rs = t->rs;
+    float *restrict zr = fft->zr, *restrict zi = fft->zi;
+    float *restrict xr = spectrum, *restrict xi = spectrum + n;
+
+    /* Even samples as real parts, odd samples as imaginary parts */
+    for (unsigned k = 0; k < n; k++)
+    {
+        zr[t->bitrev[k]] = x[2 * k];
+        zi[t->bitrev[k]] = x[2 * k + 1];
+    }
+    fft->passes(t, zr, zi);
+
+    xr[0] = zr[0] + zi[0];
+    xi[0] = zr[0] - zi[0];
+    for (unsigned k = 1; k < n; k++)
+    {
+        /* Spectra of the even (e) and odd (o) samples */
+        const float er = .5f * (zr[k] + zr[n - k]);
+        const float ei = .5f * (zi[k] - zi[n - k]);
+        const float o_r = .5f * (zi[k] + zi[n - k]);
+        const float o_i = -.5f * (zr[k] - zr[n - k]);
+
+        xr[k] = er + rc[k] * o_r + rs[k] * o_i;
+        xi[k] = ei + rc[k] * o_i - rs[k] * o_r;
+    }
+}
+
+void vlc_fft_Inverse(vlc_fft_t *fft, float *restrict x,
+                     const float *restrict spectrum)
+{
+    const struct fft_tables *t = fft->tables;
+    const unsigned n = t->size;
+    const float *rc = t->rc, *rs = t->rs;
+    float *restrict zr = fft->zr, *restrict zi = fft->zi;
+    const float *restrict xr = spectrum, *restrict xi = spectrum + n;
+
+    /* Merge the spectra of the even and odd samples, conjugated */
+    zr[0] = xr[0] + xi[0];
+    zi[0] = xi[0] - xr[0];
+    for (unsigned k = 1; k < n; k++)
+    {
+        const unsigned r = t->bitrev[k];
+        const float sr = xr[k] + xr[n - k], si = xi[k] - xi[n - k];
+        const float dr = xr[k] - xr[n - k], di = xi[k] + xi[n - k];
+        const float pr = rc[k] * dr - rs[k] * di;
+        const float pi = rc[k] * di + rs[k] * dr;
+
+        zr[r] = sr - pi;
+        zi[r] = -(si + pr);
+    }
+    fft->passes(t, zr, zi);
+
+    for (unsigned k = 0; k < n; k++)
+    {
+        x[2 * k] = zr[k];
+        x[2 * k + 1] = -zi[k];
+    }
+}
+
+void vlc_fft_Power(vlc_fft_t *fft, float *restrict power,
+                   const float *restrict x)
+{
+    const unsigned n = fft->tables->size;
+    const float *xr = fft->spectrum, *xi = fft->spectrum + n;
+
+    vlc_fft_Forward(fft, fft->spectrum, x);
+
+    power[0] = .25f * xr[0] * xr[0];
+    for (unsigned k = 1; k < n; k++)
+        power[k] = xr[k] * xr[k] + xi[k] * xi[k];
+    power[n] = .25f * xi[0] * xi[0];
+}
@@ -111,6 +111,45 @@ void filter_DeleteBlend( filter_t *p_blend )
     vlc_object_release( p_blend );
 }
 
+/* Below this many lines per slice, threading costs more than it saves */
+#define SLICE_MIN_LINES 16
+
+unsigned filter_GetSliceCount( filter_t *p_filter, int i_lines )
+{
+    unsigned i_slices = vlc_slices_GetThreads( p_filter->obj.libvlc );
+
+    if( i_lines < (int)i_slices * SLICE_MIN_LINES )
+        i_slices = __MAX( i_lines / SLICE_MIN_LINES, 1 );
+    return i_slices;
+}
+
+typedef struct
+{
+    filter_t *p_filter;
+    void (*pf_slice)( filter_t *, void *, unsigned, unsigned );
+    void *opaque;
+} filter_slices_t;
+
+static void RunSlice( void *data, unsigned i_slice, unsigned i_slices )
+{
+    filter_slices_t *p_sl = data;
+
+    p_sl->pf_slice( p_sl->p_filter, p_sl->opaque, i_slice, i_slices );
+}
+
+void filter_RunSlices( filter_t *p_filter, unsigned i_slices,
+                       void (*pf_slice)( filter_t *, void *, unsigned, unsigned ),
+                       void *opaque )
+{
+    filter_slices_t sl = {
+        .p_filter = p_filter,
+        .pf_slice = pf_slice,
+        .opaque = opaque,
+    };
+
+    vlc_slices_Run( p_filter->obj.libvlc, i_slices, RunSlice, &sl );
+}
+
 /* */
 #include <vlc_video_splitter.h>
 
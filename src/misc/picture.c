@@ -264,6 +264,61 @@ picture_t *picture_NewFromResource( const video_format_t *p_fmt, const picture_r
     return p_picture;
 }
 
+/**
+ * Destroys a picture allocated by picture_NewView().
+ */
+static void picture_DestroyView( picture_t *p_picture )
+{
+    picture_priv_t *priv = (picture_priv_t *)p_picture;
+
+    picture_Release( priv->gc.opaque );
+    free( p_picture );
+}
+
+picture_t *picture_NewView( picture_t *p_src, const video_format_t *p_fmt,
+                            unsigned i_x, unsigned i_y )
+{
+    if( p_fmt->i_chroma != p_src->format.i_chroma ||
+        i_x + p_fmt->i_width  > p_src->format.i_width ||
+        i_y + p_fmt->i_height > p_src->format.i_height )
+        return NULL;
+
+    const vlc_chroma_description_t *p_dsc =
+        vlc_fourcc_GetChromaDescription( p_src->format.i_chroma );
+    if( !p_dsc || (int)p_dsc->plane_count != p_src->i_planes )
+        return NULL;
+
+    picture_resource_t rsc = { .pf_destroy = picture_DestroyView };
+    for( int i = 0; i < p_src->i_planes; i++ )
+    {
+        const plane_t *p = &p_src->p[i];
+        const unsigned i_num_w = p_dsc->p[i].w.num, i_den_w = p_dsc->p[i].w.den;
+        const unsigned i_num_h = p_dsc->p[i].h.num, i_den_h = p_dsc->p[i].h.den;
+
+        /* The view must start on a chroma sample */
+        if( (i_x * i_num_w) % i_den_w || (i_y * i_num_h) % i_den_h )
+            return NULL;
+
+        const int i_line = i_y * i_num_h / i_den_h;
+        if( i_line >= p->i_lines )
+            return NULL;
+
+        rsc.p[i].p_pixels = &p->p_pixels[i_line * p->i_pitch +
+                                         i_x * i_num_w / i_den_w * p->i_pixel_pitch];
+        rsc.p[i].i_lines  = p->i_lines - i_line;
+        rsc.p[i].i_pitch  = p->i_pitch;
+    }
+
+    picture_t *p_view = picture_NewFromResource( p_fmt, &rsc );
+    if( !p_view )
+        return NULL;
+
+    picture_priv_t *priv = (picture_priv_t *)p_view;
+    priv->gc.opaque = picture_Hold( p_src );
+    picture_CopyProperties( p_view, p_src );
+    return p_view;
+}
+
 picture_t *picture_NewFromFormat( const video_format_t *p_fmt )
 {
     return picture_NewFromResource( p_fmt, NULL );
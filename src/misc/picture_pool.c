@@ -34,7 +34,28 @@
 #include <vlc_atomic.h>
 #include "picture.h"
 
-static const uintptr_t pool_max = CHAR_BIT * sizeof (unsigned long long);
+/* Pictures are stored in segments, each with its own availability mask, so
+ * that a growable pool never moves the pictures of a segment already in use.
+ * Acquisition and release only use atomic operations on the masks; the mutex
+ * is taken to block in picture_pool_Wait(), to wake up the waiters and to
+ * grow the pool. */
+#define POOL_SEGMENT_SIZE (CHAR_BIT * sizeof (unsigned))
+#define POOL_MAX_SEGMENTS 32
+#define POOL_MAX_PICTURES (POOL_SEGMENT_SIZE * POOL_MAX_SEGMENTS)
+
+struct picture_pool_slot {
+    picture_priv_t  clone; /* preallocated wrapper given out by the pool */
+    picture_t      *picture;
+    picture_pool_t *pool;
+    unsigned        segment;
+    unsigned        mask;
+    struct picture_pool_slot *next; /* refused by the lock callback */
+};
+
+struct picture_pool_segment {
+    atomic_uint              available;
+    struct picture_pool_slot slot[POOL_SEGMENT_SIZE];
+};
 
 struct picture_pool_t {
     int       (*pic_lock)(picture_t *);
@@ -42,84 +63,211 @@ struct picture_pool_t {
     vlc_mutex_t lock;
     vlc_cond_t  wait;
 
-    bool               canceled;
-    unsigned long long available;
-    atomic_ushort      refs;
-    unsigned short     picture_count;
-    picture_t  *picture[];
+    atomic_bool    canceled;
+    atomic_uint    waiters;
+    atomic_uint    refs;
+    atomic_uint    picture_count;
+
+    /* Growable pools only */
+    video_format_t format;
+    unsigned       max_count;
+
+    /* Statistics */
+    atomic_uint    in_use;
+    atomic_uint    peak_in_use;
+    atomic_ulong   acquired;
+    atomic_ulong   failed;
+
+    struct picture_pool_segment *segment[POOL_MAX_SEGMENTS];
 };
 
+static struct picture_pool_slot *picture_pool_GetSlot(picture_pool_t *pool,
+                                                      unsigned index)
+{
+    return &pool->segment[index / POOL_SEGMENT_SIZE]
+                ->slot[index % POOL_SEGMENT_SIZE];
+}
+
 static void picture_pool_Destroy(picture_pool_t *pool)
 {
     if (atomic_fetch_sub(&pool->refs, 1) != 1)
         return;
 
+    for (unsigned i = 0; i < POOL_MAX_SEGMENTS; i++)
+        vlc_free(pool->segment[i]);
+    video_format_Clean(&pool->format);
     vlc_cond_destroy(&pool->wait);
     vlc_mutex_destroy(&pool->lock);
-    vlc_free(pool);
+    free(pool);
 }
 
 void picture_pool_Release(picture_pool_t *pool)
 {
-    for (unsigned i = 0; i < pool->picture_count; i++)
-        picture_Release(pool->picture[i]);
+    unsigned count = atomic_load(&pool->picture_count);
+
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(picture_pool_GetSlot(pool, i)->picture);
     picture_pool_Destroy(pool);
 }
 
+/* Appends a picture to the pool, available if requested. Only called on
+ * creation, or with the pool lock held to grow the pool. */
+static struct picture_pool_slot *picture_pool_Append(picture_pool_t *pool,
+                                                     picture_t *picture,
+                                                     bool available)
+{
+    unsigned index = atomic_load(&pool->picture_count);
+    unsigned segment = index / POOL_SEGMENT_SIZE;
+
+    assert(index < POOL_MAX_PICTURES);
+    if (pool->segment[segment] == NULL) {
+        struct picture_pool_segment *seg = vlc_memalign(64, sizeof (*seg));
+        if (unlikely(seg == NULL))
+            return NULL;
+        atomic_init(&seg->available, 0);
+        pool->segment[segment] = seg;
+    }
+
+    struct picture_pool_slot *slot = picture_pool_GetSlot(pool, index);
+    slot->picture = picture;
+    slot->pool = pool;
+    slot->segment = segment;
+    slot->mask = 1U << (index % POOL_SEGMENT_SIZE);
+    if (available)
+        atomic_fetch_or(&pool->segment[segment]->available, slot->mask);
+    /* Publish the slot to picture_pool_Release() and picture_pool_Enum() */
+    atomic_store(&pool->picture_count, index + 1);
+    return slot;
+}
+
+/* Makes a taken picture available again */
+static void picture_pool_GiveBack(picture_pool_t *pool,
+                                  struct picture_pool_slot *slot)
+{
+    unsigned available = atomic_fetch_or(&pool->segment[slot->segment]->available,
+                                         slot->mask);
+    assert(!(available & slot->mask));
+    (void) available;
+
+    /* Pairs with the increment in picture_pool_Wait(): either the waiter
+     * sees the picture, or it is seen waiting here. */
+    if (atomic_load(&pool->waiters) > 0) {
+        vlc_mutex_lock(&pool->lock);
+        vlc_cond_signal(&pool->wait);
+        vlc_mutex_unlock(&pool->lock);
+    }
+}
+
 static void picture_pool_ReleasePicture(picture_t *clone)
 {
     picture_priv_t *priv = (picture_priv_t *)clone;
-    uintptr_t sys = (uintptr_t)priv->gc.opaque;
-    picture_pool_t *pool = (void *)(sys & ~(pool_max - 1));
-    unsigned offset = sys & (pool_max - 1);
-    picture_t *picture = pool->picture[offset];
-
-    free(clone);
+    struct picture_pool_slot *slot = priv->gc.opaque;
+    picture_pool_t *pool = slot->pool;
+    picture_t *picture = slot->picture;
 
     if (pool->pic_unlock != NULL)
         pool->pic_unlock(picture);
     picture_Release(picture);
 
-    vlc_mutex_lock(&pool->lock);
-    assert(!(pool->available & (1ULL << offset)));
-    pool->available |= 1ULL << offset;
-    vlc_cond_signal(&pool->wait);
-    vlc_mutex_unlock(&pool->lock);
-
+    atomic_fetch_sub(&pool->in_use, 1);
+    picture_pool_GiveBack(pool, slot);
     picture_pool_Destroy(pool);
 }
 
-static picture_t *picture_pool_ClonePicture(picture_pool_t *pool,
-                                            unsigned offset)
+static picture_t *picture_pool_ClonePicture(struct picture_pool_slot *slot)
 {
-    picture_t *picture = pool->picture[offset];
-    uintptr_t sys = ((uintptr_t)pool) + offset;
-    picture_resource_t res = {
-        .p_sys = picture->p_sys,
-        .pf_destroy = picture_pool_ReleasePicture,
-    };
+    picture_priv_t *priv = &slot->clone;
+    picture_t *picture = slot->picture;
+    picture_t *clone = &priv->picture;
+
+    /* Same as picture_NewFromResource() with the picture planes, without
+     * the allocation */
+    memset(clone, 0, sizeof (*clone));
+    clone->format = picture->format;
+    clone->i_planes = picture->i_planes;
+    memcpy(clone->p, picture->p, sizeof (clone->p));
+    clone->i_nb_fields = 2;
+    clone->p_sys = picture->p_sys;
+
+    atomic_init(&priv->gc.refs, 1);
+    priv->gc.destroy = picture_pool_ReleasePicture;
+    priv->gc.opaque = slot;
+    picture_Hold(picture);
+    return clone;
+}
+
+static void picture_pool_Acquired(picture_pool_t *pool)
+{
+    unsigned in_use = atomic_fetch_add(&pool->in_use, 1) + 1;
+    unsigned peak = atomic_load(&pool->peak_in_use);
+
+    while (in_use > peak
+        && !atomic_compare_exchange_weak(&pool->peak_in_use, &peak, in_use));
+    atomic_fetch_add(&pool->acquired, 1);
+    atomic_fetch_add(&pool->refs, 1);
+}
+
+/* Takes any available picture, without blocking */
+static struct picture_pool_slot *picture_pool_Take(picture_pool_t *pool)
+{
+    unsigned segments = (atomic_load(&pool->picture_count)
+                         + POOL_SEGMENT_SIZE - 1) / POOL_SEGMENT_SIZE;
+
+    for (unsigned i = 0; i < segments; i++) {
+        struct picture_pool_segment *seg = pool->segment[i];
+        unsigned available = atomic_load(&seg->available);
+
+        while (available != 0) {
+            unsigned bit = ctz(available);
 
-    for (int i = 0; i < picture->i_planes; i++) {
-        res.p[i].p_pixels = picture->p[i].p_pixels;
-        res.p[i].i_lines = picture->p[i].i_lines;
-        res.p[i].i_pitch = picture->p[i].i_pitch;
+            if (atomic_compare_exchange_weak(&seg->available, &available,
+                                             available & ~(1U << bit)))
+                return &seg->slot[bit];
+        }
     }
+    return NULL;
+}
 
-    picture_t *clone = picture_NewFromResource(&picture->format, &res);
-    if (likely(clone != NULL)) {
-        ((picture_priv_t *)clone)->gc.opaque = (void *)sys;
-        picture_Hold(picture);
+/* Adds a new picture to a growable pool, returned as taken */
+static struct picture_pool_slot *picture_pool_Grow(picture_pool_t *pool)
+{
+    struct picture_pool_slot *slot = NULL;
+
+    vlc_mutex_lock(&pool->lock);
+    if (atomic_load(&pool->picture_count) < pool->max_count) {
+        picture_t *picture = picture_NewFromFormat(&pool->format);
+
+        if (likely(picture != NULL)) {
+            slot = picture_pool_Append(pool, picture, false);
+            if (unlikely(slot == NULL))
+                picture_Release(picture);
+        }
     }
+    vlc_mutex_unlock(&pool->lock);
+    return slot;
+}
+
+/* Locks and wraps a taken picture */
+static picture_t *picture_pool_Lock(picture_pool_t *pool,
+                                    struct picture_pool_slot *slot)
+{
+    picture_t *picture = slot->picture;
+
+    if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS)
+        return NULL;
+
+    picture_pool_Acquired(pool);
+    picture_t *clone = picture_pool_ClonePicture(slot);
+    assert(clone->p_next == NULL);
     return clone;
 }
 
 picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg)
 {
-    if (unlikely(cfg->picture_count > pool_max))
+    if (unlikely(cfg->picture_count > POOL_MAX_PICTURES))
         return NULL;
 
-    picture_pool_t *pool = vlc_memalign(pool_max,
-        sizeof (*pool) + cfg->picture_count * sizeof (picture_t *));
+    picture_pool_t *pool = calloc(1, sizeof (*pool));
     if (unlikely(pool == NULL))
         return NULL;
 
@@ -127,15 +275,23 @@ picture_pool_t *picture_pool_NewExtended(const picture_pool_configuration_t *cfg
     pool->pic_unlock = cfg->unlock;
     vlc_mutex_init(&pool->lock);
     vlc_cond_init(&pool->wait);
-    if (cfg->picture_count == pool_max)
-        pool->available = ~0ULL;
-    else
-        pool->available = (1ULL << cfg->picture_count) - 1;
-    atomic_init(&pool->refs,  1);
-    pool->picture_count = cfg->picture_count;
-    memcpy(pool->picture, cfg->picture,
-           cfg->picture_count * sizeof (picture_t *));
-    pool->canceled = false;
+    atomic_init(&pool->canceled, false);
+    atomic_init(&pool->waiters, 0);
+    atomic_init(&pool->refs, 1);
+    atomic_init(&pool->picture_count, 0);
+    atomic_init(&pool->in_use, 0);
+    atomic_init(&pool->peak_in_use, 0);
+    atomic_init(&pool->acquired, 0);
+    atomic_init(&pool->failed, 0);
+    pool->max_count = cfg->picture_count;
+
+    for (unsigned i = 0; i < cfg->picture_count; i++)
+        if (unlikely(picture_pool_Append(pool, cfg->picture[i], true) == NULL)) {
+            /* The pictures belong to the caller on error */
+            atomic_store(&pool->picture_count, 0);
+            picture_pool_Destroy(pool);
+            return NULL;
+        }
     return pool;
 }
 
@@ -173,6 +329,23 @@ error:
     return NULL;
 }
 
+picture_pool_t *picture_pool_NewGrowable(const video_format_t *fmt,
+                                         unsigned count, unsigned max)
+{
+    if (max > POOL_MAX_PICTURES)
+        max = POOL_MAX_PICTURES;
+    if (unlikely(count > max))
+        return NULL;
+
+    picture_pool_t *pool = picture_pool_NewFromFormat(fmt, count);
+    if (pool == NULL)
+        return NULL;
+
+    video_format_Copy(&pool->format, fmt);
+    pool->max_count = max;
+    return pool;
+}
+
 picture_pool_t *picture_pool_Reserve(picture_pool_t *master, unsigned count)
 {
     picture_t *picture[count ? count : 1];
@@ -196,96 +369,75 @@ error:
     return NULL;
 }
 
-/** Find next (bit) set */
-static int fnsll(unsigned long long x, unsigned i)
-{
-    if (i >= CHAR_BIT * sizeof (x))
-        return 0;
-    return ffsll(x & ~((1ULL << i) - 1));
-}
-
 picture_t *picture_pool_Get(picture_pool_t *pool)
 {
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-
-    if (pool->canceled)
-    {
-        vlc_mutex_unlock(&pool->lock);
-        return NULL;
-    }
+    struct picture_pool_slot *slot, *refused = NULL;
+    picture_t *clone = NULL;
 
-    for (unsigned i = ffsll(pool->available); i; i = fnsll(pool->available, i))
-    {
-        pool->available &= ~(1ULL << (i - 1));
-        vlc_mutex_unlock(&pool->lock);
+    assert(atomic_load(&pool->refs) > 0);
 
-        picture_t *picture = pool->picture[i - 1];
+    if (atomic_load(&pool->canceled))
+        return NULL;
 
-        if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
-            vlc_mutex_lock(&pool->lock);
-            pool->available |= 1ULL << (i - 1);
-            continue;
-        }
+    while ((slot = picture_pool_Take(pool)) != NULL
+        || (pool->max_count > atomic_load(&pool->picture_count)
+         && (slot = picture_pool_Grow(pool)) != NULL)) {
+        clone = picture_pool_Lock(pool, slot);
+        if (clone != NULL)
+            break;
+        /* Keep it until another picture is found */
+        slot->next = refused;
+        refused = slot;
+    }
 
-        picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-        if (clone != NULL) {
-            assert(clone->p_next == NULL);
-            atomic_fetch_add(&pool->refs, 1);
-        }
-        return clone;
+    while (refused != NULL) {
+        slot = refused;
+        refused = slot->next;
+        picture_pool_GiveBack(pool, slot);
     }
 
-    vlc_mutex_unlock(&pool->lock);
-    return NULL;
+    if (clone == NULL)
+        atomic_fetch_add(&pool->failed, 1);
+    return clone;
 }
 
 picture_t *picture_pool_Wait(picture_pool_t *pool)
 {
-    unsigned i;
-
-    vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
-
-    while (pool->available == 0)
-    {
-        if (pool->canceled)
-        {
-            vlc_mutex_unlock(&pool->lock);
-            return NULL;
-        }
-        vlc_cond_wait(&pool->wait, &pool->lock);
-    }
+    struct picture_pool_slot *slot;
 
-    i = ffsll(pool->available);
-    assert(i > 0);
-    pool->available &= ~(1ULL << (i - 1));
-    vlc_mutex_unlock(&pool->lock);
+    assert(atomic_load(&pool->refs) > 0);
 
-    picture_t *picture = pool->picture[i - 1];
+    slot = picture_pool_Take(pool);
+    if (slot == NULL && pool->max_count > atomic_load(&pool->picture_count))
+        slot = picture_pool_Grow(pool);
 
-    if (pool->pic_lock != NULL && pool->pic_lock(picture) != VLC_SUCCESS) {
+    if (slot == NULL) {
         vlc_mutex_lock(&pool->lock);
-        pool->available |= 1ULL << (i - 1);
-        vlc_cond_signal(&pool->wait);
+        atomic_fetch_add(&pool->waiters, 1);
+        while ((slot = picture_pool_Take(pool)) == NULL) {
+            if (atomic_load(&pool->canceled)) {
+                atomic_fetch_sub(&pool->waiters, 1);
+                vlc_mutex_unlock(&pool->lock);
+                return NULL;
+            }
+            vlc_cond_wait(&pool->wait, &pool->lock);
+        }
+        atomic_fetch_sub(&pool->waiters, 1);
         vlc_mutex_unlock(&pool->lock);
-        return NULL;
     }
 
-    picture_t *clone = picture_pool_ClonePicture(pool, i - 1);
-    if (clone != NULL) {
-        assert(clone->p_next == NULL);
-        atomic_fetch_add(&pool->refs, 1);
-    }
+    picture_t *clone = picture_pool_Lock(pool, slot);
+    if (clone == NULL)
+        picture_pool_GiveBack(pool, slot);
     return clone;
 }
 
 void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 {
     vlc_mutex_lock(&pool->lock);
-    assert(pool->refs > 0);
+    assert(atomic_load(&pool->refs) > 0);
 
-    pool->canceled = canceled;
+    atomic_store(&pool->canceled, canceled);
     if (canceled)
         vlc_cond_broadcast(&pool->wait);
     vlc_mutex_unlock(&pool->lock);
@@ -293,14 +445,30 @@ void picture_pool_Cancel(picture_pool_t *pool, bool canceled)
 
 unsigned picture_pool_GetSize(const picture_pool_t *pool)
 {
-    return pool->picture_count;
+    return atomic_load(&((picture_pool_t *)pool)->picture_count);
+}
+
+void picture_pool_GetStats(const picture_pool_t *pool,
+                           picture_pool_stats_t *stats)
+{
+    picture_pool_t *p = (picture_pool_t *)pool;
+
+    stats->size = atomic_load(&p->picture_count);
+    stats->max_size = __MAX(p->max_count, stats->size);
+    stats->in_use = atomic_load(&p->in_use);
+    stats->peak_in_use = atomic_load(&p->peak_in_use);
+    stats->acquired = atomic_load(&p->acquired);
+    stats->failed = atomic_load(&p->failed);
 }
 
 void picture_pool_Enum(picture_pool_t *pool, void (*cb)(void *, picture_t *),
                        void *opaque)
 {
-    /* NOTE: So far, the pictures table cannot change after the pool is created
-     * so there is no need to lock the pool mutex here. */
-    for (unsigned i = 0; i < pool->picture_count; i++)
-        cb(opaque, pool->picture[i]);
+    /* NOTE: Pictures are only ever appended to a pool, and their slots never
+     * move, so there is no need to lock the pool mutex here. Pictures added
+     * by a growable pool during the enumeration may be skipped. */
+    unsigned count = atomic_load(&pool->picture_count);
+
+    for (unsigned i = 0; i < count; i++)
+        cb(opaque, picture_pool_GetSlot(pool, i)->picture);
 }
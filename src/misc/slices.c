@@ -0,0 +1,227 @@
+/*****************************************************************************
+ * slices.c : shared worker pool for slice-threaded processing
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include <assert.h>
+
+#include <vlc_common.h>
+#include "../libvlc.h"
+
+#define SLICES_MAX_THREADS 32
+
+typedef struct vlc_slices_job
+{
+    struct vlc_slices_job *p_next;
+
+    void (*pf_run)( void *, unsigned, unsigned );
+    void *opaque;
+
+    unsigned i_count;   /* number of slices */
+    unsigned i_next;    /* next slice to hand out */
+    unsigned i_pending; /* slices not done yet */
+} vlc_slices_job_t;
+
+struct vlc_slices
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait_work;
+    vlc_cond_t  wait_done;
+
+    /* Jobs with slices left to hand out, oldest first */
+    vlc_slices_job_t *p_first;
+    vlc_slices_job_t **pp_last;
+    bool b_quit;
+
+    unsigned i_threads;
+    vlc_thread_t threads[];
+};
+
+static vlc_mutex_t slices_lock = VLC_STATIC_MUTEX;
+
+/* Takes the next slice of the oldest job, lock must be held */
+static vlc_slices_job_t *TakeSlice( vlc_slices_t *p_slices, unsigned *pi_slice )
+{
+    vlc_slices_job_t *p_job = p_slices->p_first;
+
+    assert( p_job != NULL && p_job->i_next < p_job->i_count );
+    *pi_slice = p_job->i_next++;
+    if( p_job->i_next == p_job->i_count )
+    {
+        p_slices->p_first = p_job->p_next;
+        if( p_slices->p_first == NULL )
+            p_slices->pp_last = &p_slices->p_first;
+    }
+    return p_job;
+}
+
+/* Runs a slice, lock must be held, and is released meanwhile */
+static void RunSlice( vlc_slices_t *p_slices, vlc_slices_job_t *p_job,
+                      unsigned i_slice )
+{
+    vlc_mutex_unlock( &p_slices->lock );
+    p_job->pf_run( p_job->opaque, i_slice, p_job->i_count );
+    vlc_mutex_lock( &p_slices->lock );
+
+    assert( p_job->i_pending > 0 );
+    if( --p_job->i_pending == 0 )
+        vlc_cond_broadcast( &p_slices->wait_done );
+}
+
+static void *Thread( void *data )
+{
+    vlc_slices_t *p_slices = data;
+
+    vlc_savecancel();
+    vlc_mutex_lock( &p_slices->lock );
+    for( ;; )
+    {
+        while( !p_slices->b_quit && p_slices->p_first == NULL )
+            vlc_cond_wait( &p_slices->wait_work, &p_slices->lock );
+        if( p_slices->b_quit )
+            break;
+
+        unsigned i_slice;
+        vlc_slices_job_t *p_job = TakeSlice( p_slices, &i_slice );
+        RunSlice( p_slices, p_job, i_slice );
+    }
+    vlc_mutex_unlock( &p_slices->lock );
+    return NULL;
+}
+
+static vlc_slices_t *Create( libvlc_int_t *p_libvlc )
+{
+    int i_threads = var_InheritInteger( p_libvlc, "video-filter-threads" );
+    if( i_threads <= 0 )
+        i_threads = vlc_GetCPUCount();
+    /* The calling thread takes its share of the slices */
+    i_threads = __MIN( i_threads - 1, SLICES_MAX_THREADS );
+    i_threads = __MAX( i_threads, 0 );
+
+    vlc_slices_t *p_slices = malloc( sizeof( *p_slices )
+                                     + i_threads * sizeof( vlc_thread_t ) );
+    if( unlikely(p_slices == NULL) )
+        return NULL;
+
+    vlc_mutex_init( &p_slices->lock );
+    vlc_cond_init( &p_slices->wait_work );
+    vlc_cond_init( &p_slices->wait_done );
+    p_slices->p_first = NULL;
+    p_slices->pp_last = &p_slices->p_first;
+    p_slices->b_quit = false;
+    p_slices->i_threads = 0;
+
+    for( int i = 0; i < i_threads; i++ )
+    {
+        if( vlc_clone( &p_slices->threads[i], Thread, p_slices,
+                       VLC_THREAD_PRIORITY_VIDEO ) )
+            break;
+        p_slices->i_threads++;
+    }
+
+    msg_Dbg( p_libvlc, "slice worker pool started with %u threads",
+             p_slices->i_threads );
+    return p_slices;
+}
+
+void vlc_slices_Destroy( vlc_slices_t *p_slices )
+{
+    if( p_slices == NULL )
+        return;
+
+    vlc_mutex_lock( &p_slices->lock );
+    assert( p_slices->p_first == NULL );
+    p_slices->b_quit = true;
+    vlc_cond_broadcast( &p_slices->wait_work );
+    vlc_mutex_unlock( &p_slices->lock );
+
+    for( unsigned i = 0; i < p_slices->i_threads; i++ )
+        vlc_join( p_slices->threads[i], NULL );
+
+    vlc_cond_destroy( &p_slices->wait_done );
+    vlc_cond_destroy( &p_slices->wait_work );
+    vlc_mutex_destroy( &p_slices->lock );
+    free( p_slices );
+}
+
+static vlc_slices_t *Get( libvlc_int_t *p_libvlc )
+{
+    libvlc_priv_t *priv = libvlc_priv( p_libvlc );
+
+    vlc_mutex_lock( &slices_lock );
+    if( priv->slices == NULL )
+        priv->slices = Create( p_libvlc );
+    vlc_slices_t *p_slices = priv->slices;
+    vlc_mutex_unlock( &slices_lock );
+
+    return p_slices;
+}
+
+unsigned vlc_slices_GetThreads( libvlc_int_t *p_libvlc )
+{
+    vlc_slices_t *p_slices = Get( p_libvlc );
+
+    return 1 + ( p_slices != NULL ? p_slices->i_threads : 0 );
+}
+
+void vlc_slices_Run( libvlc_int_t *p_libvlc, unsigned i_count,
+                     void (*pf_run)( void *, unsigned, unsigned ),
+                     void *opaque )
+{
+    vlc_slices_t *p_slices = i_count > 1 ? Get( p_libvlc ) : NULL;
+
+    if( p_slices == NULL || p_slices->i_threads == 0 )
+    {
+        for( unsigned i = 0; i < i_count; i++ )
+            pf_run( opaque, i, i_count );
+        return;
+    }
+
+    vlc_slices_job_t job = {
+        .p_next = NULL,
+        .pf_run = pf_run,
+        .opaque = opaque,
+        .i_count = i_count,
+        .i_next = 0,
+        .i_pending = i_count,
+    };
+
+    int canc = vlc_savecancel();
+    vlc_mutex_lock( &p_slices->lock );
+    *p_slices->pp_last = &job;
+    p_slices->pp_last = &job.p_next;
+    vlc_cond_broadcast( &p_slices->wait_work );
+
+    /* Work rather than sleep until all our slices are handed out. Slices
+     * are handed out oldest job first, so this may help other callers */
+    while( job.i_next < job.i_count )
+    {
+        unsigned i_slice;
+        vlc_slices_job_t *p_job = TakeSlice( p_slices, &i_slice );
+        RunSlice( p_slices, p_job, i_slice );
+    }
+
+    while( job.i_pending > 0 )
+        vlc_cond_wait( &p_slices->wait_done, &p_slices->lock );
+    vlc_mutex_unlock( &p_slices->lock );
+    vlc_restorecancel( canc );
+}
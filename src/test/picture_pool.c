@@ -106,6 +106,110 @@ static void test(bool zombie)
             picture_Release(pics[i]);
 }
 
+static void test_large(void)
+{
+    const unsigned count = 200;
+    picture_t *pics[count];
+
+    pool = picture_pool_NewFromFormat(&fmt, count);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == count);
+
+    for (unsigned i = 0; i < count; i++) {
+        pics[i] = picture_pool_Get(pool);
+        assert(pics[i] != NULL);
+        for (unsigned j = 0; j < i; j++)
+            assert(pics[j]->p[0].p_pixels != pics[i]->p[0].p_pixels);
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    picture_pool_stats_t stats;
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.size == count && stats.max_size == count);
+    assert(stats.in_use == count && stats.peak_in_use == count);
+    assert(stats.acquired == count && stats.failed == 1);
+
+    for (unsigned i = 0; i < count; i++)
+        picture_Release(pics[i]);
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.in_use == 0 && stats.peak_in_use == count);
+    picture_pool_Release(pool);
+}
+
+static void test_growable(void)
+{
+    picture_t *pics[PICTURES];
+
+    pool = picture_pool_NewGrowable(&fmt, 2, PICTURES);
+    assert(pool != NULL);
+    assert(picture_pool_GetSize(pool) == 2);
+
+    for (unsigned i = 0; i < PICTURES; i++) {
+        pics[i] = (i & 1) ? picture_pool_Get(pool) : picture_pool_Wait(pool);
+        assert(pics[i] != NULL);
+        assert(picture_pool_GetSize(pool) == __MAX(2, i + 1));
+    }
+    assert(picture_pool_Get(pool) == NULL);
+
+    /* Released pictures are reused before growing any further */
+    picture_Release(pics[0]);
+    pics[0] = picture_pool_Get(pool);
+    assert(pics[0] != NULL);
+    assert(picture_pool_GetSize(pool) == PICTURES);
+
+    reserve = picture_pool_Reserve(pool, 1);
+    assert(reserve == NULL);
+
+    for (unsigned i = 0; i < PICTURES; i++)
+        picture_Release(pics[i]);
+    picture_pool_Release(pool);
+}
+
+#define THREADS 4
+#define ITERATIONS 10000
+
+static void *test_thread(void *data)
+{
+    picture_pool_t *p = data;
+
+    for (unsigned i = 0; i < ITERATIONS; i++) {
+        picture_t *a = picture_pool_Wait(p);
+        picture_t *b = picture_pool_Get(p);
+
+        assert(a != NULL);
+        a->date = i;
+        if (b != NULL) {
+            assert(b->p[0].p_pixels != a->p[0].p_pixels);
+            picture_Release(b);
+        }
+        assert(a->date == (mtime_t)i);
+        picture_Release(a);
+    }
+    return NULL;
+}
+
+static void test_threads(void)
+{
+    vlc_thread_t threads[THREADS];
+
+    /* Fewer pictures than twice the threads, so that they compete */
+    pool = picture_pool_NewFromFormat(&fmt, THREADS + 1);
+    assert(pool != NULL);
+
+    for (unsigned i = 0; i < THREADS; i++)
+        assert(vlc_clone(&threads[i], test_thread, pool,
+                         VLC_THREAD_PRIORITY_LOW) == 0);
+    for (unsigned i = 0; i < THREADS; i++)
+        vlc_join(threads[i], NULL);
+
+    picture_pool_stats_t stats;
+    picture_pool_GetStats(pool, &stats);
+    assert(stats.in_use == 0);
+    assert(stats.peak_in_use <= THREADS + 1);
+    assert(stats.acquired + stats.failed == 2 * THREADS * ITERATIONS);
+    picture_pool_Release(pool);
+}
+
 int main(void)
 {
     video_format_Setup(&fmt, VLC_CODEC_I420, 320, 200, 320, 200, 1, 1);
@@ -122,6 +226,9 @@ int main(void)
 
     test(false);
     test(true);
+    test_large();
+    test_growable();
+    test_threads();
 
     return 0;
 }
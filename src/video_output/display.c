@@ -1495,6 +1495,8 @@ static int SplitterPictureNew(video_splitter_t *splitter, picture_t *picture[])
     vout_display_sys_t *wsys = splitter->p_owner->wrapper->sys;
 
     for (int i = 0; i < wsys->count; i++) {
+        if (picture[i])
+            continue; /* view of the source picture */
         if (vout_IsDisplayFiltered(wsys->display[i])) {
             /* TODO use a pool ? */
             picture[i] = picture_NewFromFormat(&wsys->display[i]->source);
@@ -1503,13 +1505,22 @@ static int SplitterPictureNew(video_splitter_t *splitter, picture_t *picture[])
             picture[i] = pool ? picture_pool_Get(pool) : NULL;
         }
         if (!picture[i]) {
-            for (int j = 0; j < i; j++)
-                picture_Release(picture[j]);
+            for (int j = 0; j < wsys->count; j++)
+                if (picture[j])
+                    picture_Release(picture[j]);
             return VLC_EGENERIC;
         }
     }
     return VLC_SUCCESS;
 }
+static bool SplitterPictureView(video_splitter_t *splitter, int index)
+{
+    vout_display_sys_t *wsys = splitter->p_owner->wrapper->sys;
+    vout_display_t *vd = wsys->display[index];
+
+    /* The converters read the view, or the display can show it directly */
+    return vout_IsDisplayFiltered(vd) || vd->info.accepts_views;
+}
 static void SplitterPictureDel(video_splitter_t *splitter, picture_t *picture[])
 {
     vout_display_sys_t *wsys = splitter->p_owner->wrapper->sys;
@@ -1581,6 +1592,7 @@ vout_display_t *vout_NewSplitter(vout_thread_t *vout,
     splitter->p_owner = vso;
     splitter->pf_picture_new = SplitterPictureNew;
     splitter->pf_picture_del = SplitterPictureDel;
+    splitter->pf_picture_view = SplitterPictureView;
 
     /* */
     TAB_INIT(sys->count, sys->display);
@@ -57,6 +57,8 @@
  * Local prototypes
  *****************************************************************************/
 static void *Thread(void *);
+static void FilterStageWake(vout_thread_t *);
+static void FilterStaticLock(vout_thread_t *);
 static void VoutDestructor(vlc_object_t *);
 
 /* Maximum delay between 2 displayed pictures.
@@ -142,8 +144,15 @@ static vout_thread_t *VoutCreate(vlc_object_t *object,
 
     /* Initialize locks */
     vlc_mutex_init(&vout->p->filter.lock);
+    vlc_mutex_init(&vout->p->filter.static_lock);
+    vlc_mutex_init(&vout->p->filter.stage.lock);
+    vlc_cond_init(&vout->p->filter.stage.wait);
+    vlc_cond_init(&vout->p->filter.stage.idle);
     vlc_mutex_init(&vout->p->spu_lock);
 
+    vout->p->filter.stage.enabled = var_InheritBool(vout, "video-filter-pipeline");
+    vout->p->filter.stage.running = false;
+
     /* Take care of some "interface/control" related initialisations */
     vout_IntfInit(vout);
 
@@ -290,6 +299,10 @@ static void VoutDestructor(vlc_object_t *object)
 
     /* Destroy the locks */
     vlc_mutex_destroy(&vout->p->spu_lock);
+    vlc_cond_destroy(&vout->p->filter.stage.idle);
+    vlc_cond_destroy(&vout->p->filter.stage.wait);
+    vlc_mutex_destroy(&vout->p->filter.stage.lock);
+    vlc_mutex_destroy(&vout->p->filter.static_lock);
     vlc_mutex_destroy(&vout->p->filter.lock);
     vout_control_Clean(&vout->p->control);
 
@@ -425,6 +438,7 @@ void vout_PutPicture(vout_thread_t *vout, picture_t *picture)
     picture->p_next = NULL;
     picture_fifo_Push(vout->p->decoder_fifo, picture);
 
+    FilterStageWake(vout);
     vout_control_Wake(&vout->p->control);
 }
 
@@ -665,7 +679,8 @@ static picture_t *VoutVideoFilterStaticNewPicture(filter_t *filter)
 {
     vout_thread_t *vout = filter->owner.sys;
 
-    vlc_assert_locked(&vout->p->filter.lock);
+    /* Called with static_lock held, or by the busy filter stage: either way,
+     * the filters cannot be changed meanwhile */
     if (filter_chain_GetLength(vout->p->filter.chain_interactive) == 0)
         return VoutVideoFilterInteractiveNewPicture(filter);
 
@@ -682,12 +697,16 @@ static void ThreadFilterFlush(vout_thread_t *vout, bool is_locked)
         picture_Release( vout->p->displayed.next );
     vout->p->displayed.next = NULL;
 
-    if (!is_locked)
+    if (!is_locked) {
+        FilterStaticLock(vout);
         vlc_mutex_lock(&vout->p->filter.lock);
+    }
     filter_chain_VideoFlush(vout->p->filter.chain_static);
     filter_chain_VideoFlush(vout->p->filter.chain_interactive);
-    if (!is_locked)
+    if (!is_locked) {
         vlc_mutex_unlock(&vout->p->filter.lock);
+        vlc_mutex_unlock(&vout->p->filter.static_lock);
+    }
 }
 
 typedef struct {
@@ -732,8 +751,10 @@ static void ThreadChangeFilters(vout_thread_t *vout,
         current = next;
     }
 
-    if (!is_locked)
+    if (!is_locked) {
+        FilterStaticLock(vout);
         vlc_mutex_lock(&vout->p->filter.lock);
+    }
 
     es_format_t fmt_target;
     es_format_InitFromVideo(&fmt_target, source ? source : &vout->p->filter.format);
@@ -782,20 +803,304 @@ static void ThreadChangeFilters(vout_thread_t *vout,
         video_format_Copy(&vout->p->filter.format, source);
     }
 
-    if (!is_locked)
+    if (!is_locked) {
         vlc_mutex_unlock(&vout->p->filter.lock);
+        vlc_mutex_unlock(&vout->p->filter.static_lock);
+    }
 }
 
+/*****************************************************************************
+ * Filter stage: runs chain_static on its own thread, ahead of the display
+ *****************************************************************************/
+/* Takes static_lock once the stage does not use chain_static */
+static void FilterStaticLock(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_mutex_lock(&sys->filter.static_lock);
+    while (sys->filter.stage.busy)
+        vlc_cond_wait(&sys->filter.stage.idle, &sys->filter.static_lock);
+}
+
+static void FilterStageWake(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter.stage.enabled)
+        return;
+
+    vlc_mutex_lock(&sys->filter.stage.lock);
+    sys->filter.stage.pending = true;
+    vlc_cond_signal(&sys->filter.stage.wait);
+    vlc_mutex_unlock(&sys->filter.stage.lock);
+}
+
+static void FilterStagePause(vout_thread_t *vout, bool is_paused)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter.stage.enabled)
+        return;
+
+    vlc_mutex_lock(&sys->filter.stage.lock);
+    sys->filter.stage.paused  = is_paused;
+    sys->filter.stage.pending = true;
+    vlc_cond_signal(&sys->filter.stage.wait);
+    vlc_mutex_unlock(&sys->filter.stage.lock);
+}
+
+static void FilterStagePush(vout_thread_t *vout, picture_t *decoded,
+                            picture_t *filtered)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_assert_locked(&sys->filter.static_lock);
+    assert(sys->filter.stage.count < VOUT_FILTER_QUEUE);
+    sys->filter.stage.queue[sys->filter.stage.count].decoded  = decoded;
+    sys->filter.stage.queue[sys->filter.stage.count].filtered = filtered;
+    sys->filter.stage.count++;
+}
+
+static picture_t *FilterStagePop(vout_thread_t *vout, picture_t **decoded)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_assert_locked(&sys->filter.static_lock);
+    if (sys->filter.stage.count == 0)
+        return NULL;
+
+    picture_t *filtered = sys->filter.stage.queue[0].filtered;
+    *decoded = sys->filter.stage.queue[0].decoded;
+    sys->filter.stage.count--;
+    memmove(&sys->filter.stage.queue[0], &sys->filter.stage.queue[1],
+            sys->filter.stage.count * sizeof(sys->filter.stage.queue[0]));
+    return filtered;
+}
+
+static void FilterStageFlush(vout_thread_t *vout, mtime_t date, bool below)
+{
+    vout_thread_sys_t *sys = vout->p;
+    unsigned kept = 0;
+
+    vlc_assert_locked(&sys->filter.static_lock);
+    for (unsigned i = 0; i < sys->filter.stage.count; i++) {
+        picture_t *filtered = sys->filter.stage.queue[i].filtered;
+        picture_t *decoded  = sys->filter.stage.queue[i].decoded;
+
+        if (( below && filtered->date <= date) ||
+            (!below && filtered->date >= date)) {
+            picture_Release(filtered);
+            if (decoded)
+                picture_Release(decoded);
+        } else
+            sys->filter.stage.queue[kept++] = sys->filter.stage.queue[i];
+    }
+    sys->filter.stage.count = kept;
+
+    /* The picture being filtered left the decoder FIFO already */
+    if (sys->filter.stage.busy &&
+        (( below && sys->filter.stage.date <= date) ||
+         (!below && sys->filter.stage.date >= date)))
+        sys->filter.stage.drop = true;
+}
+
+static void FilterStageOffsetDate(vout_thread_t *vout, mtime_t duration)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_assert_locked(&sys->filter.static_lock);
+    for (unsigned i = 0; i < sys->filter.stage.count; i++) {
+        picture_t *filtered = sys->filter.stage.queue[i].filtered;
+        picture_t *decoded  = sys->filter.stage.queue[i].decoded;
+
+        filtered->date += duration;
+        if (decoded && decoded != filtered)
+            decoded->date += duration;
+    }
+
+    /* The filters may read the date of the picture being filtered: it gets
+     * offset once filtered */
+    if (sys->filter.stage.busy)
+        sys->filter.stage.offset += duration;
+}
+
+/* Filters one decoded picture without holding static_lock, so that the vout
+ * thread can meanwhile pop the queue, flush it or offset its dates. */
+static picture_t *FilterStageFilter(vout_thread_t *vout, picture_t *decoded)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    sys->filter.stage.busy   = true;
+    sys->filter.stage.drop   = false;
+    sys->filter.stage.offset = 0;
+    sys->filter.stage.date   = decoded->date;
+    vlc_mutex_unlock(&sys->filter.static_lock);
+
+    picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_static,
+                                                   picture_Hold(decoded));
+
+    vlc_mutex_lock(&sys->filter.static_lock);
+    sys->filter.stage.busy = false;
+    vlc_cond_broadcast(&sys->filter.stage.idle);
+
+    if (filtered && sys->filter.stage.drop) {
+        picture_Release(filtered);
+        filtered = NULL;
+    }
+    if (filtered && sys->filter.stage.offset != 0) {
+        filtered->date += sys->filter.stage.offset;
+        if (decoded != filtered)
+            decoded->date += sys->filter.stage.offset;
+    }
+    return filtered;
+}
+
+/* Fills the queue with filtered pictures, static_lock must be held.
+ * Pictures needing a filter change are left to the vout thread. */
+static void FilterStageRun(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    while (sys->filter.stage.count < VOUT_FILTER_QUEUE) {
+        /* Without static filters, there is nothing to do ahead of time */
+        if (filter_chain_GetLength(sys->filter.chain_static) == 0)
+            break;
+
+        picture_t *filtered = filter_chain_VideoFilter(sys->filter.chain_static, NULL);
+        if (filtered) {
+            FilterStagePush(vout, NULL, filtered);
+            continue;
+        }
+
+        picture_t *decoded = picture_fifo_Peek(sys->decoder_fifo);
+        if (!decoded)
+            break;
+        const bool format_changed =
+            !VideoFormatIsCropArEqual(&decoded->format, &sys->filter.format);
+        picture_Release(decoded);
+        if (format_changed)
+            break;
+
+        decoded = picture_fifo_Pop(sys->decoder_fifo);
+        if (!decoded)
+            break;
+        if (atomic_load(&sys->is_late_dropped) && !decoded->b_force) {
+            const mtime_t late = mdate() - decoded->date;
+            if (late > VOUT_DISPLAY_LATE_THRESHOLD) {
+                msg_Warn(vout, "picture is too late to be displayed (missing %"PRId64" ms)", late/1000);
+                picture_Release(decoded);
+                vout_statistic_AddLost(&sys->statistic, 1);
+                continue;
+            }
+        }
+
+        filtered = FilterStageFilter(vout, decoded);
+        if (filtered)
+            FilterStagePush(vout, decoded, filtered);
+        else
+            picture_Release(decoded);
+    }
+}
+
+static void *FilterStageThread(void *object)
+{
+    vout_thread_t *vout = object;
+    vout_thread_sys_t *sys = vout->p;
+
+    vlc_savecancel();
+    for (;;) {
+        vlc_mutex_lock(&sys->filter.stage.lock);
+        while (!sys->filter.stage.quit &&
+               (!sys->filter.stage.pending || sys->filter.stage.paused))
+            vlc_cond_wait(&sys->filter.stage.wait, &sys->filter.stage.lock);
+        const bool quit = sys->filter.stage.quit;
+        sys->filter.stage.pending = false;
+        vlc_mutex_unlock(&sys->filter.stage.lock);
+
+        if (quit)
+            break;
+
+        vlc_mutex_lock(&sys->filter.static_lock);
+        FilterStageRun(vout);
+        vlc_mutex_unlock(&sys->filter.static_lock);
+    }
+    return NULL;
+}
+
+static void FilterStageStart(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    sys->filter.stage.count   = 0;
+    sys->filter.stage.pending = false;
+    sys->filter.stage.paused  = false;
+    sys->filter.stage.quit    = false;
+    sys->filter.stage.busy    = false;
+    sys->filter.stage.running = sys->filter.stage.enabled &&
+        !vlc_clone(&sys->filter.stage.thread, FilterStageThread, vout,
+                   VLC_THREAD_PRIORITY_OUTPUT);
+    if (sys->filter.stage.enabled && !sys->filter.stage.running)
+        msg_Err(vout, "cannot start the video filter stage");
+}
+
+static void FilterStageStop(vout_thread_t *vout)
+{
+    vout_thread_sys_t *sys = vout->p;
+
+    if (!sys->filter.stage.running)
+        return;
+
+    vlc_mutex_lock(&sys->filter.stage.lock);
+    sys->filter.stage.quit = true;
+    vlc_cond_signal(&sys->filter.stage.wait);
+    vlc_mutex_unlock(&sys->filter.stage.lock);
+    vlc_join(sys->filter.stage.thread, NULL);
+    sys->filter.stage.running = false;
+
+    vlc_mutex_lock(&sys->filter.static_lock);
+    FilterStageFlush(vout, INT64_MAX, true);
+    vlc_mutex_unlock(&sys->filter.static_lock);
+}
 
 /* */
 static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool frame_by_frame)
 {
-    bool is_late_dropped = vout->p->is_late_dropped && !vout->p->pause.is_on && !frame_by_frame;
+    bool is_late_dropped = atomic_load(&vout->p->is_late_dropped) &&
+                           !vout->p->pause.is_on && !frame_by_frame;
+
+    /* Only the queue is needed to take a picture filtered ahead of time */
+    vlc_mutex_lock(&vout->p->filter.static_lock);
+
+    picture_t *picture = NULL;
+    if (!reuse || !vout->p->displayed.decoded) {
+        picture_t *decoded = NULL;
+
+        picture = FilterStagePop(vout, &decoded);
+        if (!picture && vout->p->filter.stage.busy) {
+            /* The stage is filtering the next picture: wait for it */
+            while (vout->p->filter.stage.busy)
+                vlc_cond_wait(&vout->p->filter.stage.idle,
+                              &vout->p->filter.static_lock);
+            picture = FilterStagePop(vout, &decoded);
+        }
+        if (decoded) {
+            if (vout->p->displayed.decoded)
+                picture_Release(vout->p->displayed.decoded);
 
+            vout->p->displayed.decoded       = decoded;
+            vout->p->displayed.timestamp     = decoded->date;
+            vout->p->displayed.is_interlaced = !decoded->b_progressive;
+        }
+    }
+    /* Otherwise filter inline, which needs chain_static */
+    while (!picture && vout->p->filter.stage.busy)
+        vlc_cond_wait(&vout->p->filter.stage.idle,
+                      &vout->p->filter.static_lock);
     vlc_mutex_lock(&vout->p->filter.lock);
 
-    picture_t *picture = filter_chain_VideoFilter(vout->p->filter.chain_static, NULL);
-    assert(!reuse || !picture);
+    if (!picture)
+        picture = filter_chain_VideoFilter(vout->p->filter.chain_static, NULL);
+    assert(!reuse || !picture || !vout->p->displayed.decoded);
 
     while (!picture) {
         picture_t *decoded;
@@ -836,6 +1141,11 @@ static int ThreadDisplayPreparePicture(vout_thread_t *vout, bool reuse, bool fra
     }
 
     vlc_mutex_unlock(&vout->p->filter.lock);
+    vlc_mutex_unlock(&vout->p->filter.static_lock);
+
+    /* There is room in the queue, or a picture left for this thread was
+     * processed */
+    FilterStageWake(vout);
 
     if (!picture)
         return VLC_EGENERIC;
@@ -1166,6 +1476,9 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
         if (vout->p->step.last > VLC_TS_INVALID)
             vout->p->step.last += duration;
         picture_fifo_OffsetDate(vout->p->decoder_fifo, duration);
+        vlc_mutex_lock(&vout->p->filter.static_lock);
+        FilterStageOffsetDate(vout, duration);
+        vlc_mutex_unlock(&vout->p->filter.static_lock);
         if (vout->p->displayed.decoded)
             vout->p->displayed.decoded->date += duration;
         spu_OffsetSubtitleDate(vout->p->spu, duration);
@@ -1177,6 +1490,7 @@ static void ThreadChangePause(vout_thread_t *vout, bool is_paused, mtime_t date)
     }
     vout->p->pause.is_on = is_paused;
     vout->p->pause.date  = date;
+    FilterStagePause(vout, is_paused);
 }
 
 static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
@@ -1198,7 +1512,10 @@ static void ThreadFlush(vout_thread_t *vout, bool below, mtime_t date)
         }
     }
 
+    vlc_mutex_lock(&vout->p->filter.static_lock);
+    FilterStageFlush(vout, date, below);
     picture_fifo_Flush(vout->p->decoder_fifo, date, below);
+    vlc_mutex_unlock(&vout->p->filter.static_lock);
 }
 
 static void ThreadStep(vout_thread_t *vout, mtime_t *duration)
@@ -1406,6 +1723,8 @@ static int ThreadStart(vout_thread_t *vout, vout_display_state_t *state)
     vout->p->spu_blend_chroma        = 0;
     vout->p->spu_blend               = NULL;
 
+    FilterStageStart(vout);
+
     video_format_Print(VLC_OBJECT(vout), "original format", &vout->p->original);
     return VLC_SUCCESS;
 error:
@@ -1421,6 +1740,8 @@ error:
 
 static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 {
+    FilterStageStop(vout);
+
     if (vout->p->spu_blend)
         filter_DeleteBlend(vout->p->spu_blend);
 
@@ -1447,7 +1768,8 @@ static void ThreadStop(vout_thread_t *vout, vout_display_state_t *state)
 static void ThreadInit(vout_thread_t *vout)
 {
     vout->p->dead            = false;
-    vout->p->is_late_dropped = var_InheritBool(vout, "drop-late-frames");
+    atomic_init(&vout->p->is_late_dropped,
+                var_InheritBool(vout, "drop-late-frames"));
     vout->p->pause.is_on     = false;
     vout->p->pause.date      = VLC_TS_INVALID;
 
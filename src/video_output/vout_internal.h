@@ -25,6 +25,7 @@
 #ifndef LIBVLC_VOUT_INTERNAL_H
 #define LIBVLC_VOUT_INTERNAL_H 1
 
+#include <vlc_atomic.h>
 #include <vlc_picture_fifo.h>
 #include <vlc_picture_pool.h>
 #include <vlc_vout_display.h>
@@ -43,6 +44,11 @@
  */
 #define VOUT_MAX_PICTURES (20)
 
+/**
+ * Number of pictures the filter stage may process ahead of the display.
+ */
+#define VOUT_FILTER_QUEUE (2)
+
 /* */
 struct vout_thread_sys_t
 {
@@ -110,15 +116,44 @@ struct vout_thread_sys_t
     } title;
 
     /* */
-    bool            is_late_dropped;
+    atomic_bool     is_late_dropped;
 
-    /* Video filter2 chain */
+    /* Video filter2 chain
+     * static_lock protects chain_static and the stage queue, lock protects
+     * chain_interactive. Both are needed to change the filters, static_lock
+     * first. While the stage is busy, it owns chain_static without holding
+     * static_lock: other users of chain_static must wait for it to be idle. */
     struct {
         vlc_mutex_t     lock;
+        vlc_mutex_t     static_lock;
         char            *configuration;
         video_format_t  format;
         struct filter_chain_t *chain_static;
         struct filter_chain_t *chain_interactive;
+
+        /* Optional thread running chain_static ahead of the display */
+        struct {
+            bool         enabled;
+            bool         running;
+            vlc_thread_t thread;
+            vlc_mutex_t  lock;
+            vlc_cond_t   wait;
+            bool         pending;
+            bool         paused;
+            bool         quit;
+
+            /* Protected by static_lock */
+            vlc_cond_t   idle;
+            bool         busy;     /* filtering outside of static_lock */
+            bool         drop;     /* the picture being filtered was flushed */
+            mtime_t      offset;   /* pause time while busy */
+            mtime_t      date;     /* date of the picture being filtered */
+            unsigned     count;
+            struct {
+                picture_t *decoded;  /* source picture, or NULL */
+                picture_t *filtered;
+            } queue[VOUT_FILTER_QUEUE];
+        } stage;
     } filter;
 
     /* */
@@ -61,6 +61,38 @@ typedef struct {
     spu_heap_entry_t entry[VOUT_MAX_SUBPICTURES];
 } spu_heap_t;
 
+/* Number of rendered text regions kept across frames */
+#define SPU_TEXT_CACHE_SIZE 16
+#define SPU_TEXT_CACHE_MAX_CHROMAS 8
+
+/* Everything the text renderer output depends on */
+typedef struct {
+    const text_segment_t *text;
+    video_format_t fmt;
+    int  align;
+    bool noregionbg;
+    bool gridmode;
+    unsigned render_width;
+    unsigned render_height;
+    int  text_scale;
+    vlc_fourcc_t chroma[SPU_TEXT_CACHE_MAX_CHROMAS];
+} spu_text_key_t;
+
+typedef struct {
+    spu_text_key_t key;
+    text_segment_t *text;      /**< owned copy of key.text, NULL if unused */
+    video_format_t fmt;        /**< rendered region format */
+    picture_t      *picture;   /**< rendered region picture */
+    uint64_t       last_use;
+} spu_text_cache_entry_t;
+
+typedef struct {
+    uint64_t use_count;
+    unsigned hits;
+    unsigned misses;
+    spu_text_cache_entry_t entry[SPU_TEXT_CACHE_SIZE];
+} spu_text_cache_t;
+
 struct spu_private_t {
     vlc_mutex_t  lock;            /* lock to protect all followings fields */
     vlc_object_t *input;
@@ -69,6 +101,7 @@ struct spu_private_t {
 
     int channel;             /**< number of subpicture channels registered */
     filter_t *text;                              /**< text renderer module */
+    spu_text_cache_t text_cache;          /**< rendered text regions cache */
     filter_t *scale_yuvp;                     /**< scaling module for YUVP */
     filter_t *scale;                    /**< scaling module (all but YUVP) */
     bool force_crop;                     /**< force cropping of subpicture */
@@ -156,6 +189,191 @@ static void SpuHeapClean(spu_heap_t *heap)
     }
 }
 
+/*****************************************************************************
+ * rendered text regions cache
+ *****************************************************************************/
+static bool SpuTextStyleEqual(const text_style_t *a, const text_style_t *b)
+{
+    if (a == NULL || b == NULL)
+        return a == b;
+
+    return a->i_features == b->i_features &&
+           a->i_style_flags == b->i_style_flags &&
+           a->f_font_relsize == b->f_font_relsize &&
+           a->i_font_size == b->i_font_size &&
+           a->i_font_color == b->i_font_color &&
+           a->i_font_alpha == b->i_font_alpha &&
+           a->i_spacing == b->i_spacing &&
+           a->i_outline_color == b->i_outline_color &&
+           a->i_outline_alpha == b->i_outline_alpha &&
+           a->i_outline_width == b->i_outline_width &&
+           a->i_shadow_color == b->i_shadow_color &&
+           a->i_shadow_alpha == b->i_shadow_alpha &&
+           a->i_shadow_width == b->i_shadow_width &&
+           a->i_background_color == b->i_background_color &&
+           a->i_background_alpha == b->i_background_alpha &&
+           a->i_karaoke_background_color == b->i_karaoke_background_color &&
+           a->i_karaoke_background_alpha == b->i_karaoke_background_alpha &&
+           !strcmp(a->psz_fontname ? a->psz_fontname : "",
+                   b->psz_fontname ? b->psz_fontname : "") &&
+           !strcmp(a->psz_monofontname ? a->psz_monofontname : "",
+                   b->psz_monofontname ? b->psz_monofontname : "");
+}
+
+static bool SpuTextSegmentsEqual(const text_segment_t *a,
+                                 const text_segment_t *b)
+{
+    for (; a != NULL && b != NULL; a = a->p_next, b = b->p_next) {
+        if (strcmp(a->psz_text ? a->psz_text : "",
+                   b->psz_text ? b->psz_text : ""))
+            return false;
+        if (!SpuTextStyleEqual(a->style, b->style))
+            return false;
+    }
+    return a == b;
+}
+
+/**
+ * Fills the cache key of a text region, before it gets rendered in place.
+ * It fails if the region cannot be cached.
+ */
+static bool SpuTextKeyInit(spu_text_key_t *key, filter_t *text,
+                           const subpicture_region_t *region,
+                           const vlc_fourcc_t *chroma_list)
+{
+    if (region->p_text == NULL || region->fmt.p_palette != NULL)
+        return false;
+
+    memset(key, 0, sizeof(*key));
+    for (unsigned i = 0; chroma_list[i]; i++) {
+        if (i >= SPU_TEXT_CACHE_MAX_CHROMAS - 1)
+            return false;
+        key->chroma[i] = chroma_list[i];
+    }
+    key->text          = region->p_text;
+    key->fmt           = region->fmt;
+    key->align         = region->i_align;
+    key->noregionbg    = region->b_noregionbg;
+    key->gridmode      = region->b_gridmode;
+    key->render_width  = text->fmt_out.video.i_width;
+    key->render_height = text->fmt_out.video.i_height;
+    key->text_scale    = var_InheritInteger(text, "sub-text-scale");
+    return true;
+}
+
+static bool SpuTextKeyEqual(const spu_text_key_t *a, const spu_text_key_t *b)
+{
+    return a->fmt.i_width == b->fmt.i_width &&
+           a->fmt.i_height == b->fmt.i_height &&
+           a->fmt.i_visible_width == b->fmt.i_visible_width &&
+           a->fmt.i_visible_height == b->fmt.i_visible_height &&
+           a->fmt.i_x_offset == b->fmt.i_x_offset &&
+           a->fmt.i_y_offset == b->fmt.i_y_offset &&
+           a->fmt.i_sar_num == b->fmt.i_sar_num &&
+           a->fmt.i_sar_den == b->fmt.i_sar_den &&
+           a->align == b->align &&
+           a->noregionbg == b->noregionbg &&
+           a->gridmode == b->gridmode &&
+           a->render_width == b->render_width &&
+           a->render_height == b->render_height &&
+           a->text_scale == b->text_scale &&
+           !memcmp(a->chroma, b->chroma, sizeof(a->chroma)) &&
+           SpuTextSegmentsEqual(a->text, b->text);
+}
+
+static void SpuTextCacheEntryClean(spu_text_cache_entry_t *e)
+{
+    if (e->text == NULL)
+        return;
+    text_segment_ChainDelete(e->text);
+    video_format_Clean(&e->fmt);
+    picture_Release(e->picture);
+    e->text = NULL;
+}
+
+static void SpuTextCacheInit(spu_text_cache_t *cache)
+{
+    cache->use_count = 0;
+    cache->hits      = 0;
+    cache->misses    = 0;
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++)
+        cache->entry[i].text = NULL;
+}
+
+static void SpuTextCacheClean(spu_text_cache_t *cache)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++)
+        SpuTextCacheEntryClean(&cache->entry[i]);
+}
+
+/**
+ * Renders a text region from the cache, if it was rendered before.
+ */
+static bool SpuTextCacheGet(spu_text_cache_t *cache, const spu_text_key_t *key,
+                            subpicture_region_t *region)
+{
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *e = &cache->entry[i];
+
+        if (e->text == NULL || !SpuTextKeyEqual(&e->key, key))
+            continue;
+
+        video_palette_t *palette = region->fmt.p_palette;
+        if (e->fmt.p_palette) {
+            if (!palette && !(palette = malloc(sizeof(*palette))))
+                return false;
+            *palette = *e->fmt.p_palette;
+        }
+
+        assert(region->p_picture == NULL);
+        region->fmt = e->fmt;
+        region->fmt.p_palette = palette;
+        region->p_picture = picture_Hold(e->picture);
+
+        e->last_use = ++cache->use_count;
+        cache->hits++;
+        return true;
+    }
+    cache->misses++;
+    return false;
+}
+
+/**
+ * Stores a freshly rendered text region, evicting the least recently used
+ * one if the cache is full.
+ */
+static void SpuTextCachePut(spu_text_cache_t *cache, const spu_text_key_t *key,
+                            const subpicture_region_t *region)
+{
+    spu_text_cache_entry_t *e = &cache->entry[0];
+
+    for (int i = 0; i < SPU_TEXT_CACHE_SIZE; i++) {
+        spu_text_cache_entry_t *c = &cache->entry[i];
+
+        if (c->text == NULL) {
+            e = c;
+            break;
+        }
+        if (c->last_use < e->last_use)
+            e = c;
+    }
+    SpuTextCacheEntryClean(e);
+
+    /* The key text points to the region one, which may go away */
+    text_segment_t *copy = text_segment_Copy((text_segment_t *)key->text);
+    if (copy == NULL)
+        return;
+    if (video_format_Copy(&e->fmt, &region->fmt)) {
+        text_segment_ChainDelete(copy);
+        return;
+    }
+    e->key      = *key;
+    e->key.text = copy;
+    e->text     = copy;
+    e->picture  = picture_Hold(region->p_picture);
+    e->last_use = ++cache->use_count;
+}
+
 static void FilterRelease(filter_t *filter)
 {
     if (filter->p_module)
@@ -274,10 +492,25 @@ static void SpuRenderText(spu_t *spu, bool *rerender_text,
      */
     var_SetInteger(text, "spu-elapsed", elapsed_time);
     var_SetBool(text, "text-rerender", false);
+    if (!region->p_text)
+        return;
+
+    spu_text_key_t key;
+    const bool cacheable = SpuTextKeyInit(&key, text, region, chroma_list);
+
+    /* Reuse the picture of an identical text rendered earlier */
+    if (cacheable && SpuTextCacheGet(&spu->p->text_cache, &key, region)) {
+        *rerender_text = false;
+        return;
+    }
 
-    if ( region->p_text )
-        text->pf_render(text, region, region, chroma_list);
+    text->pf_render(text, region, region, chroma_list);
     *rerender_text = var_GetBool(text, "text-rerender");
+
+    /* Time-dependent text cannot be reused */
+    if (cacheable && !*rerender_text &&
+        region->fmt.i_chroma != VLC_CODEC_TEXT && region->p_picture)
+        SpuTextCachePut(&spu->p->text_cache, &key, region);
 }
 
 /**
@@ -1200,6 +1433,7 @@ spu_t *spu_Create(vlc_object_t *object)
     SpuHeapInit(&sys->heap);
 
     sys->text = NULL;
+    SpuTextCacheInit(&sys->text_cache);
     sys->scale = NULL;
     sys->scale_yuvp = NULL;
 
@@ -1246,6 +1480,10 @@ void spu_Destroy(spu_t *spu)
     if (sys->text)
         FilterRelease(sys->text);
 
+    msg_Dbg(spu, "text cache: %u hits, %u misses",
+            sys->text_cache.hits, sys->text_cache.misses);
+    SpuTextCacheClean(&sys->text_cache);
+
     if (sys->scale_yuvp)
         FilterRelease(sys->scale_yuvp);
 
@@ -1287,6 +1525,8 @@ void spu_Attach(spu_t *spu, vlc_object_t *input, bool attach)
         if (spu->p->text)
             FilterRelease(spu->p->text);
         spu->p->text = SpuRenderCreateAndLoadText(spu);
+        /* The new renderer may use other fonts (attachments) */
+        SpuTextCacheClean(&spu->p->text_cache);
 
         vlc_mutex_unlock(&spu->p->lock);
     } else {
@@ -124,9 +124,11 @@ int vout_InitWrapper(vout_thread_t *vout)
 
     sys->display.use_dr = !vout_IsDisplayFiltered(vd);
     const bool allow_dr = !vd->info.has_pictures_invalid && !vd->info.is_slow && sys->display.use_dr;
-    const unsigned private_picture  = 4; /* XXX 3 for filter, 1 for SPU */
+    /* The filter stage holds its queued pictures and their sources */
+    const unsigned queued_picture   = sys->filter.stage.enabled ? VOUT_FILTER_QUEUE : 0;
+    const unsigned private_picture  = 4 + queued_picture; /* XXX 3 for filter, 1 for SPU */
     const unsigned decoder_picture  = 1 + sys->dpb_size;
-    const unsigned kept_picture     = 1; /* last displayed picture */
+    const unsigned kept_picture     = 1 + queued_picture; /* last displayed picture */
     const unsigned reserved_picture = DISPLAY_PICTURE_COUNT +
                                       private_picture +
                                       kept_picture;
@@ -148,10 +150,18 @@ int vout_InitWrapper(vout_thread_t *vout)
         sys->decoder_pool = display_pool;
         sys->display_pool = display_pool;
     } else if (!sys->decoder_pool) {
-        sys->decoder_pool =
-            picture_pool_NewFromFormat(&source,
-                                       __MAX(VOUT_MAX_PICTURES,
-                                             reserved_picture + decoder_picture - DISPLAY_PICTURE_COUNT));
+        const unsigned count = __MAX(VOUT_MAX_PICTURES,
+                                     reserved_picture + decoder_picture - DISPLAY_PICTURE_COUNT);
+
+        /* If requested, system memory pictures can be added when deep
+         * reordering or filtering holds all of them, rather than stalling
+         * the decoder */
+        if (var_InheritBool(vout, "video-pool-grow"))
+            sys->decoder_pool =
+                picture_pool_NewGrowable(&source, count,
+                                         count + VOUT_MAX_PICTURES);
+        else
+            sys->decoder_pool = picture_pool_NewFromFormat(&source, count);
         if (!sys->decoder_pool)
             return VLC_EGENERIC;
         if (allow_dr) {
@@ -182,6 +192,12 @@ void vout_EndWrapper(vout_thread_t *vout)
 
     assert(vout->p->decoder_pool && vout->p->private_pool);
 
+    picture_pool_stats_t stats;
+    picture_pool_GetStats(sys->decoder_pool, &stats);
+    msg_Dbg(vout, "decoder pool: %u/%u pictures, peak %u in use, "
+            "%lu acquired, %lu failed", stats.size, stats.max_size,
+            stats.peak_in_use, stats.acquired, stats.failed);
+
     picture_pool_Release(sys->private_pool);
 
     if (sys->decoder_pool != sys->display_pool)
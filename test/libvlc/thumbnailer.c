@@ -0,0 +1,190 @@
+/*****************************************************************************
+ * thumbnailer.c - libvlc smoke test
+ *****************************************************************************
+ * Copyright © 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#include "test.h"
+
+#include <string.h>
+
+#include <vlc_common.h>
+#include <vlc_modules.h>
+#include <vlc_threads.h>
+
+#define REQUESTS 8
+
+struct test_batch
+{
+    vlc_mutex_t lock;
+    vlc_cond_t  wait;
+    unsigned    done;
+    unsigned    images;
+    libvlc_media_t *md;
+};
+
+static void thumbnail_done (void *opaque, libvlc_media_t *md,
+                            const void *data, size_t size)
+{
+    struct test_batch *batch = opaque;
+    static const unsigned char png[] = { 0x89, 'P', 'N', 'G' };
+
+    assert (md == batch->md);
+    if (data != NULL)
+    {
+        assert (size > sizeof (png));
+        assert (!memcmp (data, png, sizeof (png)));
+    }
+
+    vlc_mutex_lock (&batch->lock);
+    batch->done++;
+    if (data != NULL)
+        batch->images++;
+    vlc_cond_signal (&batch->wait);
+    vlc_mutex_unlock (&batch->lock);
+}
+
+static void test_thumbnailer (const char **argv, int argc, bool wait)
+{
+    struct test_batch batch = { .done = 0, .images = 0 };
+
+    log ("Testing thumbnailer (%s)\n", wait ? "batch" : "cancellation");
+
+    vlc_mutex_init (&batch.lock);
+    vlc_cond_init (&batch.wait);
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    batch.md = libvlc_media_new_path (vlc, test_default_video);
+    assert (batch.md != NULL);
+
+    libvlc_thumbnailer_t *th = libvlc_thumbnailer_new (vlc, 2);
+    assert (th != NULL);
+
+    for (unsigned i = 0; i < REQUESTS; i++)
+    {
+        int ret;
+        if (i & 1)
+            ret = libvlc_thumbnailer_request_by_pos (th, batch.md, 0.f,
+                                                     64, 0,
+                                                     libvlc_thumbnailer_png,
+                                                     0, thumbnail_done,
+                                                     &batch);
+        else /* Native size, so that no video converter is needed */
+            ret = libvlc_thumbnailer_request_by_time (th, batch.md, 0,
+                                                      0, 0,
+                                                      libvlc_thumbnailer_png,
+                                                      5000, thumbnail_done,
+                                                      &batch);
+        assert (ret == 0);
+    }
+
+    if (wait)
+    {
+        vlc_mutex_lock (&batch.lock);
+        while (batch.done < REQUESTS)
+            vlc_cond_wait (&batch.wait, &batch.lock);
+        vlc_mutex_unlock (&batch.lock);
+        log ("%u/%u thumbnails extracted\n", batch.images, REQUESTS);
+        /* Scaled requests may fail without a video converter */
+        assert (batch.images >= REQUESTS / 2);
+    }
+
+    /* Every remaining request is canceled */
+    libvlc_thumbnailer_release (th);
+    assert (batch.done == REQUESTS);
+
+    libvlc_media_release (batch.md);
+    libvlc_release (vlc);
+
+    vlc_cond_destroy (&batch.wait);
+    vlc_mutex_destroy (&batch.lock);
+}
+
+/* The options of the media apply to the extraction, as for playback */
+static void test_thumbnailer_options (const char **argv, int argc)
+{
+    struct test_batch batch = { .done = 0, .images = 0 };
+
+    log ("Testing thumbnailer media options\n");
+
+    vlc_mutex_init (&batch.lock);
+    vlc_cond_init (&batch.wait);
+
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    batch.md = libvlc_media_new_path (vlc, test_default_video);
+    assert (batch.md != NULL);
+    libvlc_media_add_option (batch.md, ":demux=nonexistent");
+
+    libvlc_thumbnailer_t *th = libvlc_thumbnailer_new (vlc, 1);
+    assert (th != NULL);
+
+    int ret = libvlc_thumbnailer_request_by_time (th, batch.md, 0, 0, 0,
+                                                  libvlc_thumbnailer_png,
+                                                  5000, thumbnail_done,
+                                                  &batch);
+    assert (ret == 0);
+
+    vlc_mutex_lock (&batch.lock);
+    while (batch.done < 1)
+        vlc_cond_wait (&batch.wait, &batch.lock);
+    vlc_mutex_unlock (&batch.lock);
+    /* The image cannot be opened with the forced demuxer */
+    assert (batch.images == 0);
+
+    libvlc_thumbnailer_release (th);
+    libvlc_media_release (batch.md);
+    libvlc_release (vlc);
+
+    vlc_cond_destroy (&batch.wait);
+    vlc_mutex_destroy (&batch.lock);
+}
+
+static bool have_modules (const char **argv, int argc)
+{
+    static const char *const modules[] = { "image", "jpeg", "png" };
+    libvlc_instance_t *vlc = libvlc_new (argc, argv);
+    assert (vlc != NULL);
+
+    bool ok = true;
+    for (size_t i = 0; i < ARRAY_SIZE(modules); i++)
+        if (!module_exists (modules[i]))
+        {
+            log ("Skipping: %s module not found\n", modules[i]);
+            ok = false;
+        }
+
+    libvlc_release (vlc);
+    return ok;
+}
+
+int main (void)
+{
+    test_init ();
+
+    if (!have_modules (test_defaults_args, test_defaults_nargs))
+        return 77;
+
+    test_thumbnailer (test_defaults_args, test_defaults_nargs, true);
+    test_thumbnailer (test_defaults_args, test_defaults_nargs, false);
+    test_thumbnailer_options (test_defaults_args, test_defaults_nargs);
+
+    return 0;
+}
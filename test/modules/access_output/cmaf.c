@@ -0,0 +1,477 @@
+/*****************************************************************************
+ * cmaf.c: CMAF segmenter test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The segmenter splits the fragmented MP4 stream of the mux in top level
+ * boxes, whatever the block boundaries. The same stream is cut at every
+ * byte, in blocks of a few bytes and in one block per fragment: the
+ * segments must hold the same boxes, and the manifests must describe them.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_fs.h>
+#include <vlc_memstream.h>
+#include <vlc_sout.h>
+
+#define FRAGMENTS 6
+#define GOP       2 /* fragments per random access point */
+#define URL       "http://example.com/seg-###.m4s"
+
+static char psz_dir[] = "/tmp/vlc-test-cmaf-XXXXXX";
+
+/* Growable byte buffer to write boxes */
+typedef struct
+{
+    uint8_t *p;
+    size_t   i_size;
+} buf_t;
+
+static size_t Put( buf_t *b, const void *p, size_t i_size )
+{
+    size_t i_pos = b->i_size;
+
+    b->p = realloc( b->p, b->i_size + i_size );
+    assert( b->p );
+    if( p != NULL )
+        memcpy( &b->p[i_pos], p, i_size );
+    else
+        memset( &b->p[i_pos], 0, i_size );
+    b->i_size += i_size;
+    return i_pos;
+}
+
+static size_t BoxOpen( buf_t *b, const char *psz_type )
+{
+    uint8_t h[8] = { 0 };
+    memcpy( &h[4], psz_type, 4 );
+    return Put( b, h, 8 );
+}
+
+static void BoxClose( buf_t *b, size_t i_pos )
+{
+    SetDWBE( &b->p[i_pos], b->i_size - i_pos );
+}
+
+/* ftyp and a moov with a single AVC High 3.1 track */
+static void BuildInit( buf_t *b )
+{
+    size_t ftyp = BoxOpen( b, "ftyp" );
+    Put( b, "iso6\0\0\0\0iso6cmfc", 16 );
+    BoxClose( b, ftyp );
+
+    size_t moov = BoxOpen( b, "moov" );
+    size_t mvhd = BoxOpen( b, "mvhd" );
+    Put( b, NULL, 100 );
+    BoxClose( b, mvhd );
+    size_t trak = BoxOpen( b, "trak" );
+    size_t mdia = BoxOpen( b, "mdia" );
+    size_t minf = BoxOpen( b, "minf" );
+    size_t stbl = BoxOpen( b, "stbl" );
+    size_t stsd = BoxOpen( b, "stsd" );
+    Put( b, "\0\0\0\0\0\0\0\1", 8 );
+    size_t avc1 = BoxOpen( b, "avc1" );
+    Put( b, NULL, 78 );
+    size_t avcC = BoxOpen( b, "avcC" );
+    Put( b, "\x01\x64\x00\x1f\xff\xe0\x00", 7 );
+    BoxClose( b, avcC );
+    BoxClose( b, avc1 );
+    BoxClose( b, stsd );
+    BoxClose( b, stbl );
+    BoxClose( b, minf );
+    BoxClose( b, mdia );
+    BoxClose( b, trak );
+    BoxClose( b, moov );
+}
+
+/* moof + mdat; the mdat of odd fragments uses a 64 bits size */
+static void BuildFragment( buf_t *b, int i_frag )
+{
+    size_t moof = BoxOpen( b, "moof" );
+    uint8_t p_data[40 + 8 * i_frag];
+    memset( p_data, 0x10 + i_frag, sizeof(p_data) );
+    Put( b, p_data, sizeof(p_data) );
+    BoxClose( b, moof );
+
+    uint8_t p_media[100 + 16 * i_frag];
+    memset( p_media, 0x80 + i_frag, sizeof(p_media) );
+    if( i_frag & 1 )
+    {
+        uint8_t h[16] = { 0, 0, 0, 1, 'm', 'd', 'a', 't' };
+        SetQWBE( &h[8], 16 + sizeof(p_media) );
+        Put( b, h, 16 );
+        Put( b, p_media, sizeof(p_media) );
+    }
+    else
+    {
+        size_t mdat = BoxOpen( b, "mdat" );
+        Put( b, p_media, sizeof(p_media) );
+        BoxClose( b, mdat );
+    }
+}
+
+static char *MakePath( const char *psz_name )
+{
+    char *psz_path;
+    if( asprintf( &psz_path, "%s/%s", psz_dir, psz_name ) < 0 )
+        abort();
+    return psz_path;
+}
+
+static char *ReadFile( const char *psz_name, size_t *pi_size )
+{
+    char *psz_path = MakePath( psz_name );
+    FILE *fp = vlc_fopen( psz_path, "rb" );
+    free( psz_path );
+    if( fp == NULL )
+        return NULL;
+
+    char *p = NULL;
+    size_t i_size = 0, i_read;
+    do
+    {
+        p = realloc( p, i_size + 4097 );
+        assert( p );
+        i_read = fread( &p[i_size], 1, 4096, fp );
+        i_size += i_read;
+    }
+    while( i_read > 0 );
+    fclose( fp );
+
+    p[i_size] = '\0';
+    if( pi_size != NULL )
+        *pi_size = i_size;
+    return p;
+}
+
+static void RemoveFile( const char *psz_name )
+{
+    char *psz_path = MakePath( psz_name );
+    vlc_unlink( psz_path );
+    free( psz_path );
+}
+
+static sout_access_out_t *Create( libvlc_int_t *p_libvlc, bool b_chunked )
+{
+    char *psz_access, *psz_hls = MakePath( "index.m3u8" ),
+         *psz_dash = MakePath( "index.mpd" ), *psz_path = MakePath( "seg-###.m4s" );
+
+    if( asprintf( &psz_access, "cmaf{seglen=%d,chunked=%d,index-url=\"%s\","
+                  "hls-index=\"%s\",dash-index=\"%s\"}", GOP, b_chunked, URL,
+                  psz_hls, psz_dash ) < 0 )
+        abort();
+
+    sout_access_out_t *p_access = sout_AccessOutNew( p_libvlc, psz_access,
+                                                     psz_path );
+    free( psz_access );
+    free( psz_path );
+    free( psz_dash );
+    free( psz_hls );
+    return p_access;
+}
+
+/* The stream: FRAGMENTS fragments starting at pi_frag[], then an mfra box,
+ * which the segmenter must drop, at pi_frag[FRAGMENTS] */
+typedef struct
+{
+    buf_t  init;
+    buf_t  data;
+    size_t pi_frag[FRAGMENTS + 1];
+} fmp4_t;
+
+static void BuildStream( fmp4_t *p_stream )
+{
+    memset( p_stream, 0, sizeof(*p_stream) );
+    BuildInit( &p_stream->init );
+    for( int i = 0; i < FRAGMENTS; i++ )
+    {
+        p_stream->pi_frag[i] = p_stream->data.i_size;
+        BuildFragment( &p_stream->data, i );
+    }
+    p_stream->pi_frag[FRAGMENTS] = p_stream->data.i_size;
+
+    size_t mfra = BoxOpen( &p_stream->data, "mfra" );
+    Put( &p_stream->data, NULL, 24 );
+    BoxClose( &p_stream->data, mfra );
+}
+
+/* Writes the stream bytes from i_pos to i_end, in blocks of i_cut bytes, or
+ * one block per fragment if i_cut is 0. The timing of a block is the one of
+ * the fragment of its last byte, as the mux starts a block at each moof. */
+static void Write( sout_access_out_t *p_access, const fmp4_t *p_stream,
+                   size_t i_pos, size_t i_end, size_t i_cut )
+{
+    const size_t *pi_frag = p_stream->pi_frag;
+
+    while( i_pos < i_end )
+    {
+        size_t i_size = i_end - i_pos;
+        int i_frag = 0;
+
+        if( i_cut )
+            i_size = __MIN( i_size, i_cut );
+        else
+            for( int i = FRAGMENTS; i > 0; i-- )
+                if( pi_frag[i] > i_pos )
+                    i_size = __MIN( i_size, pi_frag[i] - i_pos );
+        while( i_frag + 1 < FRAGMENTS && pi_frag[i_frag + 1] < i_pos + i_size )
+            i_frag++;
+
+        block_t *p_block = block_Alloc( i_size );
+        assert( p_block );
+        memcpy( p_block->p_buffer, &p_stream->data.p[i_pos], i_size );
+        p_block->i_dts = p_block->i_pts = VLC_TS_0 + i_frag * CLOCK_FREQ;
+        p_block->i_length = CLOCK_FREQ;
+        if( i_frag % GOP == 0 )
+            p_block->i_flags |= BLOCK_FLAG_TYPE_I;
+
+        ssize_t i_ret = sout_AccessOutWrite( p_access, p_block );
+        assert( i_ret == (ssize_t)i_size );
+        i_pos += i_size;
+    }
+}
+
+static void WriteInit( sout_access_out_t *p_access, const fmp4_t *p_stream )
+{
+    block_t *p_block = block_Alloc( p_stream->init.i_size );
+    assert( p_block );
+    memcpy( p_block->p_buffer, p_stream->init.p, p_stream->init.i_size );
+    p_block->i_flags |= BLOCK_FLAG_HEADER;
+
+    ssize_t i_ret = sout_AccessOutWrite( p_access, p_block );
+    assert( i_ret == (ssize_t)p_stream->init.i_size );
+}
+
+static void CheckFile( const char *psz_name, const uint8_t *p, size_t i_size )
+{
+    size_t i_read;
+    char *p_read = ReadFile( psz_name, &i_read );
+
+    if( p_read == NULL || i_read != i_size || memcmp( p_read, p, i_size ) )
+    {
+        fprintf( stderr, "%s differs from the stream\n", psz_name );
+        abort();
+    }
+    free( p_read );
+}
+
+static void CheckText( const char *psz_name, const char *psz_expected )
+{
+    char *psz = ReadFile( psz_name, NULL );
+
+    if( psz == NULL || strcmp( psz, psz_expected ) )
+    {
+        fprintf( stderr, "%s:\n%s\nexpected:\n%s\n", psz_name,
+                 psz ? psz : "(missing)", psz_expected );
+        abort();
+    }
+    free( psz );
+}
+
+static void CheckContains( const char *psz_name, const char *psz_expected )
+{
+    char *psz = ReadFile( psz_name, NULL );
+
+    if( psz == NULL || strstr( psz, psz_expected ) == NULL )
+    {
+        fprintf( stderr, "%s:\n%s\nlacks:\n%s\n", psz_name,
+                 psz ? psz : "(missing)", psz_expected );
+        abort();
+    }
+    free( psz );
+}
+
+/* The live playlist after the first fragment of the second segment */
+static void CheckLive( const fmp4_t *p_stream )
+{
+    const size_t *pi_frag = p_stream->pi_frag;
+    char *psz_expected;
+
+    if( asprintf( &psz_expected,
+            "#EXTM3U\n#EXT-X-VERSION:9\n#EXT-X-TARGETDURATION:2\n"
+            "#EXT-X-MEDIA-SEQUENCE:1\n#EXT-X-INDEPENDENT-SEGMENTS\n"
+            "#EXT-X-PLAYLIST-TYPE:EVENT\n"
+            "#EXT-X-PART-INF:PART-TARGET=1.000\n"
+            "#EXT-X-SERVER-CONTROL:PART-HOLD-BACK=3.000\n"
+            "#EXT-X-MAP:URI=\"http://example.com/seg-init.m4s\"\n"
+            "#EXT-X-PART:DURATION=1.000,URI=\"http://example.com/seg-001.m4s\","
+            "BYTERANGE=\"%zu@0\",INDEPENDENT=YES\n"
+            "#EXT-X-PART:DURATION=1.000,URI=\"http://example.com/seg-001.m4s\","
+            "BYTERANGE=\"%zu@%zu\"\n"
+            "#EXTINF:2.000,\nhttp://example.com/seg-001.m4s\n"
+            "#EXT-X-PART:DURATION=1.000,URI=\"http://example.com/seg-002.m4s\","
+            "BYTERANGE=\"%zu@0\",INDEPENDENT=YES\n",
+            pi_frag[1], pi_frag[2] - pi_frag[1], pi_frag[1],
+            pi_frag[3] - pi_frag[2] ) < 0 )
+        abort();
+    CheckText( "index.m3u8", psz_expected );
+    free( psz_expected );
+
+    CheckContains( "index.mpd", " type=\"dynamic\"" );
+    CheckContains( "index.mpd", " availabilityTimeComplete=\"false\"" );
+    CheckContains( "index.mpd", "    <SegmentTimeline>\n"
+                                "     <S t=\"0\" d=\"2000\"/>\n"
+                                "    </SegmentTimeline>\n" );
+}
+
+static void CheckOutput( const fmp4_t *p_stream )
+{
+    const size_t *pi_frag = p_stream->pi_frag;
+    struct vlc_memstream hls, dash;
+
+    CheckFile( "seg-init.m4s", p_stream->init.p, p_stream->init.i_size );
+
+    assert( vlc_memstream_open( &hls ) == 0 );
+    vlc_memstream_puts( &hls,
+            "#EXTM3U\n#EXT-X-VERSION:7\n#EXT-X-TARGETDURATION:2\n"
+            "#EXT-X-MEDIA-SEQUENCE:1\n#EXT-X-INDEPENDENT-SEGMENTS\n"
+            "#EXT-X-PLAYLIST-TYPE:VOD\n"
+            "#EXT-X-MAP:URI=\"http://example.com/seg-init.m4s\"\n" );
+    assert( vlc_memstream_open( &dash ) == 0 );
+    vlc_memstream_puts( &dash,
+            "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+            "<MPD xmlns=\"urn:mpeg:dash:schema:mpd:2011\" "
+            "profiles=\"urn:mpeg:dash:profile:isoff-live:2011,"
+            "urn:mpeg:dash:profile:cmaf:2019\" type=\"static\" "
+            "mediaPresentationDuration=\"PT6.000S\" minBufferTime=\"PT2.000S\">\n"
+            " <Period id=\"0\" start=\"PT0S\">\n"
+            "  <AdaptationSet mimeType=\"video/mp4\" segmentAlignment=\"true\""
+            " startWithSAP=\"1\">\n"
+            "   <SegmentTemplate timescale=\"1000\""
+            " initialization=\"http://example.com/seg-init.m4s\""
+            " media=\"http://example.com/seg-$Number%03d$.m4s\" startNumber=\"1\">\n"
+            "    <SegmentTimeline>\n" );
+
+    for( int i = 0; i < FRAGMENTS / GOP; i++ )
+    {
+        char psz_name[16];
+        snprintf( psz_name, sizeof(psz_name), "seg-%03d.m4s", i + 1 );
+        CheckFile( psz_name, &p_stream->data.p[pi_frag[i * GOP]],
+                   pi_frag[(i + 1) * GOP] - pi_frag[i * GOP] );
+
+        vlc_memstream_printf( &hls, "#EXTINF:2.000,\nhttp://example.com/%s\n",
+                              psz_name );
+        vlc_memstream_printf( &dash, "     <S t=\"%d\" d=\"2000\"/>\n",
+                              i * 2000 );
+    }
+
+    vlc_memstream_puts( &hls, "#EXT-X-ENDLIST\n" );
+    vlc_memstream_printf( &dash,
+            "    </SegmentTimeline>\n   </SegmentTemplate>\n"
+            "   <Representation id=\"0\" bandwidth=\"%zu\""
+            " codecs=\"avc1.64001f\"/>\n"
+            "  </AdaptationSet>\n </Period>\n</MPD>\n",
+            pi_frag[FRAGMENTS] * 8 / FRAGMENTS );
+    assert( vlc_memstream_close( &hls ) == 0 );
+    assert( vlc_memstream_close( &dash ) == 0 );
+
+    CheckText( "index.m3u8", hls.ptr );
+    CheckText( "index.mpd", dash.ptr );
+    free( hls.ptr );
+    free( dash.ptr );
+}
+
+static void Cleanup( void )
+{
+    RemoveFile( "seg-init.m4s" );
+    for( int i = 0; i < FRAGMENTS / GOP; i++ )
+    {
+        char psz_name[16];
+        snprintf( psz_name, sizeof(psz_name), "seg-%03d.m4s", i + 1 );
+        RemoveFile( psz_name );
+    }
+    RemoveFile( "index.m3u8" );
+    RemoveFile( "index.mpd" );
+}
+
+static void test_Segments( libvlc_int_t *p_libvlc, const fmp4_t *p_stream,
+                           size_t i_cut, bool b_chunked )
+{
+    sout_access_out_t *p_access = Create( p_libvlc, b_chunked );
+    assert( p_access );
+
+    WriteInit( p_access, p_stream );
+    if( b_chunked )
+    {
+        size_t i_live = p_stream->pi_frag[GOP + 1];
+        Write( p_access, p_stream, 0, i_live, i_cut );
+        CheckLive( p_stream );
+        Write( p_access, p_stream, i_live, p_stream->data.i_size, i_cut );
+    }
+    else
+        Write( p_access, p_stream, 0, p_stream->data.i_size, i_cut );
+    sout_AccessOutDelete( p_access );
+
+    CheckOutput( p_stream );
+    Cleanup();
+    printf( "cmaf %s, %zu bytes blocks: ok\n",
+            b_chunked ? "chunked" : "segments", i_cut );
+}
+
+int main( void )
+{
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv), ppsz_argv );
+    assert( p_vlc );
+
+    if( mkdtemp( psz_dir ) == NULL )
+    {
+        perror( "mkdtemp" );
+        libvlc_release( p_vlc );
+        return 77;
+    }
+
+    fmp4_t stream;
+    BuildStream( &stream );
+
+    /* Every byte, box headers split in all possible ways, and one block per
+     * fragment */
+    static const size_t pi_cut[] = { 1, 3, 7, 13, 0 };
+    for( size_t i = 0; i < ARRAY_SIZE(pi_cut); i++ )
+    {
+        test_Segments( p_vlc->p_libvlc_int, &stream, pi_cut[i], false );
+        test_Segments( p_vlc->p_libvlc_int, &stream, pi_cut[i], true );
+    }
+
+    free( stream.init.p );
+    free( stream.data.p );
+    rmdir( psz_dir );
+    libvlc_release( p_vlc );
+    return 0;
+}
@@ -0,0 +1,165 @@
+/*****************************************************************************
+ * common.c: audio filter tests common functions
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#include "common.h"
+
+#define BENCH_SECONDS 20
+
+filter_t *CreateAudioFilter( vlc_object_t *p_parent, const char *psz_cap,
+                             const char *psz_name, uint16_t i_chans,
+                             unsigned i_in_rate, unsigned i_out_rate )
+{
+    filter_t *p_filter = vlc_object_create( p_parent, sizeof(*p_filter) );
+    assert( p_filter );
+
+    audio_format_t fmt = {
+        .i_format = VLC_CODEC_FL32,
+        .i_physical_channels = i_chans,
+        .i_original_channels = i_chans,
+    };
+    aout_FormatPrepare( &fmt );
+
+    es_format_Init( &p_filter->fmt_in, AUDIO_ES, VLC_CODEC_FL32 );
+    p_filter->fmt_in.audio = fmt;
+    p_filter->fmt_in.audio.i_rate = i_in_rate;
+    es_format_Init( &p_filter->fmt_out, AUDIO_ES, VLC_CODEC_FL32 );
+    p_filter->fmt_out.audio = fmt;
+    p_filter->fmt_out.audio.i_rate = i_out_rate;
+
+    p_filter->p_module = module_need( p_filter, psz_cap, psz_name, true );
+    if( p_filter->p_module == NULL )
+    {
+        es_format_Clean( &p_filter->fmt_in );
+        es_format_Clean( &p_filter->fmt_out );
+        vlc_object_release( p_filter );
+        return NULL;
+    }
+    return p_filter;
+}
+
+void DeleteAudioFilter( filter_t *p_filter )
+{
+    module_unneed( p_filter, p_filter->p_module );
+    es_format_Clean( &p_filter->fmt_in );
+    es_format_Clean( &p_filter->fmt_out );
+    vlc_object_release( p_filter );
+}
+
+float *RunAudioFilter( filter_t *p_filter, const float *p_in, size_t i_frames,
+                       unsigned i_period, bool b_drain,
+                       void (*pf_block)( filter_t *, size_t, void * ),
+                       void *p_opaque, size_t *pi_out, mtime_t *pi_time )
+{
+    const unsigned i_rate = p_filter->fmt_in.audio.i_rate;
+    const unsigned i_nch_in = p_filter->fmt_in.audio.i_channels;
+    const unsigned i_nch_out = p_filter->fmt_out.audio.i_channels;
+    size_t i_out = 0, i_size = 0;
+    float *p_out = NULL;
+    mtime_t i_time = 0;
+
+    for( size_t i = 0, k = 0; i < i_frames || b_drain; i += i_period, k++ )
+    {
+        block_t *p_block;
+
+        if( i < i_frames )
+        {
+            const size_t i_count = __MIN( (size_t)i_period, i_frames - i );
+
+            p_block = block_Alloc( i_count * i_nch_in * sizeof (float) );
+            assert( p_block );
+            memcpy( p_block->p_buffer, &p_in[i_nch_in * i],
+                    p_block->i_buffer );
+            p_block->i_nb_samples = i_count;
+            p_block->i_pts = VLC_TS_0 + i * CLOCK_FREQ / i_rate;
+            p_block->i_length = i_count * CLOCK_FREQ / i_rate;
+
+            if( pf_block != NULL )
+                pf_block( p_filter, k, p_opaque );
+            mtime_t i_start = mdate();
+            p_block = p_filter->pf_audio_filter( p_filter, p_block );
+            i_time += mdate() - i_start;
+            p_filter->fmt_in.audio.i_rate = i_rate;
+        }
+        else
+        {
+            p_block = filter_DrainAudio( p_filter );
+            b_drain = false;
+        }
+
+        if( p_block == NULL )
+            continue;
+
+        const size_t i_count = p_block->i_buffer
+                             / (i_nch_out * sizeof (float));
+        if( i_out + i_count > i_size )
+        {
+            i_size = (i_out + i_count) * 2;
+            p_out = realloc( p_out, i_size * i_nch_out * sizeof (float) );
+            assert( p_out );
+        }
+        memcpy( &p_out[i_nch_out * i_out], p_block->p_buffer,
+                i_count * i_nch_out * sizeof (float) );
+        i_out += i_count;
+        block_Release( p_block );
+    }
+
+    *pi_out = i_out;
+    if( pi_time != NULL )
+        *pi_time = i_time;
+    return p_out;
+}
+
+int main( int argc, char *argv[] )
+{
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv), ppsz_argv );
+    assert( p_vlc );
+
+    srand( 0 );
+    test_Main( p_vlc->p_libvlc_int );
+    if( argc > 1 && !strcmp( argv[1], "-b" ) )
+        test_Benchmark( p_vlc->p_libvlc_int, BENCH_SECONDS );
+
+    libvlc_release( p_vlc );
+    return 0;
+}
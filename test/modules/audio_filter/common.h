@@ -0,0 +1,65 @@
+/*****************************************************************************
+ * common.h: audio filter tests common definitions
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifndef VLC_TEST_AUDIO_FILTER_COMMON_H
+#define VLC_TEST_AUDIO_FILTER_COMMON_H
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+
+/*
+ * The main() of the audio filter tests is shared: it creates a libvlc
+ * instance with the plugins of the build tree, and calls test_Main() with
+ * it. With -b, it then calls test_Benchmark() for 20 seconds of audio.
+ * Both are provided by each test.
+ */
+void test_Main( libvlc_int_t *p_libvlc );
+void test_Benchmark( libvlc_int_t *p_libvlc, unsigned i_seconds );
+
+/**
+ * Loads an audio filter module converting i_in_rate to i_out_rate Hz of
+ * i_chans interleaved float samples. p_parent is the parent object of the
+ * filter, from which it inherits its settings.
+ *
+ * \return the filter, or NULL if the module could not be loaded
+ */
+filter_t *CreateAudioFilter( vlc_object_t *p_parent, const char *psz_cap,
+                             const char *psz_name, uint16_t i_chans,
+                             unsigned i_in_rate, unsigned i_out_rate );
+void DeleteAudioFilter( filter_t *p_filter );
+
+/**
+ * Filters i_frames of interleaved audio in blocks of i_period frames, then
+ * drains the filter if b_drain is true.
+ *
+ * pf_block, if not NULL, is called before each block is filtered, with the
+ * index of the block. It may change the input rate of the filter, which is
+ * restored after the block, as the audio output does to correct drift.
+ *
+ * \param pi_out the number of output frames [OUT]
+ * \param pi_time the time spent in the filter, or NULL [OUT]
+ * \return the output, to be freed by the caller
+ */
+float *RunAudioFilter( filter_t *p_filter, const float *p_in, size_t i_frames,
+                       unsigned i_period, bool b_drain,
+                       void (*pf_block)( filter_t *, size_t, void * ),
+                       void *p_opaque, size_t *pi_out, mtime_t *pi_time );
+
+#endif
@@ -0,0 +1,252 @@
+/*****************************************************************************
+ * convolver.c: partitioned convolution engine test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../../modules/audio_filter/convolver.c"
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+#include <unistd.h>
+
+#include "common.h"
+
+#define RATE 48000
+
+static float Noise( void )
+{
+    return rand() / (float)RAND_MAX - .5f;
+}
+
+/*****************************************************************************
+ * Comparison with the direct convolution, fed in random chunks
+ *****************************************************************************/
+static void test_Direct( unsigned i_block, size_t i_max )
+{
+    enum { INPUTS = 3, OUTPUTS = 2, FRAMES = 3 * RATE / 10 };
+    /* Responses of each path: none, shorter than a block, not a whole
+     * number of blocks, and the longest */
+    const size_t lengths[INPUTS][OUTPUTS] = {
+        { i_max, 0 }, { i_block / 3, i_max - i_block / 2 }, { 1, i_max / 3 },
+    };
+    float *p_ir[INPUTS][OUTPUTS];
+
+    convolver_t *c = convolver_New( i_block, INPUTS, OUTPUTS, i_max );
+    assert( c != NULL );
+    for( unsigned i = 0; i < INPUTS; i++ )
+        for( unsigned o = 0; o < OUTPUTS; o++ )
+        {
+            const size_t i_len = lengths[i][o];
+
+            p_ir[i][o] = malloc( (i_len + 1) * sizeof (float) );
+            assert( p_ir[i][o] );
+            /* Decaying noise, like a room */
+            for( size_t k = 0; k < i_len; k++ )
+                p_ir[i][o][k] = Noise() * expf( -4.f * k / i_max );
+            assert( convolver_SetResponse( c, i, o, p_ir[i][o], i_len, 1,
+                                           .5f ) == VLC_SUCCESS );
+        }
+    assert( convolver_SetResponse( c, 0, 1, p_ir[0][0], i_max + i_block, 1,
+                                   1.f ) == VLC_EGENERIC );
+
+    float *p_in = malloc( FRAMES * INPUTS * sizeof (float) );
+    float *p_out = malloc( FRAMES * OUTPUTS * sizeof (float) );
+    assert( p_in && p_out );
+    for( size_t k = 0; k < FRAMES * INPUTS; k++ )
+        p_in[k] = Noise();
+
+    for( size_t k = 0; k < FRAMES; )
+    {
+        size_t i_count = __MIN( (size_t)rand() % (3 * i_block), FRAMES - k );
+
+        convolver_Process( c, &p_out[k * OUTPUTS], &p_in[k * INPUTS],
+                           i_count );
+        k += i_count;
+    }
+
+    double f_err = 0., f_ref = 0.;
+    for( size_t k = 0; k < FRAMES; k++ )
+        for( unsigned o = 0; o < OUTPUTS; o++ )
+        {
+            double f_sum = 0.;
+
+            /* The output is delayed by one block */
+            for( unsigned i = 0; i < INPUTS; i++ )
+                for( size_t j = 0; j < lengths[i][o]
+                                && j + i_block <= k; j++ )
+                    f_sum += .5 * p_ir[i][o][j]
+                           * p_in[(k - i_block - j) * INPUTS + i];
+            f_err = fmax( f_err, fabs( p_out[k * OUTPUTS + o] - f_sum ) );
+            f_ref = fmax( f_ref, fabs( f_sum ) );
+        }
+    printf( "convolver %4u frames blocks, %5zu frames: error %6.1f dB\n",
+            i_block, i_max, 20. * log10( f_err / f_ref ) );
+    assert( f_err < 1e-5 * f_ref );
+
+    /* Reset leaves no tail */
+    convolver_Reset( c );
+    memset( p_in, 0, FRAMES * INPUTS * sizeof (float) );
+    convolver_Process( c, p_out, p_in, FRAMES );
+    for( size_t k = 0; k < FRAMES * OUTPUTS; k++ )
+        assert( p_out[k] == 0.f );
+
+    free( p_out );
+    free( p_in );
+    for( unsigned i = 0; i < INPUTS; i++ )
+        for( unsigned o = 0; o < OUTPUTS; o++ )
+            free( p_ir[i][o] );
+    convolver_Delete( c );
+}
+
+/*****************************************************************************
+ * Impulse response files
+ *****************************************************************************/
+static void PutLE( uint8_t *p, uint32_t v, unsigned i_bytes )
+{
+    for( unsigned i = 0; i < i_bytes; i++ )
+        p[i] = v >> (8 * i);
+}
+
+static void test_Load( libvlc_int_t *p_libvlc )
+{
+    static const struct { unsigned i_tag, i_bits; } formats[] = {
+        { 1, 16 }, { 1, 24 }, { 1, 32 }, { 3, 32 },
+    };
+    static const float samples[] = { 0.f, .5f, -.25f, -1.f, .75f, .125f };
+    char psz_path[] = "/tmp/vlc-test-convolverXXXXXX";
+
+    for( size_t f = 0; f < ARRAY_SIZE(formats); f++ )
+    {
+        const unsigned i_bytes = formats[f].i_bits / 8;
+        const size_t i_data = ARRAY_SIZE(samples) * i_bytes;
+        uint8_t p_file[64 + ARRAY_SIZE(samples) * 4];
+
+        /* A stereo file, with an unknown chunk before the data */
+        memcpy( p_file, "RIFF", 4 );
+        PutLE( p_file + 4, 4 + 24 + 10 + 8 + i_data, 4 );
+        memcpy( p_file + 8, "WAVEfmt ", 8 );
+        PutLE( p_file + 16, 16, 4 );
+        PutLE( p_file + 20, formats[f].i_tag, 2 );
+        PutLE( p_file + 22, 2, 2 );
+        PutLE( p_file + 24, RATE, 4 );
+        PutLE( p_file + 28, RATE * 2 * i_bytes, 4 );
+        PutLE( p_file + 32, 2 * i_bytes, 2 );
+        PutLE( p_file + 34, formats[f].i_bits, 2 );
+        memcpy( p_file + 36, "LIST", 4 );
+        PutLE( p_file + 40, 1, 4 );
+        memcpy( p_file + 46, "data", 4 );
+        PutLE( p_file + 50, i_data, 4 );
+        for( size_t i = 0; i < ARRAY_SIZE(samples); i++ )
+        {
+            union { float f; uint32_t u; } v = { .f = samples[i] };
+            uint32_t i_sample = formats[f].i_tag == 3 ? v.u :
+                (uint32_t)lrint( samples[i] * (1u << (formats[f].i_bits - 1)) );
+            PutLE( p_file + 54 + i * i_bytes, i_sample, i_bytes );
+        }
+
+        int fd = mkstemp( psz_path );
+        assert( fd >= 0 );
+        assert( write( fd, p_file, 54 + i_data ) == (ssize_t)(54 + i_data) );
+        close( fd );
+
+        unsigned i_rate, i_chans;
+        size_t i_frames;
+        float *p = convolver_Load( VLC_OBJECT(p_libvlc), psz_path, &i_rate,
+                                   &i_chans, &i_frames );
+        unlink( psz_path );
+        strcpy( psz_path + strlen( psz_path ) - 6, "XXXXXX" );
+
+        assert( p != NULL );
+        assert( i_rate == RATE && i_chans == 2 );
+        assert( i_frames == ARRAY_SIZE(samples) / 2 );
+        for( size_t i = 0; i < ARRAY_SIZE(samples); i++ )
+            assert( p[i] == samples[i] );
+        free( p );
+    }
+
+    unsigned i_rate, i_chans;
+    size_t i_frames;
+    assert( convolver_Load( VLC_OBJECT(p_libvlc), "/nonexistent.wav",
+                            &i_rate, &i_chans, &i_frames ) == NULL );
+}
+
+/*****************************************************************************
+ * Latency and cost of the binaural rendering of 7.1 audio
+ *****************************************************************************/
+void test_Benchmark( libvlc_int_t *p_libvlc, unsigned i_seconds )
+{
+    static const unsigned blocks[] = { 64, 128, 256, 512 };
+    /* Anechoic HRIR, small and large room responses */
+    static const size_t lengths[] = { 256, RATE / 4, RATE };
+    const size_t i_frames = RATE * i_seconds;
+    VLC_UNUSED(p_libvlc);
+
+    float *p_in = malloc( i_frames * 8 * sizeof (float) );
+    float *p_out = malloc( i_frames * 2 * sizeof (float) );
+    float *p_ir = malloc( RATE * sizeof (float) );
+    assert( p_in && p_out && p_ir );
+    for( size_t k = 0; k < i_frames * 8; k++ )
+        p_in[k] = Noise();
+    for( size_t k = 0; k < RATE; k++ )
+        p_ir[k] = Noise();
+
+    for( size_t l = 0; l < ARRAY_SIZE(lengths); l++ )
+        for( size_t b = 0; b < ARRAY_SIZE(blocks); b++ )
+        {
+            convolver_t *c = convolver_New( blocks[b], 8, 2, lengths[l] );
+            assert( c != NULL );
+            for( unsigned i = 0; i < 8; i++ )
+                for( unsigned o = 0; o < 2; o++ )
+                    assert( convolver_SetResponse( c, i, o, p_ir,
+                                                   lengths[l], 1, .1f )
+                            == VLC_SUCCESS );
+
+            mtime_t i_time = mdate();
+            for( size_t k = 0; k < i_frames; k += RATE / 100 )
+                convolver_Process( c, &p_out[2 * k], &p_in[8 * k],
+                                   __MIN( RATE / 100, i_frames - k ) );
+            i_time = mdate() - i_time;
+            convolver_Delete( c );
+
+            printf( "convolver 7.1 binaural, %5zu frames responses, "
+                    "%3u frames blocks (%4.1f ms): %5.2f %% CPU\n",
+                    lengths[l], blocks[b], 1000. * blocks[b] / RATE,
+                    100. * i_time / (CLOCK_FREQ * i_seconds) );
+        }
+
+    free( p_ir );
+    free( p_out );
+    free( p_in );
+}
+
+void test_Main( libvlc_int_t *p_libvlc )
+{
+    test_Direct( 4, 4 );
+    test_Direct( 64, 1000 );
+    test_Direct( 256, 256 );
+    test_Direct( 256, 4000 );
+    test_Load( p_libvlc );
+}
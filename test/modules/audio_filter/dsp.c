@@ -0,0 +1,628 @@
+/*****************************************************************************
+ * dsp.c: audio DSP modules regression test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Every audio filter, converter, resampler and volume module is loaded
+ * through the module bank and fed with the same synthetic signal. The output
+ * of the first second is compared with a stored reference, so that any change
+ * to the arithmetic of a module, such as a SIMD rewrite, is caught. Integer
+ * output is hashed and checked sample for sample. Floating point output
+ * depends on how the compiler orders and contracts operations, so its level
+ * and its correlation with a fixed noise are checked within a tolerance
+ * instead. The time per sample and the number of output buffers allocated
+ * per block are reported as well.
+ *
+ * Run with -b to benchmark more audio, and with -r to list the references of
+ * the current build instead of checking them.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_aout_volume.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#define RATE 48000
+#define FRAMES 1024
+/* Blocks of output that are hashed: about one second */
+#define HASHED_BLOCKS (RATE / FRAMES)
+
+/* Run with -b to benchmark more audio */
+static unsigned i_bench_seconds = 1;
+/* Run with -r to list the references */
+static bool b_list_refs = false;
+
+/* The hashes of integer output were recorded on x86-64. Some modules compute
+ * in floating point before converting to integers, and other architectures
+ * may fuse multiplications and additions, and thus round differently. */
+#if defined(__x86_64__)
+# define HAVE_HASHES
+#endif
+
+/* Maximum relative error of the level and correlation of floating point
+ * output, that is a signal to error ratio of at least 80 dB */
+#define FLOAT_TOLERANCE 1e-4
+
+#define MONO     AOUT_CHAN_CENTER
+#define STEREO   AOUT_CHANS_STEREO
+#define DOLBY    (AOUT_CHANS_STEREO|AOUT_CHAN_DOLBYSTEREO)
+#define CH5_1    AOUT_CHANS_5_1
+#define CH7_1    AOUT_CHANS_7_1
+
+struct dsp_case
+{
+    const char  *psz_cap;
+    const char  *psz_name;
+    vlc_fourcc_t i_in_format;
+    vlc_fourcc_t i_out_format;  /**< 0: as negotiated by the module */
+    uint16_t     i_in_chans;
+    uint32_t     i_in_orig;     /**< 0: same as physical channels */
+    uint16_t     i_out_chans;   /**< 0: same as input */
+    uint32_t     i_out_orig;    /**< 0: same as physical channels */
+    unsigned     i_out_rate;    /**< 0: same as input */
+    bool         b_cpu;         /**< integer output depends on the CPU */
+    /* Reference of integer output */
+    uint64_t     i_hash;        /**< 0: no reference recorded */
+    /* Reference of floating point output */
+    double       f_level;       /**< RMS level, 0: no reference recorded */
+    double       f_corr;        /**< correlation with the noise */
+};
+
+#define HASH(hash)         hash, 0., 0.
+#define SIGNATURE(l, c)    0, l, c
+#define NO_REF             0, 0., 0.
+
+#define FILTER(name, fmt, chans, ref) \
+    { "audio filter", name, fmt, 0, chans, 0, 0, 0, 0, false, ref }
+#define CONVERTER(name, in, out, ref) \
+    { "audio converter", name, in, out, STEREO, 0, 0, 0, 0, false, ref }
+#define MIXER(cap, name, in, out, out_orig, ref) \
+    { cap, name, VLC_CODEC_FL32, 0, in, 0, out, out_orig, 0, false, ref }
+#define RESAMPLER(name, out_rate, cpu, ref) \
+    { "audio resampler", name, VLC_CODEC_FL32, 0, STEREO, 0, 0, 0, \
+      out_rate, cpu, ref }
+#define VOLUME(name, fmt, ref) \
+    { "audio volume", name, fmt, 0, STEREO, 0, 0, 0, 0, false, ref }
+
+static const struct dsp_case cases[] = {
+    FILTER( "equalizer", VLC_CODEC_FL32, MONO,
+            SIGNATURE( 0.498764502, -0.361478385 ) ),
+    FILTER( "equalizer", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.475486996, -1.39671138 ) ),
+    FILTER( "equalizer", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.468532401, -0.0269280398 ) ),
+    FILTER( "equalizer", VLC_CODEC_FL32, CH7_1,
+            SIGNATURE( 0.46647896, 1.18713182 ) ),
+    FILTER( "compressor", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.351747283, -1.16995052 ) ),
+    FILTER( "compressor", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.330873356, -1.08645182 ) ),
+    FILTER( "param_eq", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.203853043, -0.836302788 ) ),
+    FILTER( "param_eq", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.220547039, -1.14437125 ) ),
+    FILTER( "spatializer", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.049669462, 1.47025225 ) ),
+    FILTER( "spatializer", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.134702331, -1.26106211 ) ),
+    FILTER( "chorus_flanger", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.0833973292, -0.952273492 ) ),
+    FILTER( "gain", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.113176282, -0.810232439 ) ),
+    FILTER( "gain", VLC_CODEC_S16N, STEREO,
+            HASH( UINT64_C(0x69b81091a1d057c4) ) ),
+    FILTER( "karaoke", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.165863008, -1.7747872 ) ),
+    FILTER( "loudness", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.143617568, -0.333051831 ) ),
+    FILTER( "loudness", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.141238534, 0.0303056041 ) ),
+    FILTER( "normvol", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.0951363078, -1.32885391 ) ),
+    FILTER( "normvol", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.0950138269, -1.58770429 ) ),
+    FILTER( "stereo_widen", VLC_CODEC_FL32, STEREO,
+            SIGNATURE( 0.15375866, -1.27543914 ) ),
+    FILTER( "mono", VLC_CODEC_S16N, STEREO,
+            HASH( UINT64_C(0xcc4257f4ed05dacc) ) ),
+    FILTER( "mono", VLC_CODEC_S16N, CH5_1,
+            HASH( UINT64_C(0x3fc5a93fdda0484f) ) ),
+    FILTER( "remap", VLC_CODEC_FL32, CH5_1,
+            SIGNATURE( 0.161263108, -1.45484884 ) ),
+    FILTER( "remap", VLC_CODEC_S16N, CH7_1,
+            HASH( UINT64_C(0xd404d27676965867) ) ),
+
+    MIXER( "audio filter", "headphone", CH5_1, STEREO, 0,
+           SIGNATURE( 0.0744938535, 1.43456828 ) ),
+    MIXER( "audio filter", "headphone", CH7_1, STEREO, 0,
+           SIGNATURE( 0.0784571174, 0.439355958 ) ),
+    { "audio converter", "dolby", VLC_CODEC_FL32, 0,
+      STEREO, DOLBY, CH5_1, STEREO, 0, false,
+      SIGNATURE( 0.132011498, -0.454524604 ) },
+    MIXER( "audio converter", "simple_channel_mixer", CH5_1, STEREO, 0,
+           SIGNATURE( 0.249199032, 0.285411893 ) ),
+    MIXER( "audio converter", "simple_channel_mixer", CH7_1, STEREO, 0,
+           SIGNATURE( 0.197664111, 1.26966413 ) ),
+    MIXER( "audio converter", "simple_channel_mixer", CH7_1, CH5_1, 0,
+           SIGNATURE( 0.146487959, -0.010520563 ) ),
+    { "audio converter", "simple_channel_mixer", VLC_CODEC_FL32,
+      VLC_CODEC_S16N, CH5_1, 0, STEREO, 0, 0, false,
+      HASH( UINT64_C(0x27332458fa742c86) ) },
+    { "audio converter", "simple_channel_mixer", VLC_CODEC_FL32,
+      VLC_CODEC_S32N, CH7_1, 0, CH5_1, 0, 0, false,
+      HASH( UINT64_C(0xf6da88d31bc1dbb2) ) },
+    MIXER( "audio converter", "trivial", CH5_1, STEREO, 0,
+           SIGNATURE( 0.163224496, -1.44631392 ) ),
+    MIXER( "audio converter", "trivial", MONO, STEREO, 0,
+           SIGNATURE( 0.161250481, -0.963893833 ) ),
+    MIXER( "audio converter", "trivial", STEREO, CH5_1, 0,
+           SIGNATURE( 0.0933462256, 0.378586241 ) ),
+
+    CONVERTER( "audio_format", VLC_CODEC_U8, VLC_CODEC_S16N,
+               HASH( UINT64_C(0xe9649a2e7873bc88) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_U8, VLC_CODEC_FL32,
+               SIGNATURE( 0.157180613, -0.816974182 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_U8, VLC_CODEC_S32N,
+               HASH( UINT64_C(0x3479bed448083b80) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_U8, VLC_CODEC_FL64,
+               SIGNATURE( 0.157180613, -0.816974182 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S16N, VLC_CODEC_U8,
+               HASH( UINT64_C(0x4d04805c3481277f) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S16N, VLC_CODEC_FL32,
+               SIGNATURE( 0.161662698, -0.810232005 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S16N, VLC_CODEC_S32N,
+               HASH( UINT64_C(0x516ddddcf312401d) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S16N, VLC_CODEC_FL64,
+               SIGNATURE( 0.161662698, -0.810232005 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL32, VLC_CODEC_U8,
+               HASH( UINT64_C(0xecd834b5f9e47a10) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL32, VLC_CODEC_S16N,
+               HASH( UINT64_C(0xa4df555dd6d3cea1) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL32, VLC_CODEC_S32N,
+               HASH( UINT64_C(0x72868109043c8618) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL32, VLC_CODEC_FL64,
+               SIGNATURE( 0.161680406, -0.810232422 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S32N, VLC_CODEC_U8,
+               HASH( UINT64_C(0x4124d7bd6cb31517) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S32N, VLC_CODEC_S16N,
+               HASH( UINT64_C(0x1e83a6ee0bb8547f) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S32N, VLC_CODEC_FL32,
+               SIGNATURE( 0.161680404, -0.810232392 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_S32N, VLC_CODEC_FL64,
+               SIGNATURE( 0.161680405, -0.810232416 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL64, VLC_CODEC_U8,
+               HASH( UINT64_C(0xecd834b5f9e47a10) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL64, VLC_CODEC_S16N,
+               HASH( UINT64_C(0xd0352b5b8256f081) ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL64, VLC_CODEC_FL32,
+               SIGNATURE( 0.161680406, -0.810232422 ) ),
+    CONVERTER( "audio_format", VLC_CODEC_FL64, VLC_CODEC_S32N,
+               HASH( UINT64_C(0x72868109043c8618) ) ),
+
+    RESAMPLER( "ugly", 44100, false, SIGNATURE( 0.161731577, -0.253272956 ) ),
+    RESAMPLER( "bandlimited", 44100, false, NO_REF ),
+    RESAMPLER( "polyphase", 44100, true,
+               SIGNATURE( 0.15838202, 0.979755883 ) ),
+    RESAMPLER( "samplerate", 44100, false, NO_REF ),
+    RESAMPLER( "speex", 44100, false, NO_REF ),
+    RESAMPLER( "soxr", 44100, false, NO_REF ),
+
+    VOLUME( "float_mixer", VLC_CODEC_FL32,
+            SIGNATURE( 0.0808402028, -0.810232422 ) ),
+    VOLUME( "float_mixer", VLC_CODEC_FL64,
+            SIGNATURE( 0.0808402027, -0.810232414 ) ),
+    VOLUME( "integer_mixer", VLC_CODEC_S16N,
+            HASH( UINT64_C(0xb67fae0fe194248b) ) ),
+    VOLUME( "integer_mixer", VLC_CODEC_S32N,
+            HASH( UINT64_C(0x8bd9ff313e125271) ) ),
+};
+
+/*****************************************************************************
+ * Synthetic signal
+ *****************************************************************************/
+
+/**
+ * Generates frame i of channel c: white noise over a sawtooth whose period
+ * depends on the channel, with a full scale impulse once per second. Only
+ * exact integer and power of two arithmetic is used, so that the input is the
+ * same everywhere.
+ */
+static double Signal( uint32_t *p_seed, uint64_t i, unsigned c )
+{
+    *p_seed = *p_seed * 1664525 + 1013904223;
+
+    const double noise = ((int32_t)*p_seed >> 8) / (double)(1 << 26);
+    const unsigned i_period = 64 << (c % 4);
+    const double saw = (double)((i + 16 * c) % i_period) / i_period - .5;
+
+    if( i % RATE == 0 )
+        return c & 1 ? -1. : 1. - 1. / 128;
+    return .5 * saw + noise;
+}
+
+static void Encode( uint8_t *p, vlc_fourcc_t i_format, size_t i, double v )
+{
+    switch( i_format )
+    {
+        case VLC_CODEC_U8:
+            p[i] = 128 + (int)(v * 127.);
+            break;
+        case VLC_CODEC_S16N:
+            ((int16_t *)p)[i] = v * 32767.;
+            break;
+        case VLC_CODEC_S32N:
+            ((int32_t *)p)[i] = v * 2147483647.;
+            break;
+        case VLC_CODEC_FL32:
+            ((float *)p)[i] = v;
+            break;
+        case VLC_CODEC_FL64:
+            ((double *)p)[i] = v;
+            break;
+        default:
+            vlc_assert_unreachable();
+    }
+}
+
+/*****************************************************************************
+ * Harness
+ *****************************************************************************/
+struct dsp_run
+{
+    unsigned i_allocs;
+    uint64_t i_hash;
+    double   f_energy;
+    double   f_corr;
+    size_t   i_samples;
+    uint32_t i_seed;
+};
+
+static block_t *CountBuffer( filter_t *p_filter, size_t i_size )
+{
+    struct dsp_run *p_run = p_filter->owner.sys;
+
+    p_run->i_allocs++;
+    return block_Alloc( i_size );
+}
+
+static bool IsFloat( vlc_fourcc_t i_format )
+{
+    return i_format == VLC_CODEC_FL32 || i_format == VLC_CODEC_FL64;
+}
+
+/* FNV-1a */
+static void Hash( uint64_t *p_hash, const uint8_t *p, size_t i_size )
+{
+    for( size_t i = 0; i < i_size; i++ )
+        *p_hash = (*p_hash ^ p[i]) * UINT64_C(0x100000001b3);
+}
+
+/**
+ * Accumulates the energy of floating point output, and its product with a
+ * noise of -1 and +1. Rounding errors only move them by about the error to
+ * signal ratio, whereas any other change of the output moves the correlation
+ * by a lot more.
+ */
+static void Correlate( struct dsp_run *p_run, vlc_fourcc_t i_format,
+                       const block_t *p_block )
+{
+    const size_t i_samples = p_block->i_buffer
+                           / (aout_BitsPerSample( i_format ) / 8);
+
+    for( size_t i = 0; i < i_samples; i++ )
+    {
+        const double v = i_format == VLC_CODEC_FL32
+                       ? ((const float *)p_block->p_buffer)[i]
+                       : ((const double *)p_block->p_buffer)[i];
+
+        p_run->i_seed = p_run->i_seed * 214013 + 2531011;
+        p_run->f_energy += v * v;
+        p_run->f_corr += (p_run->i_seed >> 31) ? -v : v;
+    }
+    p_run->i_samples += i_samples;
+}
+
+static void Measure( struct dsp_run *p_run, vlc_fourcc_t i_format,
+                     const block_t *p_block )
+{
+    if( IsFloat( i_format ) )
+        Correlate( p_run, i_format, p_block );
+    else
+        Hash( &p_run->i_hash, p_block->p_buffer, p_block->i_buffer );
+}
+
+static void InitFormat( audio_format_t *p_fmt, vlc_fourcc_t i_format,
+                        uint16_t i_chans, uint32_t i_orig, unsigned i_rate )
+{
+    memset( p_fmt, 0, sizeof (*p_fmt) );
+    p_fmt->i_format = i_format;
+    p_fmt->i_rate = i_rate;
+    p_fmt->i_physical_channels = i_chans;
+    p_fmt->i_original_channels = i_orig ? i_orig : i_chans;
+    aout_FormatPrepare( p_fmt );
+}
+
+static block_t *NewInput( vlc_fourcc_t i_format, unsigned i_nch,
+                          uint32_t *p_seed, uint64_t i_frame )
+{
+    const unsigned i_bytes = aout_BitsPerSample( i_format ) / 8;
+    block_t *p_block = block_Alloc( FRAMES * i_nch * i_bytes );
+    assert( p_block );
+
+    for( unsigned i = 0; i < FRAMES; i++ )
+        for( unsigned c = 0; c < i_nch; c++ )
+            Encode( p_block->p_buffer, i_format, i * i_nch + c,
+                    Signal( p_seed, i_frame + i, c ) );
+    p_block->i_nb_samples = FRAMES;
+    p_block->i_pts = p_block->i_dts = VLC_TS_0 + i_frame * CLOCK_FREQ / RATE;
+    p_block->i_length = FRAMES * CLOCK_FREQ / RATE;
+    return p_block;
+}
+
+/**
+ * Runs a filter, converter or resampler. Returns false if the module is not
+ * available in this build.
+ */
+static bool RunFilter( libvlc_int_t *p_libvlc, const struct dsp_case *p_case,
+                       unsigned i_blocks, struct dsp_run *p_run,
+                       mtime_t *pi_time )
+{
+    filter_t *p_filter = vlc_object_create( p_libvlc, sizeof(*p_filter) );
+    assert( p_filter );
+
+    es_format_Init( &p_filter->fmt_in, AUDIO_ES, p_case->i_in_format );
+    InitFormat( &p_filter->fmt_in.audio, p_case->i_in_format,
+                p_case->i_in_chans, p_case->i_in_orig, RATE );
+    const vlc_fourcc_t i_out_format = p_case->i_out_format
+                                    ? p_case->i_out_format
+                                    : p_case->i_in_format;
+    es_format_Init( &p_filter->fmt_out, AUDIO_ES, i_out_format );
+    InitFormat( &p_filter->fmt_out.audio, i_out_format,
+                p_case->i_out_chans ? p_case->i_out_chans
+                                    : p_case->i_in_chans,
+                p_case->i_out_chans ? p_case->i_out_orig
+                                    : p_case->i_in_orig,
+                p_case->i_out_rate ? p_case->i_out_rate : RATE );
+    p_filter->owner.sys = p_run;
+    p_filter->owner.audio.buffer_new = CountBuffer;
+
+    p_filter->p_module = module_need( p_filter, p_case->psz_cap,
+                                      p_case->psz_name, true );
+    if( p_filter->p_module == NULL )
+    {
+        vlc_object_release( p_filter );
+        return false;
+    }
+    /* Filters pick their input format, the pipeline converts to it */
+    assert( p_filter->fmt_in.audio.i_format == p_case->i_in_format );
+
+    const unsigned i_nch = aout_FormatNbChannels( &p_filter->fmt_in.audio );
+    uint32_t i_seed = 0;
+    mtime_t i_time = 0;
+
+    for( unsigned k = 0; k < i_blocks; k++ )
+    {
+        block_t *p_block = NewInput( p_case->i_in_format, i_nch, &i_seed,
+                                     (uint64_t)k * FRAMES );
+
+        mtime_t i_start = mdate();
+        p_block = p_filter->pf_audio_filter( p_filter, p_block );
+        i_time += mdate() - i_start;
+
+        if( p_block == NULL )
+            continue;
+        if( k < HASHED_BLOCKS )
+            Measure( p_run, p_filter->fmt_out.audio.i_format, p_block );
+        block_Release( p_block );
+    }
+    *pi_time = i_time;
+
+    module_unneed( p_filter, p_filter->p_module );
+    es_format_Clean( &p_filter->fmt_in );
+    es_format_Clean( &p_filter->fmt_out );
+    vlc_object_release( p_filter );
+    return true;
+}
+
+/**
+ * Runs a volume module, amplifying in place by -6 dB.
+ */
+static bool RunVolume( libvlc_int_t *p_libvlc, const struct dsp_case *p_case,
+                       unsigned i_blocks, struct dsp_run *p_run,
+                       mtime_t *pi_time )
+{
+    audio_volume_t *p_volume = vlc_object_create( p_libvlc,
+                                                  sizeof(*p_volume) );
+    assert( p_volume );
+    p_volume->format = p_case->i_in_format;
+
+    module_t *p_module = module_need( p_volume, "audio volume",
+                                      p_case->psz_name, true );
+    if( p_module == NULL )
+    {
+        vlc_object_release( p_volume );
+        return false;
+    }
+
+    const unsigned i_nch = popcount( p_case->i_in_chans );
+    uint32_t i_seed = 0;
+    mtime_t i_time = 0;
+
+    for( unsigned k = 0; k < i_blocks; k++ )
+    {
+        block_t *p_block = NewInput( p_case->i_in_format, i_nch, &i_seed,
+                                     (uint64_t)k * FRAMES );
+
+        mtime_t i_start = mdate();
+        p_volume->amplify( p_volume, p_block, .5f );
+        i_time += mdate() - i_start;
+
+        if( k < HASHED_BLOCKS )
+            Measure( p_run, p_case->i_in_format, p_block );
+        block_Release( p_block );
+    }
+    *pi_time = i_time;
+
+    module_unneed( p_volume, p_module );
+    vlc_object_release( p_volume );
+    return true;
+}
+
+static const char *Layout( uint16_t i_chans )
+{
+    switch( i_chans )
+    {
+        case MONO:   return "mono";
+        case STEREO: return "stereo";
+        case CH5_1:  return "5.1";
+        case CH7_1:  return "7.1";
+        default:     return "?";
+    }
+}
+
+int main( int argc, char *argv[] )
+{
+    /* Non-default settings, so that the filters do not pass through */
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+        "--equalizer-bands=8 5 -6 -8 -3 4 9 11 11 11", "--gain-value=0.7",
+        "--param-eq-lowgain=6", "--param-eq-gain2=-6",
+        "--param-eq-highgain=3",
+    };
+    unsigned i_failures = 0;
+
+    for( int i = 1; i < argc; i++ )
+    {
+        if( !strcmp( argv[i], "-b" ) )
+            i_bench_seconds = 20;
+        else if( !strcmp( argv[i], "-r" ) )
+            b_list_refs = true;
+    }
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv), ppsz_argv );
+    assert( p_vlc );
+
+    const unsigned i_blocks = __MAX( HASHED_BLOCKS,
+                                     i_bench_seconds * RATE / FRAMES );
+
+    for( size_t i = 0; i < ARRAY_SIZE(cases); i++ )
+    {
+        const struct dsp_case *p_case = &cases[i];
+        struct dsp_run run = { .i_allocs = 0,
+                               .i_hash = UINT64_C(0xcbf29ce484222325) };
+        mtime_t i_time;
+        bool b_found;
+
+        if( !strcmp( p_case->psz_cap, "audio volume" ) )
+            b_found = RunVolume( p_vlc->p_libvlc_int, p_case, i_blocks,
+                                 &run, &i_time );
+        else
+            b_found = RunFilter( p_vlc->p_libvlc_int, p_case, i_blocks,
+                                 &run, &i_time );
+
+        char psz_desc[64];
+        snprintf( psz_desc, sizeof (psz_desc), "%4.4s %-6s -> %4.4s %-6s",
+                  (const char *)&p_case->i_in_format,
+                  Layout( p_case->i_in_chans ),
+                  (const char *)(p_case->i_out_format ? &p_case->i_out_format
+                                                      : &p_case->i_in_format),
+                  Layout( p_case->i_out_chans ? p_case->i_out_chans
+                                              : p_case->i_in_chans ) );
+
+        if( !b_found )
+        {
+            /* Some modules depend on optional libraries */
+            printf( "%-24s %s: not available\n", p_case->psz_name, psz_desc );
+            continue;
+        }
+
+        /* Level and correlation with the noise, the latter normalized so
+         * that a relative error of the output moves it as much */
+        const double f_level = sqrt( run.f_energy / __MAX(run.i_samples, 1) );
+        const double f_corr = run.f_energy > 0.
+                            ? run.f_corr / sqrt( run.f_energy ) : 0.;
+        const bool b_float = IsFloat( p_case->i_out_format
+                                      ? p_case->i_out_format
+                                      : p_case->i_in_format );
+
+        if( b_list_refs )
+        {
+            if( b_float )
+                printf( "%-24s %s: SIGNATURE( %.9g, %.9g )\n",
+                        p_case->psz_name, psz_desc, f_level, f_corr );
+            else
+                printf( "%-24s %s: HASH( 0x%016"PRIx64" )\n",
+                        p_case->psz_name, psz_desc, run.i_hash );
+            continue;
+        }
+
+        const char *psz_check = "not checked";
+        if( b_float && p_case->f_level != 0. )
+        {
+            if( fabs( f_level - p_case->f_level )
+                    <= FLOAT_TOLERANCE * p_case->f_level
+             && fabs( f_corr - p_case->f_corr ) <= FLOAT_TOLERANCE )
+                psz_check = "within tolerance";
+            else
+            {
+                printf( "%-24s %s: level %.9g, correlation %.9g\n",
+                        p_case->psz_name, psz_desc, f_level, f_corr );
+                psz_check = "MISMATCH";
+                i_failures++;
+            }
+        }
+#ifdef HAVE_HASHES
+        if( !b_float && !p_case->b_cpu && p_case->i_hash != 0 )
+        {
+            if( run.i_hash == p_case->i_hash )
+                psz_check = "bit-exact";
+            else
+            {
+                psz_check = "MISMATCH";
+                i_failures++;
+            }
+        }
+#endif
+        printf( "%-24s %s: %7.2f ns/sample, %.2f allocs/block, %s\n",
+                p_case->psz_name, psz_desc,
+                i_time * 1000. / ((double)i_blocks * FRAMES),
+                run.i_allocs / (double)i_blocks, psz_check );
+    }
+
+    libvlc_release( p_vlc );
+    assert( i_failures == 0 );
+    return 0;
+}
@@ -0,0 +1,272 @@
+/*****************************************************************************
+ * loudness.c: EBU R128 loudness filter test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The meter is checked against signals of the EBU Tech 3341 and 3342
+ * conformance tests, and the normalizer against its own meter.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+#include <vlc_filter.h>
+
+#include "common.h"
+
+#define RATE 48000
+#define FRAMES (RATE / 100)
+#define FREQ 997.
+
+/* The filter publishes its measures on its parent: each filter gets its own
+ * parent, which also holds its settings */
+static filter_t *CreateLoudness( libvlc_int_t *p_libvlc, uint16_t i_chans,
+                                 bool b_normalize, float f_target )
+{
+    vlc_object_t *p_parent = vlc_object_create( p_libvlc,
+                                                sizeof (*p_parent) );
+    assert( p_parent );
+    var_Create( p_parent, "loudness-normalize", VLC_VAR_BOOL );
+    var_SetBool( p_parent, "loudness-normalize", b_normalize );
+    var_Create( p_parent, "loudness-target", VLC_VAR_FLOAT );
+    var_SetFloat( p_parent, "loudness-target", f_target );
+
+    filter_t *p_filter = CreateAudioFilter( p_parent, "audio filter",
+                                            "loudness", i_chans, RATE, RATE );
+    assert( p_filter );
+    return p_filter;
+}
+
+static void DeleteLoudness( filter_t *p_filter )
+{
+    vlc_object_t *p_parent = p_filter->obj.parent;
+
+    DeleteAudioFilter( p_filter );
+    vlc_object_release( p_parent );
+}
+
+static float Measure( filter_t *p_filter, const char *psz_name )
+{
+    return var_GetFloat( p_filter->obj.parent, psz_name );
+}
+
+/**
+ * Fills i_frames of the selected channels with a sine of peak level f_db,
+ * starting at the frame i_start.
+ */
+static void Sine( float *p, size_t i_start, size_t i_frames, unsigned i_nch,
+                  uint32_t i_mask, float f_db, double f_freq, double f_phase )
+{
+    const double a = pow( 10., f_db / 20. ), w = 2. * M_PI * f_freq / RATE;
+
+    for( size_t i = i_start; i < i_start + i_frames; i++ )
+        for( unsigned c = 0; c < i_nch; c++ )
+            p[i_nch * i + c] = (i_mask >> c) & 1 ? a * sin( w * i + f_phase )
+                                                 : 0.f;
+}
+
+/**
+ * Filters i_frames of audio in blocks of 10 ms. The output is as long as the
+ * input. It is copied to p_out if not NULL.
+ */
+static mtime_t Run( filter_t *p_filter, const float *p_in, float *p_out,
+                    size_t i_frames )
+{
+    const unsigned i_nch = p_filter->fmt_in.audio.i_channels;
+    size_t i_out;
+    mtime_t i_time;
+
+    float *p = RunAudioFilter( p_filter, p_in, i_frames, FRAMES, false,
+                               NULL, NULL, &i_out, &i_time );
+    assert( i_out == i_frames );
+    if( p_out != NULL )
+        memcpy( p_out, p, i_frames * i_nch * sizeof (float) );
+    free( p );
+    return i_time;
+}
+
+/*****************************************************************************
+ * Meter
+ *****************************************************************************/
+static void test_Meter( libvlc_int_t *p_libvlc )
+{
+    const size_t i_frames = 40 * RATE;
+    float *p_in = malloc( i_frames * 6 * sizeof (float) );
+    assert( p_in );
+
+    /* Tech 3341 cases 1 and 2: steady sines */
+    static const float levels[] = { -23.f, -33.f };
+    for( size_t i = 0; i < ARRAY_SIZE(levels); i++ )
+    {
+        filter_t *p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO,
+                                             false, -23.f );
+        Sine( p_in, 0, 20 * RATE, 2, 3, levels[i], 1000., 0. );
+        Run( p_filter, p_in, NULL, 20 * RATE );
+        assert( fabsf( Measure( p_filter, "loudness-momentary" ) - levels[i] )
+                < .1f );
+        assert( fabsf( Measure( p_filter, "loudness-short-term" )
+                       - levels[i] ) < .1f );
+        assert( fabsf( Measure( p_filter, "loudness-integrated" )
+                       - levels[i] ) < .1f );
+        DeleteLoudness( p_filter );
+    }
+
+    /* Tech 3341 case 3: the quiet parts are under the relative gate */
+    filter_t *p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO,
+                                         false, -23.f );
+    Sine( p_in, 0, 10 * RATE, 2, 3, -36.f, 1000., 0. );
+    Sine( p_in, 10 * RATE, 20 * RATE, 2, 3, -23.f, 1000., 0. );
+    Sine( p_in, 30 * RATE, 10 * RATE, 2, 3, -36.f, 1000., 0. );
+    Run( p_filter, p_in, NULL, i_frames );
+    printf( "loudness gated integrated: %.2f LUFS\n",
+            Measure( p_filter, "loudness-integrated" ) );
+    assert( fabsf( Measure( p_filter, "loudness-integrated" ) + 23.f )
+            < .1f );
+    DeleteLoudness( p_filter );
+
+    /* Tech 3342 case 1: loudness range */
+    p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, false, -23.f );
+    Sine( p_in, 0, 20 * RATE, 2, 3, -20.f, 1000., 0. );
+    Sine( p_in, 20 * RATE, 20 * RATE, 2, 3, -30.f, 1000., 0. );
+    Run( p_filter, p_in, NULL, i_frames );
+    printf( "loudness range: %.2f LU\n",
+            Measure( p_filter, "loudness-range" ) );
+    assert( fabsf( Measure( p_filter, "loudness-range" ) - 10.f ) < 1.f );
+    DeleteLoudness( p_filter );
+
+    /* A quarter of the rate, with the peaks between the samples, 3 dB over
+     * the sample peak */
+    p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, false, -23.f );
+    Sine( p_in, 0, RATE, 2, 3, -6.f, RATE / 4, M_PI_4 );
+    Run( p_filter, p_in, NULL, RATE );
+    printf( "loudness true peak: %.2f dBTP\n",
+            Measure( p_filter, "loudness-true-peak" ) );
+    assert( fabsf( Measure( p_filter, "loudness-true-peak" ) + 6.f ) < .5f );
+    DeleteLoudness( p_filter );
+
+    /* Channel weights: the front channels count as one, the surround ones
+     * as 1.41, and the LFE not at all */
+    static const float weights[] = { 0.f, 0.f, 1.5f, 1.5f, 0.f, -HUGE_VALF };
+    for( unsigned c = 0; c < 6; c++ )
+    {
+        p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_5_1, false, -23.f );
+        Sine( p_in, 0, 5 * RATE, 6, 1 << c, -20.f, 1000., 0. );
+        Run( p_filter, p_in, NULL, 5 * RATE );
+        float f_loudness = Measure( p_filter, "loudness-integrated" );
+        if( isinf( weights[c] ) )
+            assert( f_loudness < -70.f );
+        else
+            assert( fabsf( f_loudness - (-23.f + weights[c]) ) < .1f );
+        DeleteLoudness( p_filter );
+    }
+
+    free( p_in );
+}
+
+/*****************************************************************************
+ * Normalizer and limiter
+ *****************************************************************************/
+static void test_Normalize( libvlc_int_t *p_libvlc )
+{
+    const size_t i_frames = 20 * RATE;
+    float *p_in = malloc( i_frames * 2 * sizeof (float) );
+    float *p_out = malloc( i_frames * 2 * sizeof (float) );
+    assert( p_in && p_out );
+
+    /* A quiet sine is brought to the target, once the normalizer has
+     * settled */
+    filter_t *p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, true,
+                                         -23.f );
+    filter_t *p_meter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, false,
+                                        -23.f );
+    Sine( p_in, 0, i_frames, 2, 3, -33.f, FREQ, 0. );
+    Run( p_filter, p_in, p_out, i_frames );
+    Run( p_meter, &p_out[2 * 5 * RATE], NULL, i_frames - 5 * RATE );
+    printf( "loudness normalized: %.2f LUFS, gain %.2f dB\n",
+            Measure( p_meter, "loudness-integrated" ),
+            Measure( p_filter, "loudness-gain" ) );
+    assert( fabsf( Measure( p_meter, "loudness-integrated" ) + 23.f )
+            < .2f );
+    assert( fabsf( Measure( p_filter, "loudness-gain" ) - 10.f ) < .2f );
+
+    /* The delayed frames come out when draining */
+    block_t *p_block = filter_DrainAudio( p_filter );
+    assert( p_block && p_block->i_nb_samples == RATE / 200 - 1 );
+    assert( p_block->i_pts == VLC_TS_0 + (mtime_t)i_frames * CLOCK_FREQ
+                                         / RATE );
+    block_Release( p_block );
+    DeleteLoudness( p_meter );
+    DeleteLoudness( p_filter );
+
+    /* The maximum gain brings a loud sine over the ceiling, and the limiter
+     * keeps it under */
+    p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, true, 0.f );
+    p_meter = CreateLoudness( p_libvlc, AOUT_CHANS_STEREO, false, -23.f );
+    Sine( p_in, 0, i_frames, 2, 3, -12.f, FREQ, 0. );
+    Sine( p_in, RATE, RATE / 2, 2, 3, -6.f, FREQ * 4, 0. );
+    Run( p_filter, p_in, p_out, i_frames );
+    Run( p_meter, p_out, NULL, i_frames );
+    printf( "loudness limited: %.2f dBTP\n",
+            Measure( p_meter, "loudness-true-peak" ) );
+    assert( Measure( p_meter, "loudness-true-peak" ) < -.9f );
+    DeleteLoudness( p_meter );
+    DeleteLoudness( p_filter );
+
+    free( p_out );
+    free( p_in );
+}
+
+/*****************************************************************************
+ * Cost of the normalization of 5.1 audio
+ *****************************************************************************/
+void test_Benchmark( libvlc_int_t *p_libvlc, unsigned i_seconds )
+{
+    const size_t i_frames = RATE * i_seconds;
+    float *p_in = malloc( i_frames * 6 * sizeof (float) );
+    assert( p_in );
+
+    for( size_t i = 0; i < i_frames * 6; i++ )
+        p_in[i] = (rand() / (float)RAND_MAX - .5f) * .1f;
+
+    filter_t *p_filter = CreateLoudness( p_libvlc, AOUT_CHANS_5_1, true,
+                                         -23.f );
+    mtime_t i_time = Run( p_filter, p_in, NULL, i_frames );
+    DeleteLoudness( p_filter );
+
+    printf( "loudness 5.1 normalization: %5.2f %% CPU\n",
+            100. * i_time / (CLOCK_FREQ * i_seconds) );
+    free( p_in );
+}
+
+void test_Main( libvlc_int_t *p_libvlc )
+{
+    test_Meter( p_libvlc );
+    test_Normalize( p_libvlc );
+}
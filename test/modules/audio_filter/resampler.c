@@ -0,0 +1,301 @@
+/*****************************************************************************
+ * resampler.c: audio resamplers quality test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+
+#include "common.h"
+
+#define AMPLITUDE .5
+
+/**
+ * Generates i_frames of a stereo sine of normalized frequency w. The right
+ * channel is a cosine.
+ */
+static float *Sine( double w, size_t i_frames )
+{
+    float *p = malloc( i_frames * 2 * sizeof (float) );
+    assert( p );
+
+    for( size_t i = 0; i < i_frames; i++ )
+    {
+        p[2 * i] = AMPLITUDE * sin( w * i );
+        p[2 * i + 1] = AMPLITUDE * cos( w * i );
+    }
+    return p;
+}
+
+typedef struct
+{
+    const int *pi_adjust;
+    unsigned   i_adjusts;
+} drift_t;
+
+/* Adjusts the input rate of each period in turn, as the audio output drift
+ * correction does */
+static void Drift( filter_t *p_filter, size_t i_block, void *p_opaque )
+{
+    const drift_t *p_drift = p_opaque;
+
+    p_filter->fmt_in.audio.i_rate +=
+        p_drift->pi_adjust[i_block % p_drift->i_adjusts];
+}
+
+/**
+ * Resamples i_frames of a sine in periods of i_period frames. pi_adjust
+ * gives the input rate adjustment of each period, in turn.
+ */
+static float *Run( filter_t *p_filter, double f_freq, size_t i_frames,
+                   unsigned i_period, const int *pi_adjust,
+                   unsigned i_adjusts, size_t *pi_out, mtime_t *pi_time )
+{
+    const double w = 2. * M_PI * f_freq / p_filter->fmt_in.audio.i_rate;
+    drift_t drift = { pi_adjust, i_adjusts };
+    float *p_in = Sine( w, i_frames );
+
+    float *p_out = RunAudioFilter( p_filter, p_in, i_frames, i_period, true,
+                                   i_adjusts ? Drift : NULL, &drift,
+                                   pi_out, pi_time );
+    free( p_in );
+    return p_out;
+}
+
+/**
+ * Measures the THD+N of the left channel: the ratio of the residual to the
+ * sine of normalized frequency w fitted by least squares, in dB. The start and
+ * the end of the output, where the filters settle, are skipped.
+ */
+static double Thdn( const float *p_out, size_t i_count, double w )
+{
+    const size_t i_start = i_count / 8, i_end = i_count - i_count / 8;
+    /* Normal equations of x = a sin + b cos + c */
+    double m[3][3] = { { 0 } }, v[3] = { 0 };
+
+    for( size_t i = i_start; i < i_end; i++ )
+    {
+        const double s[3] = { sin( w * i ), cos( w * i ), 1. };
+        for( int r = 0; r < 3; r++ )
+        {
+            for( int c = 0; c < 3; c++ )
+                m[r][c] += s[r] * s[c];
+            v[r] += s[r] * p_out[2 * i];
+        }
+    }
+
+    /* Cramer's rule */
+    const double det = m[0][0] * (m[1][1] * m[2][2] - m[1][2] * m[2][1])
+                     - m[0][1] * (m[1][0] * m[2][2] - m[1][2] * m[2][0])
+                     + m[0][2] * (m[1][0] * m[2][1] - m[1][1] * m[2][0]);
+    double x[3];
+    for( int k = 0; k < 3; k++ )
+    {
+        double t[3][3];
+        memcpy( t, m, sizeof (t) );
+        for( int r = 0; r < 3; r++ )
+            t[r][k] = v[r];
+        x[k] = (t[0][0] * (t[1][1] * t[2][2] - t[1][2] * t[2][1])
+              - t[0][1] * (t[1][0] * t[2][2] - t[1][2] * t[2][0])
+              + t[0][2] * (t[1][0] * t[2][1] - t[1][1] * t[2][0])) / det;
+    }
+
+    double f_signal = 0., f_noise = 0.;
+    for( size_t i = i_start; i < i_end; i++ )
+    {
+        const double fit = x[0] * sin( w * i ) + x[1] * cos( w * i ) + x[2];
+        f_signal += fit * fit;
+        f_noise += (p_out[2 * i] - fit) * (p_out[2 * i] - fit);
+    }
+    return 10. * log10( f_noise / f_signal );
+}
+
+static double Measure( libvlc_int_t *p_libvlc, const char *psz_cap,
+                       const char *psz_name, unsigned i_in_rate,
+                       unsigned i_out_rate, double f_freq,
+                       const int *pi_adjust, unsigned i_adjusts )
+{
+    filter_t *p_filter = CreateAudioFilter( VLC_OBJECT(p_libvlc), psz_cap,
+                                            psz_name, AOUT_CHANS_STEREO,
+                                            i_in_rate, i_out_rate );
+    if( p_filter == NULL )
+        return NAN;
+
+    size_t i_out;
+    float *p_out = Run( p_filter, f_freq, i_in_rate / 2, i_in_rate / 200,
+                        pi_adjust, i_adjusts, &i_out, NULL );
+    DeleteAudioFilter( p_filter );
+
+    /* The input sine appears sped up by the rate adjustment */
+    const double f_rate = i_in_rate + (i_adjusts ? pi_adjust[0] : 0);
+    const double w = 2. * M_PI * f_freq * f_rate / i_in_rate / i_out_rate;
+
+    /* No more than a few periods of silence may be output in total */
+    assert( i_out > (uint64_t)i_out_rate * 4 / 10 );
+    double f_thdn = Thdn( p_out, i_out, w );
+    free( p_out );
+    return f_thdn;
+}
+
+/*****************************************************************************
+ * Quality of the polyphase resampler
+ *****************************************************************************/
+static const unsigned rates[][2] = {
+    { 44100, 48000 }, { 48000, 44100 }, { 48000, 96000 }, { 96000, 48000 },
+    { 22050, 48000 }, { 48000, 32000 }, { 44100, 192000 }, { 8000, 44100 },
+};
+
+static void test_Quality( libvlc_int_t *p_libvlc )
+{
+    for( size_t i = 0; i < ARRAY_SIZE(rates); i++ )
+    {
+        const unsigned i_min = __MIN(rates[i][0], rates[i][1]);
+        const double freqs[] = { 997., i_min * .2, i_min * .35 };
+
+        for( size_t j = 0; j < ARRAY_SIZE(freqs); j++ )
+        {
+            double f_thdn = Measure( p_libvlc, "audio converter", "polyphase",
+                                     rates[i][0], rates[i][1], freqs[j],
+                                     NULL, 0 );
+            printf( "polyphase %6u -> %6u Hz, %7.1f Hz: THD+N %6.1f dB\n",
+                    rates[i][0], rates[i][1], freqs[j], f_thdn );
+            assert( f_thdn < -80. );
+        }
+    }
+}
+
+/*****************************************************************************
+ * Drift correction of the polyphase resampler
+ *****************************************************************************/
+static void test_Drift( libvlc_int_t *p_libvlc )
+{
+    static const int adjusts[] = { 3, -3, 20, -41 };
+
+    /* Constant adjustments */
+    for( size_t i = 0; i < ARRAY_SIZE(adjusts); i++ )
+        for( unsigned i_out_rate = 44100; i_out_rate <= 48000;
+             i_out_rate += 3900 )
+        {
+            double f_thdn = Measure( p_libvlc, "audio resampler", "polyphase",
+                                     48000, i_out_rate, 997.,
+                                     &adjusts[i], 1 );
+            printf( "polyphase  48000 -> %6u Hz, %+3d Hz drift: "
+                    "THD+N %6.1f dB\n", i_out_rate, adjusts[i], f_thdn );
+            assert( f_thdn < -80. );
+        }
+
+    /* Switching between exact and interpolated phases must be seamless:
+     * check that the second difference stays within the one of the sine. */
+    static const int steps[] = { 0, 5, 0, -5, -5, 0 };
+    const unsigned pairs[][2] = { { 48000, 48000 }, { 44100, 48000 } };
+    const double f_freq = 997.;
+
+    for( size_t i = 0; i < ARRAY_SIZE(pairs); i++ )
+    {
+        filter_t *p_filter = CreateAudioFilter( VLC_OBJECT(p_libvlc),
+                                                "audio resampler", "polyphase",
+                                                AOUT_CHANS_STEREO,
+                                                pairs[i][0], pairs[i][1] );
+        assert( p_filter );
+
+        size_t i_out;
+        float *p_out = Run( p_filter, f_freq, pairs[i][0], 240, steps,
+                            ARRAY_SIZE(steps), &i_out, NULL );
+        DeleteAudioFilter( p_filter );
+
+        const double w = 2. * M_PI * f_freq * 1.001 / pairs[i][1];
+        const double f_max = AMPLITUDE * w * w * 1.05;
+        double f_worst = 0.;
+
+        for( size_t j = i_out / 8; j + 1 < i_out - i_out / 8; j++ )
+        {
+            double d = fabs( p_out[2 * (j + 1)] - 2. * p_out[2 * j]
+                             + p_out[2 * (j - 1)] );
+            if( d > f_worst )
+                f_worst = d;
+        }
+        printf( "polyphase %6u -> %6u Hz, varying drift: "
+                "second difference %.5f (sine %.5f)\n",
+                pairs[i][0], pairs[i][1], f_worst, AMPLITUDE * w * w );
+        assert( f_worst < f_max );
+        free( p_out );
+    }
+}
+
+/*****************************************************************************
+ * Comparison and benchmark of every resampler
+ *****************************************************************************/
+void test_Benchmark( libvlc_int_t *p_libvlc, unsigned i_seconds )
+{
+    size_t i_modules;
+    module_t **pp_modules = module_list_get( &i_modules );
+
+    for( size_t m = 0; m < i_modules; m++ )
+    {
+        if( !module_provides( pp_modules[m], "audio resampler" ) )
+            continue;
+
+        const char *psz_name = module_get_object( pp_modules[m] );
+
+        for( size_t i = 0; i < 2; i++ )
+        {
+            filter_t *p_filter = CreateAudioFilter( VLC_OBJECT(p_libvlc),
+                                                    "audio resampler",
+                                                    psz_name, AOUT_CHANS_STEREO,
+                                                    rates[i][0], rates[i][1] );
+            if( p_filter == NULL )
+                continue;
+
+            size_t i_out;
+            mtime_t i_time;
+            float *p_out = Run( p_filter, 997.,
+                                rates[i][0] * i_seconds,
+                                rates[i][0] / 200, NULL, 0, &i_out,
+                                &i_time );
+            DeleteAudioFilter( p_filter );
+            free( p_out );
+
+            double f_thdn = Measure( p_libvlc, "audio resampler", psz_name,
+                                     rates[i][0], rates[i][1],
+                                     rates[i][0] * .2, NULL, 0 );
+            printf( "%-12s %6u -> %6u Hz stereo: %6"PRId64" us/s, "
+                    "THD+N %6.1f dB\n", psz_name, rates[i][0], rates[i][1],
+                    i_time / i_seconds, f_thdn );
+        }
+    }
+    module_list_free( pp_modules );
+}
+
+void test_Main( libvlc_int_t *p_libvlc )
+{
+    test_Quality( p_libvlc );
+    test_Drift( p_libvlc );
+}
@@ -0,0 +1,194 @@
+/*****************************************************************************
+ * scaletempo.c: audio tempo scaler quality test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_filter.h>
+
+#include "common.h"
+
+#define AMPLITUDE .5
+#define RATE 48000
+#define FREQ 441.
+/* Analysis window, as long as a stride by default */
+#define WINDOW (RATE * 3 / 100)
+
+static filter_t *CreateScaletempo( libvlc_int_t *p_libvlc, uint16_t i_chans )
+{
+    filter_t *p_filter = CreateAudioFilter( VLC_OBJECT(p_libvlc),
+                                            "audio filter", "scaletempo",
+                                            i_chans, RATE, RATE );
+    assert( p_filter );
+    return p_filter;
+}
+
+/**
+ * Plays i_frames of a sine at f_rate times the normal speed, in periods of
+ * 10 ms. Each channel is shifted by a quarter of a period from the previous.
+ */
+static float *Run( filter_t *p_filter, double f_rate, size_t i_frames,
+                   size_t *pi_out, mtime_t *pi_time )
+{
+    const unsigned i_nch = p_filter->fmt_in.audio.i_channels;
+    const double w = 2. * M_PI * FREQ / RATE;
+
+    float *p_in = malloc( i_frames * i_nch * sizeof (float) );
+    assert( p_in );
+    for( size_t i = 0; i < i_frames; i++ )
+        for( unsigned c = 0; c < i_nch; c++ )
+            p_in[i_nch * i + c] = AMPLITUDE * sin( w * i + c * M_PI_2 );
+
+    /* The audio output signals the playback rate through the input rate */
+    p_filter->fmt_in.audio.i_rate = lround( RATE * f_rate );
+    float *p_out = RunAudioFilter( p_filter, p_in, i_frames, RATE / 100,
+                                   false, NULL, NULL, pi_out, pi_time );
+    p_filter->fmt_in.audio.i_rate = RATE;
+
+    free( p_in );
+    return p_out;
+}
+
+/**
+ * Fits a sine of normalized frequency w to i_count frames of one channel by
+ * least squares. Returns the ratio of the residual to the sine in dB, and the
+ * phase of the sine.
+ */
+static double Fit( const float *p_out, size_t i_count, unsigned i_nch,
+                   unsigned i_ch, double w, double *pf_phase )
+{
+    double ss = 0., sc = 0., cc = 0., xs = 0., xc = 0.;
+
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        const double s = sin( w * i ), c = cos( w * i );
+        const double x = p_out[i_nch * i + i_ch];
+        ss += s * s; sc += s * c; cc += c * c;
+        xs += x * s; xc += x * c;
+    }
+
+    const double det = ss * cc - sc * sc;
+    const double a = (xs * cc - xc * sc) / det;
+    const double b = (xc * ss - xs * sc) / det;
+
+    double f_signal = 0., f_noise = 0.;
+    for( size_t i = 0; i < i_count; i++ )
+    {
+        const double fit = a * sin( w * i ) + b * cos( w * i );
+        const double x = p_out[i_nch * i + i_ch];
+        f_signal += fit * fit;
+        f_noise += (x - fit) * (x - fit);
+    }
+    *pf_phase = atan2( b, a );
+    return 10. * log10( f_noise / f_signal );
+}
+
+static const double rates[] = { .5, .75, 1.25, 1.5, 2., 3., 4. };
+
+/*****************************************************************************
+ * Pitch, duration and inter-channel phase of the tempo scaled output
+ *****************************************************************************/
+void test_Main( libvlc_int_t *p_libvlc )
+{
+    static const uint16_t chans[] = { AOUT_CHANS_STEREO, AOUT_CHANS_5_1 };
+    const double w = 2. * M_PI * FREQ / RATE;
+
+    for( size_t k = 0; k < ARRAY_SIZE(chans); k++ )
+        for( size_t i = 0; i < ARRAY_SIZE(rates); i++ )
+        {
+            filter_t *p_filter = CreateScaletempo( p_libvlc, chans[k] );
+            const unsigned i_nch = p_filter->fmt_in.audio.i_channels;
+
+            size_t i_out;
+            float *p_out = Run( p_filter, rates[i], 4 * RATE, &i_out, NULL );
+            DeleteAudioFilter( p_filter );
+
+            /* The duration is scaled, give or take the queued strides */
+            const double f_expected = 4. * RATE / rates[i];
+            assert( fabs( i_out - f_expected ) < RATE / 5 );
+
+            /* The pitch is kept within each stride, and so is the phase
+             * between channels since they are all shifted by the same
+             * offset. The phase itself drifts with the rounding of the
+             * offsets to whole frames, so the sine is fitted piecewise. */
+            double f_worst = -INFINITY;
+            for( size_t j = i_out / 8; j + WINDOW <= i_out; j += WINDOW )
+            {
+                double f_phase0 = 0.;
+                for( unsigned c = 0; c < i_nch; c++ )
+                {
+                    double f_phase;
+                    double f_thdn = Fit( &p_out[i_nch * j], WINDOW, i_nch, c,
+                                         w, &f_phase );
+                    if( f_thdn > f_worst )
+                        f_worst = f_thdn;
+                    if( c == 0 )
+                        f_phase0 = f_phase;
+                    else
+                    {
+                        double d = remainder( f_phase - f_phase0 - c * M_PI_2,
+                                              2. * M_PI );
+                        assert( fabs( d ) < 1e-3 );
+                    }
+                }
+            }
+            printf( "scaletempo %u ch x%.2f: %zu frames, THD+N %6.1f dB\n",
+                    i_nch, rates[i], i_out, f_worst );
+            assert( f_worst < -40. );
+            free( p_out );
+        }
+}
+
+/*****************************************************************************
+ * Benchmark of the tempo scaler over the usual playback rates
+ *****************************************************************************/
+void test_Benchmark( libvlc_int_t *p_libvlc, unsigned i_seconds )
+{
+    static const uint16_t chans[] = { AOUT_CHANS_STEREO, AOUT_CHANS_5_1 };
+
+    for( size_t k = 0; k < ARRAY_SIZE(chans); k++ )
+        for( size_t i = 0; i < ARRAY_SIZE(rates); i++ )
+        {
+            filter_t *p_filter = CreateScaletempo( p_libvlc, chans[k] );
+            const unsigned i_nch = p_filter->fmt_in.audio.i_channels;
+
+            size_t i_out;
+            mtime_t i_time;
+            float *p_out = Run( p_filter, rates[i],
+                                RATE * rates[i] * i_seconds,
+                                &i_out, &i_time );
+            DeleteAudioFilter( p_filter );
+            free( p_out );
+
+            /* Per second of output, whatever the rate */
+            printf( "scaletempo %u ch x%.2f: %6"PRId64" us/s\n",
+                    i_nch, rates[i], i_time / i_seconds );
+        }
+}
@@ -0,0 +1,128 @@
+/*****************************************************************************
+ * ring.c: audio output sample ring test
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc_common.h>
+#include <vlc_aout.h>
+#include <vlc_block.h>
+
+#include "../../../modules/audio_output/ring.h"
+
+#define SIZE  1000
+#define FRAME 4
+#define CHUNK 64
+
+/* The "device" checks that it gets the bytes in order, and alternately takes
+ * whole and partial writes, slowly or not */
+static size_t i_played;
+static unsigned i_writes;
+
+static ssize_t Write( void *opaque, const void *buf, size_t length )
+{
+    const uint8_t *p = buf;
+
+    assert( opaque == &i_played );
+    assert( length > 0 && length <= CHUNK );
+
+    if( (i_writes++ % 3) == 0 && length > 1 )
+        length /= 2;
+    if( (i_writes % 29) == 0 )
+        mwait( mdate() + CLOCK_FREQ / 1000 );
+
+    for( size_t i = 0; i < length; i++ )
+        assert( p[i] == (uint8_t)(i_played + i) );
+    i_played += length;
+    return length;
+}
+
+static size_t Play( aout_ring_t *p_ring, size_t i_pos, size_t i_size )
+{
+    block_t *p_block = block_Alloc( i_size );
+    assert( p_block );
+
+    for( size_t i = 0; i < i_size; i++ )
+        p_block->p_buffer[i] = i_pos + i;
+    aout_RingPlay( p_ring, p_block );
+    return i_pos + i_size;
+}
+
+int main( void )
+{
+    aout_ring_t ring;
+    size_t i_pos = 0;
+
+    assert( aout_RingInit( &ring, SIZE + 1, FRAME, CHUNK + 3, Write,
+                           &i_played ) == VLC_SUCCESS );
+    assert( ring.size == SIZE && ring.chunk == CHUNK );
+
+    /* Blocks larger than the ring wait for the device */
+    srand( 0 );
+    for( unsigned i = 0; i < 300; i++ )
+        i_pos = Play( &ring, i_pos, FRAME * (rand() % (2 * SIZE / FRAME)) );
+    aout_RingDrain( &ring );
+    assert( aout_RingUsed( &ring ) == 0 );
+    assert( i_played == i_pos );
+
+    /* Each side sleeps and gets woken up again, without losing a wake-up */
+    for( unsigned i = 0; i < 2000; i++ )
+    {
+        i_pos = Play( &ring, i_pos, FRAME * (1 + rand() % 4) );
+        if( i & 1 )
+            aout_RingDrain( &ring );
+    }
+    aout_RingDrain( &ring );
+    assert( i_played == i_pos );
+
+    /* Nothing gets played while paused, and what does not fit is dropped */
+    aout_RingPause( &ring, true );
+    Play( &ring, i_pos, 3 * SIZE / 2 );
+    assert( aout_RingUsed( &ring ) == SIZE );
+    aout_RingDrain( &ring );
+    aout_RingFlush( &ring );
+    assert( aout_RingUsed( &ring ) == 0 );
+    assert( i_played == i_pos );
+
+    /* Queued samples are played on resume */
+    i_pos = Play( &ring, i_pos, SIZE / 2 );
+    aout_RingPause( &ring, false );
+    i_pos = Play( &ring, i_pos, SIZE );
+    aout_RingDrain( &ring );
+    assert( i_played == i_pos );
+
+    /* Flushing discards the queued samples */
+    i_pos = Play( &ring, i_pos, SIZE );
+    aout_RingFlush( &ring );
+    assert( aout_RingUsed( &ring ) == 0 );
+    i_pos = i_played;
+    i_pos = Play( &ring, i_pos, SIZE / 2 );
+
+    aout_RingClean( &ring );
+    assert( i_played <= i_pos );
+    return 0;
+}
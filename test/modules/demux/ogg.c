@@ -0,0 +1,610 @@
+/*****************************************************************************
+ * ogg.c: Ogg demuxer seek test
+ *****************************************************************************
+ * Copyright (C) 2026 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * Opus, Vorbis and Theora streams, alone and multiplexed, are generated in
+ * memory. Every packet carries its stream and number, so that the packets
+ * demuxed after a seek can be checked against where the seek should land:
+ * the audio page holding the target, or the keyframe preceding it. The
+ * seek index and page cache fill up as the file is demuxed, so the same
+ * seeks are done on a fresh demuxer, again right after, and after the
+ * file was played up to its end: they must all land on the same packets.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_block.h>
+#include <vlc_demux.h>
+#include <vlc_es_out.h>
+#include <vlc_modules.h>
+#include <vlc_stream.h>
+
+#define SECONDS 60
+
+/*****************************************************************************
+ * Ogg muxing
+ *****************************************************************************/
+static uint32_t pi_crc[256];
+
+static void CrcInit( void )
+{
+    for( uint32_t i = 0; i < 256; i++ )
+    {
+        uint32_t r = i << 24;
+        for( int j = 0; j < 8; j++ )
+            r = ( r & 0x80000000 ) ? ( r << 1 ) ^ 0x04c11db7 : r << 1;
+        pi_crc[i] = r;
+    }
+}
+
+typedef struct
+{
+    uint8_t *p;
+    size_t   i_size;
+} buf_t;
+
+static void Put( buf_t *b, const void *p, size_t i_size )
+{
+    b->p = realloc( b->p, b->i_size + i_size );
+    assert( b->p );
+    memcpy( &b->p[b->i_size], p, i_size );
+    b->i_size += i_size;
+}
+
+typedef struct
+{
+    uint32_t i_serial;
+    uint32_t i_pageno;
+    bool     b_bos;
+    /* packets of the page being built */
+    uint8_t  p_lacing[255];
+    int      i_lacing;
+    buf_t    body;
+} ogg_writer_t;
+
+static void WriterInit( ogg_writer_t *w, uint32_t i_serial )
+{
+    memset( w, 0, sizeof(*w) );
+    w->i_serial = i_serial;
+    w->b_bos = true;
+}
+
+/* Appends a packet to the page; it must fit */
+static void WriterPacket( ogg_writer_t *w, const uint8_t *p, size_t i_size )
+{
+    size_t i_segs = i_size / 255 + 1;
+    assert( w->i_lacing + i_segs <= 255 );
+    for( size_t i = 0; i < i_segs - 1; i++ )
+        w->p_lacing[w->i_lacing++] = 255;
+    w->p_lacing[w->i_lacing++] = i_size % 255;
+    Put( &w->body, p, i_size );
+}
+
+static void WriterFlush( ogg_writer_t *w, buf_t *out, int64_t i_granule,
+                         bool b_eos )
+{
+    uint8_t h[27 + 255];
+
+    memcpy( h, "OggS", 4 );
+    h[4] = 0;
+    h[5] = ( w->b_bos ? 0x02 : 0 ) | ( b_eos ? 0x04 : 0 );
+    SetQWLE( &h[6], i_granule );
+    SetDWLE( &h[14], w->i_serial );
+    SetDWLE( &h[18], w->i_pageno++ );
+    SetDWLE( &h[22], 0 );
+    h[26] = w->i_lacing;
+    memcpy( &h[27], w->p_lacing, w->i_lacing );
+
+    size_t i_header = 27 + w->i_lacing;
+    uint32_t i_crc = 0;
+    for( size_t i = 0; i < i_header; i++ )
+        i_crc = ( i_crc << 8 ) ^ pi_crc[( i_crc >> 24 ) ^ h[i]];
+    for( size_t i = 0; i < w->body.i_size; i++ )
+        i_crc = ( i_crc << 8 ) ^ pi_crc[( i_crc >> 24 ) ^ w->body.p[i]];
+    SetDWLE( &h[22], i_crc );
+
+    Put( out, h, i_header );
+    Put( out, w->body.p, w->body.i_size );
+    w->body.i_size = 0;
+    w->i_lacing = 0;
+    w->b_bos = false;
+}
+
+/*****************************************************************************
+ * Streams
+ *****************************************************************************/
+enum { OPUS, VORBIS, THEORA };
+
+typedef struct
+{
+    int      i_codec;
+    uint32_t i_serial;
+    /* data packets, and packets per page */
+    int      i_packets;
+    int      i_per_page;
+    /* time of a packet, and keyframe interval for video */
+    mtime_t  i_packet_length;
+    int      i_gop;
+} stream_def_t;
+
+/* Tags the payload of a data packet with its stream and number */
+static size_t DataPacket( const stream_def_t *s, int i_packet, uint8_t *p )
+{
+    size_t i_size = 24 + ( i_packet * 37 ) % 90;
+
+    memset( p, 0, i_size );
+    switch( s->i_codec )
+    {
+        case OPUS:   p[0] = 0xf8; break; /* CELT fullband 20 ms, 1 frame */
+        case VORBIS: p[0] = 0x00; break; /* audio packet */
+        case THEORA: p[0] = i_packet % s->i_gop ? 0x40 : 0x00; break;
+    }
+    SetDWBE( &p[4], s->i_serial );
+    SetDWBE( &p[8], i_packet );
+    return i_size;
+}
+
+static int64_t PacketGranule( const stream_def_t *s, int i_packet )
+{
+    switch( s->i_codec )
+    {
+        case OPUS: /* 960 samples per packet, after 312 samples pre-skip */
+            return 312 + 960 * (int64_t)( i_packet + 1 );
+        case VORBIS: /* 1024 samples per packet */
+            return 1024 * (int64_t)( i_packet + 1 );
+        default: /* 3.2.1: frame numbers start at 1, shift 6 */
+        {
+            int i_key = i_packet - i_packet % s->i_gop;
+            return ( (int64_t)( i_key + 1 ) << 6 ) | ( i_packet - i_key );
+        }
+    }
+}
+
+static void HeaderPackets( const stream_def_t *s, ogg_writer_t *w,
+                           buf_t *out, bool b_first )
+{
+    uint8_t p[64];
+
+    switch( s->i_codec )
+    {
+        case OPUS:
+            if( b_first )
+            {
+                memcpy( p, "OpusHead\x01\x02", 10 );
+                SetWLE( &p[10], 312 );
+                SetDWLE( &p[12], 48000 );
+                SetWLE( &p[16], 0 );
+                p[18] = 0;
+                WriterPacket( w, p, 19 );
+                WriterFlush( w, out, 0, false );
+            }
+            else
+            {
+                memcpy( p, "OpusTags\x04\0\0\0test\0\0\0\0", 20 );
+                WriterPacket( w, p, 20 );
+                WriterFlush( w, out, 0, false );
+            }
+            break;
+        case VORBIS:
+            if( b_first )
+            {
+                memcpy( p, "\x01vorbis", 7 );
+                SetDWLE( &p[7], 0 );
+                p[11] = 2;
+                SetDWLE( &p[12], 48000 );
+                SetDWLE( &p[16], 0 );
+                SetDWLE( &p[20], 0 );       /* no nominal bitrate */
+                SetDWLE( &p[24], 0 );
+                p[28] = 0xb8; /* 256 and 2048 samples blocks */
+                p[29] = 1;
+                WriterPacket( w, p, 30 );
+                WriterFlush( w, out, 0, false );
+            }
+            else
+            {
+                memcpy( p, "\x03vorbis\x04\0\0\0test\0\0\0\0\x01", 20 );
+                WriterPacket( w, p, 20 );
+                memcpy( p, "\x05vorbis\0", 8 );
+                WriterPacket( w, p, 8 );
+                WriterFlush( w, out, 0, false );
+            }
+            break;
+        case THEORA:
+            if( b_first )
+            {
+                memset( p, 0, 42 );
+                memcpy( p, "\x80theora\x03\x02\x01", 10 );
+                SetWBE( &p[10], 20 );  /* 320x240 */
+                SetWBE( &p[12], 15 );
+                p[15] = 0x01; p[16] = 0x40; /* 320 */
+                p[19] = 0xf0;               /* 240 */
+                SetDWBE( &p[22], 25 );
+                SetDWBE( &p[26], 1 );
+                p[32] = 1; p[35] = 1;       /* square pixels */
+                /* quality 0, keyframe granule shift 6 */
+                p[41] = 0xc0;
+                WriterPacket( w, p, 42 );
+                WriterFlush( w, out, 0, false );
+            }
+            else
+            {
+                memcpy( p, "\x81theora\x04\0\0\0test\0\0\0\0", 19 );
+                WriterPacket( w, p, 19 );
+                memcpy( p, "\x82theora\0", 8 );
+                WriterPacket( w, p, 8 );
+                WriterFlush( w, out, 0, false );
+            }
+            break;
+    }
+}
+
+/* Multiplexes the streams, with data pages ordered by end time */
+static void BuildFile( const stream_def_t *p_defs, int i_defs, buf_t *out )
+{
+    ogg_writer_t w[4];
+    int pi_next[4] = { 0 };
+
+    assert( i_defs <= 4 );
+    memset( out, 0, sizeof(*out) );
+    for( int i = 0; i < i_defs; i++ )
+    {
+        WriterInit( &w[i], p_defs[i].i_serial );
+        HeaderPackets( &p_defs[i], &w[i], out, true );
+    }
+    for( int i = 0; i < i_defs; i++ )
+        HeaderPackets( &p_defs[i], &w[i], out, false );
+
+    for( ;; )
+    {
+        int i_best = -1;
+        mtime_t i_best_end = 0;
+
+        for( int i = 0; i < i_defs; i++ )
+        {
+            const stream_def_t *s = &p_defs[i];
+            if( pi_next[i] >= s->i_packets )
+                continue;
+            int i_last = __MIN( pi_next[i] + s->i_per_page, s->i_packets );
+            mtime_t i_end = i_last * s->i_packet_length;
+            if( i_best < 0 || i_end < i_best_end )
+            {
+                i_best = i;
+                i_best_end = i_end;
+            }
+        }
+        if( i_best < 0 )
+            break;
+
+        const stream_def_t *s = &p_defs[i_best];
+        int i_last = __MIN( pi_next[i_best] + s->i_per_page, s->i_packets );
+        for( int j = pi_next[i_best]; j < i_last; j++ )
+        {
+            uint8_t p[128];
+            WriterPacket( &w[i_best], p, DataPacket( s, j, p ) );
+        }
+        WriterFlush( &w[i_best], out, PacketGranule( s, i_last - 1 ),
+                     i_last == s->i_packets );
+        pi_next[i_best] = i_last;
+    }
+
+    for( int i = 0; i < i_defs; i++ )
+        free( w[i].body.p );
+}
+
+/*****************************************************************************
+ * Demuxing
+ *****************************************************************************/
+struct es_out_id_t
+{
+    int i_cat;
+};
+
+/* First data packet demuxed for each stream since the last reset */
+typedef struct
+{
+    const stream_def_t *p_defs;
+    int      i_defs;
+    int      pi_first[4];
+} collector_t;
+
+static void CollectorReset( collector_t *c )
+{
+    for( size_t i = 0; i < ARRAY_SIZE(c->pi_first); i++ )
+        c->pi_first[i] = -1;
+}
+
+static bool CollectorDone( const collector_t *c )
+{
+    for( int i = 0; i < c->i_defs; i++ )
+        if( c->pi_first[i] < 0 )
+            return false;
+    return true;
+}
+
+static es_out_id_t *EsOutAdd( es_out_t *out, const es_format_t *fmt )
+{
+    VLC_UNUSED(out);
+    es_out_id_t *id = malloc( sizeof(*id) );
+    assert( id );
+    id->i_cat = fmt->i_cat;
+    return id;
+}
+
+static int EsOutSend( es_out_t *out, es_out_id_t *id, block_t *p_block )
+{
+    collector_t *c = (collector_t *)out->p_sys;
+    VLC_UNUSED(id);
+
+    /* Header packets are not tagged */
+    if( p_block->i_buffer >= 12 )
+    {
+        uint32_t i_serial = GetDWBE( &p_block->p_buffer[4] );
+        for( int i = 0; i < c->i_defs; i++ )
+            if( c->p_defs[i].i_serial == i_serial && c->pi_first[i] < 0 )
+                c->pi_first[i] = GetDWBE( &p_block->p_buffer[8] );
+    }
+    block_Release( p_block );
+    return VLC_SUCCESS;
+}
+
+static void EsOutDel( es_out_t *out, es_out_id_t *id )
+{
+    VLC_UNUSED(out);
+    free( id );
+}
+
+static int EsOutControl( es_out_t *out, int i_query, va_list args )
+{
+    VLC_UNUSED(out);
+    switch( i_query )
+    {
+        case ES_OUT_GET_ES_STATE:
+            va_arg( args, es_out_id_t * );
+            *va_arg( args, bool * ) = true;
+            return VLC_SUCCESS;
+        case ES_OUT_SET_PCR:
+        case ES_OUT_SET_GROUP_PCR:
+        case ES_OUT_RESET_PCR:
+        case ES_OUT_SET_NEXT_DISPLAY_TIME:
+        case ES_OUT_SET_ES_FMT:
+            return VLC_SUCCESS;
+        default:
+            return VLC_EGENERIC;
+    }
+}
+
+/* Checks where the seek to i_time landed, pi_first being the first packet
+ * of each stream. The first video stream drives the seek, and lands on the
+ * keyframe preceding the target, or the one before if the target frame is
+ * not over yet. Otherwise the audio stream lands at the start of the page
+ * holding the target, or of the page before. Other streams are demuxed
+ * from there, so they start at most a page before the video. */
+static void CheckSeek( const stream_def_t *p_defs, int i_defs,
+                       mtime_t i_time, const int *pi_first )
+{
+    const stream_def_t *p_main = &p_defs[0];
+    int i_main = 0;
+    for( int i = 0; i < i_defs; i++ )
+        if( p_defs[i].i_codec == THEORA )
+        {
+            p_main = &p_defs[i];
+            i_main = i;
+            break;
+        }
+
+    int i_target = __MIN( i_time / p_main->i_packet_length,
+                          p_main->i_packets - 1 );
+    int i_unit = p_main->i_codec == THEORA ? p_main->i_gop
+                                           : p_main->i_per_page;
+    int i_expected = i_target - i_target % i_unit;
+
+    assert( pi_first[i_main] % i_unit == 0 );
+    assert( pi_first[i_main] <= i_expected );
+    assert( pi_first[i_main] >= i_expected - i_unit );
+
+    mtime_t i_main_time = pi_first[i_main] * p_main->i_packet_length;
+    for( int i = 0; i < i_defs; i++ )
+    {
+        if( i == i_main )
+            continue;
+        assert( pi_first[i] >= 0 );
+        mtime_t i_first = pi_first[i] * p_defs[i].i_packet_length;
+        assert( i_first <= i_time );
+        assert( i_first >= i_main_time
+                           - p_defs[i].i_per_page * p_defs[i].i_packet_length );
+    }
+}
+
+typedef struct
+{
+    demux_t    *p_demux;
+    collector_t collector;
+    es_out_t    out;
+} test_demux_t;
+
+static void Open( test_demux_t *t, vlc_object_t *p_obj, buf_t *p_file,
+                  const stream_def_t *p_defs, int i_defs )
+{
+    t->collector.p_defs = p_defs;
+    t->collector.i_defs = i_defs;
+    CollectorReset( &t->collector );
+    t->out = (es_out_t) {
+        .pf_add = EsOutAdd,
+        .pf_send = EsOutSend,
+        .pf_del = EsOutDel,
+        .pf_control = EsOutControl,
+        .p_sys = (es_out_sys_t *)&t->collector,
+    };
+
+    stream_t *p_stream = vlc_stream_MemoryNew( p_obj, p_file->p,
+                                               p_file->i_size, true );
+    assert( p_stream );
+    t->p_demux = demux_New( p_obj, "ogg", "", p_stream, &t->out );
+    assert( t->p_demux );
+
+    /* Past the headers */
+    while( !CollectorDone( &t->collector ) )
+        assert( demux_Demux( t->p_demux ) == VLC_DEMUXER_SUCCESS );
+}
+
+static void Close( test_demux_t *t )
+{
+    demux_Delete( t->p_demux ); /* and its stream */
+}
+
+/* Plays up to i_time: the end of stream would reset the demuxer */
+static void DemuxUntil( test_demux_t *t, mtime_t i_time )
+{
+    int64_t i_now;
+    do
+    {
+        assert( demux_Demux( t->p_demux ) == VLC_DEMUXER_SUCCESS );
+        assert( demux_Control( t->p_demux, DEMUX_GET_TIME, &i_now )
+                == VLC_SUCCESS );
+    } while( i_now < VLC_TS_0 + i_time );
+}
+
+/* Seeks to i_time, or to the same position if i_length is not 0, and
+ * returns the first packet of each stream */
+static void Seek( test_demux_t *t, mtime_t i_time, int64_t i_length,
+                  int *pi_first )
+{
+    if( i_length != 0 )
+        assert( demux_Control( t->p_demux, DEMUX_SET_POSITION,
+                               (double)i_time / i_length, false )
+                == VLC_SUCCESS );
+    else
+        assert( demux_Control( t->p_demux, DEMUX_SET_TIME, i_time, false )
+                == VLC_SUCCESS );
+    CollectorReset( &t->collector );
+    while( !CollectorDone( &t->collector ) &&
+           demux_Demux( t->p_demux ) == VLC_DEMUXER_SUCCESS );
+    memcpy( pi_first, t->collector.pi_first, sizeof(t->collector.pi_first) );
+}
+
+static const mtime_t pi_seeks[] = {
+    CLOCK_FREQ * 31 + 5000, CLOCK_FREQ * 2, CLOCK_FREQ * 58 + 120000,
+    CLOCK_FREQ * 17 + 330000, CLOCK_FREQ * 17 + 400000, CLOCK_FREQ * 45,
+    CLOCK_FREQ / 4, CLOCK_FREQ * 40 + 999000, CLOCK_FREQ * 9 + 640000,
+};
+#define SEEKS ARRAY_SIZE(pi_seeks)
+
+static void test_Seek( vlc_object_t *p_obj, const char *psz_name,
+                       const stream_def_t *p_defs, int i_defs )
+{
+    buf_t file;
+    test_demux_t t;
+    int pi_fresh[SEEKS][4], pi_again[2][SEEKS][4], pi_indexed[SEEKS][4];
+    int pi_position[SEEKS][4];
+
+    BuildFile( p_defs, i_defs, &file );
+
+    /* A new demuxer for each seek: nothing indexed nor cached */
+    for( size_t i = 0; i < SEEKS; i++ )
+    {
+        Open( &t, p_obj, &file, p_defs, i_defs );
+        Seek( &t, pi_seeks[i], 0, pi_fresh[i] );
+        Close( &t );
+    }
+
+    /* All seeks in a row, twice, then once played up to the end */
+    Open( &t, p_obj, &file, p_defs, i_defs );
+    int64_t i_length;
+    assert( demux_Control( t.p_demux, DEMUX_GET_LENGTH, &i_length )
+            == VLC_SUCCESS );
+    for( int j = 0; j < 2; j++ )
+        for( size_t i = 0; i < SEEKS; i++ )
+            Seek( &t, pi_seeks[i], 0, pi_again[j][i] );
+    assert( demux_Control( t.p_demux, DEMUX_SET_TIME, (mtime_t)0, false )
+            == VLC_SUCCESS );
+    DemuxUntil( &t, CLOCK_FREQ * ( SECONDS - 1 ) );
+    for( size_t i = 0; i < SEEKS; i++ )
+        Seek( &t, pi_seeks[i], 0, pi_indexed[i] );
+
+    /* Positions are seeked to by time, as the length is known */
+    for( size_t i = 0; i < SEEKS; i++ )
+        Seek( &t, pi_seeks[i], i_length, pi_position[i] );
+    Close( &t );
+
+    for( size_t i = 0; i < SEEKS; i++ )
+    {
+        CheckSeek( p_defs, i_defs, pi_seeks[i], pi_fresh[i] );
+        CheckSeek( p_defs, i_defs, pi_seeks[i], pi_position[i] );
+        for( int j = 0; j < 2; j++ )
+            assert( !memcmp( pi_again[j][i], pi_fresh[i],
+                             sizeof(pi_fresh[i]) ) );
+        assert( !memcmp( pi_indexed[i], pi_fresh[i], sizeof(pi_fresh[i]) ) );
+    }
+    assert( i_length > CLOCK_FREQ * ( SECONDS - 2 ) );
+    assert( i_length <= CLOCK_FREQ * SECONDS );
+    printf( "%s: %zu seeks checked, length %"PRId64" ms\n", psz_name, SEEKS,
+            i_length / 1000 );
+    free( file.p );
+}
+
+int main( void )
+{
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv), ppsz_argv );
+    assert( p_vlc );
+    if( !module_exists( "ogg" ) )
+    {
+        fprintf( stderr, "Skipping: ogg demux module not found\n" );
+        libvlc_release( p_vlc );
+        return 77;
+    }
+
+    CrcInit();
+    vlc_object_t *p_obj = VLC_OBJECT(p_vlc->p_libvlc_int);
+
+    /* 20 ms Opus packets, 21.33 ms Vorbis packets, 25 fps Theora */
+    const stream_def_t opus = {
+        OPUS, 0x0b05, SECONDS * 50, 10, CLOCK_FREQ / 50, 0 };
+    const stream_def_t vorbis = {
+        VORBIS, 0x0b0b, SECONDS * 48000 / 1024, 12, CLOCK_FREQ * 1024 / 48000, 0 };
+    const stream_def_t theora = {
+        THEORA, 0x07e0, SECONDS * 25, 1, CLOCK_FREQ / 25, 32 };
+
+    test_Seek( p_obj, "opus", &opus, 1 );
+    test_Seek( p_obj, "vorbis", &vorbis, 1 );
+    test_Seek( p_obj, "theora", &theora, 1 );
+    test_Seek( p_obj, "theora+vorbis", (const stream_def_t []){ theora, vorbis }, 2 );
+    test_Seek( p_obj, "theora+opus", (const stream_def_t []){ theora, opus }, 2 );
+
+    libvlc_release( p_vlc );
+    return 0;
+}
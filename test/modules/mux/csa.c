@@ -0,0 +1,235 @@
+/*****************************************************************************
+ * csa.c: CSA batch engine test
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <vlc_common.h>
+#include "../modules/mux/mpeg/csa.h"
+#include "../modules/mux/mpeg/csa.c"
+
+#define PACKETS 1000
+
+static uint8_t *pp_ref[PACKETS];
+static uint8_t *pp_pkt[PACKETS];
+
+static void test_SetKeys( csa_t *c )
+{
+    for( int i = 0; i < 8; i++ )
+    {
+        c->o_ck[i] = rand();
+        c->e_ck[i] = rand();
+    }
+    csa_ComputeKey( c->o_kk, c->o_ck );
+    csa_ComputeKey( c->e_kk, c->e_ck );
+}
+
+/* Random packets, with adaptation fields of every length */
+static void test_FillPackets( void )
+{
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        uint8_t *p = pp_ref[i];
+
+        for( int j = 0; j < 188; j++ )
+            p[j] = rand();
+        p[0] = 0x47;
+        p[3] = 0x10 | (i & 0x0f);
+        if( i % 3 == 0 )
+        {
+            p[3] |= 0x20;
+            p[4] = (i / 3) % 184;
+        }
+        memcpy( pp_pkt[i], p, 188 );
+    }
+}
+
+static void test_Check( const char *psz_what )
+{
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        if( memcmp( pp_ref[i], pp_pkt[i], 188 ) )
+        {
+            fprintf( stderr, "%s: packet %d differs\n", psz_what, i );
+            abort();
+        }
+    }
+}
+
+static void test_Engine( csa_t *c, const char *psz_name, csa_bs_func_t pf_enc,
+                         csa_bs_func_t pf_dec, int i_lanes, int i_pkt_size )
+{
+    uint8_t *pp_data[CSA_BATCH_SIZE];
+    int      pi_len[CSA_BATCH_SIZE];
+
+    assert( i_lanes <= CSA_BATCH_SIZE );
+    printf( "%s engine, %d bytes packets\n", psz_name, i_pkt_size );
+
+    for( int i_count = 1; i_count <= i_lanes; i_count += i_count < 9 ? 1 : 37 )
+    {
+        int i_used = 0;
+
+        test_FillPackets();
+        for( int i = 0; i < i_count; i++ )
+        {
+            const int i_hdr = csa_PayloadOffset( pp_ref[i] );
+            if( i_pkt_size - i_hdr < 8 )
+                continue;
+            csa_Encrypt( c, pp_ref[i], i_pkt_size );
+            pp_pkt[i][3] = pp_ref[i][3];
+            pp_data[i_used] = &pp_pkt[i][i_hdr];
+            pi_len[i_used++] = i_pkt_size - i_hdr;
+        }
+        pf_enc( c->use_odd ? c->o_ck : c->e_ck, c->use_odd ? c->o_kk : c->e_kk,
+                pp_data, pi_len, i_used );
+        test_Check( "encrypt" );
+
+        for( int i = 0; i < i_count; i++ )
+            csa_Decrypt( c, pp_ref[i], i_pkt_size );
+        pf_dec( c->use_odd ? c->o_ck : c->e_ck, c->use_odd ? c->o_kk : c->e_kk,
+                pp_data, pi_len, i_used );
+        for( int i = 0; i < i_count; i++ )
+            pp_pkt[i][3] &= 0x3f;
+        test_Check( "decrypt" );
+    }
+}
+
+static void test_Batch( csa_t *c, int i_pkt_size )
+{
+    printf( "batch API, %d bytes packets\n", i_pkt_size );
+
+    /* mixed keys and unscrambled packets */
+    test_FillPackets();
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        c->use_odd = i & 1;
+        if( i % 5 )
+            csa_Encrypt( c, pp_ref[i], i_pkt_size );
+        memcpy( pp_pkt[i], pp_ref[i], 188 );
+    }
+    for( int i = 0; i < PACKETS; i++ )
+        csa_Decrypt( c, pp_ref[i], i_pkt_size );
+    csa_DecryptBatch( c, pp_pkt, PACKETS, i_pkt_size );
+    test_Check( "batch decrypt" );
+
+    c->use_odd = true;
+    for( int i = 0; i < PACKETS; i++ )
+        csa_Encrypt( c, pp_ref[i], i_pkt_size );
+    csa_EncryptBatch( c, pp_pkt, PACKETS, i_pkt_size );
+    test_Check( "batch encrypt" );
+}
+
+static void test_Throughput( csa_t *c )
+{
+    const int i_loops = 10;
+    mtime_t i_start;
+
+    test_FillPackets();
+
+    i_start = mdate();
+    for( int j = 0; j < i_loops; j++ )
+        for( int i = 0; i < PACKETS; i++ )
+            csa_Encrypt( c, pp_ref[i], 188 );
+    const mtime_t i_scalar = mdate() - i_start;
+
+    i_start = mdate();
+    for( int j = 0; j < i_loops; j++ )
+        csa_EncryptBatch( c, pp_pkt, PACKETS, 188 );
+    const mtime_t i_batch = mdate() - i_start;
+
+    printf( "encrypt: scalar %"PRId64" pkt/s, batch %"PRId64" pkt/s\n",
+            (int64_t)PACKETS * i_loops * CLOCK_FREQ / __MAX(i_scalar, 1),
+            (int64_t)PACKETS * i_loops * CLOCK_FREQ / __MAX(i_batch, 1) );
+
+    i_start = mdate();
+    for( int j = 0; j < i_loops; j++ )
+        for( int i = 0; i < PACKETS; i++ )
+        {
+            pp_ref[i][3] |= 0x80;
+            csa_Decrypt( c, pp_ref[i], 188 );
+        }
+    const mtime_t i_dscalar = mdate() - i_start;
+
+    i_start = mdate();
+    for( int j = 0; j < i_loops; j++ )
+    {
+        for( int i = 0; i < PACKETS; i++ )
+            pp_pkt[i][3] |= 0x80;
+        csa_DecryptBatch( c, pp_pkt, PACKETS, 188 );
+    }
+    const mtime_t i_dbatch = mdate() - i_start;
+
+    printf( "decrypt: scalar %"PRId64" pkt/s, batch %"PRId64" pkt/s\n",
+            (int64_t)PACKETS * i_loops * CLOCK_FREQ / __MAX(i_dscalar, 1),
+            (int64_t)PACKETS * i_loops * CLOCK_FREQ / __MAX(i_dbatch, 1) );
+}
+
+int main( void )
+{
+    static const int pi_sizes[] = { 188, 100, 12 };
+
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        pp_ref[i] = malloc( 188 );
+        pp_pkt[i] = malloc( 188 );
+        assert( pp_ref[i] && pp_pkt[i] );
+    }
+
+    srand( 0 );
+    csa_t *c = csa_New();
+    assert( c );
+    test_SetKeys( c );
+
+    /* Check the 8x8 transposition helper */
+    for( int i = 0; i < 64; i++ )
+    {
+        const uint64_t x = 1ULL << i;
+        assert( csa_Transpose8x8( x ) == 1ULL << ( 8 * (i % 8) + i / 8 ) );
+    }
+
+    for( size_t i = 0; i < ARRAY_SIZE(pi_sizes); i++ )
+    {
+        c->use_odd = i & 1;
+        test_Engine( c, "C", csa_BsEncrypt_c, csa_BsDecrypt_c, 64,
+                     pi_sizes[i] );
+#ifdef HAVE_CSA_BS_SSE2
+        if( vlc_CPU_SSE2() )
+            test_Engine( c, "SSE2", csa_BsEncrypt_sse2, csa_BsDecrypt_sse2,
+                         128, pi_sizes[i] );
+#endif
+#ifdef HAVE_CSA_BS_AVX2
+        if( vlc_CPU_AVX2() )
+            test_Engine( c, "AVX2", csa_BsEncrypt_avx2, csa_BsDecrypt_avx2,
+                         256, pi_sizes[i] );
+#endif
+        test_Batch( c, pi_sizes[i] );
+    }
+
+    test_Throughput( c );
+
+    csa_Delete( c );
+    for( int i = 0; i < PACKETS; i++ )
+    {
+        free( pp_ref[i] );
+        free( pp_pkt[i] );
+    }
+    return 0;
+}
@@ -0,0 +1,407 @@
+/*****************************************************************************
+ * chroma.c: chroma converters test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <math.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_modules.h>
+#include <vlc_picture.h>
+
+/* Run with -b to benchmark more frames */
+static int i_bench_frames = 2;
+
+static picture_t *NewPicture( filter_t *p_filter )
+{
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+static filter_t *CreateConverter( libvlc_int_t *p_libvlc, const char *psz_name,
+                                  vlc_fourcc_t i_src, vlc_fourcc_t i_dst,
+                                  unsigned i_width, unsigned i_height,
+                                  video_color_space_t space )
+{
+    filter_t *p_filter = vlc_object_create( p_libvlc, sizeof(*p_filter) );
+    assert( p_filter );
+
+    es_format_Init( &p_filter->fmt_in, VIDEO_ES, i_src );
+    video_format_Setup( &p_filter->fmt_in.video, i_src, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    p_filter->fmt_in.video.space = space;
+    es_format_Init( &p_filter->fmt_out, VIDEO_ES, i_dst );
+    video_format_Setup( &p_filter->fmt_out.video, i_dst, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+    video_format_FixRgb( &p_filter->fmt_out.video );
+    p_filter->owner.video.buffer_new = NewPicture;
+
+    p_filter->p_module = module_need( p_filter, "video converter", psz_name,
+                                      true );
+    if( p_filter->p_module == NULL )
+    {
+        es_format_Clean( &p_filter->fmt_in );
+        es_format_Clean( &p_filter->fmt_out );
+        vlc_object_release( p_filter );
+        return NULL;
+    }
+    return p_filter;
+}
+
+static void DeleteConverter( filter_t *p_filter )
+{
+    module_unneed( p_filter, p_filter->p_module );
+    es_format_Clean( &p_filter->fmt_in );
+    es_format_Clean( &p_filter->fmt_out );
+    vlc_object_release( p_filter );
+}
+
+/* Samples with smooth areas and extreme values, within the sample depth */
+static picture_t *NewSource( const video_format_t *p_fmt, unsigned i_seed )
+{
+    picture_t *p_pic = picture_NewFromFormat( p_fmt );
+    const vlc_chroma_description_t *p_desc =
+        vlc_fourcc_GetChromaDescription( p_fmt->i_chroma );
+    const unsigned i_max = 1 << p_desc->pixel_bits;
+    /* P010 stores its samples in the most significant bits */
+    const unsigned i_shift = p_fmt->i_chroma == VLC_CODEC_P010 ? 6 : 0;
+
+    assert( p_pic );
+    for( int i_plane = 0; i_plane < p_pic->i_planes; i_plane++ )
+    {
+        const plane_t *p = &p_pic->p[i_plane];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch / (int)p_desc->pixel_size; x++ )
+            {
+                unsigned v = (x * 5 + y * 3 + i_plane * 17 + i_seed
+                              + ((x * y) & 15)) % i_max;
+                if( (x + y + i_seed) % 61 == 0 )
+                    v = (x & 1) * (i_max - 1);
+
+                if( p_desc->pixel_size == 2 )
+                    ((uint16_t *)&p->p_pixels[y * p->i_pitch])[x] = v << i_shift;
+                else
+                    p->p_pixels[y * p->i_pitch + x] = v;
+            }
+    }
+    return p_pic;
+}
+
+/*****************************************************************************
+ * Reference conversions
+ *****************************************************************************/
+
+static unsigned GetSample( const picture_t *p_pic, int i_plane, unsigned x,
+                           unsigned y )
+{
+    const plane_t *p = &p_pic->p[i_plane];
+
+    if( p_pic->format.i_chroma == VLC_CODEC_P010
+     || p_pic->format.i_chroma == VLC_CODEC_I420_10L
+     || p_pic->format.i_chroma == VLC_CODEC_I422_10L )
+        return ((const uint16_t *)&p->p_pixels[y * p->i_pitch])[x];
+    return p->p_pixels[y * p->i_pitch + x];
+}
+
+/* Returns the Y, U and V samples of a pixel on 10 bits */
+static void GetPixel( const picture_t *p_pic, unsigned x, unsigned y,
+                      unsigned yuv[3] )
+{
+    const vlc_fourcc_t i_chroma = p_pic->format.i_chroma;
+
+    switch( i_chroma )
+    {
+        case VLC_CODEC_NV12:
+            yuv[0] = GetSample( p_pic, 0, x, y ) << 2;
+            yuv[1] = GetSample( p_pic, 1, x / 2 * 2, y / 2 ) << 2;
+            yuv[2] = GetSample( p_pic, 1, x / 2 * 2 + 1, y / 2 ) << 2;
+            break;
+        case VLC_CODEC_P010:
+            yuv[0] = GetSample( p_pic, 0, x, y ) >> 6;
+            yuv[1] = GetSample( p_pic, 1, x / 2 * 2, y / 2 ) >> 6;
+            yuv[2] = GetSample( p_pic, 1, x / 2 * 2 + 1, y / 2 ) >> 6;
+            break;
+        default:
+        {
+            const bool b_422 = i_chroma == VLC_CODEC_I422
+                            || i_chroma == VLC_CODEC_J422
+                            || i_chroma == VLC_CODEC_I422_10L;
+            const bool b_10 = i_chroma == VLC_CODEC_I420_10L
+                           || i_chroma == VLC_CODEC_I422_10L;
+            const unsigned cy = b_422 ? y : y / 2;
+            const int u = i_chroma == VLC_CODEC_YV12 ? V_PLANE : U_PLANE;
+            const int v = i_chroma == VLC_CODEC_YV12 ? U_PLANE : V_PLANE;
+
+            yuv[0] = GetSample( p_pic, Y_PLANE, x, y ) << (b_10 ? 0 : 2);
+            yuv[1] = GetSample( p_pic, u, x / 2, cy ) << (b_10 ? 0 : 2);
+            yuv[2] = GetSample( p_pic, v, x / 2, cy ) << (b_10 ? 0 : 2);
+            break;
+        }
+    }
+}
+
+static void CheckYuv( const picture_t *p_src, const picture_t *p_dst )
+{
+    const bool b_422 = p_src->format.i_chroma == VLC_CODEC_I422
+                    || p_src->format.i_chroma == VLC_CODEC_J422
+                    || p_src->format.i_chroma == VLC_CODEC_I422_10L;
+    const bool b_10 = p_src->format.i_chroma == VLC_CODEC_I422_10L;
+
+    for( unsigned y = 0; y < p_src->format.i_visible_height; y++ )
+        for( unsigned x = 0; x < p_src->format.i_visible_width; x++ )
+        {
+            unsigned in[3], out[3];
+
+            GetPixel( p_src, x, y, in );
+            GetPixel( p_dst, x, y, out );
+            if( b_422 )
+            {
+                /* 4:2:0 chroma is the average of both lines, rounded at
+                 * the source depth */
+                unsigned top[3], bottom[3];
+
+                GetPixel( p_src, x, y / 2 * 2, top );
+                GetPixel( p_src, x, __MIN(y / 2 * 2 + 1,
+                          p_src->format.i_visible_height - 1), bottom );
+                for( int i = 1; i < 3; i++ )
+                    in[i] = b_10 ? (top[i] + bottom[i] + 1) >> 1
+                                 : (top[i] + bottom[i] + 4) >> 3 << 2;
+            }
+            if( in[0] != out[0] || in[1] != out[1] || in[2] != out[2] )
+            {
+                fprintf( stderr, "%4.4s to %4.4s: pixel %ux%u differs\n",
+                         (const char *)&p_src->format.i_chroma,
+                         (const char *)&p_dst->format.i_chroma, x, y );
+                abort();
+            }
+        }
+}
+
+static void CheckRgb( const picture_t *p_src, const picture_t *p_dst )
+{
+    const video_format_t *p_fmt = &p_src->format;
+    const bool b_full = p_fmt->i_chroma == VLC_CODEC_J420
+                     || p_fmt->i_chroma == VLC_CODEC_J422;
+    const bool b_bgra = p_dst->format.i_chroma != VLC_CODEC_RGBA;
+    float kr = 0.299f, kb = 0.114f;
+
+    if( p_fmt->space == COLOR_SPACE_BT709
+     || (p_fmt->space == COLOR_SPACE_UNDEF && p_fmt->i_visible_height > 576) )
+        kr = 0.2126f, kb = 0.0722f;
+    else if( p_fmt->space == COLOR_SPACE_BT2020 )
+        kr = 0.2627f, kb = 0.0593f;
+
+    const float kg = 1.f - kr - kb;
+    const float ky = b_full ? 1.f : 255.f / 219.f;
+    const float kc = b_full ? 1.f : 255.f / 224.f;
+
+    for( unsigned y = 0; y < p_fmt->i_visible_height; y++ )
+        for( unsigned x = 0; x < p_fmt->i_visible_width; x++ )
+        {
+            unsigned yuv[3];
+            GetPixel( p_src, x, y, yuv );
+
+            const float l = ky * (yuv[0] / 4.f - (b_full ? 0 : 16));
+            const float u = kc * (yuv[1] / 4.f - 128);
+            const float v = kc * (yuv[2] / 4.f - 128);
+            const float rgb[3] = {
+                l + 2 * (1 - kr) * v,
+                l - 2 * (1 - kb) * kb / kg * u - 2 * (1 - kr) * kr / kg * v,
+                l + 2 * (1 - kb) * u,
+            };
+            const uint8_t *p = &p_dst->p[0].p_pixels[y * p_dst->p[0].i_pitch
+                                                     + 4 * x];
+
+            for( int i = 0; i < 3; i++ )
+            {
+                const float f_ref = rgb[i] < 0 ? 0 : rgb[i] > 255 ? 255 : rgb[i];
+                const uint8_t out = p[b_bgra ? 2 - i : i];
+
+                if( fabsf( out - f_ref ) > 1.f )
+                {
+                    fprintf( stderr, "%4.4s to %4.4s: pixel %ux%u component "
+                             "%d is %u instead of %f\n",
+                             (const char *)&p_fmt->i_chroma,
+                             (const char *)&p_dst->format.i_chroma, x, y, i,
+                             out, f_ref );
+                    abort();
+                }
+            }
+            assert( p[3] == 0xff );
+        }
+}
+
+static const vlc_fourcc_t pairs_simd[][2] = {
+    { VLC_CODEC_I420, VLC_CODEC_NV12 }, { VLC_CODEC_YV12, VLC_CODEC_NV12 },
+    { VLC_CODEC_NV12, VLC_CODEC_I420 }, { VLC_CODEC_NV12, VLC_CODEC_YV12 },
+    { VLC_CODEC_I420_10L, VLC_CODEC_P010 },
+    { VLC_CODEC_P010, VLC_CODEC_I420_10L },
+    { VLC_CODEC_I422, VLC_CODEC_I420 }, { VLC_CODEC_I422, VLC_CODEC_YV12 },
+    { VLC_CODEC_I422_10L, VLC_CODEC_I420_10L },
+    { VLC_CODEC_I420, VLC_CODEC_RGBA }, { VLC_CODEC_J420, VLC_CODEC_BGRA },
+    { VLC_CODEC_YV12, VLC_CODEC_RGBA }, { VLC_CODEC_I422, VLC_CODEC_BGRA },
+    { VLC_CODEC_I420_10L, VLC_CODEC_RGBA },
+    { VLC_CODEC_I422_10L, VLC_CODEC_BGRA },
+};
+
+static void test_Simd( libvlc_int_t *p_libvlc )
+{
+    static const unsigned pi_sizes[][2] = {
+        { 1920, 1080 }, { 718, 480 }, { 33, 17 }, { 2, 2 },
+    };
+    static const video_color_space_t spaces[] = {
+        COLOR_SPACE_UNDEF, COLOR_SPACE_BT601, COLOR_SPACE_BT709,
+        COLOR_SPACE_BT2020,
+    };
+
+    if( !module_exists( "chroma_simd" ) || !vlc_CPU_AVX2() )
+    {
+        printf( "chroma_simd not available, skipping its checks\n" );
+        return;
+    }
+
+    for( size_t i = 0; i < ARRAY_SIZE(pairs_simd); i++ )
+        for( size_t j = 0; j < ARRAY_SIZE(pi_sizes); j++ )
+            for( size_t k = 0; k < ARRAY_SIZE(spaces); k++ )
+            {
+                const vlc_fourcc_t i_dst = pairs_simd[i][1];
+                const bool b_rgb = i_dst == VLC_CODEC_RGBA
+                                || i_dst == VLC_CODEC_BGRA;
+
+                if( k > 0 && !b_rgb )
+                    break;
+
+                filter_t *p_filter = CreateConverter( p_libvlc, "chroma_simd",
+                                                      pairs_simd[i][0], i_dst,
+                                                      pi_sizes[j][0],
+                                                      pi_sizes[j][1],
+                                                      spaces[k] );
+                assert( p_filter );
+
+                picture_t *p_src = NewSource( &p_filter->fmt_in.video, j );
+                picture_Hold( p_src );
+                picture_t *p_dst = p_filter->pf_video_filter( p_filter, p_src );
+                assert( p_dst );
+
+                if( b_rgb )
+                    CheckRgb( p_src, p_dst );
+                else
+                    CheckYuv( p_src, p_dst );
+
+                picture_Release( p_dst );
+                picture_Release( p_src );
+                DeleteConverter( p_filter );
+            }
+    printf( "chroma_simd conversions checked\n" );
+}
+
+/*****************************************************************************
+ * Benchmark of every converter
+ *****************************************************************************/
+
+static void test_Benchmark( libvlc_int_t *p_libvlc )
+{
+    static const vlc_fourcc_t pairs_other[][2] = {
+        { VLC_CODEC_I420, VLC_CODEC_YUYV }, { VLC_CODEC_I420, VLC_CODEC_UYVY },
+        { VLC_CODEC_I422, VLC_CODEC_YUYV }, { VLC_CODEC_YUYV, VLC_CODEC_I420 },
+        { VLC_CODEC_YUYV, VLC_CODEC_I422 }, { VLC_CODEC_I420, VLC_CODEC_RGB32 },
+        { VLC_CODEC_I420, VLC_CODEC_RGB16 }, { VLC_CODEC_GREY, VLC_CODEC_I420 },
+        { VLC_CODEC_I422, VLC_CODEC_YUV420A },
+    };
+    const unsigned i_width = 1920, i_height = 1080;
+    size_t i_modules;
+    module_t **pp_modules = module_list_get( &i_modules );
+
+    for( size_t m = 0; m < i_modules; m++ )
+    {
+        if( !module_provides( pp_modules[m], "video converter" ) )
+            continue;
+
+        const char *psz_name = module_get_object( pp_modules[m] );
+        if( !strcmp( psz_name, "chain" ) )
+            continue; /* it only loads the other converters */
+
+        for( size_t i = 0; i < ARRAY_SIZE(pairs_simd) + ARRAY_SIZE(pairs_other);
+             i++ )
+        {
+            const vlc_fourcc_t *pair = i < ARRAY_SIZE(pairs_simd)
+                ? pairs_simd[i] : pairs_other[i - ARRAY_SIZE(pairs_simd)];
+            filter_t *p_filter = CreateConverter( p_libvlc, psz_name,
+                                                  pair[0], pair[1],
+                                                  i_width, i_height,
+                                                  COLOR_SPACE_UNDEF );
+            if( p_filter == NULL )
+                continue;
+
+            picture_t *p_src = NewSource( &p_filter->fmt_in.video, 0 );
+            mtime_t i_time = 0;
+
+            for( int j = 0; j < 1 + i_bench_frames; j++ )
+            {
+                mtime_t i_start = mdate();
+                picture_t *p_dst = p_filter->pf_video_filter( p_filter,
+                                                              picture_Hold( p_src ) );
+                if( j > 0 )
+                    i_time += mdate() - i_start;
+                assert( p_dst );
+                picture_Release( p_dst );
+            }
+            printf( "%-16s %4.4s to %4.4s %4ux%-4u %6"PRId64" us/frame\n",
+                    psz_name, (const char *)&pair[0], (const char *)&pair[1],
+                    i_width, i_height, i_time / i_bench_frames );
+
+            picture_Release( p_src );
+            DeleteConverter( p_filter );
+        }
+    }
+    module_list_free( pp_modules );
+}
+
+int main( int argc, char *argv[] )
+{
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+    };
+
+    if( argc > 1 && !strcmp( argv[1], "-b" ) )
+        i_bench_frames = 50;
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv), ppsz_argv );
+    assert( p_vlc );
+
+    test_Simd( p_vlc->p_libvlc_int );
+    test_Benchmark( p_vlc->p_libvlc_int );
+
+    libvlc_release( p_vlc );
+    return 0;
+}
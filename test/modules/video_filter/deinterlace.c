@@ -0,0 +1,471 @@
+/*****************************************************************************
+ * deinterlace.c: deinterlacer kernels and algorithms test
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_cpu.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#include "../modules/video_filter/deinterlace/common.h"
+#include "../modules/video_filter/deinterlace/yadif.h"
+#include "../modules/video_filter/deinterlace/merge.h"
+#include "../modules/video_filter/deinterlace/merge.c"
+
+/* Run with -b to benchmark more frames */
+static int i_bench_frames = 4;
+
+/*****************************************************************************
+ * Kernels
+ *****************************************************************************/
+
+typedef void (*yadif_func_t)(uint8_t *, uint8_t *, uint8_t *, uint8_t *,
+                             int, int, int, int, int);
+typedef void (*merge_func_t)(void *, const void *, const void *, size_t);
+
+#define LINES 5
+#define MAX_WIDTH 1920
+/* Enough room to read 3 pixels before and after any line */
+#define PITCH (2 * (MAX_WIDTH + 128))
+
+static uint8_t p_fields[3][LINES * PITCH];
+static uint8_t p_ref[PITCH], p_out[PITCH];
+
+static void FillFields( unsigned i_depth )
+{
+    const unsigned i_mask = (1 << i_depth) - 1;
+
+    for( int i = 0; i < 3; i++ )
+    {
+        if( i_depth > 8 )
+        {
+            uint16_t *p = (uint16_t *)p_fields[i];
+            for( size_t j = 0; j < sizeof(p_fields[i]) / 2; j++ )
+                /* mostly smooth, with some extreme values */
+                p[j] = rand() % 4 ? ((j % PITCH) * 7 + i * 13 + rand() % 64)
+                                    & i_mask
+                                  : (rand() & 1) * i_mask;
+        }
+        else
+        {
+            uint8_t *p = p_fields[i];
+            for( size_t j = 0; j < sizeof(p_fields[i]); j++ )
+                p[j] = rand() % 4 ? ((j % PITCH) * 7 + i * 13 + rand() % 64)
+                                    & i_mask
+                                  : (rand() & 1) * i_mask;
+        }
+    }
+}
+
+/* Leave the MMX state after the MMX and SSE2 kernels */
+static void EndKernel( void )
+{
+#if defined(CAN_COMPILE_MMXEXT) || defined(CAN_COMPILE_SSE)
+    if( vlc_CPU_MMXEXT() )
+        EndMMX();
+#endif
+}
+
+static void RunYadif( yadif_func_t pf, uint8_t *p_dst, int i_width,
+                      int i_pixel_size, int i_parity, int i_mode )
+{
+    /* Filter the middle line, with 2 lines above and below */
+    const int i_offset = 2 * PITCH + 64;
+
+    pf( p_dst + 64, &p_fields[0][i_offset], &p_fields[1][i_offset],
+        &p_fields[2][i_offset], i_width / i_pixel_size, PITCH, -PITCH,
+        i_parity, i_mode );
+    EndKernel();
+}
+
+static void test_Yadif( const char *psz_name, yadif_func_t pf,
+                        yadif_func_t pf_ref, unsigned i_depth, bool b_bounded )
+{
+    static const int pi_widths[] = { 1, 7, 16, 31, 33, 64, 100, 720, 1919 };
+    const int i_pixel_size = i_depth > 8 ? 2 : 1;
+
+    printf( "yadif %s, %u bits\n", psz_name, i_depth );
+    for( int i_iter = 0; i_iter < 8; i_iter++ )
+    {
+        FillFields( i_depth );
+        for( size_t i = 0; i < ARRAY_SIZE(pi_widths); i++ )
+            for( int i_parity = 0; i_parity < 2; i_parity++ )
+                for( int i_mode = 0; i_mode <= 2; i_mode += 2 )
+                {
+                    const int i_bytes = pi_widths[i] * i_pixel_size;
+
+                    memset( p_ref, 0x55, sizeof(p_ref) );
+                    memset( p_out, 0x55, sizeof(p_out) );
+                    RunYadif( pf_ref, p_ref, i_bytes, i_pixel_size,
+                              i_parity, i_mode );
+                    RunYadif( pf, p_out, i_bytes, i_pixel_size,
+                              i_parity, i_mode );
+                    /* The MMX and SSE kernels write whole vectors */
+                    if( memcmp( p_ref, p_out,
+                                b_bounded ? sizeof(p_ref) : (size_t)(64 + i_bytes) ) )
+                    {
+                        fprintf( stderr, "yadif %s: %d pixels, parity %d, "
+                                 "mode %d differ\n", psz_name, pi_widths[i],
+                                 i_parity, i_mode );
+                        abort();
+                    }
+                }
+    }
+}
+
+static void test_Merge( const char *psz_name, merge_func_t pf,
+                        merge_func_t pf_ref, int i_pixel_size, bool b_exact )
+{
+    printf( "merge %s, %d bytes pixels\n", psz_name, i_pixel_size );
+    FillFields( 8 * i_pixel_size );
+    for( int i_align = 0; i_align < 64; i_align += 2 )
+        for( size_t i_bytes = 2; i_bytes < 300; i_bytes += 2 )
+        {
+            memset( p_ref, 0x55, sizeof(p_ref) );
+            memset( p_out, 0x55, sizeof(p_out) );
+            pf_ref( p_ref, &p_fields[0][i_align], &p_fields[1][i_align],
+                    i_bytes );
+            pf( p_out, &p_fields[0][i_align], &p_fields[1][i_align],
+                i_bytes );
+            for( size_t i = 0; i < sizeof(p_ref); i += i_pixel_size )
+            {
+                int a = i_pixel_size == 2 ? *(uint16_t *)&p_ref[i] : p_ref[i];
+                int b = i_pixel_size == 2 ? *(uint16_t *)&p_out[i] : p_out[i];
+
+                /* pavgb/pavgw round up */
+                if( a != b && (b_exact || i >= i_bytes || b - a != 1) )
+                {
+                    fprintf( stderr, "merge %s: %zu bytes, offset %d: "
+                             "differ at %zu\n", psz_name, i_bytes, i_align,
+                             i );
+                    abort();
+                }
+            }
+        }
+    EndKernel();
+}
+
+static void bench_Yadif( const char *psz_name, yadif_func_t pf, int i_depth )
+{
+    const int i_pixel_size = i_depth > 8 ? 2 : 1;
+    const int i_loops = 2000;
+
+    FillFields( i_depth );
+    mtime_t i_start = mdate();
+    for( int i = 0; i < i_loops; i++ )
+        RunYadif( pf, p_out, MAX_WIDTH * i_pixel_size, i_pixel_size, i & 1, 0 );
+    mtime_t i_time = __MAX(mdate() - i_start, 1);
+    printf( "yadif %-7s %2d bits: %6"PRId64" Mpixel/s\n", psz_name, i_depth,
+            (int64_t)MAX_WIDTH * i_loops / i_time );
+}
+
+static void bench_Merge( const char *psz_name, merge_func_t pf,
+                         int i_pixel_size )
+{
+    const int i_loops = 20000;
+
+    mtime_t i_start = mdate();
+    for( int i = 0; i < i_loops; i++ )
+        pf( p_out, p_fields[0], p_fields[1], MAX_WIDTH * i_pixel_size );
+    mtime_t i_time = __MAX(mdate() - i_start, 1);
+    EndKernel();
+    printf( "merge %-7s %2d bits: %6"PRId64" Mpixel/s\n", psz_name,
+            8 * i_pixel_size, (int64_t)MAX_WIDTH * i_loops / i_time );
+}
+
+static void test_Kernels( void )
+{
+    static const struct
+    {
+        const char *psz_name;
+        yadif_func_t pf_yadif8;
+        yadif_func_t pf_yadif16;
+        merge_func_t pf_merge8;
+        merge_func_t pf_merge16;
+        bool b_exact;
+    } kernels[] = {
+        { "C", yadif_filter_line_c,
+          (yadif_func_t)yadif_filter_line_c_16bit,
+          Merge8BitGeneric, Merge16BitGeneric, true },
+#if defined(HAVE_YADIF_MMX) && defined(CAN_COMPILE_MMXEXT)
+        { "MMX", yadif_filter_line_mmx, NULL,
+          MergeMMXEXT, NULL, false },
+#endif
+#if defined(HAVE_YADIF_SSE2) && defined(CAN_COMPILE_SSE)
+        { "SSE2", yadif_filter_line_sse2, NULL,
+          Merge8BitSSE2, Merge16BitSSE2, false },
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+        { "SSSE3", yadif_filter_line_ssse3, NULL, NULL, NULL, false },
+#endif
+#if defined(HAVE_YADIF_AVX2)
+        { "AVX2", yadif_filter_line_avx2, yadif_filter_line_16bit_avx2,
+          Merge8BitAVX2, Merge16BitAVX2, true },
+#endif
+#if defined(HAVE_YADIF_AVX512)
+        { "AVX-512", yadif_filter_line_avx512,
+          yadif_filter_line_16bit_avx512,
+          Merge8BitAVX512, Merge16BitAVX512, true },
+#endif
+    };
+    const bool pb_cpu[] = {
+        true,
+#if defined(HAVE_YADIF_MMX) && defined(CAN_COMPILE_MMXEXT)
+        vlc_CPU_MMXEXT(),
+#endif
+#if defined(HAVE_YADIF_SSE2) && defined(CAN_COMPILE_SSE)
+        vlc_CPU_SSE2(),
+#endif
+#if defined(HAVE_YADIF_SSSE3)
+        vlc_CPU_SSSE3(),
+#endif
+#if defined(HAVE_YADIF_AVX2)
+        vlc_CPU_AVX2(),
+#endif
+#if defined(HAVE_YADIF_AVX512)
+        vlc_CPU_AVX512(),
+#endif
+    };
+    static_assert( ARRAY_SIZE(kernels) == ARRAY_SIZE(pb_cpu), "kernels" );
+
+    for( size_t i = 1; i < ARRAY_SIZE(kernels); i++ )
+    {
+        if( !pb_cpu[i] )
+        {
+            printf( "%s: not supported by the CPU, skipped\n",
+                    kernels[i].psz_name );
+            continue;
+        }
+        if( kernels[i].pf_yadif8 )
+            test_Yadif( kernels[i].psz_name, kernels[i].pf_yadif8,
+                        kernels[0].pf_yadif8, 8, kernels[i].b_exact );
+        if( kernels[i].pf_yadif16 )
+        {
+            test_Yadif( kernels[i].psz_name, kernels[i].pf_yadif16,
+                        kernels[0].pf_yadif16, 10, kernels[i].b_exact );
+            test_Yadif( kernels[i].psz_name, kernels[i].pf_yadif16,
+                        kernels[0].pf_yadif16, 16, kernels[i].b_exact );
+        }
+        if( kernels[i].pf_merge8 )
+            test_Merge( kernels[i].psz_name, kernels[i].pf_merge8,
+                        kernels[0].pf_merge8, 1, kernels[i].b_exact );
+        if( kernels[i].pf_merge16 )
+            test_Merge( kernels[i].psz_name, kernels[i].pf_merge16,
+                        kernels[0].pf_merge16, 2, kernels[i].b_exact );
+    }
+
+    for( size_t i = 0; i < ARRAY_SIZE(kernels); i++ )
+    {
+        if( !pb_cpu[i] )
+            continue;
+        if( kernels[i].pf_yadif8 )
+            bench_Yadif( kernels[i].psz_name, kernels[i].pf_yadif8, 8 );
+        if( kernels[i].pf_yadif16 )
+            bench_Yadif( kernels[i].psz_name, kernels[i].pf_yadif16, 16 );
+        if( kernels[i].pf_merge8 )
+            bench_Merge( kernels[i].psz_name, kernels[i].pf_merge8, 1 );
+        if( kernels[i].pf_merge16 )
+            bench_Merge( kernels[i].psz_name, kernels[i].pf_merge16, 2 );
+    }
+}
+
+/*****************************************************************************
+ * Algorithms
+ *****************************************************************************/
+
+#define FRAMES 6
+
+static picture_t *NewPicture( filter_t *p_filter )
+{
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+/* Synthetic interlaced frames: a moving ramp, with a different shift on each
+ * field, plus some texture */
+static picture_t *NewField( const video_format_t *p_fmt, int i_frame )
+{
+    picture_t *p_pic = picture_NewFromFormat( p_fmt );
+    assert( p_pic );
+
+    const int i_pixel_size = p_pic->p[0].i_pixel_pitch;
+    const unsigned i_max = i_pixel_size == 2 ? 1023 : 255;
+
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+
+        for( int y = 0; y < p->i_lines; y++ )
+        {
+            const int i_shift = 4 * i_frame + 2 * (y & 1);
+
+            for( int x = 0; x < p->i_pitch / i_pixel_size; x++ )
+            {
+                unsigned v = ((x + i_shift) * 3 + y * 2 + ((x * y) & 7)) % i_max;
+
+                if( i_pixel_size == 2 )
+                    ((uint16_t *)&p->p_pixels[y * p->i_pitch])[x] = v;
+                else
+                    p->p_pixels[y * p->i_pitch + x] = v;
+            }
+        }
+    }
+    p_pic->date = VLC_TS_0 + i_frame * CLOCK_FREQ / 25;
+    p_pic->b_progressive = false;
+    p_pic->b_top_field_first = true;
+    p_pic->i_nb_fields = 2;
+    return p_pic;
+}
+
+struct deinterlace_mode
+{
+    const char *psz_name;
+    unsigned i_height_div; /* output lines per input line */
+    unsigned i_rate_mul; /* output pictures per input frame */
+    bool b_high_depth; /* supports more than 8 bits per sample */
+};
+
+static void test_Algorithm( libvlc_int_t *p_libvlc,
+                            const struct deinterlace_mode *p_mode,
+                            vlc_fourcc_t i_chroma, unsigned i_width,
+                            unsigned i_height )
+{
+    video_format_t fmt;
+    es_format_t es;
+
+    video_format_Init( &fmt, i_chroma );
+    video_format_Setup( &fmt, i_chroma, i_width, i_height, i_width, i_height,
+                        1, 1 );
+    es_format_Init( &es, VIDEO_ES, i_chroma );
+    es.video = fmt;
+
+    var_SetString( p_libvlc, "sout-deinterlace-mode", p_mode->psz_name );
+
+    filter_owner_t owner = {
+        .sys = p_libvlc,
+        .video = { .buffer_new = NewPicture },
+    };
+    filter_chain_t *p_chain = filter_chain_NewVideo( VLC_OBJECT(p_libvlc),
+                                                     true, &owner );
+    assert( p_chain );
+    filter_chain_Reset( p_chain, &es, &es );
+    if( filter_chain_AppendFilter( p_chain, "deinterlace", NULL, &es,
+                                   &es ) == NULL )
+    {
+        fprintf( stderr, "%s: cannot load deinterlace\n", p_mode->psz_name );
+        abort();
+    }
+    assert( filter_chain_GetFmtOut( p_chain )->video.i_visible_height
+            == i_height / p_mode->i_height_div );
+
+    unsigned i_out = 0;
+    const int i_frames = FRAMES + i_bench_frames;
+    mtime_t i_time = 0;
+
+    for( int i = 0; i < i_frames; i++ )
+    {
+        picture_t *p_in = NewField( &fmt, i );
+        mtime_t i_start = mdate();
+        unsigned i_count = 0;
+
+        /* Double rate algorithms queue their second picture in the chain */
+        for( picture_t *p_pic = filter_chain_VideoFilter( p_chain, p_in );
+             p_pic != NULL; p_pic = filter_chain_VideoFilter( p_chain, NULL ) )
+        {
+            assert( p_pic->format.i_visible_width == i_width );
+            i_count++;
+            picture_Release( p_pic );
+        }
+        if( i >= FRAMES )
+            i_time += mdate() - i_start;
+        assert( i_count <= p_mode->i_rate_mul );
+        i_out += i_count;
+    }
+    filter_chain_Delete( p_chain );
+    es_format_Clean( &es );
+
+    /* Every algorithm outputs at least one picture per input frame once
+     * its history is full; IVTC drops one frame out of five at most */
+    assert( i_out >= ((unsigned)i_frames * 4 / 5 - 3) * p_mode->i_rate_mul );
+
+    printf( "%-9s %4.4s %4ux%-4u %4u pictures, %6"PRId64" us/frame\n",
+            p_mode->psz_name, (const char *)&i_chroma, i_width, i_height, i_out,
+            i_time / __MAX(i_bench_frames, 1) );
+}
+
+static void test_Algorithms( void )
+{
+    static const struct deinterlace_mode modes[] = {
+        { "discard", 2, 1, true }, { "blend", 1, 1, true },
+        { "mean", 2, 1, true }, { "bob", 1, 2, true },
+        { "linear", 1, 2, true }, { "x", 1, 1, false },
+        { "yadif", 1, 1, true }, { "yadif2x", 1, 2, true },
+        { "phosphor", 1, 2, false }, { "ivtc", 1, 1, false },
+    };
+    static const vlc_fourcc_t pi_chromas[] = {
+        VLC_CODEC_I420, VLC_CODEC_I422, VLC_CODEC_I420_10L,
+    };
+    static const unsigned pi_sizes[][2] = {
+        { 176, 144 }, { 718, 480 }, { 1920, 1080 },
+    };
+    static const char *const ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_vlc = libvlc_new( ARRAY_SIZE(ppsz_argv),
+                                           ppsz_argv );
+    assert( p_vlc );
+
+    var_Create( p_vlc->p_libvlc_int, "sout-deinterlace-mode", VLC_VAR_STRING );
+    for( size_t i = 0; i < ARRAY_SIZE(modes); i++ )
+        for( size_t j = 0; j < ARRAY_SIZE(pi_chromas); j++ )
+            for( size_t k = 0; k < ARRAY_SIZE(pi_sizes); k++ )
+                if( modes[i].b_high_depth
+                 || vlc_fourcc_GetChromaDescription( pi_chromas[j] )
+                        ->pixel_size == 1 )
+                    test_Algorithm( p_vlc->p_libvlc_int, &modes[i],
+                                    pi_chromas[j], pi_sizes[k][0],
+                                    pi_sizes[k][1] );
+
+    libvlc_release( p_vlc );
+}
+
+int main( int argc, char *argv[] )
+{
+    if( argc > 1 && !strcmp( argv[1], "-b" ) )
+        i_bench_frames = 50;
+
+    srand( 0 );
+    test_Kernels();
+    test_Algorithms();
+    return 0;
+}
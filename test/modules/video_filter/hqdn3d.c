@@ -0,0 +1,172 @@
+/*****************************************************************************
+ * hqdn3d.c: hqdn3d denoiser slice test
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+/*
+ * The denoiser low passes recursively along the rows, down the columns and
+ * over time. Filtering in slices must give the same pictures as filtering
+ * whole planes on a single thread.
+ */
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdlib.h>
+
+#include <vlc/vlc.h>
+#include "../../../lib/libvlc_internal.h"
+
+#include <vlc_common.h>
+#include <vlc_filter.h>
+#include <vlc_picture.h>
+
+#define FRAMES 8
+
+static picture_t *NewPicture( filter_t *p_filter )
+{
+    return picture_NewFromFormat( &p_filter->fmt_out.video );
+}
+
+/* A slow moving ramp with a little noise: the low passes smooth it over
+ * long distances, across the slices */
+static picture_t *NewFrame( const video_format_t *p_fmt, int i_frame )
+{
+    picture_t *p_pic = picture_NewFromFormat( p_fmt );
+    assert( p_pic );
+
+    srand( i_frame );
+    for( int i = 0; i < p_pic->i_planes; i++ )
+    {
+        plane_t *p = &p_pic->p[i];
+
+        for( int y = 0; y < p->i_lines; y++ )
+            for( int x = 0; x < p->i_pitch; x++ )
+                p->p_pixels[y * p->i_pitch + x] =
+                    (x + 2 * y) / 8 + i_frame + rand() % 4;
+    }
+    p_pic->date = VLC_TS_0 + i_frame * CLOCK_FREQ / 25;
+    return p_pic;
+}
+
+/* Filters FRAMES frames with the given spatial strength, and returns the
+ * last output */
+static picture_t *Run( libvlc_instance_t *p_vlc, const video_format_t *p_fmt,
+                       float f_spatial )
+{
+    libvlc_int_t *p_libvlc = p_vlc->p_libvlc_int;
+    es_format_t es;
+
+    es_format_Init( &es, VIDEO_ES, p_fmt->i_chroma );
+    es.video = *p_fmt;
+
+    filter_owner_t owner = {
+        .sys = p_libvlc,
+        .video = { .buffer_new = NewPicture },
+    };
+    filter_chain_t *p_chain = filter_chain_NewVideo( VLC_OBJECT(p_libvlc),
+                                                     true, &owner );
+    assert( p_chain );
+    filter_chain_Reset( p_chain, &es, &es );
+    filter_t *p_filter = filter_chain_AppendFilter( p_chain, "hqdn3d", NULL,
+                                                    &es, &es );
+    assert( p_filter );
+    var_SetFloat( p_filter, "hqdn3d-luma-spat", f_spatial );
+    var_SetFloat( p_filter, "hqdn3d-chroma-spat", f_spatial );
+
+    picture_t *p_out = NULL;
+    for( int i = 0; i < FRAMES; i++ )
+    {
+        if( p_out != NULL )
+            picture_Release( p_out );
+        p_out = filter_chain_VideoFilter( p_chain, NewFrame( p_fmt, i ) );
+        assert( p_out );
+    }
+    filter_chain_Delete( p_chain );
+    es_format_Clean( &es );
+    return p_out;
+}
+
+static void test_Slices( libvlc_instance_t *p_serial,
+                         libvlc_instance_t *p_sliced,
+                         unsigned i_width, unsigned i_height, float f_spatial )
+{
+    video_format_t fmt;
+
+    video_format_Init( &fmt, VLC_CODEC_I420 );
+    video_format_Setup( &fmt, VLC_CODEC_I420, i_width, i_height,
+                        i_width, i_height, 1, 1 );
+
+    picture_t *p_ref = Run( p_serial, &fmt, f_spatial );
+    picture_t *p_out = Run( p_sliced, &fmt, f_spatial );
+
+    for( int i = 0; i < p_ref->i_planes; i++ )
+    {
+        const plane_t *r = &p_ref->p[i], *o = &p_out->p[i];
+
+        for( int y = 0; y < r->i_visible_lines; y++ )
+            if( memcmp( &r->p_pixels[y * r->i_pitch],
+                        &o->p_pixels[y * o->i_pitch], r->i_visible_pitch ) )
+            {
+                fprintf( stderr, "hqdn3d %ux%u, spatial %.0f: plane %d, "
+                         "line %d differs\n", i_width, i_height, f_spatial,
+                         i, y );
+                abort();
+            }
+    }
+    printf( "hqdn3d %4ux%-4u spatial %3.0f: identical\n", i_width, i_height,
+            f_spatial );
+
+    picture_Release( p_out );
+    picture_Release( p_ref );
+}
+
+int main( void )
+{
+    static const unsigned pi_sizes[][2] = {
+        { 176, 144 }, { 333, 241 }, { 720, 576 }, { 1920, 1080 },
+    };
+    const char *ppsz_argv[] = {
+        "--ignore-config", "-I", "dummy", "--no-media-library",
+        "--video-filter-threads=1",
+    };
+
+    setenv( "VLC_PLUGIN_PATH", "../modules", 1 );
+    libvlc_instance_t *p_serial = libvlc_new( ARRAY_SIZE(ppsz_argv),
+                                              ppsz_argv );
+    ppsz_argv[ARRAY_SIZE(ppsz_argv) - 1] = "--video-filter-threads=4";
+    libvlc_instance_t *p_sliced = libvlc_new( ARRAY_SIZE(ppsz_argv),
+                                              ppsz_argv );
+    assert( p_serial && p_sliced );
+
+    /* Temporal only, the default and the strongest spatial low pass */
+    static const float pf_spatial[] = { 0.f, 4.f, 254.f };
+    for( size_t i = 0; i < ARRAY_SIZE(pi_sizes); i++ )
+        for( size_t j = 0; j < ARRAY_SIZE(pf_spatial); j++ )
+            test_Slices( p_serial, p_sliced, pi_sizes[i][0], pi_sizes[i][1],
+                         pf_spatial[j] );
+
+    libvlc_release( p_sliced );
+    libvlc_release( p_serial );
+    return 0;
+}
@@ -0,0 +1,198 @@
+/*****************************************************************************
+ * fft.c: real fast Fourier transform test and benchmark
+ *****************************************************************************
+ * Copyright (C) 2017 VLC authors and VideoLAN
+ *
+ * This program is free software; you can redistribute it and/or modify it
+ * under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation; either version 2.1 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE. See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program; if not, write to the Free Software Foundation,
+ * Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
+ *****************************************************************************/
+
+#ifdef HAVE_CONFIG_H
+# include "config.h"
+#endif
+
+#include "../../../src/misc/fft.c"
+
+#ifdef NDEBUG
+ #undef NDEBUG
+#endif
+#include <assert.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "../../libvlc/test.h"
+
+/* Run with -b to benchmark longer */
+static unsigned i_bench_rounds = 1;
+
+struct kernel
+{
+    const char *psz_name;
+    void (*pf_passes)(const struct fft_tables *, float *, float *);
+};
+
+static float Noise( void )
+{
+    return rand() / (float)RAND_MAX - .5f;
+}
+
+/*****************************************************************************
+ * Comparison with the direct transform
+ *****************************************************************************/
+static void test_Direct( const struct kernel *p_kernel, unsigned i_size )
+{
+    const unsigned n = i_size / 2;
+    float *p_in = malloc( i_size * sizeof (float) );
+    float *p_spec = malloc( i_size * sizeof (float) );
+    float *p_out = malloc( i_size * sizeof (float) );
+    float *p_power = malloc( (n + 1) * sizeof (float) );
+    assert( p_in && p_spec && p_out && p_power );
+
+    vlc_fft_t *fft = vlc_fft_New( i_size );
+    assert( fft != NULL );
+    fft->passes = p_kernel->pf_passes;
+
+    double f_peak = 0.;
+    for( unsigned k = 0; k < i_size; k++ )
+        p_in[k] = Noise();
+    vlc_fft_Forward( fft, p_spec, p_in );
+    vlc_fft_Power( fft, p_power, p_in );
+
+    double f_err = 0., f_power_err = 0.;
+    for( unsigned k = 0; k <= n; k++ )
+    {
+        double re = 0., im = 0.;
+        for( unsigned t = 0; t < i_size; t++ )
+        {
+            re += p_in[t] * cos( 2. * M_PI * k * t / i_size );
+            im -= p_in[t] * sin( 2. * M_PI * k * t / i_size );
+        }
+
+        double got_re, got_im;
+        if( k == 0 )
+            got_re = p_spec[0], got_im = 0.;
+        else if( k == n )
+            got_re = p_spec[n], got_im = 0.;
+        else
+            got_re = p_spec[k], got_im = p_spec[n + k];
+
+        const double power = re * re + im * im;
+        f_peak = fmax( f_peak, sqrt( power ) );
+        f_err = fmax( f_err, hypot( got_re - re, got_im - im ) );
+        f_power_err = fmax( f_power_err, fabs( p_power[k]
+                            - ((k == 0 || k == n) ? power / 4. : power ) ) );
+    }
+    /* The error of a float FFT grows with the logarithm of its length */
+    assert( f_err < 1e-5 * f_peak * log2( i_size ) );
+    assert( f_power_err < 1e-4 * f_peak * f_peak );
+
+    vlc_fft_Inverse( fft, p_out, p_spec );
+    double f_round = 0.;
+    for( unsigned k = 0; k < i_size; k++ )
+        f_round = fmax( f_round, fabs( p_out[k] / i_size - p_in[k] ) );
+    assert( f_round < 1e-6 * log2( i_size ) );
+
+    vlc_fft_Delete( fft );
+    free( p_power );
+    free( p_out );
+    free( p_spec );
+    free( p_in );
+}
+
+/*****************************************************************************
+ * Shared tables
+ *****************************************************************************/
+static void test_Tables( void )
+{
+    assert( vlc_fft_New( 0 ) == NULL );
+    assert( vlc_fft_New( 4 ) == NULL );
+    assert( vlc_fft_New( 1000 ) == NULL );
+
+    vlc_fft_t *a = vlc_fft_New( 512 ), *b = vlc_fft_New( 512 );
+    vlc_fft_t *c = vlc_fft_New( 1024 );
+    assert( a && b && c );
+    assert( a->tables == b->tables && a->tables->refs == 2 );
+    assert( a->tables != c->tables );
+    vlc_fft_Delete( a );
+    assert( b->tables->refs == 1 );
+    vlc_fft_Delete( b );
+    assert( tables_cache[8] == NULL );
+    vlc_fft_Delete( c );
+    assert( tables_cache[9] == NULL );
+}
+
+/*****************************************************************************
+ * Cost of a transform
+ *****************************************************************************/
+static void test_Benchmark( const struct kernel *p_kernel, unsigned i_size )
+{
+    const unsigned i_count = i_bench_rounds * (1u << 22) / i_size;
+    float *p_in = malloc( i_size * sizeof (float) );
+    float *p_spec = malloc( i_size * sizeof (float) );
+    assert( p_in && p_spec );
+    for( unsigned k = 0; k < i_size; k++ )
+        p_in[k] = Noise();
+
+    vlc_fft_t *fft = vlc_fft_New( i_size );
+    assert( fft != NULL );
+    fft->passes = p_kernel->pf_passes;
+
+    mtime_t i_time = mdate();
+    for( unsigned i = 0; i < i_count; i++ )
+        vlc_fft_Forward( fft, p_spec, p_in );
+    i_time = mdate() - i_time;
+    vlc_fft_Delete( fft );
+
+    printf( "fft %-4s %5u samples: %8.1f ns\n", p_kernel->psz_name, i_size,
+            1000. * i_time / i_count );
+
+    free( p_spec );
+    free( p_in );
+}
+
+int main( int argc, char *argv[] )
+{
+    struct kernel kernels[4] = { { "C", PassesC } };
+    size_t i_kernels = 1;
+
+#ifdef HAVE_FFT_SSE2
+    if( vlc_CPU_SSE2() )
+        kernels[i_kernels++] = (struct kernel){ "SSE2", PassesSSE2 };
+#endif
+#ifdef HAVE_FFT_AVX2
+    if( vlc_CPU_AVX2() )
+        kernels[i_kernels++] = (struct kernel){ "AVX2", PassesAVX2 };
+#endif
+#ifdef HAVE_FFT_NEON
+    kernels[i_kernels++] = (struct kernel){ "NEON", PassesNEON };
+#endif
+
+    test_init();
+    if( argc > 1 && !strcmp( argv[1], "-b" ) )
+    {
+        i_bench_rounds = 20;
+        alarm( 0 );
+    }
+    srand( 0 );
+
+    test_Tables();
+    for( size_t i = 0; i < i_kernels; i++ )
+        for( unsigned i_size = 8; i_size <= 8192; i_size *= 2 )
+            test_Direct( &kernels[i], i_size );
+
+    for( unsigned i_size = 64; i_size <= 8192; i_size *= 4 )
+        for( size_t i = 0; i < i_kernels; i++ )
+            test_Benchmark( &kernels[i], i_size );
+    return 0;
+}
@@ -21,6 +21,7 @@
  * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston MA 02110-1301, USA.
  *****************************************************************************/
 
+#include <float.h>
 #include <limits.h>
 
 #include "../../libvlc/test.h"
@@ -94,6 +95,15 @@ static void test_floats( libvlc_int_t *p_libvlc )
     for( unsigned i = 0; i < VAR_COUNT; i++ )
         assert( var_GetFloat( p_libvlc, psz_var_name[i] ) == var_value[i].f_float );
 
+    /* Negative values are not clamped */
+    vlc_value_t min;
+    var_Change( p_libvlc, psz_var_name[0], VLC_VAR_GETMIN, &min, NULL );
+    assert( min.f_float == -FLT_MAX );
+    var_SetFloat( p_libvlc, psz_var_name[0], -23.f );
+    assert( var_GetFloat( p_libvlc, psz_var_name[0] ) == -23.f );
+    var_SetFloat( p_libvlc, psz_var_name[0], -FLT_MAX );
+    assert( var_GetFloat( p_libvlc, psz_var_name[0] ) == -FLT_MAX );
+
     for( unsigned i = 0; i < VAR_COUNT; i++ )
         var_Destroy( p_libvlc, psz_var_name[i] );
 }